@@ -40,6 +40,13 @@ PlusFidLineFinder::PlusFidLineFinder()
 
   m_MinThetaRad = -1.0;
   m_MaxThetaRad = -1.0;
+
+  m_UseFastLineFinding = true;
+  m_DotGridOrigin[0] = 0;
+  m_DotGridOrigin[1] = 0;
+  m_DotGridCellSizePx = 1.0;
+  m_DotGridSize[0] = 0;
+  m_DotGridSize[1] = 0;
 }
 
 //-----------------------------------------------------------------------------
@@ -206,6 +213,8 @@ PlusStatus PlusFidLineFinder::ReadConfiguration( vtkXMLDataElement* configData )
     XML_READ_SCALAR_ATTRIBUTE_WARNING( double, CollinearPointsMaxDistanceFromLineMm, segmentationParameters );
   }
 
+  XML_READ_BOOL_ATTRIBUTE_OPTIONAL( UseFastLineFinding, segmentationParameters );
+
   return PLUS_SUCCESS;
 }
 
@@ -432,16 +441,39 @@ void PlusFidLineFinder::FindLines2Points()
   }
 
   std::vector<PlusFidLine> twoPointsLinesVector;
+  std::vector<int> candidateDotIndices;
 
   for( unsigned int i = 0 ; i < m_Patterns.size() ; i++ )
   {
     //the expected length of the line
     int lineLenPx = floor( m_Patterns[i]->GetDistanceToOriginMm()[m_Patterns[i]->GetWires().size() - 1] / m_ApproximateSpacingMmPerPixel + 0.5 );
+    double lineLenTolerancePx = fabs( floor( m_Patterns[i]->GetDistanceToOriginToleranceMm()[m_Patterns[i]->GetWires().size() - 1] / m_ApproximateSpacingMmPerPixel + 0.5 ) );
 
     for ( unsigned int dot1Index = 0; dot1Index < m_DotsVector.size() - 1; dot1Index++ )
     {
-      for ( unsigned int dot2Index = dot1Index + 1; dot2Index < m_DotsVector.size(); dot2Index++ )
+      candidateDotIndices.clear();
+      if( m_UseFastLineFinding )
+      {
+        // The other dot must be within the maximum line length (+1 pixel margin for rounding errors)
+        double maxLengthPx = lineLenPx + lineLenTolerancePx + 1.0;
+        GetDotIndicesInRegion( m_DotsVector[dot1Index].GetX() - maxLengthPx, m_DotsVector[dot1Index].GetY() - maxLengthPx,
+                               m_DotsVector[dot1Index].GetX() + maxLengthPx, m_DotsVector[dot1Index].GetY() + maxLengthPx, candidateDotIndices );
+      }
+      else
+      {
+        for ( unsigned int dotIndex = dot1Index + 1; dotIndex < m_DotsVector.size(); dotIndex++ )
+        {
+          candidateDotIndices.push_back( dotIndex );
+        }
+      }
+
+      for ( std::vector<int>::iterator candidateIt = candidateDotIndices.begin(); candidateIt != candidateDotIndices.end(); ++candidateIt )
       {
+        unsigned int dot2Index = *candidateIt;
+        if( dot2Index <= dot1Index )
+        {
+          continue;
+        }
         double length = SegmentLength( m_DotsVector[dot1Index], m_DotsVector[dot2Index] );
         bool acceptLength = fabs( length - lineLenPx ) < floor( m_Patterns[i]->GetDistanceToOriginToleranceMm()[m_Patterns[i]->GetWires().size() - 1] / m_ApproximateSpacingMmPerPixel + 0.5 );
 
@@ -456,15 +488,17 @@ void PlusFidLineFinder::FindLines2Points()
             twoPointsLine.AddPoint( dot1Index );
             twoPointsLine.AddPoint( dot2Index );
 
-            bool duplicate = std::binary_search( twoPointsLinesVector.begin(), twoPointsLinesVector.end(), twoPointsLine, PlusFidLine::compareLines );
+            // the lines need to be sorted by points for the binary search to be performed; inserting the line at its
+            // lower bound gives the same order as sorting the vector after each addition
+            std::vector<PlusFidLine>::iterator insertPosition = std::lower_bound( twoPointsLinesVector.begin(), twoPointsLinesVector.end(), twoPointsLine, PlusFidLine::compareLines );
+            bool duplicate = ( insertPosition != twoPointsLinesVector.end() && !PlusFidLine::compareLines( twoPointsLine, *insertPosition ) );
 
             if( !duplicate )
             {
               twoPointsLine.SetStartPointIndex( dot1Index );
               ComputeLine( twoPointsLine );
 
-              twoPointsLinesVector.push_back( twoPointsLine );
-              std::sort( twoPointsLinesVector.begin(), twoPointsLinesVector.end(), PlusFidLine::compareLines ); //the lines need to be sorted that way each time for the binary search to be performed
+              twoPointsLinesVector.insert( insertPosition, twoPointsLine );
             }
           }
         }
@@ -489,6 +523,7 @@ void PlusFidLineFinder::FindLinesNPoints()
 
   double dist = m_CollinearPointsMaxDistanceFromLineMm / m_ApproximateSpacingMmPerPixel;
   unsigned int maxNumberOfPointsPerLine( 0 );
+  std::vector<int> candidateDotIndices;
 
   for( unsigned int i = 0 ; i < m_Patterns.size() ; i++ )
   {
@@ -507,13 +542,65 @@ void PlusFidLineFinder::FindLinesNPoints()
         continue;
       }
 
+      // Expected distance of the new point from the start point of the line, for finding the candidate points in the dot grid
+      bool useDotGrid = m_UseFastLineFinding
+                        && linesVectorIndex - 2 < m_Patterns[i]->GetDistanceToOriginMm().size()
+                        && linesVectorIndex - 2 < m_Patterns[i]->GetDistanceToOriginToleranceMm().size();
+      double expectedLengthPx = 0;
+      double expectedLengthTolerancePx = 0;
+      if( useDotGrid )
+      {
+        expectedLengthPx = floor( m_Patterns[i]->GetDistanceToOriginMm()[linesVectorIndex - 2] / m_ApproximateSpacingMmPerPixel + 0.5 );
+        expectedLengthTolerancePx = fabs( floor( m_Patterns[i]->GetDistanceToOriginToleranceMm()[linesVectorIndex - 2] / m_ApproximateSpacingMmPerPixel + 0.5 ) );
+      }
+
       for ( unsigned int l = 0; l < m_LinesVector[linesVectorIndex - 1].size(); l++ )
       {
         PlusFidLine currentShorterPointsLine;
         currentShorterPointsLine = m_LinesVector[linesVectorIndex - 1][l]; //the current max point line we want to expand
 
-        for ( unsigned int b3 = 0; b3 < m_DotsVector.size(); b3++ )
+        const PlusFidDot& startDot = m_DotsVector[currentShorterPointsLine.GetStartPointIndex()];
+        const PlusFidDot& endDot = m_DotsVector[currentShorterPointsLine.GetEndPointIndex()];
+        double lineDirection[2] = { endDot.GetX() - startDot.GetX(), endDot.GetY() - startDot.GetY() };
+        double lineDirectionLength = sqrt( lineDirection[0] * lineDirection[0] + lineDirection[1] * lineDirection[1] );
+        candidateDotIndices.clear();
+        if( useDotGrid && lineDirectionLength > 0 )
         {
+          // The new point must be at most dist away from the line, in the direction of the end point, at the expected
+          // distance from the start point. Get the dots in the bounding box of this region (with 1 pixel margin for rounding errors).
+          double along[2] = { lineDirection[0] / lineDirectionLength, lineDirection[1] / lineDirectionLength };
+          double across[2] = { -along[1], along[0] };
+          double minAlongPx = std::max( 0.0, expectedLengthPx - expectedLengthTolerancePx - fabs( dist ) ) - 1.0;
+          double maxAlongPx = expectedLengthPx + expectedLengthTolerancePx + 1.0;
+          double maxAcrossPx = fabs( dist ) + 1.0;
+          double minX = startDot.GetX();
+          double maxX = startDot.GetX();
+          double minY = startDot.GetY();
+          double maxY = startDot.GetY();
+          for ( int corner = 0; corner < 4; corner++ )
+          {
+            double alongPx = ( corner < 2 ? minAlongPx : maxAlongPx );
+            double acrossPx = ( corner % 2 == 0 ? -maxAcrossPx : maxAcrossPx );
+            double x = startDot.GetX() + alongPx * along[0] + acrossPx * across[0];
+            double y = startDot.GetY() + alongPx * along[1] + acrossPx * across[1];
+            minX = ( corner == 0 ? x : std::min( minX, x ) );
+            maxX = ( corner == 0 ? x : std::max( maxX, x ) );
+            minY = ( corner == 0 ? y : std::min( minY, y ) );
+            maxY = ( corner == 0 ? y : std::max( maxY, y ) );
+          }
+          GetDotIndicesInRegion( minX, minY, maxX, maxY, candidateDotIndices );
+        }
+        else
+        {
+          for ( unsigned int dotIndex = 0; dotIndex < m_DotsVector.size(); dotIndex++ )
+          {
+            candidateDotIndices.push_back( dotIndex );
+          }
+        }
+
+        for ( std::vector<int>::iterator candidateIt = candidateDotIndices.begin(); candidateIt != candidateDotIndices.end(); ++candidateIt )
+        {
+          unsigned int b3 = *candidateIt;
           std::vector<int> candidatesIndex;
           bool checkDuplicateFlag = false;//assume there is no duplicate
 
@@ -583,14 +670,14 @@ void PlusFidLineFinder::FindLinesNPoints()
               m_LinesVector.push_back( emptyLine );
             }
 
-            if( !std::binary_search( m_LinesVector[linesVectorIndex].begin(), m_LinesVector[linesVectorIndex].end(), line, PlusFidLine::compareLines ) )
+            // the lines are kept sorted so that lines that are already in the list can be quickly found by a binary search
+            std::vector<PlusFidLine>::iterator insertPosition = std::lower_bound( m_LinesVector[linesVectorIndex].begin(), m_LinesVector[linesVectorIndex].end(), line, PlusFidLine::compareLines );
+            if( insertPosition == m_LinesVector[linesVectorIndex].end() || PlusFidLine::compareLines( line, *insertPosition ) )
             {
               ComputeLine( line );
               if( AcceptLine( line ) )
               {
-                m_LinesVector[linesVectorIndex].push_back( line );
-                // sort the lines so that lines that are already in the list can be quickly found by a binary search
-                std::sort ( m_LinesVector[linesVectorIndex].begin(), m_LinesVector[linesVectorIndex].end(), PlusFidLine::compareLines );
+                m_LinesVector[linesVectorIndex].insert( insertPosition, line );
               }
             }
           }
@@ -664,10 +751,112 @@ bool PlusFidLineFinder::AcceptLine( PlusFidLine& line )
 
 //-----------------------------------------------------------------------------
 
+void PlusFidLineFinder::BuildDotGrid()
+{
+  m_DotGridCellFirstDot.clear();
+  m_DotGridDotIndices.clear();
+  m_DotGridSize[0] = 0;
+  m_DotGridSize[1] = 0;
+  if( m_DotsVector.empty() )
+  {
+    return;
+  }
+
+  double minPosition[2] = { m_DotsVector[0].GetX(), m_DotsVector[0].GetY() };
+  double maxPosition[2] = { m_DotsVector[0].GetX(), m_DotsVector[0].GetY() };
+  for( std::vector<PlusFidDot>::iterator dotIt = m_DotsVector.begin(); dotIt != m_DotsVector.end(); ++dotIt )
+  {
+    minPosition[0] = std::min( minPosition[0], dotIt->GetX() );
+    minPosition[1] = std::min( minPosition[1], dotIt->GetY() );
+    maxPosition[0] = std::max( maxPosition[0], dotIt->GetX() );
+    maxPosition[1] = std::max( maxPosition[1], dotIt->GetY() );
+  }
+
+  // Choose the cell size so that there is about one dot in each cell
+  double area = std::max( 1.0, ( maxPosition[0] - minPosition[0] ) * ( maxPosition[1] - minPosition[1] ) );
+  m_DotGridCellSizePx = std::max( 1.0, sqrt( area / m_DotsVector.size() ) );
+  m_DotGridOrigin[0] = minPosition[0];
+  m_DotGridOrigin[1] = minPosition[1];
+  m_DotGridSize[0] = static_cast<int>( ( maxPosition[0] - minPosition[0] ) / m_DotGridCellSizePx ) + 1;
+  m_DotGridSize[1] = static_cast<int>( ( maxPosition[1] - minPosition[1] ) / m_DotGridCellSizePx ) + 1;
+
+  // Counting sort of the dots by cell index
+  std::vector<int> dotCellIndices( m_DotsVector.size() );
+  m_DotGridCellFirstDot.assign( m_DotGridSize[0] * m_DotGridSize[1] + 1, 0 );
+  for( unsigned int dotIndex = 0; dotIndex < m_DotsVector.size(); dotIndex++ )
+  {
+    int cellX = std::min( static_cast<int>( ( m_DotsVector[dotIndex].GetX() - m_DotGridOrigin[0] ) / m_DotGridCellSizePx ), m_DotGridSize[0] - 1 );
+    int cellY = std::min( static_cast<int>( ( m_DotsVector[dotIndex].GetY() - m_DotGridOrigin[1] ) / m_DotGridCellSizePx ), m_DotGridSize[1] - 1 );
+    dotCellIndices[dotIndex] = cellY * m_DotGridSize[0] + cellX;
+    m_DotGridCellFirstDot[dotCellIndices[dotIndex] + 1]++;
+  }
+  for( unsigned int cellIndex = 1; cellIndex < m_DotGridCellFirstDot.size(); cellIndex++ )
+  {
+    m_DotGridCellFirstDot[cellIndex] += m_DotGridCellFirstDot[cellIndex - 1];
+  }
+  std::vector<int> nextDotInCell( m_DotGridCellFirstDot.begin(), m_DotGridCellFirstDot.end() - 1 );
+  m_DotGridDotIndices.resize( m_DotsVector.size() );
+  for( unsigned int dotIndex = 0; dotIndex < m_DotsVector.size(); dotIndex++ )
+  {
+    m_DotGridDotIndices[nextDotInCell[dotCellIndices[dotIndex]]++] = dotIndex;
+  }
+}
+
+//-----------------------------------------------------------------------------
+
+void PlusFidLineFinder::GetDotIndicesInRegion( double minX, double minY, double maxX, double maxY, std::vector<int>& dotIndices )
+{
+  dotIndices.clear();
+  if( m_DotGridSize[0] == 0 || m_DotGridSize[1] == 0 )
+  {
+    return;
+  }
+
+  double firstCellX = floor( ( minX - m_DotGridOrigin[0] ) / m_DotGridCellSizePx );
+  double firstCellY = floor( ( minY - m_DotGridOrigin[1] ) / m_DotGridCellSizePx );
+  double lastCellX = floor( ( maxX - m_DotGridOrigin[0] ) / m_DotGridCellSizePx );
+  double lastCellY = floor( ( maxY - m_DotGridOrigin[1] ) / m_DotGridCellSizePx );
+  if( lastCellX < 0 || lastCellY < 0 || firstCellX >= m_DotGridSize[0] || firstCellY >= m_DotGridSize[1] )
+  {
+    // the region is outside the grid
+    return;
+  }
+  int cellXStart = std::max( 0, static_cast<int>( firstCellX ) );
+  int cellYStart = std::max( 0, static_cast<int>( firstCellY ) );
+  int cellXEnd = std::min( m_DotGridSize[0] - 1, static_cast<int>( lastCellX ) );
+  int cellYEnd = std::min( m_DotGridSize[1] - 1, static_cast<int>( lastCellY ) );
+
+  for( int cellY = cellYStart; cellY <= cellYEnd; cellY++ )
+  {
+    for( int cellX = cellXStart; cellX <= cellXEnd; cellX++ )
+    {
+      int cellIndex = cellY * m_DotGridSize[0] + cellX;
+      for( int i = m_DotGridCellFirstDot[cellIndex]; i < m_DotGridCellFirstDot[cellIndex + 1]; i++ )
+      {
+        const PlusFidDot& dot = m_DotsVector[m_DotGridDotIndices[i]];
+        if( dot.GetX() >= minX && dot.GetX() <= maxX && dot.GetY() >= minY && dot.GetY() <= maxY )
+        {
+          dotIndices.push_back( m_DotGridDotIndices[i] );
+        }
+      }
+    }
+  }
+
+  // Dots are tested in the same order as without the grid
+  std::sort( dotIndices.begin(), dotIndices.end() );
+}
+
+//-----------------------------------------------------------------------------
+
 void PlusFidLineFinder::FindLines( )
 {
   LOG_TRACE( "FidLineFinder::FindLines" );
 
+  if( m_UseFastLineFinding )
+  {
+    BuildDotGrid();
+  }
+
   // Make pairs of dots into 2-point lines.
   FindLines2Points();
 
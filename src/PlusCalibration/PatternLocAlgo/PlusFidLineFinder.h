@@ -50,6 +50,14 @@ public:
   /*! Set the maximum distance from a point to a line when the point is tested to be a point of the line */
   void SetCollinearPointsMaxDistanceFromLineMm( double value ) { m_CollinearPointsMaxDistanceFromLineMm = value; };
 
+  /*!
+    If true (default) then dots are stored in a uniform grid and only the dots in the region where the line length
+    and collinearity tolerances can be met are tested when lines are formed, instead of testing all the dots.
+    The found lines are the same.
+  */
+  void SetUseFastLineFinding( bool value ) { m_UseFastLineFinding = value; };
+  bool GetUseFastLineFinding() { return m_UseFastLineFinding; };
+
   /*! Read the configuration file from a vtk XML data element */
   PlusStatus ReadConfiguration( vtkXMLDataElement* rootConfigElement );
 
@@ -106,6 +114,12 @@ protected:
   /*! Return true if an angle is in the allowed angle range, false otherwise */
   bool AcceptAngleRad( double angleRad );
 
+  /*! Sort the dots into the cells of a uniform grid, which is used for finding the dots in a region */
+  void BuildDotGrid();
+
+  /*! Get the indices (in ascending order) of the dots that are in the specified rectangle (in pixels) */
+  void GetDotIndicesInRegion( double minX, double minY, double maxX, double maxY, std::vector<int>& dotIndices );
+
   //Accessors and mutators
 
   /*! Get the maximum rotation vector, this maximum rotation represents the physical limitation of the probe,
@@ -134,6 +148,18 @@ protected:
   std::vector< std::vector<PlusFidLine> > m_LinesVector;
 
   std::vector<PlusFidPattern*> m_Patterns;
+
+  bool m_UseFastLineFinding;
+
+  /*! Position of the first grid cell corner and the size of the square cells, in pixels */
+  double m_DotGridOrigin[2];
+  double m_DotGridCellSizePx;
+  /*! Number of grid cells along X and Y */
+  int m_DotGridSize[2];
+  /*! Index of the first dot of each cell in m_DotGridDotIndices (one more element than the number of cells) */
+  std::vector<int> m_DotGridCellFirstDot;
+  /*! Dot indices ordered by cell */
+  std::vector<int> m_DotGridDotIndices;
 };
 
 #endif // _FIDUCIAL_LINE_FINDER_H
@@ -13,12 +13,17 @@ See License.txt for details.
 #include "vtkPlusTrackedFrameList.h"
 #include "PlusTrackedFrame.h"
 
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
 static const double DOT_STEPS  = 4.0;
 static const double DOT_RADIUS = 6.0;
 
 //-----------------------------------------------------------------------------
 
 PlusFidPatternRecognition::PlusFidPatternRecognition()
+  : m_NumberOfThreads(1)
 {
 
 }
@@ -46,6 +51,12 @@ PlusStatus PlusFidPatternRecognition::ReadConfiguration(vtkXMLDataElement* rootC
   m_FidLineFinder.ReadConfiguration(rootConfigElement);
   m_FidLabeling.ReadConfiguration(rootConfigElement, m_FidLineFinder.GetMinThetaRad(), m_FidLineFinder.GetMaxThetaRad());
 
+  vtkXMLDataElement* segmentationParameters = rootConfigElement->FindNestedElementWithName("Segmentation");
+  if (segmentationParameters != NULL)
+  {
+    XML_READ_SCALAR_ATTRIBUTE_OPTIONAL(unsigned long, NumberOfThreads, segmentationParameters);
+  }
+
   return PLUS_SUCCESS;
 }
 
@@ -76,18 +87,25 @@ PlusStatus PlusFidPatternRecognition::RecognizePattern(PlusTrackedFrame* tracked
 //-----------------------------------------------------------------------------
 
 PlusStatus PlusFidPatternRecognition::RecognizePattern(PlusTrackedFrame* trackedFrame, PatternRecognitionError& patternRecognitionError, unsigned int frameIndex)
+{
+  return RecognizePattern(trackedFrame, m_FidSegmentation, m_FidLineFinder, m_FidLabeling, patternRecognitionError, frameIndex);
+}
+
+//-----------------------------------------------------------------------------
+
+PlusStatus PlusFidPatternRecognition::RecognizePattern(PlusTrackedFrame* trackedFrame, PlusFidSegmentation& fidSegmentation, PlusFidLineFinder& fidLineFinder, PlusFidLabeling& fidLabeling, PatternRecognitionError& patternRecognitionError, unsigned int frameIndex)
 {
   LOG_TRACE("FidPatternRecognition::RecognizePattern");
 
   patternRecognitionError = PATTERN_RECOGNITION_ERROR_NO_ERROR;
 
-  m_FidSegmentation.Clear();
-  m_FidLineFinder.Clear();
-  m_FidLabeling.Clear();
+  fidSegmentation.Clear();
+  fidLineFinder.Clear();
+  fidLabeling.Clear();
 
-  m_FidSegmentation.SetFrameSize(trackedFrame->GetFrameSize());
-  m_FidLineFinder.SetFrameSize(trackedFrame->GetFrameSize());
-  m_FidLabeling.SetFrameSize(trackedFrame->GetFrameSize());
+  fidSegmentation.SetFrameSize(trackedFrame->GetFrameSize());
+  fidLineFinder.SetFrameSize(trackedFrame->GetFrameSize());
+  fidLabeling.SetFrameSize(trackedFrame->GetFrameSize());
 
   if (trackedFrame->GetImageData()->GetVTKScalarPixelType() != VTK_UNSIGNED_CHAR)
   {
@@ -99,14 +117,14 @@ PlusStatus PlusFidPatternRecognition::RecognizePattern(PlusTrackedFrame* tracked
   int bytes = trackedFrame->GetFrameSize()[0] * trackedFrame->GetFrameSize()[1] * sizeof(PlusFidSegmentation::PixelType);
   PlusFidSegmentation::PixelType* image = reinterpret_cast<PlusFidSegmentation::PixelType*>(trackedFrame->GetImageData()->GetScalarPointer());
 
-  memcpy(m_FidSegmentation.GetWorking(), image, bytes);
-  memcpy(m_FidSegmentation.GetUnalteredImage(), image, bytes);
+  memcpy(fidSegmentation.GetWorking(), image, bytes);
+  memcpy(fidSegmentation.GetUnalteredImage(), image, bytes);
 
   //Start of the segmentation
-  m_FidSegmentation.MorphologicalOperations();
-  m_FidSegmentation.Suppress(m_FidSegmentation.GetWorking(), m_FidSegmentation.GetThresholdImagePercent() / 100.00);
+  fidSegmentation.MorphologicalOperations();
+  fidSegmentation.Suppress(fidSegmentation.GetWorking(), fidSegmentation.GetThresholdImagePercent() / 100.00);
   bool tooManyCandidates = false;
-  bool clusteringSuccessful = m_FidSegmentation.Cluster(tooManyCandidates);
+  bool clusteringSuccessful = fidSegmentation.Cluster(tooManyCandidates);
   if (tooManyCandidates)
   {
     patternRecognitionError = PATTERN_RECOGNITION_ERROR_TOO_MANY_CANDIDATES;
@@ -118,29 +136,29 @@ PlusStatus PlusFidPatternRecognition::RecognizePattern(PlusTrackedFrame* tracked
 
   //End of the segmentation
 
-  m_FidSegmentation.SetCandidateFidValues(m_FidSegmentation.GetDotsVector());
+  fidSegmentation.SetCandidateFidValues(fidSegmentation.GetDotsVector());
 
-  m_FidLineFinder.SetCandidateFidValues(m_FidSegmentation.GetCandidateFidValues());
-  m_FidLineFinder.SetDotsVector(m_FidSegmentation.GetDotsVector());
-  m_FidLabeling.SetDotsVector(m_FidSegmentation.GetDotsVector());
+  fidLineFinder.SetCandidateFidValues(fidSegmentation.GetCandidateFidValues());
+  fidLineFinder.SetDotsVector(fidSegmentation.GetDotsVector());
+  fidLabeling.SetDotsVector(fidSegmentation.GetDotsVector());
 
-  m_FidLineFinder.FindLines();
+  fidLineFinder.FindLines();
 
-  if (m_FidLineFinder.GetLinesVector().size() > 3)
+  if (fidLineFinder.GetLinesVector().size() > 3)
   {
-    m_FidLabeling.SetLinesVector(m_FidLineFinder.GetLinesVector());
-    m_FidLabeling.FindPattern();
+    fidLabeling.SetLinesVector(fidLineFinder.GetLinesVector());
+    fidLabeling.FindPattern();
   }
 
-  if (m_FidSegmentation.GetDebugOutput())
+  if (fidSegmentation.GetDebugOutput())
   {
     //Displays the result dots
-    m_FidSegmentation.WritePossibleFiducialOverlayImage(m_FidLabeling.GetFoundDotsCoordinateValue(), m_FidSegmentation.GetUnalteredImage(), "foundFiducials", frameIndex);
-    m_FidSegmentation.WritePossibleFiducialOverlayImage(m_FidSegmentation.GetCandidateFidValues(), m_FidSegmentation.GetUnalteredImage(), "candidateFiducials", frameIndex);   //Display all candidates dots
+    fidSegmentation.WritePossibleFiducialOverlayImage(fidLabeling.GetFoundDotsCoordinateValue(), fidSegmentation.GetUnalteredImage(), "foundFiducials", frameIndex);
+    fidSegmentation.WritePossibleFiducialOverlayImage(fidSegmentation.GetCandidateFidValues(), fidSegmentation.GetUnalteredImage(), "candidateFiducials", frameIndex);   //Display all candidates dots
   }
 
   // Set results
-  std::vector< std::vector<double> > fiducials = m_FidLabeling.GetFoundDotsCoordinateValue();
+  std::vector< std::vector<double> > fiducials = fidLabeling.GetFoundDotsCoordinateValue();
 
   vtkSmartPointer<vtkPoints> fiducialPoints = vtkSmartPointer<vtkPoints>::New();
   fiducialPoints->SetNumberOfPoints(fiducials.size());
@@ -178,17 +196,82 @@ PlusStatus PlusFidPatternRecognition::RecognizePattern(vtkPlusTrackedFrameList*
     *numberOfSuccessfullySegmentedImages = 0;
   }
 
+  // segment only non segmented frames
+  std::vector<unsigned int> frameIndicesToSegment;
   for (unsigned int currentFrameIndex = 0; currentFrameIndex < trackedFrameList->GetNumberOfTrackedFrames(); currentFrameIndex++)
   {
-    PlusTrackedFrame* trackedFrame = trackedFrameList->GetTrackedFrame(currentFrameIndex);
+    if (trackedFrameList->GetTrackedFrame(currentFrameIndex)->GetFiducialPointsCoordinatePx() == NULL)
+    {
+      frameIndicesToSegment.push_back(currentFrameIndex);
+    }
+  }
+  const int numberOfFramesToSegment = static_cast<int>(frameIndicesToSegment.size());
+
+  int numberOfThreads = m_NumberOfThreads;
+  if (numberOfThreads <= 0)
+  {
+    numberOfThreads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+  }
+  if (m_FidSegmentation.GetDebugOutput())
+  {
+    // debug images of the segmentation steps are written to files with the same name for all frames
+    numberOfThreads = 1;
+  }
+  numberOfThreads = std::min(numberOfThreads, numberOfFramesToSegment);
 
-    // segment only non segmented frames
-    if (trackedFrame->GetFiducialPointsCoordinatePx() != NULL)
+  std::vector<PlusStatus> frameStatus(numberOfFramesToSegment, PLUS_SUCCESS);
+  std::vector<PatternRecognitionError> frameErrors(numberOfFramesToSegment, PATTERN_RECOGNITION_ERROR_NO_ERROR);
+  if (numberOfThreads <= 1)
+  {
+    for (int i = 0; i < numberOfFramesToSegment; i++)
     {
-      continue;
+      frameStatus[i] = RecognizePattern(trackedFrameList->GetTrackedFrame(frameIndicesToSegment[i]), frameErrors[i], frameIndicesToSegment[i]);
     }
+  }
+  else
+  {
+    // Frames are independent, each thread takes the next frame to segment and processes it with its own copy of the algorithm components
+    std::vector<PlusFidSegmentation> fidSegmentations(numberOfThreads, m_FidSegmentation);
+    std::vector<PlusFidLineFinder> fidLineFinders(numberOfThreads, m_FidLineFinder);
+    std::vector<PlusFidLabeling> fidLabelings(numberOfThreads, m_FidLabeling);
+    std::atomic<int> nextFrameToSegment(0);
+    int lastFrameThreadIndex = 0;
+    auto segmentFrames = [&](int threadIndex)
+    {
+      for (int i = nextFrameToSegment++; i < numberOfFramesToSegment; i = nextFrameToSegment++)
+      {
+        frameStatus[i] = RecognizePattern(trackedFrameList->GetTrackedFrame(frameIndicesToSegment[i]), fidSegmentations[threadIndex], fidLineFinders[threadIndex], fidLabelings[threadIndex], frameErrors[i], frameIndicesToSegment[i]);
+        if (i == numberOfFramesToSegment - 1)
+        {
+          // only one thread gets the last frame, the value is read after the threads are joined
+          lastFrameThreadIndex = threadIndex;
+        }
+      }
+    };
+    std::vector<std::thread> segmentationThreads;
+    for (int threadIndex = 0; threadIndex < numberOfThreads; threadIndex++)
+    {
+      segmentationThreads.push_back(std::thread(segmentFrames, threadIndex));
+    }
+    for (std::vector<std::thread>::iterator threadIt = segmentationThreads.begin(); threadIt != segmentationThreads.end(); ++threadIt)
+    {
+      threadIt->join();
+    }
+
+    // Keep the state of the last segmented frame in the algorithm components, as with a single thread
+    m_FidSegmentation = fidSegmentations[lastFrameThreadIndex];
+    m_FidLineFinder = fidLineFinders[lastFrameThreadIndex];
+    m_FidLabeling = fidLabelings[lastFrameThreadIndex];
+  }
+
+  // Collect the results in frame order
+  for (int i = 0; i < numberOfFramesToSegment; i++)
+  {
+    unsigned int currentFrameIndex = frameIndicesToSegment[i];
+    PlusTrackedFrame* trackedFrame = trackedFrameList->GetTrackedFrame(currentFrameIndex);
 
-    if (RecognizePattern(trackedFrame, patternRecognitionError, currentFrameIndex) != PLUS_SUCCESS)
+    patternRecognitionError = frameErrors[i];
+    if (frameStatus[i] != PLUS_SUCCESS)
     {
       if (patternRecognitionError != PATTERN_RECOGNITION_ERROR_TOO_MANY_CANDIDATES)
       {
@@ -44,7 +44,11 @@ public:
 
   /*!
   Run pattern recognition on a tracked frame list.
-  It only segments the tracked frames which were not already segmented
+  It only segments the tracked frames which were not already segmented.
+  If multiple threads are used (see SetNumberOfThreads) then each thread segments frames with its own copy of the
+  segmentation, line finder and labeling components. The components of this object are updated from the copy that
+  segmented the last frame, so the results, the segmented frame indices and the state of the components are the same
+  as with a single thread.
   \param trackedFrameList Tracked frame list to segment
   \param numberOfSuccessfullySegmentedImages Out parameter holding the number of segmented images in this call (it is only equals the number of all segmented images in the tracked frame if it was not segmented at all)
   \param segmentedFramesIndices Indices of the frames that were properly segmented
@@ -92,9 +96,19 @@ public:
   /*! Set the maximum number of candidates to consider */
   void SetNumberOfMaximumFiducialPointCandidates(int aMax);
 
+  /*! Set the number of threads used for segmenting a tracked frame list. If 0 then the number of processor cores is used. Default is 1. */
+  void SetNumberOfThreads(int numberOfThreads) { m_NumberOfThreads = numberOfThreads; };
+
+  /*! Get the number of threads used for segmenting a tracked frame list. If 0 then the number of processor cores is used. */
+  int GetNumberOfThreads() { return m_NumberOfThreads; };
+
   /*! Reads the phantom definition and computes the NWires intersection if needed */
   PlusStatus ReadPhantomDefinition(vtkXMLDataElement* rootConfigElement);
 
+protected:
+  /*! Run pattern recognition on a tracked frame using the specified algorithm components */
+  static PlusStatus RecognizePattern(PlusTrackedFrame* trackedFrame, PlusFidSegmentation& fidSegmentation, PlusFidLineFinder& fidLineFinder, PlusFidLabeling& fidLabeling, PatternRecognitionError& patternRecognitionError, unsigned int frameIndex);
+
 protected:
 
   PlusFidSegmentation           m_FidSegmentation;
@@ -103,6 +117,9 @@ protected:
   std::vector<PlusFidPattern*>  m_Patterns;
 
   double                        m_MaxLineLengthToleranceMm;
+
+  /*! Number of threads used for segmenting a tracked frame list (0 = number of processor cores, default: 1) */
+  int                           m_NumberOfThreads;
 };
 
 //-----------------------------------------------------------------------------
@@ -10,9 +10,14 @@
 #include "vtkMath.h"
 
 #include <limits.h>
+#include <stdlib.h>
 #include <iostream>
 #include <algorithm>
 
+#ifdef PLUS_SSE2_AVAILABLE
+#include <emmintrin.h>
+#endif
+
 #include "itkRGBPixel.h"
 #include "itkImage.h"
 #include "itkImageFileReader.h"
@@ -27,6 +32,274 @@ const int PlusFidSegmentation::DEFAULT_NUMBER_OF_MAXIMUM_FIDUCIAL_POINT_CANDIDAT
 
 //-----------------------------------------------------------------------------
 
+namespace
+{
+  /*! Minimum of pixel values (erosion) for scalar and vectorized row operations */
+  struct MorphologyMinimum
+  {
+    static inline PlusFidSegmentation::PixelType Apply(PlusFidSegmentation::PixelType a, PlusFidSegmentation::PixelType b) { return a < b ? a : b; }
+#ifdef PLUS_SSE2_AVAILABLE
+    static inline __m128i Apply(__m128i a, __m128i b) { return _mm_min_epu8(a, b); }
+#endif
+  };
+
+  /*! Maximum of pixel values (dilation) for scalar and vectorized row operations */
+  struct MorphologyMaximum
+  {
+    static inline PlusFidSegmentation::PixelType Apply(PlusFidSegmentation::PixelType a, PlusFidSegmentation::PixelType b) { return a > b ? a : b; }
+#ifdef PLUS_SSE2_AVAILABLE
+    static inline __m128i Apply(__m128i a, __m128i b) { return _mm_max_epu8(a, b); }
+#endif
+  };
+
+  //-----------------------------------------------------------------------------
+  // output[i] = Op(a[i], b[i]) for i in [0, count). The output may be the same array as an input.
+  template <class Op> void CombineRows(PlusFidSegmentation::PixelType* output, const PlusFidSegmentation::PixelType* a, const PlusFidSegmentation::PixelType* b, int count)
+  {
+    int i = 0;
+#ifdef PLUS_SSE2_AVAILABLE
+    for (; i + 16 <= count; i += 16)
+    {
+      __m128i valuesA = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+      __m128i valuesB = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i), Op::Apply(valuesA, valuesB));
+    }
+#endif
+    for (; i < count; i++)
+    {
+      output[i] = Op::Apply(a[i], b[i]);
+    }
+  }
+
+  //-----------------------------------------------------------------------------
+  // Running minimum/maximum over a horizontal bar (van Herk/Gil-Werman algorithm).
+  // The row is split into blocks of the bar length. The forward buffer contains the running value from the start of the block,
+  // the backward buffer from the end of the block, so that any bar is covered by the backward value at its first pixel
+  // and the forward value at its last pixel.
+  template <class Op> void FilterHorizontalBar(PlusFidSegmentation::PixelType* dest, const PlusFidSegmentation::PixelType* image,
+      const unsigned int frameSize[2], const unsigned int roi[4], int barSize, std::vector<PlusFidSegmentation::PixelType>& buffer)
+  {
+    memset(dest, 0, frameSize[1]*frameSize[0]*sizeof(PlusFidSegmentation::PixelType));
+    if (roi[0] >= roi[2] || roi[1] >= roi[3])
+    {
+      return;
+    }
+
+    const int barLength = 2 * barSize + 1;
+    const int roiWidth = roi[2] - roi[0];
+    const int inputWidth = roiWidth + 2 * barSize;
+    buffer.resize(2 * inputWidth);
+    PlusFidSegmentation::PixelType* forward = &buffer[0];
+    PlusFidSegmentation::PixelType* backward = forward + inputWidth;
+
+    for (unsigned int ir = roi[1]; ir < roi[3]; ir++)
+    {
+      const PlusFidSegmentation::PixelType* input = image + ir * frameSize[0] + roi[0] - barSize;
+      for (int blockStart = 0; blockStart < inputWidth; blockStart += barLength)
+      {
+        int blockEnd = std::min(blockStart + barLength, inputWidth);
+        forward[blockStart] = input[blockStart];
+        for (int i = blockStart + 1; i < blockEnd; i++)
+        {
+          forward[i] = Op::Apply(forward[i - 1], input[i]);
+        }
+        backward[blockEnd - 1] = input[blockEnd - 1];
+        for (int i = blockEnd - 2; i >= blockStart; i--)
+        {
+          backward[i] = Op::Apply(backward[i + 1], input[i]);
+        }
+      }
+      PlusFidSegmentation::PixelType* output = dest + ir * frameSize[0] + roi[0];
+      for (int ic = 0; ic < roiWidth; ic++)
+      {
+        output[ic] = Op::Apply(backward[ic], forward[ic + 2 * barSize]);
+      }
+    }
+  }
+
+  //-----------------------------------------------------------------------------
+  // Running minimum/maximum over a vertical (columnStep = 0) or diagonal (columnStep = +1 or -1) bar.
+  // Pixels of the bar centered at (r, c) are (r + t, c + t * columnStep), t = -barSize..barSize.
+  // Same algorithm as FilterHorizontalBar, but blocks are formed of rows, so that the running values of all the lines
+  // are updated by combining a whole row with the (shifted) previous row, which is vectorized.
+  // Lines that enter or leave the processed region through its side start a new block there, which is correct as
+  // the bars of the region of interest are entirely inside the processed region.
+  template <class Op> void FilterBarAlongColumns(PlusFidSegmentation::PixelType* dest, const PlusFidSegmentation::PixelType* image,
+      const unsigned int frameSize[2], const unsigned int roi[4], int barSize, int columnStep, std::vector<PlusFidSegmentation::PixelType>& buffer)
+  {
+    memset(dest, 0, frameSize[1]*frameSize[0]*sizeof(PlusFidSegmentation::PixelType));
+    if (roi[0] >= roi[2] || roi[1] >= roi[3])
+    {
+      return;
+    }
+
+    const int barLength = 2 * barSize + 1;
+    const int columnMargin = (columnStep != 0 ? barSize : 0);
+    const int roiWidth = roi[2] - roi[0];
+    const int inputWidth = roiWidth + 2 * columnMargin;
+    const int inputHeight = roi[3] - roi[1] + 2 * barSize;
+    const int frameWidth = frameSize[0];
+    const PlusFidSegmentation::PixelType* input = image + (roi[1] - barSize) * frameWidth + roi[0] - columnMargin;
+    buffer.resize(2 * inputWidth * inputHeight);
+    PlusFidSegmentation::PixelType* forward = &buffer[0];
+    PlusFidSegmentation::PixelType* backward = forward + inputWidth * inputHeight;
+
+    // Columns where the line continues from the previous (forward) or next (backward) row inside the processed region
+    const int linkedWidth = inputWidth - (columnStep != 0 ? 1 : 0);
+    const int forwardLinkedStart = (columnStep > 0 ? 1 : 0);
+    const int backwardLinkedStart = (columnStep < 0 ? 1 : 0);
+    const int forwardEntryColumn = (columnStep > 0 ? 0 : inputWidth - 1);
+    const int backwardEntryColumn = (columnStep > 0 ? inputWidth - 1 : 0);
+
+    for (int blockStart = 0; blockStart < inputHeight; blockStart += barLength)
+    {
+      int blockEnd = std::min(blockStart + barLength, inputHeight);
+
+      memcpy(forward + blockStart * inputWidth, input + blockStart * frameWidth, inputWidth * sizeof(PlusFidSegmentation::PixelType));
+      for (int i = blockStart + 1; i < blockEnd; i++)
+      {
+        PlusFidSegmentation::PixelType* forwardRow = forward + i * inputWidth;
+        const PlusFidSegmentation::PixelType* inputRow = input + i * frameWidth;
+        CombineRows<Op>(forwardRow + forwardLinkedStart, forwardRow - inputWidth + forwardLinkedStart - columnStep, inputRow + forwardLinkedStart, linkedWidth);
+        if (columnStep != 0)
+        {
+          forwardRow[forwardEntryColumn] = inputRow[forwardEntryColumn];
+        }
+      }
+
+      memcpy(backward + (blockEnd - 1) * inputWidth, input + (blockEnd - 1) * frameWidth, inputWidth * sizeof(PlusFidSegmentation::PixelType));
+      for (int i = blockEnd - 2; i >= blockStart; i--)
+      {
+        PlusFidSegmentation::PixelType* backwardRow = backward + i * inputWidth;
+        const PlusFidSegmentation::PixelType* inputRow = input + i * frameWidth;
+        CombineRows<Op>(backwardRow + backwardLinkedStart, backwardRow + inputWidth + backwardLinkedStart + columnStep, inputRow + backwardLinkedStart, linkedWidth);
+        if (columnStep != 0)
+        {
+          backwardRow[backwardEntryColumn] = inputRow[backwardEntryColumn];
+        }
+      }
+    }
+
+    for (unsigned int ir = roi[1]; ir < roi[3]; ir++)
+    {
+      int i = ir - roi[1] + barSize;
+      CombineRows<Op>(dest + ir * frameWidth + roi[0],
+                      backward + (i - barSize) * inputWidth + columnMargin - barSize * columnStep,
+                      forward + (i + barSize) * inputWidth + columnMargin + barSize * columnStep, roiWidth);
+    }
+  }
+
+  //-----------------------------------------------------------------------------
+  // Minimum/maximum over a disk shaped structuring element, decomposed to horizontal chords.
+  // Running values over chords of half width w are computed for each input row incrementally from the half width w-1
+  // values, then each output row is combined from the chords of the rows it covers.
+  // If shapeXIsRowOffset is true then the X coordinate of the shape points is the row offset and Y is the column offset,
+  // otherwise the opposite. Returns false (without modifying dest) if the shape is not a union of centered horizontal
+  // chords or it does not fit in the image around the region of interest.
+  template <class Op> bool FilterDisk(PlusFidSegmentation::PixelType* dest, const PlusFidSegmentation::PixelType* image,
+                                      const unsigned int frameSize[2], const unsigned int roi[4], const std::vector<PlusCoordinate2D>& shape, bool shapeXIsRowOffset,
+                                      std::vector<PlusFidSegmentation::PixelType>& buffer)
+  {
+    if (shape.empty())
+    {
+      return false;
+    }
+    int radius = 0;
+    for (std::vector<PlusCoordinate2D>::const_iterator pointIt = shape.begin(); pointIt != shape.end(); ++pointIt)
+    {
+      radius = std::max(radius, abs(shapeXIsRowOffset ? pointIt->X : pointIt->Y));
+    }
+    std::vector<int> chordHalfWidths(2 * radius + 1, -1);
+    std::vector<int> chordPointCounts(2 * radius + 1, 0);
+    for (std::vector<PlusCoordinate2D>::const_iterator pointIt = shape.begin(); pointIt != shape.end(); ++pointIt)
+    {
+      int rowOffset = (shapeXIsRowOffset ? pointIt->X : pointIt->Y);
+      int columnOffset = (shapeXIsRowOffset ? pointIt->Y : pointIt->X);
+      chordHalfWidths[rowOffset + radius] = std::max(chordHalfWidths[rowOffset + radius], abs(columnOffset));
+      chordPointCounts[rowOffset + radius]++;
+    }
+    int maxHalfWidth = 0;
+    for (int chordIndex = 0; chordIndex <= 2 * radius; chordIndex++)
+    {
+      if (chordHalfWidths[chordIndex] < 0 || chordPointCounts[chordIndex] != 2 * chordHalfWidths[chordIndex] + 1)
+      {
+        return false;
+      }
+      maxHalfWidth = std::max(maxHalfWidth, chordHalfWidths[chordIndex]);
+    }
+    if (roi[0] < roi[2] && roi[1] < roi[3]
+        && (roi[0] < static_cast<unsigned int>(maxHalfWidth) || roi[2] - 1 + maxHalfWidth >= frameSize[0]
+            || roi[1] < static_cast<unsigned int>(radius) || roi[3] - 1 + radius >= frameSize[1]))
+    {
+      return false;
+    }
+
+    memset(dest, 0, frameSize[1]*frameSize[0]*sizeof(PlusFidSegmentation::PixelType));
+    if (roi[0] >= roi[2] || roi[1] >= roi[3])
+    {
+      return true;
+    }
+
+    const int frameWidth = frameSize[0];
+    const int roiWidth = roi[2] - roi[0];
+    const int chordBufferWidth = roiWidth + 2 * maxHalfWidth;
+    buffer.resize((maxHalfWidth + 1) * chordBufferWidth);
+    // chords[w][ic]: running value over columns ic-w..ic+w (relative to the region of interest) of the current input row
+    std::vector<const PlusFidSegmentation::PixelType*> chords(maxHalfWidth + 1);
+
+    const int firstInputRow = roi[1] - radius;
+    const int lastInputRow = roi[3] - 1 + radius;
+    for (int inputRow = firstInputRow; inputRow <= lastInputRow; inputRow++)
+    {
+      // Output rows that this input row contributes to: inputRow - rowOffset
+      int minRowOffset = std::max(-radius, inputRow - static_cast<int>(roi[3] - 1));
+      int maxRowOffset = std::min(radius, inputRow - static_cast<int>(roi[1]));
+      int neededHalfWidth = 0;
+      for (int rowOffset = minRowOffset; rowOffset <= maxRowOffset; rowOffset++)
+      {
+        neededHalfWidth = std::max(neededHalfWidth, chordHalfWidths[rowOffset + radius]);
+      }
+
+      chords[0] = image + inputRow * frameWidth + roi[0];
+      for (int halfWidth = 1; halfWidth <= neededHalfWidth; halfWidth++)
+      {
+        // Values are needed for columns -margin..roiWidth+margin-1 for computing the wider chords
+        int margin = maxHalfWidth - halfWidth;
+        PlusFidSegmentation::PixelType* chord = &buffer[halfWidth * chordBufferWidth] + maxHalfWidth;
+        const PlusFidSegmentation::PixelType* narrowerChord = chords[halfWidth - 1];
+        if (halfWidth == 1)
+        {
+          CombineRows<Op>(chord - margin, narrowerChord - margin - 1, narrowerChord - margin, roiWidth + 2 * margin);
+          CombineRows<Op>(chord - margin, chord - margin, narrowerChord - margin + 1, roiWidth + 2 * margin);
+        }
+        else
+        {
+          CombineRows<Op>(chord - margin, narrowerChord - margin - 1, narrowerChord - margin + 1, roiWidth + 2 * margin);
+        }
+        chords[halfWidth] = chord;
+      }
+
+      for (int rowOffset = minRowOffset; rowOffset <= maxRowOffset; rowOffset++)
+      {
+        PlusFidSegmentation::PixelType* output = dest + (inputRow - rowOffset) * frameWidth + roi[0];
+        const PlusFidSegmentation::PixelType* chord = chords[chordHalfWidths[rowOffset + radius]];
+        if (rowOffset == -radius)
+        {
+          // first input row of this output row
+          memcpy(output, chord, roiWidth * sizeof(PlusFidSegmentation::PixelType));
+        }
+        else
+        {
+          CombineRows<Op>(output, output, chord, roiWidth);
+        }
+      }
+    }
+    return true;
+  }
+}
+
+//-----------------------------------------------------------------------------
+
 PlusFidSegmentation::PlusFidSegmentation()
   : m_UseOriginalImageIntensityForDotIntensityScore(false)
   , m_NumberOfMaximumFiducialPointCandidates(DEFAULT_NUMBER_OF_MAXIMUM_FIDUCIAL_POINT_CANDIDATES)
@@ -43,6 +316,7 @@ PlusFidSegmentation::PlusFidSegmentation()
   , m_Eroded(new PlusFidSegmentation::PixelType[1])
   , m_UnalteredImage(new PlusFidSegmentation::PixelType[1])
   , m_DebugOutput(false)
+  , m_UseFastMorphology(true)
 {
   //Initialization of member variables
   m_FrameSize[0] = 0;
@@ -76,6 +350,19 @@ PlusFidSegmentation::PlusFidSegmentation()
 
 //-----------------------------------------------------------------------------
 
+PlusFidSegmentation::PlusFidSegmentation(const PlusFidSegmentation& other)
+  : m_Working(NULL)
+  , m_Dilated(NULL)
+  , m_Eroded(NULL)
+  , m_UnalteredImage(NULL)
+{
+  m_FrameSize[0] = 0;
+  m_FrameSize[1] = 0;
+  *this = other;
+}
+
+//-----------------------------------------------------------------------------
+
 PlusFidSegmentation::~PlusFidSegmentation()
 {
   delete[] m_Dilated;
@@ -86,6 +373,57 @@ PlusFidSegmentation::~PlusFidSegmentation()
 
 //-----------------------------------------------------------------------------
 
+PlusFidSegmentation& PlusFidSegmentation::operator=(const PlusFidSegmentation& other)
+{
+  if (this == &other)
+  {
+    return *this;
+  }
+
+  m_UseOriginalImageIntensityForDotIntensityScore = other.m_UseOriginalImageIntensityForDotIntensityScore;
+  m_NumberOfMaximumFiducialPointCandidates = other.m_NumberOfMaximumFiducialPointCandidates;
+  m_ThresholdImagePercent = other.m_ThresholdImagePercent;
+  m_MorphologicalOpeningBarSizeMm = other.m_MorphologicalOpeningBarSizeMm;
+  m_MorphologicalOpeningCircleRadiusMm = other.m_MorphologicalOpeningCircleRadiusMm;
+  m_PossibleFiducialsImageFilename = other.m_PossibleFiducialsImageFilename;
+  m_FiducialGeometry = other.m_FiducialGeometry;
+  m_MorphologicalCircle = other.m_MorphologicalCircle;
+  m_ApproximateSpacingMmPerPixel = other.m_ApproximateSpacingMmPerPixel;
+  memcpy(m_RegionOfInterest, other.m_RegionOfInterest, sizeof(m_RegionOfInterest));
+  memcpy(m_ImageScalingTolerancePercent, other.m_ImageScalingTolerancePercent, sizeof(m_ImageScalingTolerancePercent));
+  memcpy(m_ImageNormalVectorInPhantomFrameEstimation, other.m_ImageNormalVectorInPhantomFrameEstimation, sizeof(m_ImageNormalVectorInPhantomFrameEstimation));
+  memcpy(m_ImageNormalVectorInPhantomFrameMaximumRotationAngleDeg, other.m_ImageNormalVectorInPhantomFrameMaximumRotationAngleDeg, sizeof(m_ImageNormalVectorInPhantomFrameMaximumRotationAngleDeg));
+  memcpy(m_ImageToPhantomTransform, other.m_ImageToPhantomTransform, sizeof(m_ImageToPhantomTransform));
+  m_DotsFound = other.m_DotsFound;
+  m_FoundDotsCoordinateValue = other.m_FoundDotsCoordinateValue;
+  m_NumDots = other.m_NumDots;
+  m_CandidateFidValues = other.m_CandidateFidValues;
+  m_DotsVector = other.m_DotsVector;
+  m_DebugOutput = other.m_DebugOutput;
+  m_UseFastMorphology = other.m_UseFastMorphology;
+
+  // Working images (the temporary buffer of the fast morphological operations is not copied, it is allocated when needed)
+  delete[] m_Dilated;
+  delete[] m_Eroded;
+  delete[] m_Working;
+  delete[] m_UnalteredImage;
+  m_FrameSize[0] = other.m_FrameSize[0];
+  m_FrameSize[1] = other.m_FrameSize[1];
+  long size = std::max<long>(1, static_cast<long>(m_FrameSize[0]) * m_FrameSize[1]);
+  m_Dilated = new PlusFidSegmentation::PixelType[size];
+  m_Eroded = new PlusFidSegmentation::PixelType[size];
+  m_Working = new PlusFidSegmentation::PixelType[size];
+  m_UnalteredImage = new PlusFidSegmentation::PixelType[size];
+  memcpy(m_Dilated, other.m_Dilated, size * sizeof(PlusFidSegmentation::PixelType));
+  memcpy(m_Eroded, other.m_Eroded, size * sizeof(PlusFidSegmentation::PixelType));
+  memcpy(m_Working, other.m_Working, size * sizeof(PlusFidSegmentation::PixelType));
+  memcpy(m_UnalteredImage, other.m_UnalteredImage, size * sizeof(PlusFidSegmentation::PixelType));
+
+  return *this;
+}
+
+//-----------------------------------------------------------------------------
+
 void PlusFidSegmentation::UpdateParameters()
 {
   LOG_TRACE("FidSegmentation::UpdateParameters");
@@ -185,6 +523,7 @@ PlusStatus PlusFidSegmentation::ReadConfiguration(vtkXMLDataElement* configData)
   }
 
   XML_READ_SCALAR_ATTRIBUTE_OPTIONAL(int, NumberOfMaximumFiducialPointCandidates, segmentationParameters);
+  XML_READ_BOOL_ATTRIBUTE_OPTIONAL(UseFastMorphology, segmentationParameters);
 
   UpdateParameters();
 
@@ -308,6 +647,12 @@ void PlusFidSegmentation::Erode0(PlusFidSegmentation::PixelType* dest, PlusFidSe
 {
   //LOG_TRACE("FidSegmentation::Erode0");
 
+  if (m_UseFastMorphology)
+  {
+    FilterHorizontalBar<MorphologyMinimum>(dest, image, m_FrameSize, m_RegionOfInterest, GetMorphologicalOpeningBarSizePx(), m_MorphologyBuffer);
+    return;
+  }
+
   memset(dest, 0, m_FrameSize[1]*m_FrameSize[0]*sizeof(PlusFidSegmentation::PixelType));
 
   const unsigned int barSize = GetMorphologicalOpeningBarSizePx();
@@ -366,6 +711,12 @@ void PlusFidSegmentation::Erode45(PlusFidSegmentation::PixelType* dest, PlusFidS
 {
   //LOG_TRACE("FidSegmentation::Erode45");
 
+  if (m_UseFastMorphology)
+  {
+    FilterBarAlongColumns<MorphologyMinimum>(dest, image, m_FrameSize, m_RegionOfInterest, GetMorphologicalOpeningBarSizePx(), -1, m_MorphologyBuffer);
+    return;
+  }
+
   memset(dest, 0, m_FrameSize[1]*m_FrameSize[0]*sizeof(PlusFidSegmentation::PixelType));
   const unsigned int barSize = GetMorphologicalOpeningBarSizePx();
 
@@ -445,6 +796,12 @@ void PlusFidSegmentation::Erode90(PlusFidSegmentation::PixelType* dest, PlusFidS
 {
   //LOG_TRACE("FidSegmentation::Erode90");
 
+  if (m_UseFastMorphology)
+  {
+    FilterBarAlongColumns<MorphologyMinimum>(dest, image, m_FrameSize, m_RegionOfInterest, GetMorphologicalOpeningBarSizePx(), 0, m_MorphologyBuffer);
+    return;
+  }
+
   memset(dest, 0, m_FrameSize[1]*m_FrameSize[0]*sizeof(PlusFidSegmentation::PixelType));
 
   const unsigned int barSize = GetMorphologicalOpeningBarSizePx();
@@ -501,6 +858,12 @@ void PlusFidSegmentation::Erode135(PlusFidSegmentation::PixelType* dest, PlusFid
 {
   //LOG_TRACE("FidSegmentation::Erode135");
 
+  if (m_UseFastMorphology)
+  {
+    FilterBarAlongColumns<MorphologyMinimum>(dest, image, m_FrameSize, m_RegionOfInterest, GetMorphologicalOpeningBarSizePx(), 1, m_MorphologyBuffer);
+    return;
+  }
+
   memset(dest, 0, m_FrameSize[1]*m_FrameSize[0]*sizeof(PlusFidSegmentation::PixelType));
 
   const unsigned int barSize = GetMorphologicalOpeningBarSizePx();
@@ -556,6 +919,11 @@ void PlusFidSegmentation::ErodeCircle(PlusFidSegmentation::PixelType* dest, Plus
 {
   //LOG_TRACE("FidSegmentation::ErodeCircle");
 
+  if (m_UseFastMorphology && FilterDisk<MorphologyMinimum>(dest, image, m_FrameSize, m_RegionOfInterest, m_MorphologicalCircle, true, m_MorphologyBuffer))
+  {
+    return;
+  }
+
   unsigned int slen = m_MorphologicalCircle.size();
 
   memset(dest, 0, m_FrameSize[1]*m_FrameSize[0]*sizeof(PlusFidSegmentation::PixelType));
@@ -615,6 +983,12 @@ void PlusFidSegmentation::Dilate0(PlusFidSegmentation::PixelType* dest, PlusFidS
 {
   //LOG_TRACE("FidSegmentation::Dilate0");
 
+  if (m_UseFastMorphology)
+  {
+    FilterHorizontalBar<MorphologyMaximum>(dest, image, m_FrameSize, m_RegionOfInterest, GetMorphologicalOpeningBarSizePx(), m_MorphologyBuffer);
+    return;
+  }
+
   memset(dest, 0, m_FrameSize[1]*m_FrameSize[0]*sizeof(PlusFidSegmentation::PixelType));
 
   const unsigned int barSize = GetMorphologicalOpeningBarSizePx();
@@ -677,6 +1051,12 @@ void PlusFidSegmentation::Dilate45(PlusFidSegmentation::PixelType* dest, PlusFid
 {
   //LOG_TRACE("FidSegmentation::Dilate45");
 
+  if (m_UseFastMorphology)
+  {
+    FilterBarAlongColumns<MorphologyMaximum>(dest, image, m_FrameSize, m_RegionOfInterest, GetMorphologicalOpeningBarSizePx(), -1, m_MorphologyBuffer);
+    return;
+  }
+
   memset(dest, 0, m_FrameSize[1]*m_FrameSize[0]*sizeof(PlusFidSegmentation::PixelType));
   const unsigned int barSize = GetMorphologicalOpeningBarSizePx();
 
@@ -748,6 +1128,12 @@ void PlusFidSegmentation::Dilate90(PlusFidSegmentation::PixelType* dest, PlusFid
 {
   //LOG_TRACE("FidSegmentation::Dilate90");
 
+  if (m_UseFastMorphology)
+  {
+    FilterBarAlongColumns<MorphologyMaximum>(dest, image, m_FrameSize, m_RegionOfInterest, GetMorphologicalOpeningBarSizePx(), 0, m_MorphologyBuffer);
+    return;
+  }
+
   memset(dest, 0, m_FrameSize[1]*m_FrameSize[0]*sizeof(PlusFidSegmentation::PixelType));
   const unsigned int barSize = GetMorphologicalOpeningBarSizePx();
 
@@ -798,6 +1184,12 @@ void PlusFidSegmentation::Dilate135(PlusFidSegmentation::PixelType* dest, PlusFi
 {
   //LOG_TRACE("FidSegmentation::Dilate135");
 
+  if (m_UseFastMorphology)
+  {
+    FilterBarAlongColumns<MorphologyMaximum>(dest, image, m_FrameSize, m_RegionOfInterest, GetMorphologicalOpeningBarSizePx(), 1, m_MorphologyBuffer);
+    return;
+  }
+
   memset(dest, 0, m_FrameSize[1]*m_FrameSize[0]*sizeof(PlusFidSegmentation::PixelType));
   const unsigned int barSize = GetMorphologicalOpeningBarSizePx();
 
@@ -868,6 +1260,11 @@ void PlusFidSegmentation::DilateCircle(PlusFidSegmentation::PixelType* dest, Plu
 {
   //LOG_TRACE("FidSegmentation::DilateCircle");
 
+  if (m_UseFastMorphology && FilterDisk<MorphologyMaximum>(dest, image, m_FrameSize, m_RegionOfInterest, m_MorphologicalCircle, false, m_MorphologyBuffer))
+  {
+    return;
+  }
+
   unsigned int slen = m_MorphologicalCircle.size();
 
   PlusCoordinate2D* shape = new PlusCoordinate2D[slen];
@@ -945,6 +1342,7 @@ void PlusFidSegmentation::DilateCircle(PlusFidSegmentation::PixelType* dest, Plu
       last = dest[ir * m_FrameSize[0] + ic] = dval ;
     }
   }
+  delete [] shape;
   delete [] newDots;
   delete [] oldDots;
 }
@@ -1137,11 +1535,20 @@ void PlusFidSegmentation::Subtract(PlusFidSegmentation::PixelType* image, PlusFi
 {
   //LOG_TRACE("FidSegmentation::Subtract");
 
-  for (unsigned int pos = m_FrameSize[1] * m_FrameSize[0]; pos > 0; pos--)
+  const int pixelCount = m_FrameSize[1] * m_FrameSize[0];
+  int pos = 0;
+#ifdef PLUS_SSE2_AVAILABLE
+  // Subtraction with unsigned saturation is 0 where the subtracted value is larger
+  for (; pos + 16 <= pixelCount; pos += 16)
   {
-    *image = *vals > *image ? 0 : *image - *vals;
-    image++;
-    vals++;
+    __m128i imageValues = _mm_loadu_si128(reinterpret_cast<const __m128i*>(image + pos));
+    __m128i subtractedValues = _mm_loadu_si128(reinterpret_cast<const __m128i*>(vals + pos));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(image + pos), _mm_subs_epu8(imageValues, subtractedValues));
+  }
+#endif
+  for (; pos < pixelCount; pos++)
+  {
+    image[pos] = vals[pos] > image[pos] ? 0 : image[pos] - vals[pos];
   }
 }
 
@@ -1155,21 +1562,41 @@ void PlusFidSegmentation::Suppress(PlusFidSegmentation::PixelType* image, double
 {
   LOG_TRACE("FidSegmentation::Suppress");
 
+  const int pixelCount = m_FrameSize[0] * m_FrameSize[1];
+
   // Get the minimum and maximum pixel value
   PlusFidSegmentation::PixelType max = 0;
   PlusFidSegmentation::PixelType min = 255;
-  PlusFidSegmentation::PixelType* pix = image;
-  for (unsigned int pos = 0; pos < m_FrameSize[0]*m_FrameSize[1]; pos ++)
+  int pos = 0;
+#ifdef PLUS_SSE2_AVAILABLE
+  __m128i maxValues = _mm_setzero_si128();
+  __m128i minValues = _mm_set1_epi8(static_cast<char>(0xFF));
+  for (; pos + 16 <= pixelCount; pos += 16)
+  {
+    __m128i values = _mm_loadu_si128(reinterpret_cast<const __m128i*>(image + pos));
+    maxValues = _mm_max_epu8(maxValues, values);
+    minValues = _mm_min_epu8(minValues, values);
+  }
+  PlusFidSegmentation::PixelType maxLanes[16];
+  PlusFidSegmentation::PixelType minLanes[16];
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(maxLanes), maxValues);
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(minLanes), minValues);
+  for (int lane = 0; lane < 16; lane++)
   {
-    if (*pix > max)
+    max = std::max(max, maxLanes[lane]);
+    min = std::min(min, minLanes[lane]);
+  }
+#endif
+  for (; pos < pixelCount; pos++)
+  {
+    if (image[pos] > max)
     {
-      max = *pix;
+      max = image[pos];
     }
-    if (*pix < min)
+    if (image[pos] < min)
     {
-      min = *pix;
+      min = image[pos];
     }
-    pix++;
   }
 
   //We use floor to calculate the round value here.
@@ -1177,15 +1604,23 @@ void PlusFidSegmentation::Suppress(PlusFidSegmentation::PixelType* image, double
   PlusFidSegmentation::PixelType thresh = min + (PlusFidSegmentation::PixelType)floor((double)(max - min) * percent_thresh + 0.5);
 
   //thresholding
-  int pixelCount = m_FrameSize[0] * m_FrameSize[1];
-  PlusFidSegmentation::PixelType* pixel = image;
-  for (int i = 0; i < pixelCount; i++)
+  pos = 0;
+#ifdef PLUS_SSE2_AVAILABLE
+  // Pixels below the threshold are cleared by masking (BLACK is 0)
+  __m128i threshValues = _mm_set1_epi8(static_cast<char>(thresh));
+  for (; pos + 16 <= pixelCount; pos += 16)
+  {
+    __m128i values = _mm_loadu_si128(reinterpret_cast<const __m128i*>(image + pos));
+    __m128i aboveThreshMask = _mm_cmpeq_epi8(_mm_max_epu8(values, threshValues), values);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(image + pos), _mm_and_si128(values, aboveThreshMask));
+  }
+#endif
+  for (; pos < pixelCount; pos++)
   {
-    if (*pixel < thresh)
+    if (image[pos] < thresh)
     {
-      *pixel = BLACK;
+      image[pos] = BLACK;
     }
-    pixel++;
   }
 
   if (m_DebugOutput)
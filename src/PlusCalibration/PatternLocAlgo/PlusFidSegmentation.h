@@ -54,8 +54,12 @@ public:
   };
 
   PlusFidSegmentation();
+  /*! Copy the parameters and the working images (e.g., for processing frames in multiple threads) */
+  PlusFidSegmentation(const PlusFidSegmentation& other);
   virtual ~PlusFidSegmentation();
 
+  PlusFidSegmentation& operator=(const PlusFidSegmentation& other);
+
   /* Read the configuration file */
   PlusStatus ReadConfiguration( vtkXMLDataElement* rootConfigElement );
 
@@ -200,6 +204,14 @@ public:
   /*! Set to true to use the original image intensity for the dots intensity values */
   void  SetUseOriginalImageIntensityForDotIntensityScore( bool value ) { m_UseOriginalImageIntensityForDotIntensityScore = value; };
 
+  /*!
+    If true (default) then erosion and dilation compute running minimum/maximum values (van Herk/Gil-Werman algorithm for the bars,
+    decomposition to horizontal chords for the circle) using vectorized row operations. If false then the structuring element
+    is evaluated at each pixel. The resulting images are identical.
+  */
+  void  SetUseFastMorphology( bool value ) { m_UseFastMorphology = value; };
+  bool  GetUseFastMorphology() { return m_UseFastMorphology; };
+
 protected:
   unsigned int m_FrameSize[2];
   unsigned int m_RegionOfInterest[4]; // xmin, ymin; xmax, ymax
@@ -245,6 +257,12 @@ protected:
   std::vector<PlusFidDot> m_DotsVector;
 
   bool m_DebugOutput;
+
+  /*! Use running minimum/maximum computation for the morphological operations */
+  bool m_UseFastMorphology;
+
+  /*! Temporary buffer of the fast morphological operations */
+  std::vector<PlusFidSegmentation::PixelType> m_MorphologyBuffer;
 };
 
 #endif // _FIDUCIAL_SEGMENTATION_H
@@ -0,0 +1,167 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+See License.txt for details.
+=========================================================Plus=header=end*/
+
+/*!
+  \file PlusFidLineFinderTest.cxx
+  \brief Segments all frames of a sequence, adds random noise dots to the found dots and finds the lines
+  with the fast (spatially indexed) and the reference (exhaustive) candidate search. Verifies that the
+  found lines are identical and reports the average and worst-case computation time per frame.
+*/
+
+#include "PlusConfigure.h"
+
+#include "PlusFidLineFinder.h"
+#include "PlusFidPatternRecognition.h"
+#include "PlusFidPatternRecognitionTestUtilities.h"
+#include "PlusFidSegmentation.h"
+#include "PlusTrackedFrame.h"
+#include "vtkPlusTrackedFrameList.h"
+#include "vtkSmartPointer.h"
+#include "vtksys/CommandLineArguments.hxx"
+
+#include <sstream>
+
+using namespace PlusFidPatternRecognitionTestUtilities;
+
+namespace
+{
+  // Returns the computation time in seconds
+  double FindLines(PlusFidLineFinder& lineFinder, PlusTrackedFrame* trackedFrame, const std::vector<PlusFidDot>& dots)
+  {
+    lineFinder.Clear();
+    lineFinder.SetFrameSize(trackedFrame->GetFrameSize());
+    lineFinder.SetCandidateFidValues(dots);
+    lineFinder.SetDotsVector(dots);
+
+    double startTimeSec = vtkPlusAccurateTimer::GetSystemTime();
+    lineFinder.FindLines();
+    return vtkPlusAccurateTimer::GetSystemTime() - startTimeSec;
+  }
+
+  // Returns the number of lines that are different in the two line vectors
+  int CompareLines(std::vector<std::vector<PlusFidLine> >& referenceLinesVector, std::vector<std::vector<PlusFidLine> >& linesVector)
+  {
+    if (referenceLinesVector.size() != linesVector.size())
+    {
+      LOG_ERROR("Number of line vectors differ: " << linesVector.size() << " (reference: " << referenceLinesVector.size() << ")");
+      return 1;
+    }
+    int numberOfDifferentLines = 0;
+    for (unsigned int numberOfPoints = 0; numberOfPoints < referenceLinesVector.size(); numberOfPoints++)
+    {
+      std::vector<PlusFidLine>& referenceLines = referenceLinesVector[numberOfPoints];
+      std::vector<PlusFidLine>& lines = linesVector[numberOfPoints];
+      if (referenceLines.size() != lines.size())
+      {
+        LOG_ERROR("Number of " << numberOfPoints << "-point lines differ: " << lines.size() << " (reference: " << referenceLines.size() << ")");
+        numberOfDifferentLines++;
+        continue;
+      }
+      for (unsigned int lineIndex = 0; lineIndex < referenceLines.size(); lineIndex++)
+      {
+        bool identical = (referenceLines[lineIndex].GetNumberOfPoints() == lines[lineIndex].GetNumberOfPoints()
+                          && referenceLines[lineIndex].GetStartPointIndex() == lines[lineIndex].GetStartPointIndex()
+                          && referenceLines[lineIndex].GetEndPointIndex() == lines[lineIndex].GetEndPointIndex()
+                          && referenceLines[lineIndex].GetIntensity() == lines[lineIndex].GetIntensity());
+        for (unsigned int pointIndex = 0; identical && pointIndex < referenceLines[lineIndex].GetNumberOfPoints(); pointIndex++)
+        {
+          identical = (referenceLines[lineIndex].GetPoint(pointIndex) == lines[lineIndex].GetPoint(pointIndex));
+        }
+        if (!identical)
+        {
+          numberOfDifferentLines++;
+        }
+      }
+    }
+    return numberOfDifferentLines;
+  }
+}
+
+//-----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  int numberOfNoiseDots = 60;
+
+  vtksys::CommandLineArguments args;
+  args.Initialize(argc, argv);
+  args.AddArgument("--noise-dots", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &numberOfNoiseDots, "Number of random dots that are added to the segmented dots of each frame (default: 60)");
+
+  PlusFidPatternRecognition patternRecognition;
+  vtkSmartPointer<vtkPlusTrackedFrameList> trackedFrameList = vtkSmartPointer<vtkPlusTrackedFrameList>::New();
+  if (ParseArgumentsAndReadInput(args, patternRecognition, trackedFrameList) != PLUS_SUCCESS)
+  {
+    return EXIT_FAILURE;
+  }
+
+  PlusFidSegmentation segmentation(*patternRecognition.GetFidSegmentation());
+  PlusFidLineFinder referenceLineFinder(*patternRecognition.GetFidLineFinder());
+  referenceLineFinder.SetUseFastLineFinding(false);
+  PlusFidLineFinder fastLineFinder(*patternRecognition.GetFidLineFinder());
+  fastLineFinder.SetUseFastLineFinding(true);
+
+  srand(0);
+  int numberOfFailures = 0;
+  double referenceTimeSec = 0;
+  double referenceMaxTimeSec = 0;
+  double fastTimeSec = 0;
+  double fastMaxTimeSec = 0;
+  for (unsigned int frameIndex = 0; frameIndex < trackedFrameList->GetNumberOfTrackedFrames(); frameIndex++)
+  {
+    PlusTrackedFrame* trackedFrame = trackedFrameList->GetTrackedFrame(frameIndex);
+
+    // Segment the frame
+    SetSegmentationImage(segmentation, trackedFrame);
+    segmentation.MorphologicalOperations();
+    segmentation.Suppress(segmentation.GetWorking(), segmentation.GetThresholdImagePercent() / 100.00);
+    bool tooManyCandidates = false;
+    segmentation.Cluster(tooManyCandidates);
+
+    // Add noise dots at random positions, with intensities in the range of the segmented dots
+    std::vector<PlusFidDot> dots = segmentation.GetDotsVector();
+    double maxDotIntensity = 1.0;
+    for (std::vector<PlusFidDot>::iterator dotIt = dots.begin(); dotIt != dots.end(); ++dotIt)
+    {
+      maxDotIntensity = std::max(maxDotIntensity, dotIt->GetDotIntensity());
+    }
+    for (int noiseDotIndex = 0; noiseDotIndex < numberOfNoiseDots; noiseDotIndex++)
+    {
+      PlusFidDot noiseDot;
+      noiseDot.SetX(trackedFrame->GetFrameSize()[0] * (double)rand() / RAND_MAX);
+      noiseDot.SetY(trackedFrame->GetFrameSize()[1] * (double)rand() / RAND_MAX);
+      noiseDot.SetDotIntensity(maxDotIntensity * (double)rand() / RAND_MAX);
+      dots.push_back(noiseDot);
+    }
+
+    double referenceFrameTimeSec = FindLines(referenceLineFinder, trackedFrame, dots);
+    referenceTimeSec += referenceFrameTimeSec;
+    referenceMaxTimeSec = std::max(referenceMaxTimeSec, referenceFrameTimeSec);
+    double fastFrameTimeSec = FindLines(fastLineFinder, trackedFrame, dots);
+    fastTimeSec += fastFrameTimeSec;
+    fastMaxTimeSec = std::max(fastMaxTimeSec, fastFrameTimeSec);
+
+    int numberOfDifferentLines = CompareLines(referenceLineFinder.GetLinesVector(), fastLineFinder.GetLinesVector());
+    if (numberOfDifferentLines > 0)
+    {
+      LOG_ERROR("Fast line finding result of frame " << frameIndex << " (" << dots.size() << " dots) differs from the reference result in " << numberOfDifferentLines << " lines");
+      numberOfFailures++;
+    }
+  }
+
+  unsigned int numberOfFrames = trackedFrameList->GetNumberOfTrackedFrames();
+  std::ostringstream operationName;
+  operationName << "Line finding (with " << numberOfNoiseDots << " noise dots per frame)";
+  LogComputationTimes(operationName.str(), numberOfFrames, referenceTimeSec, fastTimeSec);
+  LOG_INFO("Worst-case time per frame, reference: " << referenceMaxTimeSec * 1000.0 << " ms, fast: " << fastMaxTimeSec * 1000.0 << " ms");
+
+  if (numberOfFailures > 0)
+  {
+    LOG_ERROR("Test failed, number of frames with differences: " << numberOfFailures);
+    return EXIT_FAILURE;
+  }
+
+  LOG_INFO("Test completed successfully");
+  return EXIT_SUCCESS;
+}
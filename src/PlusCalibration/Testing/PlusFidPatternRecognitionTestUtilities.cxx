@@ -0,0 +1,104 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+See License.txt for details.
+=========================================================Plus=header=end*/
+
+#include "PlusConfigure.h"
+#include "PlusFidPatternRecognitionTestUtilities.h"
+
+#include "PlusFidPatternRecognition.h"
+#include "PlusTrackedFrame.h"
+#include "vtkPlusSequenceIO.h"
+#include "vtkPlusTrackedFrameList.h"
+#include "vtkSmartPointer.h"
+#include "vtkXMLDataElement.h"
+
+//-----------------------------------------------------------------------------
+PlusStatus PlusFidPatternRecognitionTestUtilities::ParseArgumentsAndReadInput(vtksys::CommandLineArguments& args, PlusFidPatternRecognition& patternRecognition, vtkPlusTrackedFrameList* trackedFrameList)
+{
+  bool printHelp = false;
+  std::string inputImageSequenceFileName;
+  std::string inputTestDataDir;
+  std::string inputConfigFileName;
+  int verboseLevel = vtkPlusLogger::LOG_LEVEL_UNDEFINED;
+
+  args.AddArgument("--help", vtksys::CommandLineArguments::NO_ARGUMENT, &printHelp, "Print this help.");
+  args.AddArgument("--test-data-dir", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &inputTestDataDir, "Test data directory");
+  args.AddArgument("--img-seq-file", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &inputImageSequenceFileName, "Filename of the input image sequence. All frames of the sequence are processed.");
+  args.AddArgument("--config-file", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &inputConfigFileName, "Calibration configuration file name");
+  args.AddArgument("--verbose", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &verboseLevel, "Verbose level (1=error only, 2=warning, 3=info, 4=debug, 5=trace)");
+
+  if (!args.Parse())
+  {
+    std::cerr << "Problem parsing arguments" << std::endl;
+    std::cout << "Help: " << args.GetHelp() << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  if (printHelp)
+  {
+    std::cout << args.GetHelp() << std::endl;
+    exit(EXIT_SUCCESS);
+  }
+
+  vtkPlusLogger::Instance()->SetLogLevel(verboseLevel);
+
+  if (inputImageSequenceFileName.empty() || inputConfigFileName.empty())
+  {
+    std::cerr << "At least one of the following parameters is missing: --img-seq-file, --config-file" << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  // Read configuration
+  vtkSmartPointer<vtkXMLDataElement> configRootElement = vtkSmartPointer<vtkXMLDataElement>::New();
+  if (PlusXmlUtils::ReadDeviceSetConfigurationFromFile(configRootElement, inputConfigFileName.c_str()) == PLUS_FAIL)
+  {
+    LOG_ERROR("Unable to read configuration from file " << inputConfigFileName.c_str());
+    return PLUS_FAIL;
+  }
+  if (patternRecognition.ReadConfiguration(configRootElement) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Unable to read pattern recognition configuration from file " << inputConfigFileName.c_str());
+    return PLUS_FAIL;
+  }
+
+  // Read frames
+  std::string inputImageSequencePath = inputTestDataDir + "/" + inputImageSequenceFileName;
+  if (vtkPlusSequenceIO::Read(inputImageSequencePath, trackedFrameList) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Failed to read sequence metafile: " << inputImageSequencePath);
+    return PLUS_FAIL;
+  }
+  for (unsigned int frameIndex = 0; frameIndex < trackedFrameList->GetNumberOfTrackedFrames(); frameIndex++)
+  {
+    if (trackedFrameList->GetTrackedFrame(frameIndex)->GetImageData()->GetVTKScalarPixelType() != VTK_UNSIGNED_CHAR)
+    {
+      LOG_ERROR("Frame " << frameIndex << " is not an 8-bit image");
+      return PLUS_FAIL;
+    }
+  }
+
+  return PLUS_SUCCESS;
+}
+
+//-----------------------------------------------------------------------------
+void PlusFidPatternRecognitionTestUtilities::SetSegmentationImage(PlusFidSegmentation& segmentation, PlusTrackedFrame* trackedFrame)
+{
+  segmentation.Clear();
+  segmentation.SetFrameSize(trackedFrame->GetFrameSize());
+  int bytes = trackedFrame->GetFrameSize()[0] * trackedFrame->GetFrameSize()[1] * sizeof(PlusFidSegmentation::PixelType);
+  memcpy(segmentation.GetWorking(), trackedFrame->GetImageData()->GetScalarPointer(), bytes);
+  memcpy(segmentation.GetUnalteredImage(), trackedFrame->GetImageData()->GetScalarPointer(), bytes);
+}
+
+//-----------------------------------------------------------------------------
+void PlusFidPatternRecognitionTestUtilities::LogComputationTimes(const std::string& operationName, unsigned int numberOfFrames, double referenceTimeSec, double fastTimeSec)
+{
+  LOG_INFO(operationName << " of " << numberOfFrames << " frames, reference: " << referenceTimeSec << " sec, fast: " << fastTimeSec
+           << " sec, speedup: " << (fastTimeSec > 0 ? referenceTimeSec / fastTimeSec : 0) << "x");
+  if (numberOfFrames > 0)
+  {
+    LOG_INFO("Average time per frame, reference: " << referenceTimeSec * 1000.0 / numberOfFrames << " ms, fast: " << fastTimeSec * 1000.0 / numberOfFrames << " ms");
+  }
+}
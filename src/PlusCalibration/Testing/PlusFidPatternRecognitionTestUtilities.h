@@ -0,0 +1,43 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+See License.txt for details.
+=========================================================Plus=header=end*/
+
+/*!
+  \file PlusFidPatternRecognitionTestUtilities.h
+  \brief Loading of the configuration and the input sequence and reporting of computation times, shared between
+  the fiducial pattern recognition tests.
+*/
+
+#ifndef __PlusFidPatternRecognitionTestUtilities_h
+#define __PlusFidPatternRecognitionTestUtilities_h
+
+#include "PlusFidSegmentation.h"
+#include "vtksys/CommandLineArguments.hxx"
+
+#include <string>
+
+class PlusFidPatternRecognition;
+class PlusTrackedFrame;
+class vtkPlusTrackedFrameList;
+
+namespace PlusFidPatternRecognitionTestUtilities
+{
+  /*!
+    Add the --help, --verbose, --test-data-dir, --img-seq-file, and --config-file arguments to the test-specific arguments,
+    parse the command line, and set the log level. Exits the process if the help is requested or the arguments are invalid.
+    Then read the pattern recognition configuration from the configuration file and the frames from the image sequence file.
+    args must be initialized with the command line before calling this function.
+    Returns PLUS_FAIL if the configuration or the sequence cannot be read or the frames are not 8-bit images.
+  */
+  PlusStatus ParseArgumentsAndReadInput(vtksys::CommandLineArguments& args, PlusFidPatternRecognition& patternRecognition, vtkPlusTrackedFrameList* trackedFrameList);
+
+  /*! Copy the image of the tracked frame to the working and unaltered images of the segmentation */
+  void SetSegmentationImage(PlusFidSegmentation& segmentation, PlusTrackedFrame* trackedFrame);
+
+  /*! Log the total and average per frame computation time of the reference and the fast implementation and the speedup */
+  void LogComputationTimes(const std::string& operationName, unsigned int numberOfFrames, double referenceTimeSec, double fastTimeSec);
+}
+
+#endif
@@ -0,0 +1,139 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+See License.txt for details.
+=========================================================Plus=header=end*/
+
+/*!
+  \file PlusFidPatternRecognitionThreadingTest.cxx
+  \brief Runs pattern recognition on a tracked frame list with 1..N threads, reports the computation times
+  and verifies that the results are identical to the single-threaded results.
+*/
+
+#include "PlusConfigure.h"
+
+#include "PlusFidPatternRecognition.h"
+#include "PlusFidPatternRecognitionTestUtilities.h"
+#include "PlusTrackedFrame.h"
+#include "vtkPlusTrackedFrameList.h"
+#include "vtkPoints.h"
+#include "vtkSmartPointer.h"
+#include "vtksys/CommandLineArguments.hxx"
+
+#include <sstream>
+#include <vector>
+
+using namespace PlusFidPatternRecognitionTestUtilities;
+
+namespace
+{
+  struct SegmentationRunResult
+  {
+    int NumberOfSegmentedImages;
+    std::vector<unsigned int> SegmentedFramesIndices;
+    std::vector< std::vector<double> > FiducialCoordinates;
+    /*! Found dots that are kept in the labeling component of the pattern recognition after the last frame */
+    std::vector< std::vector<double> > LastFrameFoundDots;
+    double ComputationTimeSec;
+  };
+
+  PlusStatus RunSegmentation(PlusFidPatternRecognition& patternRecognition, vtkPlusTrackedFrameList* trackedFrameList, int numberOfThreads, SegmentationRunResult& result)
+  {
+    // Remove results of the previous run, as only non-segmented frames are processed
+    for (unsigned int frameIndex = 0; frameIndex < trackedFrameList->GetNumberOfTrackedFrames(); frameIndex++)
+    {
+      trackedFrameList->GetTrackedFrame(frameIndex)->SetFiducialPointsCoordinatePx(NULL);
+    }
+
+    patternRecognition.SetNumberOfThreads(numberOfThreads);
+    PlusFidPatternRecognition::PatternRecognitionError error;
+    result.NumberOfSegmentedImages = 0;
+    result.SegmentedFramesIndices.clear();
+    double startTimeSec = vtkPlusAccurateTimer::GetSystemTime();
+    PlusStatus status = patternRecognition.RecognizePattern(trackedFrameList, error, &result.NumberOfSegmentedImages, &result.SegmentedFramesIndices);
+    result.ComputationTimeSec = vtkPlusAccurateTimer::GetSystemTime() - startTimeSec;
+
+    result.FiducialCoordinates.clear();
+    for (unsigned int frameIndex = 0; frameIndex < trackedFrameList->GetNumberOfTrackedFrames(); frameIndex++)
+    {
+      std::vector<double> frameCoordinates;
+      vtkPoints* fiducials = trackedFrameList->GetTrackedFrame(frameIndex)->GetFiducialPointsCoordinatePx();
+      for (vtkIdType pointIndex = 0; fiducials != NULL && pointIndex < fiducials->GetNumberOfPoints(); pointIndex++)
+      {
+        double* point = fiducials->GetPoint(pointIndex);
+        frameCoordinates.push_back(point[0]);
+        frameCoordinates.push_back(point[1]);
+      }
+      result.FiducialCoordinates.push_back(frameCoordinates);
+    }
+    result.LastFrameFoundDots = patternRecognition.GetFidLabeling()->GetFoundDotsCoordinateValue();
+    return status;
+  }
+}
+
+//-----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  int maxNumberOfThreads = 4;
+
+  vtksys::CommandLineArguments args;
+  args.Initialize(argc, argv);
+  args.AddArgument("--max-number-of-threads", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &maxNumberOfThreads, "Segmentation is performed with 1, 2, ..., max-number-of-threads threads (default: 4)");
+
+  PlusFidPatternRecognition patternRecognition;
+  vtkSmartPointer<vtkPlusTrackedFrameList> trackedFrameList = vtkSmartPointer<vtkPlusTrackedFrameList>::New();
+  if (ParseArgumentsAndReadInput(args, patternRecognition, trackedFrameList) != PLUS_SUCCESS)
+  {
+    return EXIT_FAILURE;
+  }
+
+  SegmentationRunResult referenceResult;
+  PlusStatus referenceStatus = RunSegmentation(patternRecognition, trackedFrameList, 1, referenceResult);
+  LOG_INFO("Reference: segmentation with 1 thread, " << referenceResult.NumberOfSegmentedImages << " of " << trackedFrameList->GetNumberOfTrackedFrames()
+           << " frames segmented successfully");
+
+  int numberOfFailures = 0;
+  for (int numberOfThreads = 2; numberOfThreads <= maxNumberOfThreads; numberOfThreads++)
+  {
+    SegmentationRunResult result;
+    PlusStatus status = RunSegmentation(patternRecognition, trackedFrameList, numberOfThreads, result);
+    std::ostringstream operationName;
+    operationName << "Segmentation with " << numberOfThreads << " threads";
+    LogComputationTimes(operationName.str(), trackedFrameList->GetNumberOfTrackedFrames(), referenceResult.ComputationTimeSec, result.ComputationTimeSec);
+
+    if (status != referenceStatus)
+    {
+      LOG_ERROR("Segmentation status with " << numberOfThreads << " threads differs from the single-threaded status");
+      numberOfFailures++;
+    }
+    if (result.NumberOfSegmentedImages != referenceResult.NumberOfSegmentedImages
+        || result.SegmentedFramesIndices != referenceResult.SegmentedFramesIndices)
+    {
+      LOG_ERROR("Segmented frames with " << numberOfThreads << " threads differ from the single-threaded results: "
+                << result.NumberOfSegmentedImages << " frames segmented, expected " << referenceResult.NumberOfSegmentedImages);
+      numberOfFailures++;
+    }
+    for (unsigned int frameIndex = 0; frameIndex < result.FiducialCoordinates.size(); frameIndex++)
+    {
+      if (result.FiducialCoordinates[frameIndex] != referenceResult.FiducialCoordinates[frameIndex])
+      {
+        LOG_ERROR("Fiducial positions of frame " << frameIndex << " with " << numberOfThreads << " threads differ from the single-threaded results");
+        numberOfFailures++;
+      }
+    }
+    if (result.LastFrameFoundDots != referenceResult.LastFrameFoundDots)
+    {
+      LOG_ERROR("Labeling component state after segmentation with " << numberOfThreads << " threads differs from the single-threaded state");
+      numberOfFailures++;
+    }
+  }
+
+  if (numberOfFailures > 0)
+  {
+    LOG_ERROR("Test failed, number of differences: " << numberOfFailures);
+    return EXIT_FAILURE;
+  }
+
+  LOG_INFO("Test completed successfully");
+  return EXIT_SUCCESS;
+}
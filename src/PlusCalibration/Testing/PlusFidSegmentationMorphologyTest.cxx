@@ -0,0 +1,93 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+See License.txt for details.
+=========================================================Plus=header=end*/
+
+/*!
+  \file PlusFidSegmentationMorphologyTest.cxx
+  \brief Performs the morphological operations and thresholding of fiducial segmentation on all frames of a sequence
+  with the fast and the reference (per-pixel) implementation, reports the computation times
+  and verifies that the resulting images are identical.
+*/
+
+#include "PlusConfigure.h"
+
+#include "PlusFidPatternRecognition.h"
+#include "PlusFidPatternRecognitionTestUtilities.h"
+#include "PlusFidSegmentation.h"
+#include "PlusTrackedFrame.h"
+#include "vtkPlusTrackedFrameList.h"
+#include "vtkSmartPointer.h"
+#include "vtksys/CommandLineArguments.hxx"
+
+using namespace PlusFidPatternRecognitionTestUtilities;
+
+namespace
+{
+  // Returns the computation time in seconds
+  double SegmentFrame(PlusFidSegmentation& segmentation, PlusTrackedFrame* trackedFrame)
+  {
+    SetSegmentationImage(segmentation, trackedFrame);
+
+    double startTimeSec = vtkPlusAccurateTimer::GetSystemTime();
+    segmentation.MorphologicalOperations();
+    segmentation.Suppress(segmentation.GetWorking(), segmentation.GetThresholdImagePercent() / 100.00);
+    return vtkPlusAccurateTimer::GetSystemTime() - startTimeSec;
+  }
+}
+
+//-----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  vtksys::CommandLineArguments args;
+  args.Initialize(argc, argv);
+
+  PlusFidPatternRecognition patternRecognition;
+  vtkSmartPointer<vtkPlusTrackedFrameList> trackedFrameList = vtkSmartPointer<vtkPlusTrackedFrameList>::New();
+  if (ParseArgumentsAndReadInput(args, patternRecognition, trackedFrameList) != PLUS_SUCCESS)
+  {
+    return EXIT_FAILURE;
+  }
+
+  PlusFidSegmentation referenceSegmentation(*patternRecognition.GetFidSegmentation());
+  referenceSegmentation.SetUseFastMorphology(false);
+  PlusFidSegmentation fastSegmentation(*patternRecognition.GetFidSegmentation());
+  fastSegmentation.SetUseFastMorphology(true);
+
+  int numberOfFailures = 0;
+  double referenceTimeSec = 0;
+  double fastTimeSec = 0;
+  for (unsigned int frameIndex = 0; frameIndex < trackedFrameList->GetNumberOfTrackedFrames(); frameIndex++)
+  {
+    PlusTrackedFrame* trackedFrame = trackedFrameList->GetTrackedFrame(frameIndex);
+    referenceTimeSec += SegmentFrame(referenceSegmentation, trackedFrame);
+    fastTimeSec += SegmentFrame(fastSegmentation, trackedFrame);
+
+    int pixelCount = trackedFrame->GetFrameSize()[0] * trackedFrame->GetFrameSize()[1];
+    int numberOfDifferentPixels = 0;
+    for (int pixelIndex = 0; pixelIndex < pixelCount; pixelIndex++)
+    {
+      if (referenceSegmentation.GetWorking()[pixelIndex] != fastSegmentation.GetWorking()[pixelIndex])
+      {
+        numberOfDifferentPixels++;
+      }
+    }
+    if (numberOfDifferentPixels > 0)
+    {
+      LOG_ERROR("Fast morphological operations result of frame " << frameIndex << " differs from the reference result in " << numberOfDifferentPixels << " pixels");
+      numberOfFailures++;
+    }
+  }
+
+  LogComputationTimes("Morphological operations", trackedFrameList->GetNumberOfTrackedFrames(), referenceTimeSec, fastTimeSec);
+
+  if (numberOfFailures > 0)
+  {
+    LOG_ERROR("Test failed, number of frames with differences: " << numberOfFailures);
+    return EXIT_FAILURE;
+  }
+
+  LOG_INFO("Test completed successfully");
+  return EXIT_SUCCESS;
+}
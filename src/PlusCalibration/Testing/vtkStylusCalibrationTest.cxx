@@ -14,6 +14,7 @@
 #include "PlusMath.h"
 #include "PlusTrackedFrame.h"
 #include "vtkPlusDataCollector.h"
+#include "vtkMath.h"
 #include "vtkMatrix4x4.h"
 #include "vtkMinimalStandardRandomSequence.h"
 #include "vtkPlusPivotCalibrationAlgo.h"
@@ -218,6 +219,24 @@ int main (int argc, char* argv[])
   LOG_INFO("Number of detected outliers: "<<pivotCalibration->GetNumberOfDetectedOutliers());
   LOG_INFO("Mean calibration error: "<<pivotCalibration->GetCalibrationError()<<" mm");
 
+  // The incremental estimate must match the batch calibration result
+  double incrementalPivotPoint_Marker[3] = {0, 0, 0};
+  double incrementalPivotPoint_Reference[3] = {0, 0, 0};
+  if (pivotCalibration->GetIncrementalPivotPointPosition(incrementalPivotPoint_Marker, incrementalPivotPoint_Reference) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Incremental calibration error!");
+    exit(EXIT_FAILURE);
+  }
+  LOG_INFO("Incremental calibration error: "<<pivotCalibration->GetIncrementalCalibrationError()<<" mm (converged: "<<(pivotCalibration->GetIncrementalCalibrationConverged()?"yes":"no")<<")");
+  vtkMatrix4x4* pivotPointToMarkerMatrix = pivotCalibration->GetPivotPointToMarkerTransformMatrix();
+  double batchPivotPoint_Marker[3] = {pivotPointToMarkerMatrix->GetElement(0,3), pivotPointToMarkerMatrix->GetElement(1,3), pivotPointToMarkerMatrix->GetElement(2,3)};
+  double incrementalPosDiff = sqrt(vtkMath::Distance2BetweenPoints(incrementalPivotPoint_Marker, batchPivotPoint_Marker));
+  if (incrementalPosDiff > TRANSLATION_ERROR_THRESHOLD)
+  {
+    LOG_ERROR("Incremental calibration result mismatch: translation difference is "<<incrementalPosDiff<<", maximum allowed is "<<TRANSLATION_ERROR_THRESHOLD);
+    exit(EXIT_FAILURE);
+  }
+
   // Save result
   if (transformRepository->WriteConfiguration(configRootElement) != PLUS_SUCCESS )
   {
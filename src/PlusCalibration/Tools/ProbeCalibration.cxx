@@ -7,7 +7,8 @@ See License.txt for details.
 /*!
 \file ProbeCalibration.cxx
 \brief This test runs a freehand calibration on a recorded data set and
-compares the results to a baseline
+compares the results to a baseline. The incremental estimate, which is computed
+from the same frames during the calibration, is compared to the linear least squares result.
 */
 
 #include "PlusConfigure.h"
@@ -39,6 +40,7 @@ const double ERROR_THRESHOLD = 0.05;
 #endif
 
 int CompareCalibrationResultsWithBaseline(const char* baselineFileName, const char* currentResultFileName, double translationErrorThreshold, double rotationErrorThreshold);
+int CompareIncrementalCalibrationResultWithLinearLeastSquares(vtkPlusProbeCalibrationAlgo* freehandCalibration, double translationErrorThreshold, double rotationErrorThreshold);
 
 int main(int argc, char* argv[])
 {
@@ -58,6 +60,8 @@ int main(int argc, char* argv[])
   double inputTranslationErrorThreshold(1e-10);
   double inputRotationErrorThreshold(1e-10);
 #endif
+  double inputIncrementalTranslationErrorThreshold(1.0);
+  double inputIncrementalRotationErrorThreshold(1.0);
 
   int verboseLevel = vtkPlusLogger::LOG_LEVEL_UNDEFINED;
 
@@ -74,6 +78,8 @@ int main(int argc, char* argv[])
 
   args.AddArgument("--translation-error-threshold", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &inputTranslationErrorThreshold, "Translation error threshold in mm. Used for baseline comparison.");
   args.AddArgument("--rotation-error-threshold", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &inputRotationErrorThreshold, "Rotation error threshold in degrees. Used for baseline comparison.");
+  args.AddArgument("--incremental-translation-error-threshold", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &inputIncrementalTranslationErrorThreshold, "Maximum translation difference in mm between the incremental and the linear least squares calibration result.");
+  args.AddArgument("--incremental-rotation-error-threshold", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &inputIncrementalRotationErrorThreshold, "Maximum rotation difference in degrees between the incremental and the linear least squares calibration result.");
 
   args.AddArgument("--output-config-file", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &resultConfigFileName, "Result configuration file name. Optional.");
 
@@ -180,6 +186,12 @@ int main(int argc, char* argv[])
     }
   }
 
+  if (CompareIncrementalCalibrationResultWithLinearLeastSquares(freehandCalibration, inputIncrementalTranslationErrorThreshold, inputIncrementalRotationErrorThreshold) != 0)
+  {
+    LOG_ERROR("Comparison of incremental calibration result to linear least squares result failed");
+    return EXIT_FAILURE;
+  }
+
   // Save result to configuration file
   if (!resultConfigFileName.empty())
   {
@@ -1009,3 +1021,37 @@ int CompareCalibrationResultsWithBaseline(const char* baselineFileName, const ch
 
   return numberOfFailures;
 }
+
+//-------------------------------------------------------------------------------------------------
+// return the number of differences
+int CompareIncrementalCalibrationResultWithLinearLeastSquares(vtkPlusProbeCalibrationAlgo* freehandCalibration, double translationErrorThreshold, double rotationErrorThreshold)
+{
+  int numberOfFailures = 0;
+
+  vtkSmartPointer<vtkMatrix4x4> incrementalTransMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+  if (freehandCalibration->GetIncrementalImageToProbeTransformMatrix(incrementalTransMatrix) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Incremental calibration result is not available");
+    return ++numberOfFailures;
+  }
+  vtkSmartPointer<vtkMatrix4x4> linearLeastSquaresTransMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+  freehandCalibration->GetLinearLeastSquaresImageToProbeTransformMatrix(linearLeastSquaresTransMatrix);
+
+  LOG_INFO("Incremental calibration error: " << freehandCalibration->GetIncrementalCalibrationError() << " mm, converged: " << (freehandCalibration->GetIncrementalCalibrationConverged() ? "yes" : "no"));
+
+  double translationError = PlusMath::GetPositionDifference(linearLeastSquaresTransMatrix, incrementalTransMatrix);
+  if (translationError > translationErrorThreshold)
+  {
+    LOG_ERROR("TransformImageToProbe translation difference (incremental compared to linear least squares) is higher than expected: " << translationError << " mm (threshold: " << translationErrorThreshold << " mm). ");
+    numberOfFailures++;
+  }
+
+  double rotationError = PlusMath::GetOrientationDifference(linearLeastSquaresTransMatrix, incrementalTransMatrix);
+  if (rotationError > rotationErrorThreshold)
+  {
+    LOG_ERROR("TransformImageToProbe rotation difference (incremental compared to linear least squares) is higher than expected: " << rotationError << " degree (threshold: " << rotationErrorThreshold << " degree). ");
+    numberOfFailures++;
+  }
+
+  return numberOfFailures;
+}
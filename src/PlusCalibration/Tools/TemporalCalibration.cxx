@@ -193,6 +193,9 @@ int main(int argc, char** argv)
   std::vector<int> clipRectOrigin;
   std::vector<int> clipRectSize;
   std::string inputBaselineFileName;
+  std::string correlationEngineStr("BRUTE_FORCE");
+  bool compareCorrelationEngines(false);
+  double maxCorrelationEngineLagDifferenceSec = MAX_ALLOWED_TIME_LAG_DIFF_SEC;
 
   vtksys::CommandLineArguments args;
   args.Initialize(argc, argv);
@@ -211,6 +214,9 @@ int main(int argc, char** argv)
   args.AddArgument("--clip-rect-origin", vtksys::CommandLineArguments::MULTI_ARGUMENT, &clipRectOrigin, "Origin of the clipping rectangle");
   args.AddArgument("--clip-rect-size", vtksys::CommandLineArguments::MULTI_ARGUMENT, &clipRectSize, "Size of the clipping rectangle");
   args.AddArgument("--baseline-file", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &inputBaselineFileName, "Input xml baseline file name with path");
+  args.AddArgument("--correlation-engine", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &correlationEngineStr, "Method for computing the alignment metric for all time offsets: BRUTE_FORCE or FFT (default: BRUTE_FORCE)");
+  args.AddArgument("--compare-correlation-engines", vtksys::CommandLineArguments::NO_ARGUMENT, &compareCorrelationEngines, "Compute the time offset with the other correlation engine as well, report the difference in computation time and fail if the time offsets differ by more than max-correlation-engine-lag-difference-sec");
+  args.AddArgument("--max-correlation-engine-lag-difference-sec", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &maxCorrelationEngineLagDifferenceSec, "Maximum allowed tracker lag difference between the correlation engines, in seconds (default: 0.005)");
 
   if (!args.Parse())
   {
@@ -242,6 +248,19 @@ int main(int argc, char** argv)
   }
 
 
+  vtkPlusTemporalCalibrationAlgo::CORRELATION_ENGINE correlationEngine(vtkPlusTemporalCalibrationAlgo::CORRELATION_ENGINE_BRUTE_FORCE);
+  vtkPlusTemporalCalibrationAlgo::CORRELATION_ENGINE otherCorrelationEngine(vtkPlusTemporalCalibrationAlgo::CORRELATION_ENGINE_FFT);
+  if (PlusCommon::IsEqualInsensitive(correlationEngineStr, "FFT"))
+  {
+    correlationEngine = vtkPlusTemporalCalibrationAlgo::CORRELATION_ENGINE_FFT;
+    otherCorrelationEngine = vtkPlusTemporalCalibrationAlgo::CORRELATION_ENGINE_BRUTE_FORCE;
+  }
+  else if (!PlusCommon::IsEqualInsensitive(correlationEngineStr, "BRUTE_FORCE"))
+  {
+    std::cerr << "Invalid correlation engine: " << correlationEngineStr << ". Expected BRUTE_FORCE or FFT." << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
   vtkPlusConfig::GetInstance()->GetOutputDirectory();
 
   if (intermediateFileOutputDirectory.empty())
@@ -321,6 +340,22 @@ int main(int argc, char** argv)
 
   vtkPlusTemporalCalibrationAlgo::TEMPORAL_CALIBRATION_ERROR error(vtkPlusTemporalCalibrationAlgo::TEMPORAL_CALIBRATION_ERROR_NONE);
 
+  // Compute the time offset with the other engine first, so that all the reported results belong to the selected engine
+  double otherEngineTrackerLagSec = 0;
+  double otherEngineComputationTimeSec = 0;
+  if (compareCorrelationEngines)
+  {
+    testTemporalCalibrationObject->SetCorrelationEngine(otherCorrelationEngine);
+    if (testTemporalCalibrationObject->Update(error) != PLUS_SUCCESS
+        || testTemporalCalibrationObject->GetMovingLagSec(otherEngineTrackerLagSec) != PLUS_SUCCESS
+        || testTemporalCalibrationObject->GetCorrelationComputationTimeSec(otherEngineComputationTimeSec) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Cannot determine tracker lag with the reference correlation engine, temporal calibration failed");
+      exit(EXIT_FAILURE);
+    }
+  }
+  testTemporalCalibrationObject->SetCorrelationEngine(correlationEngine);
+
   //  Calculate the time-offset
   if (testTemporalCalibrationObject->Update(error) != PLUS_SUCCESS)
   {
@@ -349,6 +384,25 @@ int main(int argc, char** argv)
   }
   LOG_INFO("Max calibration error: " << calibResult.maxCalibrationError);
 
+  double computationTimeSec = 0;
+  testTemporalCalibrationObject->GetCorrelationComputationTimeSec(computationTimeSec);
+  LOG_INFO("Correlation computation time (" << correlationEngineStr << "): " << computationTimeSec << " sec");
+  if (compareCorrelationEngines)
+  {
+    double bruteForceTimeSec = (correlationEngine == vtkPlusTemporalCalibrationAlgo::CORRELATION_ENGINE_FFT) ? otherEngineComputationTimeSec : computationTimeSec;
+    double fftTimeSec = (correlationEngine == vtkPlusTemporalCalibrationAlgo::CORRELATION_ENGINE_FFT) ? computationTimeSec : otherEngineComputationTimeSec;
+    LOG_INFO("Correlation computation time: brute force " << bruteForceTimeSec << " sec, FFT " << fftTimeSec << " sec, speedup: "
+             << (fftTimeSec > 0 ? bruteForceTimeSec / fftTimeSec : 0) << "x");
+    double lagDifferenceSec = calibResult.trackerLagSec - otherEngineTrackerLagSec;
+    LOG_INFO("Tracker lag difference between the correlation engines: " << lagDifferenceSec << " sec");
+    if (fabs(lagDifferenceSec) > maxCorrelationEngineLagDifferenceSec)
+    {
+      LOG_ERROR("Tracker lag difference between the correlation engines (" << lagDifferenceSec << " sec) is larger than the tolerance ("
+                << maxCorrelationEngineLagDifferenceSec << " sec). Test failed!");
+      exit(EXIT_FAILURE);
+    }
+  }
+
   // Write results to file
   std::ostringstream trackerLagOutputFilename;
   trackerLagOutputFilename << intermediateFileOutputDirectory << "/TemporalCalibrationResults.xml" << std::ends;
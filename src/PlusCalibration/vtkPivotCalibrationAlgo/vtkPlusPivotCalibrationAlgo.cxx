@@ -31,6 +31,8 @@ vtkPlusPivotCalibrationAlgo::vtkPlusPivotCalibrationAlgo()
   this->PivotPointPosition_Reference[1] = 0.0;
   this->PivotPointPosition_Reference[2] = 0.0;
   this->PivotPointPosition_Reference[3] = 1.0;
+
+  this->IncrementalSolver.Initialize(6, 1);
 }
 
 //-----------------------------------------------------------------------------
@@ -49,6 +51,7 @@ void vtkPlusPivotCalibrationAlgo::RemoveAllCalibrationPoints()
   }
   this->MarkerToReferenceTransformMatrixArray.clear();
   this->OutlierIndices.clear();
+  this->IncrementalSolver.Initialize(6, 1);
 }
 
 //----------------------------------------------------------------------------
@@ -57,7 +60,19 @@ PlusStatus vtkPlusPivotCalibrationAlgo::InsertNextCalibrationPoint(vtkMatrix4x4*
   vtkMatrix4x4* markerToReferenceTransformMatrixCopy = vtkMatrix4x4::New();
   markerToReferenceTransformMatrixCopy->DeepCopy(aMarkerToReferenceTransformMatrix);
   this->MarkerToReferenceTransformMatrixArray.push_back(markerToReferenceTransformMatrixCopy);
-  return PLUS_SUCCESS;
+
+  // Add the equations of the point to the incremental solver (see GetPivotPointPosition for the description of the equations)
+  double aMatrix[18] = {0};
+  double bVector[3] = {0};
+  for (int i = 0; i < 3; i++)
+  {
+    aMatrix[i * 6 + 0] = aMarkerToReferenceTransformMatrix->Element[i][0];
+    aMatrix[i * 6 + 1] = aMarkerToReferenceTransformMatrix->Element[i][1];
+    aMatrix[i * 6 + 2] = aMarkerToReferenceTransformMatrix->Element[i][2];
+    aMatrix[i * 6 + 3 + i] = -1;
+    bVector[i] = -aMarkerToReferenceTransformMatrix->Element[i][3];
+  }
+  return this->IncrementalSolver.AddObservation(aMatrix, bVector, 3);
 }
 
 //----------------------------------------------------------------------------
@@ -282,6 +297,8 @@ PlusStatus vtkPlusPivotCalibrationAlgo::ReadConfiguration(vtkXMLDataElement* aCo
   XML_READ_CSTRING_ATTRIBUTE_REQUIRED(ObjectMarkerCoordinateFrame, pivotCalibrationElement);
   XML_READ_CSTRING_ATTRIBUTE_REQUIRED(ReferenceCoordinateFrame, pivotCalibrationElement);
   XML_READ_CSTRING_ATTRIBUTE_REQUIRED(ObjectPivotPointCoordinateFrame, pivotCalibrationElement);
+  XML_READ_SCALAR_ATTRIBUTE_OPTIONAL(unsigned long, IncrementalConvergenceWindowSize, pivotCalibrationElement);
+  XML_READ_SCALAR_ATTRIBUTE_OPTIONAL(double, IncrementalConvergenceTolerance, pivotCalibrationElement);
   return PLUS_SUCCESS;
 }
 
@@ -326,3 +343,57 @@ int vtkPlusPivotCalibrationAlgo::GetNumberOfDetectedOutliers()
 {
   return this->OutlierIndices.size();
 }
+
+//-----------------------------------------------------------------------------
+PlusStatus vtkPlusPivotCalibrationAlgo::GetIncrementalPivotPointPosition(double pivotPoint_Marker[3], double pivotPoint_Reference[3])
+{
+  std::vector<double> xVector;
+  if (this->IncrementalSolver.GetSolution(xVector) != PLUS_SUCCESS)
+  {
+    return PLUS_FAIL;
+  }
+  for (int i = 0; i < 3; i++)
+  {
+    pivotPoint_Marker[i] = xVector[i];
+    pivotPoint_Reference[i] = xVector[3 + i];
+  }
+  return PLUS_SUCCESS;
+}
+
+//-----------------------------------------------------------------------------
+double vtkPlusPivotCalibrationAlgo::GetIncrementalCalibrationError()
+{
+  // The solver's error is the RMS of the residual vector norms, which is the distance of the pivot point positions
+  // computed from each point and the estimated pivot point position
+  return this->IncrementalSolver.GetRmsError();
+}
+
+//-----------------------------------------------------------------------------
+bool vtkPlusPivotCalibrationAlgo::GetIncrementalCalibrationConverged()
+{
+  return this->IncrementalSolver.GetConverged();
+}
+
+//-----------------------------------------------------------------------------
+void vtkPlusPivotCalibrationAlgo::SetIncrementalConvergenceWindowSize(unsigned int numberOfPoints)
+{
+  this->IncrementalSolver.SetConvergenceWindowSize(numberOfPoints);
+}
+
+//-----------------------------------------------------------------------------
+unsigned int vtkPlusPivotCalibrationAlgo::GetIncrementalConvergenceWindowSize()
+{
+  return this->IncrementalSolver.GetConvergenceWindowSize();
+}
+
+//-----------------------------------------------------------------------------
+void vtkPlusPivotCalibrationAlgo::SetIncrementalConvergenceTolerance(double tolerance)
+{
+  this->IncrementalSolver.SetConvergenceTolerance(tolerance);
+}
+
+//-----------------------------------------------------------------------------
+double vtkPlusPivotCalibrationAlgo::GetIncrementalConvergenceTolerance()
+{
+  return this->IncrementalSolver.GetConvergenceTolerance();
+}
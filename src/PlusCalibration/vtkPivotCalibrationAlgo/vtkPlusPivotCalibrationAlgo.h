@@ -9,6 +9,7 @@ See License.txt for details.
 
 // Local includes
 #include "PlusConfigure.h"
+#include "PlusIncrementalLeastSquares.h"
 #include "vtkPlusCalibrationExport.h"
 
 // VTK includes
@@ -40,6 +41,11 @@ class vtkXMLDataElement;
   The method detects outlier points (points that have larger than 3x error than the standard deviation) and ignores them when computing the pivot point
   coordinates and the calibration error.
 
+  The pivot point position is also estimated incrementally while the calibration points are inserted (see GetIncrementalPivotPointPosition).
+  Inserting a point takes constant time, so the current estimate and its error can be displayed during the acquisition, and the
+  acquisition can be stopped when the error does not change anymore (see GetIncrementalCalibrationConverged). Outliers are
+  down-weighted when they are inserted, therefore the incremental result may slightly differ from the DoPivotCalibration result.
+
   \ingroup PlusLibCalibrationAlgorithm
 */
 class vtkPlusCalibrationExport vtkPlusPivotCalibrationAlgo : public vtkObject
@@ -86,6 +92,29 @@ public:
   */
   int GetNumberOfDetectedOutliers();
 
+  /*!
+    Get the pivot point position estimated from the calibration points that have been inserted so far.
+    The computation time does not depend on the number of inserted points.
+    \param pivotPoint_Marker Pivot point position in the marker coordinate system
+    \param pivotPoint_Reference Pivot point position in the reference coordinate system
+    \return PLUS_FAIL if the inserted points do not determine the pivot point yet
+  */
+  PlusStatus GetIncrementalPivotPointPosition(double pivotPoint_Marker[3], double pivotPoint_Reference[3]);
+
+  /*! Get the RMS error (in mm) of the incrementally estimated pivot point position for the inlier points. Returns -1 if no estimate is available yet. */
+  double GetIncrementalCalibrationError();
+
+  /*! Returns true if the error of the incremental estimate has not changed significantly recently, so the acquisition can be stopped */
+  bool GetIncrementalCalibrationConverged();
+
+  /*! Number of inserted points between two convergence checks of the incremental estimate */
+  void SetIncrementalConvergenceWindowSize(unsigned int numberOfPoints);
+  unsigned int GetIncrementalConvergenceWindowSize();
+
+  /*! Maximum relative change of the incremental calibration error between two convergence checks for considering the estimate converged */
+  void SetIncrementalConvergenceTolerance(double tolerance);
+  double GetIncrementalConvergenceTolerance();
+
 public:
   vtkGetMacro(CalibrationError, double);
   vtkGetObjectMacro(PivotPointToMarkerTransformMatrix, vtkMatrix4x4);
@@ -134,6 +163,9 @@ protected:
 
   /*! List of outlier sample indices */
   std::set<unsigned int>    OutlierIndices;
+
+  /*! Incremental solver of the pivot point equations, updated when a calibration point is inserted */
+  PlusIncrementalLeastSquares IncrementalSolver;
 };
 
 #endif
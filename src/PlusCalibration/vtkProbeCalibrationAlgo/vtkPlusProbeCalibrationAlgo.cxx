@@ -52,6 +52,8 @@ vtkPlusProbeCalibrationAlgo::vtkPlusProbeCalibrationAlgo()
 {
   this->Optimizer = vtkPlusProbeCalibrationOptimizerAlgo::New();
   this->Optimizer->SetProbeCalibrationAlgo(this);
+  this->IncrementalSolver.Initialize(3, 3);
+  this->LinearLeastSquaresImageToProbeTransformMatrix.set_identity();
 }
 
 //----------------------------------------------------------------------------
@@ -75,6 +77,10 @@ PlusStatus vtkPlusProbeCalibrationAlgo::ReadConfiguration(vtkXMLDataElement* aCo
   XML_READ_CSTRING_ATTRIBUTE_REQUIRED(PhantomCoordinateFrame, probeCalibrationElement);
   XML_READ_CSTRING_ATTRIBUTE_REQUIRED(ReferenceCoordinateFrame, probeCalibrationElement);
 
+  // Incremental calibration options
+  XML_READ_SCALAR_ATTRIBUTE_OPTIONAL(unsigned long, IncrementalConvergenceWindowSize, probeCalibrationElement);
+  XML_READ_SCALAR_ATTRIBUTE_OPTIONAL(double, IncrementalConvergenceTolerance, probeCalibrationElement);
+
   // Optimization options
   if (this->Optimizer->ReadConfiguration(probeCalibrationElement) != PLUS_SUCCESS)
   {
@@ -179,6 +185,16 @@ PlusStatus vtkPlusProbeCalibrationAlgo::ComputeImageToProbeTransformByLinearLeas
     imageToProbeTransformMatrix.set_row(row, resultVector);
   }
 
+  CompleteImageToProbeTransform(imageToProbeTransformMatrix);
+
+  LOG_DEBUG(outliers.size() << " outliers points were found");
+
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusProbeCalibrationAlgo::CompleteImageToProbeTransform(vnl_matrix_fixed<double, 4, 4>& imageToProbeTransformMatrix)
+{
   // Force the last row to be exactly (0,0,0,1) - sometimes it contains numbers of 1e-18 magnitude
   imageToProbeTransformMatrix(3, 0) = 0;
   imageToProbeTransformMatrix(3, 1) = 0;
@@ -198,10 +214,6 @@ PlusStatus vtkPlusProbeCalibrationAlgo::ComputeImageToProbeTransformByLinearLeas
   imageToProbeTransformMatrix(0, 2) = zVector[0];
   imageToProbeTransformMatrix(1, 2) = zVector[1];
   imageToProbeTransformMatrix(2, 2) = zVector[2];
-
-  LOG_DEBUG(outliers.size() << " outliers points were found");
-
-  return PLUS_SUCCESS;
 }
 
 //----------------------------------------------------------------------------
@@ -249,6 +261,7 @@ PlusStatus vtkPlusProbeCalibrationAlgo::Calibrate(vtkPlusTrackedFrameList* valid
   this->PreProcessedWirePositions[CALIBRATION_ALL].Clear();
   this->PreProcessedWirePositions[VALIDATION_ALL].Clear();
   this->PreProcessedWirePositions[CALIBRATION_NOT_OUTLIER].Clear();
+  this->IncrementalSolver.Initialize(3, 3);
 
   // Add tracked frames for calibration and validation
   for (int frameNumber = validationStartFrame; frameNumber < validationEndFrame; ++frameNumber)
@@ -290,6 +303,7 @@ PlusStatus vtkPlusProbeCalibrationAlgo::Calibrate(vtkPlusTrackedFrameList* valid
     LOG_ERROR("Calibration with linear least squares method failed");
     return PLUS_FAIL;
   }
+  this->LinearLeastSquaresImageToProbeTransformMatrix = imageToProbeTransformMatrix;
   // Validate calibration result and set it to member variable and transform repository
   SetAndValidateImageToProbeTransform(imageToProbeTransformMatrix, transformRepository);
 
@@ -511,9 +525,122 @@ PlusStatus vtkPlusProbeCalibrationAlgo::AddPositionsPerImage(PlusTrackedFrame* t
 
   this->PreProcessedWirePositions[datasetType].FramePositions.push_back(framePosition);
 
+  if (datasetType == CALIBRATION_ALL)
+  {
+    return AddIncrementalCalibrationPositions(framePosition);
+  }
+
   return PLUS_SUCCESS;
 }
 
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusProbeCalibrationAlgo::AddIncrementalCalibrationPositions(const NWirePositionType& framePosition)
+{
+  // Each middle wire gives an equation for the x, y, and translation columns of the ImageToProbe matrix (see ComputeImageToProbeTransformByLinearLeastSquaresMethod):
+  //  [ x_Image y_Image 1 ] * [ ImageToProbe(0..2,0) ImageToProbe(0..2,1) ImageToProbe(0..2,3) ]^T = [ x_Probe y_Probe z_Probe ]
+  const unsigned int numberOfNWires = framePosition.MiddleWireIntersectionPointsPos_Probe.size();
+  if (numberOfNWires == 0)
+  {
+    return PLUS_SUCCESS;
+  }
+  std::vector<double> aMatrix(numberOfNWires * 3);
+  std::vector<double> bMatrix(numberOfNWires * 3);
+  for (unsigned int nWireIndex = 0; nWireIndex < numberOfNWires; ++nWireIndex)
+  {
+    const vnl_vector_fixed<double, 4>& middleWireIntersectionPointPos_Image = framePosition.AllWiresIntersectionPointsPos_Image[nWireIndex * 3 + 1];
+    const vnl_vector_fixed<double, 4>& middleWireIntersectionPointPos_Probe = framePosition.MiddleWireIntersectionPointsPos_Probe[nWireIndex];
+    aMatrix[nWireIndex * 3 + 0] = middleWireIntersectionPointPos_Image[0];
+    aMatrix[nWireIndex * 3 + 1] = middleWireIntersectionPointPos_Image[1];
+    aMatrix[nWireIndex * 3 + 2] = 1.0;
+    bMatrix[nWireIndex * 3 + 0] = middleWireIntersectionPointPos_Probe[0];
+    bMatrix[nWireIndex * 3 + 1] = middleWireIntersectionPointPos_Probe[1];
+    bMatrix[nWireIndex * 3 + 2] = middleWireIntersectionPointPos_Probe[2];
+  }
+  return this->IncrementalSolver.AddObservation(&aMatrix[0], &bMatrix[0], numberOfNWires);
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusProbeCalibrationAlgo::StartIncrementalCalibration(const std::vector<PlusNWire>& nWires)
+{
+  this->NWires = nWires;
+  this->PreProcessedWirePositions[CALIBRATION_ALL].Clear();
+  this->IncrementalSolver.Initialize(3, 3);
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusProbeCalibrationAlgo::AddIncrementalCalibrationFrame(PlusTrackedFrame* trackedFrame, vtkPlusTransformRepository* transformRepository)
+{
+  if (trackedFrame == NULL || transformRepository == NULL)
+  {
+    LOG_ERROR("vtkPlusProbeCalibrationAlgo::AddIncrementalCalibrationFrame failed: invalid input");
+    return PLUS_FAIL;
+  }
+  return AddPositionsPerImage(trackedFrame, transformRepository, CALIBRATION_ALL);
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusProbeCalibrationAlgo::GetIncrementalImageToProbeTransformMatrix(vtkMatrix4x4* imageToProbeMatrix)
+{
+  std::vector<double> xMatrix;
+  if (this->IncrementalSolver.GetSolution(xMatrix) != PLUS_SUCCESS)
+  {
+    return PLUS_FAIL;
+  }
+  vnl_matrix_fixed<double, 4, 4> imageToProbeTransformMatrix;
+  imageToProbeTransformMatrix.fill(0);
+  for (int row = 0; row < 3; ++row)
+  {
+    imageToProbeTransformMatrix(row, 0) = xMatrix[0 * 3 + row];
+    imageToProbeTransformMatrix(row, 1) = xMatrix[1 * 3 + row];
+    imageToProbeTransformMatrix(row, 3) = xMatrix[2 * 3 + row];
+  }
+  CompleteImageToProbeTransform(imageToProbeTransformMatrix);
+  PlusMath::ConvertVnlMatrixToVtkMatrix(imageToProbeTransformMatrix, imageToProbeMatrix);
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+double vtkPlusProbeCalibrationAlgo::GetIncrementalCalibrationError()
+{
+  // The solver's error is computed for the residual of all the NWires of a frame, convert it to the error of a single point
+  double rmsError = this->IncrementalSolver.GetRmsError();
+  if (rmsError < 0 || this->NWires.empty())
+  {
+    return -1.0;
+  }
+  return rmsError / sqrt(static_cast<double>(this->NWires.size()));
+}
+
+//----------------------------------------------------------------------------
+bool vtkPlusProbeCalibrationAlgo::GetIncrementalCalibrationConverged()
+{
+  return this->IncrementalSolver.GetConverged();
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusProbeCalibrationAlgo::SetIncrementalConvergenceWindowSize(unsigned int numberOfFrames)
+{
+  this->IncrementalSolver.SetConvergenceWindowSize(numberOfFrames);
+}
+
+//----------------------------------------------------------------------------
+unsigned int vtkPlusProbeCalibrationAlgo::GetIncrementalConvergenceWindowSize()
+{
+  return this->IncrementalSolver.GetConvergenceWindowSize();
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusProbeCalibrationAlgo::SetIncrementalConvergenceTolerance(double tolerance)
+{
+  this->IncrementalSolver.SetConvergenceTolerance(tolerance);
+}
+
+//----------------------------------------------------------------------------
+double vtkPlusProbeCalibrationAlgo::GetIncrementalConvergenceTolerance()
+{
+  return this->IncrementalSolver.GetConvergenceTolerance();
+}
+
 //-----------------------------------------------------------------------------
 void vtkPlusProbeCalibrationAlgo::SetAndValidateImageToProbeTransform(const vnl_matrix_fixed<double, 4, 4>& imageToProbeTransformMatrix, vtkPlusTransformRepository* transformRepository)
 {
@@ -1174,3 +1301,9 @@ void vtkPlusProbeCalibrationAlgo::GetImageToProbeTransformMatrix(vtkMatrix4x4* i
 {
   PlusMath::ConvertVnlMatrixToVtkMatrix(this->ImageToProbeTransformMatrix, imageToProbeMatrix);
 }
+
+//----------------------------------------------------------------------------
+void vtkPlusProbeCalibrationAlgo::GetLinearLeastSquaresImageToProbeTransformMatrix(vtkMatrix4x4* imageToProbeMatrix)
+{
+  PlusMath::ConvertVnlMatrixToVtkMatrix(this->LinearLeastSquaresImageToProbeTransformMatrix, imageToProbeMatrix);
+}
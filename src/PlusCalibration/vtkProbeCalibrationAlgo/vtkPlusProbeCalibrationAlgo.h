@@ -17,6 +17,7 @@
 
 #include "vtkObject.h"
 #include "vtkPlusProbeCalibrationOptimizerAlgo.h"
+#include "PlusIncrementalLeastSquares.h"
 
 class PlusTrackedFrame;
 class vtkPlusTrackedFrameList;
@@ -27,6 +28,13 @@ class PlusNWire;
 /*!
   \class vtkPlusProbeCalibrationAlgo
   \brief Probe calibration algorithm class
+
+  Besides the batch calibration (Calibrate), the linear least squares estimate of the ImageToProbe transform can be computed incrementally
+  while the frames are acquired: start it with StartIncrementalCalibration, add each segmented frame with AddIncrementalCalibrationFrame,
+  and get the current estimate with GetIncrementalImageToProbeTransformMatrix. Adding a frame takes constant time, so the estimate and its error
+  can be displayed during the acquisition, which can be stopped when the error does not change anymore (GetIncrementalCalibrationConverged).
+  The optional optimization step is only performed by the batch calibration.
+
   \ingroup PlusLibCalibrationAlgorithm
 */
 class vtkPlusCalibrationExport vtkPlusProbeCalibrationAlgo : public vtkObject
@@ -77,6 +85,42 @@ public:
   /*! Get the calibration result transformation matrix */
   void GetImageToProbeTransformMatrix( vtkMatrix4x4* imageToProbeMatrix );
 
+  /*! Get the transformation matrix that the last calibration computed by linear least squares method (before the optional optimization) */
+  void GetLinearLeastSquaresImageToProbeTransformMatrix( vtkMatrix4x4* imageToProbeMatrix );
+
+  /*!
+    Remove all calibration frames and start a new incremental calibration
+    \param nWires NWire structure that contains the computed imaginary intersections
+  */
+  void StartIncrementalCalibration( const std::vector<PlusNWire>& nWires );
+
+  /*!
+    Add a segmented frame to the incremental calibration. The computation time does not depend on the number of frames added before.
+    \param trackedFrame Tracked frame with segmentation results
+    \param transformRepository Transform repository object to be able to get the default transform
+  */
+  PlusStatus AddIncrementalCalibrationFrame( PlusTrackedFrame* trackedFrame, vtkPlusTransformRepository* transformRepository );
+
+  /*!
+    Get the ImageToProbe transform estimated from the calibration frames that have been added so far (by linear least squares method, without optimization)
+    \return PLUS_FAIL if the frames do not determine the transform yet
+  */
+  PlusStatus GetIncrementalImageToProbeTransformMatrix( vtkMatrix4x4* imageToProbeMatrix );
+
+  /*! Get the RMS distance (in mm) of the middle wire positions and the incrementally estimated positions on the inlier frames. Returns -1 if no estimate is available yet. */
+  double GetIncrementalCalibrationError();
+
+  /*! Returns true if the error of the incremental estimate has not changed significantly recently, so the acquisition can be stopped */
+  bool GetIncrementalCalibrationConverged();
+
+  /*! Number of added frames between two convergence checks of the incremental estimate */
+  void SetIncrementalConvergenceWindowSize( unsigned int numberOfFrames );
+  unsigned int GetIncrementalConvergenceWindowSize();
+
+  /*! Maximum relative change of the incremental calibration error between two convergence checks for considering the estimate converged */
+  void SetIncrementalConvergenceTolerance( double tolerance );
+  double GetIncrementalConvergenceTolerance();
+
   /*! Set the calibration date and time in string format */
   vtkSetStringMacro( CalibrationDate );
   /*! Get the calibration date and time in string format */
@@ -183,6 +227,12 @@ protected:
   */
   PlusStatus ComputeImageToProbeTransformByLinearLeastSquaresMethod( vnl_matrix_fixed<double, 4, 4>& imageToProbeTransformMatrix, std::set<int>& outliers );
 
+  /*!
+    Complete the transformation matrix from a projection matrix to a 3D-3D transformation matrix: set the z column
+    orthogonal to the x and y columns and set the last row to (0,0,0,1)
+  */
+  static void CompleteImageToProbeTransform( vnl_matrix_fixed<double, 4, 4>& imageToProbeTransformMatrix );
+
   /*! Remove outliers from calibration data
   */
   void UpdateNonOutlierData( const std::set<int>& outliers );
@@ -222,6 +272,9 @@ protected:
   /*! The result of the calibration */
   vnl_matrix_fixed<double, 4, 4> ImageToProbeTransformMatrix;
 
+  /*! The result of the linear least squares method in the last calibration, which is the seed of the optimization */
+  vnl_matrix_fixed<double, 4, 4> LinearLeastSquaresImageToProbeTransformMatrix;
+
   /*! List of NWires used for calibration and error computation */
   std::vector<PlusNWire> NWires;
 
@@ -245,6 +298,9 @@ protected:
     vnl_matrix_fixed<double, 4, 4> ProbeToPhantomTransform;
   };
 
+  /*! Add the middle wire positions of a calibration frame to the incremental solver */
+  PlusStatus AddIncrementalCalibrationPositions( const NWirePositionType& framePosition );
+
   struct NWireErrorType
   {
     /*!
@@ -316,6 +372,12 @@ protected:
 
   vtkPlusProbeCalibrationOptimizerAlgo* Optimizer;
 
+  /*!
+    Incremental solver of the linear least squares problem: the unknowns are the x, y, and translation columns of the ImageToProbe transform,
+    each frame adds one equation for the middle wire of each NWire
+  */
+  PlusIncrementalLeastSquares IncrementalSolver;
+
 private:
   vtkPlusProbeCalibrationAlgo( const vtkPlusProbeCalibrationAlgo& );
   void operator=( const vtkPlusProbeCalibrationAlgo& );
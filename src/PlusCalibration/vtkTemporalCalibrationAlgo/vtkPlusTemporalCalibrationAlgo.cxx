@@ -5,6 +5,7 @@
 =========================================================Plus=header=end*/
 
 #include "PlusConfigure.h"
+#include "PlusFft.h"
 #include "PlusTrackedFrame.h"
 #include "vtkObjectFactory.h"
 #include "vtkDoubleArray.h"
@@ -18,6 +19,7 @@
 #include <algorithm>
 #include <fstream>
 #include <iostream>
+#include <vector>
 
 //-----------------------------------------------------------------------------
 
@@ -59,6 +61,61 @@ namespace
     AMPLITUDE
   };
   MetricNormalizationType METRIC_NORMALIZATION = STD;
+
+  //-----------------------------------------------------------------------------
+  // Linearly interpolate the signal at uniformly spaced time points. Values outside the time range of the signal
+  // are clamped to the first and last values (same as vtkPiecewiseFunction). Timestamps must be increasing.
+  void ResampleSignalUniformly(const std::deque<double>& timestamps, const std::deque<double>& values,
+                               double startTimeSec, double stepSec, int numberOfSamples, std::vector<double>& resampledValues)
+  {
+    resampledValues.resize(numberOfSamples);
+    unsigned int segmentIndex = 0;
+    for (int i = 0; i < numberOfSamples; ++i)
+    {
+      double t = startTimeSec + i * stepSec;
+      if (t <= timestamps.front())
+      {
+        resampledValues[i] = values.front();
+        continue;
+      }
+      if (t >= timestamps.back())
+      {
+        resampledValues[i] = values.back();
+        continue;
+      }
+      while (timestamps[segmentIndex + 1] < t)
+      {
+        ++segmentIndex;
+      }
+      double segmentLength = timestamps[segmentIndex + 1] - timestamps[segmentIndex];
+      double weight = (segmentLength > 0) ? (t - timestamps[segmentIndex]) / segmentLength : 0.0;
+      resampledValues[i] = values[segmentIndex] + weight * (values[segmentIndex + 1] - values[segmentIndex]);
+    }
+  }
+
+  //-----------------------------------------------------------------------------
+  // Find the maximum of uniformly sampled values. The position and value of the maximum
+  // are refined by fitting a parabola to the maximum sample and its two neighbors.
+  void FindInterpolatedMaximum(const std::vector<double>& values, double& maximumIndex, double& maximumValue)
+  {
+    int bestIndex = static_cast<int>(std::max_element(values.begin(), values.end()) - values.begin());
+    maximumIndex = bestIndex;
+    maximumValue = values[bestIndex];
+    if (bestIndex == 0 || bestIndex + 1 >= static_cast<int>(values.size()))
+    {
+      return;
+    }
+    double previous = values[bestIndex - 1];
+    double next = values[bestIndex + 1];
+    double curvature = previous - 2.0 * maximumValue + next;
+    if (curvature >= 0)
+    {
+      return;
+    }
+    double delta = 0.5 * (previous - next) / curvature;
+    maximumIndex = bestIndex + delta;
+    maximumValue = maximumValue - 0.25 * (previous - next) * delta;
+  }
 }
 
 //-----------------------------------------------------------------------------
@@ -68,6 +125,8 @@ vtkPlusTemporalCalibrationAlgo::vtkPlusTemporalCalibrationAlgo()
   , SaveIntermediateImages(false)
   , IntermediateFilesOutputDirectory(vtkPlusConfig::GetInstance()->GetOutputDirectory())
   , SamplingResolutionSec(DEFAULT_SAMPLING_RESOLUTION_SEC)
+  , CorrelationEngine(CORRELATION_ENGINE_BRUTE_FORCE)
+  , CorrelationComputationTimeSec(0.0)
   , BestCorrelationValue(0.0)
   , BestCorrelationLagIndex(-1)
   , BestCorrelationTimeOffset(0.0)
@@ -180,6 +239,18 @@ void vtkPlusTemporalCalibrationAlgo::SetMaximumMovingLagSec(double maxLagSec)
   this->MaxMovingLagSec = maxLagSec;
 }
 
+//-----------------------------------------------------------------------------
+void vtkPlusTemporalCalibrationAlgo::SetCorrelationEngine(CORRELATION_ENGINE engine)
+{
+  this->CorrelationEngine = engine;
+}
+
+//-----------------------------------------------------------------------------
+vtkPlusTemporalCalibrationAlgo::CORRELATION_ENGINE vtkPlusTemporalCalibrationAlgo::GetCorrelationEngine() const
+{
+  return this->CorrelationEngine;
+}
+
 //-----------------------------------------------------------------------------
 void vtkPlusTemporalCalibrationAlgo::SetIntermediateFilesOutputDirectory(const std::string& outputDirectory)
 {
@@ -234,6 +305,18 @@ PlusStatus vtkPlusTemporalCalibrationAlgo::GetMaxCalibrationError(double& maxCal
   return PLUS_SUCCESS;
 }
 
+//-----------------------------------------------------------------------------
+PlusStatus vtkPlusTemporalCalibrationAlgo::GetCorrelationComputationTimeSec(double& computationTimeSec)
+{
+  if (this->NeverUpdated)
+  {
+    LOG_ERROR("You must first call the \"Update()\" to compute the correlation computation time.");
+    return PLUS_FAIL;
+  }
+  computationTimeSec = this->CorrelationComputationTimeSec;
+  return PLUS_SUCCESS;
+}
+
 //-----------------------------------------------------------------------------
 PlusStatus vtkPlusTemporalCalibrationAlgo::GetUncalibratedMovingPositionSignal(vtkTable* unCalibratedMovingPositionSignal)
 {
@@ -661,42 +744,8 @@ PlusStatus vtkPlusTemporalCalibrationAlgo::ComputeCommonTimeRange()
 }
 
 //-----------------------------------------------------------------------------
-PlusStatus vtkPlusTemporalCalibrationAlgo::ComputeMovingSignalLagSec(TEMPORAL_CALIBRATION_ERROR& error)
+PlusStatus vtkPlusTemporalCalibrationAlgo::ComputeBestCorrelationBruteForce(double imageFramePeriodSec, TEMPORAL_CALIBRATION_ERROR& error)
 {
-  // Need to determine the common signal range before extracting signals from the frames,
-  // because normalization, PCA, etc. must be performed only by taking into account
-  // the frames in the common range.
-  if (ComputeCommonTimeRange() != PLUS_SUCCESS)
-  {
-    error = TEMPORAL_CALIBRATION_ERROR_NO_COMMON_TIME_RANGE;
-    return PLUS_FAIL;
-  }
-
-  // Compute the position signal values from the input frames
-  if (ComputePositionSignalValues(this->FixedSignal) != PLUS_SUCCESS)
-  {
-    error = TEMPORAL_CALIBRATION_ERROR_FAILED_COMPUTE_FIXED;
-    LOG_ERROR("Failed to compute position signal from fixed frames");
-    return PLUS_FAIL;
-  }
-  if (ComputePositionSignalValues(this->MovingSignal) != PLUS_SUCCESS)
-  {
-    error = TEMPORAL_CALIBRATION_ERROR_FAILED_COMPUTE_MOVING;
-    LOG_ERROR("Failed to compute position signal from moving frames");
-    return PLUS_FAIL;
-  }
-
-  // Compute approx image image frame period. We will use this frame period as a step size in the coarse optimum search phase.
-  double fixedTimestampMin = this->FixedSignal.signalTimestamps.at(0);
-  double fixedTimestampMax = this->FixedSignal.signalTimestamps.at(this->FixedSignal.signalTimestamps.size() - 1);
-  if (this->FixedSignal.signalTimestamps.size() < 2)
-  {
-    error = TEMPORAL_CALIBRATION_ERROR_NOT_ENOUGH_FIXED_FRAMES;
-    LOG_ERROR("Not enough fixed frames are available");
-    return PLUS_FAIL;
-  }
-  double imageFramePeriodSec = (fixedTimestampMax - fixedTimestampMin) / (this->FixedSignal.signalTimestamps.size() - 1);
-
   double searchRangeFineStep = imageFramePeriodSec * 3;
 
   //  Compute cross correlation with sign convention #1
@@ -777,6 +826,259 @@ PlusStatus vtkPlusTemporalCalibrationAlgo::ComputeMovingSignalLagSec(TEMPORAL_CA
     this->CorrelationValuesFine = corrValuesInvertedTrackerFine;
   }
 
+  return PLUS_SUCCESS;
+}
+
+//-----------------------------------------------------------------------------
+PlusStatus vtkPlusTemporalCalibrationAlgo::ComputeBestCorrelationFft(double imageFramePeriodSec, TEMPORAL_CALIBRATION_ERROR& error)
+{
+  const double stepSec = this->SamplingResolutionSec;
+  if (stepSec < TIMESTAMP_EPSILON_SEC)
+  {
+    error = TEMPORAL_CALIBRATION_ERROR_SAMPLING_RESOLUTION_TOO_SMALL;
+    LOG_ERROR("Sampling resolution is too small: " << stepSec << " sec");
+    return PLUS_FAIL;
+  }
+  if (this->MovingSignal.signalTimestamps.empty())
+  {
+    error = TEMPORAL_CALIBRATION_ERROR_CORRELATION_RESULT_EMPTY;
+    LOG_ERROR("Moving signal is empty");
+    return PLUS_FAIL;
+  }
+
+  // Resample both signals once to a uniform grid. The moving signal grid is extended by the maximum lag on both sides,
+  // so that the moving sample k+p corresponds to the fixed sample k shifted by (p-maxLagSteps)*stepSec.
+  const double fixedStartTimeSec = this->FixedSignal.signalTimestamps.front();
+  const double fixedStopTimeSec = this->FixedSignal.signalTimestamps.back();
+  const int fixedCount = static_cast<int>(floor((fixedStopTimeSec - fixedStartTimeSec) / stepSec + 1e-6)) + 1;
+  const int maxLagSteps = static_cast<int>(floor(this->MaxMovingLagSec / stepSec + 1e-6));
+  const int lagCount = 2 * maxLagSteps + 1;
+  const int movingCount = fixedCount + 2 * maxLagSteps;
+  if (fixedCount < 2)
+  {
+    error = TEMPORAL_CALIBRATION_ERROR_NOT_ENOUGH_FIXED_FRAMES;
+    LOG_ERROR("Not enough fixed samples are available at " << stepSec << " sec sampling resolution");
+    return PLUS_FAIL;
+  }
+  std::vector<double> fixedValues;
+  ResampleSignalUniformly(this->FixedSignal.signalTimestamps, this->FixedSignal.signalValues, fixedStartTimeSec, stepSec, fixedCount, fixedValues);
+  std::vector<double> movingValues;
+  ResampleSignalUniformly(this->MovingSignal.signalTimestamps, this->MovingSignal.signalValues, fixedStartTimeSec - maxLagSteps * stepSec, stepSec, movingCount, movingValues);
+
+  // Normalize the fixed signal to zero mean and unit standard deviation over its whole time range.
+  // The brute-force search normalizes it in the overlap window of each offset instead, so the metric values are close to but not
+  // the same as the brute-force metric values.
+  double fixedMean = 0;
+  for (int i = 0; i < fixedCount; ++i)
+  {
+    fixedMean += fixedValues[i];
+  }
+  fixedMean /= fixedCount;
+  double fixedSumSquares = 0;
+  for (int i = 0; i < fixedCount; ++i)
+  {
+    fixedValues[i] -= fixedMean;
+    fixedSumSquares += fixedValues[i] * fixedValues[i];
+  }
+  double fixedStdev = sqrt(fixedSumSquares / (fixedCount - 1));
+  if (fixedStdev < 1e-10)
+  {
+    error = TEMPORAL_CALIBRATION_ERROR_UNABLE_NORMALIZE_METRIC;
+    LOG_ERROR("Cannot normalize data, stdev is too small");
+    return PLUS_FAIL;
+  }
+  for (int i = 0; i < fixedCount; ++i)
+  {
+    fixedValues[i] /= fixedStdev;
+  }
+
+  // The moving signal is normalized in each overlap window separately, using running sums.
+  // The overall mean is subtracted first to keep the running sums accurate.
+  double movingMean = 0;
+  for (int i = 0; i < movingCount; ++i)
+  {
+    movingMean += movingValues[i];
+  }
+  movingMean /= movingCount;
+  std::vector<double> movingRunningSum(movingCount + 1, 0.0);
+  std::vector<double> movingRunningSumSquares(movingCount + 1, 0.0);
+  for (int i = 0; i < movingCount; ++i)
+  {
+    movingValues[i] -= movingMean;
+    movingRunningSum[i + 1] = movingRunningSum[i] + movingValues[i];
+    movingRunningSumSquares[i + 1] = movingRunningSumSquares[i] + movingValues[i] * movingValues[i];
+  }
+
+  // Cross-correlation for all the time offsets: sum(fixed[k]*moving[k+p]) = ifft(conj(fft(fixed))*fft(moving))[p]
+  // The signals are zero-padded to at least movingCount values, so the circular correlation does not wrap around for the used offsets.
+  PlusFft fft;
+  if (fft.SetLength(PlusFft::GetPowerOfTwoLength(movingCount)) != PLUS_SUCCESS)
+  {
+    error = TEMPORAL_CALIBRATION_ERROR_CORRELATION_RESULT_EMPTY;
+    return PLUS_FAIL;
+  }
+  const unsigned int fftLength = fft.GetLength();
+  std::vector<double> fixedSpectrum(2 * fftLength, 0.0);
+  std::vector<double> crossSpectrum(2 * fftLength, 0.0);
+  for (int i = 0; i < fixedCount; ++i)
+  {
+    fixedSpectrum[2 * i] = fixedValues[i];
+  }
+  for (int i = 0; i < movingCount; ++i)
+  {
+    crossSpectrum[2 * i] = movingValues[i];
+  }
+  fft.Transform(&fixedSpectrum[0]);
+  fft.Transform(&crossSpectrum[0]);
+  for (unsigned int i = 0; i < fftLength; ++i)
+  {
+    double fixedRe = fixedSpectrum[2 * i];
+    double fixedIm = fixedSpectrum[2 * i + 1];
+    double movingRe = crossSpectrum[2 * i];
+    double movingIm = crossSpectrum[2 * i + 1];
+    crossSpectrum[2 * i] = fixedRe * movingRe + fixedIm * movingIm;
+    crossSpectrum[2 * i + 1] = fixedRe * movingIm - fixedIm * movingRe;
+  }
+  fft.InverseTransform(&crossSpectrum[0]);
+
+  // For normalized signals sum((a-b)^2) = 2*(n-1) - 2*sum(a*b). Inverting the moving signal (sign convention #2) only
+  // changes the sign of the cross-correlation term. The metric is scaled to the number of fixed signal samples,
+  // so that its magnitude is comparable to the metric computed by the brute-force search.
+  const double metricScale = static_cast<double>(this->FixedSignal.signalTimestamps.size()) / fixedCount;
+  std::vector<double> corrValues(lagCount);
+  std::vector<double> corrValuesInvertedTracker(lagCount);
+  std::vector<double> normalizationFactors(lagCount);
+  for (int p = 0; p < lagCount; ++p)
+  {
+    double sum = movingRunningSum[p + fixedCount] - movingRunningSum[p];
+    double sumSquares = movingRunningSumSquares[p + fixedCount] - movingRunningSumSquares[p];
+    double variance = (sumSquares - sum * sum / fixedCount) / (fixedCount - 1);
+    double normalizationFactor = (variance > 1e-20) ? 1.0 / sqrt(variance) : 1.0;
+    normalizationFactors[p] = normalizationFactor;
+    double crossCorrelation = crossSpectrum[2 * p] * normalizationFactor;
+    corrValues[p] = std::min(0.0, -(2.0 * (fixedCount - 1) - 2.0 * crossCorrelation) * metricScale);
+    corrValuesInvertedTracker[p] = std::min(0.0, -(2.0 * (fixedCount - 1) + 2.0 * crossCorrelation) * metricScale);
+  }
+
+  double peakIndex = 0;
+  double bestCorrelationValue = 0;
+  FindInterpolatedMaximum(corrValues, peakIndex, bestCorrelationValue);
+  double bestCorrelationTimeOffset = (peakIndex - maxLagSteps) * stepSec;
+  LOG_DEBUG("Time offset with sign convention #1: " << bestCorrelationTimeOffset);
+  double peakIndexInvertedTracker = 0;
+  double bestCorrelationValueInvertedTracker = 0;
+  FindInterpolatedMaximum(corrValuesInvertedTracker, peakIndexInvertedTracker, bestCorrelationValueInvertedTracker);
+  double bestCorrelationTimeOffsetInvertedTracker = (peakIndexInvertedTracker - maxLagSteps) * stepSec;
+  LOG_DEBUG("Time offset with sign convention #2: " << bestCorrelationTimeOffsetInvertedTracker);
+
+  // Adopt the smallest tracker lag
+  const std::vector<double>* bestCorrValues = &corrValues;
+  if (std::abs(bestCorrelationTimeOffset) >= std::abs(bestCorrelationTimeOffsetInvertedTracker))
+  {
+    bestCorrValues = &corrValuesInvertedTracker;
+    peakIndex = peakIndexInvertedTracker;
+    bestCorrelationValue = bestCorrelationValueInvertedTracker;
+    bestCorrelationTimeOffset = bestCorrelationTimeOffsetInvertedTracker;
+
+    // Mirror tracker metric signal about x-axis to correspond to sign convention #2
+    for (unsigned int i = 0; i < this->MovingSignal.signalValues.size(); ++i)
+    {
+      this->MovingSignal.signalValues.at(i) *= -1;
+    }
+  }
+  int nearestPeakIndex = static_cast<int>(floor(peakIndex + 0.5));
+  this->MovingLagSec = bestCorrelationTimeOffset;
+  this->BestCorrelationTimeOffset = bestCorrelationTimeOffset;
+  this->BestCorrelationValue = bestCorrelationValue;
+  this->BestCorrelationNormalizationFactor = normalizationFactors[nearestPeakIndex];
+
+  // Store the metric with the image frame period resolution in the whole search range
+  // and with sampling resolution around the best offset, as the brute-force search does
+  int coarseStep = std::max(1, static_cast<int>(floor(imageFramePeriodSec / stepSec + 0.5)));
+  this->CorrelationTimeOffsets.clear();
+  this->CorrelationValues.clear();
+  for (int p = 0; p < lagCount; p += coarseStep)
+  {
+    this->CorrelationTimeOffsets.push_back((p - maxLagSteps) * stepSec);
+    this->CorrelationValues.push_back((*bestCorrValues)[p]);
+  }
+  int fineHalfRange = static_cast<int>(ceil(imageFramePeriodSec * 3 / stepSec));
+  this->CorrelationTimeOffsetsFine.clear();
+  this->CorrelationValuesFine.clear();
+  for (int p = std::max(0, nearestPeakIndex - fineHalfRange); p <= std::min(lagCount - 1, nearestPeakIndex + fineHalfRange); ++p)
+  {
+    this->CorrelationTimeOffsetsFine.push_back((p - maxLagSteps) * stepSec);
+    this->CorrelationValuesFine.push_back((*bestCorrValues)[p]);
+  }
+
+  // The maximum calibration error is computed from the fixed signal values normalized in the overlap window
+  NormalizeMetricValues(this->FixedSignal.signalValues, this->FixedSignalValuesNormalizationFactor, fixedStartTimeSec + this->MovingLagSec, fixedStopTimeSec + this->MovingLagSec, this->FixedSignal.signalTimestamps);
+
+  LOG_DEBUG("bestCorrelationValue=" << this->BestCorrelationValue);
+  LOG_DEBUG("bestCorrelationTimeOffset=" << this->BestCorrelationTimeOffset);
+  LOG_DEBUG("bestCorrelationNormalizationFactor=" << this->BestCorrelationNormalizationFactor);
+  LOG_DEBUG("numberOfSamples=" << lagCount);
+  return PLUS_SUCCESS;
+}
+
+//-----------------------------------------------------------------------------
+PlusStatus vtkPlusTemporalCalibrationAlgo::ComputeMovingSignalLagSec(TEMPORAL_CALIBRATION_ERROR& error)
+{
+  // Need to determine the common signal range before extracting signals from the frames,
+  // because normalization, PCA, etc. must be performed only by taking into account
+  // the frames in the common range.
+  if (ComputeCommonTimeRange() != PLUS_SUCCESS)
+  {
+    error = TEMPORAL_CALIBRATION_ERROR_NO_COMMON_TIME_RANGE;
+    return PLUS_FAIL;
+  }
+
+  // Compute the position signal values from the input frames
+  if (ComputePositionSignalValues(this->FixedSignal) != PLUS_SUCCESS)
+  {
+    error = TEMPORAL_CALIBRATION_ERROR_FAILED_COMPUTE_FIXED;
+    LOG_ERROR("Failed to compute position signal from fixed frames");
+    return PLUS_FAIL;
+  }
+  if (ComputePositionSignalValues(this->MovingSignal) != PLUS_SUCCESS)
+  {
+    error = TEMPORAL_CALIBRATION_ERROR_FAILED_COMPUTE_MOVING;
+    LOG_ERROR("Failed to compute position signal from moving frames");
+    return PLUS_FAIL;
+  }
+
+  // Compute approx image image frame period. We will use this frame period as a step size in the coarse optimum search phase.
+  double fixedTimestampMin = this->FixedSignal.signalTimestamps.at(0);
+  double fixedTimestampMax = this->FixedSignal.signalTimestamps.at(this->FixedSignal.signalTimestamps.size() - 1);
+  if (this->FixedSignal.signalTimestamps.size() < 2)
+  {
+    error = TEMPORAL_CALIBRATION_ERROR_NOT_ENOUGH_FIXED_FRAMES;
+    LOG_ERROR("Not enough fixed frames are available");
+    return PLUS_FAIL;
+  }
+  double imageFramePeriodSec = (fixedTimestampMax - fixedTimestampMin) / (this->FixedSignal.signalTimestamps.size() - 1);
+
+  double correlationStartTimeSec = vtkPlusAccurateTimer::GetSystemTime();
+  PlusStatus correlationStatus = PLUS_FAIL;
+  switch (this->CorrelationEngine)
+  {
+  case CORRELATION_ENGINE_BRUTE_FORCE:
+    correlationStatus = ComputeBestCorrelationBruteForce(imageFramePeriodSec, error);
+    break;
+  case CORRELATION_ENGINE_FFT:
+    correlationStatus = ComputeBestCorrelationFft(imageFramePeriodSec, error);
+    break;
+  default:
+    LOG_ERROR("Unknown correlation engine: " << this->CorrelationEngine);
+    error = TEMPORAL_CALIBRATION_ERROR_CORRELATION_RESULT_EMPTY;
+  }
+  this->CorrelationComputationTimeSec = vtkPlusAccurateTimer::GetSystemTime() - correlationStartTimeSec;
+  if (correlationStatus != PLUS_SUCCESS)
+  {
+    return PLUS_FAIL;
+  }
+  LOG_DEBUG("Alignment metric computation time: " << this->CorrelationComputationTimeSec << " sec");
+
   // Normalize the tracker metric based on the best index offset (only considering the overlap "window"
   this->MovingSignal.normalizedSignalValues.clear();
   this->MovingSignal.normalizedSignalTimestamps.clear();
@@ -894,6 +1196,7 @@ PlusStatus vtkPlusTemporalCalibrationAlgo::ReadConfiguration(vtkXMLDataElement*
   }
   XML_READ_BOOL_ATTRIBUTE_OPTIONAL(SaveIntermediateImages, calibrationParameters);
   XML_READ_SCALAR_ATTRIBUTE_OPTIONAL(double, MaximumMovingLagSec, calibrationParameters);
+  XML_READ_ENUM2_ATTRIBUTE_OPTIONAL(CorrelationEngine, calibrationParameters, "BRUTE_FORCE", CORRELATION_ENGINE_BRUTE_FORCE, "FFT", CORRELATION_ENGINE_FFT);
 
   if (calibrationParameters != NULL)
   {
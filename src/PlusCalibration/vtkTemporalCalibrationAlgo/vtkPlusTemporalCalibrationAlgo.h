@@ -62,6 +62,12 @@ public:
     // (e.g., bottom of water tank)
   };
 
+  enum CORRELATION_ENGINE
+  {
+    CORRELATION_ENGINE_BRUTE_FORCE, // The moving signal is resampled and both signals are normalized in the overlap window at each tested time offset separately
+    CORRELATION_ENGINE_FFT          // Both signals are resampled once to a uniform grid and the metric is computed for all time offsets using FFT (the fixed signal is normalized only once)
+  };
+
   struct SignalType
   {
     vtkPlusTrackedFrameList* frameList;
@@ -105,6 +111,16 @@ public:
   /*! Sets the maximum allowable time lag between the corresponding tracker and video frames. Default is 2 seconds */
   void SetMaximumMovingLagSec(double maxLagSec);
 
+  /*!
+    Sets the method that is used for computing the alignment metric for all the time offsets. Default is CORRELATION_ENGINE_BRUTE_FORCE.
+    The brute-force engine performs a coarse and a fine search. The FFT engine computes the metric at all offsets with sampling
+    resolution in O(n log n) time and refines the best offset by sub-sample interpolation. The FFT engine normalizes the fixed signal
+    over its whole time range, while the brute-force engine normalizes it in the overlap window of each offset, therefore
+    the two engines may give slightly different time offsets.
+  */
+  void SetCorrelationEngine(CORRELATION_ENGINE engine);
+  CORRELATION_ENGINE GetCorrelationEngine() const;
+
   /*! Enable/disable saving of intermediate images for debugging. Need to call before SetVideoFrames. */
   void SetSaveIntermediateImages(bool saveIntermediateImages);
 
@@ -138,6 +154,9 @@ public:
   PlusStatus GetBestCorrelation(double& videoCorrelation);
   PlusStatus GetMaxCalibrationError(double& maxCalibrationError);
 
+  /*! Returns the time [s] that was spent on computing the alignment metric and finding the best time offset in the last Update() */
+  PlusStatus GetCorrelationComputationTimeSec(double& computationTimeSec);
+
 protected:
   PlusStatus ComputeMovingSignalLagSec(TEMPORAL_CALIBRATION_ERROR& error);
   PlusStatus ComputePositionSignalValues(SignalType& signal);
@@ -150,6 +169,12 @@ protected:
   PlusStatus NormalizeMetricValues(std::deque<double>& signal, double& normalizationFactor, double startTime, double stopTime, const std::deque<double>& timestamps);
   void ComputeCorrelationBetweenFixedAndMovingSignal(double minTrackerLagSec, double maxTrackerLagSec, double stepSizeSec, double& bestCorrelationValue, double& bestCorrelationTimeOffset, double& bestCorrelationNormalizationFactor, std::deque<double>& corrTimeOffsets, std::deque<double>& corrValues);
 
+  /*! Find the best time offset with both sign conventions by a coarse and a fine search, resampling the moving signal at each tested offset */
+  PlusStatus ComputeBestCorrelationBruteForce(double imageFramePeriodSec, TEMPORAL_CALIBRATION_ERROR& error);
+
+  /*! Find the best time offset with both sign conventions from the FFT-based cross-correlation of the uniformly resampled signals */
+  PlusStatus ComputeBestCorrelationFft(double imageFramePeriodSec, TEMPORAL_CALIBRATION_ERROR& error);
+
   double ComputeAlignmentMetric(const std::deque<double>& signalA, const std::deque<double>& signalB);
 
   PlusStatus ConstructTableSignal(std::deque<double>& x, std::deque<double>& y, vtkTable* table, double timeCorrection);
@@ -173,6 +198,12 @@ protected:
   /*! Resolution used for re-sampling [s]*/
   double SamplingResolutionSec;
 
+  /*! Method used for computing the alignment metric for all the time offsets */
+  CORRELATION_ENGINE CorrelationEngine;
+
+  /*! Time [s] spent on computing the alignment metric in the last update */
+  double CorrelationComputationTimeSec;
+
   /*! The computed signal correlation values (corresponding to the better sign convention) */
   std::deque<double> CorrelationValues;
   /*! The time-offsets used to compute the correlations */
@@ -0,0 +1,328 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+#include "PlusConfigure.h"
+#include "PlusFrameCodec.h"
+#include "vtk_zlib.h"
+
+#include <algorithm>
+#include <string.h>
+
+namespace
+{
+  //----------------------------------------------------------------------------
+  /*!
+    LZ4 block format (https://github.com/lz4/lz4/blob/dev/doc/lz4_Block_format.md), compatible with LZ4_decompress_safe.
+    Each sequence consists of a token (literal length and match length), literals, and a match (2-byte offset).
+  */
+  class PlusLz4FrameCodec : public PlusFrameCodec
+  {
+  public:
+    PlusLz4FrameCodec()
+      : HashTable(HASH_TABLE_SIZE, 0)
+    {
+    }
+
+    virtual std::string GetName() const
+    {
+      return "LZ4";
+    }
+
+    virtual PlusStatus Encode(const unsigned char* data, unsigned int dataSize, std::vector<unsigned char>& encodedData)
+    {
+      encodedData.resize(dataSize + dataSize / 255 + 16);
+      unsigned char* op = &encodedData[0];
+      unsigned int anchor = 0;
+
+      // The last match must start at least 12 bytes before the end and the last 5 bytes are always literals
+      if (dataSize >= MIN_INPUT_SIZE)
+      {
+        std::fill(this->HashTable.begin(), this->HashTable.end(), 0);
+        const unsigned int matchStartLimit = dataSize - MATCH_START_MARGIN;
+        const unsigned int matchEndLimit = dataSize - LAST_LITERALS;
+        unsigned int ip = 1;
+        while (ip <= matchStartLimit)
+        {
+          unsigned int sequence = Read32(data + ip);
+          unsigned int& hashEntry = this->HashTable[Hash(sequence)];
+          unsigned int ref = hashEntry;
+          hashEntry = ip;
+          if (ref >= ip || ip - ref > MAX_OFFSET || Read32(data + ref) != sequence)
+          {
+            // Skip faster in data that does not compress well
+            ip += 1 + ((ip - anchor) >> SKIP_STRENGTH);
+            continue;
+          }
+
+          // Extend the match backward and forward
+          while (ip > anchor && ref > 0 && data[ip - 1] == data[ref - 1])
+          {
+            ip--;
+            ref--;
+          }
+          unsigned int matchLength = MIN_MATCH;
+          while (ip + matchLength < matchEndLimit && data[ip + matchLength] == data[ref + matchLength])
+          {
+            matchLength++;
+          }
+
+          op = WriteSequence(op, data + anchor, ip - anchor, ip - ref, matchLength);
+          ip += matchLength;
+          anchor = ip;
+          if (ip <= matchStartLimit)
+          {
+            this->HashTable[Hash(Read32(data + ip - 2))] = ip - 2;
+          }
+        }
+      }
+
+      // Last literals
+      op = WriteLength(op, dataSize - anchor, 0);
+      memcpy(op, data + anchor, dataSize - anchor);
+      op += dataSize - anchor;
+
+      encodedData.resize(op - &encodedData[0]);
+      return PLUS_SUCCESS;
+    }
+
+    virtual PlusStatus Decode(const unsigned char* encodedData, unsigned int encodedDataSize, unsigned char* data, unsigned int dataSize)
+    {
+      unsigned int ip = 0;
+      unsigned int op = 0;
+      while (true)
+      {
+        if (ip >= encodedDataSize)
+        {
+          LOG_ERROR("LZ4 decoding failed: unexpected end of data");
+          return PLUS_FAIL;
+        }
+        unsigned char token = encodedData[ip++];
+
+        unsigned int literalLength = token >> 4;
+        if (ReadLength(encodedData, encodedDataSize, ip, literalLength) != PLUS_SUCCESS
+            || literalLength > encodedDataSize - ip || literalLength > dataSize - op)
+        {
+          LOG_ERROR("LZ4 decoding failed: invalid literal length");
+          return PLUS_FAIL;
+        }
+        memcpy(data + op, encodedData + ip, literalLength);
+        ip += literalLength;
+        op += literalLength;
+        if (ip == encodedDataSize)
+        {
+          // The last sequence contains only literals
+          break;
+        }
+
+        if (encodedDataSize - ip < 2)
+        {
+          LOG_ERROR("LZ4 decoding failed: unexpected end of data");
+          return PLUS_FAIL;
+        }
+        unsigned int offset = encodedData[ip] | (encodedData[ip + 1] << 8);
+        ip += 2;
+        unsigned int matchLength = token & 0x0f;
+        if (offset == 0 || offset > op || ReadLength(encodedData, encodedDataSize, ip, matchLength) != PLUS_SUCCESS
+            || matchLength + MIN_MATCH > dataSize - op)
+        {
+          LOG_ERROR("LZ4 decoding failed: invalid match");
+          return PLUS_FAIL;
+        }
+        matchLength += MIN_MATCH;
+
+        const unsigned char* matchSource = data + op - offset;
+        if (offset >= matchLength)
+        {
+          memcpy(data + op, matchSource, matchLength);
+        }
+        else
+        {
+          // Overlapping copy repeats the last offset bytes
+          for (unsigned int i = 0; i < matchLength; ++i)
+          {
+            data[op + i] = matchSource[i];
+          }
+        }
+        op += matchLength;
+      }
+
+      if (op != dataSize)
+      {
+        LOG_ERROR("LZ4 decoding failed: decoded " << op << " bytes, expected " << dataSize);
+        return PLUS_FAIL;
+      }
+      return PLUS_SUCCESS;
+    }
+
+  protected:
+    static const unsigned int MIN_MATCH = 4;
+    static const unsigned int LAST_LITERALS = 5;
+    static const unsigned int MATCH_START_MARGIN = 12;
+    static const unsigned int MIN_INPUT_SIZE = 13;
+    static const unsigned int MAX_OFFSET = 65535;
+    static const unsigned int HASH_LOG = 12;
+    static const unsigned int HASH_TABLE_SIZE = 1 << HASH_LOG;
+    static const unsigned int SKIP_STRENGTH = 6;
+
+    static unsigned int Read32(const unsigned char* p)
+    {
+      unsigned int value;
+      memcpy(&value, p, sizeof(value));
+      return value;
+    }
+
+    static unsigned int Hash(unsigned int sequence)
+    {
+      return (sequence * 2654435761U) >> (32 - HASH_LOG);
+    }
+
+    /*! Write a token with the specified literal length and match length code, followed by the extra literal length bytes */
+    static unsigned char* WriteLength(unsigned char* op, unsigned int length, unsigned char matchLengthToken)
+    {
+      if (length >= 15)
+      {
+        *op++ = static_cast<unsigned char>(0xf0 | matchLengthToken);
+        for (length -= 15; length >= 255; length -= 255)
+        {
+          *op++ = 255;
+        }
+        *op++ = static_cast<unsigned char>(length);
+      }
+      else
+      {
+        *op++ = static_cast<unsigned char>((length << 4) | matchLengthToken);
+      }
+      return op;
+    }
+
+    static unsigned char* WriteSequence(unsigned char* op, const unsigned char* literals, unsigned int literalLength, unsigned int offset, unsigned int matchLength)
+    {
+      unsigned int matchLengthCode = matchLength - MIN_MATCH;
+      op = WriteLength(op, literalLength, static_cast<unsigned char>(matchLengthCode >= 15 ? 15 : matchLengthCode));
+      memcpy(op, literals, literalLength);
+      op += literalLength;
+      *op++ = static_cast<unsigned char>(offset & 0xff);
+      *op++ = static_cast<unsigned char>(offset >> 8);
+      if (matchLengthCode >= 15)
+      {
+        for (matchLengthCode -= 15; matchLengthCode >= 255; matchLengthCode -= 255)
+        {
+          *op++ = 255;
+        }
+        *op++ = static_cast<unsigned char>(matchLengthCode);
+      }
+      return op;
+    }
+
+    static PlusStatus ReadLength(const unsigned char* encodedData, unsigned int encodedDataSize, unsigned int& ip, unsigned int& length)
+    {
+      if (length != 15)
+      {
+        return PLUS_SUCCESS;
+      }
+      unsigned char extraLength = 255;
+      while (extraLength == 255)
+      {
+        if (ip >= encodedDataSize || length > 0x7fffffff)
+        {
+          return PLUS_FAIL;
+        }
+        extraLength = encodedData[ip++];
+        length += extraLength;
+      }
+      return PLUS_SUCCESS;
+    }
+
+    std::vector<unsigned int> HashTable;
+  };
+
+  //----------------------------------------------------------------------------
+  /*! zlib compression of each frame */
+  class PlusDeflateFrameCodec : public PlusFrameCodec
+  {
+  public:
+    virtual std::string GetName() const
+    {
+      return "Deflate";
+    }
+
+    virtual PlusStatus Encode(const unsigned char* data, unsigned int dataSize, std::vector<unsigned char>& encodedData)
+    {
+      uLongf encodedDataSize = compressBound(dataSize);
+      encodedData.resize(encodedDataSize);
+      int ret = compress2(&encodedData[0], &encodedDataSize, data, dataSize, Z_DEFAULT_COMPRESSION);
+      if (ret != Z_OK)
+      {
+        LOG_ERROR("Image compression failed (errorCode=" << ret << ")");
+        return PLUS_FAIL;
+      }
+      encodedData.resize(encodedDataSize);
+      return PLUS_SUCCESS;
+    }
+
+    virtual PlusStatus Decode(const unsigned char* encodedData, unsigned int encodedDataSize, unsigned char* data, unsigned int dataSize)
+    {
+      uLongf decodedDataSize = dataSize;
+      int ret = uncompress(data, &decodedDataSize, encodedData, encodedDataSize);
+      if (ret != Z_OK || decodedDataSize != dataSize)
+      {
+        LOG_ERROR("Image decompression failed (errorCode=" << ret << ", decompressed " << decodedDataSize << " bytes, expected " << dataSize << ")");
+        return PLUS_FAIL;
+      }
+      return PLUS_SUCCESS;
+    }
+  };
+}
+
+//----------------------------------------------------------------------------
+PlusFrameCodec::PlusFrameCodec()
+{
+}
+
+//----------------------------------------------------------------------------
+PlusFrameCodec::~PlusFrameCodec()
+{
+}
+
+//----------------------------------------------------------------------------
+PlusFrameCodec* PlusFrameCodec::CreateCodec(const std::string& codecName)
+{
+  if (PlusCommon::IsEqualInsensitive(codecName, "LZ4"))
+  {
+    return new PlusLz4FrameCodec;
+  }
+  if (PlusCommon::IsEqualInsensitive(codecName, "Deflate"))
+  {
+    return new PlusDeflateFrameCodec;
+  }
+  return NULL;
+}
+
+//----------------------------------------------------------------------------
+void PlusFrameCodec::GetCodecNames(std::vector<std::string>& codecNames)
+{
+  codecNames.clear();
+  codecNames.push_back("LZ4");
+  codecNames.push_back("Deflate");
+}
+
+//----------------------------------------------------------------------------
+void PlusFrameCodec::ApplyFrameDelta(const unsigned char* frame, const unsigned char* previousFrame, unsigned int frameSize, unsigned char* delta)
+{
+  for (unsigned int i = 0; i < frameSize; ++i)
+  {
+    delta[i] = static_cast<unsigned char>(frame[i] - previousFrame[i]);
+  }
+}
+
+//----------------------------------------------------------------------------
+void PlusFrameCodec::RevertFrameDelta(unsigned char* deltaToFrame, const unsigned char* previousFrame, unsigned int frameSize)
+{
+  for (unsigned int i = 0; i < frameSize; ++i)
+  {
+    deltaToFrame[i] = static_cast<unsigned char>(deltaToFrame[i] + previousFrame[i]);
+  }
+}
@@ -0,0 +1,66 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+#ifndef __PlusFrameCodec_h
+#define __PlusFrameCodec_h
+
+#include "PlusCommon.h"
+#include "vtkPlusCommonExport.h"
+
+#include <string>
+#include <vector>
+
+/*!
+  \class PlusFrameCodec
+  \brief Lossless compression of frames of pixel data
+
+  Each frame is compressed into an independent block, so frames can be written and read one by one.
+  Available codecs:
+  - LZ4: very fast compression and decompression at a lower compression ratio (LZ4 block format)
+  - Deflate: same compression as zlib, but each frame is compressed separately
+
+  Consecutive ultrasound frames are usually very similar, therefore compressing the difference
+  between consecutive frames (see ApplyFrameDelta) often improves the compression ratio.
+
+  New codecs can be added by deriving from this class and registering them in CreateCodec and GetCodecNames.
+
+  \ingroup PlusLibCommon
+*/
+class vtkPlusCommonExport PlusFrameCodec
+{
+public:
+  virtual ~PlusFrameCodec();
+
+  /*! Name of the codec, as stored in the sequence file header */
+  virtual std::string GetName() const = 0;
+
+  /*! Compress dataSize bytes of data. The compressed data replaces the content of encodedData. */
+  virtual PlusStatus Encode(const unsigned char* data, unsigned int dataSize, std::vector<unsigned char>& encodedData) = 0;
+
+  /*! Decompress encoded data. Fails if the data cannot be decompressed into exactly dataSize bytes. */
+  virtual PlusStatus Decode(const unsigned char* encodedData, unsigned int encodedDataSize, unsigned char* data, unsigned int dataSize) = 0;
+
+  /*! Create a codec by name (case insensitive). Returns NULL if there is no codec with the specified name. The caller owns the returned object. */
+  static PlusFrameCodec* CreateCodec(const std::string& codecName);
+
+  /*! Get the names of all the available codecs */
+  static void GetCodecNames(std::vector<std::string>& codecNames);
+
+  /*! Compute the byte-wise difference (modulo 256) between a frame and the previous frame. The result can be written into the input frame. */
+  static void ApplyFrameDelta(const unsigned char* frame, const unsigned char* previousFrame, unsigned int frameSize, unsigned char* delta);
+
+  /*! Restore a frame from the byte-wise difference to the previous frame, in place */
+  static void RevertFrameDelta(unsigned char* deltaToFrame, const unsigned char* previousFrame, unsigned int frameSize);
+
+protected:
+  PlusFrameCodec();
+
+private:
+  PlusFrameCodec(const PlusFrameCodec&);  // Not implemented.
+  void operator=(const PlusFrameCodec&);  // Not implemented.
+};
+
+#endif
@@ -7,8 +7,10 @@ See License.txt for details.
 #include "PlusConfigure.h"
 #include "itksys/SystemTools.hxx"
 #include "vtkPlusMetaImageSequenceIO.h"
+#include <algorithm>
 #include <iomanip>
 #include <iostream>
+#include <limits>
 #include <vector>
 
 #ifdef _WIN32
@@ -59,6 +61,9 @@ namespace
   static const char* SEQMETA_FIELD_KINDS = "Kinds";
   static const char* SEQMETA_FIELD_COMPRESSED_DATA_SIZE = "CompressedDataSize";
 
+  // Size of the adler32 checksum at the end of each zlib stream
+  static const unsigned int ZLIB_TRAILER_SIZE = 4;
+
   static std::string SEQMETA_FIELD_FRAME_FIELD_PREFIX = "Seq_Frame";
   static std::string SEQMETA_FIELD_IMG_STATUS = "ImageStatus";
 }
@@ -72,12 +77,18 @@ vtkPlusMetaImageSequenceIO::vtkPlusMetaImageSequenceIO()
   : vtkPlusSequenceIOBase()
   , IsPixelDataBinary(true)
   , Output2DDataWithZDimensionIncluded(false)
+  , DecompressionStreamActive(false)
+  , DecompressionStreamRawDeflate(false)
+  , CompressedBytesRemaining(0)
 {
 }
 
 //----------------------------------------------------------------------------
 vtkPlusMetaImageSequenceIO::~vtkPlusMetaImageSequenceIO()
 {
+  // The read-ahead thread reads from the pixel data stream, so it has to be stopped before the stream is closed
+  this->StopReadAhead();
+  this->CloseImagePixelStream();
 }
 
 //----------------------------------------------------------------------------
@@ -284,6 +295,10 @@ PlusStatus vtkPlusMetaImageSequenceIO::ReadImageHeader()
     {
       SetUseCompression(false);
     }
+    if (this->ReadCompressionCodecHeaderField() != PLUS_SUCCESS)
+    {
+      return PLUS_FAIL;
+    }
 
     if (this->TrackedFrameList->GetCustomString("ElementNumberOfChannels") != NULL)
     {
@@ -333,158 +348,194 @@ PlusStatus vtkPlusMetaImageSequenceIO::ReadImageHeader()
 }
 
 //----------------------------------------------------------------------------
-// Read the spacing and dimensions of the image.
-PlusStatus vtkPlusMetaImageSequenceIO::ReadImagePixels()
+PlusStatus vtkPlusMetaImageSequenceIO::OpenImagePixelStream()
 {
-  int frameCount = this->Dimensions[3];
-  unsigned int frameSizeInBytes = 0;
-  if (this->Dimensions[0] > 0 && this->Dimensions[1] > 0 && this->Dimensions[2] > 0)
+  if (Superclass::OpenImagePixelStream() != PLUS_SUCCESS)
   {
-    frameSizeInBytes = this->Dimensions[0] * this->Dimensions[1] * this->Dimensions[2] * PlusVideoFrame::GetNumberOfBytesPerScalar(this->PixelType) * this->NumberOfScalarComponents;
+    return PLUS_FAIL;
   }
-
-  if (frameSizeInBytes == 0)
+  if (!this->UseCompression || this->FrameCodec != NULL)
   {
-    LOG_DEBUG("No image data in the metafile");
+    // Uncompressed and codec compressed pixel data is read by the superclass
     return PLUS_SUCCESS;
   }
 
-  int numberOfErrors = 0;
-
-  FILE* stream = NULL;
+  // If the compressed data size is not specified then the compressed data is read until the end of the file
+  this->CompressedBytesRemaining = 0;
+  std::istringstream compressedDataSizeStream(this->TrackedFrameList->GetCustomString(std::string(SEQMETA_FIELD_COMPRESSED_DATA_SIZE)));
+  compressedDataSizeStream >> this->CompressedBytesRemaining;
+  if (this->CompressedBytesRemaining == 0)
+  {
+    this->CompressedBytesRemaining = std::numeric_limits<unsigned long long>::max();
+  }
 
-  if (FileOpen(&stream, GetPixelDataFilePath().c_str(), "rb") != PLUS_SUCCESS)
+  this->DecompressionStream.next_in = Z_NULL;
+  this->DecompressionStream.avail_in = 0;
+  if (this->InitDecompressionStream(false) != PLUS_SUCCESS)
   {
-    LOG_ERROR("The file " << GetPixelDataFilePath() << " could not be opened for reading");
+    Superclass::CloseImagePixelStream();
     return PLUS_FAIL;
   }
+  this->CompressedPixelBuffer.resize(Z_BUFSIZE);
+  return PLUS_SUCCESS;
+}
 
-  std::vector<unsigned char> allFramesPixelBuffer;
-  if (this->UseCompression)
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusMetaImageSequenceIO::InitDecompressionStream(bool rawDeflate)
+{
+  if (this->DecompressionStreamActive)
   {
-    unsigned int allFramesPixelBufferSize = frameCount * frameSizeInBytes;
-
-    try
-    {
-      allFramesPixelBuffer.resize(allFramesPixelBufferSize);
-    }
-    catch (std::bad_alloc& e)
-    {
-      cerr << e.what() << endl;
-      LOG_ERROR("vtkPlusMetaImageSequenceIO::ReadImagePixels failed due to out of memory. Try to reduce image buffer sizes or use a 64-bit build of Plus.");
-      return PLUS_FAIL;
-    }
+    inflateEnd(&this->DecompressionStream);
+    this->DecompressionStreamActive = false;
+  }
 
-    unsigned int allFramesCompressedPixelBufferSize = 0;
-    PlusCommon::StringToInt(this->TrackedFrameList->GetCustomString(SEQMETA_FIELD_COMPRESSED_DATA_SIZE), allFramesCompressedPixelBufferSize);
-    std::vector<unsigned char> allFramesCompressedPixelBuffer;
-    allFramesCompressedPixelBuffer.resize(allFramesCompressedPixelBufferSize);
+  this->DecompressionStream.zalloc = Z_NULL;
+  this->DecompressionStream.zfree = Z_NULL;
+  this->DecompressionStream.opaque = Z_NULL;
+  // negative window bits means raw deflate data
+  int ret = inflateInit2(&this->DecompressionStream, rawDeflate ? -MAX_WBITS : MAX_WBITS);
+  if (ret != Z_OK)
+  {
+    LOG_ERROR("Image decompression initialization failed (errorCode=" << ret << ")");
+    return PLUS_FAIL;
+  }
+  this->DecompressionStreamActive = true;
+  this->DecompressionStreamRawDeflate = rawDeflate;
+  return PLUS_SUCCESS;
+}
 
-    FSEEK(stream, this->PixelDataFileOffset, SEEK_SET);
-    if (fread(&(allFramesCompressedPixelBuffer[0]), 1, allFramesCompressedPixelBufferSize, stream) != allFramesCompressedPixelBufferSize)
-    {
-      LOG_ERROR("Could not read " << allFramesCompressedPixelBufferSize << " bytes from " << GetPixelDataFilePath());
-      fclose(stream);
-      return PLUS_FAIL;
-    }
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusMetaImageSequenceIO::ReadCompressedPixelChunk()
+{
+  size_t bytesToRead = this->CompressedPixelBuffer.size();
+  if (this->CompressedBytesRemaining < bytesToRead)
+  {
+    bytesToRead = static_cast<size_t>(this->CompressedBytesRemaining);
+  }
+  size_t bytesRead = (bytesToRead > 0 ? fread(&(this->CompressedPixelBuffer[0]), 1, bytesToRead, this->InputImageFileHandle) : 0);
+  if (bytesRead == 0)
+  {
+    LOG_ERROR("Cannot uncompress the pixel data: uncompressed data is less than expected");
+    return PLUS_FAIL;
+  }
+  this->CompressedBytesRemaining -= bytesRead;
+  this->DecompressionStream.next_in = (Bytef*) & (this->CompressedPixelBuffer[0]);
+  this->DecompressionStream.avail_in = bytesRead;
+  return PLUS_SUCCESS;
+}
 
-    uLongf unCompSize = allFramesPixelBufferSize;
-    if (uncompress((Bytef*) & (allFramesPixelBuffer[0]), &unCompSize, (const Bytef*) & (allFramesCompressedPixelBuffer[0]), allFramesCompressedPixelBufferSize) != Z_OK)
-    {
-      LOG_ERROR("Cannot uncompress the pixel data");
-      fclose(stream);
-      return PLUS_FAIL;
-    }
-    if (unCompSize != allFramesPixelBufferSize)
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusMetaImageSequenceIO::SkipCompressedBytes(unsigned int numberOfBytes)
+{
+  while (numberOfBytes > 0)
+  {
+    if (this->DecompressionStream.avail_in == 0 && this->ReadCompressedPixelChunk() != PLUS_SUCCESS)
     {
-      LOG_ERROR("Cannot uncompress the pixel data: uncompressed data is less than expected");
-      fclose(stream);
       return PLUS_FAIL;
     }
-
+    unsigned int skippedBytes = std::min(numberOfBytes, static_cast<unsigned int>(this->DecompressionStream.avail_in));
+    this->DecompressionStream.next_in += skippedBytes;
+    this->DecompressionStream.avail_in -= skippedBytes;
+    numberOfBytes -= skippedBytes;
   }
+  return PLUS_SUCCESS;
+}
 
-  std::vector<unsigned char> pixelBuffer;
-  pixelBuffer.resize(frameSizeInBytes);
-  for (int frameNumber = 0; frameNumber < frameCount; frameNumber++)
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusMetaImageSequenceIO::ReadNextFramePixels(unsigned char* pixelBuffer, unsigned int frameSizeInBytes)
+{
+  if (!this->UseCompression || this->FrameCodec != NULL)
   {
-    CreateTrackedFrameIfNonExisting(frameNumber);
-    PlusTrackedFrame* trackedFrame = this->TrackedFrameList->GetTrackedFrame(frameNumber);
-
-    // Allocate frame only if it is valid
-    const char* imgStatus = trackedFrame->GetCustomFrameField(SEQMETA_FIELD_IMG_STATUS.c_str());
-    if (imgStatus != NULL)    // Found the image status field
-    {
-      // Save status field
-      std::string strImgStatus(imgStatus);
-
-      // Delete image status field from tracked frame
-      // Image status can be determine by trackedFrame->GetImageData()->IsImageValid()
-      trackedFrame->DeleteCustomFrameField(SEQMETA_FIELD_IMG_STATUS.c_str());
-
-      if (STRCASECMP(strImgStatus.c_str(), "OK") != 0)     // Image status _not_ OK
-      {
-        LOG_DEBUG("Frame #" << frameNumber << " image data is invalid, no need to allocate data in the tracked frame list.");
-        continue;
-      }
-    }
-
-    trackedFrame->GetImageData()->SetImageOrientation(this->ImageOrientationInMemory);
-    trackedFrame->GetImageData()->SetImageType(this->ImageType);
-
-    if (trackedFrame->GetImageData()->AllocateFrame(this->Dimensions, this->PixelType, this->NumberOfScalarComponents) != PLUS_SUCCESS)
-    {
-      LOG_ERROR("Cannot allocate memory for frame " << frameNumber);
-      numberOfErrors++;
-      continue;
-    }
-
-    int clipRectOrigin[3] = {PlusCommon::NO_CLIP, PlusCommon::NO_CLIP, PlusCommon::NO_CLIP};
-    int clipRectSize[3] = {PlusCommon::NO_CLIP, PlusCommon::NO_CLIP, PlusCommon::NO_CLIP};
+    return Superclass::ReadNextFramePixels(pixelBuffer, frameSizeInBytes);
+  }
+  if (!this->DecompressionStreamActive)
+  {
+    LOG_ERROR("Pixel data decompression stream is not open");
+    return PLUS_FAIL;
+  }
 
-    PlusVideoFrame::FlipInfoType flipInfo;
-    if (PlusVideoFrame::GetFlipAxes(this->ImageOrientationInFile, this->ImageType, this->ImageOrientationInMemory, flipInfo) != PLUS_SUCCESS)
+  this->DecompressionStream.next_out = (Bytef*)pixelBuffer;
+  this->DecompressionStream.avail_out = frameSizeInBytes;
+  while (this->DecompressionStream.avail_out > 0)
+  {
+    // Read the next chunk of compressed data
+    if (this->DecompressionStream.avail_in == 0 && this->ReadCompressedPixelChunk() != PLUS_SUCCESS)
     {
-      LOG_ERROR("Failed to convert image data to the requested orientation, from " << PlusVideoFrame::GetStringFromUsImageOrientation(this->ImageOrientationInFile) <<
-                " to " << PlusVideoFrame::GetStringFromUsImageOrientation(this->ImageOrientationInMemory));
       return PLUS_FAIL;
     }
 
-    if (!this->UseCompression)
+    int ret = inflate(&this->DecompressionStream, Z_NO_FLUSH);
+    if (ret == Z_STREAM_END)
     {
-      FilePositionOffsetType offset = PixelDataFileOffset + frameNumber * frameSizeInBytes;
-      FSEEK(stream, offset, SEEK_SET);
-      if (fread(&(pixelBuffer[0]), 1, frameSizeInBytes, stream) != frameSizeInBytes)
+      // Files that are written in multiple chunks may contain multiple concatenated compressed streams
+      if (this->DecompressionStreamRawDeflate)
       {
-        //LOG_ERROR("Could not read "<<frameSizeInBytes<<" bytes from "<<GetPixelDataFilePath());
-        //numberOfErrors++;
+        // The zlib trailer is not processed when decompressing raw deflate data, so it has to be skipped
+        if (this->SkipCompressedBytes(ZLIB_TRAILER_SIZE) != PLUS_SUCCESS || this->InitDecompressionStream(false) != PLUS_SUCCESS)
+        {
+          LOG_ERROR("Cannot uncompress the pixel data: failed to reset decompression stream");
+          return PLUS_FAIL;
+        }
       }
-      if (PlusVideoFrame::GetOrientedClippedImage(&(pixelBuffer[0]), flipInfo, this->ImageType, this->PixelType, this->NumberOfScalarComponents, this->Dimensions, *trackedFrame->GetImageData(), clipRectOrigin, clipRectSize) != PLUS_SUCCESS)
+      else if (inflateReset(&this->DecompressionStream) != Z_OK)
       {
-        LOG_ERROR("Failed to get oriented image from sequence metafile (frame number: " << frameNumber << ")!");
-        numberOfErrors++;
-        continue;
+        LOG_ERROR("Cannot uncompress the pixel data: failed to reset decompression stream");
+        return PLUS_FAIL;
       }
+      continue;
     }
-    else
+    if (ret != Z_OK && ret != Z_BUF_ERROR)
     {
-      if (PlusVideoFrame::GetOrientedClippedImage(&(allFramesPixelBuffer[0]) + frameNumber * frameSizeInBytes, flipInfo, this->ImageType, this->PixelType, this->NumberOfScalarComponents, this->Dimensions, *trackedFrame->GetImageData(), clipRectOrigin, clipRectSize) != PLUS_SUCCESS)
-      {
-        LOG_ERROR("Failed to get oriented image from sequence metafile (frame number: " << frameNumber << ")!");
-        numberOfErrors++;
-        continue;
-      }
+      LOG_ERROR("Cannot uncompress the pixel data (errorCode=" << ret << ")");
+      return PLUS_FAIL;
     }
   }
 
-  fclose(stream);
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusMetaImageSequenceIO::CloseImagePixelStream()
+{
+  if (this->DecompressionStreamActive)
+  {
+    inflateEnd(&this->DecompressionStream);
+    this->DecompressionStreamActive = false;
+  }
+  std::vector<unsigned char>().swap(this->CompressedPixelBuffer);
+  Superclass::CloseImagePixelStream();
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusMetaImageSequenceIO::SeekImagePixelStream(unsigned int frameNumber)
+{
+  if (!this->UseCompression || this->FrameCodec != NULL || !this->IsFrameIndexAvailable())
+  {
+    return Superclass::SeekImagePixelStream(frameNumber);
+  }
+  if (this->InputImageFileHandle == NULL || !this->DecompressionStreamActive)
+  {
+    LOG_ERROR("Pixel data decompression stream is not open");
+    return PLUS_FAIL;
+  }
 
-  if (numberOfErrors > 0)
+  // Compressed data of each frame starts with an independent deflate block
+  unsigned long long frameOffset = this->FrameIndexOffsets[frameNumber];
+  if (FSEEK(this->InputImageFileHandle, this->PixelDataFileOffset + frameOffset, SEEK_SET) != 0)
   {
+    LOG_ERROR("Failed to seek to the compressed data of frame " << frameNumber << " in " << this->GetPixelDataFilePath());
     return PLUS_FAIL;
   }
+  this->CompressedBytesRemaining = this->FrameIndexPixelDataSize - frameOffset;
+  this->DecompressionStream.next_in = Z_NULL;
+  this->DecompressionStream.avail_in = 0;
+  return this->InitDecompressionStream(true);
+}
 
-  return PLUS_SUCCESS;
+//----------------------------------------------------------------------------
+std::string vtkPlusMetaImageSequenceIO::GetImageStatusFieldName() const
+{
+  return SEQMETA_FIELD_IMG_STATUS;
 }
 
 //----------------------------------------------------------------------------
@@ -623,6 +674,7 @@ PlusStatus vtkPlusMetaImageSequenceIO::WriteInitialImageHeader()
     SetCustomString("CompressedData", "False");
     SetCustomString(SEQMETA_FIELD_COMPRESSED_DATA_SIZE, (const char*)(NULL));
   }
+  this->WriteCompressionCodecHeaderField();
 
   unsigned int frameSize[3] = {0, 0, 0};
   if (this->EnableImageDataWrite)
@@ -922,13 +974,15 @@ PlusStatus vtkPlusMetaImageSequenceIO::FinalizeHeader()
 //----------------------------------------------------------------------------
 PlusStatus vtkPlusMetaImageSequenceIO::WriteCompressedImagePixelsToFile(int& compressedDataSize)
 {
+  if (this->CompressionThreadCount != 1 && this->TrackedFrameList->GetNumberOfTrackedFrames() > 1)
+  {
+    return this->WriteCompressedImagePixelsToFileParallel(compressedDataSize, false);
+  }
+
   LOG_DEBUG("Writing compressed pixel data into file started");
 
   compressedDataSize = 0;
 
-  const int outputBufferSize = 16384; // can be any number, just picked a value from a zlib example
-  unsigned char outputBuffer[outputBufferSize];
-
   z_stream strm; // stream describing the compression state
 
   // use the default memory allocation routines
@@ -975,40 +1029,28 @@ PlusStatus vtkPlusMetaImageSequenceIO::WriteCompressedImagePixelsToFile(int& com
       }
     }
 
-    strm.next_in = (Bytef*)videoFrame->GetScalarPointer();
-    strm.avail_in = videoFrame->GetFrameSizeInBytes();
-
-    // Note: it's possible to request to consume all inputs and delete all history after each frame writing to allow random access
-    int flush = (frameNumber < this->TrackedFrameList->GetNumberOfTrackedFrames() - 1) ? Z_NO_FLUSH : Z_FINISH;
-
-    // run deflate() on input until output buffer not full, finish
-    // compression if all of source has been read in
-    do
+    if (this->WriteFrameIndex)
     {
-      strm.avail_out = outputBufferSize;
-      strm.next_out = outputBuffer;
-
-      ret = deflate(&strm, flush);    /* no bad return value */
-      if (ret == Z_STREAM_ERROR)
+      // Write all pending output and reset the compression history, so that decompression can start at this frame
+      strm.next_in = Z_NULL;
+      strm.avail_in = 0;
+      if (this->DeflateToFile(strm, Z_FULL_FLUSH, compressedDataSize) != PLUS_SUCCESS)
       {
-        // state clobbered
-        LOG_ERROR("Zlib state became invalid during the compression process (errorCode=" << ret << ")");
         deflateEnd(&strm);   // clean up
         return PLUS_FAIL;
       }
+      this->FrameIndexOffsets.push_back(this->CompressedBytesWritten + compressedDataSize);
+    }
 
-      size_t numberOfBytesReadyForWriting = outputBufferSize - strm.avail_out;
-      size_t numberOfBytesWritten = 0;
-      if (PlusCommon::RobustFwrite(this->OutputImageFileHandle, outputBuffer, numberOfBytesReadyForWriting, numberOfBytesWritten) != PLUS_SUCCESS)
-      {
-        LOG_ERROR("Error writing compressed data into file");
-        deflateEnd(&strm);   // clean up
-        return PLUS_FAIL;
-      }
-      compressedDataSize += numberOfBytesWritten;
+    strm.next_in = (Bytef*)videoFrame->GetScalarPointer();
+    strm.avail_in = videoFrame->GetFrameSizeInBytes();
 
+    int flush = (frameNumber < this->TrackedFrameList->GetNumberOfTrackedFrames() - 1) ? Z_NO_FLUSH : Z_FINISH;
+    if (this->DeflateToFile(strm, flush, compressedDataSize) != PLUS_SUCCESS)
+    {
+      deflateEnd(&strm);   // clean up
+      return PLUS_FAIL;
     }
-    while (strm.avail_out == 0);
 
     if (strm.avail_in != 0)
     {
@@ -1023,7 +1065,44 @@ PlusStatus vtkPlusMetaImageSequenceIO::WriteCompressedImagePixelsToFile(int& com
 
   LOG_DEBUG("Writing compressed pixel data into file completed");
 
-  if (ret != Z_STREAM_END)
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusMetaImageSequenceIO::DeflateToFile(z_stream& strm, int flush, int& compressedDataSize)
+{
+  const int outputBufferSize = 16384; // can be any number, just picked a value from a zlib example
+  unsigned char outputBuffer[outputBufferSize];
+
+  // run deflate() on input until output buffer not full, finish
+  // compression if all of source has been read in
+  int ret = Z_OK;
+  do
+  {
+    strm.avail_out = outputBufferSize;
+    strm.next_out = outputBuffer;
+
+    ret = deflate(&strm, flush);    /* no bad return value */
+    if (ret == Z_STREAM_ERROR)
+    {
+      // state clobbered
+      LOG_ERROR("Zlib state became invalid during the compression process (errorCode=" << ret << ")");
+      return PLUS_FAIL;
+    }
+
+    size_t numberOfBytesReadyForWriting = outputBufferSize - strm.avail_out;
+    size_t numberOfBytesWritten = 0;
+    if (PlusCommon::RobustFwrite(this->OutputImageFileHandle, outputBuffer, numberOfBytesReadyForWriting, numberOfBytesWritten) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Error writing compressed data into file");
+      return PLUS_FAIL;
+    }
+    compressedDataSize += numberOfBytesWritten;
+
+  }
+  while (strm.avail_out == 0);
+
+  if (flush == Z_FINISH && ret != Z_STREAM_END)
   {
     LOG_ERROR("Error occurred during compressing image data into file");
     return PLUS_FAIL;
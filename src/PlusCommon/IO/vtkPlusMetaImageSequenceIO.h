@@ -81,8 +81,32 @@ protected:
   /*! Read all the fields in the metaimage file header */
   virtual PlusStatus ReadImageHeader();
 
-  /*! Read pixel data from the metaimage */
-  virtual PlusStatus ReadImagePixels();
+  /*! Open the pixel data file and initialize decompression of the pixel data */
+  virtual PlusStatus OpenImagePixelStream();
+
+  /*! Read the pixels of the next frame, compressed pixel data is inflated in chunks */
+  virtual PlusStatus ReadNextFramePixels(unsigned char* pixelBuffer, unsigned int frameSizeInBytes);
+
+  /*! Close the pixel data file and release the decompression stream */
+  virtual void CloseImagePixelStream();
+
+  /*! Position the pixel data stream to the beginning of a frame, using the frame index if available */
+  virtual PlusStatus SeekImagePixelStream(unsigned int frameNumber);
+
+  /*!
+    Initialize the decompression stream. Raw deflate data (without zlib header) is decompressed after seeking
+    to a frame using the frame index. Input data that is already in the stream is preserved.
+  */
+  PlusStatus InitDecompressionStream(bool rawDeflate);
+
+  /*! Read the next chunk of compressed pixel data into the decompression stream input buffer */
+  PlusStatus ReadCompressedPixelChunk();
+
+  /*! Skip bytes in the compressed pixel data */
+  PlusStatus SkipCompressedBytes(unsigned int numberOfBytes);
+
+  /*! Name of the custom frame field that indicates if the image data of the frame is valid */
+  virtual std::string GetImageStatusFieldName() const;
 
   /*! Prepare the image file for writing */
   virtual PlusStatus PrepareImageFile();
@@ -98,6 +122,9 @@ protected:
   */
   virtual PlusStatus WriteCompressedImagePixelsToFile(int& compressedDataSize);
 
+  /*! Run deflate with the specified flush mode until all the input is consumed and write the output into the pixel data file */
+  PlusStatus DeflateToFile(z_stream& strm, int flush, int& compressedDataSize);
+
   /*! Conversion between ITK and METAIO pixel types */
   PlusStatus ConvertMetaElementTypeToVtkPixelType(const std::string& elementTypeStr, PlusCommon::VTKScalarPixelType& vtkPixelType);
   /*! Conversion between ITK and METAIO pixel types */
@@ -110,6 +137,16 @@ private:
   bool Output2DDataWithZDimensionIncluded;
   /*! compression stream handle for compression streaming */
   z_stream CompressionStream;
+  /*! decompression stream handle for reading compressed pixel data frame by frame */
+  z_stream DecompressionStream;
+  /*! True if DecompressionStream is initialized */
+  bool DecompressionStreamActive;
+  /*! True if DecompressionStream decompresses raw deflate data (after seeking using the frame index) */
+  bool DecompressionStreamRawDeflate;
+  /*! Chunk of compressed pixel data that is being decompressed */
+  std::vector<unsigned char> CompressedPixelBuffer;
+  /*! Number of compressed bytes that have not been read from the file yet */
+  unsigned long long CompressedBytesRemaining;
 
 protected:
   vtkPlusMetaImageSequenceIO(const vtkPlusMetaImageSequenceIO&); //purposely not implemented
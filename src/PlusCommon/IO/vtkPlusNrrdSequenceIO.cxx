@@ -5,9 +5,11 @@ See License.txt for details.
 =========================================================Plus=header=end*/
 
 #include "PlusConfigure.h"
+#include "PlusFrameCodec.h"
 #include "itksys/SystemTools.hxx"
 #include "vtkNrrdReader.h"
 #include "vtkPlusNrrdSequenceIO.h"
+#include <algorithm>
 #include <iomanip>
 #include <iostream>
 #include <sys/stat.h>
@@ -25,10 +27,6 @@ See License.txt for details.
 #include "vtkPlusTrackedFrameList.h"
 #include "vtksys/SystemTools.hxx"
 
-#if defined(_WIN32)
-  #include <io.h>
-#endif
-
 namespace
 {
 
@@ -44,6 +42,9 @@ namespace
   static std::string SEQUENCE_FIELD_FRAME_FIELD_PREFIX = "Seq_Frame";
   static std::string SEQUENCE_FIELD_IMG_STATUS = "Status";
 
+  // Size of the CRC32 and uncompressed size fields at the end of each gzip member
+  static const unsigned int GZIP_TRAILER_SIZE = 8;
+
 }
 
 //----------------------------------------------------------------------------
@@ -55,12 +56,17 @@ vtkPlusNrrdSequenceIO::vtkPlusNrrdSequenceIO()
   : vtkPlusSequenceIOBase()
   , Encoding(NRRD_ENCODING_RAW)
   , CompressionStream(NULL)
+  , DecompressionStreamActive(false)
+  , DecompressionStreamRawDeflate(false)
 {
 }
 
 //----------------------------------------------------------------------------
 vtkPlusNrrdSequenceIO::~vtkPlusNrrdSequenceIO()
 {
+  // The read-ahead thread reads from the pixel data stream, so it has to be stopped before the stream is closed
+  this->StopReadAhead();
+  this->CloseImagePixelStream();
 }
 
 //----------------------------------------------------------------------------
@@ -326,6 +332,12 @@ PlusStatus vtkPlusNrrdSequenceIO::ReadImageHeader()
       }
     }
 
+    // Codec compressed pixel data is read by the superclass, the encoding field contains the codec name
+    if (this->ReadCompressionCodecHeaderField() != PLUS_SUCCESS)
+    {
+      return PLUS_FAIL;
+    }
+
     if (this->TrackedFrameList->GetCustomString("encoding") != NULL)
     {
       // set fields according to encoding
@@ -353,174 +365,174 @@ PlusStatus vtkPlusNrrdSequenceIO::ReadImageHeader()
 }
 
 //----------------------------------------------------------------------------
-// Read the spacing and dimensions of the image.
-PlusStatus vtkPlusNrrdSequenceIO::ReadImagePixels()
+PlusStatus vtkPlusNrrdSequenceIO::OpenImagePixelStream()
 {
-  int frameCount = this->Dimensions[3];
-  unsigned int frameSizeInBytes = 0;
-  if (this->Dimensions[0] > 0 && this->Dimensions[1] > 0 && this->Dimensions[2] > 0)
+  if (Superclass::OpenImagePixelStream() != PLUS_SUCCESS)
   {
-    frameSizeInBytes = this->Dimensions[0] * this->Dimensions[1] * this->Dimensions[2] * PlusVideoFrame::GetNumberOfBytesPerScalar(this->PixelType) * this->NumberOfScalarComponents;
+    return PLUS_FAIL;
   }
-
-  if (frameSizeInBytes == 0)
+  if (!this->UseCompression || this->Encoding < NRRD_ENCODING_GZ || this->Encoding >= NRRD_ENCODING_BZ2)
   {
-    LOG_DEBUG("No image data in the file");
     return PLUS_SUCCESS;
   }
 
-  int numberOfErrors = 0;
-
-  FILE* stream = NULL;
-  gzFile gzStream = NULL;
-
-  if (this->UseCompression && this->Encoding >= NRRD_ENCODING_GZ && this->Encoding < NRRD_ENCODING_BZ2)
+  this->DecompressionStream.next_in = Z_NULL;
+  this->DecompressionStream.avail_in = 0;
+  if (this->InitDecompressionStream(false) != PLUS_SUCCESS)
   {
-    if (FileOpen(&stream, this->GetPixelDataFilePath().c_str(), "rb") != PLUS_SUCCESS)
-    {
-      LOG_ERROR("The file " << this->GetPixelDataFilePath() << " could not be opened for reading");
-      fclose(stream);
-      return PLUS_FAIL;
-    }
-
-#if _WIN32
-    int fd = _fileno(stream);
-    int dupFd = _dup(fd);
-    _lseek(dupFd, this->PixelDataFileOffset, SEEK_SET);
-#else
-    int fd = fileno(stream);
-    int dupFd = dup(fd);
-    lseek(dupFd, this->PixelDataFileOffset, SEEK_SET);
-#endif
-
-    gzStream = gzdopen(dupFd, "rb");
-
-    if (gzStream == NULL)
-    {
-      LOG_ERROR("Unable to open gz stream.");
-      fclose(stream);
-      return PLUS_FAIL;
-    }
+    Superclass::CloseImagePixelStream();
+    return PLUS_FAIL;
   }
-  else
+  this->CompressedPixelBuffer.resize(Z_BUFSIZE);
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusNrrdSequenceIO::InitDecompressionStream(bool rawDeflate)
+{
+  if (this->DecompressionStreamActive)
   {
-    if (FileOpen(&stream, this->GetPixelDataFilePath().c_str(), "rb") != PLUS_SUCCESS)
-    {
-      LOG_ERROR("The file " << this->GetPixelDataFilePath() << " could not be opened for reading");
-      return PLUS_FAIL;
-    }
+    inflateEnd(&this->DecompressionStream);
+    this->DecompressionStreamActive = false;
   }
 
-  std::vector<unsigned char> allFramesPixelBuffer;
-  unsigned char* gzAllFramesPixelBuffer;
-  if (this->UseCompression && this->Encoding >= NRRD_ENCODING_GZ && this->Encoding < NRRD_ENCODING_BZ2)
+  this->DecompressionStream.zalloc = Z_NULL;
+  this->DecompressionStream.zfree = Z_NULL;
+  this->DecompressionStream.opaque = Z_NULL;
+  // negative window bits means raw deflate data, +32 enables automatic gzip/zlib header detection
+  int ret = inflateInit2(&this->DecompressionStream, rawDeflate ? -MAX_WBITS : MAX_WBITS + 32);
+  if (ret != Z_OK)
   {
-    //gzip uncompression
-    unsigned int allFramesPixelBufferSize = frameCount * frameSizeInBytes;
-    gzAllFramesPixelBuffer = new unsigned char[allFramesPixelBufferSize];
+    LOG_ERROR("Image decompression initialization failed (errorCode=" << ret << ")");
+    return PLUS_FAIL;
+  }
+  this->DecompressionStreamActive = true;
+  this->DecompressionStreamRawDeflate = rawDeflate;
+  return PLUS_SUCCESS;
+}
 
-    vtkPlusNrrdSequenceIO::FilePositionOffsetType allFramesCompressedPixelBufferSize = vtkPlusNrrdSequenceIO::GetFileSize(this->GetPixelDataFilePath()) - this->PixelDataFileOffset;
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusNrrdSequenceIO::ReadCompressedPixelChunk()
+{
+  size_t bytesRead = fread(&(this->CompressedPixelBuffer[0]), 1, this->CompressedPixelBuffer.size(), this->InputImageFileHandle);
+  if (bytesRead == 0)
+  {
+    LOG_ERROR("Cannot uncompress the pixel data: uncompressed data is less than expected");
+    return PLUS_FAIL;
+  }
+  this->DecompressionStream.next_in = (Bytef*) & (this->CompressedPixelBuffer[0]);
+  this->DecompressionStream.avail_in = bytesRead;
+  return PLUS_SUCCESS;
+}
 
-    if (gzread(gzStream, (void*)gzAllFramesPixelBuffer, allFramesPixelBufferSize) != allFramesPixelBufferSize)
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusNrrdSequenceIO::SkipCompressedBytes(unsigned int numberOfBytes)
+{
+  while (numberOfBytes > 0)
+  {
+    if (this->DecompressionStream.avail_in == 0 && this->ReadCompressedPixelChunk() != PLUS_SUCCESS)
     {
-      LOG_ERROR("Could not uncompress " << allFramesCompressedPixelBufferSize << " bytes to " << allFramesPixelBufferSize << " bytes from " << GetPixelDataFilePath());
-      gzclose(gzStream);
       return PLUS_FAIL;
     }
-    gzclose(gzStream);
+    unsigned int skippedBytes = std::min(numberOfBytes, static_cast<unsigned int>(this->DecompressionStream.avail_in));
+    this->DecompressionStream.next_in += skippedBytes;
+    this->DecompressionStream.avail_in -= skippedBytes;
+    numberOfBytes -= skippedBytes;
   }
+  return PLUS_SUCCESS;
+}
 
-  std::vector<unsigned char> pixelBuffer;
-  pixelBuffer.resize(frameSizeInBytes);
-  for (int frameNumber = 0; frameNumber < frameCount; frameNumber++)
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusNrrdSequenceIO::ReadNextFramePixels(unsigned char* pixelBuffer, unsigned int frameSizeInBytes)
+{
+  if (!this->DecompressionStreamActive)
   {
-    this->CreateTrackedFrameIfNonExisting(frameNumber);
-    PlusTrackedFrame* trackedFrame = this->TrackedFrameList->GetTrackedFrame(frameNumber);
-
-    // Allocate frame only if it is valid
-    const char* imgStatus = trackedFrame->GetCustomFrameField(SEQUENCE_FIELD_IMG_STATUS.c_str());
-    if (imgStatus != NULL)    // Found the image status field
-    {
-      // Save status field
-      std::string strImgStatus(imgStatus);
-
-      // Delete image status field from tracked frame
-      // Image status can be determine by trackedFrame->GetImageData()->IsImageValid()
-      trackedFrame->DeleteCustomFrameField(SEQUENCE_FIELD_IMG_STATUS.c_str());
-
-      if (!PlusCommon::IsEqualInsensitive(strImgStatus, "OK"))     // Image status _not_ OK
-      {
-        LOG_DEBUG("Frame #" << frameNumber << " image data is invalid, no need to allocate data in the tracked frame list.");
-        // TODO : is this right? don't we lose tool info from these dropped frames?
-        continue;
-      }
-    }
-
-    trackedFrame->GetImageData()->SetImageOrientation(this->ImageOrientationInMemory);
-    trackedFrame->GetImageData()->SetImageType(this->ImageType);
-
-    if (trackedFrame->GetImageData()->AllocateFrame(this->Dimensions, this->PixelType, this->NumberOfScalarComponents) != PLUS_SUCCESS)
-    {
-      LOG_ERROR("Cannot allocate memory for frame " << frameNumber);
-      numberOfErrors++;
-      continue;
-    }
-
-    int clipRectOrigin[3] = {PlusCommon::NO_CLIP, PlusCommon::NO_CLIP, PlusCommon::NO_CLIP};
-    int clipRectSize[3] = {PlusCommon::NO_CLIP, PlusCommon::NO_CLIP, PlusCommon::NO_CLIP};
+    return Superclass::ReadNextFramePixels(pixelBuffer, frameSizeInBytes);
+  }
 
-    PlusVideoFrame::FlipInfoType flipInfo;
-    if (PlusVideoFrame::GetFlipAxes(this->ImageOrientationInFile, this->ImageType, this->ImageOrientationInMemory, flipInfo) != PLUS_SUCCESS)
+  this->DecompressionStream.next_out = (Bytef*)pixelBuffer;
+  this->DecompressionStream.avail_out = frameSizeInBytes;
+  while (this->DecompressionStream.avail_out > 0)
+  {
+    // Read the next chunk of compressed data
+    if (this->DecompressionStream.avail_in == 0 && this->ReadCompressedPixelChunk() != PLUS_SUCCESS)
     {
-      LOG_ERROR("Failed to convert image data to the requested orientation, from " << PlusVideoFrame::GetStringFromUsImageOrientation(this->ImageOrientationInFile) <<
-                " to " << PlusVideoFrame::GetStringFromUsImageOrientation(this->ImageOrientationInMemory));
+      LOG_ERROR("Could not uncompress " << frameSizeInBytes << " bytes from " << this->GetPixelDataFilePath());
       return PLUS_FAIL;
     }
 
-    if (!this->UseCompression)
+    int ret = inflate(&this->DecompressionStream, Z_NO_FLUSH);
+    if (ret == Z_STREAM_END)
     {
-      FilePositionOffsetType offset = this->PixelDataFileOffset + frameNumber * frameSizeInBytes;
-      FSEEK(stream, offset, SEEK_SET);
-      if (fread(&(pixelBuffer[0]), 1, frameSizeInBytes, stream) != frameSizeInBytes)
+      // A gzip file may contain multiple concatenated members
+      if (this->DecompressionStreamRawDeflate)
       {
-        //LOG_ERROR("Could not read "<<frameSizeInBytes<<" bytes from "<<GetPixelDataFilePath());
-        //numberOfErrors++;
+        // The gzip trailer is not processed when decompressing raw deflate data, so it has to be skipped
+        if (this->SkipCompressedBytes(GZIP_TRAILER_SIZE) != PLUS_SUCCESS || this->InitDecompressionStream(false) != PLUS_SUCCESS)
+        {
+          LOG_ERROR("Cannot uncompress the pixel data: failed to reset decompression stream");
+          return PLUS_FAIL;
+        }
       }
-      if (PlusVideoFrame::GetOrientedClippedImage(&(pixelBuffer[0]), flipInfo, this->ImageType, this->PixelType, this->NumberOfScalarComponents, this->Dimensions, *trackedFrame->GetImageData(), clipRectOrigin, clipRectSize) != PLUS_SUCCESS)
+      else if (inflateReset(&this->DecompressionStream) != Z_OK)
       {
-        LOG_ERROR("Failed to get oriented image from sequence file (frame number: " << frameNumber << ")!");
-        numberOfErrors++;
-        continue;
+        LOG_ERROR("Cannot uncompress the pixel data: failed to reset decompression stream");
+        return PLUS_FAIL;
       }
+      continue;
     }
-    else
+    if (ret != Z_OK && ret != Z_BUF_ERROR)
     {
-      if (PlusVideoFrame::GetOrientedClippedImage(gzAllFramesPixelBuffer + frameNumber * frameSizeInBytes, flipInfo, this->ImageType, this->PixelType, this->NumberOfScalarComponents, this->Dimensions, *trackedFrame->GetImageData(), clipRectOrigin, clipRectSize) != PLUS_SUCCESS)
-      {
-        LOG_ERROR("Failed to get oriented image from sequence file (frame number: " << frameNumber << ")!");
-        numberOfErrors++;
-        continue;
-      }
+      LOG_ERROR("Cannot uncompress the pixel data (errorCode=" << ret << ")");
+      return PLUS_FAIL;
     }
   }
 
-  if (!this->UseCompression)
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusNrrdSequenceIO::CloseImagePixelStream()
+{
+  if (this->DecompressionStreamActive)
+  {
+    inflateEnd(&this->DecompressionStream);
+    this->DecompressionStreamActive = false;
+  }
+  std::vector<unsigned char>().swap(this->CompressedPixelBuffer);
+  Superclass::CloseImagePixelStream();
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusNrrdSequenceIO::SeekImagePixelStream(unsigned int frameNumber)
+{
+  if (!this->DecompressionStreamActive || !this->IsFrameIndexAvailable())
   {
-    fclose(stream);
+    return Superclass::SeekImagePixelStream(frameNumber);
   }
 
-  if (numberOfErrors > 0)
+  // Compressed data of each frame starts with an independent deflate block
+  unsigned long long frameOffset = this->FrameIndexOffsets[frameNumber];
+  if (FSEEK(this->InputImageFileHandle, this->PixelDataFileOffset + frameOffset, SEEK_SET) != 0)
   {
+    LOG_ERROR("Failed to seek to the compressed data of frame " << frameNumber << " in " << this->GetPixelDataFilePath());
     return PLUS_FAIL;
   }
+  this->DecompressionStream.next_in = Z_NULL;
+  this->DecompressionStream.avail_in = 0;
+  return this->InitDecompressionStream(true);
+}
 
-  return PLUS_SUCCESS;
+//----------------------------------------------------------------------------
+std::string vtkPlusNrrdSequenceIO::GetImageStatusFieldName() const
+{
+  return SEQUENCE_FIELD_IMG_STATUS;
 }
 
 //----------------------------------------------------------------------------
 PlusStatus vtkPlusNrrdSequenceIO::PrepareImageFile()
 {
-  if (this->GetUseCompression())
+  if (this->GetUseCompression() && this->CompressionThreadCount == 1 && this->FrameCodec == NULL)
   {
     this->CompressionStream = gzopen(this->TempImageFileName.c_str(), "ab");
 
@@ -592,7 +604,16 @@ PlusStatus vtkPlusNrrdSequenceIO::WriteInitialImageHeader()
   SetCustomString("dimension", this->NumberOfDimensions);
 
   // CompressedData
-  SetCustomString("encoding", GetUseCompression() ? "gz" : "raw");
+  if (GetUseCompression() && this->FrameCodec != NULL)
+  {
+    // Not a standard nrrd encoding, so that other readers do not try to interpret the pixel data
+    SetCustomString("encoding", vtksys::SystemTools::LowerCase(this->FrameCodec->GetName()));
+  }
+  else
+  {
+    SetCustomString("encoding", GetUseCompression() ? "gz" : "raw");
+  }
+  this->WriteCompressionCodecHeaderField();
 
   unsigned int frameSize[3] = {0, 0, 0};
   if (this->EnableImageDataWrite)
@@ -847,13 +868,15 @@ PlusStatus vtkPlusNrrdSequenceIO::FinalizeHeader()
 //----------------------------------------------------------------------------
 PlusStatus vtkPlusNrrdSequenceIO::Close()
 {
-  if (this->GetUseCompression())
+  if (this->CompressionStream != NULL)
   {
     gzclose(this->CompressionStream);
+    this->CompressionStream = NULL;
   }
-  else
+  else if (this->OutputImageFileHandle != NULL)
   {
     fclose(this->OutputImageFileHandle);
+    this->OutputImageFileHandle = NULL;
   }
 
   return Superclass::Close();
@@ -862,6 +885,12 @@ PlusStatus vtkPlusNrrdSequenceIO::Close()
 //----------------------------------------------------------------------------
 PlusStatus vtkPlusNrrdSequenceIO::WriteCompressedImagePixelsToFile(int& compressedDataSize)
 {
+  if (this->CompressionStream == NULL)
+  {
+    // Pixel data file is opened without the gzip stream if the frames are compressed on multiple threads
+    return this->WriteCompressedImagePixelsToFileParallel(compressedDataSize, true);
+  }
+
   LOG_DEBUG("Writing compressed pixel data into file started");
 
   compressedDataSize = 0;
@@ -899,6 +928,18 @@ PlusStatus vtkPlusNrrdSequenceIO::WriteCompressedImagePixelsToFile(int& compress
       }
     }
 
+    if (this->WriteFrameIndex)
+    {
+      // Write all pending output and reset the compression history, so that decompression can start at this frame
+      if (gzflush(this->CompressionStream, Z_FULL_FLUSH) != Z_OK)
+      {
+        LOG_ERROR("Error flushing compressed data into file");
+        gzclose(this->CompressionStream);
+        return PLUS_FAIL;
+      }
+      this->FrameIndexOffsets.push_back(gzoffset(this->CompressionStream));
+    }
+
     size_t numberOfBytesReadyForWriting = videoFrame->GetFrameSizeInBytes();
     if (gzwrite(this->CompressionStream, (Bytef*)videoFrame->GetScalarPointer(), numberOfBytesReadyForWriting) != numberOfBytesReadyForWriting)
     {
@@ -1275,7 +1316,11 @@ PlusStatus vtkPlusNrrdSequenceIO::SetFileName(const std::string& aFilename)
   else if (STRCASECMP(fileExt.c_str(), ".nhdr") == 0)
   {
     std::string pixFileName = vtksys::SystemTools::GetFilenameWithoutExtension(this->FileName);
-    if (this->UseCompression)
+    if (this->UseCompression && this->FrameCodec != NULL)
+    {
+      pixFileName += ".raw." + vtksys::SystemTools::LowerCase(this->FrameCodec->GetName());
+    }
+    else if (this->UseCompression)
     {
       pixFileName += ".raw.gz";
     }
@@ -93,8 +93,32 @@ protected:
   /*! Read all the fields in the image file header */
   virtual PlusStatus ReadImageHeader();
 
-  /*! Read pixel data from the image */
-  virtual PlusStatus ReadImagePixels();
+  /*! Open the pixel data file, gzip compressed pixel data is decompressed while it is read */
+  virtual PlusStatus OpenImagePixelStream();
+
+  /*! Read the pixels of the next frame from the pixel data stream */
+  virtual PlusStatus ReadNextFramePixels( unsigned char* pixelBuffer, unsigned int frameSizeInBytes );
+
+  /*! Close the pixel data stream */
+  virtual void CloseImagePixelStream();
+
+  /*! Position the pixel data stream to the beginning of a frame, using the frame index if available */
+  virtual PlusStatus SeekImagePixelStream( unsigned int frameNumber );
+
+  /*!
+    Initialize the decompression stream. Raw deflate data (without gzip header) is decompressed after seeking
+    to a frame using the frame index. Input data that is already in the stream is preserved.
+  */
+  PlusStatus InitDecompressionStream( bool rawDeflate );
+
+  /*! Read the next chunk of compressed pixel data into the decompression stream input buffer */
+  PlusStatus ReadCompressedPixelChunk();
+
+  /*! Skip bytes in the compressed pixel data */
+  PlusStatus SkipCompressedBytes( unsigned int numberOfBytes );
+
+  /*! Name of the custom frame field that indicates if the image data of the frame is valid */
+  virtual std::string GetImageStatusFieldName() const;
 
   /*! Prepare the image file for writing */
   virtual PlusStatus PrepareImageFile();
@@ -130,6 +154,15 @@ protected:
   /*! file handle for the compression stream */
   gzFile CompressionStream;
 
+  /*! decompression stream handle for reading compressed pixel data frame by frame */
+  z_stream DecompressionStream;
+  /*! True if DecompressionStream is initialized */
+  bool DecompressionStreamActive;
+  /*! True if DecompressionStream decompresses raw deflate data (after seeking using the frame index) */
+  bool DecompressionStreamRawDeflate;
+  /*! Chunk of compressed pixel data that is being decompressed */
+  std::vector<unsigned char> CompressedPixelBuffer;
+
 private:
   vtkPlusNrrdSequenceIO( const vtkPlusNrrdSequenceIO& ); //purposely not implemented
   void operator=( const vtkPlusNrrdSequenceIO& ); //purposely not implemented
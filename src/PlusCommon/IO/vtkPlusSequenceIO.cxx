@@ -99,3 +99,36 @@ vtkPlusSequenceIOBase* vtkPlusSequenceIO::CreateSequenceHandlerForFile(const std
   LOG_ERROR("No writer for file: " << filename);
   return NULL;
 }
+
+//----------------------------------------------------------------------------
+vtkPlusSequenceIOBase* vtkPlusSequenceIO::CreateSequenceReaderForFile(const std::string& filename)
+{
+  if( !vtksys::SystemTools::FileExists(filename.c_str()) )
+  {
+    LOG_ERROR("File: " << filename << " does not exist.");
+    return NULL;
+  }
+
+  vtkPlusSequenceIOBase* reader = NULL;
+  if( vtkPlusMetaImageSequenceIO::CanReadFile(filename) )
+  {
+    reader = vtkPlusMetaImageSequenceIO::New();
+  }
+  else if( vtkPlusNrrdSequenceIO::CanReadFile(filename) )
+  {
+    reader = vtkPlusNrrdSequenceIO::New();
+  }
+  else
+  {
+    LOG_ERROR("No reader for file: " << filename);
+    return NULL;
+  }
+
+  if( reader->SetFileName(filename) != PLUS_SUCCESS )
+  {
+    LOG_ERROR("Failed to set sequence file name: " << filename);
+    reader->Delete();
+    return NULL;
+  }
+  return reader;
+}
@@ -31,6 +31,9 @@ public:
   /*! Create a handler for a given filetype */
   static vtkPlusSequenceIOBase* CreateSequenceHandlerForFile(const std::string& filename);
 
+  /*! Create a reader for an existing file. The file format is determined from the file contents. Frames can be read one by one using vtkPlusSequenceIOBase::StartFrameByFrameReading. */
+  static vtkPlusSequenceIOBase* CreateSequenceReaderForFile(const std::string& filename);
+
 protected:
   vtkPlusSequenceIO();
   virtual ~vtkPlusSequenceIO();
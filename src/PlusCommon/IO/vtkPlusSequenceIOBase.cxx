@@ -5,82 +5,1010 @@ See License.txt for details.
 =========================================================Plus=header=end*/
 
 #include "PlusConfigure.h"
+#include "PlusFrameCodec.h"
+#include "vtkMultiThreader.h"
 #include "vtkObjectFactory.h"
 #include "vtkPlusSequenceIOBase.h"
 #include "vtkPlusTrackedFrameList.h"
+#include "vtk_zlib.h"
 #include "vtksys/SystemTools.hxx"
 #include "PlusTrackedFrame.h"
 
+#ifdef _WIN32
+  #define FSEEK _fseeki64
+  #define FTELL _ftelli64
+#else
+  #define FSEEK fseek
+  #define FTELL ftell
+#endif
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <thread>
+
 #if _WIN32
 #include <errno.h>
 
-#if defined(_MSC_PLATFORM_TOOLSET_v120) || defined(_MSC_PLATFORM_TOOLSET_v140)
-// Version helpers is only available in Windows SDK 8.1 (v120) or newer
-#include <VersionHelpers.h>
-#endif
+#if defined(_MSC_PLATFORM_TOOLSET_v120) || defined(_MSC_PLATFORM_TOOLSET_v140)
+// Version helpers is only available in Windows SDK 8.1 (v120) or newer
+#include <VersionHelpers.h>
+#endif
+
+#endif
+
+namespace
+{
+  static const char* FRAME_INDEX_FILE_EXTENSION = ".idx";
+  static const char* FRAME_INDEX_FILE_SIGNATURE = "PlusSequenceFrameIndex 1";
+  static const char* FRAME_INDEX_FIELD_PIXEL_DATA_SIZE = "PixelDataSize";
+  static const char* FRAME_INDEX_FIELD_NUMBER_OF_FRAMES = "NumberOfFrames";
+
+  // Deflate, 32K window, default compression level
+  static const unsigned char ZLIB_HEADER[] = { 0x78, 0x9c };
+  // Deflate, no optional fields, no modification time, unknown operating system
+  static const unsigned char GZIP_HEADER[] = { 0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff };
+  static const unsigned int DEFLATE_DICTIONARY_SIZE = 32768;
+
+  static const char* SEQUENCE_FIELD_COMPRESSION_CODEC = "CompressionCodec";
+  // Frame type (key frame or difference to the previous frame) and compressed size of the frame in little-endian order
+  static const unsigned int CODEC_BLOCK_HEADER_SIZE = 5;
+  static const unsigned char CODEC_KEY_FRAME = 0;
+  static const unsigned char CODEC_DELTA_FRAME = 1;
+  // If a frame index is written then decoding of a frame requires decoding of at most this many frames
+  static const unsigned int CODEC_KEY_FRAME_INTERVAL = 16;
+
+  struct ParallelCompressionInfoStruct
+  {
+    std::vector<unsigned char*> FramePixels;
+    std::vector<unsigned int> FrameSizes;
+    bool UsePreviousFrameAsDictionary;
+    bool GzipFormat;
+    std::vector< std::vector<unsigned char> > CompressedFrames;
+    std::vector<uLong> FrameChecksums;
+    std::vector<PlusStatus> FrameStatus;
+  };
+
+  //----------------------------------------------------------------------------
+  PlusStatus CompressFrame( ParallelCompressionInfoStruct& str, unsigned int frameNumber )
+  {
+    z_stream strm;
+    strm.zalloc = Z_NULL;
+    strm.zfree = Z_NULL;
+    strm.opaque = Z_NULL;
+    // Raw deflate, the stream header and trailer are written when the compressed frames are concatenated
+    int ret = deflateInit2( &strm, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY );
+    if ( ret != Z_OK )
+    {
+      LOG_ERROR( "Image compression initialization failed (errorCode=" << ret << ")" );
+      return PLUS_FAIL;
+    }
+
+    unsigned char* pixels = str.FramePixels[frameNumber];
+    unsigned int frameSize = str.FrameSizes[frameNumber];
+    if ( str.UsePreviousFrameAsDictionary && frameNumber > 0 )
+    {
+      // Allow references to the previous frame, as if the frames were compressed in a single stream
+      unsigned int dictionarySize = std::min( str.FrameSizes[frameNumber - 1], DEFLATE_DICTIONARY_SIZE );
+      deflateSetDictionary( &strm, str.FramePixels[frameNumber - 1] + str.FrameSizes[frameNumber - 1] - dictionarySize, dictionarySize );
+    }
+
+    // Leave room for the empty block that is appended by the flush
+    std::vector<unsigned char>& compressedFrame = str.CompressedFrames[frameNumber];
+    compressedFrame.resize( deflateBound( &strm, frameSize ) + 16 );
+    strm.next_in = pixels;
+    strm.avail_in = frameSize;
+    strm.next_out = &compressedFrame[0];
+    strm.avail_out = compressedFrame.size();
+
+    // All frames except the last one end at a byte boundary, so that the compressed frames can be concatenated
+    bool lastFrame = ( frameNumber + 1 == str.FramePixels.size() );
+    ret = deflate( &strm, lastFrame ? Z_FINISH : Z_SYNC_FLUSH );
+    bool frameCompressed = ( ret == ( lastFrame ? Z_STREAM_END : Z_OK ) ) && strm.avail_in == 0 && strm.avail_out > 0;
+    compressedFrame.resize( compressedFrame.size() - strm.avail_out );
+    deflateEnd( &strm );
+    if ( !frameCompressed )
+    {
+      LOG_ERROR( "Failed to compress frame " << frameNumber << " (errorCode=" << ret << ")" );
+      return PLUS_FAIL;
+    }
+
+    str.FrameChecksums[frameNumber] = str.GzipFormat ? crc32( crc32( 0L, Z_NULL, 0 ), pixels, frameSize ) : adler32( adler32( 0L, Z_NULL, 0 ), pixels, frameSize );
+    return PLUS_SUCCESS;
+  }
+
+  //----------------------------------------------------------------------------
+  VTK_THREAD_RETURN_TYPE ParallelCompressionThreadFunction( void* arg )
+  {
+    vtkMultiThreader::ThreadInfo* threadInfo = static_cast<vtkMultiThreader::ThreadInfo*>( arg );
+    ParallelCompressionInfoStruct* str = static_cast<ParallelCompressionInfoStruct*>( threadInfo->UserData );
+    for ( unsigned int frameNumber = threadInfo->ThreadID; frameNumber < str->FramePixels.size(); frameNumber += threadInfo->NumberOfThreads )
+    {
+      str->FrameStatus[frameNumber] = CompressFrame( *str, frameNumber );
+    }
+    return VTK_THREAD_RETURN_VALUE;
+  }
+
+  struct CodecCompressionInfoStruct
+  {
+    std::string CodecName;
+    unsigned int FrameSize;
+    std::vector<const unsigned char*> FramePixels;
+    // Reference frame for computing the difference, NULL for key frames
+    std::vector<const unsigned char*> PreviousFramePixels;
+    std::vector< std::vector<unsigned char> > EncodedFrames;
+    std::vector<PlusStatus> FrameStatus;
+  };
+
+  //----------------------------------------------------------------------------
+  VTK_THREAD_RETURN_TYPE CodecCompressionThreadFunction( void* arg )
+  {
+    vtkMultiThreader::ThreadInfo* threadInfo = static_cast<vtkMultiThreader::ThreadInfo*>( arg );
+    CodecCompressionInfoStruct* str = static_cast<CodecCompressionInfoStruct*>( threadInfo->UserData );
+    // Codecs may keep state between frames, so each thread uses its own instance
+    PlusFrameCodec* codec = PlusFrameCodec::CreateCodec( str->CodecName );
+    std::vector<unsigned char> frameDelta;
+    for ( unsigned int frameNumber = threadInfo->ThreadID; codec != NULL && frameNumber < str->FramePixels.size(); frameNumber += threadInfo->NumberOfThreads )
+    {
+      const unsigned char* pixels = str->FramePixels[frameNumber];
+      if ( str->PreviousFramePixels[frameNumber] != NULL )
+      {
+        frameDelta.resize( str->FrameSize );
+        PlusFrameCodec::ApplyFrameDelta( pixels, str->PreviousFramePixels[frameNumber], str->FrameSize, &frameDelta[0] );
+        pixels = &frameDelta[0];
+      }
+      str->FrameStatus[frameNumber] = codec->Encode( pixels, str->FrameSize, str->EncodedFrames[frameNumber] );
+    }
+    delete codec;
+    return VTK_THREAD_RETURN_VALUE;
+  }
+
+  //----------------------------------------------------------------------------
+  PlusStatus ReadCodecBlockHeader( FILE* fileHandle, unsigned char& frameType, unsigned int& encodedFrameSize )
+  {
+    unsigned char header[CODEC_BLOCK_HEADER_SIZE];
+    if ( fread( header, 1, CODEC_BLOCK_HEADER_SIZE, fileHandle ) != CODEC_BLOCK_HEADER_SIZE )
+    {
+      return PLUS_FAIL;
+    }
+    frameType = header[0];
+    encodedFrameSize = header[1] | ( header[2] << 8 ) | ( header[3] << 16 ) | ( static_cast<unsigned int>( header[4] ) << 24 );
+    return PLUS_SUCCESS;
+  }
+
+  //----------------------------------------------------------------------------
+  PlusStatus WriteBytes( FILE* fileHandle, const unsigned char* data, size_t dataSize, int& compressedDataSize )
+  {
+    size_t writtenSize = 0;
+    if ( PlusCommon::RobustFwrite( fileHandle, const_cast<unsigned char*>( data ), dataSize, writtenSize ) != PLUS_SUCCESS )
+    {
+      LOG_ERROR( "Error writing compressed data into file" );
+      return PLUS_FAIL;
+    }
+    compressedDataSize += writtenSize;
+    return PLUS_SUCCESS;
+  }
+}
+
+//----------------------------------------------------------------------------
+class vtkPlusSequenceIOBase::vtkReadAheadInternal
+{
+public:
+  struct QueuedFrame
+  {
+    PlusTrackedFrame* Frame;
+    PlusStatus Status;
+  };
+
+  vtkReadAheadInternal()
+    : StopRequested( false )
+    , ReadingFinished( false )
+    , NextReturnedFrameNumber( 0 )
+  {
+  }
+
+  std::thread Thread;
+  std::mutex Mutex;
+  /*! Signaled by the read-ahead thread when a frame is added to the queue or all frames are read */
+  std::condition_variable FrameQueued;
+  /*! Signaled when a frame is removed from the queue or the thread is requested to stop */
+  std::condition_variable FrameTaken;
+  /*! Frames that are read but not returned by ReadNextFrame yet */
+  std::deque<QueuedFrame> Queue;
+  bool StopRequested;
+  /*! True if the read-ahead thread does not add more frames to the queue */
+  bool ReadingFinished;
+  /*! Index of the frame that is returned by the next ReadNextFrame call */
+  unsigned int NextReturnedFrameNumber;
+};
+
+//----------------------------------------------------------------------------
+
+vtkCxxSetObjectMacro( vtkPlusSequenceIOBase, TrackedFrameList, vtkPlusTrackedFrameList );
+
+//----------------------------------------------------------------------------
+vtkPlusSequenceIOBase::vtkPlusSequenceIOBase()
+  : TrackedFrameList( vtkPlusTrackedFrameList::New() )
+  , UseCompression( false )
+  , CompressedBytesWritten( 0 )
+  , EnableImageDataWrite( true )
+  , PixelType( VTK_VOID )
+  , NumberOfScalarComponents( 1 )
+  , IsDataTimeSeries(true)
+  , NumberOfDimensions( 4 )
+  , CurrentFrameOffset( 0 )
+  , TotalBytesWritten( 0 )
+  , ImageOrientationInFile( US_IMG_ORIENT_XX )
+  , ImageOrientationInMemory( US_IMG_ORIENT_XX )
+  , ImageType( US_IMG_TYPE_XX )
+  , PixelDataFileOffset( 0 )
+  , PixelDataFileName( "" )
+  , OutputImageFileHandle( NULL )
+  , InputImageFileHandle( NULL )
+  , FrameByFrameReadingActive( false )
+  , NextFrameNumber( 0 )
+  , CurrentFrame( NULL )
+  , WriteFrameIndex( false )
+  , FrameIndexPixelDataSize( 0 )
+  , CompressionThreadCount( 1 )
+  , FrameCodec( NULL )
+  , CompressionFrameDelta( false )
+  , ReadAheadFrameCount( 0 )
+  , ReadAhead( new vtkReadAheadInternal )
+{
+  this->Dimensions[0] = 1;
+  this->Dimensions[1] = 1;
+  this->Dimensions[2] = 1;
+  this->Dimensions[3] = 1;
+}
+
+//----------------------------------------------------------------------------
+vtkPlusSequenceIOBase::~vtkPlusSequenceIOBase()
+{
+  this->StopReadAhead();
+  delete this->ReadAhead;
+  this->ReadAhead = NULL;
+  if ( this->InputImageFileHandle != NULL )
+  {
+    fclose( this->InputImageFileHandle );
+    this->InputImageFileHandle = NULL;
+  }
+  delete this->CurrentFrame;
+  this->CurrentFrame = NULL;
+  delete this->FrameCodec;
+  this->FrameCodec = NULL;
+  if( this->TrackedFrameList != NULL )
+  {
+    this->SetTrackedFrameList( NULL );
+  }
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusSequenceIOBase::PrintSelf( ostream& os, vtkIndent indent )
+{
+  os << indent << "Frame List User Fields:" << std::endl;
+  this->TrackedFrameList->PrintSelf( os, indent );
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusSequenceIOBase::Read()
+{
+  this->TrackedFrameList->Clear();
+
+  if ( this->ReadImageHeader() != PLUS_SUCCESS )
+  {
+    LOG_ERROR( "Could not load header from file: " << this->FileName );
+    return PLUS_FAIL;
+  }
+
+  if ( this->ReadImagePixels() != PLUS_SUCCESS )
+  {
+    return PLUS_FAIL;
+  }
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusSequenceIOBase::StartFrameByFrameReading()
+{
+  this->StopFrameByFrameReading();
+  this->TrackedFrameList->Clear();
+
+  if ( this->ReadImageHeader() != PLUS_SUCCESS )
+  {
+    LOG_ERROR( "Could not load header from file: " << this->FileName );
+    return PLUS_FAIL;
+  }
+
+  unsigned int frameSizeInBytes = this->GetFrameSizeInBytes();
+  if ( frameSizeInBytes > 0 )
+  {
+    if ( this->Dimensions[3] > 0 )
+    {
+      this->CreateTrackedFrameIfNonExisting( this->Dimensions[3] - 1 );
+    }
+    if ( this->UseCompression )
+    {
+      // A missing or invalid index is not an error, the frames are just decompressed sequentially when seeking
+      this->ReadFrameIndexFile();
+    }
+    if ( this->OpenImagePixelStream() != PLUS_SUCCESS )
+    {
+      return PLUS_FAIL;
+    }
+    this->FramePixelBuffer.resize( frameSizeInBytes );
+  }
+
+  this->NextFrameNumber = 0;
+  this->FrameByFrameReadingActive = true;
+  if ( frameSizeInBytes > 0 && this->ReadAheadFrameCount > 0 )
+  {
+    this->StartReadAhead();
+  }
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusSequenceIOBase::ReadNextFrame( PlusTrackedFrame& trackedFrame )
+{
+  if ( !this->IsNextFrameAvailable() )
+  {
+    LOG_ERROR( "Cannot read next frame from " << this->FileName << ": " << ( this->FrameByFrameReadingActive ? "all frames have been read" : "frame-by-frame reading is not started" ) );
+    return PLUS_FAIL;
+  }
+
+  if ( !this->ReadAhead->Thread.joinable() )
+  {
+    return this->ReadNextFrameFromStream( trackedFrame );
+  }
+
+  vtkReadAheadInternal::QueuedFrame queuedFrame;
+  {
+    std::unique_lock<std::mutex> lock( this->ReadAhead->Mutex );
+    this->ReadAhead->FrameQueued.wait( lock, [this] { return !this->ReadAhead->Queue.empty() || this->ReadAhead->ReadingFinished; } );
+    if ( this->ReadAhead->Queue.empty() )
+    {
+      // The read-ahead thread stopped at a frame that it failed to read, which has already been returned
+      LOG_ERROR( "Failed to read frame " << this->ReadAhead->NextReturnedFrameNumber << " from " << this->FileName );
+      return PLUS_FAIL;
+    }
+    queuedFrame = this->ReadAhead->Queue.front();
+    this->ReadAhead->Queue.pop_front();
+    this->ReadAhead->NextReturnedFrameNumber++;
+  }
+  this->ReadAhead->FrameTaken.notify_one();
+
+  // The pixels are not copied, the returned frame takes over the image of the queued frame
+  trackedFrame.ShallowCopy( *queuedFrame.Frame );
+  delete queuedFrame.Frame;
+  return queuedFrame.Status;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusSequenceIOBase::ReadNextFrameFromStream( PlusTrackedFrame& trackedFrame )
+{
+  int frameNumber = this->NextFrameNumber;
+  this->NextFrameNumber++;
+
+  // The frame in the list contains only the header fields, so the image of the previous frame is released here
+  trackedFrame.ShallowCopy( *this->TrackedFrameList->GetTrackedFrame( frameNumber ) );
+
+  unsigned int frameSizeInBytes = this->GetFrameSizeInBytes();
+  if ( frameSizeInBytes == 0 )
+  {
+    // tracking data only
+    return PLUS_SUCCESS;
+  }
+
+  // Pixel data of invalid frames is stored in the file as well, so pixels have to be read for every frame
+  if ( this->ReadNextFramePixels( &( this->FramePixelBuffer[0] ), frameSizeInBytes ) != PLUS_SUCCESS )
+  {
+    LOG_ERROR( "Failed to read pixel data of frame " << frameNumber << " from " << this->GetPixelDataFilePath() );
+    return PLUS_FAIL;
+  }
+
+  return this->SetFrameImageFromFilePixels( trackedFrame, frameNumber, &( this->FramePixelBuffer[0] ) );
+}
+
+//----------------------------------------------------------------------------
+bool vtkPlusSequenceIOBase::IsNextFrameAvailable()
+{
+  if ( !this->FrameByFrameReadingActive )
+  {
+    return false;
+  }
+  if ( this->ReadAhead->Thread.joinable() )
+  {
+    std::lock_guard<std::mutex> lock( this->ReadAhead->Mutex );
+    return this->ReadAhead->NextReturnedFrameNumber < this->GetNumberOfFrames();
+  }
+  return this->NextFrameNumber < this->GetNumberOfFrames();
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusSequenceIOBase::StopFrameByFrameReading()
+{
+  if ( !this->FrameByFrameReadingActive )
+  {
+    return;
+  }
+  this->StopReadAhead();
+  this->CloseImagePixelStream();
+  std::vector<unsigned char>().swap( this->FramePixelBuffer );
+  this->FrameIndexOffsets.clear();
+  this->FrameIndexPixelDataSize = 0;
+  this->FrameByFrameReadingActive = false;
+}
+
+//----------------------------------------------------------------------------
+unsigned int vtkPlusSequenceIOBase::GetNumberOfFrames()
+{
+  return this->TrackedFrameList->GetNumberOfTrackedFrames();
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusSequenceIOBase::SeekFrame( unsigned int frameNumber )
+{
+  if ( !this->FrameByFrameReadingActive )
+  {
+    LOG_ERROR( "Cannot seek to frame " << frameNumber << " in " << this->FileName << ": frame-by-frame reading is not started" );
+    return PLUS_FAIL;
+  }
+  if ( frameNumber >= this->GetNumberOfFrames() )
+  {
+    LOG_ERROR( "Cannot seek to frame " << frameNumber << " in " << this->FileName << ": the sequence contains " << this->GetNumberOfFrames() << " frames" );
+    return PLUS_FAIL;
+  }
+  bool readAheadActive = this->ReadAhead->Thread.joinable();
+  if ( readAheadActive )
+  {
+    {
+      std::lock_guard<std::mutex> lock( this->ReadAhead->Mutex );
+      if ( frameNumber == this->ReadAhead->NextReturnedFrameNumber )
+      {
+        return PLUS_SUCCESS;
+      }
+    }
+    // Frames that are already read ahead are discarded, reading continues from the requested frame
+    this->StopReadAhead();
+  }
+  else if ( frameNumber == this->NextFrameNumber )
+  {
+    return PLUS_SUCCESS;
+  }
+
+  if ( frameNumber != this->NextFrameNumber && this->GetFrameSizeInBytes() > 0 && this->SeekImagePixelStream( frameNumber ) != PLUS_SUCCESS )
+  {
+    LOG_ERROR( "Failed to seek to frame " << frameNumber << " in " << this->GetPixelDataFilePath() );
+    // Position in the pixel data stream is undefined, so no more frames can be read
+    this->NextFrameNumber = this->GetNumberOfFrames();
+    return PLUS_FAIL;
+  }
+
+  this->NextFrameNumber = frameNumber;
+  if ( readAheadActive )
+  {
+    this->StartReadAhead();
+  }
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusSequenceIOBase::StartReadAhead()
+{
+  this->StopReadAhead();
+  this->ReadAhead->StopRequested = false;
+  this->ReadAhead->ReadingFinished = false;
+  this->ReadAhead->NextReturnedFrameNumber = this->NextFrameNumber;
+  this->ReadAhead->Thread = std::thread( &vtkPlusSequenceIOBase::ReadAheadThreadFunction, this );
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusSequenceIOBase::StopReadAhead()
+{
+  if ( !this->ReadAhead->Thread.joinable() )
+  {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock( this->ReadAhead->Mutex );
+    this->ReadAhead->StopRequested = true;
+  }
+  this->ReadAhead->FrameTaken.notify_one();
+  this->ReadAhead->Thread.join();
+
+  for ( std::deque<vtkReadAheadInternal::QueuedFrame>::iterator frameIt = this->ReadAhead->Queue.begin(); frameIt != this->ReadAhead->Queue.end(); ++frameIt )
+  {
+    delete frameIt->Frame;
+  }
+  this->ReadAhead->Queue.clear();
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusSequenceIOBase::ReadAheadThreadFunction()
+{
+  // Only this thread accesses the pixel data stream and NextFrameNumber while read-ahead is active
+  unsigned int numberOfFrames = this->GetNumberOfFrames();
+  while ( this->NextFrameNumber < numberOfFrames )
+  {
+    {
+      std::unique_lock<std::mutex> lock( this->ReadAhead->Mutex );
+      this->ReadAhead->FrameTaken.wait( lock, [this] { return this->ReadAhead->StopRequested || this->ReadAhead->Queue.size() < static_cast<size_t>( this->ReadAheadFrameCount ); } );
+      if ( this->ReadAhead->StopRequested )
+      {
+        break;
+      }
+    }
+
+    vtkReadAheadInternal::QueuedFrame queuedFrame;
+    queuedFrame.Frame = new PlusTrackedFrame;
+    queuedFrame.Status = this->ReadNextFrameFromStream( *queuedFrame.Frame );
+    {
+      std::lock_guard<std::mutex> lock( this->ReadAhead->Mutex );
+      this->ReadAhead->Queue.push_back( queuedFrame );
+    }
+    this->ReadAhead->FrameQueued.notify_one();
+    if ( queuedFrame.Status != PLUS_SUCCESS )
+    {
+      // Position in the pixel data stream is undefined after a read error
+      break;
+    }
+  }
+
+  {
+    std::lock_guard<std::mutex> lock( this->ReadAhead->Mutex );
+    this->ReadAhead->ReadingFinished = true;
+  }
+  this->ReadAhead->FrameQueued.notify_one();
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusSequenceIOBase::ReadFrame( unsigned int frameNumber, PlusTrackedFrame& trackedFrame )
+{
+  if ( this->SeekFrame( frameNumber ) != PLUS_SUCCESS )
+  {
+    return PLUS_FAIL;
+  }
+  return this->ReadNextFrame( trackedFrame );
+}
+
+//----------------------------------------------------------------------------
+bool vtkPlusSequenceIOBase::IsFrameIndexAvailable()
+{
+  return !this->FrameIndexOffsets.empty();
+}
+
+//----------------------------------------------------------------------------
+unsigned int vtkPlusSequenceIOBase::GetFrameSizeInBytes()
+{
+  if ( this->Dimensions[0] == 0 || this->Dimensions[1] == 0 || this->Dimensions[2] == 0 )
+  {
+    return 0;
+  }
+  return this->Dimensions[0] * this->Dimensions[1] * this->Dimensions[2] * PlusVideoFrame::GetNumberOfBytesPerScalar( this->PixelType ) * this->NumberOfScalarComponents;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusSequenceIOBase::ReadImagePixels()
+{
+  unsigned int frameSizeInBytes = this->GetFrameSizeInBytes();
+  if ( frameSizeInBytes == 0 )
+  {
+    LOG_DEBUG( "No image data in the file" );
+    return PLUS_SUCCESS;
+  }
+
+  if ( this->OpenImagePixelStream() != PLUS_SUCCESS )
+  {
+    return PLUS_FAIL;
+  }
+
+  // Frames are decompressed one by one directly into the tracked frame list, so the only extra memory that is needed is one frame
+  int numberOfErrors = 0;
+  std::vector<unsigned char> pixelBuffer( frameSizeInBytes );
+  int frameCount = this->Dimensions[3];
+  for ( int frameNumber = 0; frameNumber < frameCount; frameNumber++ )
+  {
+    if ( this->ReadNextFramePixels( &( pixelBuffer[0] ), frameSizeInBytes ) != PLUS_SUCCESS )
+    {
+      LOG_ERROR( "Failed to read pixel data of frame " << frameNumber << " from " << this->GetPixelDataFilePath() );
+      numberOfErrors++;
+      break;
+    }
+    this->CreateTrackedFrameIfNonExisting( frameNumber );
+    if ( this->SetFrameImageFromFilePixels( *this->TrackedFrameList->GetTrackedFrame( frameNumber ), frameNumber, &( pixelBuffer[0] ) ) != PLUS_SUCCESS )
+    {
+      numberOfErrors++;
+    }
+  }
+
+  this->CloseImagePixelStream();
+
+  return ( numberOfErrors > 0 ? PLUS_FAIL : PLUS_SUCCESS );
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusSequenceIOBase::OpenImagePixelStream()
+{
+  this->CloseImagePixelStream();
+  if ( FileOpen( &this->InputImageFileHandle, this->GetPixelDataFilePath().c_str(), "rb" ) != PLUS_SUCCESS )
+  {
+    LOG_ERROR( "The file " << this->GetPixelDataFilePath() << " could not be opened for reading" );
+    return PLUS_FAIL;
+  }
+  FSEEK( this->InputImageFileHandle, this->PixelDataFileOffset, SEEK_SET );
+  // The first frame is always a key frame
+  this->CodecPreviousFrame.clear();
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusSequenceIOBase::ReadNextFramePixels( unsigned char* pixelBuffer, unsigned int frameSizeInBytes )
+{
+  if ( this->InputImageFileHandle == NULL )
+  {
+    LOG_ERROR( "Pixel data stream is not open" );
+    return PLUS_FAIL;
+  }
+  if ( this->UseCompression && this->FrameCodec != NULL )
+  {
+    return this->ReadNextCodecFramePixels( pixelBuffer, frameSizeInBytes );
+  }
+  size_t bytesRead = fread( pixelBuffer, 1, frameSizeInBytes, this->InputImageFileHandle );
+  if ( bytesRead != frameSizeInBytes )
+  {
+    // Truncated files are tolerated, the missing pixels are filled with zeros
+    LOG_DEBUG( "Could only read " << bytesRead << " bytes of " << frameSizeInBytes << " bytes from " << this->GetPixelDataFilePath() );
+    memset( pixelBuffer + bytesRead, 0, frameSizeInBytes - bytesRead );
+  }
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusSequenceIOBase::CloseImagePixelStream()
+{
+  if ( this->InputImageFileHandle != NULL )
+  {
+    fclose( this->InputImageFileHandle );
+    this->InputImageFileHandle = NULL;
+  }
+  std::vector<unsigned char>().swap( this->CodecPreviousFrame );
+  std::vector<unsigned char>().swap( this->CodecEncodedFrameBuffer );
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusSequenceIOBase::SeekImagePixelStream( unsigned int frameNumber )
+{
+  if ( this->InputImageFileHandle == NULL )
+  {
+    LOG_ERROR( "Pixel data stream is not open" );
+    return PLUS_FAIL;
+  }
+
+  unsigned int frameSizeInBytes = this->GetFrameSizeInBytes();
+  if ( !this->UseCompression )
+  {
+    FilePositionOffsetType frameOffset = this->PixelDataFileOffset + static_cast<FilePositionOffsetType>( frameNumber ) * frameSizeInBytes;
+    if ( FSEEK( this->InputImageFileHandle, frameOffset, SEEK_SET ) != 0 )
+    {
+      LOG_ERROR( "Failed to seek to position " << frameOffset << " in " << this->GetPixelDataFilePath() );
+      return PLUS_FAIL;
+    }
+    return PLUS_SUCCESS;
+  }
+
+  if ( this->FrameCodec != NULL && this->IsFrameIndexAvailable() )
+  {
+    return this->SeekCodecImagePixelStream( frameNumber );
+  }
+
+  // Compressed data cannot be seeked without a frame index, so the preceding frames are decompressed and skipped
+  unsigned int currentFrameNumber = this->NextFrameNumber;
+  if ( frameNumber < currentFrameNumber )
+  {
+    if ( this->OpenImagePixelStream() != PLUS_SUCCESS )
+    {
+      return PLUS_FAIL;
+    }
+    currentFrameNumber = 0;
+  }
+  for ( ; currentFrameNumber < frameNumber; ++currentFrameNumber )
+  {
+    if ( this->ReadNextFramePixels( &( this->FramePixelBuffer[0] ), frameSizeInBytes ) != PLUS_SUCCESS )
+    {
+      LOG_ERROR( "Failed to skip pixel data of frame " << currentFrameNumber );
+      return PLUS_FAIL;
+    }
+  }
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusSequenceIOBase::ReadNextCodecFramePixels( unsigned char* pixelBuffer, unsigned int frameSizeInBytes )
+{
+  unsigned char frameType = CODEC_KEY_FRAME;
+  unsigned int encodedFrameSize = 0;
+  if ( ReadCodecBlockHeader( this->InputImageFileHandle, frameType, encodedFrameSize ) != PLUS_SUCCESS )
+  {
+    LOG_ERROR( "Cannot read compressed frame header from " << this->GetPixelDataFilePath() );
+    this->CodecPreviousFrame.clear();
+    return PLUS_FAIL;
+  }
+  bool validFrameType = ( frameType == CODEC_KEY_FRAME || ( frameType == CODEC_DELTA_FRAME && this->CodecPreviousFrame.size() == frameSizeInBytes ) );
+  // Compressed size is limited to prevent allocation of excessive memory for corrupted files
+  if ( !validFrameType || encodedFrameSize == 0 || encodedFrameSize > 2 * frameSizeInBytes + 64 )
+  {
+    LOG_ERROR( "Invalid compressed frame header in " << this->GetPixelDataFilePath() << " (frame type: " << static_cast<int>( frameType ) << ", compressed size: " << encodedFrameSize << ")" );
+    this->CodecPreviousFrame.clear();
+    return PLUS_FAIL;
+  }
+
+  this->CodecEncodedFrameBuffer.resize( encodedFrameSize );
+  if ( fread( &( this->CodecEncodedFrameBuffer[0] ), 1, encodedFrameSize, this->InputImageFileHandle ) != encodedFrameSize )
+  {
+    LOG_ERROR( "Cannot read " << encodedFrameSize << " bytes of compressed frame data from " << this->GetPixelDataFilePath() );
+    this->CodecPreviousFrame.clear();
+    return PLUS_FAIL;
+  }
+  if ( this->FrameCodec->Decode( &( this->CodecEncodedFrameBuffer[0] ), encodedFrameSize, pixelBuffer, frameSizeInBytes ) != PLUS_SUCCESS )
+  {
+    LOG_ERROR( "Cannot decode frame compressed by " << this->CompressionCodec << " codec" );
+    this->CodecPreviousFrame.clear();
+    return PLUS_FAIL;
+  }
+  if ( frameType == CODEC_DELTA_FRAME )
+  {
+    PlusFrameCodec::RevertFrameDelta( pixelBuffer, &( this->CodecPreviousFrame[0] ), frameSizeInBytes );
+  }
+
+  // The next frame may be stored as a difference to this frame
+  this->CodecPreviousFrame.assign( pixelBuffer, pixelBuffer + frameSizeInBytes );
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusSequenceIOBase::SeekCodecImagePixelStream( unsigned int frameNumber )
+{
+  unsigned int frameSizeInBytes = this->GetFrameSizeInBytes();
 
-#endif
+  // A frame that is stored as a difference can only be decoded after the preceding frames, so decoding starts
+  // at the closest key frame, or at the current position if the previous frame is already decoded
+  bool previousFrameAvailable = ( this->CodecPreviousFrame.size() == frameSizeInBytes );
+  unsigned int startFrameNumber = frameNumber;
+  while ( !previousFrameAvailable || startFrameNumber != this->NextFrameNumber )
+  {
+    unsigned char frameType = CODEC_KEY_FRAME;
+    unsigned int encodedFrameSize = 0;
+    if ( FSEEK( this->InputImageFileHandle, this->PixelDataFileOffset + this->FrameIndexOffsets[startFrameNumber], SEEK_SET ) != 0
+         || ReadCodecBlockHeader( this->InputImageFileHandle, frameType, encodedFrameSize ) != PLUS_SUCCESS )
+    {
+      LOG_ERROR( "Failed to read the compressed data of frame " << startFrameNumber << " in " << this->GetPixelDataFilePath() );
+      return PLUS_FAIL;
+    }
+    if ( frameType == CODEC_KEY_FRAME )
+    {
+      this->CodecPreviousFrame.clear();
+      break;
+    }
+    if ( startFrameNumber == 0 )
+    {
+      LOG_ERROR( "The first frame is not a key frame in " << this->GetPixelDataFilePath() );
+      return PLUS_FAIL;
+    }
+    startFrameNumber--;
+  }
+
+  if ( FSEEK( this->InputImageFileHandle, this->PixelDataFileOffset + this->FrameIndexOffsets[startFrameNumber], SEEK_SET ) != 0 )
+  {
+    LOG_ERROR( "Failed to seek to the compressed data of frame " << startFrameNumber << " in " << this->GetPixelDataFilePath() );
+    return PLUS_FAIL;
+  }
+  for ( unsigned int currentFrameNumber = startFrameNumber; currentFrameNumber < frameNumber; ++currentFrameNumber )
+  {
+    if ( this->ReadNextCodecFramePixels( &( this->FramePixelBuffer[0] ), frameSizeInBytes ) != PLUS_SUCCESS )
+    {
+      LOG_ERROR( "Failed to decode frame " << currentFrameNumber );
+      return PLUS_FAIL;
+    }
+  }
+  return PLUS_SUCCESS;
+}
 
 //----------------------------------------------------------------------------
+PlusStatus vtkPlusSequenceIOBase::SetCompressionCodec( const std::string& codecName )
+{
+  PlusFrameCodec* codec = NULL;
+  if ( !codecName.empty() )
+  {
+    codec = PlusFrameCodec::CreateCodec( codecName );
+    if ( codec == NULL )
+    {
+      LOG_ERROR( "Unknown compression codec: " << codecName );
+      return PLUS_FAIL;
+    }
+  }
+  delete this->FrameCodec;
+  this->FrameCodec = codec;
+  this->CompressionCodec = ( codec != NULL ? codec->GetName() : "" );
+  this->Modified();
+  return PLUS_SUCCESS;
+}
 
-vtkCxxSetObjectMacro( vtkPlusSequenceIOBase, TrackedFrameList, vtkPlusTrackedFrameList );
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusSequenceIOBase::ReadCompressionCodecHeaderField()
+{
+  const char* codecName = this->GetCustomString( SEQUENCE_FIELD_COMPRESSION_CODEC );
+  if ( this->SetCompressionCodec( codecName != NULL ? codecName : "" ) != PLUS_SUCCESS )
+  {
+    LOG_ERROR( "Pixel data of " << this->FileName << " is compressed by an unsupported codec" );
+    return PLUS_FAIL;
+  }
+  if ( this->FrameCodec != NULL )
+  {
+    this->UseCompression = true;
+  }
+  return PLUS_SUCCESS;
+}
 
 //----------------------------------------------------------------------------
-vtkPlusSequenceIOBase::vtkPlusSequenceIOBase()
-  : TrackedFrameList( vtkPlusTrackedFrameList::New() )
-  , UseCompression( false )
-  , CompressedBytesWritten( 0 )
-  , EnableImageDataWrite( true )
-  , PixelType( VTK_VOID )
-  , NumberOfScalarComponents( 1 )
-  , IsDataTimeSeries(true)
-  , NumberOfDimensions( 4 )
-  , CurrentFrameOffset( 0 )
-  , TotalBytesWritten( 0 )
-  , ImageOrientationInFile( US_IMG_ORIENT_XX )
-  , ImageOrientationInMemory( US_IMG_ORIENT_XX )
-  , ImageType( US_IMG_TYPE_XX )
-  , PixelDataFileOffset( 0 )
-  , PixelDataFileName( "" )
-  , OutputImageFileHandle( NULL )
+void vtkPlusSequenceIOBase::WriteCompressionCodecHeaderField()
 {
-  this->Dimensions[0] = 1;
-  this->Dimensions[1] = 1;
-  this->Dimensions[2] = 1;
-  this->Dimensions[3] = 1;
+  if ( this->UseCompression && this->FrameCodec != NULL )
+  {
+    this->SetCustomString( SEQUENCE_FIELD_COMPRESSION_CODEC, this->FrameCodec->GetName().c_str() );
+  }
+  else
+  {
+    // The field may come from a sequence that was read from a file
+    this->SetCustomString( SEQUENCE_FIELD_COMPRESSION_CODEC, static_cast<const char*>( NULL ) );
+  }
 }
 
 //----------------------------------------------------------------------------
-vtkPlusSequenceIOBase::~vtkPlusSequenceIOBase()
+std::string vtkPlusSequenceIOBase::GetFrameIndexFilePath( const std::string& sequenceFilePath )
 {
-  if( this->TrackedFrameList != NULL )
+  return sequenceFilePath + FRAME_INDEX_FILE_EXTENSION;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusSequenceIOBase::WriteFrameIndexFile( const std::string& indexFilePath, unsigned long long pixelDataSize )
+{
+  std::ofstream indexFile( indexFilePath.c_str(), std::ios::out | std::ios::trunc );
+  if ( !indexFile.is_open() )
   {
-    this->SetTrackedFrameList( NULL );
+    LOG_ERROR( "Unable to open frame index file for writing: " << indexFilePath );
+    return PLUS_FAIL;
+  }
+
+  indexFile << FRAME_INDEX_FILE_SIGNATURE << std::endl;
+  indexFile << FRAME_INDEX_FIELD_PIXEL_DATA_SIZE << " = " << pixelDataSize << std::endl;
+  indexFile << FRAME_INDEX_FIELD_NUMBER_OF_FRAMES << " = " << this->FrameIndexOffsets.size() << std::endl;
+  for ( std::vector<unsigned long long>::iterator offsetIt = this->FrameIndexOffsets.begin(); offsetIt != this->FrameIndexOffsets.end(); ++offsetIt )
+  {
+    indexFile << *offsetIt << std::endl;
+  }
+
+  if ( !indexFile.good() )
+  {
+    LOG_ERROR( "Failed to write frame index file: " << indexFilePath );
+    return PLUS_FAIL;
   }
+  return PLUS_SUCCESS;
 }
 
 //----------------------------------------------------------------------------
-void vtkPlusSequenceIOBase::PrintSelf( ostream& os, vtkIndent indent )
+PlusStatus vtkPlusSequenceIOBase::ReadFrameIndexFile()
 {
-  os << indent << "Frame List User Fields:" << std::endl;
-  this->TrackedFrameList->PrintSelf( os, indent );
+  this->FrameIndexOffsets.clear();
+  this->FrameIndexPixelDataSize = 0;
+
+  std::string indexFilePath = GetFrameIndexFilePath( this->FileName );
+  if ( !vtksys::SystemTools::FileExists( indexFilePath.c_str(), true ) )
+  {
+    LOG_DEBUG( "Frame index file is not found for " << this->FileName << ", seeking requires decompression of the preceding frames" );
+    return PLUS_SUCCESS;
+  }
+
+  std::ifstream indexFile( indexFilePath.c_str() );
+  std::string signature;
+  std::getline( indexFile, signature );
+  std::string pixelDataSizeFieldName;
+  std::string numberOfFramesFieldName;
+  std::string equalSign;
+  unsigned long long pixelDataSize = 0;
+  unsigned int numberOfFrames = 0;
+  indexFile >> pixelDataSizeFieldName >> equalSign >> pixelDataSize;
+  indexFile >> numberOfFramesFieldName >> equalSign >> numberOfFrames;
+  if ( !indexFile || signature != FRAME_INDEX_FILE_SIGNATURE
+       || pixelDataSizeFieldName != FRAME_INDEX_FIELD_PIXEL_DATA_SIZE || numberOfFramesFieldName != FRAME_INDEX_FIELD_NUMBER_OF_FRAMES )
+  {
+    LOG_WARNING( "Frame index file " << indexFilePath << " is invalid, it is ignored" );
+    return PLUS_FAIL;
+  }
+
+  std::vector<unsigned long long> frameOffsets( numberOfFrames, 0 );
+  for ( unsigned int frameNumber = 0; frameNumber < numberOfFrames; ++frameNumber )
+  {
+    indexFile >> frameOffsets[frameNumber];
+    if ( !indexFile || frameOffsets[frameNumber] >= pixelDataSize || ( frameNumber > 0 && frameOffsets[frameNumber] <= frameOffsets[frameNumber - 1] ) )
+    {
+      LOG_WARNING( "Frame index file " << indexFilePath << " contains invalid offset for frame " << frameNumber << ", it is ignored" );
+      return PLUS_FAIL;
+    }
+  }
+
+  // The index must belong to the current version of the sequence file
+  FILE* pixelDataFile = NULL;
+  if ( FileOpen( &pixelDataFile, this->GetPixelDataFilePath().c_str(), "rb" ) != PLUS_SUCCESS )
+  {
+    LOG_ERROR( "The file " << this->GetPixelDataFilePath() << " could not be opened for reading" );
+    return PLUS_FAIL;
+  }
+  FSEEK( pixelDataFile, 0, SEEK_END );
+  FilePositionOffsetType pixelDataFileSize = FTELL( pixelDataFile );
+  fclose( pixelDataFile );
+  if ( numberOfFrames != this->GetNumberOfFrames() || pixelDataFileSize < this->PixelDataFileOffset
+       || static_cast<unsigned long long>( pixelDataFileSize - this->PixelDataFileOffset ) != pixelDataSize )
+  {
+    LOG_WARNING( "Frame index file " << indexFilePath << " does not match " << this->FileName << ", it is ignored" );
+    return PLUS_FAIL;
+  }
+
+  this->FrameIndexOffsets.swap( frameOffsets );
+  this->FrameIndexPixelDataSize = pixelDataSize;
+  return PLUS_SUCCESS;
 }
 
 //----------------------------------------------------------------------------
-PlusStatus vtkPlusSequenceIOBase::Read()
+PlusStatus vtkPlusSequenceIOBase::SetFrameImageFromFilePixels( PlusTrackedFrame& trackedFrame, int frameNumber, unsigned char* pixels )
 {
-  this->TrackedFrameList->Clear();
+  // Allocate frame only if it is valid
+  std::string imageStatusFieldName = this->GetImageStatusFieldName();
+  const char* imgStatus = trackedFrame.GetCustomFrameField( imageStatusFieldName.c_str() );
+  if ( imgStatus != NULL ) // Found the image status field
+  {
+    // Save status field
+    std::string strImgStatus( imgStatus );
 
-  if ( this->ReadImageHeader() != PLUS_SUCCESS )
+    // Delete image status field from tracked frame
+    // Image status can be determine by trackedFrame->GetImageData()->IsImageValid()
+    trackedFrame.DeleteCustomFrameField( imageStatusFieldName.c_str() );
+
+    if ( !PlusCommon::IsEqualInsensitive( strImgStatus, "OK" ) ) // Image status _not_ OK
+    {
+      LOG_DEBUG( "Frame #" << frameNumber << " image data is invalid, no need to allocate data in the tracked frame list." );
+      return PLUS_SUCCESS;
+    }
+  }
+
+  trackedFrame.GetImageData()->SetImageOrientation( this->ImageOrientationInMemory );
+  trackedFrame.GetImageData()->SetImageType( this->ImageType );
+
+  if ( trackedFrame.GetImageData()->AllocateFrame( this->Dimensions, this->PixelType, this->NumberOfScalarComponents ) != PLUS_SUCCESS )
   {
-    LOG_ERROR( "Could not load header from file: " << this->FileName );
+    LOG_ERROR( "Cannot allocate memory for frame " << frameNumber );
     return PLUS_FAIL;
   }
 
-  if ( this->ReadImagePixels() != PLUS_SUCCESS )
+  int clipRectOrigin[3] = {PlusCommon::NO_CLIP, PlusCommon::NO_CLIP, PlusCommon::NO_CLIP};
+  int clipRectSize[3] = {PlusCommon::NO_CLIP, PlusCommon::NO_CLIP, PlusCommon::NO_CLIP};
+
+  PlusVideoFrame::FlipInfoType flipInfo;
+  if ( PlusVideoFrame::GetFlipAxes( this->ImageOrientationInFile, this->ImageType, this->ImageOrientationInMemory, flipInfo ) != PLUS_SUCCESS )
   {
+    LOG_ERROR( "Failed to convert image data to the requested orientation, from " << PlusVideoFrame::GetStringFromUsImageOrientation( this->ImageOrientationInFile ) <<
+               " to " << PlusVideoFrame::GetStringFromUsImageOrientation( this->ImageOrientationInMemory ) );
     return PLUS_FAIL;
   }
+
+  if ( PlusVideoFrame::GetOrientedClippedImage( pixels, flipInfo, this->ImageType, this->PixelType, this->NumberOfScalarComponents, this->Dimensions, *trackedFrame.GetImageData(), clipRectOrigin, clipRectSize ) != PLUS_SUCCESS )
+  {
+    LOG_ERROR( "Failed to get oriented image from sequence file (frame number: " << frameNumber << ")!" );
+    return PLUS_FAIL;
+  }
+
   return PLUS_SUCCESS;
 }
 
@@ -280,6 +1208,25 @@ PlusStatus vtkPlusSequenceIOBase::Close()
 {
   std::string headerFullPath = vtkPlusConfig::GetInstance()->GetOutputPath( this->FileName );
 
+  // Frame index is only needed for seeking in compressed pixel data
+  bool writeFrameIndex = this->WriteFrameIndex && this->UseCompression && !this->FrameIndexOffsets.empty();
+  unsigned long long pixelDataSize = 0;
+  if ( writeFrameIndex )
+  {
+    FILE* pixelDataFile = NULL;
+    if ( FileOpen( &pixelDataFile, this->TempImageFileName.c_str(), "rb" ) == PLUS_SUCCESS )
+    {
+      FSEEK( pixelDataFile, 0, SEEK_END );
+      pixelDataSize = FTELL( pixelDataFile );
+      fclose( pixelDataFile );
+    }
+    else
+    {
+      LOG_ERROR( "Unable to determine compressed pixel data size, frame index is not written for " << headerFullPath );
+      writeFrameIndex = false;
+    }
+  }
+
   // Rename header to final filename
   MoveFileInternal( this->TempHeaderFileName.c_str(), headerFullPath.c_str() );
 
@@ -305,14 +1252,28 @@ PlusStatus vtkPlusSequenceIOBase::Close()
     MoveFileInternal( this->TempImageFileName.c_str(), pixFullPath.c_str() );
   }
 
+  PlusStatus status = PLUS_SUCCESS;
+  std::string indexFilePath = GetFrameIndexFilePath( headerFullPath );
+  if ( writeFrameIndex )
+  {
+    status = this->WriteFrameIndexFile( indexFilePath, pixelDataSize );
+  }
+  else if ( vtksys::SystemTools::FileExists( indexFilePath.c_str(), true ) )
+  {
+    // Index of a previous version of the file would not match the new pixel data
+    vtksys::SystemTools::RemoveFile( indexFilePath.c_str() );
+  }
+
   this->TempHeaderFileName.clear();
   this->TempImageFileName.clear();
 
   this->CurrentFrameOffset = 0;
   this->TotalBytesWritten = 0;
   this->CompressedBytesWritten = 0;
+  this->FrameIndexOffsets.clear();
+  std::vector<unsigned char>().swap( this->CodecPreviousFrame );
 
-  return PLUS_SUCCESS;
+  return status;
 }
 
 //----------------------------------------------------------------------------
@@ -376,7 +1337,14 @@ PlusStatus vtkPlusSequenceIOBase::WriteImages()
     int compressedDataSize = 0;
     if ( imageDataAvailable )
     {
-      result = WriteCompressedImagePixelsToFile( compressedDataSize );
+      if ( this->FrameCodec != NULL )
+      {
+        result = this->WriteCodecCompressedImagePixelsToFile( compressedDataSize );
+      }
+      else
+      {
+        result = WriteCompressedImagePixelsToFile( compressedDataSize );
+      }
       if( result == PLUS_SUCCESS )
       {
         TotalBytesWritten += compressedDataSize;
@@ -392,6 +1360,232 @@ PlusStatus vtkPlusSequenceIOBase::WriteImages()
   return result;
 }
 
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusSequenceIOBase::WriteCompressedImagePixelsToFileParallel( int& compressedDataSize, bool gzipFormat )
+{
+  LOG_DEBUG( "Writing compressed pixel data into file using multiple threads started" );
+
+  compressedDataSize = 0;
+  unsigned int numberOfFrames = this->TrackedFrameList->GetNumberOfTrackedFrames();
+  if ( numberOfFrames == 0 )
+  {
+    return PLUS_SUCCESS;
+  }
+
+  // Create a blank frame if we have to write an invalid frame to file
+  PlusVideoFrame blankFrame;
+  if ( blankFrame.AllocateFrame( this->Dimensions, this->PixelType, this->NumberOfScalarComponents ) != PLUS_SUCCESS )
+  {
+    LOG_ERROR( "Failed to allocate space for blank image." );
+    return PLUS_FAIL;
+  }
+  blankFrame.FillBlank();
+
+  ParallelCompressionInfoStruct str;
+  // Frames must be independent if decompression has to start at any frame
+  str.UsePreviousFrameAsDictionary = !this->WriteFrameIndex;
+  str.GzipFormat = gzipFormat;
+  for ( unsigned int frameNumber = 0; frameNumber < numberOfFrames; frameNumber++ )
+  {
+    PlusVideoFrame* videoFrame = &blankFrame;
+    if ( this->EnableImageDataWrite )
+    {
+      PlusTrackedFrame* trackedFrame = this->TrackedFrameList->GetTrackedFrame( frameNumber );
+      if ( trackedFrame == NULL )
+      {
+        LOG_ERROR( "Cannot access frame " << frameNumber << " while trying to writing compress data into file" );
+        return PLUS_FAIL;
+      }
+      if ( trackedFrame->GetImageData()->IsImageValid() )
+      {
+        videoFrame = trackedFrame->GetImageData();
+      }
+    }
+    str.FramePixels.push_back( static_cast<unsigned char*>( videoFrame->GetScalarPointer() ) );
+    str.FrameSizes.push_back( videoFrame->GetFrameSizeInBytes() );
+  }
+  str.CompressedFrames.resize( numberOfFrames );
+  str.FrameChecksums.resize( numberOfFrames, 0 );
+  str.FrameStatus.resize( numberOfFrames, PLUS_FAIL );
+
+  int numberOfThreads = ( this->CompressionThreadCount > 0 ? this->CompressionThreadCount : vtkMultiThreader::GetGlobalDefaultNumberOfThreads() );
+  numberOfThreads = std::max( 1, std::min( numberOfThreads, std::min( static_cast<int>( numberOfFrames ), VTK_MAX_THREADS ) ) );
+  vtkSmartPointer<vtkMultiThreader> threader = vtkSmartPointer<vtkMultiThreader>::New();
+  threader->SetNumberOfThreads( numberOfThreads );
+  threader->SetSingleMethod( ParallelCompressionThreadFunction, &str );
+  threader->SingleMethodExecute();
+
+  // Concatenate the compressed frames in the original order
+  const unsigned char* header = gzipFormat ? GZIP_HEADER : ZLIB_HEADER;
+  size_t headerSize = gzipFormat ? sizeof( GZIP_HEADER ) : sizeof( ZLIB_HEADER );
+  if ( WriteBytes( this->OutputImageFileHandle, header, headerSize, compressedDataSize ) != PLUS_SUCCESS )
+  {
+    return PLUS_FAIL;
+  }
+  uLong checksum = gzipFormat ? crc32( 0L, Z_NULL, 0 ) : adler32( 0L, Z_NULL, 0 );
+  unsigned long long uncompressedDataSize = 0;
+  for ( unsigned int frameNumber = 0; frameNumber < numberOfFrames; frameNumber++ )
+  {
+    if ( str.FrameStatus[frameNumber] != PLUS_SUCCESS )
+    {
+      return PLUS_FAIL;
+    }
+    if ( this->WriteFrameIndex )
+    {
+      this->FrameIndexOffsets.push_back( this->CompressedBytesWritten + compressedDataSize );
+    }
+    if ( WriteBytes( this->OutputImageFileHandle, &str.CompressedFrames[frameNumber][0], str.CompressedFrames[frameNumber].size(), compressedDataSize ) != PLUS_SUCCESS )
+    {
+      return PLUS_FAIL;
+    }
+    checksum = gzipFormat ? crc32_combine( checksum, str.FrameChecksums[frameNumber], str.FrameSizes[frameNumber] )
+               : adler32_combine( checksum, str.FrameChecksums[frameNumber], str.FrameSizes[frameNumber] );
+    uncompressedDataSize += str.FrameSizes[frameNumber];
+  }
+
+  // Checksum is stored in big-endian order in zlib and little-endian order in gzip stream, gzip also stores the size modulo 2^32
+  unsigned char trailer[8] = { 0 };
+  size_t trailerSize = 0;
+  if ( gzipFormat )
+  {
+    for ( int i = 0; i < 4; i++ )
+    {
+      trailer[i] = static_cast<unsigned char>( ( checksum >> ( 8 * i ) ) & 0xff );
+      trailer[4 + i] = static_cast<unsigned char>( ( uncompressedDataSize >> ( 8 * i ) ) & 0xff );
+    }
+    trailerSize = 8;
+  }
+  else
+  {
+    for ( int i = 0; i < 4; i++ )
+    {
+      trailer[i] = static_cast<unsigned char>( ( checksum >> ( 8 * ( 3 - i ) ) ) & 0xff );
+    }
+    trailerSize = 4;
+  }
+  if ( WriteBytes( this->OutputImageFileHandle, trailer, trailerSize, compressedDataSize ) != PLUS_SUCCESS )
+  {
+    return PLUS_FAIL;
+  }
+
+  LOG_DEBUG( "Writing compressed pixel data into file using " << numberOfThreads << " threads completed" );
+
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusSequenceIOBase::WriteCodecCompressedImagePixelsToFile( int& compressedDataSize )
+{
+  LOG_DEBUG( "Writing pixel data compressed by " << this->CompressionCodec << " codec into file started" );
+
+  compressedDataSize = 0;
+  unsigned int numberOfFrames = this->TrackedFrameList->GetNumberOfTrackedFrames();
+  if ( numberOfFrames == 0 )
+  {
+    return PLUS_SUCCESS;
+  }
+
+  // Create a blank frame if we have to write an invalid frame to file
+  PlusVideoFrame blankFrame;
+  if ( blankFrame.AllocateFrame( this->Dimensions, this->PixelType, this->NumberOfScalarComponents ) != PLUS_SUCCESS )
+  {
+    LOG_ERROR( "Failed to allocate space for blank image." );
+    return PLUS_FAIL;
+  }
+  blankFrame.FillBlank();
+
+  CodecCompressionInfoStruct str;
+  str.CodecName = this->CompressionCodec;
+  str.FrameSize = blankFrame.GetFrameSizeInBytes();
+  for ( unsigned int frameNumber = 0; frameNumber < numberOfFrames; frameNumber++ )
+  {
+    PlusVideoFrame* videoFrame = &blankFrame;
+    if ( this->EnableImageDataWrite )
+    {
+      PlusTrackedFrame* trackedFrame = this->TrackedFrameList->GetTrackedFrame( frameNumber );
+      if ( trackedFrame == NULL )
+      {
+        LOG_ERROR( "Cannot access frame " << frameNumber << " while trying to writing compress data into file" );
+        return PLUS_FAIL;
+      }
+      if ( trackedFrame->GetImageData()->IsImageValid() )
+      {
+        videoFrame = trackedFrame->GetImageData();
+      }
+    }
+    if ( videoFrame->GetFrameSizeInBytes() != str.FrameSize )
+    {
+      LOG_ERROR( "Frame size mismatch: expected " << str.FrameSize << " bytes, frame " << frameNumber << " contains " << videoFrame->GetFrameSizeInBytes() << " bytes" );
+      return PLUS_FAIL;
+    }
+
+    // The first frame of this write is compared to the last frame of the previous write
+    const unsigned char* previousFramePixels = NULL;
+    if ( frameNumber > 0 )
+    {
+      previousFramePixels = str.FramePixels[frameNumber - 1];
+    }
+    else if ( this->CodecPreviousFrame.size() == str.FrameSize )
+    {
+      previousFramePixels = &( this->CodecPreviousFrame[0] );
+    }
+    // Key frames are inserted regularly when a frame index is written, to allow decoding to start near any frame
+    bool keyFrame = !this->CompressionFrameDelta || previousFramePixels == NULL
+                    || ( this->WriteFrameIndex && ( this->CurrentFrameOffset + frameNumber ) % CODEC_KEY_FRAME_INTERVAL == 0 );
+    str.FramePixels.push_back( static_cast<const unsigned char*>( videoFrame->GetScalarPointer() ) );
+    str.PreviousFramePixels.push_back( keyFrame ? NULL : previousFramePixels );
+  }
+  str.EncodedFrames.resize( numberOfFrames );
+  str.FrameStatus.resize( numberOfFrames, PLUS_FAIL );
+
+  int numberOfThreads = ( this->CompressionThreadCount > 0 ? this->CompressionThreadCount : vtkMultiThreader::GetGlobalDefaultNumberOfThreads() );
+  numberOfThreads = std::max( 1, std::min( numberOfThreads, std::min( static_cast<int>( numberOfFrames ), VTK_MAX_THREADS ) ) );
+  vtkSmartPointer<vtkMultiThreader> threader = vtkSmartPointer<vtkMultiThreader>::New();
+  threader->SetNumberOfThreads( numberOfThreads );
+  threader->SetSingleMethod( CodecCompressionThreadFunction, &str );
+  threader->SingleMethodExecute();
+
+  // Write the compressed frames in the original order
+  for ( unsigned int frameNumber = 0; frameNumber < numberOfFrames; frameNumber++ )
+  {
+    if ( str.FrameStatus[frameNumber] != PLUS_SUCCESS )
+    {
+      LOG_ERROR( "Failed to compress frame " << frameNumber << " by " << this->CompressionCodec << " codec" );
+      return PLUS_FAIL;
+    }
+    if ( this->WriteFrameIndex )
+    {
+      this->FrameIndexOffsets.push_back( this->CompressedBytesWritten + compressedDataSize );
+    }
+    std::vector<unsigned char>& encodedFrame = str.EncodedFrames[frameNumber];
+    unsigned int encodedFrameSize = encodedFrame.size();
+    unsigned char blockHeader[CODEC_BLOCK_HEADER_SIZE] =
+    {
+      ( str.PreviousFramePixels[frameNumber] != NULL ? CODEC_DELTA_FRAME : CODEC_KEY_FRAME ),
+      static_cast<unsigned char>( encodedFrameSize & 0xff ),
+      static_cast<unsigned char>( ( encodedFrameSize >> 8 ) & 0xff ),
+      static_cast<unsigned char>( ( encodedFrameSize >> 16 ) & 0xff ),
+      static_cast<unsigned char>( ( encodedFrameSize >> 24 ) & 0xff )
+    };
+    if ( WriteBytes( this->OutputImageFileHandle, blockHeader, CODEC_BLOCK_HEADER_SIZE, compressedDataSize ) != PLUS_SUCCESS
+         || WriteBytes( this->OutputImageFileHandle, &encodedFrame[0], encodedFrameSize, compressedDataSize ) != PLUS_SUCCESS )
+    {
+      return PLUS_FAIL;
+    }
+  }
+
+  // The last frame is the reference for the first frame of the next write
+  if ( this->CompressionFrameDelta )
+  {
+    const unsigned char* lastFramePixels = str.FramePixels[numberOfFrames - 1];
+    this->CodecPreviousFrame.assign( lastFramePixels, lastFramePixels + str.FrameSize );
+  }
+
+  LOG_DEBUG( "Writing pixel data compressed by " << this->CompressionCodec << " codec using " << numberOfThreads << " threads completed" );
+
+  return PLUS_SUCCESS;
+}
+
 //----------------------------------------------------------------------------
 PlusStatus vtkPlusSequenceIOBase::MoveFileInternal( const char* oldname, const char* newname )
 {
@@ -461,6 +1655,8 @@ PlusStatus vtkPlusSequenceIOBase::Discard()
 
   this->CurrentFrameOffset = 0;
   this->TotalBytesWritten = 0;
+  this->FrameIndexOffsets.clear();
+  std::vector<unsigned char>().swap( this->CodecPreviousFrame );
 
   return PLUS_SUCCESS;
 }
@@ -468,8 +1664,23 @@ PlusStatus vtkPlusSequenceIOBase::Discard()
 //----------------------------------------------------------------------------
 PlusTrackedFrame* vtkPlusSequenceIOBase::GetTrackedFrame( int frameNumber )
 {
-  PlusTrackedFrame* trackedFrame = this->TrackedFrameList->GetTrackedFrame( frameNumber );
-  return trackedFrame;
+  if ( !this->FrameByFrameReadingActive )
+  {
+    PlusTrackedFrame* trackedFrame = this->TrackedFrameList->GetTrackedFrame( frameNumber );
+    return trackedFrame;
+  }
+
+  // Only the requested frame is read from the file
+  if ( this->CurrentFrame == NULL )
+  {
+    this->CurrentFrame = new PlusTrackedFrame;
+  }
+  if ( frameNumber < 0 || this->ReadFrame( frameNumber, *this->CurrentFrame ) != PLUS_SUCCESS )
+  {
+    LOG_ERROR( "Failed to read frame " << frameNumber << " from " << this->FileName );
+    return NULL;
+  }
+  return this->CurrentFrame;
 }
 
 //----------------------------------------------------------------------------
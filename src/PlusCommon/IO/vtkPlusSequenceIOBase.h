@@ -14,6 +14,7 @@
 
 class vtkPlusTrackedFrameList;
 class PlusTrackedFrame;
+class PlusFrameCodec;
 
 #ifndef Z_BUFSIZE
 #  ifdef MAXSEG_64K
@@ -39,6 +40,44 @@ public:
   /*! Read file contents into the object */
   virtual PlusStatus Read();
 
+  /*!
+    Read the file header and prepare for reading the frames one by one by ReadNextFrame.
+    Only the header fields (custom frame fields, such as timestamps and transforms) are loaded into the
+    tracked frame list, pixel data is read (and decompressed) on demand, one frame at a time. This allows
+    processing of sequences that do not fit into memory.
+  */
+  virtual PlusStatus StartFrameByFrameReading();
+
+  /*!
+    Read the custom fields and image data of the next frame into trackedFrame.
+    Only one frame is kept in memory (plus the frames that are read ahead, see ReadAheadFrameCount),
+    so the same tracked frame object can be reused for reading all the frames.
+  */
+  virtual PlusStatus ReadNextFrame( PlusTrackedFrame& trackedFrame );
+
+  /*! Returns true if frame-by-frame reading is started and not all the frames have been read yet */
+  bool IsNextFrameAvailable();
+
+  /*! Release the pixel data file that was opened by StartFrameByFrameReading */
+  virtual void StopFrameByFrameReading();
+
+  /*! Get the number of frames in the sequence. Available after the header is read. */
+  unsigned int GetNumberOfFrames();
+
+  /*!
+    Position frame-by-frame reading so that the next ReadNextFrame call returns the specified frame.
+    Uncompressed pixel data is always seekable. Compressed pixel data can be seeked without decompressing
+    the preceding frames if the file was written with a frame index (see WriteFrameIndex), otherwise
+    the preceding frames are decompressed and skipped (backward seeking restarts from the first frame).
+  */
+  virtual PlusStatus SeekFrame( unsigned int frameNumber );
+
+  /*! Read a single frame (random access). Frame-by-frame reading must be started by StartFrameByFrameReading. */
+  virtual PlusStatus ReadFrame( unsigned int frameNumber, PlusTrackedFrame& trackedFrame );
+
+  /*! Returns true if a valid frame index was found when frame-by-frame reading was started */
+  bool IsFrameIndexAvailable();
+
   /*! Write images to disc, compression allowed */
   virtual PlusStatus WriteImages();
 
@@ -92,7 +131,11 @@ public:
   /*! Finalize the header */
   virtual PlusStatus FinalizeHeader() = 0;
 
-  /*! Returns a pointer to a single frame */
+  /*!
+    Returns a pointer to a single frame.
+    If frame-by-frame reading is active then the frame is read from the file (see ReadFrame) and the returned
+    pointer is valid until the next GetTrackedFrame call, otherwise the frame is returned from the tracked frame list.
+  */
   virtual PlusTrackedFrame* GetTrackedFrame( int frameNumber );
 
   /*! Close the sequence */
@@ -129,6 +172,12 @@ public:
   /*! Return the dimensions of the sequence */
   vtkGetVector4Macro( Dimensions, unsigned int );
 
+  /*! Get the pixel type of the images in the sequence */
+  vtkGetMacro( PixelType, PlusCommon::VTKScalarPixelType );
+
+  /*! Get the number of scalar components of the images in the sequence */
+  vtkGetMacro( NumberOfScalarComponents, int );
+
   /*! Flag to enable/disable writing of image data */
   vtkGetMacro( EnableImageDataWrite, bool );
   /*! Flag to enable/disable writing of image data */
@@ -136,12 +185,118 @@ public:
   /*! Flag to enable/disable writing of image data */
   vtkBooleanMacro( EnableImageDataWrite, bool );
 
+  /*!
+    Flag to enable/disable writing of a frame index file (<FileName>.idx) when image data is compressed.
+    If enabled then each frame is compressed into an independent deflate block (the file remains readable
+    by any reader) and the offset of each block is stored in the index file, which allows reading any frame
+    without decompressing the preceding frames.
+  */
+  vtkGetMacro( WriteFrameIndex, bool );
+  /*! Flag to enable/disable writing of a frame index file */
+  vtkSetMacro( WriteFrameIndex, bool );
+  /*! Flag to enable/disable writing of a frame index file */
+  vtkBooleanMacro( WriteFrameIndex, bool );
+
+  /*!
+    Number of threads used for compressing image data. If 1 (default) then the frames are compressed on the calling thread.
+    Otherwise the frames are compressed in parallel and written in the original order as a standard zlib/gzip stream.
+    0 means one thread per processor core.
+  */
+  vtkGetMacro( CompressionThreadCount, int );
+  /*! Number of threads used for compressing image data */
+  vtkSetMacro( CompressionThreadCount, int );
+
+  /*!
+    Set the codec that is used for compressing image data (see PlusFrameCodec::GetCodecNames).
+    If empty (default) then the image data is compressed into a standard zlib/gzip stream that any reader can decompress.
+    Otherwise each frame is compressed into a separate block by the selected codec (for example, LZ4 is much faster than zlib,
+    at a lower compression ratio), which can only be read by Plus. Returns PLUS_FAIL if the codec is unknown.
+  */
+  PlusStatus SetCompressionCodec( const std::string& codecName );
+  /*! Get the name of the codec that is used for compressing image data, empty if the standard zlib/gzip stream is used */
+  vtkGetStdStringMacro( CompressionCodec );
+
+  /*!
+    Flag to enable/disable compressing the difference to the previous frame instead of the frame itself.
+    Consecutive ultrasound frames are usually very similar, therefore the difference can be compressed better.
+    Only used if a compression codec is set. If a frame index is written then every few frames are stored without
+    the difference, so that decoding of any frame can start at a nearby frame.
+  */
+  vtkGetMacro( CompressionFrameDelta, bool );
+  /*! Flag to enable/disable compressing the difference to the previous frame */
+  vtkSetMacro( CompressionFrameDelta, bool );
+  /*! Flag to enable/disable compressing the difference to the previous frame */
+  vtkBooleanMacro( CompressionFrameDelta, bool );
+
+  /*!
+    Number of frames that are read ahead on a background I/O thread during frame-by-frame reading.
+    If 0 (default) then ReadNextFrame reads and decompresses the frame on the calling thread.
+    Otherwise the following frames are read into a queue of at most this many frames, so that file reading
+    and decompression overlap with the processing of the returned frames. Seeking discards the queued frames.
+    The tracked frame list must not be modified while frames are read ahead.
+    Takes effect at the next StartFrameByFrameReading call.
+  */
+  vtkGetMacro( ReadAheadFrameCount, int );
+  /*! Number of frames that are read ahead on a background I/O thread during frame-by-frame reading */
+  vtkSetMacro( ReadAheadFrameCount, int );
+
 protected:
   /*! Read all the fields in the image file header */
   virtual PlusStatus ReadImageHeader() = 0;
 
-  /*! Read pixel data from the image */
-  virtual PlusStatus ReadImagePixels() = 0;
+  /*! Read pixel data of all the frames into the tracked frame list */
+  virtual PlusStatus ReadImagePixels();
+
+  /*! Open the pixel data file for reading the frames sequentially, starting from the first frame */
+  virtual PlusStatus OpenImagePixelStream();
+
+  /*! Read the pixels of the next frame (in the orientation of the file) from the pixel data stream */
+  virtual PlusStatus ReadNextFramePixels( unsigned char* pixelBuffer, unsigned int frameSizeInBytes );
+
+  /*! Close the pixel data stream */
+  virtual void CloseImagePixelStream();
+
+  /*! Read the custom fields and image data of the next frame from the pixel data stream, on the calling thread */
+  PlusStatus ReadNextFrameFromStream( PlusTrackedFrame& trackedFrame );
+
+  /*! Start the background thread that reads frames ahead, from the current position of the pixel data stream */
+  void StartReadAhead();
+
+  /*!
+    Stop the read-ahead thread and discard the frames that it has read. Must be called before the pixel data stream is closed.
+    The pixel data stream remains positioned after the last frame that was read by the thread (NextFrameNumber).
+  */
+  void StopReadAhead();
+
+  /*! Read frames into the read-ahead queue until all the frames are read or read-ahead is stopped */
+  void ReadAheadThreadFunction();
+
+  /*!
+    Position the pixel data stream to the beginning of the specified frame. The default implementation
+    seeks directly in uncompressed pixel data and decompresses and skips the preceding frames in compressed pixel data.
+  */
+  virtual PlusStatus SeekImagePixelStream( unsigned int frameNumber );
+
+  /*! Full path of the frame index file that belongs to a sequence file */
+  static std::string GetFrameIndexFilePath( const std::string& sequenceFilePath );
+
+  /*! Write the frame offsets that are recorded while writing the compressed images into the frame index file */
+  PlusStatus WriteFrameIndexFile( const std::string& indexFilePath, unsigned long long pixelDataSize );
+
+  /*! Read the frame index file. The index is ignored if it does not match the pixel data in the sequence file. */
+  PlusStatus ReadFrameIndexFile();
+
+  /*! Name of the custom frame field that indicates if the image data of the frame is valid */
+  virtual std::string GetImageStatusFieldName() const = 0;
+
+  /*!
+    Set the image data of a frame from pixels that are read from the file. The image is converted to the
+    orientation in memory. Image data is not allocated for frames that are marked as invalid by the image status field.
+  */
+  PlusStatus SetFrameImageFromFilePixels( PlusTrackedFrame& trackedFrame, int frameNumber, unsigned char* pixels );
+
+  /*! Size of one frame of pixel data in the file, 0 if the file contains no image data */
+  unsigned int GetFrameSizeInBytes();
 
   /*! Write all the fields to the sequence file header */
   virtual PlusStatus WriteInitialImageHeader() = 0;
@@ -162,6 +317,33 @@ protected:
   */
   virtual PlusStatus WriteCompressedImagePixelsToFile( int& compressedDataSize ) = 0;
 
+  /*!
+    Compress the frames on multiple threads (see CompressionThreadCount) and write them into the pixel data file
+    as one zlib (gzipFormat=false) or gzip (gzipFormat=true) stream. Each frame is deflated separately; the end of
+    the previous frame is used as dictionary, unless a frame index is written.
+    \param compressedDataSize returns the size of the compressed data that is written to the file.
+  */
+  PlusStatus WriteCompressedImagePixelsToFileParallel( int& compressedDataSize, bool gzipFormat );
+
+  /*!
+    Compress the frames with the compression codec (see SetCompressionCodec), on multiple threads if CompressionThreadCount is not 1,
+    and write them into the pixel data file. Each frame is written as a block header (frame type and compressed size) and the compressed data.
+    \param compressedDataSize returns the size of the compressed data that is written to the file.
+  */
+  PlusStatus WriteCodecCompressedImagePixelsToFile( int& compressedDataSize );
+
+  /*! Read and decode the next frame that is compressed with the compression codec */
+  PlusStatus ReadNextCodecFramePixels( unsigned char* pixelBuffer, unsigned int frameSizeInBytes );
+
+  /*! Position the pixel data stream to the specified frame using the frame index, in pixel data that is compressed with the compression codec */
+  PlusStatus SeekCodecImagePixelStream( unsigned int frameNumber );
+
+  /*! Set the compression codec according to the image header fields. Standard zlib/gzip compression is used if the codec is not specified. */
+  PlusStatus ReadCompressionCodecHeaderField();
+
+  /*! Add the compression codec to the image header fields (or remove it, if the standard zlib/gzip compression is used) */
+  void WriteCompressionCodecHeaderField();
+
   /*! Opens a file. Doesn't log error if it fails because it may be expected. */
   static PlusStatus FileOpen( FILE** stream, const char* filename, const char* flags );
 
@@ -253,6 +435,39 @@ protected:
   std::string PixelDataFileName;
   /*! file handle for image output */
   FILE* OutputImageFileHandle;
+  /*! file handle for reading pixel data sequentially */
+  FILE* InputImageFileHandle;
+  /*! True if frame-by-frame reading was started */
+  bool FrameByFrameReadingActive;
+  /*! Index of the frame that is returned by the next ReadNextFrame call */
+  unsigned int NextFrameNumber;
+  /*! Buffer for one frame of pixel data, used while reading the frames */
+  std::vector<unsigned char> FramePixelBuffer;
+  /*! Frame that is returned by GetTrackedFrame during frame-by-frame reading */
+  PlusTrackedFrame* CurrentFrame;
+  /*! Enable writing of independently compressed frames and a frame index file */
+  bool WriteFrameIndex;
+  /*! Position of the compressed data of each frame, relative to the first byte of the pixel data */
+  std::vector<unsigned long long> FrameIndexOffsets;
+  /*! Total size of the compressed pixel data, as stored in the frame index file */
+  unsigned long long FrameIndexPixelDataSize;
+  /*! Number of threads used for compressing image data, 0 means one thread per processor core */
+  int CompressionThreadCount;
+  /*! Name of the codec used for compressing image data, empty if the standard zlib/gzip stream is used */
+  std::string CompressionCodec;
+  /*! Codec used for compressing image data, NULL if the standard zlib/gzip stream is used */
+  PlusFrameCodec* FrameCodec;
+  /*! Compress the difference to the previous frame */
+  bool CompressionFrameDelta;
+  /*! Pixels of the previously written or read frame, the reference for frame difference encoding and decoding */
+  std::vector<unsigned char> CodecPreviousFrame;
+  /*! Buffer for the compressed data of one frame, used while reading the frames */
+  std::vector<unsigned char> CodecEncodedFrameBuffer;
+  /*! Maximum number of frames that are read ahead on a background thread, 0 if frames are read on the calling thread */
+  int ReadAheadFrameCount;
+  /*! Queue and thread of frame read-ahead */
+  class vtkReadAheadInternal;
+  vtkReadAheadInternal* ReadAhead;
 
 protected:
   vtkPlusSequenceIOBase();
@@ -19,6 +19,43 @@ See License.txt for details.
 #include <algorithm>
 #include <string>
 
+#if defined(_MSC_VER) && defined(PLUS_AVX2_AVAILABLE)
+  #include <intrin.h>
+  #include <immintrin.h>
+#endif
+
+namespace
+{
+  //----------------------------------------------------------------------------
+  bool DetectAvx2Support()
+  {
+#if defined(PLUS_AVX2_AVAILABLE) && defined(_MSC_VER)
+    int cpuInfo[4] = {0};
+    __cpuid(cpuInfo, 0);
+    if (cpuInfo[0] < 7)
+    {
+      return false;
+    }
+    __cpuid(cpuInfo, 1);
+    bool osUsesXsave = (cpuInfo[2] & (1 << 27)) != 0;
+    bool avxSupported = (cpuInfo[2] & (1 << 28)) != 0;
+    // The operating system must save the YMM registers on context switch
+    if (!osUsesXsave || !avxSupported || (_xgetbv(0) & 0x6) != 0x6)
+    {
+      return false;
+    }
+    __cpuidex(cpuInfo, 7, 0);
+    return (cpuInfo[1] & (1 << 5)) != 0;
+#elif defined(PLUS_AVX2_AVAILABLE)
+    // Checks operating system support as well
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") != 0;
+#else
+    return false;
+#endif
+  }
+}
+
 //-------------------------------------------------------
 PlusTransformName::PlusTransformName()
 {
@@ -441,6 +478,24 @@ PlusStatus PlusCommon::XML::PrintXML(const std::string& fname, vtkXMLDataElement
   return PlusCommon::XML::PrintXML(of, vtkIndent(), elem);
 }
 
+//----------------------------------------------------------------------------
+bool PlusCommon::IsSse2Supported()
+{
+#ifdef PLUS_SSE2_AVAILABLE
+  // All processors that can run code compiled with SSE2 enabled support SSE2
+  return true;
+#else
+  return false;
+#endif
+}
+
+//----------------------------------------------------------------------------
+bool PlusCommon::IsAvx2Supported()
+{
+  static const bool avx2Supported = DetectAvx2Support();
+  return avx2Supported;
+}
+
 //----------------------------------------------------------------------------
 std::string PlusCommon::GetPlusLibVersionString()
 {
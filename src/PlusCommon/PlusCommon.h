@@ -56,6 +56,28 @@ enum PlusImagingMode
   #define STRCASECMP strcasecmp
 #endif
 
+///////////////////////////////////////////////////////////////////
+// SIMD instruction sets
+
+// PLUS_SSE2_AVAILABLE and PLUS_AVX2_AVAILABLE are defined if the compiler can generate code for the instruction set.
+// Functions that use AVX2 intrinsics must be declared with PLUS_TARGET_AVX2 and may only be called
+// if PlusCommon::IsAvx2Supported() returns true.
+#if defined(_MSC_VER) && (defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+  #define PLUS_SSE2_AVAILABLE
+  #if _MSC_VER >= 1700
+    #define PLUS_AVX2_AVAILABLE
+  #endif
+  #define PLUS_TARGET_AVX2
+#elif (defined(__GNUC__) || defined(__clang__)) && defined(__SSE2__)
+  #define PLUS_SSE2_AVAILABLE
+  #if (defined(__clang__) && __clang_major__ >= 4) || (!defined(__clang__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9)))
+    #define PLUS_AVX2_AVAILABLE
+  #endif
+  #define PLUS_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+  #define PLUS_TARGET_AVX2
+#endif
+
 ///////////////////////////////////////////////////////////////////
 // Logging
 
@@ -423,6 +445,12 @@ namespace PlusCommon
 
   vtkPlusCommonExport std::string GetPlusLibVersionString();
 
+  /*! Returns true if SSE2 instructions can be used (supported by both the compiler and the processor) */
+  vtkPlusCommonExport bool IsSse2Supported();
+
+  /*! Returns true if AVX2 instructions can be used (supported by the compiler, the processor, and the operating system) */
+  vtkPlusCommonExport bool IsAvx2Supported();
+
   //----------------------------------------------------------------------------
   namespace XML
   {
@@ -534,6 +562,17 @@ public:
     return !(in == *this);
   }
 
+  /*! Strict weak ordering by 'From' then 'To' frame name, allows using transform names as map keys */
+  inline bool operator< (const PlusTransformName& in) const
+  {
+    int fromComparison = m_From.compare(in.m_From);
+    if (fromComparison != 0)
+    {
+      return fromComparison < 0;
+    }
+    return m_To < in.m_To;
+  }
+
   friend std::ostream& operator<< (std::ostream& os, const PlusTransformName& transformName)
   {
     os << transformName.GetTransformName();
@@ -0,0 +1,152 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+#include "PlusConfigure.h"
+#include "PlusFft.h"
+#include "vtkMath.h"
+
+#include <math.h>
+
+//----------------------------------------------------------------------------
+PlusFft::PlusFft()
+  : Length(0)
+{
+}
+
+//----------------------------------------------------------------------------
+PlusFft::~PlusFft()
+{
+}
+
+//----------------------------------------------------------------------------
+unsigned int PlusFft::GetPowerOfTwoLength(unsigned int minimumLength)
+{
+  unsigned int length = 1;
+  while (length < minimumLength)
+  {
+    length *= 2;
+  }
+  return length;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus PlusFft::SetLength(unsigned int length)
+{
+  if (length == this->Length)
+  {
+    // already prepared
+    return PLUS_SUCCESS;
+  }
+  if (length == 0 || (length & (length - 1)) != 0)
+  {
+    LOG_ERROR("PlusFft::SetLength failed: length must be a power of two (requested: " << length << ")");
+    return PLUS_FAIL;
+  }
+
+  this->BitReversalSwaps.clear();
+  unsigned int numberOfBits = 0;
+  while ((1u << numberOfBits) < length)
+  {
+    numberOfBits++;
+  }
+  for (unsigned int i = 0; i < length; i++)
+  {
+    unsigned int reversed = 0;
+    for (unsigned int bit = 0; bit < numberOfBits; bit++)
+    {
+      reversed |= ((i >> bit) & 1) << (numberOfBits - 1 - bit);
+    }
+    if (i < reversed)
+    {
+      this->BitReversalSwaps.push_back(i);
+      this->BitReversalSwaps.push_back(reversed);
+    }
+  }
+
+  // Twiddle factors of each stage are stored contiguously, so that the butterfly loops read them sequentially
+  this->Twiddles.resize(2 * (length > 1 ? length - 1 : 0));
+  for (unsigned int halfSize = 1; halfSize < length; halfSize *= 2)
+  {
+    double* stageTwiddles = &this->Twiddles[2 * (halfSize - 1)];
+    for (unsigned int k = 0; k < halfSize; k++)
+    {
+      double angle = vtkMath::Pi() * k / halfSize;
+      stageTwiddles[2 * k] = cos(angle);
+      stageTwiddles[2 * k + 1] = -sin(angle);
+    }
+  }
+
+  this->Length = length;
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+void PlusFft::Transform(double* data) const
+{
+  // Reorder the values to bit reversed order
+  for (std::vector<unsigned int>::const_iterator swapIt = this->BitReversalSwaps.begin(); swapIt != this->BitReversalSwaps.end(); swapIt += 2)
+  {
+    double* a = data + 2 * swapIt[0];
+    double* b = data + 2 * swapIt[1];
+    double re = a[0];
+    double im = a[1];
+    a[0] = b[0];
+    a[1] = b[1];
+    b[0] = re;
+    b[1] = im;
+  }
+
+  // First stage: all twiddle factors are 1
+  for (unsigned int i = 0; i + 1 < this->Length; i += 2)
+  {
+    double* a = data + 2 * i;
+    double re = a[2];
+    double im = a[3];
+    a[2] = a[0] - re;
+    a[3] = a[1] - im;
+    a[0] += re;
+    a[1] += im;
+  }
+
+  // Radix-2 butterflies of the remaining stages
+  for (unsigned int halfSize = 2; halfSize < this->Length; halfSize *= 2)
+  {
+    const double* stageTwiddles = &this->Twiddles[2 * (halfSize - 1)];
+    for (unsigned int start = 0; start < this->Length; start += 2 * halfSize)
+    {
+      double* a = data + 2 * start;
+      double* b = a + 2 * halfSize;
+      for (unsigned int k = 0; k < halfSize; k++)
+      {
+        double wRe = stageTwiddles[2 * k];
+        double wIm = stageTwiddles[2 * k + 1];
+        double re = wRe * b[2 * k] - wIm * b[2 * k + 1];
+        double im = wRe * b[2 * k + 1] + wIm * b[2 * k];
+        b[2 * k] = a[2 * k] - re;
+        b[2 * k + 1] = a[2 * k + 1] - im;
+        a[2 * k] += re;
+        a[2 * k + 1] += im;
+      }
+    }
+  }
+}
+
+//----------------------------------------------------------------------------
+void PlusFft::InverseTransform(double* data) const
+{
+  // ifft(x) = conj(fft(conj(x)))/n
+  for (unsigned int i = 0; i < this->Length; i++)
+  {
+    data[2 * i + 1] = -data[2 * i + 1];
+  }
+  this->Transform(data);
+  double scale = 1.0 / this->Length;
+  for (unsigned int i = 0; i < this->Length; i++)
+  {
+    data[2 * i] *= scale;
+    data[2 * i + 1] *= -scale;
+  }
+}
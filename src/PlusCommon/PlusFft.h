@@ -0,0 +1,63 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+#ifndef __PlusFft_h
+#define __PlusFft_h
+
+#include "PlusCommon.h"
+#include "vtkPlusCommonExport.h"
+
+#include <vector>
+
+/*!
+  \class PlusFft
+  \brief Fast Fourier transform of complex data with power of two length
+
+  The object stores the plan of the transform (bit reversal permutation and the twiddle factors
+  of each butterfly stage), so that it can be reused for transforming many signals of the same length.
+  Complex values are stored as interleaved real and imaginary parts.
+
+  Transform and InverseTransform do not modify the object, so the same plan can be used by multiple threads.
+
+  \ingroup PlusLibCommon
+*/
+class vtkPlusCommonExport PlusFft
+{
+public:
+  PlusFft();
+  virtual ~PlusFft();
+
+  /*! Prepare the plan for the specified number of complex values. The length must be a power of two. Does nothing if the plan is already prepared for this length. */
+  PlusStatus SetLength(unsigned int length);
+
+  /*! Get the number of complex values that the plan is prepared for (0 if not prepared yet) */
+  unsigned int GetLength() const { return this->Length; }
+
+  /*! Compute the discrete Fourier transform in place. data contains Length complex values (2*Length doubles). */
+  void Transform(double* data) const;
+
+  /*! Compute the inverse discrete Fourier transform in place, including the division by Length. data contains Length complex values (2*Length doubles). */
+  void InverseTransform(double* data) const;
+
+  /*! Get the smallest power of two that is not smaller than the specified length */
+  static unsigned int GetPowerOfTwoLength(unsigned int minimumLength);
+
+protected:
+  /*! Number of complex values in the transformed signal */
+  unsigned int Length;
+
+  /*! Pairs of indices that are swapped for bit reversal permutation */
+  std::vector<unsigned int> BitReversalSwaps;
+
+  /*! Twiddle factors (interleaved cos, -sin values) of all stages. Stage with half size h starts at complex value index h-1. */
+  std::vector<double> Twiddles;
+
+private:
+  PlusFft(const PlusFft&);  // Not implemented.
+  void operator=(const PlusFft&);  // Not implemented.
+};
+
+#endif
@@ -0,0 +1,478 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+#include "PlusConfigure.h"
+#include "PlusIncrementalLeastSquares.h"
+
+#include <algorithm>
+#include <math.h>
+
+namespace
+{
+  const double DEFAULT_OUTLIER_THRESHOLD = 3.0;
+  const unsigned int DEFAULT_NUMBER_OF_INITIALIZATION_OBSERVATIONS = 20;
+  const unsigned int DEFAULT_CONVERGENCE_WINDOW_SIZE = 20;
+  const double DEFAULT_CONVERGENCE_TOLERANCE = 0.05;
+
+  // Maximum number of reweighting iterations during initialization
+  const int MAX_NUMBER_OF_REWEIGHTING_ITERATIONS = 10;
+  // Number of concentration steps that are performed from each starting subset when computing the initial robust solution
+  const int NUMBER_OF_CONCENTRATION_STEPS = 3;
+  // Minimum number of stored observations for computing the initial robust solution from subsets
+  const unsigned int MIN_NUMBER_OF_OBSERVATIONS_FOR_SUBSET_SEARCH = 4;
+  // Pivots of the LDL^T decomposition that are smaller than this fraction of the corresponding diagonal element are considered to be zero
+  const double SINGULAR_PIVOT_TOLERANCE = 1e-10;
+}
+
+//----------------------------------------------------------------------------
+PlusIncrementalLeastSquares::PlusIncrementalLeastSquares()
+  : NumberOfUnknowns(0)
+  , NumberOfRightHandSides(0)
+  , RightHandSideSumOfSquares(0)
+  , InlierRightHandSideSumOfSquares(0)
+  , NumberOfInlierObservations(0)
+  , NumberOfObservations(0)
+  , NumberOfOutlierObservations(0)
+  , SolutionUpToDate(false)
+  , SolutionStatus(PLUS_FAIL)
+  , OutlierThreshold(DEFAULT_OUTLIER_THRESHOLD)
+  , NumberOfInitializationObservations(DEFAULT_NUMBER_OF_INITIALIZATION_OBSERVATIONS)
+  , ConvergenceWindowSize(DEFAULT_CONVERGENCE_WINDOW_SIZE)
+  , ConvergenceTolerance(DEFAULT_CONVERGENCE_TOLERANCE)
+  , ConvergenceWindowStartRmsError(-1.0)
+  , ConvergenceWindowStartNumberOfObservations(0)
+  , Converged(false)
+{
+}
+
+//----------------------------------------------------------------------------
+PlusIncrementalLeastSquares::~PlusIncrementalLeastSquares()
+{
+}
+
+//----------------------------------------------------------------------------
+void PlusIncrementalLeastSquares::Initialize(unsigned int numberOfUnknowns, unsigned int numberOfRightHandSides)
+{
+  this->NumberOfUnknowns = numberOfUnknowns;
+  this->NumberOfRightHandSides = numberOfRightHandSides;
+  this->NormalMatrix.assign(numberOfUnknowns * numberOfUnknowns, 0.0);
+  this->NormalRightHandSide.assign(numberOfUnknowns * numberOfRightHandSides, 0.0);
+  this->RightHandSideSumOfSquares = 0;
+  this->InlierNormalMatrix.assign(numberOfUnknowns * numberOfUnknowns, 0.0);
+  this->InlierNormalRightHandSide.assign(numberOfUnknowns * numberOfRightHandSides, 0.0);
+  this->InlierRightHandSideSumOfSquares = 0;
+  this->NumberOfInlierObservations = 0;
+  this->NumberOfObservations = 0;
+  this->NumberOfOutlierObservations = 0;
+  this->InitializationA.clear();
+  this->InitializationB.clear();
+  this->InitializationNumberOfRows.clear();
+  this->InitializationWeights.clear();
+  this->Solution.clear();
+  this->SolutionUpToDate = false;
+  this->SolutionStatus = PLUS_FAIL;
+  this->ConvergenceWindowStartRmsError = -1.0;
+  this->ConvergenceWindowStartNumberOfObservations = 0;
+  this->Converged = false;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus PlusIncrementalLeastSquares::AddObservation(const double* a, const double* b, unsigned int numberOfRows)
+{
+  if (this->NumberOfUnknowns == 0 || this->NumberOfRightHandSides == 0)
+  {
+    LOG_ERROR("PlusIncrementalLeastSquares::AddObservation failed: the solver is not initialized");
+    return PLUS_FAIL;
+  }
+  if (numberOfRows == 0)
+  {
+    LOG_ERROR("PlusIncrementalLeastSquares::AddObservation failed: the observation is empty");
+    return PLUS_FAIL;
+  }
+
+  this->NumberOfObservations++;
+
+  if (this->NumberOfObservations <= this->NumberOfInitializationObservations)
+  {
+    // Store the observation and recompute the weights of all the stored observations
+    this->InitializationA.insert(this->InitializationA.end(), a, a + numberOfRows * this->NumberOfUnknowns);
+    this->InitializationB.insert(this->InitializationB.end(), b, b + numberOfRows * this->NumberOfRightHandSides);
+    this->InitializationNumberOfRows.push_back(numberOfRows);
+    this->InitializationWeights.push_back(1.0);
+    ReweightInitializationObservations();
+
+    if (this->NumberOfObservations == this->NumberOfInitializationObservations)
+    {
+      // Initialization is completed, the weights of these observations will not change anymore
+      std::vector<double>().swap(this->InitializationA);
+      std::vector<double>().swap(this->InitializationB);
+      std::vector<unsigned int>().swap(this->InitializationNumberOfRows);
+      std::vector<double>().swap(this->InitializationWeights);
+      this->ConvergenceWindowStartNumberOfObservations = this->NumberOfObservations;
+      this->ConvergenceWindowStartRmsError = GetRmsError();
+    }
+    return PLUS_SUCCESS;
+  }
+
+  // Down-weight the observation if it is an outlier for the current solution
+  double weight = 1.0;
+  if (this->OutlierThreshold > 0 && UpdateSolution() == PLUS_SUCCESS)
+  {
+    double residualThreshold = this->OutlierThreshold * GetRmsError();
+    double residual = ComputeResidualNorm(a, b, numberOfRows, this->Solution);
+    if (residualThreshold > 0 && residual > residualThreshold)
+    {
+      weight = (residualThreshold / residual) * (residualThreshold / residual);
+      this->NumberOfOutlierObservations++;
+    }
+  }
+
+  AccumulateObservation(a, b, numberOfRows, weight);
+  UpdateConvergence();
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+void PlusIncrementalLeastSquares::AccumulateObservation(const double* a, const double* b, unsigned int numberOfRows, double weight)
+{
+  const unsigned int n = this->NumberOfUnknowns;
+  const unsigned int k = this->NumberOfRightHandSides;
+  // Outliers have a weight below 1, they only contribute to the solution
+  const bool inlier = (weight >= 1.0);
+  for (unsigned int row = 0; row < numberOfRows; row++)
+  {
+    const double* aRow = a + row * n;
+    const double* bRow = b + row * k;
+    for (unsigned int i = 0; i < n; i++)
+    {
+      if (aRow[i] == 0)
+      {
+        continue;
+      }
+      double weightedA = weight * aRow[i];
+      for (unsigned int j = 0; j < n; j++)
+      {
+        this->NormalMatrix[i * n + j] += weightedA * aRow[j];
+        if (inlier)
+        {
+          this->InlierNormalMatrix[i * n + j] += aRow[i] * aRow[j];
+        }
+      }
+      for (unsigned int j = 0; j < k; j++)
+      {
+        this->NormalRightHandSide[i * k + j] += weightedA * bRow[j];
+        if (inlier)
+        {
+          this->InlierNormalRightHandSide[i * k + j] += aRow[i] * bRow[j];
+        }
+      }
+    }
+    for (unsigned int j = 0; j < k; j++)
+    {
+      this->RightHandSideSumOfSquares += weight * bRow[j] * bRow[j];
+      if (inlier)
+      {
+        this->InlierRightHandSideSumOfSquares += bRow[j] * bRow[j];
+      }
+    }
+  }
+  if (inlier)
+  {
+    this->NumberOfInlierObservations++;
+  }
+  this->SolutionUpToDate = false;
+}
+
+//----------------------------------------------------------------------------
+double PlusIncrementalLeastSquares::ComputeResidualNorm(const double* a, const double* b, unsigned int numberOfRows, const std::vector<double>& x) const
+{
+  const unsigned int n = this->NumberOfUnknowns;
+  const unsigned int k = this->NumberOfRightHandSides;
+  double sumOfSquares = 0;
+  for (unsigned int row = 0; row < numberOfRows; row++)
+  {
+    for (unsigned int j = 0; j < k; j++)
+    {
+      double residual = -b[row * k + j];
+      for (unsigned int i = 0; i < n; i++)
+      {
+        residual += a[row * n + i] * x[i * k + j];
+      }
+      sumOfSquares += residual * residual;
+    }
+  }
+  return sqrt(sumOfSquares);
+}
+
+//----------------------------------------------------------------------------
+PlusStatus PlusIncrementalLeastSquares::SolveNormalEquations(std::vector<double>& x) const
+{
+  const unsigned int n = this->NumberOfUnknowns;
+  const unsigned int k = this->NumberOfRightHandSides;
+
+  // LDL^T decomposition: D is stored in the diagonal, L (unit lower triangular) below the diagonal
+  std::vector<double> ldl(this->NormalMatrix);
+  for (unsigned int j = 0; j < n; j++)
+  {
+    double d = ldl[j * n + j];
+    for (unsigned int p = 0; p < j; p++)
+    {
+      d -= ldl[j * n + p] * ldl[j * n + p] * ldl[p * n + p];
+    }
+    if (d <= SINGULAR_PIVOT_TOLERANCE * this->NormalMatrix[j * n + j])
+    {
+      // the observations do not determine all the unknowns
+      return PLUS_FAIL;
+    }
+    ldl[j * n + j] = d;
+    for (unsigned int i = j + 1; i < n; i++)
+    {
+      double v = ldl[i * n + j];
+      for (unsigned int p = 0; p < j; p++)
+      {
+        v -= ldl[i * n + p] * ldl[j * n + p] * ldl[p * n + p];
+      }
+      ldl[i * n + j] = v / d;
+    }
+  }
+
+  x = this->NormalRightHandSide;
+  for (unsigned int column = 0; column < k; column++)
+  {
+    // Solve L*y=c, then D*z=y, then L^T*x=z
+    for (unsigned int i = 0; i < n; i++)
+    {
+      for (unsigned int p = 0; p < i; p++)
+      {
+        x[i * k + column] -= ldl[i * n + p] * x[p * k + column];
+      }
+    }
+    for (unsigned int i = 0; i < n; i++)
+    {
+      x[i * k + column] /= ldl[i * n + i];
+    }
+    for (int i = n - 1; i >= 0; i--)
+    {
+      for (unsigned int p = i + 1; p < n; p++)
+      {
+        x[i * k + column] -= ldl[p * n + i] * x[p * k + column];
+      }
+    }
+  }
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus PlusIncrementalLeastSquares::UpdateSolution()
+{
+  if (!this->SolutionUpToDate)
+  {
+    this->SolutionStatus = SolveNormalEquations(this->Solution);
+    this->SolutionUpToDate = true;
+  }
+  return this->SolutionStatus;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus PlusIncrementalLeastSquares::GetSolution(std::vector<double>& x)
+{
+  if (UpdateSolution() != PLUS_SUCCESS)
+  {
+    return PLUS_FAIL;
+  }
+  x = this->Solution;
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+double PlusIncrementalLeastSquares::GetRmsError()
+{
+  if (this->NumberOfInlierObservations == 0 || UpdateSolution() != PLUS_SUCCESS)
+  {
+    return -1.0;
+  }
+
+  // Sum of squared residuals of the inliers: sum(|A_i*X-B_i|^2) = trace(X^T*N*X) - 2*trace(X^T*C) + sum(|B_i|^2)
+  const unsigned int n = this->NumberOfUnknowns;
+  const unsigned int k = this->NumberOfRightHandSides;
+  double sumOfSquares = this->InlierRightHandSideSumOfSquares;
+  for (unsigned int column = 0; column < k; column++)
+  {
+    for (unsigned int i = 0; i < n; i++)
+    {
+      double normalMatrixTimesX = 0;
+      for (unsigned int j = 0; j < n; j++)
+      {
+        normalMatrixTimesX += this->InlierNormalMatrix[i * n + j] * this->Solution[j * k + column];
+      }
+      sumOfSquares += this->Solution[i * k + column] * (normalMatrixTimesX - 2.0 * this->InlierNormalRightHandSide[i * k + column]);
+    }
+  }
+
+  // The sum may be slightly negative due to rounding errors
+  return sqrt(std::max(0.0, sumOfSquares) / this->NumberOfInlierObservations);
+}
+
+//----------------------------------------------------------------------------
+void PlusIncrementalLeastSquares::RebuildNormalEquations(const std::vector<double>& weights)
+{
+  std::fill(this->NormalMatrix.begin(), this->NormalMatrix.end(), 0.0);
+  std::fill(this->NormalRightHandSide.begin(), this->NormalRightHandSide.end(), 0.0);
+  this->RightHandSideSumOfSquares = 0;
+  std::fill(this->InlierNormalMatrix.begin(), this->InlierNormalMatrix.end(), 0.0);
+  std::fill(this->InlierNormalRightHandSide.begin(), this->InlierNormalRightHandSide.end(), 0.0);
+  this->InlierRightHandSideSumOfSquares = 0;
+  this->NumberOfInlierObservations = 0;
+  const double* a = this->InitializationA.empty() ? NULL : &this->InitializationA[0];
+  const double* b = this->InitializationB.empty() ? NULL : &this->InitializationB[0];
+  for (unsigned int observationIndex = 0; observationIndex < this->InitializationNumberOfRows.size(); observationIndex++)
+  {
+    if (weights[observationIndex] > 0)
+    {
+      AccumulateObservation(a, b, this->InitializationNumberOfRows[observationIndex], weights[observationIndex]);
+    }
+    a += this->InitializationNumberOfRows[observationIndex] * this->NumberOfUnknowns;
+    b += this->InitializationNumberOfRows[observationIndex] * this->NumberOfRightHandSides;
+  }
+  this->SolutionUpToDate = false;
+}
+
+//----------------------------------------------------------------------------
+void PlusIncrementalLeastSquares::ComputeInitializationResiduals(const std::vector<double>& x, std::vector<double>& residuals) const
+{
+  residuals.resize(this->InitializationNumberOfRows.size());
+  const double* a = &this->InitializationA[0];
+  const double* b = &this->InitializationB[0];
+  for (unsigned int observationIndex = 0; observationIndex < this->InitializationNumberOfRows.size(); observationIndex++)
+  {
+    residuals[observationIndex] = ComputeResidualNorm(a, b, this->InitializationNumberOfRows[observationIndex], x);
+    a += this->InitializationNumberOfRows[observationIndex] * this->NumberOfUnknowns;
+    b += this->InitializationNumberOfRows[observationIndex] * this->NumberOfRightHandSides;
+  }
+}
+
+//----------------------------------------------------------------------------
+bool PlusIncrementalLeastSquares::ComputeTrimmedInitializationWeights()
+{
+  const unsigned int numberOfObservations = this->InitializationNumberOfRows.size();
+  const unsigned int subsetSize = (numberOfObservations + 3) / 4;
+  const unsigned int trimmedSize = (numberOfObservations + 1) / 2;
+
+  // Least trimmed squares: starting from the solution of each subset of consecutive observations, keep the half of the
+  // observations that have the smallest residuals and solve again. The start that leads to the smallest sum of squares
+  // of the kept residuals is used. A few gross outliers cannot bias this solution, as most of the subsets do not contain them.
+  std::vector<double> weights(numberOfObservations);
+  std::vector<double> residuals;
+  std::vector<double> sortedResiduals;
+  double bestTrimmedSumOfSquares = -1;
+  for (unsigned int startIndex = 0; startIndex < numberOfObservations; startIndex++)
+  {
+    std::fill(weights.begin(), weights.end(), 0.0);
+    for (unsigned int i = 0; i < subsetSize; i++)
+    {
+      weights[(startIndex + i) % numberOfObservations] = 1.0;
+    }
+
+    bool solved = true;
+    double trimmedSumOfSquares = 0;
+    for (int step = 0; step < NUMBER_OF_CONCENTRATION_STEPS; step++)
+    {
+      RebuildNormalEquations(weights);
+      if (UpdateSolution() != PLUS_SUCCESS)
+      {
+        solved = false;
+        break;
+      }
+      ComputeInitializationResiduals(this->Solution, residuals);
+      sortedResiduals = residuals;
+      std::nth_element(sortedResiduals.begin(), sortedResiduals.begin() + trimmedSize - 1, sortedResiduals.end());
+      double residualThreshold = sortedResiduals[trimmedSize - 1];
+      trimmedSumOfSquares = 0;
+      for (unsigned int observationIndex = 0; observationIndex < numberOfObservations; observationIndex++)
+      {
+        weights[observationIndex] = (residuals[observationIndex] <= residualThreshold ? 1.0 : 0.0);
+        trimmedSumOfSquares += weights[observationIndex] * residuals[observationIndex] * residuals[observationIndex];
+      }
+    }
+
+    if (solved && (bestTrimmedSumOfSquares < 0 || trimmedSumOfSquares < bestTrimmedSumOfSquares))
+    {
+      bestTrimmedSumOfSquares = trimmedSumOfSquares;
+      this->InitializationWeights = weights;
+    }
+  }
+  return (bestTrimmedSumOfSquares >= 0);
+}
+
+//----------------------------------------------------------------------------
+void PlusIncrementalLeastSquares::ReweightInitializationObservations()
+{
+  const unsigned int numberOfObservations = this->InitializationNumberOfRows.size();
+  if (this->OutlierThreshold <= 0
+      || numberOfObservations < MIN_NUMBER_OF_OBSERVATIONS_FOR_SUBSET_SEARCH
+      || !ComputeTrimmedInitializationWeights())
+  {
+    std::fill(this->InitializationWeights.begin(), this->InitializationWeights.end(), 1.0);
+  }
+
+  std::vector<double> residuals;
+  for (int iteration = 0; ; iteration++)
+  {
+    RebuildNormalEquations(this->InitializationWeights);
+    if (iteration >= MAX_NUMBER_OF_REWEIGHTING_ITERATIONS || this->OutlierThreshold <= 0 || UpdateSolution() != PLUS_SUCCESS)
+    {
+      break;
+    }
+
+    // Compute new weights, using the median residual as error scale
+    ComputeInitializationResiduals(this->Solution, residuals);
+    std::vector<double> sortedResiduals(residuals);
+    std::nth_element(sortedResiduals.begin(), sortedResiduals.begin() + numberOfObservations / 2, sortedResiduals.end());
+    double residualThreshold = this->OutlierThreshold * sortedResiduals[numberOfObservations / 2];
+
+    bool weightsChanged = false;
+    for (unsigned int observationIndex = 0; observationIndex < numberOfObservations; observationIndex++)
+    {
+      double weight = 1.0;
+      if (residualThreshold > 0 && residuals[observationIndex] > residualThreshold)
+      {
+        weight = (residualThreshold / residuals[observationIndex]) * (residualThreshold / residuals[observationIndex]);
+      }
+      if (fabs(weight - this->InitializationWeights[observationIndex]) > 1e-6)
+      {
+        weightsChanged = true;
+      }
+      this->InitializationWeights[observationIndex] = weight;
+    }
+    if (!weightsChanged)
+    {
+      break;
+    }
+  }
+
+  this->NumberOfOutlierObservations = 0;
+  for (unsigned int observationIndex = 0; observationIndex < numberOfObservations; observationIndex++)
+  {
+    if (this->InitializationWeights[observationIndex] < 1.0)
+    {
+      this->NumberOfOutlierObservations++;
+    }
+  }
+}
+
+//----------------------------------------------------------------------------
+void PlusIncrementalLeastSquares::UpdateConvergence()
+{
+  if (this->ConvergenceWindowSize == 0 || this->NumberOfObservations - this->ConvergenceWindowStartNumberOfObservations < this->ConvergenceWindowSize)
+  {
+    return;
+  }
+  double rmsError = GetRmsError();
+  this->Converged = (rmsError >= 0 && this->ConvergenceWindowStartRmsError >= 0
+                     && fabs(rmsError - this->ConvergenceWindowStartRmsError) <= this->ConvergenceTolerance * this->ConvergenceWindowStartRmsError);
+  this->ConvergenceWindowStartRmsError = rmsError;
+  this->ConvergenceWindowStartNumberOfObservations = this->NumberOfObservations;
+}
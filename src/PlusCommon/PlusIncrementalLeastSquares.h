@@ -0,0 +1,169 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+#ifndef __PlusIncrementalLeastSquares_h
+#define __PlusIncrementalLeastSquares_h
+
+#include "PlusCommon.h"
+#include "vtkPlusCommonExport.h"
+
+#include <vector>
+
+/*!
+  \class PlusIncrementalLeastSquares
+  \brief Robust linear least squares solver that is updated in constant time when a new observation is added
+
+  Solves the AX=B problem, where X has NumberOfUnknowns rows and NumberOfRightHandSides columns.
+  Each observation is a block of rows of A and B (for example, the 3 equations that a tracked pose gives in pivot calibration).
+  Only the weighted normal equations (A^T*W*A, A^T*W*B, and the weighted sum of squares of B) are stored, therefore
+  the time and memory needed for adding an observation and for computing the solution do not depend on the number of observations.
+
+  The residual of an observation is the norm of A_i*X-B_i. Observations with a residual larger than OutlierThreshold times the
+  RMS residual of the inliers for the current solution are considered as outliers and they are added with a weight of (threshold/residual)^2,
+  so that an outlier cannot increase the sum of squared residuals more than an inlier with the threshold residual.
+  The normal equations of the inliers are accumulated separately, so that outliers do not increase the reported RMS residual and
+  the outlier threshold (which would let more and more outliers in if the ratio of outliers is high).
+  The weight is determined when the observation is added and it is not changed later. The first NumberOfInitializationObservations
+  observations are stored and reweighted iteratively (starting from a least trimmed squares solution and using the median residual
+  as error scale, which are not affected by outliers), so that outliers at the beginning of the acquisition do not bias the initial solution.
+
+  The solution is considered to be converged if the RMS residual changed by less than ConvergenceTolerance (relative to the previous
+  value) during the last ConvergenceWindowSize observations. This can be used for stopping data acquisition when
+  adding more observations would not improve the result significantly.
+
+  Matrices are stored in row-major order.
+
+  \ingroup PlusLibCommon
+*/
+class vtkPlusCommonExport PlusIncrementalLeastSquares
+{
+public:
+  PlusIncrementalLeastSquares();
+  virtual ~PlusIncrementalLeastSquares();
+
+  /*! Remove all observations and set the size of the problem. Outlier rejection and convergence settings are not changed. */
+  void Initialize(unsigned int numberOfUnknowns, unsigned int numberOfRightHandSides);
+
+  /*!
+    Add an observation
+    \param a Rows of the A matrix (numberOfRows x NumberOfUnknowns values)
+    \param b Rows of the B matrix (numberOfRows x NumberOfRightHandSides values)
+    \param numberOfRows Number of rows (equations) in the observation
+  */
+  PlusStatus AddObservation(const double* a, const double* b, unsigned int numberOfRows);
+
+  /*!
+    Get the least squares solution for all the observations that have been added so far
+    \param x Solution matrix (NumberOfUnknowns x NumberOfRightHandSides values)
+    \return PLUS_FAIL if the observations do not determine all the unknowns
+  */
+  PlusStatus GetSolution(std::vector<double>& x);
+
+  /*! Get the root mean square of the residuals of the inlier observations for the current solution. Returns -1 if there is no solution yet. */
+  double GetRmsError();
+
+  /*! Get the number of observations that have been added */
+  unsigned int GetNumberOfObservations() const { return this->NumberOfObservations; }
+
+  /*! Get the number of observations that have been added with a reduced weight, because they were detected as outliers */
+  unsigned int GetNumberOfOutlierObservations() const { return this->NumberOfOutlierObservations; }
+
+  /*! Returns true if the RMS residual has not changed significantly during the last ConvergenceWindowSize observations */
+  bool GetConverged() const { return this->Converged; }
+
+  /*! Observations with larger residual than OutlierThreshold times the error scale are down-weighted. Outlier rejection is disabled if the value is 0. */
+  void SetOutlierThreshold(double threshold) { this->OutlierThreshold = threshold; }
+  double GetOutlierThreshold() const { return this->OutlierThreshold; }
+
+  /*! Number of observations that are stored and reweighted iteratively at the beginning of the acquisition */
+  void SetNumberOfInitializationObservations(unsigned int numberOfObservations) { this->NumberOfInitializationObservations = numberOfObservations; }
+  unsigned int GetNumberOfInitializationObservations() const { return this->NumberOfInitializationObservations; }
+
+  /*! Number of observations between two convergence checks */
+  void SetConvergenceWindowSize(unsigned int numberOfObservations) { this->ConvergenceWindowSize = numberOfObservations; }
+  unsigned int GetConvergenceWindowSize() const { return this->ConvergenceWindowSize; }
+
+  /*! Maximum relative change of the RMS residual between two convergence checks for considering the solution converged */
+  void SetConvergenceTolerance(double tolerance) { this->ConvergenceTolerance = tolerance; }
+  double GetConvergenceTolerance() const { return this->ConvergenceTolerance; }
+
+protected:
+  /*! Add the weighted observation to the normal equations. Observations with a weight of 1 are added to the inlier normal equations as well. */
+  void AccumulateObservation(const double* a, const double* b, unsigned int numberOfRows, double weight);
+
+  /*! Compute the norm of the residual of an observation for the specified solution */
+  double ComputeResidualNorm(const double* a, const double* b, unsigned int numberOfRows, const std::vector<double>& x) const;
+
+  /*! Solve the normal equations by LDL^T decomposition. Returns PLUS_FAIL if the normal matrix is singular. */
+  PlusStatus SolveNormalEquations(std::vector<double>& x) const;
+
+  /*! Solve the normal equations if observations have been added since the last solution */
+  PlusStatus UpdateSolution();
+
+  /*! Rebuild the normal equations from the stored initialization observations with the specified weights */
+  void RebuildNormalEquations(const std::vector<double>& weights);
+
+  /*! Compute the residual norm of each stored initialization observation for the specified solution */
+  void ComputeInitializationResiduals(const std::vector<double>& x, std::vector<double>& residuals) const;
+
+  /*! Set 0/1 initialization weights by least trimmed squares. Returns false if none of the subsets determine all the unknowns. */
+  bool ComputeTrimmedInitializationWeights();
+
+  /*! Compute the weights of the stored initialization observations by iteratively reweighted least squares and rebuild the normal equations */
+  void ReweightInitializationObservations();
+
+  /*! Check if the RMS residual changed since the beginning of the convergence window */
+  void UpdateConvergence();
+
+protected:
+  unsigned int NumberOfUnknowns;
+  unsigned int NumberOfRightHandSides;
+
+  /*! Sum of A_i^T*w_i*A_i (NumberOfUnknowns x NumberOfUnknowns) */
+  std::vector<double> NormalMatrix;
+  /*! Sum of A_i^T*w_i*B_i (NumberOfUnknowns x NumberOfRightHandSides) */
+  std::vector<double> NormalRightHandSide;
+  /*! Sum of w_i*|B_i|^2 */
+  double RightHandSideSumOfSquares;
+
+  /*! Sum of A_i^T*A_i of the inlier observations (NumberOfUnknowns x NumberOfUnknowns) */
+  std::vector<double> InlierNormalMatrix;
+  /*! Sum of A_i^T*B_i of the inlier observations (NumberOfUnknowns x NumberOfRightHandSides) */
+  std::vector<double> InlierNormalRightHandSide;
+  /*! Sum of |B_i|^2 of the inlier observations */
+  double InlierRightHandSideSumOfSquares;
+  /*! Number of inlier observations */
+  unsigned int NumberOfInlierObservations;
+
+  unsigned int NumberOfObservations;
+  unsigned int NumberOfOutlierObservations;
+
+  /*! A and B rows of the observations that are stored during initialization */
+  std::vector<double> InitializationA;
+  std::vector<double> InitializationB;
+  /*! Number of rows of each observation that is stored during initialization */
+  std::vector<unsigned int> InitializationNumberOfRows;
+  /*! Weight of each observation that is stored during initialization */
+  std::vector<double> InitializationWeights;
+
+  /*! Solution of the current normal equations, valid if SolutionUpToDate is true */
+  std::vector<double> Solution;
+  bool SolutionUpToDate;
+  PlusStatus SolutionStatus;
+
+  double OutlierThreshold;
+  unsigned int NumberOfInitializationObservations;
+  unsigned int ConvergenceWindowSize;
+  double ConvergenceTolerance;
+
+  /*! RMS residual at the beginning of the current convergence window (-1 if not available) */
+  double ConvergenceWindowStartRmsError;
+  /*! Number of observations at the beginning of the current convergence window */
+  unsigned int ConvergenceWindowStartNumberOfObservations;
+  bool Converged;
+};
+
+#endif
@@ -24,6 +24,17 @@ const std::string PlusTrackedFrame::TransformPostfix = "Transform";
 const std::string PlusTrackedFrame::TransformStatusPostfix = "TransformStatus";
 const int FLOATING_POINT_PRECISION = 16; // Number of digits used when writing transforms and timestamps
 
+//----------------------------------------------------------------------------
+PlusTrackedFrame::FrameTransformEntry::FrameTransformEntry()
+  : Status(FIELD_INVALID)
+  , MatrixDefined(false)
+  , StatusDefined(false)
+  , MatrixTextModified(false)
+  , StatusTextModified(false)
+{
+  vtkMatrix4x4::Identity(this->Matrix);
+}
+
 //----------------------------------------------------------------------------
 PlusTrackedFrame::PlusTrackedFrame()
 {
@@ -61,7 +72,11 @@ PlusTrackedFrame& PlusTrackedFrame::operator=(PlusTrackedFrame const& trackedFra
     return *this;
   }
 
-  this->CustomFrameFields = trackedFrame.CustomFrameFields;
+  {
+    PlusLockGuard<vtkPlusSimpleRecursiveCriticalSection> transformFieldsGuard(&trackedFrame.TransformFieldsMutex);
+    this->CustomFrameFields = trackedFrame.CustomFrameFields;
+    this->FrameTransforms = trackedFrame.FrameTransforms;
+  }
   this->ImageData = trackedFrame.ImageData;
   this->Timestamp = trackedFrame.Timestamp;
   this->FrameSize[0] = trackedFrame.FrameSize[0];
@@ -72,6 +87,27 @@ PlusTrackedFrame& PlusTrackedFrame::operator=(PlusTrackedFrame const& trackedFra
   return *this;
 }
 
+//----------------------------------------------------------------------------
+void PlusTrackedFrame::ShallowCopy(const PlusTrackedFrame& trackedFrame)
+{
+  if (this == &trackedFrame)
+  {
+    return;
+  }
+
+  {
+    PlusLockGuard<vtkPlusSimpleRecursiveCriticalSection> transformFieldsGuard(&trackedFrame.TransformFieldsMutex);
+    this->CustomFrameFields = trackedFrame.CustomFrameFields;
+    this->FrameTransforms = trackedFrame.FrameTransforms;
+  }
+  this->ImageData.ShallowCopy(trackedFrame.ImageData);
+  this->Timestamp = trackedFrame.Timestamp;
+  this->FrameSize[0] = trackedFrame.FrameSize[0];
+  this->FrameSize[1] = trackedFrame.FrameSize[1];
+  this->FrameSize[2] = trackedFrame.FrameSize[2];
+  this->SetFiducialPointsCoordinatePx(trackedFrame.FiducialPointsCoordinatePx);
+}
+
 //----------------------------------------------------------------------------
 PlusStatus PlusTrackedFrame::GetTrackedFrameInXmlData(std::string& strXmlData, const std::vector<PlusTransformName>& requestedTransforms)
 {
@@ -95,6 +131,9 @@ PlusStatus PlusTrackedFrame::PrintToXML(vtkXMLDataElement* trackedFrame, const s
     return PLUS_FAIL;
   }
 
+  PlusLockGuard<vtkPlusSimpleRecursiveCriticalSection> transformFieldsGuard(&this->TransformFieldsMutex);
+  this->UpdateTransformFields();
+
   trackedFrame->SetName("TrackedFrame");
   trackedFrame->SetDoubleAttribute("Timestamp", this->Timestamp);
   trackedFrame->SetAttribute("ImageDataValid", (this->GetImageData()->IsImageValid() ? "true" : "false"));
@@ -133,7 +172,8 @@ PlusStatus PlusTrackedFrame::PrintToXML(vtkXMLDataElement* trackedFrame, const s
       vtkSmartPointer<vtkXMLDataElement> customField = vtkSmartPointer<vtkXMLDataElement>::New();
       customField->SetName("CustomFrameField");
       customField->SetAttribute("Name", statusName.c_str());
-      customField->SetAttribute("Value", CustomFrameFields[statusName].c_str());
+      FieldMapType::const_iterator statusField = CustomFrameFields.find(statusName);
+      customField->SetAttribute("Value", statusField != CustomFrameFields.end() ? statusField->second.c_str() : "");
       trackedFrame->AddNestedElement(customField);
     }
     vtkSmartPointer<vtkXMLDataElement> customField = vtkSmartPointer<vtkXMLDataElement>::New();
@@ -286,6 +326,15 @@ void PlusTrackedFrame::SetImageData(const PlusVideoFrame& value)
   this->ImageData.GetFrameSize(this->FrameSize);
 }
 
+//----------------------------------------------------------------------------
+void PlusTrackedFrame::ShareImageData(const PlusVideoFrame& value)
+{
+  this->ImageData.ShallowCopy(value);
+
+  // Update our cached frame size
+  this->ImageData.GetFrameSize(this->FrameSize);
+}
+
 //----------------------------------------------------------------------------
 void PlusTrackedFrame::SetTimestamp(double value)
 {
@@ -353,6 +402,9 @@ void PlusTrackedFrame::SetCustomFrameField(std::string name, std::string value)
     }
   }
 
+  // The text value overrides any previously set binary transform of the same name
+  this->InvalidateFrameTransform(name);
+
   this->CustomFrameFields[name] = value;
 }
 
@@ -365,6 +417,12 @@ const char* PlusTrackedFrame::GetCustomFrameField(const char* fieldName)
     return NULL;
   }
 
+  PlusLockGuard<vtkPlusSimpleRecursiveCriticalSection> transformFieldsGuard(&this->TransformFieldsMutex);
+  if (IsTransform(fieldName) || IsTransformStatus(fieldName))
+  {
+    this->UpdateTransformFields();
+  }
+
   FieldMapType::iterator fieldIterator;
   fieldIterator = this->CustomFrameFields.find(fieldName);
   if (fieldIterator != this->CustomFrameFields.end())
@@ -389,6 +447,12 @@ PlusStatus PlusTrackedFrame::DeleteCustomFrameField(const char* fieldName)
     return PLUS_FAIL;
   }
 
+  if (IsTransform(fieldName) || IsTransformStatus(fieldName))
+  {
+    this->UpdateTransformFields();
+    this->InvalidateFrameTransform(fieldName);
+  }
+
   FieldMapType::iterator field = this->CustomFrameFields.find(fieldName);
   if (field != this->CustomFrameFields.end())
   {
@@ -403,6 +467,13 @@ PlusStatus PlusTrackedFrame::DeleteCustomFrameField(const char* fieldName)
 //----------------------------------------------------------------------------
 bool PlusTrackedFrame::IsCustomFrameTransformNameDefined(const PlusTransformName& transformName)
 {
+  PlusLockGuard<vtkPlusSimpleRecursiveCriticalSection> transformFieldsGuard(&this->TransformFieldsMutex);
+  FrameTransformMapType::iterator transformIt = this->FrameTransforms.find(transformName);
+  if (transformIt != this->FrameTransforms.end() && transformIt->second.MatrixDefined)
+  {
+    return true;
+  }
+
   std::string toolTransformName;
   if (transformName.GetTransformName(toolTransformName) != PLUS_SUCCESS)
   {
@@ -426,6 +497,12 @@ bool PlusTrackedFrame::IsCustomFrameFieldDefined(const char* fieldName)
     return false;
   }
 
+  PlusLockGuard<vtkPlusSimpleRecursiveCriticalSection> transformFieldsGuard(&this->TransformFieldsMutex);
+  if (IsTransform(fieldName) || IsTransformStatus(fieldName))
+  {
+    this->UpdateTransformFields();
+  }
+
   FieldMapType::iterator fieldIterator;
   fieldIterator = this->CustomFrameFields.find(fieldName);
   if (fieldIterator != this->CustomFrameFields.end())
@@ -440,6 +517,15 @@ bool PlusTrackedFrame::IsCustomFrameFieldDefined(const char* fieldName)
 //----------------------------------------------------------------------------
 PlusStatus PlusTrackedFrame::GetCustomFrameTransform(const PlusTransformName& frameTransformName, double transform[16])
 {
+  // Readers may add the parsed matrix to FrameTransforms, so the lookup is protected by the same lock as the text fields
+  PlusLockGuard<vtkPlusSimpleRecursiveCriticalSection> transformFieldsGuard(&this->TransformFieldsMutex);
+  FrameTransformMapType::iterator transformIt = this->FrameTransforms.find(frameTransformName);
+  if (transformIt != this->FrameTransforms.end() && transformIt->second.MatrixDefined)
+  {
+    std::copy(transformIt->second.Matrix, transformIt->second.Matrix + 16, transform);
+    return PLUS_SUCCESS;
+  }
+
   std::string transformName;
   if (frameTransformName.GetTransformName(transformName) != PLUS_SUCCESS)
   {
@@ -468,6 +554,17 @@ PlusStatus PlusTrackedFrame::GetCustomFrameTransform(const PlusTransformName& fr
   {
     transform[i++] = item;
   }
+
+  if (i == 16)
+  {
+    // Cache the parsed matrix, the text field is already up to date.
+    // The cached matrix is removed if the field is set or deleted through the text interface.
+    FrameTransformEntry& entry = this->FrameTransforms[frameTransformName];
+    std::copy(transform, transform + 16, entry.Matrix);
+    entry.MatrixDefined = true;
+    entry.MatrixTextModified = false;
+  }
+
   return PLUS_SUCCESS;
 }
 
@@ -485,6 +582,15 @@ PlusStatus PlusTrackedFrame::GetCustomFrameTransform(const PlusTransformName& fr
 PlusStatus PlusTrackedFrame::GetCustomFrameTransformStatus(const PlusTransformName& frameTransformName, TrackedFrameFieldStatus& status)
 {
   status = FIELD_INVALID;
+
+  PlusLockGuard<vtkPlusSimpleRecursiveCriticalSection> transformFieldsGuard(&this->TransformFieldsMutex);
+  FrameTransformMapType::iterator transformIt = this->FrameTransforms.find(frameTransformName);
+  if (transformIt != this->FrameTransforms.end() && transformIt->second.StatusDefined)
+  {
+    status = transformIt->second.Status;
+    return PLUS_SUCCESS;
+  }
+
   std::string transformStatusName;
   if (frameTransformName.GetTransformName(transformStatusName) != PLUS_SUCCESS)
   {
@@ -511,32 +617,28 @@ PlusStatus PlusTrackedFrame::GetCustomFrameTransformStatus(const PlusTransformNa
 
   status = PlusTrackedFrame::ConvertFieldStatusFromString(strStatus);
 
+  // Cache the parsed status, the text field is already up to date
+  FrameTransformEntry& entry = this->FrameTransforms[frameTransformName];
+  entry.Status = status;
+  entry.StatusDefined = true;
+  entry.StatusTextModified = false;
+
   return PLUS_SUCCESS;
 }
 
 //----------------------------------------------------------------------------
 PlusStatus PlusTrackedFrame::SetCustomFrameTransformStatus(const PlusTransformName& frameTransformName, TrackedFrameFieldStatus status)
 {
-  std::string transformStatusName;
-  if (frameTransformName.GetTransformName(transformStatusName) != PLUS_SUCCESS)
+  if (!frameTransformName.IsValid())
   {
     LOG_ERROR("Unable to set custom transform status, transform name is wrong!");
     return PLUS_FAIL;
   }
 
-  // Append TransformStatus to the end of the transform name
-  if (IsTransform(transformStatusName))
-  {
-    transformStatusName.append("Status");
-  }
-  else if (!IsTransformStatus(transformStatusName))
-  {
-    transformStatusName.append(TransformStatusPostfix);
-  }
-
-  std::string strStatus = PlusTrackedFrame::ConvertFieldStatusToString(status);
-
-  this->SetCustomFrameField(transformStatusName, strStatus);
+  FrameTransformEntry& entry = this->FrameTransforms[frameTransformName];
+  entry.Status = status;
+  entry.StatusDefined = true;
+  entry.StatusTextModified = true;
 
   return PLUS_SUCCESS;
 }
@@ -544,26 +646,16 @@ PlusStatus PlusTrackedFrame::SetCustomFrameTransformStatus(const PlusTransformNa
 //----------------------------------------------------------------------------
 PlusStatus PlusTrackedFrame::SetCustomFrameTransform(const PlusTransformName& frameTransformName, double transform[16])
 {
-  std::ostringstream strTransform;
-  for (int i = 0; i < 16; ++i)
+  if (!frameTransformName.IsValid())
   {
-    strTransform << std::setprecision(FLOATING_POINT_PRECISION) << transform[ i ] << " ";
-  }
-
-  std::string transformName;
-  if (frameTransformName.GetTransformName(transformName) != PLUS_SUCCESS)
-  {
-    LOG_ERROR("Unable to get custom transform, transform name is wrong!");
+    LOG_ERROR("Unable to set custom transform, transform name is wrong!");
     return PLUS_FAIL;
   }
 
-  // Append Transform to the end of the transform name
-  if (!IsTransform(transformName))
-  {
-    transformName.append(TransformPostfix);
-  }
-
-  SetCustomFrameField(transformName, strTransform.str());
+  FrameTransformEntry& entry = this->FrameTransforms[frameTransformName];
+  std::copy(transform, transform + 16, entry.Matrix);
+  entry.MatrixDefined = true;
+  entry.MatrixTextModified = true;
 
   return PLUS_SUCCESS;
 }
@@ -576,6 +668,91 @@ PlusStatus PlusTrackedFrame::SetCustomFrameTransform(const PlusTransformName& fr
   return SetCustomFrameTransform(frameTransformName, dTransform);
 }
 
+//----------------------------------------------------------------------------
+void PlusTrackedFrame::UpdateTransformFields()
+{
+  PlusLockGuard<vtkPlusSimpleRecursiveCriticalSection> transformFieldsGuard(&this->TransformFieldsMutex);
+  for (FrameTransformMapType::iterator transformIt = this->FrameTransforms.begin(); transformIt != this->FrameTransforms.end(); ++transformIt)
+  {
+    FrameTransformEntry& entry = transformIt->second;
+    if (!entry.MatrixTextModified && !entry.StatusTextModified)
+    {
+      continue;
+    }
+
+    std::string transformName = transformIt->first.GetTransformName();
+    if (!IsTransform(transformName))
+    {
+      transformName.append(TransformPostfix);
+    }
+
+    if (entry.MatrixTextModified)
+    {
+      std::ostringstream strTransform;
+      for (int i = 0; i < 16; ++i)
+      {
+        strTransform << std::setprecision(FLOATING_POINT_PRECISION) << entry.Matrix[ i ] << " ";
+      }
+      this->CustomFrameFields[transformName] = strTransform.str();
+      entry.MatrixTextModified = false;
+    }
+
+    if (entry.StatusTextModified)
+    {
+      this->CustomFrameFields[transformName + "Status"] = PlusTrackedFrame::ConvertFieldStatusToString(entry.Status);
+      entry.StatusTextModified = false;
+    }
+  }
+}
+
+//----------------------------------------------------------------------------
+void PlusTrackedFrame::InvalidateFrameTransform(const std::string& fieldName)
+{
+  if (this->FrameTransforms.empty())
+  {
+    return;
+  }
+
+  bool isStatus = IsTransformStatus(fieldName);
+  if (!isStatus && !IsTransform(fieldName))
+  {
+    return;
+  }
+
+  for (FrameTransformMapType::iterator transformIt = this->FrameTransforms.begin(); transformIt != this->FrameTransforms.end(); ++transformIt)
+  {
+    std::string transformName = transformIt->first.GetTransformName();
+    if (!IsTransform(transformName))
+    {
+      transformName.append(TransformPostfix);
+    }
+    if (isStatus)
+    {
+      transformName.append("Status");
+    }
+    if (!PlusCommon::IsEqualInsensitive(transformName, fieldName))
+    {
+      continue;
+    }
+
+    if (isStatus)
+    {
+      transformIt->second.StatusDefined = false;
+      transformIt->second.StatusTextModified = false;
+    }
+    else
+    {
+      transformIt->second.MatrixDefined = false;
+      transformIt->second.MatrixTextModified = false;
+    }
+    if (!transformIt->second.MatrixDefined && !transformIt->second.StatusDefined)
+    {
+      this->FrameTransforms.erase(transformIt);
+    }
+    return;
+  }
+}
+
 //----------------------------------------------------------------------------
 TrackedFrameFieldStatus PlusTrackedFrame::ConvertFieldStatusFromString(const char* statusStr)
 {
@@ -657,9 +834,18 @@ PlusStatus PlusTrackedFrame::WriteToFile(const std::string& filename, vtkMatrix4
   return PLUS_SUCCESS;
 }
 
+//----------------------------------------------------------------------------
+const PlusTrackedFrame::FieldMapType& PlusTrackedFrame::GetCustomFields()
+{
+  this->UpdateTransformFields();
+  return this->CustomFrameFields;
+}
+
 //----------------------------------------------------------------------------
 void PlusTrackedFrame::GetCustomFrameFieldNameList(std::vector<std::string>& fieldNames)
 {
+  PlusLockGuard<vtkPlusSimpleRecursiveCriticalSection> transformFieldsGuard(&this->TransformFieldsMutex);
+  this->UpdateTransformFields();
   fieldNames.clear();
   for (FieldMapType::const_iterator it = this->CustomFrameFields.begin(); it != this->CustomFrameFields.end(); it++)
   {
@@ -670,13 +856,27 @@ void PlusTrackedFrame::GetCustomFrameFieldNameList(std::vector<std::string>& fie
 //----------------------------------------------------------------------------
 void PlusTrackedFrame::GetCustomFrameTransformNameList(std::vector<PlusTransformName>& transformNames)
 {
+  PlusLockGuard<vtkPlusSimpleRecursiveCriticalSection> transformFieldsGuard(&this->TransformFieldsMutex);
   transformNames.clear();
+  for (FrameTransformMapType::const_iterator it = this->FrameTransforms.begin(); it != this->FrameTransforms.end(); ++it)
+  {
+    if (it->second.MatrixDefined)
+    {
+      transformNames.push_back(it->first);
+    }
+  }
   for (FieldMapType::const_iterator it = this->CustomFrameFields.begin(); it != this->CustomFrameFields.end(); it++)
   {
     if (IsTransform(it->first))
     {
       PlusTransformName trName;
       trName.SetTransformName(it->first.substr(0, it->first.length() - TransformPostfix.length()).c_str());
+      FrameTransformMapType::const_iterator transformIt = this->FrameTransforms.find(trName);
+      if (transformIt != this->FrameTransforms.end() && transformIt->second.MatrixDefined)
+      {
+        // already listed from the binary transforms
+        continue;
+      }
       transformNames.push_back(trName);
     }
   }
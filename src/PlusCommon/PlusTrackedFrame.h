@@ -42,16 +42,47 @@ public:
   static const std::string TransformStatusPostfix;
   typedef std::map<std::string, std::string> FieldMapType;
 
+  /*!
+    Binary representation of a frame transform and its status.
+    Transforms set through SetCustomFrameTransform are kept in this form and only converted
+    to text (CustomFrameFields) when the text representation is actually requested.
+    Transforms that only exist as text (e.g., read from a sequence file) are parsed on the first
+    GetCustomFrameTransform/GetCustomFrameTransformStatus call and the parsed value is stored here.
+    The conversions are protected by TransformFieldsMutex, so the same frame can be read from multiple threads.
+  */
+  struct FrameTransformEntry
+  {
+    FrameTransformEntry();
+    double Matrix[16];
+    TrackedFrameFieldStatus Status;
+    bool MatrixDefined;
+    bool StatusDefined;
+    /*! Matrix has been changed since the last time the text field was generated */
+    bool MatrixTextModified;
+    /*! Status has been changed since the last time the text field was generated */
+    bool StatusTextModified;
+  };
+  typedef std::map<PlusTransformName, FrameTransformEntry> FrameTransformMapType;
+
 public:
   PlusTrackedFrame();
   ~PlusTrackedFrame();
   PlusTrackedFrame(const PlusTrackedFrame& frame);
   PlusTrackedFrame& operator=(PlusTrackedFrame const& trackedFrame);
 
+  /*!
+    Copy all data from another tracked frame, but share the image pixels with it instead of copying them.
+    See PlusVideoFrame::ShallowCopy for the rules of accessing shared pixel data.
+  */
+  void ShallowCopy(const PlusTrackedFrame& trackedFrame);
+
 public:
   /*! Set image data */
   void SetImageData(const PlusVideoFrame& value);
 
+  /*! Set image data as a read-only view of the pixels of the specified frame, without copying them (see PlusVideoFrame::ShallowCopy) */
+  void ShareImageData(const PlusVideoFrame& value);
+
   /*! Get image data */
   PlusVideoFrame* GetImageData() { return &(this->ImageData); };
 
@@ -148,8 +179,14 @@ public:
   /*! Convert from field status enum to field status string */
   static std::string ConvertFieldStatusToString(TrackedFrameFieldStatus status);
 
-  /*! Return all custom fields in a map */
-  const FieldMapType& GetCustomFields() { return this->CustomFrameFields; }
+  /*!
+    Return all custom fields in a map (transforms stored in binary form are converted to text fields first).
+    The returned map is not modified by other getters, only by setting or deleting fields.
+  */
+  const FieldMapType& GetCustomFields();
+
+  /*! Return all transforms that are stored in binary form */
+  const FrameTransformMapType& GetCustomFrameTransforms() { return this->FrameTransforms; }
 
   /*! Returns true if the input string ends with "Transform", else false */
   static bool IsTransform(std::string str);
@@ -164,12 +201,33 @@ public:
     return (Timestamp == data.Timestamp);
   }
 
+protected:
+  /*! Write the text representation of all modified binary transforms into CustomFrameFields */
+  void UpdateTransformFields();
+
+  /*!
+    Remove the binary representation of a transform (or transform status) field,
+    used when the field is set or deleted through the text interface
+  */
+  void InvalidateFrameTransform(const std::string& fieldName);
+
 protected:
   PlusVideoFrame ImageData;
   double Timestamp;
 
   FieldMapType CustomFrameFields;
 
+  /*! Binary transform storage, avoids string formatting and parsing on the acquisition and processing paths */
+  FrameTransformMapType FrameTransforms;
+
+  /*!
+    Guards the text fields that are generated from the binary transforms and the binary transforms that are parsed
+    from the text fields when a getter is called. Getters (and copying from this frame) lock it while they access
+    CustomFrameFields or FrameTransforms, so that concurrent readers of the same frame do not see a partially generated
+    field or entry. Writers are not synchronized (same as other members).
+  */
+  mutable vtkPlusSimpleRecursiveCriticalSection TransformFieldsMutex;
+
   unsigned int FrameSize[3];
 
   /*! Stores segmented fiducial point pixel coordinates */
@@ -8,11 +8,13 @@ See License.txt for details.
 #include "PlusVideoFrame.h"
 #include "itkImageBase.h"
 #include "vtkBMPReader.h"
+#include "vtkDataArray.h"
 #include "vtkExtractVOI.h"
 #include "vtkImageData.h"
 #include "vtkImageImport.h"
 #include "vtkImageReader.h"
 #include "vtkObjectFactory.h"
+#include "vtkPointData.h"
 #include "vtkPNMReader.h"
 #include "vtkTIFFReader.h"
 #include "vtkTrivialProducer.h"
@@ -414,6 +416,8 @@ PlusStatus PlusVideoFrame::FillBlank()
     return PLUS_FAIL;
   }
 
+  this->DetachSharedImage();
+
   memset(this->GetScalarPointer(), 0, this->GetFrameSizeInBytes());
 
   return PLUS_SUCCESS;
@@ -486,6 +490,8 @@ PlusStatus PlusVideoFrame::AllocateFrame(const int imageSize[3], PlusCommon::VTK
     this->SetImageData(vtkImageData::New());
   }
   PlusStatus allocStatus = PlusVideoFrame::AllocateFrame(this->GetImage(), imageSize, pixType, numberOfScalarComponents);
+  // Callers write the pixels after allocation, which must not modify pixels that are shared with other frames
+  this->DetachSharedImage();
   return allocStatus;
 }
 
@@ -497,6 +503,8 @@ PlusStatus PlusVideoFrame::AllocateFrame(const unsigned int imageSize[3], PlusCo
     this->SetImageData(vtkImageData::New());
   }
   PlusStatus allocStatus = PlusVideoFrame::AllocateFrame(this->GetImage(), imageSize, pixType, numberOfScalarComponents);
+  // Callers write the pixels after allocation, which must not modify pixels that are shared with other frames
+  this->DetachSharedImage();
   return allocStatus;
 }
 
@@ -554,6 +562,67 @@ PlusStatus PlusVideoFrame::ShallowCopyFrom(vtkImageData* frame)
   return PLUS_SUCCESS;
 }
 
+//----------------------------------------------------------------------------
+PlusStatus PlusVideoFrame::ShallowCopy(const PlusVideoFrame& videoItem)
+{
+  if (this == &videoItem)
+  {
+    return PLUS_SUCCESS;
+  }
+
+  this->ImageType = videoItem.ImageType;
+  this->ImageOrientation = videoItem.ImageOrientation;
+
+  if (videoItem.Image == NULL)
+  {
+    DELETE_IF_NOT_NULL(this->Image);
+    return PLUS_SUCCESS;
+  }
+
+  if (this->Image == NULL)
+  {
+    this->SetImageData(vtkImageData::New());
+  }
+  // Copies the image geometry and increments the reference count of the pixel array
+  this->Image->ShallowCopy(videoItem.Image);
+
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+bool PlusVideoFrame::IsImageShared() const
+{
+  if (this->Image == NULL)
+  {
+    return false;
+  }
+  vtkDataArray* scalars = this->Image->GetPointData()->GetScalars();
+  return scalars != NULL && scalars->GetReferenceCount() > 1;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus PlusVideoFrame::DetachSharedImage()
+{
+  if (!this->IsImageShared())
+  {
+    return PLUS_SUCCESS;
+  }
+
+  vtkDataArray* sharedScalars = this->Image->GetPointData()->GetScalars();
+  vtkSmartPointer<vtkDataArray> scalars = vtkSmartPointer<vtkDataArray>::Take(vtkDataArray::CreateDataArray(sharedScalars->GetDataType()));
+  if (scalars.GetPointer() == NULL)
+  {
+    LOG_ERROR("Failed to allocate pixel array for detaching shared video frame");
+    return PLUS_FAIL;
+  }
+  scalars->SetName(sharedScalars->GetName());
+  scalars->SetNumberOfComponents(sharedScalars->GetNumberOfComponents());
+  scalars->SetNumberOfTuples(sharedScalars->GetNumberOfTuples());
+  this->Image->GetPointData()->SetScalars(scalars);
+
+  return PLUS_SUCCESS;
+}
+
 //----------------------------------------------------------------------------
 int PlusVideoFrame::GetNumberOfBytesPerScalar() const
 {
@@ -1044,6 +1113,8 @@ PlusStatus PlusVideoFrame::GetOrientedClippedImage(unsigned char* imageDataPtr,
     const int clipRectangleOrigin[3],
     const int clipRectangleSize[3])
 {
+  // Don't overwrite pixels that are shared with other frames
+  outBufferItem.DetachSharedImage();
   return PlusVideoFrame::GetOrientedClippedImage(imageDataPtr, flipInfo, inUsImageType, pixType,
          numberOfScalarComponents, inputFrameSizeInPx, outBufferItem.GetImage(), clipRectangleOrigin, clipRectangleSize);
 }
@@ -1058,6 +1129,8 @@ PlusStatus PlusVideoFrame::GetOrientedClippedImage(unsigned char* imageDataPtr,
     const int clipRectangleOrigin[3],
     const int clipRectangleSize[3])
 {
+  // Don't overwrite pixels that are shared with other frames
+  outBufferItem.DetachSharedImage();
   return PlusVideoFrame::GetOrientedClippedImage(imageDataPtr, flipInfo, inUsImageType, inUsImagePixelType,
          numberOfScalarComponents, inputFrameSizeInPx, outBufferItem.GetImage(), clipRectangleOrigin, clipRectangleSize);
 }
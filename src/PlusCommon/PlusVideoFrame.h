@@ -182,6 +182,24 @@ public:
   /*! Sets the pixel buffer content by copying pixel data from a vtkImageData object.*/
   PlusStatus ShallowCopyFrom(vtkImageData* frame);
 
+  /*!
+    Make this frame a read-only view of the pixel data of another frame, without copying the pixels.
+    The shared pixel array is reference counted and stays unchanged as long as any frame refers to it:
+    methods of this class that write pixels (AllocateFrame, DeepCopy, FillBlank, GetOrientedClippedImage, ...)
+    detach the frame first and write into a newly allocated pixel array instead.
+    Pixels must not be modified directly through GetImage() or GetScalarPointer() while they are shared.
+  */
+  PlusStatus ShallowCopy(const PlusVideoFrame& videoItem);
+
+  /*! Return true if the pixel array is referenced by other frames or images as well (see ShallowCopy) */
+  bool IsImageShared() const;
+
+  /*!
+    If the pixel array is shared then replace it with a newly allocated array of the same size and type,
+    so that pixels can be written without modifying the shared data. Pixel values are not copied.
+  */
+  PlusStatus DetachSharedImage();
+
   /*! Get US_IMAGE_ORIENTATION enum value from string */
   static US_IMAGE_ORIENTATION GetUsImageOrientationFromString(const char* imgOrientationStr);
   static US_IMAGE_ORIENTATION GetUsImageOrientationFromString(const std::string& imgOrientationStr);
@@ -0,0 +1,184 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+/*!
+  \file PlusIncrementalLeastSquaresTest.cxx
+  \brief This test solves a simulated pivot calibration problem with PlusIncrementalLeastSquares
+  and compares the result to the ground truth. Some of the samples are gross outliers, including
+  the first ones, which must not bias the result. The test is repeated with a high ratio of outliers,
+  which must not increase the RMS error and therefore the outlier threshold.
+*/
+
+#include "PlusConfigure.h"
+#include "PlusIncrementalLeastSquares.h"
+
+#include "vtkMath.h"
+#include "vtksys/CommandLineArguments.hxx"
+
+namespace
+{
+  const double PIVOT_POINT_MARKER[3] = {12.3, -45.6, 150.2};
+  const double PIVOT_POINT_REFERENCE[3] = {-200.5, 310.0, -80.7};
+  const double NOISE_STDEV_MM = 0.1;
+  const double POSITION_ERROR_THRESHOLD_MM = 0.1;
+  // The RMS error of the inliers is sqrt(3)*NOISE_STDEV_MM, as the residual of a sample is a 3D vector
+  const double RMS_ERROR_THRESHOLD_MM = 2 * sqrt(3.0) * NOISE_STDEV_MM;
+
+  //----------------------------------------------------------------------------
+  // Generate the equations of a pivot calibration sample (see vtkPlusPivotCalibrationAlgo) with random marker orientation
+  void GenerateSample(bool outlier, double aMatrix[18], double bVector[3])
+  {
+    double quaternion[4] = {vtkMath::Gaussian(), vtkMath::Gaussian(), vtkMath::Gaussian(), vtkMath::Gaussian()};
+    double norm = sqrt(quaternion[0] * quaternion[0] + quaternion[1] * quaternion[1] + quaternion[2] * quaternion[2] + quaternion[3] * quaternion[3]);
+    for (int i = 0; i < 4; i++)
+    {
+      quaternion[i] /= norm;
+    }
+    double rotation[3][3];
+    vtkMath::QuaternionToMatrix3x3(quaternion, rotation);
+
+    for (int i = 0; i < 3; i++)
+    {
+      // MarkerToReference translation that maps the pivot point to its reference position
+      double translation = PIVOT_POINT_REFERENCE[i] + vtkMath::Gaussian(0, NOISE_STDEV_MM);
+      for (int j = 0; j < 3; j++)
+      {
+        translation -= rotation[i][j] * PIVOT_POINT_MARKER[j];
+      }
+      if (outlier)
+      {
+        translation += vtkMath::Random(-1000, 1000);
+      }
+      for (int j = 0; j < 3; j++)
+      {
+        aMatrix[i * 6 + j] = rotation[i][j];
+        aMatrix[i * 6 + 3 + j] = (i == j ? -1 : 0);
+      }
+      bVector[i] = -translation;
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  // Add samples to the solver (the first samples and the specified ratio of the other samples are outliers) and compare the result to the ground truth
+  int RunCalibration(int numberOfSamples, double outlierRatio)
+  {
+    LOG_INFO("Pivot calibration with " << numberOfSamples << " samples, outlier ratio: " << outlierRatio);
+    int numberOfErrors = 0;
+
+    PlusIncrementalLeastSquares solver;
+    solver.Initialize(6, 1);
+    double aMatrix[18] = {0};
+    double bVector[3] = {0};
+    int numberOfOutliers = 0;
+    for (int sampleIndex = 0; sampleIndex < numberOfSamples; sampleIndex++)
+    {
+      bool outlier = (sampleIndex < 3 || vtkMath::Random() < outlierRatio);
+      if (outlier)
+      {
+        numberOfOutliers++;
+      }
+      GenerateSample(outlier, aMatrix, bVector);
+      if (solver.AddObservation(aMatrix, bVector, 3) != PLUS_SUCCESS)
+      {
+        LOG_ERROR("Failed to add sample " << sampleIndex);
+        return numberOfErrors + 1;
+      }
+    }
+
+    std::vector<double> xVector;
+    if (solver.GetSolution(xVector) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to get the solution");
+      return numberOfErrors + 1;
+    }
+    LOG_INFO("Pivot point in marker coordinate system: " << xVector[0] << " " << xVector[1] << " " << xVector[2]);
+    LOG_INFO("Pivot point in reference coordinate system: " << xVector[3] << " " << xVector[4] << " " << xVector[5]);
+    LOG_INFO("RMS error: " << solver.GetRmsError() << " mm, converged: " << (solver.GetConverged() ? "yes" : "no"));
+    LOG_INFO("Number of generated outliers: " << numberOfOutliers << ", detected outliers: " << solver.GetNumberOfOutlierObservations());
+
+    double markerError = sqrt(vtkMath::Distance2BetweenPoints(&xVector[0], PIVOT_POINT_MARKER));
+    double referenceError = sqrt(vtkMath::Distance2BetweenPoints(&xVector[3], PIVOT_POINT_REFERENCE));
+    if (markerError > POSITION_ERROR_THRESHOLD_MM || referenceError > POSITION_ERROR_THRESHOLD_MM)
+    {
+      LOG_ERROR("Pivot point position mismatch: error is " << markerError << " mm in marker and " << referenceError << " mm in reference coordinate system, maximum allowed is " << POSITION_ERROR_THRESHOLD_MM);
+      numberOfErrors++;
+    }
+    if (solver.GetRmsError() < 0 || solver.GetRmsError() > RMS_ERROR_THRESHOLD_MM)
+    {
+      LOG_ERROR("RMS error is " << solver.GetRmsError() << " mm, maximum allowed is " << RMS_ERROR_THRESHOLD_MM);
+      numberOfErrors++;
+    }
+    if (solver.GetNumberOfOutlierObservations() < static_cast<unsigned int>(numberOfOutliers))
+    {
+      LOG_ERROR("Not all the outliers were detected: " << solver.GetNumberOfOutlierObservations() << " of " << numberOfOutliers);
+      numberOfErrors++;
+    }
+    if (!solver.GetConverged())
+    {
+      LOG_ERROR("Solution is not converged after " << numberOfSamples << " samples");
+      numberOfErrors++;
+    }
+    return numberOfErrors;
+  }
+}
+
+//----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  bool printHelp(false);
+  int verboseLevel = vtkPlusLogger::LOG_LEVEL_UNDEFINED;
+  int numberOfSamples = 500;
+
+  vtksys::CommandLineArguments args;
+  args.Initialize(argc, argv);
+  args.AddArgument("--help", vtksys::CommandLineArguments::NO_ARGUMENT, &printHelp, "Print this help.");
+  args.AddArgument("--number-of-samples", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &numberOfSamples, "Number of simulated pivot calibration samples");
+  args.AddArgument("--verbose", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &verboseLevel, "Verbose level (1=error only, 2=warning, 3=info, 4=debug, 5=trace)");
+
+  if (!args.Parse())
+  {
+    std::cerr << "Problem parsing arguments" << std::endl;
+    std::cout << "Help: " << args.GetHelp() << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  if (printHelp)
+  {
+    std::cout << args.GetHelp() << std::endl;
+    exit(EXIT_SUCCESS);
+  }
+  vtkPlusLogger::Instance()->SetLogLevel(verboseLevel);
+
+  int numberOfErrors = 0;
+  vtkMath::RandomSeed(1234);
+
+  PlusIncrementalLeastSquares solver;
+  solver.Initialize(6, 1);
+
+  double aMatrix[18] = {0};
+  double bVector[3] = {0};
+  std::vector<double> xVector;
+
+  // A single sample does not determine the unknowns
+  GenerateSample(false, aMatrix, bVector);
+  solver.AddObservation(aMatrix, bVector, 3);
+  if (solver.GetSolution(xVector) == PLUS_SUCCESS || solver.GetRmsError() >= 0)
+  {
+    LOG_ERROR("Solution is available from a single pivot calibration sample");
+    numberOfErrors++;
+  }
+
+  // 5% of the samples are outliers, then a ratio that the outliers would make the error scale run away if they were included in it
+  numberOfErrors += RunCalibration(numberOfSamples, 0.05);
+  numberOfErrors += RunCalibration(numberOfSamples, 0.3);
+
+  if (numberOfErrors > 0)
+  {
+    LOG_ERROR("Test failed with " << numberOfErrors << " errors");
+    return EXIT_FAILURE;
+  }
+  LOG_INFO("Test completed successfully");
+  return EXIT_SUCCESS;
+}
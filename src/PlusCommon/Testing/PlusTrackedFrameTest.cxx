@@ -0,0 +1,407 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+See License.txt for details.
+=========================================================Plus=header=end*/
+
+/*!
+  \file PlusTrackedFrameTest.cxx
+  \brief Test storing transforms in tracked frames: consistency of the binary and text representations
+  of transforms and transform statuses, XML round-trip, and reading the same frame from multiple threads.
+*/
+
+// Local includes
+#include "PlusConfigure.h"
+#include "PlusTrackedFrame.h"
+
+// VTK includes
+#include <vtkMatrix4x4.h>
+#include <vtkMultiThreader.h>
+#include <vtkSmartPointer.h>
+#include <vtksys/CommandLineArguments.hxx>
+
+#include <iomanip>
+#include <sstream>
+
+namespace
+{
+  const double MATRIX_COMPARISON_TOLERANCE = 1e-10;
+  const int NUMBER_OF_READER_THREADS = 4;
+  const int NUMBER_OF_READS_PER_THREAD = 2000;
+
+  //----------------------------------------------------------------------------
+  void GetTestMatrix(double offset, double matrix[16])
+  {
+    for (int i = 0; i < 16; i++)
+    {
+      matrix[i] = (i % 5 == 0 ? 1.0 : 0.0);
+    }
+    matrix[3] = offset + 1.0 / 3.0;
+    matrix[7] = -offset * 2.5;
+    matrix[11] = 123.456789012345;
+  }
+
+  //----------------------------------------------------------------------------
+  bool IsMatrixEqual(const double a[16], const double b[16])
+  {
+    for (int i = 0; i < 16; i++)
+    {
+      if (fabs(a[i] - b[i]) > MATRIX_COMPARISON_TOLERANCE)
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+  PlusStatus CheckTransform(PlusTrackedFrame& frame, const PlusTransformName& transformName, const double expectedMatrix[16], TrackedFrameFieldStatus expectedStatus)
+  {
+    std::string transformNameStr;
+    transformName.GetTransformName(transformNameStr);
+
+    if (!frame.IsCustomFrameTransformNameDefined(transformName))
+    {
+      LOG_ERROR("Transform " << transformNameStr << " is not defined");
+      return PLUS_FAIL;
+    }
+
+    double matrix[16] = {0};
+    if (frame.GetCustomFrameTransform(transformName, matrix) != PLUS_SUCCESS || !IsMatrixEqual(matrix, expectedMatrix))
+    {
+      LOG_ERROR("Transform " << transformNameStr << " mismatch");
+      return PLUS_FAIL;
+    }
+
+    TrackedFrameFieldStatus status = FIELD_INVALID;
+    if (frame.GetCustomFrameTransformStatus(transformName, status) != PLUS_SUCCESS || status != expectedStatus)
+    {
+      LOG_ERROR("Transform status " << transformNameStr << " mismatch");
+      return PLUS_FAIL;
+    }
+
+    // Text representation
+    const char* matrixStr = frame.GetCustomFrameField(transformNameStr + PlusTrackedFrame::TransformPostfix);
+    if (matrixStr == NULL)
+    {
+      LOG_ERROR("Transform field " << transformNameStr << PlusTrackedFrame::TransformPostfix << " is not defined");
+      return PLUS_FAIL;
+    }
+    std::istringstream matrixStream(matrixStr);
+    for (int i = 0; i < 16; i++)
+    {
+      if (!(matrixStream >> matrix[i]))
+      {
+        LOG_ERROR("Transform field " << transformNameStr << " is invalid: " << matrixStr);
+        return PLUS_FAIL;
+      }
+    }
+    if (!IsMatrixEqual(matrix, expectedMatrix))
+    {
+      LOG_ERROR("Transform field " << transformNameStr << " mismatch: " << matrixStr);
+      return PLUS_FAIL;
+    }
+
+    const char* statusStr = frame.GetCustomFrameField(transformNameStr + PlusTrackedFrame::TransformStatusPostfix);
+    if (statusStr == NULL || PlusTrackedFrame::ConvertFieldStatusFromString(statusStr) != expectedStatus)
+    {
+      LOG_ERROR("Transform status field " << transformNameStr << " mismatch: " << (statusStr ? statusStr : "NULL"));
+      return PLUS_FAIL;
+    }
+
+    return PLUS_SUCCESS;
+  }
+
+  //----------------------------------------------------------------------------
+  PlusStatus TestBinaryAndTextFields()
+  {
+    double probeMatrix[16] = {0};
+    GetTestMatrix(10, probeMatrix);
+    double stylusMatrix[16] = {0};
+    GetTestMatrix(-20, stylusMatrix);
+
+    PlusTransformName probeToTracker("Probe", "Tracker");
+    PlusTransformName stylusToTracker("Stylus", "Tracker");
+
+    PlusTrackedFrame frame;
+    frame.SetTimestamp(12.5);
+
+    // Binary setters
+    frame.SetCustomFrameTransform(probeToTracker, probeMatrix);
+    frame.SetCustomFrameTransformStatus(probeToTracker, FIELD_OK);
+    if (CheckTransform(frame, probeToTracker, probeMatrix, FIELD_OK) != PLUS_SUCCESS)
+    {
+      return PLUS_FAIL;
+    }
+
+    // Text setters
+    std::ostringstream stylusMatrixStr;
+    stylusMatrixStr << std::setprecision(16);
+    for (int i = 0; i < 16; i++)
+    {
+      stylusMatrixStr << stylusMatrix[i] << " ";
+    }
+    frame.SetCustomFrameField("StylusToTrackerTransform", stylusMatrixStr.str());
+    frame.SetCustomFrameField("StylusToTrackerTransformStatus", "INVALID");
+    if (CheckTransform(frame, stylusToTracker, stylusMatrix, FIELD_INVALID) != PLUS_SUCCESS)
+    {
+      return PLUS_FAIL;
+    }
+
+    // Transforms that only exist as text are parsed once
+    PlusTrackedFrame::FrameTransformMapType::const_iterator stylusIt = frame.GetCustomFrameTransforms().find(stylusToTracker);
+    if (stylusIt == frame.GetCustomFrameTransforms().end() || !stylusIt->second.MatrixDefined || !stylusIt->second.StatusDefined
+        || !IsMatrixEqual(stylusIt->second.Matrix, stylusMatrix) || stylusIt->second.Status != FIELD_INVALID)
+    {
+      LOG_ERROR("Parsed text transform " << stylusToTracker << " is not cached");
+      return PLUS_FAIL;
+    }
+
+    // Binary value overwritten by text value and then by binary value again
+    frame.SetCustomFrameField("ProbeToTrackerTransform", stylusMatrixStr.str());
+    frame.SetCustomFrameField("ProbeToTrackerTransformStatus", "INVALID");
+    if (CheckTransform(frame, probeToTracker, stylusMatrix, FIELD_INVALID) != PLUS_SUCCESS)
+    {
+      return PLUS_FAIL;
+    }
+    frame.SetCustomFrameTransform(probeToTracker, probeMatrix);
+    frame.SetCustomFrameTransformStatus(probeToTracker, FIELD_OK);
+    if (CheckTransform(frame, probeToTracker, probeMatrix, FIELD_OK) != PLUS_SUCCESS)
+    {
+      return PLUS_FAIL;
+    }
+
+    // Each transform is listed once
+    std::vector<PlusTransformName> transformNames;
+    frame.GetCustomFrameTransformNameList(transformNames);
+    if (transformNames.size() != 2)
+    {
+      LOG_ERROR("Unexpected number of transforms: " << transformNames.size() << " (expected 2)");
+      return PLUS_FAIL;
+    }
+    std::vector<std::string> fieldNames;
+    frame.GetCustomFrameFieldNameList(fieldNames);
+    if (fieldNames.size() != 5 || frame.GetCustomFields().size() != 5)
+    {
+      LOG_ERROR("Unexpected number of fields: " << fieldNames.size() << " (expected 5: timestamp, 2 transforms and 2 statuses)");
+      return PLUS_FAIL;
+    }
+
+    // Copies are independent
+    PlusTrackedFrame frameCopy(frame);
+    frame.SetCustomFrameTransform(probeToTracker, stylusMatrix);
+    if (CheckTransform(frameCopy, probeToTracker, probeMatrix, FIELD_OK) != PLUS_SUCCESS
+        || CheckTransform(frame, probeToTracker, stylusMatrix, FIELD_OK) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Tracked frame copy test failed");
+      return PLUS_FAIL;
+    }
+
+    // Delete through the text interface
+    frame.DeleteCustomFrameField("ProbeToTrackerTransform");
+    double matrix[16] = {0};
+    if (frame.IsCustomFrameTransformNameDefined(probeToTracker) || frame.IsCustomFrameFieldDefined("ProbeToTrackerTransform"))
+    {
+      LOG_ERROR("Deleted transform is still defined");
+      return PLUS_FAIL;
+    }
+    TrackedFrameFieldStatus status = FIELD_INVALID;
+    if (frame.GetCustomFrameTransformStatus(probeToTracker, status) != PLUS_SUCCESS || status != FIELD_OK)
+    {
+      LOG_ERROR("Transform status is expected to be kept after deleting the transform");
+      return PLUS_FAIL;
+    }
+    LOG_INFO("Binary and text transform fields test completed successfully");
+    return PLUS_SUCCESS;
+  }
+
+  //----------------------------------------------------------------------------
+  PlusStatus TestXmlRoundTrip()
+  {
+    double probeMatrix[16] = {0};
+    GetTestMatrix(3, probeMatrix);
+    double stylusMatrix[16] = {0};
+    GetTestMatrix(4, stylusMatrix);
+    PlusTransformName probeToTracker("Probe", "Tracker");
+    PlusTransformName stylusToTracker("Stylus", "Tracker");
+
+    PlusTrackedFrame frame;
+    frame.SetTimestamp(1.25);
+    frame.SetCustomFrameTransform(probeToTracker, probeMatrix);
+    frame.SetCustomFrameTransformStatus(probeToTracker, FIELD_OK);
+    frame.SetCustomFrameTransform(stylusToTracker, stylusMatrix);
+    frame.SetCustomFrameTransformStatus(stylusToTracker, FIELD_INVALID);
+    frame.SetCustomFrameField("FrameNumber", "7");
+
+    // All fields
+    std::string xmlData;
+    std::vector<PlusTransformName> allTransforms;
+    if (frame.GetTrackedFrameInXmlData(xmlData, allTransforms) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to serialize tracked frame");
+      return PLUS_FAIL;
+    }
+    PlusTrackedFrame restoredFrame;
+    if (restoredFrame.SetTrackedFrameFromXmlData(xmlData) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to deserialize tracked frame");
+      return PLUS_FAIL;
+    }
+    if (CheckTransform(restoredFrame, probeToTracker, probeMatrix, FIELD_OK) != PLUS_SUCCESS
+        || CheckTransform(restoredFrame, stylusToTracker, stylusMatrix, FIELD_INVALID) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("XML round-trip failed: " << xmlData);
+      return PLUS_FAIL;
+    }
+    const char* frameNumber = restoredFrame.GetCustomFrameField("FrameNumber");
+    if (frameNumber == NULL || std::string(frameNumber) != "7" || restoredFrame.GetTimestamp() != 1.25)
+    {
+      LOG_ERROR("XML round-trip failed for non-transform fields: " << xmlData);
+      return PLUS_FAIL;
+    }
+
+    // Requested transforms only
+    std::vector<PlusTransformName> requestedTransforms;
+    requestedTransforms.push_back(stylusToTracker);
+    if (frame.GetTrackedFrameInXmlData(xmlData, requestedTransforms) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to serialize tracked frame with requested transforms");
+      return PLUS_FAIL;
+    }
+    PlusTrackedFrame restoredRequestedFrame;
+    restoredRequestedFrame.SetTrackedFrameFromXmlData(xmlData);
+    if (restoredRequestedFrame.IsCustomFrameTransformNameDefined(probeToTracker)
+        || CheckTransform(restoredRequestedFrame, stylusToTracker, stylusMatrix, FIELD_INVALID) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("XML round-trip with requested transforms failed: " << xmlData);
+      return PLUS_FAIL;
+    }
+
+    LOG_INFO("XML round-trip test completed successfully");
+    return PLUS_SUCCESS;
+  }
+
+  //----------------------------------------------------------------------------
+  struct ReaderThreadData
+  {
+    PlusTrackedFrame* Frame;
+    double ExpectedMatrix[NUMBER_OF_READER_THREADS][16];
+    int NumberOfErrors[NUMBER_OF_READER_THREADS];
+  };
+
+  //----------------------------------------------------------------------------
+  void* ReaderThread(vtkMultiThreader::ThreadInfo* data)
+  {
+    ReaderThreadData* threadData = static_cast<ReaderThreadData*>(data->UserData);
+    const int threadId = data->ThreadID;
+    for (int i = 0; i < NUMBER_OF_READS_PER_THREAD; i++)
+    {
+      int toolIndex = (threadId + i) % NUMBER_OF_READER_THREADS;
+      std::ostringstream toolName;
+      toolName << "Tool" << toolIndex;
+      PlusTransformName transformName(toolName.str(), "Tracker");
+
+      // Mix binary and text reads, text reads generate the text fields on first access
+      double matrix[16] = {0};
+      if (threadData->Frame->GetCustomFrameTransform(transformName, matrix) != PLUS_SUCCESS
+          || !IsMatrixEqual(matrix, threadData->ExpectedMatrix[toolIndex]))
+      {
+        threadData->NumberOfErrors[threadId]++;
+      }
+      if (threadData->Frame->GetCustomFrameField(toolName.str() + "ToTrackerTransformStatus") == NULL)
+      {
+        threadData->NumberOfErrors[threadId]++;
+      }
+      if (threadData->Frame->GetCustomFields().size() != 2 * NUMBER_OF_READER_THREADS)
+      {
+        threadData->NumberOfErrors[threadId]++;
+      }
+    }
+    return NULL;
+  }
+
+  //----------------------------------------------------------------------------
+  PlusStatus TestConcurrentReads()
+  {
+    PlusTrackedFrame frame;
+    ReaderThreadData threadData;
+    threadData.Frame = &frame;
+    for (int toolIndex = 0; toolIndex < NUMBER_OF_READER_THREADS; toolIndex++)
+    {
+      std::ostringstream toolName;
+      toolName << "Tool" << toolIndex;
+      GetTestMatrix(toolIndex, threadData.ExpectedMatrix[toolIndex]);
+      if (toolIndex % 2 == 0)
+      {
+        frame.SetCustomFrameTransform(PlusTransformName(toolName.str(), "Tracker"), threadData.ExpectedMatrix[toolIndex]);
+        frame.SetCustomFrameTransformStatus(PlusTransformName(toolName.str(), "Tracker"), FIELD_OK);
+      }
+      else
+      {
+        // Text only, as read from a sequence file, the parsed matrix is cached by the first reader
+        std::ostringstream matrixStr;
+        matrixStr << std::setprecision(16);
+        for (int i = 0; i < 16; i++)
+        {
+          matrixStr << threadData.ExpectedMatrix[toolIndex][i] << " ";
+        }
+        frame.SetCustomFrameField(toolName.str() + "ToTrackerTransform", matrixStr.str());
+        frame.SetCustomFrameField(toolName.str() + "ToTrackerTransformStatus", "OK");
+      }
+      threadData.NumberOfErrors[toolIndex] = 0;
+    }
+
+    vtkSmartPointer<vtkMultiThreader> multiThreader = vtkSmartPointer<vtkMultiThreader>::New();
+    multiThreader->SetNumberOfThreads(NUMBER_OF_READER_THREADS);
+    multiThreader->SetSingleMethod((vtkThreadFunctionType)&ReaderThread, &threadData);
+    multiThreader->SingleMethodExecute();
+
+    int numberOfErrors = 0;
+    for (int threadId = 0; threadId < NUMBER_OF_READER_THREADS; threadId++)
+    {
+      numberOfErrors += threadData.NumberOfErrors[threadId];
+    }
+    if (numberOfErrors > 0)
+    {
+      LOG_ERROR("Concurrent read test failed: " << numberOfErrors << " inconsistent reads");
+      return PLUS_FAIL;
+    }
+    LOG_INFO("Concurrent read test completed successfully");
+    return PLUS_SUCCESS;
+  }
+}
+
+//----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  bool printHelp(false);
+  int verboseLevel = vtkPlusLogger::LOG_LEVEL_UNDEFINED;
+
+  vtksys::CommandLineArguments args;
+  args.Initialize(argc, argv);
+
+  args.AddArgument("--help", vtksys::CommandLineArguments::NO_ARGUMENT, &printHelp, "Print this help.");
+  args.AddArgument("--verbose", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &verboseLevel, "Verbose level (1=error only, 2=warning, 3=info, 4=debug, 5=trace)");
+
+  if (!args.Parse())
+  {
+    std::cerr << "Problem parsing arguments" << std::endl;
+    std::cout << "Help: " << args.GetHelp() << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  if (printHelp)
+  {
+    std::cout << args.GetHelp() << std::endl;
+    exit(EXIT_SUCCESS);
+  }
+
+  vtkPlusLogger::Instance()->SetLogLevel(verboseLevel);
+
+  if (TestBinaryAndTextFields() != PLUS_SUCCESS) { exit(EXIT_FAILURE); }
+  if (TestXmlRoundTrip() != PLUS_SUCCESS) { exit(EXIT_FAILURE); }
+  if (TestConcurrentReads() != PLUS_SUCCESS) { exit(EXIT_FAILURE); }
+
+  LOG_INFO("Test finished successfully!");
+  return EXIT_SUCCESS;
+}
@@ -219,6 +219,41 @@ int main(int argc, char **argv)
     return EXIT_FAILURE;
   }
 
+  /////////////////////////////////////////////////////////////////////////////
+  // Test getting multiple transforms at once (results must match GetTransform)
+  std::vector<PlusTransformName> batchTransformNames;
+  batchTransformNames.push_back(PlusTransformName("Phantom", "StylusTip"));
+  batchTransformNames.push_back(PlusTransformName("StylusTip", "Tracker"));
+  batchTransformNames.push_back(PlusTransformName("Stylus", "Tracker"));
+  batchTransformNames.push_back(PlusTransformName("Probe", "StylusTip"));
+  batchTransformNames.push_back(PlusTransformName("Probe", "Probe"));
+  batchTransformNames.push_back(PlusTransformName("Tracker", "StylusTip"));
+  std::vector< vtkSmartPointer<vtkMatrix4x4> > batchMatrixObjects;
+  std::vector<vtkMatrix4x4*> batchMatrices;
+  for (unsigned int i=0; i<batchTransformNames.size(); ++i)
+  {
+    batchMatrixObjects.push_back(vtkSmartPointer<vtkMatrix4x4>::New());
+    batchMatrices.push_back(batchMatrixObjects.back());
+  }
+  std::vector<bool> batchIsValid;
+  if (transformRepository->GetTransforms(batchTransformNames, batchMatrices, &batchIsValid)!=PLUS_SUCCESS)
+  {
+    LOG_ERROR("Failed to get multiple transforms");
+    return EXIT_FAILURE;
+  }
+  for (unsigned int i=0; i<batchTransformNames.size(); ++i)
+  {
+    vtkSmartPointer<vtkMatrix4x4> mxSingle=vtkSmartPointer<vtkMatrix4x4>::New();
+    transformRepository->GetTransform(batchTransformNames[i], mxSingle, &isValid);
+    posDiff=PlusMath::GetPositionDifference(batchMatrices[i], mxSingle);
+    orientDiff=PlusMath::GetOrientationDifference(batchMatrices[i], mxSingle);
+    if (fabs(posDiff)>0.001 || fabs(orientDiff)>0.001 || batchIsValid[i]!=isValid)
+    {
+      LOG_ERROR("Mismatch between transforms computed by GetTransforms and GetTransform: " << batchTransformNames[i].GetTransformName());
+      return EXIT_FAILURE;
+    }
+  }
+
   transformRepository->PrintSelf(std::cout, vtkIndent());
 
   /////////////////////////////////////////////////////////////////////////////
@@ -8,6 +8,7 @@ See License.txt for details.
 #include "PlusConfigure.h"
 #include "PlusMath.h"
 #include "PlusTrackedFrame.h"
+#include "vtkPlusMetaImageSequenceIO.h"
 #include "vtkPlusSequenceIO.h"
 #include "vtkPlusTrackedFrameList.h"
 #include "vtkPlusTransformRepository.h"
@@ -21,6 +22,11 @@ See License.txt for details.
 #include <vtkXMLUtilities.h>
 #include <vtksys/CommandLineArguments.hxx>
 #include <vtksys/RegularExpression.hxx>
+#include <vtksys/SystemTools.hxx>
+
+// STL includes
+#include <algorithm>
+#include <functional>
 
 enum OperationType
 {
@@ -74,11 +80,17 @@ PlusStatus ConvertStringToMatrix(std::string& strMatrix, vtkMatrix4x4* matrix);
 PlusStatus AddTransform(vtkPlusTrackedFrameList* trackedFrameList, std::vector<std::string> transformNamesToAdd, std::string deviceSetConfigurationFileName);
 PlusStatus FillRectangle(vtkPlusTrackedFrameList* trackedFrameList, const std::vector<unsigned int>& fillRectOrigin, const std::vector<unsigned int>& fillRectSize, int fillGrayLevel);
 PlusStatus CropRectangle(vtkPlusTrackedFrameList* trackedFrameList, PlusVideoFrame::FlipInfoType& flipInfo, const std::vector<int>& cropRectOrigin, const std::vector<int>& cropRectSize);
+PlusStatus EditSequenceFileFrameByFrame(const std::string& inputFileName, const std::string& outputFileName, bool useCompression, bool enableImageDataWrite,
+                                        bool writeFrameIndex, unsigned int firstFrameIndex, int lastFrameIndex, unsigned int frameIndexIncrement,
+                                        const std::function<PlusStatus(vtkPlusTrackedFrameList*)>& frameListOperation);
 
 namespace
 {
   const std::string FIELD_VALUE_FRAME_SCALAR = "{frame-scalar}";
   const std::string FIELD_VALUE_FRAME_TRANSFORM = "{frame-transform}";
+
+  // Number of frames that are kept in memory when a sequence file is edited frame by frame
+  const unsigned int FRAME_BY_FRAME_EDITING_CHUNK_SIZE = 20;
 }
 
 // Fuse all fields in sequence files into the first sequence
@@ -213,6 +225,8 @@ int main(int argc, char** argv)
   OperationType                   operation;
   bool                            useCompression = false;
   bool                            incrementTimestamps = false;
+  bool                            frameByFrame = false;
+  bool                            writeFrameIndex = false;
 
   int                             firstFrameIndex = -1; // First frame index used for trimming the sequence file.
   int                             lastFrameIndex = -1; // Last frame index used for trimming the sequence file.
@@ -281,7 +295,9 @@ int main(int argc, char** argv)
   args.AddArgument("--update-reference-transform", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &strUpdatedReferenceTransformName, "Set the reference transform name to update old files by changing all ToolToReference transforms to ToolToTracker transform.");
 
   args.AddArgument("--use-compression", vtksys::CommandLineArguments::NO_ARGUMENT, &useCompression, "Compress sequence file images.");
+  args.AddArgument("--write-frame-index", vtksys::CommandLineArguments::NO_ARGUMENT, &writeFrameIndex, "Compress each frame independently and write a frame index file next to the output file, which allows fast seeking in the compressed sequence file. Used only with --use-compression.");
   args.AddArgument("--increment-timestamps", vtksys::CommandLineArguments::NO_ARGUMENT, &incrementTimestamps, "Increment timestamps in the order of the input-file-names");
+  args.AddArgument("--frame-by-frame", vtksys::CommandLineArguments::NO_ARGUMENT, &frameByFrame, "Read, process, and write the frames one by one, so that sequence files that do not fit into memory can be edited. Supported for a single input file with TRIM, DECIMATE, FILL_IMAGE_RECTANGLE, CROP, REMOVE_IMAGE_DATA operations or without operation, if the output is not a compressed metafile.");
 
   args.AddArgument("--add-transform", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &transformNamesToAdd, "Name of the transform to add to each frame (e.g., StylusTipToTracker); multiple transforms can be added separated by a comma (e.g., StylusTipToReference,ProbeToReference)");
   args.AddArgument("--config-file", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &deviceSetConfigurationFileName, "Used device set configuration file path and name");
@@ -416,6 +432,16 @@ int main(int argc, char** argv)
   }
   else if (PlusCommon::IsEqualInsensitive(strOperation, "FILL_IMAGE_RECTANGLE"))
   {
+    if (rectOriginPix.size() != 2 || rectSizePix.size() != 2)
+    {
+      LOG_ERROR("Incorrect size of vector for rectangle origin or size. Aborting.");
+      return EXIT_FAILURE;
+    }
+    if (rectOriginPix[0] < 0 || rectOriginPix[1] < 0 || rectSizePix[0] < 0 || rectSizePix[1] < 0)
+    {
+      LOG_ERROR("Negative value for rectangle origin or size entered. Aborting.");
+      return EXIT_FAILURE;
+    }
     operation = FILL_IMAGE_RECTANGLE;
   }
   else if (PlusCommon::IsEqualInsensitive(strOperation, "CROP"))
@@ -451,10 +477,12 @@ int main(int argc, char** argv)
     return EXIT_FAILURE;
   }
 
-  ///////////////////////////////////////////////////////////////////
-  // Read input files
-
-  vtkSmartPointer<vtkPlusTrackedFrameList> trackedFrameList = vtkSmartPointer<vtkPlusTrackedFrameList>::New();
+  std::vector<unsigned int> rectOriginPixUint(rectOriginPix.begin(), rectOriginPix.end());
+  std::vector<unsigned int> rectSizePixUint(rectSizePix.begin(), rectSizePix.end());
+  PlusVideoFrame::FlipInfoType flipInfo;
+  flipInfo.hFlip = flipX;
+  flipInfo.vFlip = flipY;
+  flipInfo.eFlip = flipZ;
 
   if (!inputFileName.empty())
   {
@@ -462,6 +490,74 @@ int main(int argc, char** argv)
     inputFileNames.insert(inputFileNames.begin(), inputFileName);
   }
 
+  ///////////////////////////////////////////////////////////////////
+  // Edit frame by frame
+
+  // Operations that only need one frame at a time are performed while the frames are read from the input file,
+  // so that sequences that do not fit into memory can be edited, too. Compressed metafiles cannot be written
+  // in multiple parts, therefore they are always written from memory.
+  bool frameByFrameEditing = (frameByFrame && inputFileNames.size() == 1 && strUpdatedReferenceTransformName.empty()
+                              && !(useCompression && vtkPlusMetaImageSequenceIO::CanWriteFile(outputFileName)));
+  if (frameByFrame && !frameByFrameEditing)
+  {
+    LOG_WARNING("Frame-by-frame editing is not supported with the specified input and output files. The whole sequence is loaded into memory.");
+  }
+  if (frameByFrameEditing)
+  {
+    unsigned int firstFrameIndexUint = 0;
+    int lastFrameIndexInt = -1; // last frame of the sequence
+    unsigned int frameIndexIncrement = 1;
+    std::function<PlusStatus(vtkPlusTrackedFrameList*)> frameListOperation;
+    switch (operation)
+    {
+    case NO_OPERATION:
+    case APPEND:
+    case REMOVE_IMAGE_DATA:
+      break;
+    case TRIM:
+      firstFrameIndexUint = static_cast<unsigned int>(std::max(firstFrameIndex, 0));
+      lastFrameIndexInt = std::max(lastFrameIndex, 0);
+      LOG_INFO("Trim sequence file from frame #: " << firstFrameIndexUint << " to frame #" << lastFrameIndexInt);
+      break;
+    case DECIMATE:
+      LOG_INFO("Decimate sequence file: keep 1 frame out of every " << decimationFactor << " frames");
+      if (decimationFactor < 2)
+      {
+        LOG_ERROR("Invalid decimation factor: " << decimationFactor << ". It must be an integer larger or equal than 2.");
+        return EXIT_FAILURE;
+      }
+      frameIndexIncrement = static_cast<unsigned int>(decimationFactor);
+      break;
+    case FILL_IMAGE_RECTANGLE:
+      frameListOperation = [&](vtkPlusTrackedFrameList* frameList) { return FillRectangle(frameList, rectOriginPixUint, rectSizePixUint, fillGrayLevel); };
+      break;
+    case CROP:
+      frameListOperation = [&](vtkPlusTrackedFrameList* frameList) { return CropRectangle(frameList, flipInfo, rectOriginPix, rectSizePix); };
+      break;
+    default:
+      LOG_WARNING("Frame-by-frame editing is not supported for operation " << strOperation << ". The whole sequence is loaded into memory.");
+      frameByFrameEditing = false;
+    }
+
+    if (frameByFrameEditing)
+    {
+      LOG_INFO("Save output sequence file to: " << outputFileName);
+      if (EditSequenceFileFrameByFrame(inputFileNames[0], outputFileName, useCompression, operation != REMOVE_IMAGE_DATA,
+                                       writeFrameIndex, firstFrameIndexUint, lastFrameIndexInt, frameIndexIncrement, frameListOperation) != PLUS_SUCCESS)
+      {
+        LOG_ERROR("Couldn't edit sequence file: " << inputFileNames[0]);
+        return EXIT_FAILURE;
+      }
+      LOG_INFO("Sequence file editing was successful!");
+      return EXIT_SUCCESS;
+    }
+  }
+
+  ///////////////////////////////////////////////////////////////////
+  // Read input files
+
+  vtkSmartPointer<vtkPlusTrackedFrameList> trackedFrameList = vtkSmartPointer<vtkPlusTrackedFrameList>::New();
+
   // Multiple input files are appended unless sequences are mixed
   PlusStatus status = PLUS_SUCCESS;
   if (operation == MIX)
@@ -621,18 +717,6 @@ int main(int argc, char** argv)
   break;
   case FILL_IMAGE_RECTANGLE:
   {
-    if (rectOriginPix.size() != 2 || rectSizePix.size() != 2)
-    {
-      LOG_ERROR("Incorrect size of vector for rectangle origin or size. Aborting.");
-      return PLUS_FAIL;
-    }
-    if (rectOriginPix[0] < 0 || rectOriginPix[1] < 0 || rectSizePix[0] < 0 || rectSizePix[1] < 0)
-    {
-      LOG_ERROR("Negative value for rectangle origin or size entered. Aborting.");
-      return PLUS_FAIL;
-    }
-    std::vector<unsigned int> rectOriginPixUint(rectOriginPix.begin(), rectOriginPix.end());
-    std::vector<unsigned int> rectSizePixUint(rectSizePix.begin(), rectSizePix.end());
     // Fill a rectangular region in the image with a solid color
     if (FillRectangle(trackedFrameList, rectOriginPixUint, rectSizePixUint, fillGrayLevel) != PLUS_SUCCESS)
     {
@@ -644,10 +728,6 @@ int main(int argc, char** argv)
   case CROP:
   {
     // Crop a rectangular region from the image
-    PlusVideoFrame::FlipInfoType flipInfo;
-    flipInfo.hFlip = flipX;
-    flipInfo.vFlip = flipY;
-    flipInfo.eFlip = flipZ;
     if (CropRectangle(trackedFrameList, flipInfo, rectOriginPix, rectSizePix) != PLUS_SUCCESS)
     {
       LOG_ERROR("Failed to fill rectangle");
@@ -766,7 +846,32 @@ int main(int argc, char** argv)
   // Save output file to file
 
   LOG_INFO("Save output sequence file to: " << outputFileName);
-  if (vtkPlusSequenceIO::Write(outputFileName, trackedFrameList, trackedFrameList->GetImageOrientation(), useCompression, operation != REMOVE_IMAGE_DATA) != PLUS_SUCCESS)
+  if (writeFrameIndex)
+  {
+    if (vtksys::SystemTools::FileExists(outputFileName.c_str()))
+    {
+      // Remove the file before replacing it
+      vtksys::SystemTools::RemoveFile(outputFileName.c_str());
+    }
+    vtkSmartPointer<vtkPlusSequenceIOBase> writer = vtkSmartPointer<vtkPlusSequenceIOBase>::Take(vtkPlusSequenceIO::CreateSequenceHandlerForFile(outputFileName));
+    if (writer.GetPointer() == NULL)
+    {
+      return EXIT_FAILURE;
+    }
+    writer->SetUseCompression(useCompression);
+    writer->SetEnableImageDataWrite(operation != REMOVE_IMAGE_DATA);
+    writer->SetWriteFrameIndex(true);
+    writer->SetIsDataTimeSeries(trackedFrameList->GetNumberOfTrackedFrames() > 1);
+    writer->SetImageOrientationInFile(trackedFrameList->GetImageOrientation());
+    writer->SetTrackedFrameList(trackedFrameList);
+    writer->SetFileName(outputFileName);
+    if (writer->Write() != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Couldn't write sequence file: " << outputFileName);
+      return EXIT_FAILURE;
+    }
+  }
+  else if (vtkPlusSequenceIO::Write(outputFileName, trackedFrameList, trackedFrameList->GetImageOrientation(), useCompression, operation != REMOVE_IMAGE_DATA) != PLUS_SUCCESS)
   {
     LOG_ERROR("Couldn't write sequence file: " << outputFileName);
     return EXIT_FAILURE;
@@ -1169,3 +1274,110 @@ PlusStatus CropRectangle(vtkPlusTrackedFrameList* trackedFrameList, PlusVideoFra
 
   return PLUS_SUCCESS;
 }
+
+//-------------------------------------------------------
+PlusStatus EditSequenceFileFrameByFrame(const std::string& inputFileName, const std::string& outputFileName, bool useCompression, bool enableImageDataWrite,
+                                        bool writeFrameIndex, unsigned int firstFrameIndex, int lastFrameIndex, unsigned int frameIndexIncrement,
+                                        const std::function<PlusStatus(vtkPlusTrackedFrameList*)>& frameListOperation)
+{
+  LOG_INFO("Read input sequence file frame by frame: " << inputFileName);
+  vtkSmartPointer<vtkPlusSequenceIOBase> reader = vtkSmartPointer<vtkPlusSequenceIOBase>::Take(vtkPlusSequenceIO::CreateSequenceReaderForFile(inputFileName));
+  if (reader.GetPointer() == NULL || reader->StartFrameByFrameReading() != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Couldn't read sequence file: " << inputFileName);
+    return PLUS_FAIL;
+  }
+
+  const unsigned int numberOfFrames = reader->GetNumberOfFrames();
+  unsigned int lastFrameIndexUint = (lastFrameIndex < 0 ? numberOfFrames - 1 : static_cast<unsigned int>(lastFrameIndex));
+  if (numberOfFrames == 0 || lastFrameIndexUint >= numberOfFrames || firstFrameIndex > lastFrameIndexUint)
+  {
+    LOG_ERROR("Invalid input range: (" << firstFrameIndex << ", " << lastFrameIndexUint << ")" << " Permitted range within (0, " << static_cast<int>(numberOfFrames) - 1 << ")");
+    return PLUS_FAIL;
+  }
+  const unsigned int numberOfOutputFrames = (lastFrameIndexUint - firstFrameIndex) / frameIndexIncrement + 1;
+
+  // Frames are collected in this list and written to file in chunks
+  vtkSmartPointer<vtkPlusTrackedFrameList> outputFrameList = vtkSmartPointer<vtkPlusTrackedFrameList>::New();
+  std::vector<std::string> fieldNames;
+  reader->GetTrackedFrameList()->GetCustomFieldNameList(fieldNames);
+  for (std::vector<std::string>::iterator fieldNameIt = fieldNames.begin(); fieldNameIt != fieldNames.end(); ++fieldNameIt)
+  {
+    outputFrameList->SetCustomString(*fieldNameIt, reader->GetTrackedFrameList()->GetCustomString(*fieldNameIt));
+  }
+
+  if (vtksys::SystemTools::FileExists(outputFileName.c_str()))
+  {
+    // Remove the file before replacing it
+    vtksys::SystemTools::RemoveFile(outputFileName.c_str());
+  }
+  vtkSmartPointer<vtkPlusSequenceIOBase> writer = vtkSmartPointer<vtkPlusSequenceIOBase>::Take(vtkPlusSequenceIO::CreateSequenceHandlerForFile(outputFileName));
+  if (writer.GetPointer() == NULL)
+  {
+    return PLUS_FAIL;
+  }
+  writer->SetUseCompression(useCompression);
+  writer->SetEnableImageDataWrite(enableImageDataWrite);
+  writer->SetWriteFrameIndex(writeFrameIndex);
+  writer->SetIsDataTimeSeries(numberOfOutputFrames > 1);
+  writer->SetTrackedFrameList(outputFrameList);
+  writer->SetFileName(outputFileName);
+
+  bool isHeaderPrepared = false;
+  bool isData3D = false;
+  PlusTrackedFrame trackedFrame;
+  for (unsigned int frameIndex = firstFrameIndex; frameIndex <= lastFrameIndexUint; frameIndex += frameIndexIncrement)
+  {
+    vtkPlusLogger::PrintProgressbar((100.0 * frameIndex) / (lastFrameIndexUint + 1));
+
+    // Skipped frames are not decompressed if the input file has a frame index
+    if (reader->ReadFrame(frameIndex, trackedFrame) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to read frame #" << frameIndex << " from sequence file: " << inputFileName);
+      return PLUS_FAIL;
+    }
+    outputFrameList->AddTrackedFrame(&trackedFrame, vtkPlusTrackedFrameList::ADD_INVALID_FRAME);
+
+    bool lastOutputFrame = (frameIndex + frameIndexIncrement > lastFrameIndexUint);
+    if (outputFrameList->GetNumberOfTrackedFrames() < FRAME_BY_FRAME_EDITING_CHUNK_SIZE && !lastOutputFrame)
+    {
+      continue;
+    }
+
+    if (frameListOperation && frameListOperation(outputFrameList) != PLUS_SUCCESS)
+    {
+      return PLUS_FAIL;
+    }
+    if (!isHeaderPrepared)
+    {
+      // Header is prepared from the first processed frames, as the operation may change the frame size
+      writer->SetImageOrientationInFile(outputFrameList->GetImageOrientation());
+      isData3D = (outputFrameList->GetTrackedFrame(0)->GetFrameSize()[2] > 1);
+      if (writer->PrepareHeader() != PLUS_SUCCESS)
+      {
+        LOG_ERROR("Unable to prepare header of sequence file: " << outputFileName);
+        return PLUS_FAIL;
+      }
+      isHeaderPrepared = true;
+    }
+    if (writer->AppendImagesToHeader() != PLUS_SUCCESS || writer->WriteImages() != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Unable to write frames to sequence file: " << outputFileName);
+      return PLUS_FAIL;
+    }
+    outputFrameList->Clear();
+  }
+  reader->StopFrameByFrameReading();
+  vtkPlusLogger::PrintProgressbar(100);
+
+  writer->UpdateDimensionsCustomStrings(numberOfOutputFrames, isData3D);
+  writer->UpdateFieldInImageHeader(writer->GetDimensionSizeString());
+  writer->UpdateFieldInImageHeader(writer->GetDimensionKindsString());
+  if (writer->FinalizeHeader() != PLUS_SUCCESS || writer->Close() != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Couldn't write sequence file: " << outputFileName);
+    return PLUS_FAIL;
+  }
+
+  return PLUS_SUCCESS;
+}
@@ -6,11 +6,13 @@
 
 #include "PlusConfigure.h"
 #include "PlusTrackedFrame.h"
+#include "vtkMatrix4x4.h"
 #include "vtkObjectFactory.h"
 #include "vtkPlusRecursiveCriticalSection.h"
 #include "vtkTransform.h"
 #include "vtkPlusTransformRepository.h"
 #include "vtksys/SystemTools.hxx"
+#include <algorithm>
 
 //----------------------------------------------------------------------------
 
@@ -259,6 +261,9 @@ PlusStatus vtkPlusTransformRepository::SetTransform(const PlusTransformName& aTr
   toCoordFrame[aTransformName.From()].m_Transform->SetInput(fromCoordFrame[aTransformName.To()].m_Transform);
   toCoordFrame[aTransformName.From()].m_Transform->Inverse();
   toCoordFrame[aTransformName.From()].m_IsValid = isValid;
+
+  // New transform paths may be available now
+  this->InvalidatePathCache();
   return PLUS_SUCCESS;
 }
 
@@ -298,21 +303,33 @@ PlusStatus vtkPlusTransformRepository::GetTransform(const PlusTransformName& aTr
   PlusLockGuard<vtkPlusRecursiveCriticalSection> accessGuard(this->CriticalSection);
 
   // Check if we can find the transform by combining the input transforms
-  // To improve performance the already found paths could be stored in a map of transform name -> transformInfoList
-  TransformInfoListType transformInfoList;
-  if (FindPath(aTransformName, transformInfoList) != PLUS_SUCCESS)
+  const TransformInfoPathType* path = NULL;
+  if (this->GetCachedPath(aTransformName, path) != PLUS_SUCCESS)
   {
     // the transform cannot be computed, error has been already logged by FindPath
-    *isValid = false;
+    if (isValid != NULL)
+    {
+      (*isValid) = false;
+    }
     return PLUS_FAIL;
   }
 
-  // Create transform chain and compute transform status
-  vtkSmartPointer<vtkTransform> combinedTransform = vtkSmartPointer<vtkTransform>::New();
+  // Multiply the matrices along the path and compute transform status
+  double combinedElements[16];
+  double productElements[16];
   bool combinedTransformValid(true);
-  for (TransformInfoListType::iterator transformInfo = transformInfoList.begin(); transformInfo != transformInfoList.end(); ++transformInfo)
+  for (TransformInfoPathType::const_iterator transformInfo = path->begin(); transformInfo != path->end(); ++transformInfo)
   {
-    combinedTransform->Concatenate((*transformInfo)->m_Transform);
+    vtkMatrix4x4* transformMatrix = (*transformInfo)->m_Transform->GetMatrix();
+    if (transformInfo == path->begin())
+    {
+      vtkMatrix4x4::DeepCopy(combinedElements, transformMatrix);
+    }
+    else
+    {
+      vtkMatrix4x4::Multiply4x4(combinedElements, *transformMatrix->Element, productElements);
+      std::copy(productElements, productElements + 16, combinedElements);
+    }
     if (!(*transformInfo)->m_IsValid)
     {
       combinedTransformValid = false;
@@ -321,7 +338,7 @@ PlusStatus vtkPlusTransformRepository::GetTransform(const PlusTransformName& aTr
   // Save the results
   if (matrix != NULL)
   {
-    matrix->DeepCopy(combinedTransform->GetMatrix());
+    matrix->DeepCopy(combinedElements);
   }
 
   if (isValid != NULL)
@@ -332,6 +349,102 @@ PlusStatus vtkPlusTransformRepository::GetTransform(const PlusTransformName& aTr
   return PLUS_SUCCESS;
 }
 
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusTransformRepository::GetTransforms(const std::vector<PlusTransformName>& transformNames, const std::vector<vtkMatrix4x4*>& matrices, std::vector<bool>* isValid /*=NULL*/)
+{
+  if (matrices.size() != transformNames.size())
+  {
+    LOG_ERROR("vtkPlusTransformRepository::GetTransforms failed: the number of matrices (" << matrices.size()
+              << ") does not match the number of transform names (" << transformNames.size() << ")");
+    return PLUS_FAIL;
+  }
+  if (isValid != NULL)
+  {
+    isValid->assign(transformNames.size(), false);
+  }
+
+  // Product of the first transforms of a path. As there are no circles in the transform graph,
+  // the first and last transform identifies the sub-path, so the products can be shared between paths.
+  struct PathProduct
+  {
+    double Elements[16];
+    bool IsValid;
+  };
+  typedef std::map< std::pair<TransformInfo*, TransformInfo*>, PathProduct > PathProductMapType;
+  PathProductMapType pathProducts;
+
+  PlusLockGuard<vtkPlusRecursiveCriticalSection> accessGuard(this->CriticalSection);
+
+  int numberOfErrors(0);
+  for (unsigned int transformIndex = 0; transformIndex < transformNames.size(); ++transformIndex)
+  {
+    const PlusTransformName& transformName = transformNames[transformIndex];
+    if (!transformName.IsValid())
+    {
+      LOG_ERROR("Transform name is invalid");
+      numberOfErrors++;
+      continue;
+    }
+
+    if (transformName.From() == transformName.To())
+    {
+      if (matrices[transformIndex] != NULL)
+      {
+        matrices[transformIndex]->Identity();
+      }
+      if (isValid != NULL)
+      {
+        (*isValid)[transformIndex] = true;
+      }
+      continue;
+    }
+
+    const TransformInfoPathType* path = NULL;
+    if (this->GetCachedPath(transformName, path) != PLUS_SUCCESS)
+    {
+      // the transform cannot be computed, error has been already logged by FindPath
+      numberOfErrors++;
+      continue;
+    }
+
+    // Extend the products that have been already computed for a previous transform
+    const PathProduct* product = NULL;
+    for (TransformInfoPathType::const_iterator transformInfo = path->begin(); transformInfo != path->end(); ++transformInfo)
+    {
+      std::pair<PathProductMapType::iterator, bool> inserted = pathProducts.insert(
+            PathProductMapType::value_type(std::make_pair(path->front(), *transformInfo), PathProduct()));
+      if (inserted.second)
+      {
+        PathProduct& newProduct = inserted.first->second;
+        vtkMatrix4x4* transformMatrix = (*transformInfo)->m_Transform->GetMatrix();
+        if (product == NULL)
+        {
+          vtkMatrix4x4::DeepCopy(newProduct.Elements, transformMatrix);
+          newProduct.IsValid = (*transformInfo)->m_IsValid;
+        }
+        else
+        {
+          vtkMatrix4x4::Multiply4x4(product->Elements, *transformMatrix->Element, newProduct.Elements);
+          newProduct.IsValid = product->IsValid && (*transformInfo)->m_IsValid;
+        }
+      }
+      product = &(inserted.first->second);
+    }
+
+    // Save the results
+    if (matrices[transformIndex] != NULL)
+    {
+      matrices[transformIndex]->DeepCopy(product->Elements);
+    }
+    if (isValid != NULL)
+    {
+      (*isValid)[transformIndex] = product->IsValid;
+    }
+  }
+
+  return (numberOfErrors == 0 ? PLUS_SUCCESS : PLUS_FAIL);
+}
+
 //----------------------------------------------------------------------------
 PlusStatus vtkPlusTransformRepository::GetTransformValid(const PlusTransformName& aTransformName, bool& isValid)
 {
@@ -544,6 +657,36 @@ PlusStatus vtkPlusTransformRepository::FindPath(const PlusTransformName& aTransf
   return PLUS_FAIL;
 }
 
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusTransformRepository::GetCachedPath(const PlusTransformName& aTransformName, const TransformInfoPathType*& path, bool silent /*=false*/)
+{
+  std::pair<std::string, std::string> fromTo(aTransformName.From(), aTransformName.To());
+  TransformPathCacheType::iterator cachedPathIt = this->PathCache.find(fromTo);
+  if (cachedPathIt != this->PathCache.end())
+  {
+    path = &(cachedPathIt->second);
+    return PLUS_SUCCESS;
+  }
+
+  TransformInfoListType transformInfoList;
+  if (FindPath(aTransformName, transformInfoList, NULL, silent) != PLUS_SUCCESS)
+  {
+    // paths that are not found are not cached, as normally they are not queried repeatedly
+    return PLUS_FAIL;
+  }
+  TransformInfoPathType& newPath = this->PathCache[fromTo];
+  newPath.assign(transformInfoList.begin(), transformInfoList.end());
+  path = &newPath;
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusTransformRepository::InvalidatePathCache()
+{
+  PlusLockGuard<vtkPlusRecursiveCriticalSection> accessGuard(this->CriticalSection);
+  this->PathCache.clear();
+}
+
 //----------------------------------------------------------------------------
 PlusStatus vtkPlusTransformRepository::IsExistingTransform(PlusTransformName aTransformName, bool aSilent/* = true*/)
 {
@@ -552,8 +695,8 @@ PlusStatus vtkPlusTransformRepository::IsExistingTransform(PlusTransformName aTr
     return PLUS_SUCCESS;
   }
   PlusLockGuard<vtkPlusRecursiveCriticalSection> accessGuard(this->CriticalSection);
-  TransformInfoListType transformInfoList;
-  return FindPath(aTransformName, transformInfoList, NULL, aSilent);
+  const TransformInfoPathType* path = NULL;
+  return this->GetCachedPath(aTransformName, path, aSilent);
 }
 
 //----------------------------------------------------------------------------
@@ -582,6 +725,8 @@ PlusStatus vtkPlusTransformRepository::DeleteTransform(const PlusTransformName&
       return PLUS_FAIL;
     }
     fromCoordFrame.erase(fromToTransformInfoIt);
+    // Cached paths may refer to the deleted transform
+    this->InvalidatePathCache();
   }
   else
   {
@@ -608,6 +753,8 @@ PlusStatus vtkPlusTransformRepository::DeleteTransform(const PlusTransformName&
 //----------------------------------------------------------------------------
 void vtkPlusTransformRepository::Clear()
 {
+  PlusLockGuard<vtkPlusRecursiveCriticalSection> accessGuard(this->CriticalSection);
+  this->InvalidatePathCache();
   this->CoordinateFrames.clear();
 }
 
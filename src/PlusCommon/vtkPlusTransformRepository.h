@@ -12,6 +12,7 @@ See License.txt for details.
 #include "vtkObject.h"
 #include <list>
 #include <map>
+#include <vector>
 
 class PlusTrackedFrame;
 class vtkMatrix4x4;
@@ -36,6 +37,11 @@ Example usage:
   transformRepository->GetTransform("Image", "Tracker", mxImageToTracker, &status);
 \endcode
 
+Transform paths between coordinate frames are resolved once and cached until a transform is added or removed,
+therefore a GetTransform call only multiplies the matrices along the path. If several transforms are needed
+after each SetTransforms(trackedFrame) call then GetTransforms should be used, which computes the products of the
+common path prefixes of the requested transforms only once.
+
 The following coordinate frames are used commonly:
   \li Image: image frame coordinate system, origin is the bottom-left corner, unit is pixel
   \li Tool: coordinate system of the DRB attached to the probe, unit is mm
@@ -122,6 +128,20 @@ public:
   */
   virtual PlusStatus GetTransform(const PlusTransformName& aTransformName, vtkMatrix4x4* matrix, bool* isValid = NULL);
 
+  /*!
+    Get multiple transform matrices at once (typically all the transforms needed after a SetTransforms(trackedFrame) call).
+    Paths that start from the same coordinate frame share the products of their common leading transforms,
+    which are computed only once (e.g., ImageToProbe*ProbeToTracker is computed once for ImageToTracker and
+    ImageToReference, if ImageToReference is resolved through Image->Probe->Tracker->Reference). Transforms that
+    are only common at the end of the paths (e.g., TrackerToReference in Probe->Tracker->Reference and
+    Stylus->Tracker->Reference) are multiplied separately for each path.
+    \param transformNames names of the transforms to retrieve from the repository
+    \param matrices the retrieved transforms are copied into these matrices, must have the same number of elements as transformNames (NULL elements are allowed)
+    \param isValid if this parameter is not NULL then the transforms' validity statuses are returned in this vector
+    \return PLUS_FAIL if any of the transforms cannot be computed (the matrices of the other transforms are still set)
+  */
+  virtual PlusStatus GetTransforms(const std::vector<PlusTransformName>& transformNames, const std::vector<vtkMatrix4x4*>& matrices, std::vector<bool>* isValid = NULL);
+
   /*!
     Get the valid status of a transform matrix between two coordinate frames.
     The status is typically invalid when a tracked tool is out of view.
@@ -189,6 +209,11 @@ protected:
   /*! List of transforms */
   typedef std::list<TransformInfo*> TransformInfoListType;
 
+  /*! Transforms along a path, the transform between the end coordinate frames is the product of the transforms (in this order) */
+  typedef std::vector<TransformInfo*> TransformInfoPathType;
+  /*! For each (from, to) coordinate frame name pair (first) stores the transform path between them (second) */
+  typedef std::map< std::pair<std::string, std::string>, TransformInfoPathType > TransformPathCacheType;
+
   /*! Get a user-defined original input transform (or its inverse). Does not combine user-defined input transforms. */
   TransformInfo* GetOriginalTransform(const PlusTransformName& aTransformName);
 
@@ -202,8 +227,23 @@ protected:
   */
   PlusStatus FindPath(const PlusTransformName& aTransformName, TransformInfoListType& transformInfoList, const char* skipCoordFrameName = NULL, bool silent = false);
 
+  /*!
+    Get the transform path between the specified coordinate frames from the path cache. If the path is not cached yet
+    then it is found by FindPath and added to the cache.
+    \param aTransformName name of the transform to find (from and to coordinate frames must be different)
+    \param path the pointer to the cached path is returned here, it is valid until the next InvalidatePathCache call
+    \param silent Don't log an error if path cannot be found
+  */
+  PlusStatus GetCachedPath(const PlusTransformName& aTransformName, const TransformInfoPathType*& path, bool silent = false);
+
+  /*! Remove all transform paths from the cache. Must be called whenever a transform is added to or removed from the repository. */
+  void InvalidatePathCache();
+
   CoordFrameToCoordFrameToTransformMapType CoordinateFrames;
 
+  /*! Already found transform paths. The path only depends on the set of stored transforms, not on their values. */
+  TransformPathCacheType PathCache;
+
   vtkPlusRecursiveCriticalSection* CriticalSection;
 
   TransformInfo TransformToSelf;
@@ -37,6 +37,8 @@ vtkPlusImageProcessorVideoSource::vtkPlusImageProcessorVideoSource()
   
   // The data capture thread will be used to regularly read the frames and process them
   this->StartThreadForInternalUpdates = true;
+  // Process the frames as soon as they arrive instead of waiting for the next polling period
+  this->UpdateOnNewInputData = true;
 }
 
 //----------------------------------------------------------------------------
@@ -77,6 +77,32 @@ PlusStatus StreamBufferItem::DeepCopy( StreamBufferItem* dataItem )
   return PLUS_SUCCESS;
 }
 
+//----------------------------------------------------------------------------
+PlusStatus StreamBufferItem::ShallowCopy( StreamBufferItem* dataItem )
+{
+  if ( dataItem == NULL )
+  {
+    LOG_ERROR( "Failed to shallow copy data buffer item - buffer item NULL!" );
+    return PLUS_FAIL;
+  }
+  if ( this == dataItem )
+  {
+    return PLUS_SUCCESS;
+  }
+
+  this->Frame.ShallowCopy( dataItem->Frame );
+  this->FilteredTimeStamp = dataItem->FilteredTimeStamp;
+  this->UnfilteredTimeStamp = dataItem->UnfilteredTimeStamp;
+  this->Index = dataItem->Index;
+  this->Uid = dataItem->Uid;
+  this->CustomFrameFields = dataItem->CustomFrameFields;
+  this->Status = dataItem->Status;
+  this->Matrix->DeepCopy( dataItem->Matrix );
+  this->ValidTransformData = dataItem->ValidTransformData;
+
+  return PLUS_SUCCESS;
+}
+
 //----------------------------------------------------------------------------
 PlusStatus StreamBufferItem::SetMatrix( vtkMatrix4x4* matrix )
 {
@@ -133,6 +133,12 @@ public:
   /*! Copy stream buffer item */
   PlusStatus DeepCopy( StreamBufferItem* dataItem );
 
+  /*!
+    Copy stream buffer item, but share the video frame pixels with the source item instead of copying them.
+    See PlusVideoFrame::ShallowCopy for the rules of accessing shared pixel data.
+  */
+  PlusStatus ShallowCopy( StreamBufferItem* dataItem );
+
   PlusVideoFrame& GetFrame() { return this->Frame; };
 
   /*! Set tracker matrix */
@@ -379,14 +379,12 @@ PlusStatus vtkPlusSavedDataSource::InternalConnect()
     return PLUS_FAIL;
   }
 
-  vtkSmartPointer<vtkPlusTrackedFrameList> savedDataBuffer = vtkSmartPointer<vtkPlusTrackedFrameList>::New();
-
-  // Read sequence file into tracked frame list
-  vtkPlusSequenceIO::Read(foundAbsoluteImagePath, savedDataBuffer);
-
-  if (savedDataBuffer->GetNumberOfTrackedFrames() < 1)
+  // Frames are read from the sequence file one by one, so the file is not loaded into memory
+  // in addition to the local buffers
+  vtkSmartPointer<vtkPlusSequenceIOBase> sequenceReader = vtkSmartPointer<vtkPlusSequenceIOBase>::Take(vtkPlusSequenceIO::CreateSequenceReaderForFile(foundAbsoluteImagePath));
+  if (sequenceReader.GetPointer() == NULL)
   {
-    LOG_ERROR("Failed to connect to saved dataset - there is no frame in the sequence metafile!");
+    LOG_ERROR("Unable to connect to saved data video source: Unable to read sequence metafile: " << this->SequenceFile);
     return PLUS_FAIL;
   }
 
@@ -394,10 +392,10 @@ PlusStatus vtkPlusSavedDataSource::InternalConnect()
   switch (this->SimulatedStream)
   {
     case VIDEO_STREAM:
-      status = InternalConnectVideo(savedDataBuffer);
+      status = InternalConnectVideo(sequenceReader);
       break;
     case TRACKER_STREAM:
-      status = InternalConnectTracker(savedDataBuffer);
+      status = InternalConnectTracker(sequenceReader);
       break;
     default:
       LOG_ERROR("Unknown stream type: " << this->SimulatedStream);
@@ -457,32 +455,31 @@ PlusStatus vtkPlusSavedDataSource::InternalConnect()
 }
 
 //----------------------------------------------------------------------------
-PlusStatus vtkPlusSavedDataSource::InternalConnectVideo(vtkPlusTrackedFrameList* savedDataBuffer)
+PlusStatus vtkPlusSavedDataSource::InternalConnectVideo(vtkPlusSequenceIOBase* sequenceReader)
 {
-  // Set buffer parameters based on the input tracked frame list
   vtkPlusDataSource* outputDataSource = this->GetOutputDataSource();
   if (outputDataSource == NULL)
   {
     return PLUS_FAIL;
   }
-  if (outputDataSource->SetImageType(savedDataBuffer->GetImageType()) != PLUS_SUCCESS)
-  {
-    LOG_ERROR("Failed to set video buffer image type");
-    return PLUS_FAIL;
-  }
 
   // Saved data buffer contains data read directly from file, set up a new local buffer
+  // Buffer parameters are set based on the first frame in the file
   DeleteLocalBuffers();
   this->LocalVideoBuffer = vtkPlusBuffer::New();
-  this->LocalVideoBuffer->SetImageOrientation(savedDataBuffer->GetImageOrientation());
-  this->LocalVideoBuffer->SetImageType(savedDataBuffer->GetImageType());
-  this->LocalVideoBuffer->SetFrameSize(savedDataBuffer->GetFrameSize());
-  this->LocalVideoBuffer->SetNumberOfScalarComponents(savedDataBuffer->GetTrackedFrame(0)->GetNumberOfScalarComponents());
-  this->LocalVideoBuffer->SetPixelType(savedDataBuffer->GetTrackedFrame(0)->GetImageData()->GetVTKScalarPixelType());
-  this->LocalVideoBuffer->SetBufferSize(savedDataBuffer->GetNumberOfTrackedFrames());
   this->LocalVideoBuffer->SetLocalTimeOffsetSec(0.0);   // the time offset is copied from the output, so reset it to 0
-  this->LocalVideoBuffer->CopyImagesFromTrackedFrameList(savedDataBuffer, vtkPlusBuffer::READ_FILTERED_IGNORE_UNFILTERED_TIMESTAMPS, this->UseAllFrameFields);
-  savedDataBuffer->Clear();
+  if (this->LocalVideoBuffer->CopyImagesFromSequenceFile(sequenceReader, vtkPlusBuffer::READ_FILTERED_IGNORE_UNFILTERED_TIMESTAMPS, this->UseAllFrameFields) != PLUS_SUCCESS
+      && this->LocalVideoBuffer->GetNumberOfItems() < 1)
+  {
+    LOG_ERROR("Failed to connect to saved dataset - there is no frame in the sequence metafile!");
+    return PLUS_FAIL;
+  }
+
+  if (outputDataSource->SetImageType(this->LocalVideoBuffer->GetImageType()) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Failed to set video buffer image type");
+    return PLUS_FAIL;
+  }
 
   PlusStatus result(PLUS_SUCCESS);
   for (DataSourceContainerIterator it = this->VideoSources.begin(); it != this->VideoSources.end(); ++it)
@@ -531,12 +528,21 @@ PlusStatus vtkPlusSavedDataSource::InternalConnectVideo(vtkPlusTrackedFrameList*
 }
 
 //----------------------------------------------------------------------------
-PlusStatus vtkPlusSavedDataSource::InternalConnectTracker(vtkPlusTrackedFrameList* savedDataBuffer)
+PlusStatus vtkPlusSavedDataSource::InternalConnectTracker(vtkPlusSequenceIOBase* sequenceReader)
 {
+  // Tracking data is stored in the header, pixel data does not have to be read
+  if (sequenceReader->StartFrameByFrameReading() != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Failed to read sequence file: " << sequenceReader->GetFileName());
+    return PLUS_FAIL;
+  }
+  sequenceReader->StopFrameByFrameReading();
+  vtkPlusTrackedFrameList* savedDataBuffer = sequenceReader->GetTrackedFrameList();
+
   PlusTrackedFrame* frame = savedDataBuffer->GetTrackedFrame(0);
   if (frame == NULL)
   {
-    LOG_ERROR("The tracked frame buffer doesn't seem to contain any frames");
+    LOG_ERROR("Failed to connect to saved dataset - there is no frame in the sequence metafile!");
     return PLUS_FAIL;
   }
 
@@ -12,6 +12,7 @@ See License.txt for details.
 #include "vtkPlusDevice.h"
 
 class vtkPlusBuffer;
+class vtkPlusSequenceIOBase;
 
 class vtkPlusDataCollectionExport vtkPlusSavedDataSource;
 
@@ -96,10 +97,10 @@ protected:
   virtual PlusStatus InternalConnect();
 
   /*! Connect to device, in case the output is a video stream */
-  virtual PlusStatus InternalConnectVideo( vtkPlusTrackedFrameList* savedDataBuffer );
+  virtual PlusStatus InternalConnectVideo( vtkPlusSequenceIOBase* sequenceReader );
 
   /*! Connect to device, in case the output is a tracker stream */
-  virtual PlusStatus InternalConnectTracker( vtkPlusTrackedFrameList* savedDataBuffer );
+  virtual PlusStatus InternalConnectTracker( vtkPlusSequenceIOBase* sequenceReader );
 
   /*! Disconnect from device */
   virtual PlusStatus InternalDisconnect();
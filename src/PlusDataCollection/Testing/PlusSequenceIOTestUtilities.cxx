@@ -0,0 +1,161 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+#include "PlusConfigure.h"
+#include "PlusSequenceIOTestUtilities.h"
+
+#include "PlusTrackedFrame.h"
+#include "vtkMatrix4x4.h"
+#include "vtkPlusSequenceIO.h"
+#include "vtkPlusTrackedFrameList.h"
+#include "vtkSmartPointer.h"
+#include "vtksys/SystemTools.hxx"
+
+#include <algorithm>
+
+//----------------------------------------------------------------------------
+PlusStatus PlusSequenceIOTestUtilities::CreateTestSequence(vtkPlusTrackedFrameList* trackedFrameList, unsigned int numberOfFrames, const unsigned int frameSize[3], int invalidFrameIndex /*=-1*/)
+{
+  PlusTransformName probeToTrackerName("Probe", "Tracker");
+  vtkSmartPointer<vtkMatrix4x4> probeToTracker = vtkSmartPointer<vtkMatrix4x4>::New();
+  unsigned int randomState = 12345;
+  for (unsigned int frameIndex = 0; frameIndex < numberOfFrames; ++frameIndex)
+  {
+    PlusTrackedFrame trackedFrame;
+    if (static_cast<int>(frameIndex) != invalidFrameIndex)
+    {
+      PlusVideoFrame* videoFrame = trackedFrame.GetImageData();
+      if (videoFrame->AllocateFrame(frameSize, VTK_UNSIGNED_CHAR, 1) != PLUS_SUCCESS)
+      {
+        LOG_ERROR("Failed to allocate frame " << frameIndex);
+        return PLUS_FAIL;
+      }
+      videoFrame->SetImageOrientation(US_IMG_ORIENT_MF);
+      videoFrame->SetImageType(US_IMG_BRIGHTNESS);
+      unsigned char* pixels = static_cast<unsigned char*>(videoFrame->GetScalarPointer());
+      for (unsigned int z = 0; z < frameSize[2]; ++z)
+      {
+        for (unsigned int y = 0; y < frameSize[1]; ++y)
+        {
+          for (unsigned int x = 0; x < frameSize[0]; ++x)
+          {
+            randomState = randomState * 1103515245 + 12345;
+            unsigned int pattern = ((x + frameIndex) / 16 + y / 32) % 4 * 40;
+            *(pixels++) = static_cast<unsigned char>(pattern + (randomState >> 16) % 48);
+          }
+        }
+      }
+    }
+    trackedFrame.SetTimestamp(10.0 + 0.033 * frameIndex);
+    probeToTracker->SetElement(0, 3, frameIndex * 1.5);
+    trackedFrame.SetCustomFrameTransform(probeToTrackerName, probeToTracker);
+    trackedFrame.SetCustomFrameTransformStatus(probeToTrackerName, FIELD_OK);
+    trackedFrameList->AddTrackedFrame(&trackedFrame, vtkPlusTrackedFrameList::ADD_INVALID_FRAME);
+  }
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int PlusSequenceIOTestUtilities::CompareImages(vtkPlusTrackedFrameList* expectedFrameList, PlusTrackedFrame& actualFrame, unsigned int frameIndex, const std::string& fileName)
+{
+  PlusVideoFrame* expectedImage = expectedFrameList->GetTrackedFrame(frameIndex)->GetImageData();
+  PlusVideoFrame* actualImage = actualFrame.GetImageData();
+  if (!expectedImage->IsImageValid())
+  {
+    // Invalid frames are stored as blank images
+    return 0;
+  }
+  if (!actualImage->IsImageValid() || actualImage->GetFrameSizeInBytes() != expectedImage->GetFrameSizeInBytes()
+      || memcmp(expectedImage->GetScalarPointer(), actualImage->GetScalarPointer(), expectedImage->GetFrameSizeInBytes()) != 0)
+  {
+    LOG_ERROR("Frame " << frameIndex << " of " << fileName << " does not match the original image");
+    return 1;
+  }
+  return 0;
+}
+
+//----------------------------------------------------------------------------
+int PlusSequenceIOTestUtilities::WriteAndReadBack(vtkPlusSequenceIOBase* writer, vtkPlusTrackedFrameList* sourceFrameList, const std::string& fileName, WriteAndReadStatistics& statistics)
+{
+  writer->SetImageOrientationInFile(sourceFrameList->GetImageOrientation());
+  writer->SetTrackedFrameList(sourceFrameList);
+  writer->SetFileName(fileName);
+
+  double startTime = vtkPlusAccurateTimer::GetSystemTime();
+  if (writer->Write() != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Failed to write " << fileName);
+    return 1;
+  }
+  statistics.WriteTimeSec = vtkPlusAccurateTimer::GetSystemTime() - startTime;
+
+  vtkSmartPointer<vtkPlusTrackedFrameList> readFrameList = vtkSmartPointer<vtkPlusTrackedFrameList>::New();
+  startTime = vtkPlusAccurateTimer::GetSystemTime();
+  if (vtkPlusSequenceIO::Read(fileName, readFrameList) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Failed to read " << fileName);
+    return 1;
+  }
+  statistics.ReadTimeSec = vtkPlusAccurateTimer::GetSystemTime() - startTime;
+
+  statistics.ImageDataSizeMb = 0;
+  for (unsigned int frameIndex = 0; frameIndex < sourceFrameList->GetNumberOfTrackedFrames(); ++frameIndex)
+  {
+    statistics.ImageDataSizeMb += sourceFrameList->GetTrackedFrame(frameIndex)->GetImageData()->GetFrameSizeInBytes() / 1.0e6;
+  }
+  statistics.FileSizeMb = vtksys::SystemTools::FileLength(fileName.c_str()) / 1.0e6;
+
+  int numberOfErrors = 0;
+  if (readFrameList->GetNumberOfTrackedFrames() != sourceFrameList->GetNumberOfTrackedFrames())
+  {
+    LOG_ERROR("Number of frames mismatch in " << fileName << ": " << readFrameList->GetNumberOfTrackedFrames() << ", expected " << sourceFrameList->GetNumberOfTrackedFrames());
+    return 1;
+  }
+  for (unsigned int frameIndex = 0; frameIndex < readFrameList->GetNumberOfTrackedFrames(); ++frameIndex)
+  {
+    numberOfErrors += CompareImages(sourceFrameList, *readFrameList->GetTrackedFrame(frameIndex), frameIndex, fileName);
+  }
+
+  if (!writer->GetWriteFrameIndex())
+  {
+    return numberOfErrors;
+  }
+
+  // Frames are accessible through the frame index. Consecutive frames may be decoded from the same key frame.
+  vtkSmartPointer<vtkPlusSequenceIOBase> reader = vtkSmartPointer<vtkPlusSequenceIOBase>::Take(vtkPlusSequenceIO::CreateSequenceReaderForFile(fileName));
+  if (reader.GetPointer() == NULL || reader->StartFrameByFrameReading() != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Failed to start frame-by-frame reading of " << fileName);
+    return numberOfErrors + 1;
+  }
+  if (reader->GetCompressionCodec() != writer->GetCompressionCodec())
+  {
+    LOG_ERROR("Compression codec mismatch in " << fileName << ": " << reader->GetCompressionCodec() << ", expected " << writer->GetCompressionCodec());
+    numberOfErrors++;
+  }
+  if (!reader->IsFrameIndexAvailable())
+  {
+    LOG_ERROR("Frame index is not available for " << fileName);
+    numberOfErrors++;
+  }
+  unsigned int lastFrameIndex = sourceFrameList->GetNumberOfTrackedFrames() - 1;
+  unsigned int frameReadOrder[] = { lastFrameIndex, lastFrameIndex / 2, lastFrameIndex / 2 + 1, 0, 1 };
+  PlusTrackedFrame trackedFrame;
+  for (unsigned int i = 0; i < sizeof(frameReadOrder) / sizeof(frameReadOrder[0]); ++i)
+  {
+    unsigned int frameIndex = std::min(frameReadOrder[i], lastFrameIndex);
+    if (reader->ReadFrame(frameIndex, trackedFrame) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to read frame " << frameIndex << " of " << fileName);
+      numberOfErrors++;
+      continue;
+    }
+    numberOfErrors += CompareImages(sourceFrameList, trackedFrame, frameIndex, fileName);
+  }
+  reader->StopFrameByFrameReading();
+
+  return numberOfErrors;
+}
@@ -0,0 +1,57 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+/*!
+  \file PlusSequenceIOTestUtilities.h
+  \brief Synthetic test sequence and write - read back - compare check, shared between the sequence file reading and writing tests.
+*/
+
+#ifndef __PlusSequenceIOTestUtilities_h
+#define __PlusSequenceIOTestUtilities_h
+
+#include "PlusCommon.h"
+
+#include <string>
+
+class PlusTrackedFrame;
+class vtkPlusSequenceIOBase;
+class vtkPlusTrackedFrameList;
+
+namespace PlusSequenceIOTestUtilities
+{
+  /*! Size of the image data and the file and the processing times of a sequence file that is written and read back */
+  struct WriteAndReadStatistics
+  {
+    double WriteTimeSec;
+    double ReadTimeSec;
+    double ImageDataSizeMb;
+    double FileSizeMb;
+  };
+
+  /*!
+    Create 8-bit brightness frames with speckle-like noise over a slowly moving pattern, which compresses similarly to B-mode
+    ultrasound images, and a ProbeToTracker transform that changes in each frame. The result only depends on the input arguments.
+    \param invalidFrameIndex Index of a frame that is added without image data, -1 if all the frames have image data
+  */
+  PlusStatus CreateTestSequence(vtkPlusTrackedFrameList* trackedFrameList, unsigned int numberOfFrames, const unsigned int frameSize[3], int invalidFrameIndex = -1);
+
+  /*!
+    Compare the image of a frame that is read from a file to the image of the frame with the same index in the expected frame list.
+    Frames without image data are stored as blank images, therefore they are not compared.
+    Returns the number of errors (0 or 1).
+  */
+  int CompareImages(vtkPlusTrackedFrameList* expectedFrameList, PlusTrackedFrame& actualFrame, unsigned int frameIndex, const std::string& fileName);
+
+  /*!
+    Write the source frames into the file using the writer, which must have all the compression settings set already,
+    read the whole file and compare the images to the source frames. If the writer writes a frame index then the compression codec
+    and the frame index are checked and frames are read by random access, in both directions and consecutively, and compared as well.
+    Returns the number of errors.
+  */
+  int WriteAndReadBack(vtkPlusSequenceIOBase* writer, vtkPlusTrackedFrameList* sourceFrameList, const std::string& fileName, WriteAndReadStatistics& statistics);
+}
+
+#endif
@@ -0,0 +1,234 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+// Measure reader and writer throughput of a vtkPlusBuffer that is accessed by one writer
+// and multiple reader threads, with and without lock-free reading.
+// Readers also verify that the returned UIDs, timestamps and frame indices are consistent.
+
+#include "PlusConfigure.h"
+#include "vtkMatrix4x4.h"
+#include "vtkMultiThreader.h"
+#include "vtkPlusBuffer.h"
+#include "vtksys/CommandLineArguments.hxx"
+#include <atomic>
+#include <iomanip>
+
+namespace
+{
+  // Timestamp difference between subsequent items
+  const double ITEM_PERIOD_SEC = 0.001;
+  // Number of items to look back in time when testing time-based lookup
+  const int LOOKBACK_ITEMS = 50;
+
+  struct BenchmarkState
+  {
+    vtkPlusBuffer* Buffer;
+    std::atomic<bool> StopRequested;
+    std::atomic<int> NumberOfErrors;
+  };
+
+  struct ThreadState
+  {
+    BenchmarkState* Benchmark;
+    unsigned long long NumberOfOperations;
+  };
+}
+
+//----------------------------------------------------------------------------
+void* WriterThread(vtkMultiThreader::ThreadInfo* data)
+{
+  ThreadState* threadState = static_cast<ThreadState*>(data->UserData);
+  BenchmarkState* benchmark = threadState->Benchmark;
+  vtkSmartPointer<vtkMatrix4x4> matrix = vtkSmartPointer<vtkMatrix4x4>::New();
+
+  unsigned long frameNumber = 0;
+  while (!benchmark->StopRequested)
+  {
+    ++frameNumber;
+    // UID of the item will be the same as the frame number, readers rely on this
+    double timestamp = frameNumber * ITEM_PERIOD_SEC;
+    matrix->SetElement(0, 3, frameNumber);
+    if (benchmark->Buffer->AddTimeStampedItem(matrix, TOOL_OK, frameNumber, timestamp, timestamp) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to add item " << frameNumber << " to the buffer");
+      ++benchmark->NumberOfErrors;
+    }
+    threadState->NumberOfOperations++;
+  }
+  return NULL;
+}
+
+//----------------------------------------------------------------------------
+void* ReaderThread(vtkMultiThreader::ThreadInfo* data)
+{
+  ThreadState* threadState = static_cast<ThreadState*>(data->UserData);
+  BenchmarkState* benchmark = threadState->Benchmark;
+  vtkPlusBuffer* buffer = benchmark->Buffer;
+
+  while (!benchmark->StopRequested)
+  {
+    BufferItemUidType latestUid = buffer->GetLatestItemUidInBuffer();
+    if (latestUid <= LOOKBACK_ITEMS)
+    {
+      continue;
+    }
+
+    double latestTimestamp = 0;
+    if (buffer->GetTimeStamp(latestUid, latestTimestamp) != ITEM_OK)
+    {
+      continue;
+    }
+    if (fabs(latestTimestamp - latestUid * ITEM_PERIOD_SEC) > ITEM_PERIOD_SEC * 0.1)
+    {
+      LOG_ERROR("Inconsistent timestamp for item " << latestUid << ": " << std::fixed << latestTimestamp);
+      ++benchmark->NumberOfErrors;
+    }
+
+    BufferItemUidType pastUid = 0;
+    ItemStatus status = buffer->GetItemUidFromTime((latestUid - LOOKBACK_ITEMS) * ITEM_PERIOD_SEC, pastUid);
+    if (status == ITEM_OK)
+    {
+      unsigned long pastIndex = 0;
+      if (pastUid != latestUid - LOOKBACK_ITEMS)
+      {
+        LOG_ERROR("Inconsistent item found by time lookup: expected " << latestUid - LOOKBACK_ITEMS << ", got " << pastUid);
+        ++benchmark->NumberOfErrors;
+      }
+      else if (buffer->GetIndex(pastUid, pastIndex) == ITEM_OK && pastIndex != pastUid)
+      {
+        LOG_ERROR("Inconsistent frame index for item " << pastUid << ": " << pastIndex);
+        ++benchmark->NumberOfErrors;
+      }
+    }
+    else if (status != ITEM_NOT_AVAILABLE_ANYMORE)
+    {
+      LOG_ERROR("Time lookup failed for item " << latestUid - LOOKBACK_ITEMS);
+      ++benchmark->NumberOfErrors;
+    }
+
+    threadState->NumberOfOperations++;
+  }
+  return NULL;
+}
+
+//----------------------------------------------------------------------------
+int RunBenchmark(bool lockFreeReading, int numberOfReaders, double testTimeSec, int bufferSize)
+{
+  vtkSmartPointer<vtkPlusBuffer> buffer = vtkSmartPointer<vtkPlusBuffer>::New();
+  buffer->SetBufferSize(bufferSize);
+  buffer->SetLockFreeReading(lockFreeReading);
+
+  BenchmarkState benchmark;
+  benchmark.Buffer = buffer;
+  benchmark.StopRequested = false;
+  benchmark.NumberOfErrors = 0;
+
+  std::vector<ThreadState> threadStates(numberOfReaders + 1);
+  for (std::vector<ThreadState>::iterator it = threadStates.begin(); it != threadStates.end(); ++it)
+  {
+    it->Benchmark = &benchmark;
+    it->NumberOfOperations = 0;
+  }
+
+  vtkSmartPointer<vtkMultiThreader> multithreader = vtkSmartPointer<vtkMultiThreader>::New();
+  std::vector<int> threadIds;
+  double startTime = vtkPlusAccurateTimer::GetSystemTime();
+  threadIds.push_back(multithreader->SpawnThread((vtkThreadFunctionType)&WriterThread, &threadStates[0]));
+  for (int i = 1; i <= numberOfReaders; i++)
+  {
+    threadIds.push_back(multithreader->SpawnThread((vtkThreadFunctionType)&ReaderThread, &threadStates[i]));
+  }
+
+  vtkPlusAccurateTimer::Delay(testTimeSec);
+  benchmark.StopRequested = true;
+  for (std::vector<int>::iterator it = threadIds.begin(); it != threadIds.end(); ++it)
+  {
+    multithreader->TerminateThread(*it);
+  }
+  double elapsedTimeSec = vtkPlusAccurateTimer::GetSystemTime() - startTime;
+
+  unsigned long long numberOfReads = 0;
+  for (int i = 1; i <= numberOfReaders; i++)
+  {
+    numberOfReads += threadStates[i].NumberOfOperations;
+  }
+
+  LOG_INFO((lockFreeReading ? "Lock-free" : "Locked   ")
+           << " | readers: " << std::setw(2) << numberOfReaders
+           << " | writer: " << std::setw(10) << std::fixed << std::setprecision(0) << threadStates[0].NumberOfOperations / elapsedTimeSec << " items/s"
+           << " | readers total: " << std::setw(10) << numberOfReads / elapsedTimeSec << " queries/s"
+           << " | per reader: " << std::setw(10) << numberOfReads / elapsedTimeSec / numberOfReaders << " queries/s");
+
+  return benchmark.NumberOfErrors;
+}
+
+//----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  bool printHelp(false);
+  int verboseLevel = vtkPlusLogger::LOG_LEVEL_UNDEFINED;
+  double testTimeSec = 1.0;
+  int bufferSize = 150;
+  std::vector<int> numberOfReadersList;
+
+  vtksys::CommandLineArguments args;
+  args.Initialize(argc, argv);
+
+  args.AddArgument("--help", vtksys::CommandLineArguments::NO_ARGUMENT, &printHelp, "Print this help.");
+  args.AddArgument("--verbose", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &verboseLevel, "Verbose level (1=error only, 2=warning, 3=info, 4=debug, 5=trace)");
+  args.AddArgument("--test-time-sec", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &testTimeSec, "Length of each test run (in seconds, default: 1)");
+  args.AddArgument("--buffer-size", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &bufferSize, "Number of items in the buffer (default: 150)");
+  args.AddArgument("--number-of-readers", vtksys::CommandLineArguments::MULTI_ARGUMENT, &numberOfReadersList, "List of reader thread counts to test (default: 1 4 16)");
+
+  if (!args.Parse())
+  {
+    std::cerr << "Problem parsing arguments" << std::endl;
+    std::cout << "Help: " << args.GetHelp() << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  if (printHelp)
+  {
+    std::cout << args.GetHelp() << std::endl;
+    exit(EXIT_SUCCESS);
+  }
+
+  vtkPlusLogger::Instance()->SetLogLevel(verboseLevel);
+
+  if (bufferSize <= LOOKBACK_ITEMS)
+  {
+    LOG_ERROR("Buffer size must be larger than " << LOOKBACK_ITEMS);
+    exit(EXIT_FAILURE);
+  }
+
+  if (numberOfReadersList.empty())
+  {
+    numberOfReadersList.push_back(1);
+    numberOfReadersList.push_back(4);
+    numberOfReadersList.push_back(16);
+  }
+
+  int numberOfErrors = 0;
+  for (std::vector<int>::iterator it = numberOfReadersList.begin(); it != numberOfReadersList.end(); ++it)
+  {
+    if (*it < 1 || *it + 1 > VTK_MAX_THREADS)
+    {
+      LOG_ERROR("Invalid number of reader threads: " << *it);
+      exit(EXIT_FAILURE);
+    }
+    numberOfErrors += RunBenchmark(false, *it, testTimeSec, bufferSize);
+    numberOfErrors += RunBenchmark(true, *it, testTimeSec, bufferSize);
+  }
+
+  if (numberOfErrors > 0)
+  {
+    LOG_ERROR("Test failed, number of errors: " << numberOfErrors);
+    return EXIT_FAILURE;
+  }
+
+  LOG_INFO("Test completed successfully");
+  return EXIT_SUCCESS;
+}
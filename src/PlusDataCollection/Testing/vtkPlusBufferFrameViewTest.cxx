@@ -0,0 +1,166 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+// Verify that frame views returned by vtkPlusBuffer::GetStreamBufferItemView share the pixels
+// with the buffer and that the shared pixels are not overwritten while the view is alive.
+
+#include "PlusConfigure.h"
+#include "PlusTrackedFrame.h"
+#include "vtkPlusBuffer.h"
+#include "vtksys/CommandLineArguments.hxx"
+
+namespace
+{
+  const unsigned int FRAME_SIZE[3] = { 64, 48, 1 };
+  const int BUFFER_SIZE = 3;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus AddFrame(vtkPlusBuffer* buffer, unsigned char pixelValue, long frameNumber)
+{
+  std::vector<unsigned char> pixels(FRAME_SIZE[0] * FRAME_SIZE[1] * FRAME_SIZE[2], pixelValue);
+  int clipRectangleOrigin[3] = { PlusCommon::NO_CLIP, PlusCommon::NO_CLIP, PlusCommon::NO_CLIP };
+  int clipRectangleSize[3] = { PlusCommon::NO_CLIP, PlusCommon::NO_CLIP, PlusCommon::NO_CLIP };
+  double timestamp = frameNumber * 0.1;
+  return buffer->AddItem(&pixels[0], US_IMG_ORIENT_MF, FRAME_SIZE, VTK_UNSIGNED_CHAR, 1, US_IMG_BRIGHTNESS, 0, frameNumber,
+                         clipRectangleOrigin, clipRectangleSize, timestamp, timestamp);
+}
+
+//----------------------------------------------------------------------------
+int CheckFrame(PlusVideoFrame& frame, unsigned char expectedPixelValue, const std::string& frameName)
+{
+  unsigned int frameSize[3] = { 0, 0, 0 };
+  if (frame.GetFrameSize(frameSize) != PLUS_SUCCESS || frameSize[0] != FRAME_SIZE[0] || frameSize[1] != FRAME_SIZE[1] || frameSize[2] != FRAME_SIZE[2])
+  {
+    LOG_ERROR(frameName << ": unexpected frame size: " << frameSize[0] << "x" << frameSize[1] << "x" << frameSize[2]);
+    return 1;
+  }
+  unsigned char* pixels = static_cast<unsigned char*>(frame.GetScalarPointer());
+  for (unsigned long i = 0; i < frame.GetFrameSizeInBytes(); ++i)
+  {
+    if (pixels[i] != expectedPixelValue)
+    {
+      LOG_ERROR(frameName << ": pixel " << i << " value is " << static_cast<int>(pixels[i]) << ", expected " << static_cast<int>(expectedPixelValue));
+      return 1;
+    }
+  }
+  return 0;
+}
+
+//----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  bool printHelp(false);
+  int verboseLevel = vtkPlusLogger::LOG_LEVEL_UNDEFINED;
+
+  vtksys::CommandLineArguments args;
+  args.Initialize(argc, argv);
+
+  args.AddArgument("--help", vtksys::CommandLineArguments::NO_ARGUMENT, &printHelp, "Print this help.");
+  args.AddArgument("--verbose", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &verboseLevel, "Verbose level (1=error only, 2=warning, 3=info, 4=debug, 5=trace)");
+
+  if (!args.Parse())
+  {
+    std::cerr << "Problem parsing arguments" << std::endl;
+    std::cout << "Help: " << args.GetHelp() << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  if (printHelp)
+  {
+    std::cout << args.GetHelp() << std::endl;
+    exit(EXIT_SUCCESS);
+  }
+
+  vtkPlusLogger::Instance()->SetLogLevel(verboseLevel);
+
+  vtkSmartPointer<vtkPlusBuffer> buffer = vtkSmartPointer<vtkPlusBuffer>::New();
+  buffer->SetImageType(US_IMG_BRIGHTNESS);
+  buffer->SetImageOrientation(US_IMG_ORIENT_MF);
+  buffer->SetPixelType(VTK_UNSIGNED_CHAR);
+  buffer->SetNumberOfScalarComponents(1);
+  buffer->SetFrameSize(FRAME_SIZE[0], FRAME_SIZE[1], FRAME_SIZE[2]);
+  buffer->SetBufferSize(BUFFER_SIZE);
+
+  int numberOfErrors = 0;
+  long frameNumber = 1;
+  if (AddFrame(buffer, 1, frameNumber) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Failed to add frame " << frameNumber);
+    exit(EXIT_FAILURE);
+  }
+  BufferItemUidType pinnedUid = buffer->GetLatestItemUidInBuffer();
+
+  // Views share the pixels with the buffer, copies don't
+  StreamBufferItem view;
+  StreamBufferItem otherView;
+  StreamBufferItem copy;
+  if (buffer->GetStreamBufferItemView(pinnedUid, &view) != ITEM_OK
+      || buffer->GetStreamBufferItemView(pinnedUid, &otherView) != ITEM_OK
+      || buffer->GetStreamBufferItem(pinnedUid, &copy) != ITEM_OK)
+  {
+    LOG_ERROR("Failed to get buffer item " << pinnedUid);
+    exit(EXIT_FAILURE);
+  }
+  if (view.GetFrame().GetScalarPointer() != otherView.GetFrame().GetScalarPointer())
+  {
+    LOG_ERROR("Views of the same buffer item don't share pixel data");
+    numberOfErrors++;
+  }
+  if (view.GetFrame().GetScalarPointer() == copy.GetFrame().GetScalarPointer())
+  {
+    LOG_ERROR("Copy of a buffer item shares pixel data with the buffer");
+    numberOfErrors++;
+  }
+  numberOfErrors += CheckFrame(view.GetFrame(), 1, "View");
+
+  // Overwrite all the slots of the buffer (twice), the view must not change
+  for (unsigned char pixelValue = 2; pixelValue <= 2 * BUFFER_SIZE + 1; ++pixelValue)
+  {
+    ++frameNumber;
+    if (AddFrame(buffer, pixelValue, frameNumber) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to add frame " << frameNumber);
+      exit(EXIT_FAILURE);
+    }
+  }
+  if (buffer->GetOldestItemUidInBuffer() <= pinnedUid)
+  {
+    LOG_ERROR("Item " << pinnedUid << " is expected to be removed from the buffer");
+    numberOfErrors++;
+  }
+  numberOfErrors += CheckFrame(view.GetFrame(), 1, "View after overwriting the buffer");
+  numberOfErrors += CheckFrame(otherView.GetFrame(), 1, "Other view after overwriting the buffer");
+
+  StreamBufferItem latestItem;
+  if (buffer->GetLatestStreamBufferItem(&latestItem) != ITEM_OK)
+  {
+    LOG_ERROR("Failed to get latest buffer item");
+    exit(EXIT_FAILURE);
+  }
+  numberOfErrors += CheckFrame(latestItem.GetFrame(), 2 * BUFFER_SIZE + 1, "Latest item");
+
+  // Writing into a tracked frame that shares the pixels must not modify the view
+  PlusTrackedFrame trackedFrame;
+  trackedFrame.ShareImageData(view.GetFrame());
+  if (trackedFrame.GetImageData()->GetScalarPointer() != view.GetFrame().GetScalarPointer())
+  {
+    LOG_ERROR("Tracked frame doesn't share pixel data with the view");
+    numberOfErrors++;
+  }
+  trackedFrame.GetImageData()->FillBlank();
+  numberOfErrors += CheckFrame(*trackedFrame.GetImageData(), 0, "Tracked frame after filling");
+  numberOfErrors += CheckFrame(view.GetFrame(), 1, "View after filling the tracked frame");
+
+  if (numberOfErrors > 0)
+  {
+    LOG_ERROR("Test failed, number of errors: " << numberOfErrors);
+    return EXIT_FAILURE;
+  }
+
+  LOG_INFO("Test completed successfully");
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,207 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+// Verify that vtkPlusNewItemSignal is notified when items are added to a vtkPlusBuffer and
+// compare the latency of a consumer that polls the buffer with one that waits for the signal.
+
+#include "PlusConfigure.h"
+#include "vtkMatrix4x4.h"
+#include "vtkMultiThreader.h"
+#include "vtkPlusBuffer.h"
+#include "vtkPlusNewItemSignal.h"
+#include "vtksys/CommandLineArguments.hxx"
+#include <atomic>
+
+namespace
+{
+  struct LatencyBenchmarkState
+  {
+    vtkPlusBuffer* Buffer;
+    vtkPlusNewItemSignal* Signal;
+    bool WaitForSignal;
+    double PollingPeriodSec;
+    std::atomic<bool> StopRequested;
+    unsigned long NumberOfDetectedItems;
+    double LatencySumSec;
+    double LatencyMaxSec;
+  };
+}
+
+//----------------------------------------------------------------------------
+void* ConsumerThread(vtkMultiThreader::ThreadInfo* data)
+{
+  LatencyBenchmarkState* state = static_cast<LatencyBenchmarkState*>(data->UserData);
+  BufferItemUidType lastUid = state->Buffer->GetLatestItemUidInBuffer();
+  unsigned long long lastNotificationCount = state->Signal->GetNotificationCount();
+  while (!state->StopRequested)
+  {
+    BufferItemUidType latestUid = state->Buffer->GetLatestItemUidInBuffer();
+    if (latestUid != lastUid && state->Buffer->GetNumberOfItems() > 0)
+    {
+      double detectionTime = vtkPlusAccurateTimer::GetSystemTime();
+      double itemTimestamp = 0;
+      if (state->Buffer->GetTimeStamp(latestUid, itemTimestamp) == ITEM_OK)
+      {
+        double latencySec = detectionTime - itemTimestamp;
+        state->NumberOfDetectedItems++;
+        state->LatencySumSec += latencySec;
+        state->LatencyMaxSec = std::max(state->LatencyMaxSec, latencySec);
+      }
+      lastUid = latestUid;
+    }
+    if (state->WaitForSignal)
+    {
+      state->Signal->WaitForNewItem(lastNotificationCount, state->PollingPeriodSec);
+    }
+    else
+    {
+      vtkPlusAccurateTimer::Delay(state->PollingPeriodSec);
+    }
+  }
+  return NULL;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus AddItem(vtkPlusBuffer* buffer, unsigned long frameNumber)
+{
+  vtkSmartPointer<vtkMatrix4x4> matrix = vtkSmartPointer<vtkMatrix4x4>::New();
+  double timestamp = vtkPlusAccurateTimer::GetSystemTime();
+  return buffer->AddTimeStampedItem(matrix, TOOL_OK, frameNumber, timestamp, timestamp);
+}
+
+//----------------------------------------------------------------------------
+int TestNotifications()
+{
+  int numberOfErrors = 0;
+  vtkSmartPointer<vtkPlusBuffer> buffer = vtkSmartPointer<vtkPlusBuffer>::New();
+  vtkSmartPointer<vtkPlusNewItemSignal> signal = vtkSmartPointer<vtkPlusNewItemSignal>::New();
+
+  unsigned long long lastNotificationCount = signal->GetNotificationCount();
+  if (signal->WaitForNewItem(lastNotificationCount, 0.01))
+  {
+    LOG_ERROR("Signal is notified without adding items");
+    numberOfErrors++;
+  }
+
+  // Adding the same signal twice must not result in multiple notifications
+  buffer->AddNewItemSignal(signal);
+  buffer->AddNewItemSignal(signal);
+  const unsigned long numberOfItems = 5;
+  for (unsigned long frameNumber = 1; frameNumber <= numberOfItems; ++frameNumber)
+  {
+    AddItem(buffer, frameNumber);
+  }
+  unsigned long long previousNotificationCount = lastNotificationCount;
+  if (!signal->WaitForNewItem(lastNotificationCount, 0.01))
+  {
+    LOG_ERROR("Signal is not notified after adding items");
+    numberOfErrors++;
+  }
+  if (lastNotificationCount - previousNotificationCount != numberOfItems)
+  {
+    LOG_ERROR("Unexpected number of notifications: " << lastNotificationCount - previousNotificationCount << ", expected " << numberOfItems);
+    numberOfErrors++;
+  }
+
+  // No notifications after removing the signal
+  buffer->RemoveNewItemSignal(signal);
+  AddItem(buffer, numberOfItems + 1);
+  if (signal->WaitForNewItem(lastNotificationCount, 0.01))
+  {
+    LOG_ERROR("Signal is notified after it was removed from the buffer");
+    numberOfErrors++;
+  }
+
+  return numberOfErrors;
+}
+
+//----------------------------------------------------------------------------
+void RunLatencyBenchmark(bool waitForSignal, double itemPeriodSec, double pollingPeriodSec, double testTimeSec)
+{
+  vtkSmartPointer<vtkPlusBuffer> buffer = vtkSmartPointer<vtkPlusBuffer>::New();
+  vtkSmartPointer<vtkPlusNewItemSignal> signal = vtkSmartPointer<vtkPlusNewItemSignal>::New();
+  buffer->AddNewItemSignal(signal);
+
+  LatencyBenchmarkState state;
+  state.Buffer = buffer;
+  state.Signal = signal;
+  state.WaitForSignal = waitForSignal;
+  state.PollingPeriodSec = pollingPeriodSec;
+  state.StopRequested = false;
+  state.NumberOfDetectedItems = 0;
+  state.LatencySumSec = 0;
+  state.LatencyMaxSec = 0;
+
+  vtkSmartPointer<vtkMultiThreader> multithreader = vtkSmartPointer<vtkMultiThreader>::New();
+  int threadId = multithreader->SpawnThread((vtkThreadFunctionType)&ConsumerThread, &state);
+
+  unsigned long frameNumber = 0;
+  double startTime = vtkPlusAccurateTimer::GetSystemTime();
+  while (vtkPlusAccurateTimer::GetSystemTime() - startTime < testTimeSec)
+  {
+    AddItem(buffer, ++frameNumber);
+    vtkPlusAccurateTimer::Delay(itemPeriodSec);
+  }
+
+  state.StopRequested = true;
+  signal->Notify();
+  multithreader->TerminateThread(threadId);
+
+  LOG_INFO((waitForSignal ? "Event-driven" : "Polling     ")
+           << " | items: " << frameNumber
+           << " | detected: " << state.NumberOfDetectedItems
+           << " | mean latency: " << (state.NumberOfDetectedItems > 0 ? 1000.0 * state.LatencySumSec / state.NumberOfDetectedItems : 0) << "ms"
+           << " | max latency: " << 1000.0 * state.LatencyMaxSec << "ms");
+}
+
+//----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  bool printHelp(false);
+  int verboseLevel = vtkPlusLogger::LOG_LEVEL_UNDEFINED;
+  double testTimeSec = 1.0;
+  double itemPeriodSec = 0.033;
+  double pollingPeriodSec = 0.033;
+
+  vtksys::CommandLineArguments args;
+  args.Initialize(argc, argv);
+
+  args.AddArgument("--help", vtksys::CommandLineArguments::NO_ARGUMENT, &printHelp, "Print this help.");
+  args.AddArgument("--verbose", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &verboseLevel, "Verbose level (1=error only, 2=warning, 3=info, 4=debug, 5=trace)");
+  args.AddArgument("--test-time-sec", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &testTimeSec, "Length of each latency measurement (in seconds, default: 1)");
+  args.AddArgument("--item-period-sec", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &itemPeriodSec, "Time between adding items to the buffer (in seconds, default: 0.033)");
+  args.AddArgument("--polling-period-sec", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &pollingPeriodSec, "Polling period of the consumer, also used as maximum waiting time in event-driven mode (in seconds, default: 0.033)");
+
+  if (!args.Parse())
+  {
+    std::cerr << "Problem parsing arguments" << std::endl;
+    std::cout << "Help: " << args.GetHelp() << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  if (printHelp)
+  {
+    std::cout << args.GetHelp() << std::endl;
+    exit(EXIT_SUCCESS);
+  }
+
+  vtkPlusLogger::Instance()->SetLogLevel(verboseLevel);
+
+  int numberOfErrors = TestNotifications();
+
+  // Latency depends on the system load, so it is only reported
+  RunLatencyBenchmark(false, itemPeriodSec, pollingPeriodSec, testTimeSec);
+  RunLatencyBenchmark(true, itemPeriodSec, pollingPeriodSec, testTimeSec);
+
+  if (numberOfErrors > 0)
+  {
+    LOG_ERROR("Test failed, number of errors: " << numberOfErrors);
+    return EXIT_FAILURE;
+  }
+
+  LOG_INFO("Test completed successfully");
+  return EXIT_SUCCESS;
+}
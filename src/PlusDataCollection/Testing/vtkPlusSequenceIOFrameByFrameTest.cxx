@@ -0,0 +1,329 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+// Verify that reading a sequence file frame by frame (vtkPlusSequenceIOBase::StartFrameByFrameReading
+// and ReadNextFrame) or by random access (ReadFrame) gives the same result as reading the whole file
+// at once, for compressed and uncompressed metafiles and nrrd files, with and without frame index,
+// with and without reading frames ahead on a background thread.
+
+#include "PlusConfigure.h"
+#include "PlusSequenceIOTestUtilities.h"
+#include "PlusTrackedFrame.h"
+#include "vtkPlusConfig.h"
+#include "vtkPlusSequenceIO.h"
+#include "vtkPlusTrackedFrameList.h"
+#include "vtksys/CommandLineArguments.hxx"
+
+namespace
+{
+  const unsigned int FRAME_SIZE[3] = { 24, 16, 1 };
+  const unsigned int NUMBER_OF_FRAMES = 7;
+  const int INVALID_FRAME_INDEX = 3;
+  const unsigned int WRITE_CHUNK_SIZE = 3;
+  // Less than the number of frames, so that the read-ahead thread has to wait for the frames to be taken
+  const int READ_AHEAD_FRAME_COUNT = 2;
+}
+
+//----------------------------------------------------------------------------
+int CompareFrames(PlusTrackedFrame& expectedFrame, PlusTrackedFrame& actualFrame, unsigned int frameIndex)
+{
+  int numberOfErrors = 0;
+
+  std::vector<std::string> fieldNames;
+  expectedFrame.GetCustomFrameFieldNameList(fieldNames);
+  for (std::vector<std::string>::iterator fieldNameIt = fieldNames.begin(); fieldNameIt != fieldNames.end(); ++fieldNameIt)
+  {
+    const char* expectedValue = expectedFrame.GetCustomFrameField(*fieldNameIt);
+    const char* actualValue = actualFrame.GetCustomFrameField(*fieldNameIt);
+    if (actualValue == NULL || std::string(expectedValue) != actualValue)
+    {
+      LOG_ERROR("Frame " << frameIndex << ": field " << *fieldNameIt << " value mismatch: expected '" << expectedValue << "', actual '" << (actualValue ? actualValue : "(undefined)") << "'");
+      numberOfErrors++;
+    }
+  }
+
+  PlusVideoFrame* expectedImage = expectedFrame.GetImageData();
+  PlusVideoFrame* actualImage = actualFrame.GetImageData();
+  if (expectedImage->IsImageValid() != actualImage->IsImageValid())
+  {
+    LOG_ERROR("Frame " << frameIndex << ": image validity mismatch");
+    return numberOfErrors + 1;
+  }
+  if (!expectedImage->IsImageValid())
+  {
+    return numberOfErrors;
+  }
+  unsigned int expectedSize[3] = { 0, 0, 0 };
+  unsigned int actualSize[3] = { 0, 0, 0 };
+  expectedImage->GetFrameSize(expectedSize);
+  actualImage->GetFrameSize(actualSize);
+  if (expectedSize[0] != actualSize[0] || expectedSize[1] != actualSize[1] || expectedSize[2] != actualSize[2]
+      || expectedImage->GetVTKScalarPixelType() != actualImage->GetVTKScalarPixelType()
+      || expectedImage->GetNumberOfScalarComponents() != actualImage->GetNumberOfScalarComponents())
+  {
+    LOG_ERROR("Frame " << frameIndex << ": image format mismatch");
+    return numberOfErrors + 1;
+  }
+  if (memcmp(expectedImage->GetScalarPointer(), actualImage->GetScalarPointer(), expectedImage->GetFrameSizeInBytes()) != 0)
+  {
+    LOG_ERROR("Frame " << frameIndex << ": pixel data mismatch");
+    numberOfErrors++;
+  }
+  return numberOfErrors;
+}
+
+//----------------------------------------------------------------------------
+int TestFrameByFrameReading(vtkPlusTrackedFrameList* sourceFrameList, const std::string& outputFileName, bool useCompression, int readAheadFrameCount)
+{
+  std::string fileName = vtkPlusConfig::GetInstance()->GetOutputPath(outputFileName);
+  LOG_INFO("Test frame-by-frame reading of " << fileName << (useCompression ? " (compressed" : " (uncompressed") << ", read-ahead: " << readAheadFrameCount << " frames)");
+  if (vtkPlusSequenceIO::Write(fileName, sourceFrameList, sourceFrameList->GetImageOrientation(), useCompression) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Failed to write sequence file " << fileName);
+    return 1;
+  }
+
+  vtkSmartPointer<vtkPlusTrackedFrameList> fullyReadFrameList = vtkSmartPointer<vtkPlusTrackedFrameList>::New();
+  if (vtkPlusSequenceIO::Read(fileName, fullyReadFrameList) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Failed to read sequence file " << fileName);
+    return 1;
+  }
+
+  vtkSmartPointer<vtkPlusSequenceIOBase> reader = vtkSmartPointer<vtkPlusSequenceIOBase>::Take(vtkPlusSequenceIO::CreateSequenceReaderForFile(fileName));
+  if (reader.GetPointer() != NULL)
+  {
+    reader->SetReadAheadFrameCount(readAheadFrameCount);
+  }
+  if (reader.GetPointer() == NULL || reader->StartFrameByFrameReading() != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Failed to start frame-by-frame reading of " << fileName);
+    return 1;
+  }
+  if (reader->GetNumberOfFrames() != fullyReadFrameList->GetNumberOfTrackedFrames())
+  {
+    LOG_ERROR("Number of frames mismatch: " << reader->GetNumberOfFrames() << ", expected " << fullyReadFrameList->GetNumberOfTrackedFrames());
+    return 1;
+  }
+
+  int numberOfErrors = 0;
+  // The same frame object is reused for all the frames, as in typical applications
+  PlusTrackedFrame trackedFrame;
+  for (unsigned int frameIndex = 0; frameIndex < fullyReadFrameList->GetNumberOfTrackedFrames(); ++frameIndex)
+  {
+    if (!reader->IsNextFrameAvailable() || reader->ReadNextFrame(trackedFrame) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to read frame " << frameIndex << " of " << fileName);
+      return numberOfErrors + 1;
+    }
+    numberOfErrors += CompareFrames(*fullyReadFrameList->GetTrackedFrame(frameIndex), trackedFrame, frameIndex);
+  }
+  if (reader->IsNextFrameAvailable())
+  {
+    LOG_ERROR("Next frame is reported to be available after reading all the frames");
+    numberOfErrors++;
+  }
+  reader->StopFrameByFrameReading();
+
+  // Reading can be restarted
+  if (reader->StartFrameByFrameReading() != PLUS_SUCCESS || reader->ReadNextFrame(trackedFrame) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Failed to restart frame-by-frame reading of " << fileName);
+    return numberOfErrors + 1;
+  }
+  numberOfErrors += CompareFrames(*fullyReadFrameList->GetTrackedFrame(0), trackedFrame, 0);
+  reader->StopFrameByFrameReading();
+
+  return numberOfErrors;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus WriteSequenceFileInChunks(vtkPlusTrackedFrameList* sourceFrameList, const std::string& fileName, bool useCompression, bool writeFrameIndex)
+{
+  // Frames are written in multiple chunks, the same way as vtkPlusVirtualCapture records them
+  vtkSmartPointer<vtkPlusTrackedFrameList> chunkFrameList = vtkSmartPointer<vtkPlusTrackedFrameList>::New();
+  vtkSmartPointer<vtkPlusSequenceIOBase> writer = vtkSmartPointer<vtkPlusSequenceIOBase>::Take(vtkPlusSequenceIO::CreateSequenceHandlerForFile(fileName));
+  if (writer.GetPointer() == NULL)
+  {
+    return PLUS_FAIL;
+  }
+  writer->SetUseCompression(useCompression);
+  writer->SetWriteFrameIndex(writeFrameIndex);
+  writer->SetTrackedFrameList(chunkFrameList);
+  writer->SetFileName(fileName);
+
+  for (unsigned int frameIndex = 0; frameIndex < sourceFrameList->GetNumberOfTrackedFrames(); ++frameIndex)
+  {
+    chunkFrameList->AddTrackedFrame(sourceFrameList->GetTrackedFrame(frameIndex), vtkPlusTrackedFrameList::ADD_INVALID_FRAME);
+    if (chunkFrameList->GetNumberOfTrackedFrames() < WRITE_CHUNK_SIZE && frameIndex + 1 < sourceFrameList->GetNumberOfTrackedFrames())
+    {
+      continue;
+    }
+    if (frameIndex < WRITE_CHUNK_SIZE)
+    {
+      writer->SetImageOrientationInFile(chunkFrameList->GetImageOrientation());
+      if (writer->PrepareHeader() != PLUS_SUCCESS)
+      {
+        return PLUS_FAIL;
+      }
+    }
+    if (writer->AppendImagesToHeader() != PLUS_SUCCESS || writer->WriteImages() != PLUS_SUCCESS)
+    {
+      return PLUS_FAIL;
+    }
+    chunkFrameList->Clear();
+  }
+
+  writer->UpdateDimensionsCustomStrings(sourceFrameList->GetNumberOfTrackedFrames(), false);
+  writer->UpdateFieldInImageHeader(writer->GetDimensionSizeString());
+  writer->UpdateFieldInImageHeader(writer->GetDimensionKindsString());
+  if (writer->FinalizeHeader() != PLUS_SUCCESS || writer->Close() != PLUS_SUCCESS)
+  {
+    return PLUS_FAIL;
+  }
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int TestRandomAccessReading(vtkPlusTrackedFrameList* sourceFrameList, const std::string& outputFileName, bool useCompression, bool writeFrameIndex, int readAheadFrameCount)
+{
+  std::string fileName = vtkPlusConfig::GetInstance()->GetOutputPath(outputFileName);
+  LOG_INFO("Test random access reading of " << fileName << (useCompression ? " (compressed" : " (uncompressed") << (writeFrameIndex ? ", with frame index" : "") << ", read-ahead: " << readAheadFrameCount << " frames)");
+  if (WriteSequenceFileInChunks(sourceFrameList, fileName, useCompression, writeFrameIndex) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Failed to write sequence file " << fileName);
+    return 1;
+  }
+
+  vtkSmartPointer<vtkPlusTrackedFrameList> fullyReadFrameList = vtkSmartPointer<vtkPlusTrackedFrameList>::New();
+  if (vtkPlusSequenceIO::Read(fileName, fullyReadFrameList) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Failed to read sequence file " << fileName);
+    return 1;
+  }
+
+  vtkSmartPointer<vtkPlusSequenceIOBase> reader = vtkSmartPointer<vtkPlusSequenceIOBase>::Take(vtkPlusSequenceIO::CreateSequenceReaderForFile(fileName));
+  if (reader.GetPointer() != NULL)
+  {
+    reader->SetReadAheadFrameCount(readAheadFrameCount);
+  }
+  if (reader.GetPointer() == NULL || reader->StartFrameByFrameReading() != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Failed to start frame-by-frame reading of " << fileName);
+    return 1;
+  }
+  if (reader->GetNumberOfFrames() != NUMBER_OF_FRAMES || fullyReadFrameList->GetNumberOfTrackedFrames() != NUMBER_OF_FRAMES)
+  {
+    LOG_ERROR("Number of frames mismatch: " << reader->GetNumberOfFrames() << " (random access), " << fullyReadFrameList->GetNumberOfTrackedFrames() << " (full read), expected " << NUMBER_OF_FRAMES);
+    return 1;
+  }
+
+  int numberOfErrors = 0;
+  if (reader->IsFrameIndexAvailable() != (useCompression && writeFrameIndex))
+  {
+    LOG_ERROR("Frame index is " << (reader->IsFrameIndexAvailable() ? "available" : "not available") << " for " << fileName);
+    numberOfErrors++;
+  }
+
+  // Forward and backward seeking, also within and across the written chunks
+  const unsigned int frameReadOrder[] = { 5, 2, 0, 6, 3, 1, 4, 4, 0 };
+  PlusTrackedFrame trackedFrame;
+  for (unsigned int i = 0; i < sizeof(frameReadOrder) / sizeof(frameReadOrder[0]); ++i)
+  {
+    unsigned int frameIndex = frameReadOrder[i];
+    if (reader->ReadFrame(frameIndex, trackedFrame) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to read frame " << frameIndex << " of " << fileName);
+      return numberOfErrors + 1;
+    }
+    numberOfErrors += CompareFrames(*fullyReadFrameList->GetTrackedFrame(frameIndex), trackedFrame, frameIndex);
+  }
+
+  // Sequential reading continues after the last randomly accessed frame
+  for (unsigned int frameIndex = 1; frameIndex < NUMBER_OF_FRAMES; ++frameIndex)
+  {
+    if (!reader->IsNextFrameAvailable() || reader->ReadNextFrame(trackedFrame) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to read frame " << frameIndex << " of " << fileName << " after seeking");
+      return numberOfErrors + 1;
+    }
+    numberOfErrors += CompareFrames(*fullyReadFrameList->GetTrackedFrame(frameIndex), trackedFrame, frameIndex);
+  }
+
+  // Frames returned by GetTrackedFrame are read from the file
+  PlusTrackedFrame* lastFrame = reader->GetTrackedFrame(NUMBER_OF_FRAMES - 1);
+  if (lastFrame == NULL)
+  {
+    LOG_ERROR("Failed to get frame " << NUMBER_OF_FRAMES - 1 << " of " << fileName);
+    return numberOfErrors + 1;
+  }
+  numberOfErrors += CompareFrames(*fullyReadFrameList->GetTrackedFrame(NUMBER_OF_FRAMES - 1), *lastFrame, NUMBER_OF_FRAMES - 1);
+
+  reader->StopFrameByFrameReading();
+  return numberOfErrors;
+}
+
+//----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  bool printHelp(false);
+  int verboseLevel = vtkPlusLogger::LOG_LEVEL_UNDEFINED;
+
+  vtksys::CommandLineArguments args;
+  args.Initialize(argc, argv);
+
+  args.AddArgument("--help", vtksys::CommandLineArguments::NO_ARGUMENT, &printHelp, "Print this help.");
+  args.AddArgument("--verbose", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &verboseLevel, "Verbose level (1=error only, 2=warning, 3=info, 4=debug, 5=trace)");
+
+  if (!args.Parse())
+  {
+    std::cerr << "Problem parsing arguments" << std::endl;
+    std::cout << "Help: " << args.GetHelp() << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  if (printHelp)
+  {
+    std::cout << args.GetHelp() << std::endl;
+    exit(EXIT_SUCCESS);
+  }
+
+  vtkPlusLogger::Instance()->SetLogLevel(verboseLevel);
+
+  vtkSmartPointer<vtkPlusTrackedFrameList> sourceFrameList = vtkSmartPointer<vtkPlusTrackedFrameList>::New();
+  if (PlusSequenceIOTestUtilities::CreateTestSequence(sourceFrameList, NUMBER_OF_FRAMES, FRAME_SIZE, INVALID_FRAME_INDEX) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Failed to create test sequence");
+    return EXIT_FAILURE;
+  }
+
+  int numberOfErrors = 0;
+  const int readAheadFrameCounts[] = { 0, READ_AHEAD_FRAME_COUNT };
+  for (unsigned int i = 0; i < sizeof(readAheadFrameCounts) / sizeof(readAheadFrameCounts[0]); ++i)
+  {
+    int readAheadFrameCount = readAheadFrameCounts[i];
+    numberOfErrors += TestFrameByFrameReading(sourceFrameList, "SequenceIOFrameByFrameTest.mha", false, readAheadFrameCount);
+    numberOfErrors += TestFrameByFrameReading(sourceFrameList, "SequenceIOFrameByFrameTestCompressed.mha", true, readAheadFrameCount);
+    numberOfErrors += TestFrameByFrameReading(sourceFrameList, "SequenceIOFrameByFrameTest.nrrd", false, readAheadFrameCount);
+    numberOfErrors += TestFrameByFrameReading(sourceFrameList, "SequenceIOFrameByFrameTestCompressed.nrrd", true, readAheadFrameCount);
+
+    numberOfErrors += TestRandomAccessReading(sourceFrameList, "SequenceIORandomAccessTest.mha", false, false, readAheadFrameCount);
+    numberOfErrors += TestRandomAccessReading(sourceFrameList, "SequenceIORandomAccessTestCompressed.mha", true, false, readAheadFrameCount);
+    numberOfErrors += TestRandomAccessReading(sourceFrameList, "SequenceIORandomAccessTestCompressedIndexed.mha", true, true, readAheadFrameCount);
+    numberOfErrors += TestRandomAccessReading(sourceFrameList, "SequenceIORandomAccessTest.nrrd", false, false, readAheadFrameCount);
+    numberOfErrors += TestRandomAccessReading(sourceFrameList, "SequenceIORandomAccessTestCompressed.nrrd", true, false, readAheadFrameCount);
+    numberOfErrors += TestRandomAccessReading(sourceFrameList, "SequenceIORandomAccessTestCompressedIndexed.nrrd", true, true, readAheadFrameCount);
+  }
+
+  if (numberOfErrors > 0)
+  {
+    LOG_ERROR("Test failed, number of errors: " << numberOfErrors);
+    return EXIT_FAILURE;
+  }
+
+  LOG_INFO("Test completed successfully");
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,128 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+// Write the images of a sequence file into metafiles and nrrd files using the available compression codecs
+// (with and without frame difference encoding) and the standard zlib compression, verify that the files
+// can be read and contain the original images, and report the compression ratio and throughput.
+
+#include "PlusConfigure.h"
+#include "PlusFrameCodec.h"
+#include "PlusSequenceIOTestUtilities.h"
+#include "PlusTrackedFrame.h"
+#include "vtkPlusConfig.h"
+#include "vtkPlusSequenceIO.h"
+#include "vtkPlusTrackedFrameList.h"
+#include "vtksys/CommandLineArguments.hxx"
+#include "vtksys/SystemTools.hxx"
+#include <iomanip>
+
+//----------------------------------------------------------------------------
+int TestFrameCodec(vtkPlusTrackedFrameList* sourceFrameList, const std::string& outputFileName, const std::string& codecName, bool frameDelta, bool writeFrameIndex, int compressionThreadCount)
+{
+  std::string fileName = vtkPlusConfig::GetInstance()->GetOutputPath(outputFileName);
+  vtkSmartPointer<vtkPlusSequenceIOBase> writer = vtkSmartPointer<vtkPlusSequenceIOBase>::Take(vtkPlusSequenceIO::CreateSequenceHandlerForFile(fileName));
+  if (writer.GetPointer() == NULL)
+  {
+    LOG_ERROR("Failed to create writer for " << fileName);
+    return 1;
+  }
+  writer->SetUseCompression(true);
+  if (writer->SetCompressionCodec(codecName) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Failed to set compression codec " << codecName);
+    return 1;
+  }
+  writer->SetCompressionFrameDelta(frameDelta);
+  writer->SetCompressionThreadCount(compressionThreadCount);
+  writer->SetWriteFrameIndex(writeFrameIndex);
+
+  // Random access requires decoding from the closest key frame
+  PlusSequenceIOTestUtilities::WriteAndReadStatistics statistics;
+  int numberOfErrors = PlusSequenceIOTestUtilities::WriteAndReadBack(writer, sourceFrameList, fileName, statistics);
+  if (numberOfErrors == 0)
+  {
+    LOG_INFO(std::setw(5) << vtksys::SystemTools::GetFilenameLastExtension(fileName)
+             << " | codec: " << std::setw(7) << (codecName.empty() ? "zlib" : codecName)
+             << " | frame delta: " << (frameDelta ? "yes" : "no ")
+             << " | frame index: " << (writeFrameIndex ? "yes" : "no ")
+             << " | write speed: " << std::setw(8) << std::fixed << std::setprecision(1) << (statistics.WriteTimeSec > 0 ? statistics.ImageDataSizeMb / statistics.WriteTimeSec : 0) << " MB/s"
+             << " | read speed: " << std::setw(8) << (statistics.ReadTimeSec > 0 ? statistics.ImageDataSizeMb / statistics.ReadTimeSec : 0) << " MB/s"
+             << " | compression ratio: " << std::setprecision(3) << (statistics.ImageDataSizeMb > 0 ? statistics.FileSizeMb / statistics.ImageDataSizeMb : 0));
+  }
+  return numberOfErrors;
+}
+
+//----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  bool printHelp(false);
+  int verboseLevel = vtkPlusLogger::LOG_LEVEL_UNDEFINED;
+  std::string inputSeqFile;
+  int compressionThreadCount = 1;
+
+  vtksys::CommandLineArguments args;
+  args.Initialize(argc, argv);
+
+  args.AddArgument("--help", vtksys::CommandLineArguments::NO_ARGUMENT, &printHelp, "Print this help.");
+  args.AddArgument("--verbose", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &verboseLevel, "Verbose level (1=error only, 2=warning, 3=info, 4=debug, 5=trace)");
+  args.AddArgument("--seq-file", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &inputSeqFile, "Sequence file that contains the images to compress");
+  args.AddArgument("--compression-thread-count", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &compressionThreadCount, "Number of compression threads, 0 means one thread per processor core (default: 1)");
+
+  if (!args.Parse())
+  {
+    std::cerr << "Problem parsing arguments" << std::endl;
+    std::cout << "Help: " << args.GetHelp() << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  if (printHelp)
+  {
+    std::cout << args.GetHelp() << std::endl;
+    exit(EXIT_SUCCESS);
+  }
+
+  vtkPlusLogger::Instance()->SetLogLevel(verboseLevel);
+
+  if (inputSeqFile.empty())
+  {
+    LOG_ERROR("--seq-file argument is required");
+    exit(EXIT_FAILURE);
+  }
+
+  vtkSmartPointer<vtkPlusTrackedFrameList> sourceFrameList = vtkSmartPointer<vtkPlusTrackedFrameList>::New();
+  if (vtkPlusSequenceIO::Read(inputSeqFile, sourceFrameList) != PLUS_SUCCESS || sourceFrameList->GetNumberOfTrackedFrames() == 0)
+  {
+    LOG_ERROR("Failed to read images from " << inputSeqFile);
+    return EXIT_FAILURE;
+  }
+
+  LOG_INFO("Writing " << sourceFrameList->GetNumberOfTrackedFrames() << " frames of " << inputSeqFile);
+  std::vector<std::string> codecNames;
+  PlusFrameCodec::GetCodecNames(codecNames);
+  const char* fileExtensions[] = { ".mha", ".nrrd" };
+  int numberOfErrors = 0;
+  for (unsigned int i = 0; i < sizeof(fileExtensions) / sizeof(fileExtensions[0]); ++i)
+  {
+    std::string baseFileName = std::string("SequenceIOFrameCodecTest");
+    // Reference: standard zlib compression
+    numberOfErrors += TestFrameCodec(sourceFrameList, baseFileName + "Zlib" + fileExtensions[i], "", false, false, compressionThreadCount);
+    for (std::vector<std::string>::iterator codecIt = codecNames.begin(); codecIt != codecNames.end(); ++codecIt)
+    {
+      numberOfErrors += TestFrameCodec(sourceFrameList, baseFileName + *codecIt + fileExtensions[i], *codecIt, false, false, compressionThreadCount);
+      numberOfErrors += TestFrameCodec(sourceFrameList, baseFileName + *codecIt + "Delta" + fileExtensions[i], *codecIt, true, false, compressionThreadCount);
+      numberOfErrors += TestFrameCodec(sourceFrameList, baseFileName + *codecIt + "DeltaIndexed" + fileExtensions[i], *codecIt, true, true, compressionThreadCount);
+    }
+  }
+
+  if (numberOfErrors > 0)
+  {
+    LOG_ERROR("Test failed, number of errors: " << numberOfErrors);
+    return EXIT_FAILURE;
+  }
+
+  LOG_INFO("Test completed successfully");
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,136 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+// Write compressed metafiles and nrrd files using different numbers of compression threads,
+// verify that the files can be read and contain the original images, and report the write speed.
+
+#include "PlusConfigure.h"
+#include "PlusSequenceIOTestUtilities.h"
+#include "PlusTrackedFrame.h"
+#include "vtkMultiThreader.h"
+#include "vtkPlusConfig.h"
+#include "vtkPlusSequenceIO.h"
+#include "vtkPlusTrackedFrameList.h"
+#include "vtksys/CommandLineArguments.hxx"
+#include "vtksys/SystemTools.hxx"
+#include <iomanip>
+
+//----------------------------------------------------------------------------
+int TestParallelCompression(vtkPlusTrackedFrameList* sourceFrameList, const std::string& outputFileName, int compressionThreadCount, bool writeFrameIndex)
+{
+  std::string fileName = vtkPlusConfig::GetInstance()->GetOutputPath(outputFileName);
+  vtkSmartPointer<vtkPlusSequenceIOBase> writer = vtkSmartPointer<vtkPlusSequenceIOBase>::Take(vtkPlusSequenceIO::CreateSequenceHandlerForFile(fileName));
+  if (writer.GetPointer() == NULL)
+  {
+    LOG_ERROR("Failed to create writer for " << fileName);
+    return 1;
+  }
+  writer->SetUseCompression(true);
+  writer->SetCompressionThreadCount(compressionThreadCount);
+  writer->SetWriteFrameIndex(writeFrameIndex);
+
+  // All the frames can be read using the standard zlib/gzip decompression
+  PlusSequenceIOTestUtilities::WriteAndReadStatistics statistics;
+  int numberOfErrors = PlusSequenceIOTestUtilities::WriteAndReadBack(writer, sourceFrameList, fileName, statistics);
+  if (numberOfErrors == 0)
+  {
+    LOG_INFO(std::setw(4) << vtksys::SystemTools::GetFilenameLastExtension(fileName)
+             << " | threads: " << std::setw(2) << compressionThreadCount
+             << " | frame index: " << (writeFrameIndex ? "yes" : "no ")
+             << " | write speed: " << std::setw(8) << std::fixed << std::setprecision(1) << (statistics.WriteTimeSec > 0 ? statistics.ImageDataSizeMb / statistics.WriteTimeSec : 0) << " MB/s"
+             << " | compression ratio: " << std::setprecision(3) << (statistics.ImageDataSizeMb > 0 ? statistics.FileSizeMb / statistics.ImageDataSizeMb : 0));
+  }
+  return numberOfErrors;
+}
+
+//----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  bool printHelp(false);
+  int verboseLevel = vtkPlusLogger::LOG_LEVEL_UNDEFINED;
+  int numberOfFrames = 60;
+  std::vector<int> frameSizeList;
+  std::vector<int> compressionThreadCountList;
+
+  vtksys::CommandLineArguments args;
+  args.Initialize(argc, argv);
+
+  args.AddArgument("--help", vtksys::CommandLineArguments::NO_ARGUMENT, &printHelp, "Print this help.");
+  args.AddArgument("--verbose", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &verboseLevel, "Verbose level (1=error only, 2=warning, 3=info, 4=debug, 5=trace)");
+  args.AddArgument("--number-of-frames", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &numberOfFrames, "Number of frames written to each file (default: 60)");
+  args.AddArgument("--frame-size", vtksys::CommandLineArguments::MULTI_ARGUMENT, &frameSizeList, "Width and height of the frames (default: 640 480)");
+  args.AddArgument("--compression-thread-count", vtksys::CommandLineArguments::MULTI_ARGUMENT, &compressionThreadCountList, "List of compression thread counts to test, 0 means one thread per processor core (default: 1 2 4 0)");
+
+  if (!args.Parse())
+  {
+    std::cerr << "Problem parsing arguments" << std::endl;
+    std::cout << "Help: " << args.GetHelp() << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  if (printHelp)
+  {
+    std::cout << args.GetHelp() << std::endl;
+    exit(EXIT_SUCCESS);
+  }
+
+  vtkPlusLogger::Instance()->SetLogLevel(verboseLevel);
+
+  unsigned int frameSize[3] = { 640, 480, 1 };
+  if (!frameSizeList.empty())
+  {
+    if (frameSizeList.size() != 2 || frameSizeList[0] < 1 || frameSizeList[1] < 1)
+    {
+      LOG_ERROR("Invalid frame size, width and height have to be specified");
+      exit(EXIT_FAILURE);
+    }
+    frameSize[0] = frameSizeList[0];
+    frameSize[1] = frameSizeList[1];
+  }
+  if (numberOfFrames < 1)
+  {
+    LOG_ERROR("Invalid number of frames: " << numberOfFrames);
+    exit(EXIT_FAILURE);
+  }
+  if (compressionThreadCountList.empty())
+  {
+    compressionThreadCountList.push_back(1);
+    compressionThreadCountList.push_back(2);
+    compressionThreadCountList.push_back(4);
+    compressionThreadCountList.push_back(0);
+  }
+
+  vtkSmartPointer<vtkPlusTrackedFrameList> sourceFrameList = vtkSmartPointer<vtkPlusTrackedFrameList>::New();
+  if (PlusSequenceIOTestUtilities::CreateTestSequence(sourceFrameList, numberOfFrames, frameSize) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Failed to create test sequence");
+    return EXIT_FAILURE;
+  }
+
+  LOG_INFO("Writing " << numberOfFrames << " frames of " << frameSize[0] << "x" << frameSize[1] << " pixels, number of processor cores: " << vtkMultiThreader::GetGlobalDefaultNumberOfThreads());
+  int numberOfErrors = 0;
+  for (std::vector<int>::iterator it = compressionThreadCountList.begin(); it != compressionThreadCountList.end(); ++it)
+  {
+    if (*it < 0 || *it > VTK_MAX_THREADS)
+    {
+      LOG_ERROR("Invalid number of compression threads: " << *it);
+      exit(EXIT_FAILURE);
+    }
+    numberOfErrors += TestParallelCompression(sourceFrameList, "SequenceIOParallelCompressionTest.mha", *it, false);
+    numberOfErrors += TestParallelCompression(sourceFrameList, "SequenceIOParallelCompressionTest.nrrd", *it, false);
+    numberOfErrors += TestParallelCompression(sourceFrameList, "SequenceIOParallelCompressionTestIndexed.mha", *it, true);
+    numberOfErrors += TestParallelCompression(sourceFrameList, "SequenceIOParallelCompressionTestIndexed.nrrd", *it, true);
+  }
+
+  if (numberOfErrors > 0)
+  {
+    LOG_ERROR("Test failed, number of errors: " << numberOfErrors);
+    return EXIT_FAILURE;
+  }
+
+  LOG_INFO("Test completed successfully");
+  return EXIT_SUCCESS;
+}
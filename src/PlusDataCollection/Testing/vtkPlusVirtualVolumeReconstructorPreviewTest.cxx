@@ -0,0 +1,257 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+// Add a synthetic freehand sweep to a volume reconstructor device with live preview (PreviewDownsamplingFactor) in batches,
+// as the live reconstruction does, while another thread keeps reading the preview volume. Verify that the preview volume
+// contains all the frames added so far and that the full-resolution volume contains every frame, including the frames
+// that had to be deferred because the full-resolution insertion queue was full.
+
+#include "PlusConfigure.h"
+#include "PlusTrackedFrame.h"
+#include "PlusVolumeReconstructionTestUtilities.h"
+#include "vtkPlusTrackedFrameList.h"
+#include "vtkPlusTransformRepository.h"
+#include "vtkPlusVirtualVolumeReconstructor.h"
+#include "vtkPlusVolumeReconstructor.h"
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkMatrix4x4.h>
+#include <vtkMultiThreader.h>
+#include <vtkObjectFactory.h>
+#include <vtkXMLDataElement.h>
+#include <vtkXMLUtilities.h>
+
+#include <algorithm>
+#include <atomic>
+
+namespace
+{
+  const char DEVICE_ID[] = "VolumeReconstructorDevice";
+  const int PREVIEW_DOWNSAMPLING_FACTOR = 2;
+  const double SWEEP_LENGTH_MM = 100.0;
+
+  const char DEVICE_SET_CONFIGURATION[] =
+    "<PlusConfiguration>"
+    "  <DataCollection>"
+    "    <Device Id=\"VolumeReconstructorDevice\" Type=\"VirtualVolumeReconstructor\" PreviewDownsamplingFactor=\"2\">"
+    "      <VolumeReconstruction ImageCoordinateFrame=\"Image\" ReferenceCoordinateFrame=\"Reference\""
+    "        OutputSpacing=\"0.5 0.5 0.5\" OutputOrigin=\"0 0 0\" OutputExtent=\"0 199 0 199 0 299\""
+    "        Interpolation=\"LINEAR\" Optimization=\"FULL\" CompoundingMode=\"MEAN\" FillHoles=\"OFF\" NumberOfThreads=\"1\" />"
+    "    </Device>"
+    "  </DataCollection>"
+    "</PlusConfiguration>";
+
+  struct PreviewReaderData
+  {
+    vtkPlusVirtualVolumeReconstructor* Device;
+    std::atomic<bool> StopRequested;
+    std::atomic<int> NumberOfPreviews;
+    std::atomic<int> NumberOfErrors;
+  };
+}
+
+//----------------------------------------------------------------------------
+// Exposes the frame adding method of the live reconstruction
+class vtkPlusVirtualVolumeReconstructorPreviewTester : public vtkPlusVirtualVolumeReconstructor
+{
+public:
+  static vtkPlusVirtualVolumeReconstructorPreviewTester* New();
+  vtkTypeMacro(vtkPlusVirtualVolumeReconstructorPreviewTester, vtkPlusVirtualVolumeReconstructor);
+
+  PlusStatus AddLiveFrames(vtkPlusTrackedFrameList* trackedFrameList) { return this->AddFrames(trackedFrameList, true); }
+};
+
+vtkStandardNewMacro(vtkPlusVirtualVolumeReconstructorPreviewTester);
+
+//----------------------------------------------------------------------------
+// Create tracked frames of a freehand sweep that moves and tilts the probe through the volume
+PlusStatus CreateSweep(int numberOfFrames, std::vector<PlusTrackedFrame>& frames)
+{
+  std::vector< vtkSmartPointer<vtkImageData> > images;
+  std::vector< vtkSmartPointer<vtkMatrix4x4> > imageToReferenceTransforms;
+  PlusVolumeReconstructionTestUtilities::CreateSweep(numberOfFrames, SWEEP_LENGTH_MM, images, imageToReferenceTransforms);
+
+  PlusTransformName imageToReferenceTransformName("Image", "Reference");
+  for (int frameIndex = 0; frameIndex < numberOfFrames; ++frameIndex)
+  {
+    PlusTrackedFrame frame;
+    if (frame.GetImageData()->DeepCopyFrom(images[frameIndex]) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to copy the image of frame " << frameIndex);
+      return PLUS_FAIL;
+    }
+    frame.SetTimestamp(frameIndex * 0.05);
+    frame.SetCustomFrameTransform(imageToReferenceTransformName, imageToReferenceTransforms[frameIndex]);
+    frame.SetCustomFrameTransformStatus(imageToReferenceTransformName, FIELD_OK);
+    frames.push_back(frame);
+  }
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+// Reconstruct the volume from the first numberOfFrames frames without pipelined insertion
+PlusStatus ReconstructReferenceVolume(vtkXMLDataElement* deviceElement, double spacing, const int extent[6], std::vector<PlusTrackedFrame>& frames,
+                                      int numberOfFrames, vtkImageData* volume)
+{
+  vtkSmartPointer<vtkPlusVolumeReconstructor> reconstructor = vtkSmartPointer<vtkPlusVolumeReconstructor>::New();
+  if (reconstructor->ReadConfiguration(deviceElement) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Failed to read reference volume reconstructor configuration");
+    return PLUS_FAIL;
+  }
+  double outputSpacing[3] = { spacing, spacing, spacing };
+  int outputExtent[6] = { extent[0], extent[1], extent[2], extent[3], extent[4], extent[5] };
+  reconstructor->SetOutputSpacing(outputSpacing);
+  reconstructor->SetOutputExtent(outputExtent);
+  reconstructor->SetPipelinedInsertion(false);
+  reconstructor->SetNumberOfThreads(1);
+
+  vtkSmartPointer<vtkPlusTransformRepository> transformRepository = vtkSmartPointer<vtkPlusTransformRepository>::New();
+  for (int frameIndex = 0; frameIndex < numberOfFrames; ++frameIndex)
+  {
+    if (transformRepository->SetTransforms(frames[frameIndex]) != PLUS_SUCCESS
+        || reconstructor->AddTrackedFrame(&frames[frameIndex], transformRepository) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to add frame " << frameIndex << " to the reference volume");
+      return PLUS_FAIL;
+    }
+  }
+  return reconstructor->ExtractGrayLevels(volume);
+}
+
+//----------------------------------------------------------------------------
+// Keep reading the preview volume while frames are added by the main thread
+void* ReadPreviewThread(vtkMultiThreader::ThreadInfo* data)
+{
+  PreviewReaderData* readerData = static_cast<PreviewReaderData*>(data->UserData);
+  vtkSmartPointer<vtkImageData> previewVolume = vtkSmartPointer<vtkImageData>::New();
+  while (!readerData->StopRequested)
+  {
+    std::string errorMessage;
+    if (readerData->Device->GetReconstructedVolumePreview(previewVolume, errorMessage) != PLUS_SUCCESS)
+    {
+      readerData->NumberOfErrors++;
+    }
+    readerData->NumberOfPreviews++;
+    vtkPlusAccurateTimer::Delay(0.01);
+  }
+  return NULL;
+}
+
+//----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  int numberOfFrames = 200;
+  int numberOfFramesPerBatch = 50;
+
+  vtksys::CommandLineArguments args;
+  args.Initialize(argc, argv);
+  args.AddArgument("--number-of-frames", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &numberOfFrames, "Number of frames in the synthetic sweep (default: 200)");
+  args.AddArgument("--frames-per-batch", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &numberOfFramesPerBatch, "Number of frames that are added at once (default: 50)");
+  PlusVolumeReconstructionTestUtilities::ParseArguments(args);
+
+  vtkSmartPointer<vtkXMLDataElement> configRootElement = vtkSmartPointer<vtkXMLDataElement>::Take(vtkXMLUtilities::ReadElementFromString(DEVICE_SET_CONFIGURATION));
+  vtkXMLDataElement* deviceElement = configRootElement->FindNestedElementWithName("DataCollection")->FindNestedElementWithName("Device");
+
+  vtkSmartPointer<vtkPlusVirtualVolumeReconstructorPreviewTester> device = vtkSmartPointer<vtkPlusVirtualVolumeReconstructorPreviewTester>::New();
+  device->SetDeviceId(DEVICE_ID);
+  if (static_cast<vtkPlusDevice*>(device)->ReadConfiguration(configRootElement) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Failed to read volume reconstructor device configuration");
+    return EXIT_FAILURE;
+  }
+
+  std::vector<PlusTrackedFrame> frames;
+  if (CreateSweep(numberOfFrames, frames) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Failed to create the sweep");
+    return EXIT_FAILURE;
+  }
+
+  const int fullResolutionExtent[6] = { 0, 199, 0, 199, 0, 299 };
+  const int previewExtent[6] = { 0, 100, 0, 100, 0, 150 };
+
+  PreviewReaderData readerData;
+  readerData.Device = device;
+  readerData.StopRequested = false;
+  readerData.NumberOfPreviews = 0;
+  readerData.NumberOfErrors = 0;
+  vtkSmartPointer<vtkMultiThreader> threader = vtkSmartPointer<vtkMultiThreader>::New();
+  int readerThreadId = threader->SpawnThread((vtkThreadFunctionType)&ReadPreviewThread, &readerData);
+
+  int numberOfErrors = 0;
+  int maxNumberOfDeferredFrames = 0;
+  for (int firstFrameIndex = 0; firstFrameIndex < numberOfFrames; firstFrameIndex += numberOfFramesPerBatch)
+  {
+    int numberOfAddedFrames = std::min(firstFrameIndex + numberOfFramesPerBatch, numberOfFrames);
+    vtkSmartPointer<vtkPlusTrackedFrameList> batch = vtkSmartPointer<vtkPlusTrackedFrameList>::New();
+    for (int frameIndex = firstFrameIndex; frameIndex < numberOfAddedFrames; ++frameIndex)
+    {
+      batch->AddTrackedFrame(&frames[frameIndex], vtkPlusTrackedFrameList::ADD_INVALID_FRAME);
+    }
+    if (device->AddLiveFrames(batch) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to add frames " << firstFrameIndex << "-" << numberOfAddedFrames - 1);
+      numberOfErrors++;
+    }
+    maxNumberOfDeferredFrames = std::max(maxNumberOfDeferredFrames, device->GetNumberOfDeferredFrames());
+
+    // The preview contains all the frames that have been added so far
+    vtkSmartPointer<vtkImageData> previewVolume = vtkSmartPointer<vtkImageData>::New();
+    std::string errorMessage;
+    vtkSmartPointer<vtkImageData> referencePreviewVolume = vtkSmartPointer<vtkImageData>::New();
+    if (device->GetReconstructedVolumePreview(previewVolume, errorMessage) != PLUS_SUCCESS
+        || ReconstructReferenceVolume(deviceElement, 0.5 * PREVIEW_DOWNSAMPLING_FACTOR, previewExtent, frames, numberOfAddedFrames, referencePreviewVolume) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to get preview volume after " << numberOfAddedFrames << " frames: " << errorMessage);
+      numberOfErrors++;
+    }
+    else if (!PlusVolumeReconstructionTestUtilities::IsImageScalarsEqual(previewVolume, referencePreviewVolume))
+    {
+      LOG_ERROR("Preview volume is different from the reference volume reconstructed from the first " << numberOfAddedFrames << " frames");
+      numberOfErrors++;
+    }
+  }
+
+  readerData.StopRequested = true;
+  threader->TerminateThread(readerThreadId);
+  LOG_INFO("Preview volume was read " << readerData.NumberOfPreviews.load() << " times while frames were added, maximum number of deferred frames: " << maxNumberOfDeferredFrames);
+  if (readerData.NumberOfErrors > 0)
+  {
+    LOG_ERROR("Failed to get the preview volume " << readerData.NumberOfErrors.load() << " times while frames were added");
+    numberOfErrors++;
+  }
+
+  // The full-resolution volume contains every frame
+  vtkSmartPointer<vtkImageData> fullResolutionVolume = vtkSmartPointer<vtkImageData>::New();
+  std::string errorMessage;
+  vtkSmartPointer<vtkImageData> referenceVolume = vtkSmartPointer<vtkImageData>::New();
+  if (device->GetReconstructedVolume(fullResolutionVolume, errorMessage) != PLUS_SUCCESS
+      || ReconstructReferenceVolume(deviceElement, 0.5, fullResolutionExtent, frames, numberOfFrames, referenceVolume) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Failed to get full-resolution volume: " << errorMessage);
+    numberOfErrors++;
+  }
+  else if (!PlusVolumeReconstructionTestUtilities::IsImageScalarsEqual(fullResolutionVolume, referenceVolume))
+  {
+    LOG_ERROR("Full-resolution volume is different from the reference volume reconstructed from all the " << numberOfFrames << " frames");
+    numberOfErrors++;
+  }
+  if (device->GetNumberOfDeferredFrames() != 0)
+  {
+    LOG_ERROR("Frames are still deferred after the full-resolution volume is retrieved: " << device->GetNumberOfDeferredFrames());
+    numberOfErrors++;
+  }
+
+  if (numberOfErrors > 0)
+  {
+    LOG_ERROR("Test failed with " << numberOfErrors << " errors");
+    return EXIT_FAILURE;
+  }
+  LOG_INFO("Test completed successfully");
+  return EXIT_SUCCESS;
+}
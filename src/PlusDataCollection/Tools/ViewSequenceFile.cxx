@@ -6,16 +6,13 @@ See License.txt for details.
 
 #include "PlusConfigure.h"
 #include "PlusTrackedFrame.h"
-#include "vtkActorCollection.h"
 #include "vtkCallbackCommand.h"
-#include "vtkCollectionIterator.h"
 #include "vtkCommand.h"
 #include "vtkImageActor.h"
 #include "vtkImageData.h"
 #include "vtkImageImport.h"
 #include "vtkImageViewer2.h"
 #include "vtkMatrix4x4.h"
-#include "vtkProp.h"
 #include "vtkRenderWindow.h"
 #include "vtkRenderWindow.h"
 #include "vtkRenderWindowInteractor.h"
@@ -26,7 +23,6 @@ See License.txt for details.
 #include "vtkTextActor.h"
 #include "vtkTextActor3D.h"
 #include "vtkTextProperty.h"
-#include "vtkPlusTrackedFrameList.h"
 #include "vtkTransform.h"
 #include "vtkPlusTransformRepository.h"
 #include "vtkXMLUtilities.h"
@@ -43,61 +39,81 @@ public:
   void Initialize(vtkRenderWindow* renderWindow,
                   vtkRenderWindowInteractor* renderWindowInteractor,
                   vtkTextActor* textActor,
-                  vtkCollection* imageActors,
-                  std::vector<vtkTransform*>* imageTransforms)
+                  vtkImageActor* imageActor,
+                  vtkPlusSequenceIOBase* reader,
+                  vtkPlusTransformRepository* transformRepository,
+                  const PlusTransformName& imageToReferenceTransformName)
   {
     this->RenderWindow = renderWindow;
     this->RenderWindowInteractor = renderWindowInteractor;
     this->TextActor = textActor;
-    this->ImageActors = imageActors;
-    this->ImageTransforms = imageTransforms;
+    this->Reader = reader;
+    this->TransformRepository = transformRepository;
+    this->ImageToReferenceTransformName = imageToReferenceTransformName;
+    imageActor->SetInputData(this->ImageData);
+    imageActor->SetUserTransform(this->ImageToReferenceTransform);
+  }
+
+  /*!
+    Read a frame from the sequence file and show it.
+    Only the displayed frame is kept in memory, so scrubbing is fast even in long recordings if the frames can be
+    read by random access (uncompressed files or compressed files with frame index).
+  */
+  PlusStatus ShowFrame(int frameNum)
+  {
+    if (this->Reader->ReadFrame(frameNum, this->TrackedFrame) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to read frame " << frameNum << " from the sequence file");
+      return PLUS_FAIL;
+    }
+    this->FrameNum = frameNum;
+
+    // Update transform repository
+    if (this->TransformRepository->SetTransforms(this->TrackedFrame) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to set repository transforms from tracked frame!");
+      return PLUS_FAIL;
+    }
+
+    this->ImageData->DeepCopy(this->TrackedFrame.GetImageData()->GetImage());
+
+    if (this->ImageToReferenceTransformName.IsValid())
+    {
+      vtkSmartPointer<vtkMatrix4x4> imageToReferenceTransformMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+      if (this->TransformRepository->GetTransform(this->ImageToReferenceTransformName, imageToReferenceTransformMatrix) != PLUS_SUCCESS)
+      {
+        std::string strTransformName;
+        this->ImageToReferenceTransformName.GetTransformName(strTransformName);
+        LOG_ERROR("Failed to get transform from repository: " << strTransformName);
+        return PLUS_FAIL;
+      }
+      this->ImageToReferenceTransform->SetMatrix(imageToReferenceTransformMatrix);
+    }
+    return PLUS_SUCCESS;
   }
 
   virtual void Execute(vtkObject* caller, unsigned long callerEvent, void*)
   {
     if (callerEvent == vtkCommand::CharEvent)
     {
+      int numberOfFrames = this->Reader->GetNumberOfFrames();
       char keycode = this->RenderWindowInteractor->GetKeyCode();
       switch (keycode)
       {
         case '+':
         {
-          if (++this->FrameNum >= this->ImageActors->GetNumberOfItems())
-          {
-            this->FrameNum = 0;
-          }
-
-          if (this->CurrentActor != NULL)
-          {
-            this->CurrentActor->VisibilityOff();
-            static_cast<vtkImageActor*>(this->ImageActors->GetItemAsObject(0))->VisibilityOn();
-          }
-
-          this->CurrentActor = static_cast<vtkImageActor*>(this->ImageActors->GetItemAsObject(this->FrameNum));
-          this->CurrentActor->VisibilityOn();
+          this->ShowFrame(this->FrameNum + 1 < numberOfFrames ? this->FrameNum + 1 : 0);
         }
         break;
         case '-':
         {
-          if (--this->FrameNum < 0)
-          {
-            this->FrameNum = this->ImageActors->GetNumberOfItems() - 1;
-          }
-
-          if (this->CurrentActor != NULL)
-          {
-            this->CurrentActor->VisibilityOff();
-            static_cast<vtkImageActor*>(this->ImageActors->GetItemAsObject(0))->VisibilityOn();
-          }
-
-          this->CurrentActor = static_cast<vtkImageActor*>(this->ImageActors->GetItemAsObject(this->FrameNum));
-          this->CurrentActor->VisibilityOn();
+          this->ShowFrame(this->FrameNum > 0 ? this->FrameNum - 1 : numberOfFrames - 1);
         }
         break;
       }
     }
 
-    double* position = (*this->ImageTransforms)[this->FrameNum]->GetPosition();
+    double* position = this->ImageToReferenceTransform->GetPosition();
     std::ostringstream ss;
     ss.precision(2);
     ss << "Frame " << this->FrameNum << "\nImage position: " << std::fixed << position[0] << "  " << position[1] << "  " << position[2] << std::ends;
@@ -112,12 +128,13 @@ protected:
   vtkMyCallback()
   {
     this->FrameNum = 0;
-    this->CurrentActor = NULL;
     this->RenderWindow = NULL;
     this->RenderWindowInteractor = NULL;
     this->TextActor = NULL;
-    this->ImageActors = NULL;
-    this->ImageTransforms = NULL;
+    this->Reader = NULL;
+    this->TransformRepository = NULL;
+    this->ImageData = vtkSmartPointer<vtkImageData>::New();
+    this->ImageToReferenceTransform = vtkSmartPointer<vtkTransform>::New();
   }
 
   virtual ~vtkMyCallback()
@@ -125,12 +142,15 @@ protected:
   }
 
   int FrameNum;
-  vtkImageActor* CurrentActor;
   vtkRenderWindow* RenderWindow;
   vtkRenderWindowInteractor* RenderWindowInteractor;
   vtkTextActor* TextActor;
-  vtkCollection* ImageActors;
-  std::vector<vtkTransform*>* ImageTransforms;
+  vtkPlusSequenceIOBase* Reader;
+  vtkPlusTransformRepository* TransformRepository;
+  PlusTransformName ImageToReferenceTransformName;
+  PlusTrackedFrame TrackedFrame;
+  vtkSmartPointer<vtkImageData> ImageData;
+  vtkSmartPointer<vtkTransform> ImageToReferenceTransform;
 };
 
 int main(int argc, char** argv)
@@ -182,24 +202,25 @@ int main(int argc, char** argv)
   vtkSmartPointer<vtkRenderer> renderer = vtkSmartPointer<vtkRenderer>::New();
   renWin->AddRenderer(renderer);
 
-  // Create image actor collection
-  vtkSmartPointer<vtkCollection> imageActors = vtkSmartPointer<vtkCollection>::New();
-
   //Create the inter actor that handles the event loop
   vtkSmartPointer<vtkRenderWindowInteractor> renderWindowInteractor = vtkSmartPointer<vtkRenderWindowInteractor>::New();
   renderWindowInteractor->SetRenderWindow(renWin);
 
-  // Read input tracked ultrasound data.
+  // Read input tracked ultrasound data header. Image data is read frame by frame, when a frame is displayed.
   LOG_DEBUG("Reading input... ");
-  vtkSmartPointer< vtkPlusTrackedFrameList > trackedFrameList = vtkSmartPointer< vtkPlusTrackedFrameList >::New();
-  // Orientation is XX so that the orientation of the trackedFrameList will match the orientation defined in the file
-  if (vtkPlusSequenceIO::Read(inputSequenceFilename, trackedFrameList) != PLUS_SUCCESS)
+  vtkSmartPointer<vtkPlusSequenceIOBase> reader = vtkSmartPointer<vtkPlusSequenceIOBase>::Take(vtkPlusSequenceIO::CreateSequenceReaderForFile(inputSequenceFilename));
+  if (reader.GetPointer() == NULL || reader->StartFrameByFrameReading() != PLUS_SUCCESS)
   {
     LOG_ERROR("Unable to load input sequences file.");
     return EXIT_FAILURE;
   }
   LOG_DEBUG("Reading input done.");
-  LOG_DEBUG("Number of frames: " << trackedFrameList->GetNumberOfTrackedFrames());
+  LOG_DEBUG("Number of frames: " << reader->GetNumberOfFrames());
+  if (reader->GetNumberOfFrames() == 0)
+  {
+    LOG_ERROR("The sequence file contains no frames: " << inputSequenceFilename);
+    return EXIT_FAILURE;
+  }
 
   // Read calibration matrices from the config file
   vtkSmartPointer<vtkPlusTransformRepository> transformRepository = vtkSmartPointer<vtkPlusTransformRepository>::New();
@@ -223,10 +244,6 @@ int main(int argc, char** argv)
     LOG_INFO("Configuration file is not specified. Only those transforms are available that are defined in the sequence metafile");
   }
 
-  LOG_INFO("Adding frames to actors...");
-
-  std::vector<vtkTransform*> imageTransforms;
-
   PlusTransformName imageToReferenceTransformName;
   if (!imageToReferenceTransformNameStr.empty())
   {
@@ -238,63 +255,32 @@ int main(int argc, char** argv)
     }
   }
 
-  int numberOfFrames = trackedFrameList->GetNumberOfTrackedFrames();
-  for (int frameIndex = 0; frameIndex < numberOfFrames; frameIndex++)
-  {
-    vtkPlusLogger::PrintProgressbar((100.0 * frameIndex) / numberOfFrames);
-    PlusTrackedFrame* frame = trackedFrameList->GetTrackedFrame(frameIndex);
-
-    // Update transform repository
-    if (transformRepository->SetTransforms(*frame) != PLUS_SUCCESS)
-    {
-      LOG_ERROR("Failed to set repository transforms from tracked frame!");
-      continue;
-    }
-
-    vtkSmartPointer<vtkImageData> frameImageData = vtkSmartPointer<vtkImageData>::New();
-    frameImageData->DeepCopy(frame->GetImageData()->GetImage());
+  vtkSmartPointer<vtkImageActor> imageActor = vtkSmartPointer<vtkImageActor>::New();
+  renderer->AddActor(imageActor);
 
-    vtkSmartPointer<vtkImageActor> imageActor = vtkSmartPointer<vtkImageActor>::New();
-    imageActor->SetInputData(frameImageData);
-
-    vtkSmartPointer< vtkTransform > imageToReferenceTransform = vtkSmartPointer< vtkTransform >::New();
-    if (imageToReferenceTransformName.IsValid())
-    {
-      vtkSmartPointer<vtkMatrix4x4> imageToReferenceTransformMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
-      if (transformRepository->GetTransform(imageToReferenceTransformName, imageToReferenceTransformMatrix) != PLUS_SUCCESS)
-      {
-        std::string strTransformName;
-        imageToReferenceTransformName.GetTransformName(strTransformName);
-        LOG_ERROR("Failed to get transform from repository: " << strTransformName);
-        continue;
-      }
-      imageToReferenceTransform->SetMatrix(imageToReferenceTransformMatrix);
-    }
-
-    imageActor->SetUserTransform(imageToReferenceTransform);
-    imageActor->VisibilityOff();
-    imageTransforms.push_back(imageToReferenceTransform);
-    imageActors->AddItem(imageActor);
-  }
-
-  vtkPlusLogger::PrintProgressbar(100);
-  std::cout << std::endl;
-
-  for (int i = 0; i < imageActors->GetNumberOfItems(); i++)
-  {
-    vtkImageActor* imgActor = static_cast<vtkImageActor*>(imageActors->GetItemAsObject(i));
-    imgActor->SetVisibility(i == 0); // hide all frames but the first one
-    renderer->AddActor(imgActor);
-  }
+  vtkSmartPointer<vtkTextActor> textActor = vtkSmartPointer<vtkTextActor>::New();
+  vtkSmartPointer<vtkMyCallback> call = vtkSmartPointer<vtkMyCallback>::New();
+  call->Initialize(renWin, renderWindowInteractor, textActor, imageActor, reader, transformRepository, imageToReferenceTransformName);
 
   if (renderingOff)
   {
+    // Read all the frames to check that they can be displayed
+    LOG_INFO("Reading all frames...");
+    int numberOfFrames = reader->GetNumberOfFrames();
+    for (int frameIndex = 0; frameIndex < numberOfFrames; frameIndex++)
+    {
+      vtkPlusLogger::PrintProgressbar((100.0 * frameIndex) / numberOfFrames);
+      call->ShowFrame(frameIndex);
+    }
+    vtkPlusLogger::PrintProgressbar(100);
+    std::cout << std::endl;
     LOG_INFO("No need for rendering...");
   }
   else
   {
+    call->ShowFrame(0);
+
     // Create a text actor for image position information
-    vtkSmartPointer<vtkTextActor> textActor = vtkSmartPointer<vtkTextActor>::New();
     vtkSmartPointer<vtkTextProperty> textprop = textActor->GetTextProperty();
     textprop->SetColor(1, 0, 0);
     textprop->SetFontFamilyToArial();
@@ -312,8 +298,6 @@ int main(int argc, char** argv)
     renWin->Render();
 
     //establish timer event and create timer
-    vtkSmartPointer<vtkMyCallback> call = vtkSmartPointer<vtkMyCallback>::New();
-    call->Initialize(renWin, renderWindowInteractor, textActor, imageActors, &imageTransforms);
     renderWindowInteractor->AddObserver(vtkCommand::TimerEvent, call);
     renderWindowInteractor->AddObserver(vtkCommand::CharEvent, call);
     renderWindowInteractor->CreateTimer(VTKI_TIMER_FIRST);    //VTKI_TIMER_FIRST = 0
@@ -323,6 +307,8 @@ int main(int argc, char** argv)
     renderWindowInteractor->Start();
   }
 
+  reader->StopFrameByFrameReading();
+
   std::cout << "MetaImageSequenceViewer completed successfully!" << std::endl;
   return EXIT_SUCCESS;
 }
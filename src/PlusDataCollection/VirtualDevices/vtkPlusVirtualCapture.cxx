@@ -5,6 +5,7 @@ See License.txt for details.
 =========================================================Plus=header=end*/
 
 #include "PlusConfigure.h"
+#include "PlusFrameCodec.h"
 #include "PlusTrackedFrame.h"
 #include "vtkPlusMetaImageSequenceIO.h"
 #include "vtkObjectFactory.h"
@@ -43,6 +44,10 @@ vtkPlusVirtualCapture::vtkPlusVirtualCapture()
   , BaseFilename("TrackedImageSequence.nrrd")
   , Writer(NULL)
   , EnableFileCompression(false)
+  , EnableFrameIndex(false)
+  , CompressionThreadCount(1)
+  , CompressionCodec("")
+  , EnableCompressionFrameDelta(false)
   , IsHeaderPrepared(false)
   , TotalFramesRecorded(0)
   , EnableCapturingOnStart(false)
@@ -58,6 +63,8 @@ vtkPlusVirtualCapture::vtkPlusVirtualCapture()
 
   // The data capture thread will be used to regularly read the frames and write to disk
   this->StartThreadForInternalUpdates = true;
+  // Read the frames as soon as they arrive instead of waiting for the next polling period
+  this->UpdateOnNewInputData = true;
 }
 
 //----------------------------------------------------------------------------
@@ -100,6 +107,15 @@ PlusStatus vtkPlusVirtualCapture::ReadConfiguration(vtkXMLDataElement* rootConfi
 
   XML_READ_CSTRING_ATTRIBUTE_OPTIONAL(BaseFilename, deviceConfig);
   XML_READ_BOOL_ATTRIBUTE_OPTIONAL(EnableFileCompression, deviceConfig);
+  XML_READ_BOOL_ATTRIBUTE_OPTIONAL(EnableFrameIndex, deviceConfig);
+  XML_READ_SCALAR_ATTRIBUTE_OPTIONAL(int, CompressionThreadCount, deviceConfig);
+  const char* compressionCodec = deviceConfig->GetAttribute("CompressionCodec");
+  if (compressionCodec != NULL && this->SetCompressionCodec(compressionCodec) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Invalid CompressionCodec attribute in device " << this->GetDeviceId());
+    return PLUS_FAIL;
+  }
+  XML_READ_BOOL_ATTRIBUTE_OPTIONAL(EnableCompressionFrameDelta, deviceConfig);
   XML_READ_BOOL_ATTRIBUTE_OPTIONAL(EnableCapturingOnStart, deviceConfig);
 
   this->SetRequestedFrameRate(15.0);   // default
@@ -116,6 +132,10 @@ PlusStatus vtkPlusVirtualCapture::WriteConfiguration(vtkXMLDataElement* rootConf
   XML_FIND_DEVICE_ELEMENT_REQUIRED_FOR_WRITING(deviceElement, rootConfig);
   deviceElement->SetAttribute("EnableCapturing", this->EnableCapturing ? "TRUE" : "FALSE");
   deviceElement->SetAttribute("EnableFileCompression", this->EnableFileCompression ? "TRUE" : "FALSE");
+  deviceElement->SetAttribute("EnableFrameIndex", this->EnableFrameIndex ? "TRUE" : "FALSE");
+  deviceElement->SetIntAttribute("CompressionThreadCount", this->CompressionThreadCount);
+  deviceElement->SetAttribute("CompressionCodec", this->CompressionCodec.c_str());
+  deviceElement->SetAttribute("EnableCompressionFrameDelta", this->EnableCompressionFrameDelta ? "TRUE" : "FALSE");
   deviceElement->SetAttribute("EnableCaptureOnStart", this->EnableCapturingOnStart ? "TRUE" : "FALSE");
   deviceElement->SetDoubleAttribute("RequestedFrameRate", this->GetRequestedFrameRate());
 
@@ -205,6 +225,10 @@ PlusStatus vtkPlusVirtualCapture::OpenFile(const char* aFilename)
 
   this->Writer = vtkPlusSequenceIO::CreateSequenceHandlerForFile(aFilename);
   this->Writer->SetUseCompression(this->EnableFileCompression);
+  this->Writer->SetWriteFrameIndex(this->EnableFrameIndex);
+  this->Writer->SetCompressionThreadCount(this->CompressionThreadCount);
+  this->Writer->SetCompressionCodec(this->CompressionCodec);
+  this->Writer->SetCompressionFrameDelta(this->EnableCompressionFrameDelta);
   this->Writer->SetTrackedFrameList(this->RecordedFrames);
   // Need to set the filename before finalizing header, because the pixel data file name depends on the file extension
   this->Writer->SetFileName(vtkPlusConfig::GetInstance()->GetOutputPath(aFilename));
@@ -297,7 +321,9 @@ PlusStatus vtkPlusVirtualCapture::InternalUpdate()
   }
   double startTimeSec = vtkPlusAccurateTimer::GetSystemTime();
 
-  this->TimeWaited += startTimeSec - LastUpdateTime;
+  // The thread may be woken up multiple times within a sampling period (UpdateOnNewInputData),
+  // therefore the waiting time is always measured from the last recording
+  this->TimeWaited = startTimeSec - this->LastUpdateTime;
 
   if (this->TimeWaited < samplingPeriodSec)
   {
@@ -471,6 +497,62 @@ void vtkPlusVirtualCapture::SetEnableFileCompression(bool aFileCompression)
   this->EnableFileCompression = aFileCompression;
 }
 
+//----------------------------------------------------------------------------
+void vtkPlusVirtualCapture::SetEnableFrameIndex(bool aFrameIndex)
+{
+  if (this->Writer != NULL)
+  {
+    this->Writer->SetWriteFrameIndex(aFrameIndex);
+  }
+
+  this->EnableFrameIndex = aFrameIndex;
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusVirtualCapture::SetCompressionThreadCount(int aThreadCount)
+{
+  if (this->Writer != NULL)
+  {
+    this->Writer->SetCompressionThreadCount(aThreadCount);
+  }
+
+  this->CompressionThreadCount = aThreadCount;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusVirtualCapture::SetCompressionCodec(const std::string& aCodecName)
+{
+  if (!aCodecName.empty())
+  {
+    PlusFrameCodec* codec = PlusFrameCodec::CreateCodec(aCodecName);
+    if (codec == NULL)
+    {
+      LOG_ERROR("Unknown compression codec: " << aCodecName);
+      return PLUS_FAIL;
+    }
+    delete codec;
+  }
+
+  if (this->Writer != NULL && this->Writer->SetCompressionCodec(aCodecName) != PLUS_SUCCESS)
+  {
+    return PLUS_FAIL;
+  }
+
+  this->CompressionCodec = aCodecName;
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusVirtualCapture::SetEnableCompressionFrameDelta(bool aFrameDelta)
+{
+  if (this->Writer != NULL)
+  {
+    this->Writer->SetCompressionFrameDelta(aFrameDelta);
+  }
+
+  this->EnableCompressionFrameDelta = aFrameDelta;
+}
+
 //-----------------------------------------------------------------------------
 void vtkPlusVirtualCapture::SetEnableCapturing(bool aValue)
 {
@@ -76,6 +76,18 @@ public:
   vtkGetMacro(EnableFileCompression, bool);
   void SetEnableFileCompression(bool aFileCompression);
 
+  vtkGetMacro(EnableFrameIndex, bool);
+  void SetEnableFrameIndex(bool aFrameIndex);
+
+  vtkGetMacro(CompressionThreadCount, int);
+  void SetCompressionThreadCount(int aThreadCount);
+
+  vtkGetMacro(CompressionCodec, std::string);
+  PlusStatus SetCompressionCodec(const std::string& aCodecName);
+
+  vtkGetMacro(EnableCompressionFrameDelta, bool);
+  void SetEnableCompressionFrameDelta(bool aFrameDelta);
+
   vtkSetMacro(EnableCapturingOnStart, bool);
   vtkGetMacro(EnableCapturingOnStart, bool);
 
@@ -152,6 +164,18 @@ protected:
   /*! When closing the file, re-read the data from file, and write it compressed */
   bool EnableFileCompression;
 
+  /*! Compress each frame independently and write a frame index file to allow fast seeking in the recorded file */
+  bool EnableFrameIndex;
+
+  /*! Number of threads used for compressing the recorded frames, 0 means one thread per processor core */
+  int CompressionThreadCount;
+
+  /*! Codec used for compressing the recorded frames (see PlusFrameCodec), empty for standard zlib/gzip compression */
+  std::string CompressionCodec;
+
+  /*! Compress the difference to the previous frame, used only if a compression codec is set */
+  bool EnableCompressionFrameDelta;
+
   /*! Preparing the header requires image data already collected, this flag makes the header preparation wait until valid data is collected */
   bool IsHeaderPrepared;
 
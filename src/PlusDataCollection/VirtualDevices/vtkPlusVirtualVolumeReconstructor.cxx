@@ -16,6 +16,8 @@ See License.txt for details.
 #include "vtkPlusVolumeReconstructor.h"
 #include "vtksys/SystemTools.hxx"
 
+#include <math.h>
+
 //----------------------------------------------------------------------------
 
 vtkStandardNewMacro(vtkPlusVirtualVolumeReconstructor);
@@ -32,13 +34,18 @@ vtkPlusVirtualVolumeReconstructor::vtkPlusVirtualVolumeReconstructor()
   , m_TimeWaited(0.0)
   , m_LastUpdateTime(0.0)
   , TotalFramesRecorded(0)
+  , PreviewDownsamplingFactor(1)
   , EnableReconstruction(false)
   , VolumeReconstructorAccessMutex(vtkSmartPointer<vtkPlusRecursiveCriticalSection>::New())
+  , PreviewVolumeReconstructorAccessMutex(vtkSmartPointer<vtkPlusRecursiveCriticalSection>::New())
 {
   // The data capture thread will be used to regularly read the frames and write to disk
   this->StartThreadForInternalUpdates = true;
+  // Read the frames as soon as they arrive instead of waiting for the next polling period
+  this->UpdateOnNewInputData = true;
 
   this->VolumeReconstructor = vtkSmartPointer<vtkPlusVolumeReconstructor>::New();
+  this->PreviewVolumeReconstructor = vtkSmartPointer<vtkPlusVolumeReconstructor>::New();
   this->TransformRepository = vtkSmartPointer<vtkPlusTransformRepository>::New();
 }
 
@@ -51,6 +58,8 @@ vtkPlusVirtualVolumeReconstructor::~vtkPlusVirtualVolumeReconstructor()
 void vtkPlusVirtualVolumeReconstructor::PrintSelf(ostream& os, vtkIndent indent)
 {
   this->Superclass::PrintSelf(os, indent);
+  os << indent << "PreviewDownsamplingFactor: " << this->PreviewDownsamplingFactor << std::endl;
+  os << indent << "NumberOfDeferredFrames: " << this->DeferredFrames.size() << std::endl;
 }
 
 //----------------------------------------------------------------------------
@@ -61,10 +70,22 @@ PlusStatus vtkPlusVirtualVolumeReconstructor::ReadConfiguration(vtkXMLDataElemen
   XML_READ_BOOL_ATTRIBUTE_OPTIONAL(EnableReconstruction, deviceConfig);
   XML_READ_CSTRING_ATTRIBUTE_OPTIONAL(OutputVolFilename, deviceConfig);
   XML_READ_CSTRING_ATTRIBUTE_OPTIONAL(OutputVolDeviceName, deviceConfig);
+  XML_READ_SCALAR_ATTRIBUTE_OPTIONAL(int, PreviewDownsamplingFactor, deviceConfig);
 
   PlusLockGuard<vtkPlusRecursiveCriticalSection> writerLock(this->VolumeReconstructorAccessMutex);
   this->VolumeReconstructor->ReadConfiguration(deviceConfig);
 
+  if (this->PreviewDownsamplingFactor > 1)
+  {
+    // The preview volume is reconstructed with the same parameters, only the output volume geometry is different.
+    // Preview frames are pasted immediately, while the full-resolution volume is updated by the insertion worker threads.
+    PlusLockGuard<vtkPlusRecursiveCriticalSection> previewLock(this->PreviewVolumeReconstructorAccessMutex);
+    this->PreviewVolumeReconstructor->ReadConfiguration(deviceConfig);
+    this->PreviewVolumeReconstructor->SetPipelinedInsertion(false);
+    this->VolumeReconstructor->SetPipelinedInsertion(true);
+    this->UpdatePreviewVolumeGeometry();
+  }
+
   return PLUS_SUCCESS;
 }
 
@@ -77,6 +98,14 @@ PlusStatus vtkPlusVirtualVolumeReconstructor::WriteConfiguration(vtkXMLDataEleme
 
   deviceElement->SetAttribute("OutputVolFilename", this->OutputVolFilename.c_str());
   deviceElement->SetAttribute("OutputVolDeviceName", this->OutputVolDeviceName.c_str());
+  if (this->PreviewDownsamplingFactor > 1)
+  {
+    deviceElement->SetIntAttribute("PreviewDownsamplingFactor", this->PreviewDownsamplingFactor);
+  }
+  else
+  {
+    XML_REMOVE_ATTRIBUTE(deviceElement, "PreviewDownsamplingFactor");
+  }
 
   PlusLockGuard<vtkPlusRecursiveCriticalSection> writerLock(this->VolumeReconstructorAccessMutex);
   this->VolumeReconstructor->WriteConfiguration(deviceElement);
@@ -138,7 +167,9 @@ PlusStatus vtkPlusVirtualVolumeReconstructor::InternalUpdate()
   }
   double startTimeSec = vtkPlusAccurateTimer::GetSystemTime();
 
-  m_TimeWaited += startTimeSec - m_LastUpdateTime;
+  // The thread may be woken up multiple times within a sampling period (UpdateOnNewInputData),
+  // therefore the waiting time is always measured from the last reconstruction
+  m_TimeWaited = startTimeSec - m_LastUpdateTime;
 
   if (m_TimeWaited < GetSamplingPeriodSec())
   {
@@ -186,7 +217,7 @@ PlusStatus vtkPlusVirtualVolumeReconstructor::InternalUpdate()
   }
   int nbFramesRecorded = recordedFrames->GetNumberOfTrackedFrames();
 
-  if (this->AddFrames(recordedFrames) != PLUS_SUCCESS)
+  if (this->AddFrames(recordedFrames, true) != PLUS_SUCCESS)
   {
     LOG_ERROR(this->GetDeviceId() << ": Unable to add " << nbFramesRecorded << " frames for volume reconstruction");
     return PLUS_FAIL;
@@ -269,6 +300,12 @@ PlusStatus vtkPlusVirtualVolumeReconstructor::Reset()
 {
   PlusLockGuard<vtkPlusRecursiveCriticalSection> writerLock(this->VolumeReconstructorAccessMutex);
   this->VolumeReconstructor->Reset();
+  this->DeferredFrames.clear();
+  if (this->PreviewDownsamplingFactor > 1)
+  {
+    PlusLockGuard<vtkPlusRecursiveCriticalSection> previewLock(this->PreviewVolumeReconstructorAccessMutex);
+    this->PreviewVolumeReconstructor->Reset();
+  }
   return PLUS_SUCCESS;
 }
 
@@ -327,6 +364,7 @@ PlusStatus vtkPlusVirtualVolumeReconstructor::GetReconstructedVolumeFromFile(con
     LOG_INFO(errorMessage);
     return PLUS_FAIL;
   }
+  this->UpdatePreviewVolumeGeometry();
   // Paste slices
   if (AddFrames(trackedFrameList) != PLUS_SUCCESS)
   {
@@ -346,17 +384,41 @@ PlusStatus vtkPlusVirtualVolumeReconstructor::GetReconstructedVolumeFromFile(con
 //-----------------------------------------------------------------------------
 PlusStatus vtkPlusVirtualVolumeReconstructor::GetReconstructedVolume(vtkImageData* reconstructedVolume, std::string& outErrorMessage, bool applyHoleFilling/*=true*/)
 {
-  outErrorMessage.clear();
   PlusLockGuard<vtkPlusRecursiveCriticalSection> writerLock(this->VolumeReconstructorAccessMutex);
-  bool oldFillHoles = this->VolumeReconstructor->GetFillHoles();
+  // The full-resolution volume must contain all the frames that have been added so far
+  if (this->AddDeferredFrames(true) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Failed to add deferred frames to the full-resolution volume");
+  }
+  return this->ExtractReconstructedVolume(this->VolumeReconstructor, reconstructedVolume, outErrorMessage, applyHoleFilling);
+}
+
+//-----------------------------------------------------------------------------
+PlusStatus vtkPlusVirtualVolumeReconstructor::GetReconstructedVolumePreview(vtkImageData* reconstructedVolume, std::string& outErrorMessage, bool applyHoleFilling/*=true*/)
+{
+  if (this->PreviewDownsamplingFactor <= 1)
+  {
+    // no preview volume, use the full-resolution volume
+    return this->GetReconstructedVolume(reconstructedVolume, outErrorMessage, applyHoleFilling);
+  }
+  // Only the preview volume is locked, so the preview is available while frames are added to the full-resolution volume
+  PlusLockGuard<vtkPlusRecursiveCriticalSection> previewLock(this->PreviewVolumeReconstructorAccessMutex);
+  return this->ExtractReconstructedVolume(this->PreviewVolumeReconstructor, reconstructedVolume, outErrorMessage, applyHoleFilling);
+}
+
+//-----------------------------------------------------------------------------
+PlusStatus vtkPlusVirtualVolumeReconstructor::ExtractReconstructedVolume(vtkPlusVolumeReconstructor* reconstructor, vtkImageData* reconstructedVolume, std::string& outErrorMessage, bool applyHoleFilling)
+{
+  outErrorMessage.clear();
+  bool oldFillHoles = reconstructor->GetFillHoles();
   if (!applyHoleFilling)
   {
-    this->VolumeReconstructor->SetFillHoles(false);
+    reconstructor->SetFillHoles(false);
   }
-  PlusStatus status = this->VolumeReconstructor->ExtractGrayLevels(reconstructedVolume);
+  PlusStatus status = reconstructor->ExtractGrayLevels(reconstructedVolume);
   if (!applyHoleFilling)
   {
-    this->VolumeReconstructor->SetFillHoles(oldFillHoles);
+    reconstructor->SetFillHoles(oldFillHoles);
   }
 
   if (status != PLUS_SUCCESS)
@@ -369,26 +431,43 @@ PlusStatus vtkPlusVirtualVolumeReconstructor::GetReconstructedVolume(vtkImageDat
 }
 
 //----------------------------------------------------------------------------
-PlusStatus vtkPlusVirtualVolumeReconstructor::AddFrames(vtkPlusTrackedFrameList* trackedFrameList)
+PlusStatus vtkPlusVirtualVolumeReconstructor::AddFrames(vtkPlusTrackedFrameList* trackedFrameList, bool updatePreview/*=false*/)
 {
   PlusLockGuard<vtkPlusRecursiveCriticalSection> writerLock(this->VolumeReconstructorAccessMutex);
 
-  PlusStatus status = PLUS_SUCCESS;
+  updatePreview = updatePreview && this->PreviewDownsamplingFactor > 1;
+
+  // Frames that were deferred earlier are inserted first to keep the order of insertion.
+  // If the preview is not updated then the caller expects all the frames in the full-resolution volume, so wait for the queue.
+  PlusStatus status = this->AddDeferredFrames(!updatePreview);
+
   const int numberOfFrames = trackedFrameList->GetNumberOfTrackedFrames();
   int numberOfFramesAddedToVolume = 0;
+  int numberOfDeferredFrames = 0;
   for (int frameIndex = 0; frameIndex < numberOfFrames; frameIndex += this->VolumeReconstructor->GetSkipInterval())
   {
     LOG_TRACE("Adding frame to volume reconstructor: " << frameIndex);
     PlusTrackedFrame* frame = trackedFrameList->GetTrackedFrame(frameIndex);
-    if (this->TransformRepository->SetTransforms(*frame) != PLUS_SUCCESS)
+    if (updatePreview)
     {
-      LOG_ERROR("Failed to update transform repository with frame #" << frameIndex);
-      status = PLUS_FAIL;
+      PlusLockGuard<vtkPlusRecursiveCriticalSection> previewLock(this->PreviewVolumeReconstructorAccessMutex);
+      if (this->AddFrameToVolume(this->PreviewVolumeReconstructor, frame) != PLUS_SUCCESS)
+      {
+        LOG_ERROR("Failed to add tracked frame to preview volume with frame #" << frameIndex);
+        status = PLUS_FAIL;
+        continue;
+      }
+    }
+    if (updatePreview && (!this->DeferredFrames.empty() || this->VolumeReconstructor->IsFrameInsertionQueueFull()))
+    {
+      // Full-resolution reconstruction cannot keep up with the acquisition, do not wait for it to keep the preview live
+      this->DeferredFrames.push_back(*frame);
+      numberOfDeferredFrames++;
       continue;
     }
     // Insert slice for reconstruction
     bool insertedIntoVolume = false;
-    if (this->VolumeReconstructor->AddTrackedFrame(frame, this->TransformRepository, &insertedIntoVolume) != PLUS_SUCCESS)
+    if (this->AddFrameToVolume(this->VolumeReconstructor, frame, &insertedIntoVolume) != PLUS_SUCCESS)
     {
       LOG_ERROR("Failed to add tracked frame to volume with frame #" << frameIndex);
       status = PLUS_FAIL;
@@ -402,10 +481,54 @@ PlusStatus vtkPlusVirtualVolumeReconstructor::AddFrames(vtkPlusTrackedFrameList*
   trackedFrameList->Clear();
 
   LOG_DEBUG("Number of frames added to the volume: " << numberOfFramesAddedToVolume << " out of " << numberOfFrames);
+  if (numberOfDeferredFrames > 0)
+  {
+    LOG_DEBUG("Full-resolution volume reconstruction cannot keep up with the acquisition. " << numberOfDeferredFrames << " frames were deferred, "
+              << this->DeferredFrames.size() << " frames wait for insertion into the full-resolution volume.");
+  }
 
   return status;
 }
 
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusVirtualVolumeReconstructor::AddFrameToVolume(vtkPlusVolumeReconstructor* reconstructor, PlusTrackedFrame* frame, bool* insertedIntoVolume/*=NULL*/)
+{
+  if (this->TransformRepository->SetTransforms(*frame) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Failed to update transform repository with tracked frame");
+    return PLUS_FAIL;
+  }
+  return reconstructor->AddTrackedFrame(frame, this->TransformRepository, insertedIntoVolume);
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusVirtualVolumeReconstructor::AddDeferredFrames(bool waitForInsertionQueue)
+{
+  PlusLockGuard<vtkPlusRecursiveCriticalSection> writerLock(this->VolumeReconstructorAccessMutex);
+  PlusStatus status = PLUS_SUCCESS;
+  while (!this->DeferredFrames.empty())
+  {
+    if (!waitForInsertionQueue && this->VolumeReconstructor->IsFrameInsertionQueueFull())
+    {
+      break;
+    }
+    if (this->AddFrameToVolume(this->VolumeReconstructor, &this->DeferredFrames.front()) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to add deferred tracked frame to volume");
+      status = PLUS_FAIL;
+    }
+    this->DeferredFrames.pop_front();
+  }
+  return status;
+}
+
+//----------------------------------------------------------------------------
+int vtkPlusVirtualVolumeReconstructor::GetNumberOfDeferredFrames()
+{
+  PlusLockGuard<vtkPlusRecursiveCriticalSection> writerLock(this->VolumeReconstructorAccessMutex);
+  return static_cast<int>(this->DeferredFrames.size());
+}
+
 //-----------------------------------------------------------------------------
 double vtkPlusVirtualVolumeReconstructor::GetSamplingPeriodSec()
 {
@@ -439,16 +562,43 @@ PlusStatus vtkPlusVirtualVolumeReconstructor::UpdateTransformRepository(vtkPlusT
 void vtkPlusVirtualVolumeReconstructor::SetOutputOrigin(double* origin)
 {
   this->VolumeReconstructor->SetOutputOrigin(origin);
+  this->UpdatePreviewVolumeGeometry();
 }
 
 //----------------------------------------------------------------------------
 void vtkPlusVirtualVolumeReconstructor::SetOutputSpacing(double* spacing)
 {
   this->VolumeReconstructor->SetOutputSpacing(spacing);
+  this->UpdatePreviewVolumeGeometry();
 }
 
 //----------------------------------------------------------------------------
 void vtkPlusVirtualVolumeReconstructor::SetOutputExtent(int* extent)
 {
   this->VolumeReconstructor->SetOutputExtent(extent);
+  this->UpdatePreviewVolumeGeometry();
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusVirtualVolumeReconstructor::UpdatePreviewVolumeGeometry()
+{
+  if (this->PreviewDownsamplingFactor <= 1)
+  {
+    return;
+  }
+  // The preview volume has the same origin and covers the same region as the full-resolution volume
+  PlusLockGuard<vtkPlusRecursiveCriticalSection> previewLock(this->PreviewVolumeReconstructorAccessMutex);
+  double* spacing = this->VolumeReconstructor->GetOutputSpacing();
+  int* extent = this->VolumeReconstructor->GetOutputExtent();
+  double previewSpacing[3] = { 0, 0, 0 };
+  int previewExtent[6] = { 0, 0, 0, 0, 0, 0 };
+  for (int axis = 0; axis < 3; axis++)
+  {
+    previewSpacing[axis] = spacing[axis] * this->PreviewDownsamplingFactor;
+    previewExtent[2 * axis] = static_cast<int>(floor(double(extent[2 * axis]) / this->PreviewDownsamplingFactor));
+    previewExtent[2 * axis + 1] = static_cast<int>(ceil(double(extent[2 * axis + 1]) / this->PreviewDownsamplingFactor));
+  }
+  this->PreviewVolumeReconstructor->SetOutputOrigin(this->VolumeReconstructor->GetOutputOrigin());
+  this->PreviewVolumeReconstructor->SetOutputSpacing(previewSpacing);
+  this->PreviewVolumeReconstructor->SetOutputExtent(previewExtent);
 }
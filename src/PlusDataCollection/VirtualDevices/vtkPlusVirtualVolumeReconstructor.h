@@ -10,6 +10,7 @@ See License.txt for details.
 #include "vtkPlusDataCollectionExport.h"
 
 #include "vtkPlusDevice.h"
+#include <deque>
 #include <string>
 
 class vtkPlusTrackedFrameList;
@@ -40,6 +41,17 @@ public:
   */
   PlusStatus GetReconstructedVolume(vtkImageData* reconstructedVolume, std::string& outErrorMessage, bool applyHoleFilling = true);
 
+  /*!
+    Get the live preview of the reconstructed volume.
+    If PreviewDownsamplingFactor is larger than 1 then the downsampled preview volume is returned, which already contains
+    all the added frames, without waiting for the insertion of queued frames into the full-resolution volume.
+    The preview volume has its own mutex, therefore the preview is available while frames are added to the full-resolution volume.
+    Otherwise the full-resolution volume is returned.
+    This method is safe to be called from any thread.
+    \param applyHoleFilling If true (default) then hole filling will be applied (if enabled and fully specified), otherwise hole filling will be skipped
+  */
+  PlusStatus GetReconstructedVolumePreview(vtkImageData* reconstructedVolume, std::string& outErrorMessage, bool applyHoleFilling = true);
+
   /*!
     Updated the transform repository contents within the volume reconstructor.
     It is advisable to call this before each volume reconstruction starting.
@@ -83,6 +95,21 @@ public:
 
   vtkGetMacro(TotalFramesRecorded, long int);
 
+  /*!
+    Enable multi-resolution live reconstruction by setting a value larger than 1 (e.g., 4).
+    Live frames are then pasted into a preview volume immediately, which has PreviewDownsamplingFactor times
+    larger spacing than the output volume, and queued for pipelined insertion into the full-resolution volume.
+    If the full-resolution insertion queue is full then the frame is deferred: it is inserted into the full-resolution
+    volume when there is room in the queue again (at the latest when the full-resolution volume is requested),
+    so that the frame insertion time remains bounded and no frames are lost.
+    The preview volume is configured when the configuration is read.
+  */
+  vtkSetMacro(PreviewDownsamplingFactor, int);
+  vtkGetMacro(PreviewDownsamplingFactor, int);
+
+  /*! Number of live frames that are added to the preview volume but not yet queued for insertion into the full-resolution volume */
+  int GetNumberOfDeferredFrames();
+
 protected:
 
   /*! Read main configuration from xml data */
@@ -115,7 +142,26 @@ protected:
   virtual PlusStatus InternalConnect();
   virtual PlusStatus InternalDisconnect();
 
-  PlusStatus AddFrames(vtkPlusTrackedFrameList* trackedFrameList);
+  /*!
+    Add frames to the volume.
+    \param updatePreview If true then the frames are also added to the preview volume (if PreviewDownsamplingFactor is larger than 1)
+  */
+  PlusStatus AddFrames(vtkPlusTrackedFrameList* trackedFrameList, bool updatePreview = false);
+
+  /*! Update the transform repository from the frame and add the frame to the volume of the specified reconstructor */
+  PlusStatus AddFrameToVolume(vtkPlusVolumeReconstructor* reconstructor, PlusTrackedFrame* frame, bool* insertedIntoVolume = NULL);
+
+  /*!
+    Add the deferred frames to the full-resolution volume, in the order of acquisition.
+    \param waitForInsertionQueue If false then only as many frames are added as the insertion queue can accept without waiting
+  */
+  PlusStatus AddDeferredFrames(bool waitForInsertionQueue);
+
+  /*! Get the gray levels of the volume of the specified reconstructor */
+  PlusStatus ExtractReconstructedVolume(vtkPlusVolumeReconstructor* reconstructor, vtkImageData* reconstructedVolume, std::string& outErrorMessage, bool applyHoleFilling);
+
+  /*! Set the preview volume origin, spacing, and extent from the full-resolution output volume geometry and PreviewDownsamplingFactor */
+  void UpdatePreviewVolumeGeometry();
 
   /*! Get the sampling period length (in seconds). Frames are copied from the devices to the data collection buffer once in every sampling period. */
   double GetSamplingPeriodSec();
@@ -146,7 +192,15 @@ protected:
   /*! Record the number of frames captured */
   long int TotalFramesRecorded;  // hard drive will probably fill up before a regular int is hit, but still...
 
+  /*! Live frames that are already in the preview volume and wait for insertion into the full-resolution volume */
+  std::deque<PlusTrackedFrame> DeferredFrames;
+
+  /*! Spacing of the preview volume relative to the output volume. Preview volume is not used if the value is not larger than 1. */
+  int PreviewDownsamplingFactor;
+
   vtkSmartPointer<vtkPlusVolumeReconstructor> VolumeReconstructor;
+  /*! Reconstructs the downsampled volume that is used for live preview */
+  vtkSmartPointer<vtkPlusVolumeReconstructor> PreviewVolumeReconstructor;
   vtkSmartPointer<vtkPlusTransformRepository> TransformRepository;
 
   bool EnableReconstruction;
@@ -157,6 +211,12 @@ protected:
   /*! Mutex instance simultaneous access of writer (writer may be accessed from command processing thread and also the internal update thread) */
   vtkSmartPointer<vtkPlusRecursiveCriticalSection> VolumeReconstructorAccessMutex;
 
+  /*!
+    Mutex for accessing the preview volume reconstructor. If both mutexes are needed then VolumeReconstructorAccessMutex
+    must be locked first.
+  */
+  vtkSmartPointer<vtkPlusRecursiveCriticalSection> PreviewVolumeReconstructorAccessMutex;
+
 private:
   vtkPlusVirtualVolumeReconstructor(const vtkPlusVirtualVolumeReconstructor&);   // Not implemented.
   void operator=(const vtkPlusVirtualVolumeReconstructor&);   // Not implemented.
@@ -15,6 +15,7 @@ See License.txt for details.
 #include "vtkObjectFactory.h"
 #include "vtkPlusBuffer.h"
 #include "vtkPlusDevice.h"
+#include "vtkPlusNewItemSignal.h"
 #include "vtkPlusSequenceIO.h"
 #include "vtkPlusTrackedFrameList.h"
 #include "vtkUnsignedLongLongArray.h"
@@ -315,33 +316,40 @@ PlusStatus vtkPlusBuffer::AddItem(const PlusTrackedFrame::FieldMapType& fields,
   int bufferIndex(0);
   BufferItemUidType itemUid;
 
-  PlusLockGuard<StreamItemCircularBuffer> dataBufferGuardedLock(this->StreamBuffer);
-  if (this->StreamBuffer->PrepareForNewItem(filteredTimestamp, itemUid, bufferIndex) != PLUS_SUCCESS)
+  NewItemSignalListType signalsToNotify;
   {
-    // Just a debug message, because we want to avoid unnecessary warning messages if the timestamp is the same as last one
-    LOCAL_LOG_DEBUG("vtkPlusBuffer: Failed to prepare for adding new frame to tracker buffer!");
-    return PLUS_FAIL;
-  }
+    PlusLockGuard<StreamItemCircularBuffer> dataBufferGuardedLock(this->StreamBuffer);
+    if (this->StreamBuffer->PrepareForNewItem(filteredTimestamp, itemUid, bufferIndex) != PLUS_SUCCESS)
+    {
+      // Just a debug message, because we want to avoid unnecessary warning messages if the timestamp is the same as last one
+      LOCAL_LOG_DEBUG("vtkPlusBuffer: Failed to prepare for adding new frame to tracker buffer!");
+      return PLUS_FAIL;
+    }
 
-  // get the pointer to the correct location in the tracker buffer, where this data needs to be copied
-  StreamBufferItem* newObjectInBuffer = this->StreamBuffer->GetBufferItemPointerFromBufferIndex(bufferIndex);
-  if (newObjectInBuffer == NULL)
-  {
-    LOCAL_LOG_ERROR("vtkPlusBuffer: Failed to get pointer to data buffer object from the tracker buffer for the new frame!");
-    return PLUS_FAIL;
-  }
+    // get the pointer to the correct location in the tracker buffer, where this data needs to be copied
+    StreamBufferItem* newObjectInBuffer = this->StreamBuffer->GetBufferItemPointerFromBufferIndex(bufferIndex);
+    if (newObjectInBuffer == NULL)
+    {
+      LOCAL_LOG_ERROR("vtkPlusBuffer: Failed to get pointer to data buffer object from the tracker buffer for the new frame!");
+      return PLUS_FAIL;
+    }
 
-  newObjectInBuffer->SetFilteredTimestamp(filteredTimestamp);
-  newObjectInBuffer->SetUnfilteredTimestamp(unfilteredTimestamp);
-  newObjectInBuffer->SetIndex(frameNumber);
-  newObjectInBuffer->SetUid(itemUid);
+    newObjectInBuffer->SetFilteredTimestamp(filteredTimestamp);
+    newObjectInBuffer->SetUnfilteredTimestamp(unfilteredTimestamp);
+    newObjectInBuffer->SetIndex(frameNumber);
+    newObjectInBuffer->SetUid(itemUid);
 
-  // Add custom fields
-  for (PlusTrackedFrame::FieldMapType::const_iterator it = fields.begin(); it != fields.end(); ++it)
-  {
-    newObjectInBuffer->SetCustomFrameField(it->first, it->second);
-    std::string name(it->first);
+    // Add custom fields
+    for (PlusTrackedFrame::FieldMapType::const_iterator it = fields.begin(); it != fields.end(); ++it)
+    {
+      newObjectInBuffer->SetCustomFrameField(it->first, it->second);
+      std::string name(it->first);
+    }
+
+    this->StreamBuffer->PublishNewItems();
+    signalsToNotify = this->NewItemSignals;
   }
+  NotifyNewItemSignals(signalsToNotify);
 
   return PLUS_SUCCESS;
 }
@@ -426,65 +434,72 @@ PlusStatus vtkPlusBuffer::AddItem(void* imageDataPtr,
 
   int bufferIndex(0);
   BufferItemUidType itemUid;
-  PlusLockGuard<StreamItemCircularBuffer> dataBufferGuardedLock(this->StreamBuffer);
-  if (this->StreamBuffer->PrepareForNewItem(filteredTimestamp, itemUid, bufferIndex) != PLUS_SUCCESS)
+  NewItemSignalListType signalsToNotify;
   {
-    // Just a debug message, because we want to avoid unnecessary warning messages if the timestamp is the same as last one
-    LOCAL_LOG_DEBUG("vtkPlusBuffer: Failed to prepare for adding new frame to video buffer!");
-    return PLUS_FAIL;
-  }
+    PlusLockGuard<StreamItemCircularBuffer> dataBufferGuardedLock(this->StreamBuffer);
+    if (this->StreamBuffer->PrepareForNewItem(filteredTimestamp, itemUid, bufferIndex) != PLUS_SUCCESS)
+    {
+      // Just a debug message, because we want to avoid unnecessary warning messages if the timestamp is the same as last one
+      LOCAL_LOG_DEBUG("vtkPlusBuffer: Failed to prepare for adding new frame to video buffer!");
+      return PLUS_FAIL;
+    }
 
-  // get the pointer to the correct location in the frame buffer, where this data needs to be copied
-  StreamBufferItem* newObjectInBuffer = this->StreamBuffer->GetBufferItemPointerFromBufferIndex(bufferIndex);
-  if (newObjectInBuffer == NULL)
-  {
-    LOCAL_LOG_ERROR("vtkPlusBuffer: Failed to get pointer to video buffer object from the video buffer for the new frame!");
-    return PLUS_FAIL;
-  }
+    // get the pointer to the correct location in the frame buffer, where this data needs to be copied
+    StreamBufferItem* newObjectInBuffer = this->StreamBuffer->GetBufferItemPointerFromBufferIndex(bufferIndex);
+    if (newObjectInBuffer == NULL)
+    {
+      LOCAL_LOG_ERROR("vtkPlusBuffer: Failed to get pointer to video buffer object from the video buffer for the new frame!");
+      return PLUS_FAIL;
+    }
 
-  unsigned int receivedFrameSize[3] = { 0, 0, 0 };
-  newObjectInBuffer->GetFrame().GetFrameSize(receivedFrameSize);
+    unsigned int receivedFrameSize[3] = { 0, 0, 0 };
+    newObjectInBuffer->GetFrame().GetFrameSize(receivedFrameSize);
 
-  if (outputFrameSizeInPx[0] != receivedFrameSize[0]
-      || outputFrameSizeInPx[1] != receivedFrameSize[1]
-      || outputFrameSizeInPx[2] != receivedFrameSize[2])
-  {
-    LOCAL_LOG_ERROR("Input frame size is different from buffer frame size (input: " <<
-                    outputFrameSizeInPx[0] << "x" << outputFrameSizeInPx[1] << "x" << outputFrameSizeInPx[2] <<
-                    ",   buffer: " <<
-                    receivedFrameSize[0] << "x" << receivedFrameSize[1] << "x" << receivedFrameSize[2] << ")!");
-    return PLUS_FAIL;
-  }
+    if (outputFrameSizeInPx[0] != receivedFrameSize[0]
+        || outputFrameSizeInPx[1] != receivedFrameSize[1]
+        || outputFrameSizeInPx[2] != receivedFrameSize[2])
+    {
+      LOCAL_LOG_ERROR("Input frame size is different from buffer frame size (input: " <<
+                      outputFrameSizeInPx[0] << "x" << outputFrameSizeInPx[1] << "x" << outputFrameSizeInPx[2] <<
+                      ",   buffer: " <<
+                      receivedFrameSize[0] << "x" << receivedFrameSize[1] << "x" << receivedFrameSize[2] << ")!");
+      return PLUS_FAIL;
+    }
 
-  // Skip the numberOfBytesToSkip bytes, e.g. header size
-  unsigned char* byteImageDataPtr = reinterpret_cast<unsigned char*>(imageDataPtr);
-  byteImageDataPtr += numberOfBytesToSkip;
+    // Skip the numberOfBytesToSkip bytes, e.g. header size
+    unsigned char* byteImageDataPtr = reinterpret_cast<unsigned char*>(imageDataPtr);
+    byteImageDataPtr += numberOfBytesToSkip;
 
-  if (PlusVideoFrame::GetOrientedClippedImage(byteImageDataPtr, flipInfo, imageType, pixelType, numberOfScalarComponents, inputFrameSizeInPx, newObjectInBuffer->GetFrame(), clipRectangleOrigin, clipRectangleSize) != PLUS_SUCCESS)
-  {
-    LOCAL_LOG_ERROR("Failed to convert input US image to the requested orientation!");
-    return PLUS_FAIL;
-  }
+    if (PlusVideoFrame::GetOrientedClippedImage(byteImageDataPtr, flipInfo, imageType, pixelType, numberOfScalarComponents, inputFrameSizeInPx, newObjectInBuffer->GetFrame(), clipRectangleOrigin, clipRectangleSize) != PLUS_SUCCESS)
+    {
+      LOCAL_LOG_ERROR("Failed to convert input US image to the requested orientation!");
+      return PLUS_FAIL;
+    }
 
-  newObjectInBuffer->SetFilteredTimestamp(filteredTimestamp);
-  newObjectInBuffer->SetUnfilteredTimestamp(unfilteredTimestamp);
-  newObjectInBuffer->SetIndex(frameNumber);
-  newObjectInBuffer->SetUid(itemUid);
-  newObjectInBuffer->GetFrame().SetImageType(imageType);
+    newObjectInBuffer->SetFilteredTimestamp(filteredTimestamp);
+    newObjectInBuffer->SetUnfilteredTimestamp(unfilteredTimestamp);
+    newObjectInBuffer->SetIndex(frameNumber);
+    newObjectInBuffer->SetUid(itemUid);
+    newObjectInBuffer->GetFrame().SetImageType(imageType);
 
-  // Add custom fields
-  if (customFields != NULL)
-  {
-    for (PlusTrackedFrame::FieldMapType::const_iterator it = customFields->begin(); it != customFields->end(); ++it)
+    // Add custom fields
+    if (customFields != NULL)
     {
-      newObjectInBuffer->SetCustomFrameField(it->first, it->second);
-      std::string name(it->first);
-      if (name.find("Transform") != std::string::npos)
+      for (PlusTrackedFrame::FieldMapType::const_iterator it = customFields->begin(); it != customFields->end(); ++it)
       {
-        newObjectInBuffer->SetValidTransformData(true);
+        newObjectInBuffer->SetCustomFrameField(it->first, it->second);
+        std::string name(it->first);
+        if (name.find("Transform") != std::string::npos)
+        {
+          newObjectInBuffer->SetValidTransformData(true);
+        }
       }
     }
+
+    this->StreamBuffer->PublishNewItems();
+    signalsToNotify = this->NewItemSignals;
   }
+  NotifyNewItemSignals(signalsToNotify);
 
   return PLUS_SUCCESS;
 }
@@ -523,42 +538,50 @@ PlusStatus vtkPlusBuffer::AddTimeStampedItem(vtkMatrix4x4* matrix, ToolStatus st
   int bufferIndex(0);
   BufferItemUidType itemUid;
 
-  PlusLockGuard<StreamItemCircularBuffer> dataBufferGuardedLock(this->StreamBuffer);
-  if (this->StreamBuffer->PrepareForNewItem(filteredTimestamp, itemUid, bufferIndex) != PLUS_SUCCESS)
+  PlusStatus itemStatus(PLUS_SUCCESS);
+  NewItemSignalListType signalsToNotify;
   {
-    // Just a debug message, because we want to avoid unnecessary warning messages if the timestamp is the same as last one
-    LOCAL_LOG_DEBUG("vtkPlusBuffer: Failed to prepare for adding new frame to tracker buffer!");
-    return PLUS_FAIL;
-  }
+    PlusLockGuard<StreamItemCircularBuffer> dataBufferGuardedLock(this->StreamBuffer);
+    if (this->StreamBuffer->PrepareForNewItem(filteredTimestamp, itemUid, bufferIndex) != PLUS_SUCCESS)
+    {
+      // Just a debug message, because we want to avoid unnecessary warning messages if the timestamp is the same as last one
+      LOCAL_LOG_DEBUG("vtkPlusBuffer: Failed to prepare for adding new frame to tracker buffer!");
+      return PLUS_FAIL;
+    }
 
-  // get the pointer to the correct location in the tracker buffer, where this data needs to be copied
-  StreamBufferItem* newObjectInBuffer = this->StreamBuffer->GetBufferItemPointerFromBufferIndex(bufferIndex);
-  if (newObjectInBuffer == NULL)
-  {
-    LOCAL_LOG_ERROR("vtkPlusBuffer: Failed to get pointer to data buffer object from the tracker buffer for the new frame!");
-    return PLUS_FAIL;
-  }
+    // get the pointer to the correct location in the tracker buffer, where this data needs to be copied
+    StreamBufferItem* newObjectInBuffer = this->StreamBuffer->GetBufferItemPointerFromBufferIndex(bufferIndex);
+    if (newObjectInBuffer == NULL)
+    {
+      LOCAL_LOG_ERROR("vtkPlusBuffer: Failed to get pointer to data buffer object from the tracker buffer for the new frame!");
+      return PLUS_FAIL;
+    }
 
-  PlusStatus itemStatus = newObjectInBuffer->SetMatrix(matrix);
-  newObjectInBuffer->SetStatus(status);
-  newObjectInBuffer->SetFilteredTimestamp(filteredTimestamp);
-  newObjectInBuffer->SetUnfilteredTimestamp(unfilteredTimestamp);
-  newObjectInBuffer->SetIndex(frameNumber);
-  newObjectInBuffer->SetUid(itemUid);
+    itemStatus = newObjectInBuffer->SetMatrix(matrix);
+    newObjectInBuffer->SetStatus(status);
+    newObjectInBuffer->SetFilteredTimestamp(filteredTimestamp);
+    newObjectInBuffer->SetUnfilteredTimestamp(unfilteredTimestamp);
+    newObjectInBuffer->SetIndex(frameNumber);
+    newObjectInBuffer->SetUid(itemUid);
 
-  // Add custom fields
-  if (customFields != NULL)
-  {
-    for (PlusTrackedFrame::FieldMapType::const_iterator it = customFields->begin(); it != customFields->end(); ++it)
+    // Add custom fields
+    if (customFields != NULL)
     {
-      newObjectInBuffer->SetCustomFrameField(it->first, it->second);
-      std::string name(it->first);
-      if (name.find("Transform") != std::string::npos)
+      for (PlusTrackedFrame::FieldMapType::const_iterator it = customFields->begin(); it != customFields->end(); ++it)
       {
-        newObjectInBuffer->SetValidTransformData(true);
+        newObjectInBuffer->SetCustomFrameField(it->first, it->second);
+        std::string name(it->first);
+        if (name.find("Transform") != std::string::npos)
+        {
+          newObjectInBuffer->SetValidTransformData(true);
+        }
       }
     }
+
+    this->StreamBuffer->PublishNewItems();
+    signalsToNotify = this->NewItemSignals;
   }
+  NotifyNewItemSignals(signalsToNotify);
 
   return itemStatus;
 }
@@ -606,6 +629,59 @@ int vtkPlusBuffer::GetAveragedItemsForFiltering()
   return this->StreamBuffer->GetAveragedItemsForFiltering();
 }
 
+//----------------------------------------------------------------------------
+void vtkPlusBuffer::SetLockFreeReading(bool enable)
+{
+  this->StreamBuffer->SetLockFreeReading(enable);
+}
+
+//----------------------------------------------------------------------------
+bool vtkPlusBuffer::GetLockFreeReading()
+{
+  return this->StreamBuffer->GetLockFreeReading();
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusBuffer::AddNewItemSignal(vtkPlusNewItemSignal* signal)
+{
+  if (signal == NULL)
+  {
+    return;
+  }
+  PlusLockGuard<StreamItemCircularBuffer> dataBufferGuardedLock(this->StreamBuffer);
+  for (std::vector< vtkSmartPointer<vtkPlusNewItemSignal> >::iterator it = this->NewItemSignals.begin(); it != this->NewItemSignals.end(); ++it)
+  {
+    if (it->GetPointer() == signal)
+    {
+      return;
+    }
+  }
+  this->NewItemSignals.push_back(signal);
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusBuffer::RemoveNewItemSignal(vtkPlusNewItemSignal* signal)
+{
+  PlusLockGuard<StreamItemCircularBuffer> dataBufferGuardedLock(this->StreamBuffer);
+  for (std::vector< vtkSmartPointer<vtkPlusNewItemSignal> >::iterator it = this->NewItemSignals.begin(); it != this->NewItemSignals.end(); ++it)
+  {
+    if (it->GetPointer() == signal)
+    {
+      this->NewItemSignals.erase(it);
+      return;
+    }
+  }
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusBuffer::NotifyNewItemSignals(const NewItemSignalListType& signalsToNotify)
+{
+  for (NewItemSignalListType::const_iterator it = signalsToNotify.begin(); it != signalsToNotify.end(); ++it)
+  {
+    (*it)->Notify();
+  }
+}
+
 //----------------------------------------------------------------------------
 void vtkPlusBuffer::SetStartTime(double startTime)
 {
@@ -626,6 +702,18 @@ PlusStatus vtkPlusBuffer::GetTimeStampReportTable(vtkTable* timeStampReportTable
 
 //----------------------------------------------------------------------------
 ItemStatus vtkPlusBuffer::GetStreamBufferItem(BufferItemUidType uid, StreamBufferItem* bufferItem)
+{
+  return this->CopyStreamBufferItem(uid, bufferItem, false);
+}
+
+//----------------------------------------------------------------------------
+ItemStatus vtkPlusBuffer::GetStreamBufferItemView(BufferItemUidType uid, StreamBufferItem* bufferItem)
+{
+  return this->CopyStreamBufferItem(uid, bufferItem, true);
+}
+
+//----------------------------------------------------------------------------
+ItemStatus vtkPlusBuffer::CopyStreamBufferItem(BufferItemUidType uid, StreamBufferItem* bufferItem, bool shareFrame)
 {
   if (bufferItem == NULL)
   {
@@ -643,7 +731,9 @@ ItemStatus vtkPlusBuffer::GetStreamBufferItem(BufferItemUidType uid, StreamBuffe
     return itemStatus;
   }
 
-  if (bufferItem->DeepCopy(dataItem) != PLUS_SUCCESS)
+  // The writer checks if the pixels of a slot are pinned while holding the buffer lock, so the reference must be taken under the lock, too
+  PlusStatus copyStatus = shareFrame ? bufferItem->ShallowCopy(dataItem) : bufferItem->DeepCopy(dataItem);
+  if (copyStatus != PLUS_SUCCESS)
   {
     LOCAL_LOG_WARNING("Failed to copy data item");
     return ITEM_UNKNOWN_ERROR;
@@ -784,6 +874,84 @@ PlusStatus vtkPlusBuffer::CopyImagesFromTrackedFrameList(vtkPlusTrackedFrameList
     return PLUS_FAIL;
   }
 
+  LOG_INFO("Copy buffer to video buffer...");
+  for (int frameNumber = 0; frameNumber < numberOfVideoFrames; frameNumber++)
+  {
+    if (this->AddItemFromTrackedFrame(*sourceTrackedFrameList->GetTrackedFrame(frameNumber), frameNumber, timestampFiltering, copyCustomFrameFields) != PLUS_SUCCESS)
+    {
+      numberOfErrors++;
+    }
+  }
+
+  return (numberOfErrors > 0 ? PLUS_FAIL : PLUS_SUCCESS);
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusBuffer::CopyImagesFromSequenceFile(vtkPlusSequenceIOBase* sequenceReader, TIMESTAMP_FILTERING_OPTION timestampFiltering, bool copyCustomFrameFields)
+{
+  if (sequenceReader == NULL)
+  {
+    LOCAL_LOG_ERROR("CopyImagesFromSequenceFile failed: sequence reader is invalid");
+    return PLUS_FAIL;
+  }
+  if (sequenceReader->StartFrameByFrameReading() != PLUS_SUCCESS)
+  {
+    LOCAL_LOG_ERROR("Failed to read sequence file: " << sequenceReader->GetFileName());
+    return PLUS_FAIL;
+  }
+
+  const int numberOfVideoFrames = sequenceReader->GetNumberOfFrames();
+  LOCAL_LOG_DEBUG("CopyImagesFromSequenceFile will copy " << numberOfVideoFrames << " frames");
+  if (numberOfVideoFrames < 1)
+  {
+    LOCAL_LOG_ERROR("There is no frame in the sequence file: " << sequenceReader->GetFileName());
+    sequenceReader->StopFrameByFrameReading();
+    return PLUS_FAIL;
+  }
+
+  if (this->SetBufferSize(numberOfVideoFrames) != PLUS_SUCCESS)
+  {
+    LOCAL_LOG_ERROR("Failed to set video buffer size!");
+    sequenceReader->StopFrameByFrameReading();
+    return PLUS_FAIL;
+  }
+
+  // Frames are read from the file one by one, so only the buffer and a single frame has to fit into memory
+  LOG_INFO("Copy sequence file to video buffer...");
+  int numberOfErrors = 0;
+  PlusTrackedFrame trackedFrame;
+  for (int frameNumber = 0; frameNumber < numberOfVideoFrames; frameNumber++)
+  {
+    if (sequenceReader->ReadNextFrame(trackedFrame) != PLUS_SUCCESS)
+    {
+      numberOfErrors++;
+      break;
+    }
+    if (frameNumber == 0)
+    {
+      // Buffer format is defined by the first frame
+      unsigned int frameSize[3] = {0, 0, 0};
+      trackedFrame.GetImageData()->GetFrameSize(frameSize);
+      this->SetFrameSize(frameSize);
+      this->SetPixelType(trackedFrame.GetImageData()->GetVTKScalarPixelType());
+      this->SetNumberOfScalarComponents(trackedFrame.GetImageData()->GetNumberOfScalarComponents());
+      this->SetImageType(trackedFrame.GetImageData()->GetImageType());
+      this->SetImageOrientation(trackedFrame.GetImageData()->GetImageOrientation());
+    }
+    if (this->AddItemFromTrackedFrame(trackedFrame, frameNumber, timestampFiltering, copyCustomFrameFields) != PLUS_SUCCESS)
+    {
+      numberOfErrors++;
+    }
+  }
+
+  sequenceReader->StopFrameByFrameReading();
+
+  return (numberOfErrors > 0 ? PLUS_FAIL : PLUS_SUCCESS);
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusBuffer::AddItemFromTrackedFrame(PlusTrackedFrame& trackedFrame, int frameNumber, TIMESTAMP_FILTERING_OPTION timestampFiltering, bool copyCustomFrameFields)
+{
   bool requireTimestamp = false;
   if (timestampFiltering == READ_FILTERED_AND_UNFILTERED_TIMESTAMPS || timestampFiltering == READ_FILTERED_IGNORE_UNFILTERED_TIMESTAMPS)
   {
@@ -796,129 +964,117 @@ PlusStatus vtkPlusBuffer::CopyImagesFromTrackedFrameList(vtkPlusTrackedFrameList
     requireUnfilteredTimestamp = true;
   }
 
-  bool requireFrameStatus = false;
   bool requireFrameNumber = false;
   if (timestampFiltering == READ_UNFILTERED_COMPUTE_FILTERED_TIMESTAMPS)
   {
-    // frame status and number is required for the filtered timestamp computation
-    requireFrameStatus = true;
+    // frame number is required for the filtered timestamp computation
     requireFrameNumber = true;
   }
 
-  LOG_INFO("Copy buffer to video buffer...");
-  for (int frameNumber = 0; frameNumber < numberOfVideoFrames; frameNumber++)
+  StreamBufferItem::FieldMapType customFields;
+  if (copyCustomFrameFields)
   {
-    StreamBufferItem::FieldMapType customFields;
-    if (copyCustomFrameFields)
+    // Copy all custom fields
+    StreamBufferItem::FieldMapType sourceCustomFields = trackedFrame.GetCustomFields();
+    StreamBufferItem::FieldMapType::iterator fieldIterator;
+    for (fieldIterator = sourceCustomFields.begin(); fieldIterator != sourceCustomFields.end(); fieldIterator++)
     {
-      // Copy all custom fields
-      StreamBufferItem::FieldMapType sourceCustomFields = sourceTrackedFrameList->GetTrackedFrame(frameNumber)->GetCustomFields();
-      StreamBufferItem::FieldMapType::iterator fieldIterator;
-      for (fieldIterator = sourceCustomFields.begin(); fieldIterator != sourceCustomFields.end(); fieldIterator++)
+      // skip special fields
+      if (PlusCommon::IsEqualInsensitive(fieldIterator->first, "TimeStamp"))
       {
-        // skip special fields
-        if (PlusCommon::IsEqualInsensitive(fieldIterator->first, "TimeStamp"))
-        {
-          continue;
-        }
-        if (PlusCommon::IsEqualInsensitive(fieldIterator->first, "UnfilteredTimestamp"))
-        {
-          continue;
-        }
-        if (PlusCommon::IsEqualInsensitive(fieldIterator->first, "FrameNumber"))
-        {
-          continue;
-        }
-        // add custom field
-        customFields[fieldIterator->first] = fieldIterator->second;
+        continue;
       }
-    }
-
-    // read filtered timestamp
-    double timestamp(0);
-    const char* strTimestamp = sourceTrackedFrameList->GetTrackedFrame(frameNumber)->GetCustomFrameField("Timestamp");
-    if (strTimestamp != NULL)
-    {
-      if (PlusCommon::StringToDouble(strTimestamp, timestamp) != PLUS_SUCCESS && requireTimestamp)
+      if (PlusCommon::IsEqualInsensitive(fieldIterator->first, "UnfilteredTimestamp"))
       {
-        LOCAL_LOG_ERROR("Unable to convert Timestamp '" << strTimestamp << "' to double for frame #" << frameNumber);
-        numberOfErrors++;
         continue;
       }
-    }
-    else if (requireTimestamp)
-    {
-      LOCAL_LOG_ERROR("Unable to read Timestamp field of frame #" << frameNumber);
-      numberOfErrors++;
-      continue;
-    }
-
-    // read unfiltered timestamp
-    double unfilteredtimestamp(0);
-    const char* strUnfilteredTimestamp = sourceTrackedFrameList->GetTrackedFrame(frameNumber)->GetCustomFrameField("UnfilteredTimestamp");
-    if (strUnfilteredTimestamp != NULL)
-    {
-      if (PlusCommon::StringToDouble(strUnfilteredTimestamp, unfilteredtimestamp) != PLUS_SUCCESS && requireUnfilteredTimestamp)
+      if (PlusCommon::IsEqualInsensitive(fieldIterator->first, "FrameNumber"))
       {
-        LOCAL_LOG_ERROR("Unable to convert UnfilteredTimestamp '" << strUnfilteredTimestamp << "' to double for frame #" << frameNumber);
-        numberOfErrors++;
         continue;
       }
+      // add custom field
+      customFields[fieldIterator->first] = fieldIterator->second;
     }
-    else if (requireUnfilteredTimestamp)
-    {
-      LOCAL_LOG_ERROR("Unable to read UnfilteredTimestamp field of frame #" << frameNumber);
-      numberOfErrors++;
-      continue;
-    }
+  }
 
-    // read frame number
-    const char* strFrameNumber = sourceTrackedFrameList->GetTrackedFrame(frameNumber)->GetCustomFrameField("FrameNumber");
-    unsigned long frmnum(0);
-    if (strFrameNumber != NULL)
+  // read filtered timestamp
+  double timestamp(0);
+  const char* strTimestamp = trackedFrame.GetCustomFrameField("Timestamp");
+  if (strTimestamp != NULL)
+  {
+    if (PlusCommon::StringToDouble(strTimestamp, timestamp) != PLUS_SUCCESS && requireTimestamp)
     {
-      if (PlusCommon::StringToLong(strFrameNumber, frmnum) != PLUS_SUCCESS && requireFrameNumber)
-      {
-        LOCAL_LOG_ERROR("Unable to convert FrameNumber '" << strFrameNumber << "' to integer for frame #" << frameNumber);
-        numberOfErrors++;
-        continue;
-      }
+      LOCAL_LOG_ERROR("Unable to convert Timestamp '" << strTimestamp << "' to double for frame #" << frameNumber);
+      return PLUS_FAIL;
     }
-    else if (requireFrameNumber)
+  }
+  else if (requireTimestamp)
+  {
+    LOCAL_LOG_ERROR("Unable to read Timestamp field of frame #" << frameNumber);
+    return PLUS_FAIL;
+  }
+
+  // read unfiltered timestamp
+  double unfilteredtimestamp(0);
+  const char* strUnfilteredTimestamp = trackedFrame.GetCustomFrameField("UnfilteredTimestamp");
+  if (strUnfilteredTimestamp != NULL)
+  {
+    if (PlusCommon::StringToDouble(strUnfilteredTimestamp, unfilteredtimestamp) != PLUS_SUCCESS && requireUnfilteredTimestamp)
     {
-      LOCAL_LOG_ERROR("Unable to read FrameNumber field of frame #" << frameNumber);
-      numberOfErrors++;
-      continue;
+      LOCAL_LOG_ERROR("Unable to convert UnfilteredTimestamp '" << strUnfilteredTimestamp << "' to double for frame #" << frameNumber);
+      return PLUS_FAIL;
     }
+  }
+  else if (requireUnfilteredTimestamp)
+  {
+    LOCAL_LOG_ERROR("Unable to read UnfilteredTimestamp field of frame #" << frameNumber);
+    return PLUS_FAIL;
+  }
 
-    int clipRectOrigin[3] = {PlusCommon::NO_CLIP, PlusCommon::NO_CLIP, PlusCommon::NO_CLIP};
-    int clipRectSize[3] = {PlusCommon::NO_CLIP, PlusCommon::NO_CLIP, PlusCommon::NO_CLIP};
-    switch (timestampFiltering)
+  // read frame number
+  const char* strFrameNumber = trackedFrame.GetCustomFrameField("FrameNumber");
+  unsigned long frmnum(0);
+  if (strFrameNumber != NULL)
+  {
+    if (PlusCommon::StringToLong(strFrameNumber, frmnum) != PLUS_SUCCESS && requireFrameNumber)
     {
-      case READ_FILTERED_AND_UNFILTERED_TIMESTAMPS:
-        if (this->AddItem(sourceTrackedFrameList->GetTrackedFrame(frameNumber)->GetImageData(), frmnum, clipRectOrigin, clipRectSize, unfilteredtimestamp, timestamp, &customFields) != PLUS_SUCCESS)
-        {
-          LOCAL_LOG_WARNING("Failed to add video frame to buffer from sequence metafile with frame #" << frameNumber);
-        }
-        break;
-      case READ_UNFILTERED_COMPUTE_FILTERED_TIMESTAMPS:
-        if (this->AddItem(sourceTrackedFrameList->GetTrackedFrame(frameNumber)->GetImageData(), frmnum, clipRectOrigin, clipRectSize, unfilteredtimestamp, UNDEFINED_TIMESTAMP, &customFields) != PLUS_SUCCESS)
-        {
-          LOCAL_LOG_WARNING("Failed to add video frame to buffer from sequence metafile with frame #" << frameNumber);
-        }
-        break;
-      case READ_FILTERED_IGNORE_UNFILTERED_TIMESTAMPS:
-        if (this->AddItem(sourceTrackedFrameList->GetTrackedFrame(frameNumber)->GetImageData(), frmnum, clipRectOrigin, clipRectSize, timestamp, timestamp, &customFields) != PLUS_SUCCESS)
-        {
-          LOCAL_LOG_WARNING("Failed to add video frame to buffer from sequence metafile with frame #" << frameNumber);
-        }
-        break;
-      default:
-        break;
+      LOCAL_LOG_ERROR("Unable to convert FrameNumber '" << strFrameNumber << "' to integer for frame #" << frameNumber);
+      return PLUS_FAIL;
     }
   }
+  else if (requireFrameNumber)
+  {
+    LOCAL_LOG_ERROR("Unable to read FrameNumber field of frame #" << frameNumber);
+    return PLUS_FAIL;
+  }
 
-  return (numberOfErrors > 0 ? PLUS_FAIL : PLUS_SUCCESS);
+  int clipRectOrigin[3] = {PlusCommon::NO_CLIP, PlusCommon::NO_CLIP, PlusCommon::NO_CLIP};
+  int clipRectSize[3] = {PlusCommon::NO_CLIP, PlusCommon::NO_CLIP, PlusCommon::NO_CLIP};
+  switch (timestampFiltering)
+  {
+    case READ_FILTERED_AND_UNFILTERED_TIMESTAMPS:
+      if (this->AddItem(trackedFrame.GetImageData(), frmnum, clipRectOrigin, clipRectSize, unfilteredtimestamp, timestamp, &customFields) != PLUS_SUCCESS)
+      {
+        LOCAL_LOG_WARNING("Failed to add video frame to buffer from sequence metafile with frame #" << frameNumber);
+      }
+      break;
+    case READ_UNFILTERED_COMPUTE_FILTERED_TIMESTAMPS:
+      if (this->AddItem(trackedFrame.GetImageData(), frmnum, clipRectOrigin, clipRectSize, unfilteredtimestamp, UNDEFINED_TIMESTAMP, &customFields) != PLUS_SUCCESS)
+      {
+        LOCAL_LOG_WARNING("Failed to add video frame to buffer from sequence metafile with frame #" << frameNumber);
+      }
+      break;
+    case READ_FILTERED_IGNORE_UNFILTERED_TIMESTAMPS:
+      if (this->AddItem(trackedFrame.GetImageData(), frmnum, clipRectOrigin, clipRectSize, timestamp, timestamp, &customFields) != PLUS_SUCCESS)
+      {
+        LOCAL_LOG_WARNING("Failed to add video frame to buffer from sequence metafile with frame #" << frameNumber);
+      }
+      break;
+    default:
+      break;
+  }
+
+  return PLUS_SUCCESS;
 }
 
 //----------------------------------------------------------------------------
@@ -1027,7 +1183,8 @@ PlusStatus vtkPlusBuffer::GetPrevNextBufferItemFromTime(double time, StreamBuffe
     }
     return PLUS_FAIL;
   }
-  status = this->GetStreamBufferItem(itemAuid, &itemA);
+  // itemA and itemB are temporary, they don't need their own copy of the pixels
+  status = this->GetStreamBufferItemView(itemAuid, &itemA);
   if (status != ITEM_OK)
   {
     LOCAL_LOG_ERROR("vtkPlusBuffer: Failed to get data buffer item with Uid: " << itemAuid);
@@ -1054,7 +1211,7 @@ PlusStatus vtkPlusBuffer::GetPrevNextBufferItemFromTime(double time, StreamBuffe
   if (fabs(itemAtime - time) < NEGLIGIBLE_TIME_DIFFERENCE)
   {
     //No need for interpolation, it's very close to the closest element
-    itemB.DeepCopy(&itemA);
+    itemB.ShallowCopy(&itemA);
     return PLUS_SUCCESS;
   }
 
@@ -1098,7 +1255,7 @@ PlusStatus vtkPlusBuffer::GetPrevNextBufferItemFromTime(double time, StreamBuffe
     return PLUS_FAIL;
   }
   // Get the item
-  status = this->GetStreamBufferItem(itemBuid, &itemB);
+  status = this->GetStreamBufferItemView(itemBuid, &itemB);
   if (status != ITEM_OK)
   {
     LOCAL_LOG_ERROR("vtkPlusBuffer: Failed to get data buffer item with Uid: " << itemBuid);
@@ -21,10 +21,13 @@ See Copyright.txt or http://www.kitware.com/Copyright.htm for details.
 #include "PlusTrackedFrame.h"
 #include "vtkObject.h"
 #include "vtkPlusTimestampedCircularBuffer.h"
+#include "vtkSmartPointer.h"
 
 class vtkPlusDevice;
+class vtkPlusNewItemSignal;
 enum ToolStatus;
 
+class vtkPlusSequenceIOBase;
 class vtkPlusTrackedFrameList;
 
 class vtkPlusDataCollectionExport vtkPlusBuffer : public vtkObject
@@ -143,6 +146,13 @@ public:
 
   /*! Get a frame with the specified frame uid from the buffer */
   virtual ItemStatus GetStreamBufferItem(BufferItemUidType uid, StreamBufferItem* bufferItem);
+  /*!
+    Get a read-only view of the frame with the specified frame uid, without copying the image pixels.
+    The returned item shares the pixel array of the buffer slot (see PlusVideoFrame::ShallowCopy).
+    The shared pixels are pinned while the returned item (or any frame that the view was shallow copied into)
+    is alive: when new data is added to the slot, the buffer writes it into a newly allocated pixel array.
+  */
+  virtual ItemStatus GetStreamBufferItemView(BufferItemUidType uid, StreamBufferItem* bufferItem);
   /*! Get the most recent frame from the buffer */
   virtual ItemStatus GetLatestStreamBufferItem(StreamBufferItem* bufferItem)
   {
@@ -248,6 +258,21 @@ public:
 
   virtual int GetAveragedItemsForFiltering();
 
+  /*!
+    Enable reading item UIDs, timestamps and frame indices without locking the buffer
+    (see vtkPlusTimestampedCircularBuffer::SetLockFreeReading)
+  */
+  virtual void SetLockFreeReading(bool enable);
+  virtual bool GetLockFreeReading();
+
+  /*!
+    Subscribe a signal that is notified each time a new item is added to the buffer.
+    Adding the same signal multiple times has no effect.
+  */
+  virtual void AddNewItemSignal(vtkPlusNewItemSignal* signal);
+  /*! Unsubscribe a signal that was added by AddNewItemSignal */
+  virtual void RemoveNewItemSignal(vtkPlusNewItemSignal* signal);
+
   /*! Set recording start time */
   virtual void SetStartTime(double startTime);
   /*! Get recording start time */
@@ -302,6 +327,13 @@ public:
   /*! Copy images from a tracked frame buffer. It is useful when data is stored in a metafile and the data is needed as a vtkPlusDataBuffer. */
   PlusStatus CopyImagesFromTrackedFrameList(vtkPlusTrackedFrameList* sourceTrackedFrameList, TIMESTAMP_FILTERING_OPTION timestampFiltering, bool copyCustomFrameFields);
 
+  /*!
+    Copy images from a sequence file. Frames are read from the file one by one, therefore the
+    whole sequence does not have to be loaded into memory before it is copied into the buffer.
+    Frame size, pixel type, image type and orientation of the buffer are set from the first frame.
+  */
+  PlusStatus CopyImagesFromSequenceFile(vtkPlusSequenceIOBase* sequenceReader, TIMESTAMP_FILTERING_OPTION timestampFiltering, bool copyCustomFrameFields);
+
   /*! Dump the current state of the video buffer to metafile */
   virtual PlusStatus WriteToSequenceFile(const char* filename, bool useCompression = false);
 
@@ -312,6 +344,9 @@ protected:
   vtkPlusBuffer();
   ~vtkPlusBuffer();
 
+  /*! Add the image and fields of a tracked frame read from a sequence file to the buffer */
+  PlusStatus AddItemFromTrackedFrame(PlusTrackedFrame& trackedFrame, int frameNumber, TIMESTAMP_FILTERING_OPTION timestampFiltering, bool copyCustomFrameFields);
+
   /*! Update video buffer by setting the frame format for each frame  */
   virtual PlusStatus AllocateMemoryForFrames();
 
@@ -321,6 +356,9 @@ protected:
   */
   virtual bool CheckFrameFormat(const unsigned int frameSizeInPx[3], PlusCommon::VTKScalarPixelType pixelType, US_IMAGE_TYPE imgType, int numberOfScalarComponents);
 
+  /*! Copy an item from the buffer. If shareFrame is true then the video frame pixels are shared with the buffer slot instead of copied. */
+  ItemStatus CopyStreamBufferItem(BufferItemUidType uid, StreamBufferItem* bufferItem, bool shareFrame);
+
   /*! Returns the two buffer items that are closest previous and next buffer items relative to the specified time. itemA is the closest item */
   PlusStatus GetPrevNextBufferItemFromTime(double time, StreamBufferItem& itemA, StreamBufferItem& itemB);
 
@@ -337,6 +375,14 @@ protected:
   /*! Get tracker buffer item from the closest timestamp */
   virtual ItemStatus GetStreamBufferItemFromClosestTime(double time, StreamBufferItem* bufferItem);
 
+  typedef std::vector< vtkSmartPointer<vtkPlusNewItemSignal> > NewItemSignalListType;
+
+  /*!
+    Notify the signals about a new item. The list is copied from NewItemSignals while the buffer is locked
+    and notified after the lock is released, so that the woken consumers do not have to wait for the writer.
+  */
+  static void NotifyNewItemSignals(const NewItemSignalListType& signalsToNotify);
+
 protected:
   /*! Image frame size in pixel */
   unsigned int FrameSize[3];
@@ -360,6 +406,9 @@ protected:
   /*! Maximum allowed time difference in seconds between the desired and the closest valid timestamp */
   double MaxAllowedTimeDifference;
 
+  /*! Signals that are notified when a new item is added, protected by the StreamBuffer lock */
+  NewItemSignalListType NewItemSignals;
+
   char* DescriptiveName;
 
 private:
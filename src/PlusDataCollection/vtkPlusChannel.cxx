@@ -451,6 +451,40 @@ PlusStatus vtkPlusChannel::GetLatestTimestamp(double& aTimestamp) const
   return aTimestamp != 0 ? PLUS_SUCCESS : PLUS_FAIL;
 }
 
+//----------------------------------------------------------------------------
+void vtkPlusChannel::AddNewItemSignal(vtkPlusNewItemSignal* signal)
+{
+  if (this->HasVideoSource())
+  {
+    this->VideoSource->AddNewItemSignal(signal);
+  }
+  for (DataSourceContainerIterator it = this->GetToolsStartIterator(); it != this->GetToolsEndIterator(); ++it)
+  {
+    it->second->AddNewItemSignal(signal);
+  }
+  for (DataSourceContainerIterator it = this->GetFieldDataSourcesStartIterator(); it != this->GetFieldDataSourcesEndIterator(); ++it)
+  {
+    it->second->AddNewItemSignal(signal);
+  }
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusChannel::RemoveNewItemSignal(vtkPlusNewItemSignal* signal)
+{
+  if (this->HasVideoSource())
+  {
+    this->VideoSource->RemoveNewItemSignal(signal);
+  }
+  for (DataSourceContainerIterator it = this->GetToolsStartIterator(); it != this->GetToolsEndIterator(); ++it)
+  {
+    it->second->RemoveNewItemSignal(signal);
+  }
+  for (DataSourceContainerIterator it = this->GetFieldDataSourcesStartIterator(); it != this->GetFieldDataSourcesEndIterator(); ++it)
+  {
+    it->second->RemoveNewItemSignal(signal);
+  }
+}
+
 
 //----------------------------------------------------------------------------
 void vtkPlusChannel::ShallowCopy(vtkDataObject* otherObject)
@@ -539,19 +573,18 @@ PlusStatus vtkPlusChannel::GetTrackedFrame(double timestamp, PlusTrackedFrame& a
       return PLUS_FAIL;
     }
 
+    // The image pixels are not copied, the tracked frame keeps them pinned in the buffer
     StreamBufferItem CurrentStreamBufferItem;
-    if (this->VideoSource->GetStreamBufferItem(frameUID, &CurrentStreamBufferItem) != ITEM_OK)
+    if (this->VideoSource->GetStreamBufferItemView(frameUID, &CurrentStreamBufferItem) != ITEM_OK)
     {
       LOG_ERROR("Couldn't get video buffer item by frame UID: " << frameUID);
       return PLUS_FAIL;
     }
 
-    // Copy frame
-    PlusVideoFrame frame = CurrentStreamBufferItem.GetFrame();
-    aTrackedFrame.SetImageData(frame);
+    aTrackedFrame.ShareImageData(CurrentStreamBufferItem.GetFrame());
 
     // Copy all custom fields
-    StreamBufferItem::FieldMapType fieldMap = CurrentStreamBufferItem.GetCustomFrameFieldMap();
+    StreamBufferItem::FieldMapType& fieldMap = CurrentStreamBufferItem.GetCustomFrameFieldMap();
     StreamBufferItem::FieldMapType::iterator fieldIterator;
     for (fieldIterator = fieldMap.begin(); fieldIterator != fieldMap.end(); fieldIterator++)
     {
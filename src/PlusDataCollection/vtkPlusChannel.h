@@ -18,6 +18,7 @@ class PlusTrackedFrame;
 class vtkPlusHTMLGenerator;
 class vtkPlusDataSource;
 class vtkPlusDevice;
+class vtkPlusNewItemSignal;
 class vtkPlusTrackedFrameList;
 
 typedef std::map<std::string, vtkPlusDataSource*> DataSourceContainer;
@@ -103,7 +104,8 @@ public:
 
   /*!
     Get tracked frame containing the transform(s) or the
-    image(s) acquired from the device at a specific timestamp
+    image(s) acquired from the device at a specific timestamp.
+    The image pixels are not copied, the tracked frame shares them with the video buffer (see PlusVideoFrame::ShallowCopy).
     \param timestamp Timestamp of the requested tracked frame
     \param trackedFrame Target tracked frame
     \param enableImageData Enable returning of image data. Tracking data will be interpolated at the timestamp of the image data.
@@ -148,6 +150,14 @@ public:
 
   virtual PlusStatus GetLatestTimestamp(double& aTimestamp) const;
 
+  /*!
+    Subscribe a signal that is notified when a new item is added to any data source of the channel (video, tools, fields).
+    Only the data sources that are already in the channel are subscribed, therefore it should be called after the channel is configured.
+  */
+  void AddNewItemSignal(vtkPlusNewItemSignal* signal);
+  /*! Unsubscribe a signal from all data sources of the channel */
+  void RemoveNewItemSignal(vtkPlusNewItemSignal* signal);
+
   void SetOwnerDevice(vtkPlusDevice* _arg) { this->OwnerDevice = _arg; }
   vtkPlusDevice* GetOwnerDevice() const { return this->OwnerDevice; }
 
@@ -378,6 +378,10 @@ PlusStatus vtkPlusDataSource::ReadConfiguration(vtkXMLDataElement* sourceElement
     LOG_DEBUG("AveragedItemsForFiltering is not defined in source element \"" << this->GetId() << "\". Using default value: " << this->GetBuffer()->GetAveragedItemsForFiltering());
   }
 
+  bool lockFreeReading = this->GetBuffer()->GetLockFreeReading();
+  XML_READ_BOOL_ATTRIBUTE_NONMEMBER_OPTIONAL(LockFreeReading, lockFreeReading, sourceElement);
+  this->GetBuffer()->SetLockFreeReading(lockFreeReading);
+
   std::string descName;
   if (!aDescriptiveNameForBuffer.empty())
   {
@@ -439,6 +443,11 @@ PlusStatus vtkPlusDataSource::WriteConfiguration(vtkXMLDataElement* aSourceEleme
     aSourceElement->SetIntAttribute("AveragedItemsForFiltering", this->GetBuffer()->GetAveragedItemsForFiltering());
   }
 
+  if (aSourceElement->GetAttribute("LockFreeReading") != NULL)
+  {
+    XML_WRITE_BOOL_ATTRIBUTE_NONMEMBER(LockFreeReading, this->GetBuffer()->GetLockFreeReading(), aSourceElement);
+  }
+
   // Write custom properties
   if (this->CustomProperties.size() > 0)
   {
@@ -818,6 +827,24 @@ ItemStatus vtkPlusDataSource::GetStreamBufferItem(BufferItemUidType uid, StreamB
   return this->GetBuffer()->GetStreamBufferItem(uid, bufferItem);
 }
 
+//-----------------------------------------------------------------------------
+ItemStatus vtkPlusDataSource::GetStreamBufferItemView(BufferItemUidType uid, StreamBufferItem* bufferItem)
+{
+  return this->GetBuffer()->GetStreamBufferItemView(uid, bufferItem);
+}
+
+//-----------------------------------------------------------------------------
+void vtkPlusDataSource::AddNewItemSignal(vtkPlusNewItemSignal* signal)
+{
+  this->GetBuffer()->AddNewItemSignal(signal);
+}
+
+//-----------------------------------------------------------------------------
+void vtkPlusDataSource::RemoveNewItemSignal(vtkPlusNewItemSignal* signal)
+{
+  this->GetBuffer()->RemoveNewItemSignal(signal);
+}
+
 //-----------------------------------------------------------------------------
 ItemStatus vtkPlusDataSource::GetLatestStreamBufferItem(StreamBufferItem* bufferItem)
 {
@@ -134,6 +134,12 @@ public:
 
   /*! Get a frame with the specified frame uid from the buffer */
   virtual ItemStatus GetStreamBufferItem(BufferItemUidType uid, StreamBufferItem* bufferItem);
+  /*! Get a read-only view of the frame with the specified frame uid, without copying the image pixels (see vtkPlusBuffer::GetStreamBufferItemView) */
+  virtual ItemStatus GetStreamBufferItemView(BufferItemUidType uid, StreamBufferItem* bufferItem);
+  /*! Subscribe a signal that is notified when a new item is added to the buffer (see vtkPlusBuffer::AddNewItemSignal) */
+  virtual void AddNewItemSignal(vtkPlusNewItemSignal* signal);
+  /*! Unsubscribe a signal that was added by AddNewItemSignal */
+  virtual void RemoveNewItemSignal(vtkPlusNewItemSignal* signal);
   /*! Get the most recent frame from the buffer */
   virtual ItemStatus GetLatestStreamBufferItem(StreamBufferItem* bufferItem);
   /*! Get the oldest frame from buffer */
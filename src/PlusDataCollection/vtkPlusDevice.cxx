@@ -10,6 +10,7 @@ See License.txt for details.
 #include "vtkPlusChannel.h"
 #include "vtkPlusDataSource.h"
 #include "vtkPlusDevice.h"
+#include "vtkPlusNewItemSignal.h"
 #include "vtkPlusRecursiveCriticalSection.h"
 #include "vtkPlusSequenceIO.h"
 #include "vtkPlusTrackedFrameList.h"
@@ -134,6 +135,8 @@ vtkPlusDevice::vtkPlusDevice()
   , OutputNeedsInitialization(1)
   , CorrectlyConfigured(true)
   , StartThreadForInternalUpdates(false)
+  , UpdateOnNewInputData(false)
+  , NewInputDataSignal(vtkPlusNewItemSignal::New())
   , LocalTimeOffsetSec(0.0)
   , MissingInputGracePeriodSec(0.0)
   , RequireImageOrientationInConfiguration(false)
@@ -183,6 +186,8 @@ vtkPlusDevice::~vtkPlusDevice()
 
   DELETE_IF_NOT_NULL(this->UpdateMutex);
 
+  DELETE_IF_NOT_NULL(this->NewInputDataSignal);
+
   LOCAL_LOG_TRACE("vtkPlusDevice::~vtkPlusDevice() completed");
 }
 
@@ -1057,6 +1062,8 @@ PlusStatus vtkPlusDevice::ReadConfiguration(vtkXMLDataElement* rootXMLElement)
     LOCAL_LOG_DEBUG("Unable to find acquisition rate in device element when it is required, using default " << this->GetAcquisitionRate());
   }
 
+  XML_READ_BOOL_ATTRIBUTE_OPTIONAL(UpdateOnNewInputData, deviceXMLElement);
+
   vtkXMLDataElement* outputChannelsElement = deviceXMLElement->FindNestedElementWithName("OutputChannels");
   if (outputChannelsElement != NULL)
   {
@@ -1265,6 +1272,13 @@ PlusStatus vtkPlusDevice::StartRecording()
 
   if (this->StartThreadForInternalUpdates)
   {
+    if (this->UpdateOnNewInputData)
+    {
+      for (ChannelContainerIterator it = this->InputChannels.begin(); it != this->InputChannels.end(); ++it)
+      {
+        (*it)->AddNewItemSignal(this->NewInputDataSignal);
+      }
+    }
     this->ThreadId =
       this->Threader->SpawnThread((vtkThreadFunctionType)\
                                   &vtkDataCaptureThread, this);
@@ -1294,6 +1308,8 @@ PlusStatus vtkPlusDevice::StopRecording()
   if (this->GetStartThreadForInternalUpdates())
   {
     LOCAL_LOG_DEBUG("Wait for internal update thread to terminate");
+    // Wake up the thread if it is waiting for new input data
+    this->NewInputDataSignal->Notify();
     // Let's give a chance to the thread to stop before we kill the connection
     while (this->ThreadAlive)
     {
@@ -1301,6 +1317,10 @@ PlusStatus vtkPlusDevice::StopRecording()
     }
     this->ThreadId = -1;
     LOCAL_LOG_DEBUG("Internal update thread terminated");
+    for (ChannelContainerIterator it = this->InputChannels.begin(); it != this->InputChannels.end(); ++it)
+    {
+      (*it)->RemoveNewItemSignal(this->NewInputDataSignal);
+    }
   }
 
   if (this->InternalStopRecording() != PLUS_SUCCESS)
@@ -1323,6 +1343,7 @@ void* vtkPlusDevice::vtkDataCaptureThread(vtkMultiThreader::ThreadInfo* data)
   double rate = self->GetAcquisitionRate();
   double currtime[FRAME_RATE_AVERAGING] = {0};
   unsigned long updatecount = 0;
+  unsigned long long lastNewInputDataNotificationCount = self->NewInputDataSignal->GetNotificationCount();
   self->ThreadAlive = true;
 
   while (self->IsRecording() && self->GetCorrectlyConfigured())
@@ -1349,7 +1370,12 @@ void* vtkPlusDevice::vtkDataCaptureThread(vtkMultiThreader::ThreadInfo* data)
     }
 
     double delay = (newtime + 1.0 / rate - vtkPlusAccurateTimer::GetSystemTime());
-    if (delay > 0)
+    if (self->UpdateOnNewInputData && !self->InputChannels.empty())
+    {
+      // Update as soon as new input data arrives, but at least at the acquisition rate
+      self->NewInputDataSignal->WaitForNewItem(lastNewInputDataNotificationCount, delay);
+    }
+    else if (delay > 0)
     {
       vtkPlusAccurateTimer::Delay(delay);
     }
@@ -24,6 +24,7 @@ class vtkPlusDataCollector;
 class vtkPlusDataSource;
 class vtkPlusDevice;
 class vtkPlusHTMLGenerator;
+class vtkPlusNewItemSignal;
 class vtkXMLDataElement;
 
 typedef std::vector<vtkPlusChannel*> ChannelContainer;
@@ -529,6 +530,14 @@ protected:
   vtkSetMacro(StartThreadForInternalUpdates, bool);
   bool GetStartThreadForInternalUpdates() const;
 
+  /*!
+    If enabled then the internal update thread is woken up as soon as new data is added to any of the input channels,
+    instead of only polling at the acquisition rate. InternalUpdate is still called at least at the acquisition rate.
+  */
+  vtkSetMacro(UpdateOnNewInputData, bool);
+  vtkGetMacro(UpdateOnNewInputData, bool);
+  vtkBooleanMacro(UpdateOnNewInputData, bool);
+
   vtkSetMacro(RecordingStartTime, double);
   double GetRecordingStartTime() const;
 
@@ -596,6 +605,12 @@ protected:
   */
   bool StartThreadForInternalUpdates;
 
+  /*! If enabled, then the internal update thread waits for new data in the input channels (see SetUpdateOnNewInputData) */
+  bool UpdateOnNewInputData;
+
+  /*! Notified when new data is added to any of the input channels, used if UpdateOnNewInputData is enabled */
+  vtkPlusNewItemSignal* NewInputDataSignal;
+
   /*! Value to use when mixing data with another temporally calibrated device*/
   double LocalTimeOffsetSec;
 
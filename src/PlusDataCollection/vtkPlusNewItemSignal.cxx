@@ -0,0 +1,62 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+See License.txt for details.
+=========================================================Plus=header=end*/
+
+#include "PlusConfigure.h"
+#include "vtkObjectFactory.h"
+#include "vtkPlusNewItemSignal.h"
+
+#include <chrono>
+
+vtkStandardNewMacro(vtkPlusNewItemSignal);
+
+//----------------------------------------------------------------------------
+vtkPlusNewItemSignal::vtkPlusNewItemSignal()
+  : NotificationCount(0)
+{
+}
+
+//----------------------------------------------------------------------------
+vtkPlusNewItemSignal::~vtkPlusNewItemSignal()
+{
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusNewItemSignal::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+  os << indent << "NotificationCount: " << this->GetNotificationCount() << std::endl;
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusNewItemSignal::Notify()
+{
+  {
+    std::lock_guard<std::mutex> lock(this->Mutex);
+    ++this->NotificationCount;
+  }
+  this->NewItemCondition.notify_all();
+}
+
+//----------------------------------------------------------------------------
+unsigned long long vtkPlusNewItemSignal::GetNotificationCount()
+{
+  std::lock_guard<std::mutex> lock(this->Mutex);
+  return this->NotificationCount;
+}
+
+//----------------------------------------------------------------------------
+bool vtkPlusNewItemSignal::WaitForNewItem(unsigned long long& lastNotificationCount, double timeoutSec)
+{
+  std::unique_lock<std::mutex> lock(this->Mutex);
+  if (timeoutSec > 0)
+  {
+    std::chrono::duration<double> timeout(timeoutSec);
+    this->NewItemCondition.wait_for(lock, timeout, [this, lastNotificationCount] { return this->NotificationCount != lastNotificationCount; });
+  }
+  bool notified = (this->NotificationCount != lastNotificationCount);
+  lastNotificationCount = this->NotificationCount;
+  return notified;
+}
@@ -0,0 +1,72 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+#ifndef __vtkPlusNewItemSignal_h
+#define __vtkPlusNewItemSignal_h
+
+#include "PlusConfigure.h"
+#include "vtkPlusDataCollectionExport.h"
+
+#include "vtkObject.h"
+
+#include <condition_variable>
+#include <mutex>
+
+/*!
+  \class vtkPlusNewItemSignal
+  \brief Wakes up consumer threads as soon as a new item is added to any of the buffers it is subscribed to
+
+  A consumer creates a signal and subscribes it to data sources (vtkPlusDataSource::AddNewItemSignal)
+  or to all data sources of a channel (vtkPlusChannel::AddNewItemSignal). Each time an item is added to
+  a subscribed buffer the notification counter is incremented and the waiting threads are woken up.
+
+  Typical usage:
+  \code
+  unsigned long long lastNotificationCount = signal->GetNotificationCount();
+  while (running)
+  {
+    // ... process all the data that is available in the buffers ...
+    signal->WaitForNewItem(lastNotificationCount, timeoutSec);
+  }
+  \endcode
+  As the counter is read before the data is processed, items that are added during processing are not missed.
+
+  \ingroup PlusLibDataCollection
+*/
+class vtkPlusDataCollectionExport vtkPlusNewItemSignal : public vtkObject
+{
+public:
+  static vtkPlusNewItemSignal* New();
+  vtkTypeMacro(vtkPlusNewItemSignal, vtkObject);
+  virtual void PrintSelf(ostream& os, vtkIndent indent) VTK_OVERRIDE;
+
+  /*! Increment the notification counter and wake up all waiting threads. Called by the buffers when a new item is added. */
+  void Notify();
+
+  /*! Get the number of notifications since the signal was created */
+  unsigned long long GetNotificationCount();
+
+  /*!
+    Block until the notification counter differs from lastNotificationCount or the timeout expires.
+    On return lastNotificationCount is set to the current value of the counter.
+    \return true if there was a notification, false if the timeout expired
+  */
+  bool WaitForNewItem(unsigned long long& lastNotificationCount, double timeoutSec);
+
+protected:
+  vtkPlusNewItemSignal();
+  virtual ~vtkPlusNewItemSignal();
+
+  std::mutex Mutex;
+  std::condition_variable NewItemCondition;
+  unsigned long long NotificationCount;
+
+private:
+  vtkPlusNewItemSignal(const vtkPlusNewItemSignal&);  // Not implemented.
+  void operator=(const vtkPlusNewItemSignal&);  // Not implemented.
+};
+
+#endif
@@ -14,9 +14,34 @@ See License.txt for details.
 
 vtkStandardNewMacro(vtkPlusTimestampedCircularBuffer);
 
+//----------------------------------------------------------------------------
+vtkPlusTimestampedCircularBuffer::PublishedItemInfo::PublishedItemInfo()
+  : Uid(0)
+  , FilteredTimestamp(0.0)
+  , UnfilteredTimestamp(0.0)
+  , Index(0)
+{
+}
+
+//----------------------------------------------------------------------------
+vtkPlusTimestampedCircularBuffer::PublishedItemInfo::PublishedItemInfo(const PublishedItemInfo& info)
+  : Uid(info.Uid.load(std::memory_order_relaxed))
+  , FilteredTimestamp(info.FilteredTimestamp.load(std::memory_order_relaxed))
+  , UnfilteredTimestamp(info.UnfilteredTimestamp.load(std::memory_order_relaxed))
+  , Index(info.Index.load(std::memory_order_relaxed))
+{
+}
+
 //----------------------------------------------------------------------------
 vtkPlusTimestampedCircularBuffer::vtkPlusTimestampedCircularBuffer()
   : Mutex(vtkPlusRecursiveCriticalSection::New())
+  , LockFreeReading(false)
+  , PublishedStateSequence(0)
+  , PublishedLatestItemUid(0)
+  , PublishedNumberOfItems(0)
+  , PublishedWritePointer(0)
+  , LastPublishedItemUid(0)
+  , NumberOfItems(0)
   , WritePointer(0)
   , CurrentTimeStamp(0.0)
   , LocalTimeOffsetSec(0.0)
@@ -66,6 +91,7 @@ void vtkPlusTimestampedCircularBuffer::PrintSelf(ostream& os, vtkIndent indent)
   os << indent << "CurrentTimeStamp: " << this->CurrentTimeStamp << "\n";
   os << indent << "Local time offset: " << this->LocalTimeOffsetSec << "\n";
   os << indent << "Latest Item Uid: " << this->LatestItemUid << "\n";
+  os << indent << "Lock-free reading: " << (this->GetLockFreeReading() ? "enabled" : "disabled") << "\n";
 }
 
 //----------------------------------------------------------------------------
@@ -98,6 +124,243 @@ PlusStatus vtkPlusTimestampedCircularBuffer::PrepareForNewItem(const double time
   return PLUS_SUCCESS;
 }
 
+//----------------------------------------------------------------------------
+void vtkPlusTimestampedCircularBuffer::PublishNewItems()
+{
+  // the caller must have locked the buffer
+  if (this->NumberOfItems < 1 || this->PublishedItems.empty())
+  {
+    return;
+  }
+
+  // Publish all the items that have been added since the last call
+  // (an item may have been skipped if the writer failed to set its content)
+  BufferItemUidType oldestUid = this->LatestItemUid - (this->NumberOfItems - 1);
+  BufferItemUidType firstUid = std::max(this->LastPublishedItemUid + 1, oldestUid);
+  for (BufferItemUidType uid = firstUid; uid <= this->LatestItemUid; ++uid)
+  {
+    int bufferIndex = (this->WritePointer - 1) - (this->LatestItemUid - uid);
+    if (bufferIndex < 0)
+    {
+      bufferIndex += this->BufferItemContainer.size();
+    }
+    this->PublishItemInfo(bufferIndex, uid);
+  }
+
+  this->BeginPublishState();
+  this->PublishedNumberOfItems.store(this->NumberOfItems, std::memory_order_relaxed);
+  this->PublishedWritePointer.store(this->WritePointer, std::memory_order_relaxed);
+  this->PublishedLatestItemUid.store(this->LatestItemUid, std::memory_order_release);
+  this->EndPublishState();
+
+  this->LastPublishedItemUid = this->LatestItemUid;
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusTimestampedCircularBuffer::PublishItemInfo(const int bufferIndex, const BufferItemUidType uid)
+{
+  // the caller must have locked the buffer
+  PublishedItemInfo& info = this->PublishedItems[bufferIndex];
+  StreamBufferItem& item = this->BufferItemContainer[bufferIndex];
+
+  // Readers that see a different UID before and after reading the values know that the values are invalid
+  info.Uid.store(0, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  info.FilteredTimestamp.store(item.GetFilteredTimestamp(0.0), std::memory_order_relaxed);
+  info.UnfilteredTimestamp.store(item.GetUnfilteredTimestamp(0.0), std::memory_order_relaxed);
+  info.Index.store(item.GetIndex(), std::memory_order_relaxed);
+  info.Uid.store(uid, std::memory_order_release);
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusTimestampedCircularBuffer::PublishAllItems()
+{
+  // the caller must have locked the buffer
+  this->PublishedItems.resize(this->BufferItemContainer.size());
+
+  const int bufferSize = this->GetBufferSize();
+  for (int bufferIndex = 0; bufferIndex < bufferSize; ++bufferIndex)
+  {
+    // Number of items between this item and the latest item
+    int offsetFromLatest = (this->WritePointer - 1) - bufferIndex;
+    if (offsetFromLatest < 0)
+    {
+      offsetFromLatest += bufferSize;
+    }
+    BufferItemUidType uid = (offsetFromLatest < this->NumberOfItems) ? this->LatestItemUid - offsetFromLatest : 0;
+    this->PublishItemInfo(bufferIndex, uid);
+  }
+
+  this->BeginPublishState();
+  this->PublishedNumberOfItems.store(this->NumberOfItems, std::memory_order_relaxed);
+  this->PublishedWritePointer.store(this->WritePointer, std::memory_order_relaxed);
+  this->PublishedLatestItemUid.store(this->LatestItemUid, std::memory_order_release);
+  this->EndPublishState();
+
+  this->LastPublishedItemUid = this->LatestItemUid;
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusTimestampedCircularBuffer::GetPublishedState(PublishedState& state)
+{
+  for (;;)
+  {
+    unsigned int sequenceBefore = this->PublishedStateSequence.load(std::memory_order_acquire);
+    if (sequenceBefore & 1)
+    {
+      // the writer is updating the state
+      continue;
+    }
+    state.NumberOfItems = this->PublishedNumberOfItems.load(std::memory_order_relaxed);
+    state.WritePointer = this->PublishedWritePointer.load(std::memory_order_relaxed);
+    state.LatestItemUid = this->PublishedLatestItemUid.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (this->PublishedStateSequence.load(std::memory_order_relaxed) == sequenceBefore)
+    {
+      return;
+    }
+  }
+}
+
+//----------------------------------------------------------------------------
+ItemStatus vtkPlusTimestampedCircularBuffer::GetPublishedItemInfo(const PublishedState& state, const BufferItemUidType uid, double* filteredTimestamp, double* unfilteredTimestamp, unsigned long* index)
+{
+  if (state.NumberOfItems < 1 || uid > state.LatestItemUid)
+  {
+    return ITEM_NOT_AVAILABLE_YET;
+  }
+  if (uid < state.LatestItemUid - (state.NumberOfItems - 1))
+  {
+    return ITEM_NOT_AVAILABLE_ANYMORE;
+  }
+
+  int bufferIndex = (state.WritePointer - 1) - (state.LatestItemUid - uid);
+  if (bufferIndex < 0)
+  {
+    bufferIndex += this->PublishedItems.size();
+  }
+  const PublishedItemInfo& info = this->PublishedItems[bufferIndex];
+
+  if (info.Uid.load(std::memory_order_acquire) != uid)
+  {
+    // the item has been overwritten since the state was retrieved
+    return ITEM_NOT_AVAILABLE_ANYMORE;
+  }
+  double filtered = info.FilteredTimestamp.load(std::memory_order_relaxed);
+  double unfiltered = info.UnfilteredTimestamp.load(std::memory_order_relaxed);
+  unsigned long itemIndex = info.Index.load(std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_acquire);
+  if (info.Uid.load(std::memory_order_relaxed) != uid)
+  {
+    // the item has been overwritten while the values were read
+    return ITEM_NOT_AVAILABLE_ANYMORE;
+  }
+
+  if (filteredTimestamp != NULL)
+  {
+    *filteredTimestamp = filtered + this->LocalTimeOffsetSec;
+  }
+  if (unfilteredTimestamp != NULL)
+  {
+    *unfilteredTimestamp = unfiltered + this->LocalTimeOffsetSec;
+  }
+  if (index != NULL)
+  {
+    *index = itemIndex;
+  }
+  return ITEM_OK;
+}
+
+//----------------------------------------------------------------------------
+ItemStatus vtkPlusTimestampedCircularBuffer::GetPublishedItemUidFromTime(const double time, BufferItemUidType& uid)
+{
+  for (;;)
+  {
+    PublishedState state;
+    this->GetPublishedState(state);
+
+    if (state.NumberOfItems < 1)
+    {
+      return ITEM_NOT_AVAILABLE_YET;
+    }
+    if (state.NumberOfItems == 1)
+    {
+      // There is only one item, it's the closest one to any timestamp
+      uid = state.LatestItemUid;
+      return ITEM_OK;
+    }
+
+    BufferItemUidType lo = state.LatestItemUid - (state.NumberOfItems - 1);   // oldest item UID
+    BufferItemUidType hi = state.LatestItemUid; // latest item UID
+
+    double tlo = 0;
+    double thi = 0;
+    if (this->GetPublishedItemInfo(state, lo, &tlo, NULL, NULL) != ITEM_OK
+        || this->GetPublishedItemInfo(state, hi, &thi, NULL, NULL) != ITEM_OK)
+    {
+      // items have been overwritten during the search, retry with the current state
+      continue;
+    }
+
+    // If the timestamp is slightly out of range then still accept it
+    // (due to errors in conversions there could be slight differences)
+    if (time < tlo - this->NegligibleTimeDifferenceSec)
+    {
+      return ITEM_NOT_AVAILABLE_ANYMORE;
+    }
+    else if (time > thi + this->NegligibleTimeDifferenceSec)
+    {
+      return ITEM_NOT_AVAILABLE_YET;
+    }
+
+    bool itemOverwritten = false;
+    while (hi - lo > 1)
+    {
+      BufferItemUidType mid = (lo + hi) / 2;
+      double tmid = 0;
+      if (this->GetPublishedItemInfo(state, mid, &tmid, NULL, NULL) != ITEM_OK)
+      {
+        itemOverwritten = true;
+        break;
+      }
+      if (time < tmid)
+      {
+        hi = mid;
+        thi = tmid;
+      }
+      else
+      {
+        lo = mid;
+        tlo = tmid;
+      }
+    }
+    if (itemOverwritten)
+    {
+      // items have been overwritten during the search, retry with the current state
+      continue;
+    }
+
+    uid = (time - tlo > thi - time) ? hi : lo;
+    return ITEM_OK;
+  }
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusTimestampedCircularBuffer::SetLockFreeReading(bool enable)
+{
+  PlusLockGuard< vtkPlusTimestampedCircularBuffer > bufferGuardedLock(this);
+  if (this->GetLockFreeReading() == enable)
+  {
+    return;
+  }
+  if (enable)
+  {
+    this->PublishAllItems();
+  }
+  this->LockFreeReading.store(enable, std::memory_order_release);
+  this->Modified();
+}
+
 //----------------------------------------------------------------------------
 // Sets the buffer size, and copies the maximum number of the most current old
 // frames and timestamps
@@ -160,6 +423,9 @@ PlusStatus vtkPlusTimestampedCircularBuffer::SetBufferSize(int newBufferSize)
     this->NumberOfItems = this->GetBufferSize();
   }
 
+  // item positions may have changed, so all of them have to be published again
+  this->PublishAllItems();
+
   this->Modified();
 
   return PLUS_SUCCESS;
@@ -208,6 +474,14 @@ StreamBufferItem* vtkPlusTimestampedCircularBuffer::GetBufferItemPointerFromBuff
 //----------------------------------------------------------------------------
 ItemStatus vtkPlusTimestampedCircularBuffer::GetFilteredTimeStamp(const BufferItemUidType uid, double& filteredTimestamp)
 {
+  if (this->GetLockFreeReading())
+  {
+    PublishedState state;
+    this->GetPublishedState(state);
+    filteredTimestamp = 0;
+    return this->GetPublishedItemInfo(state, uid, &filteredTimestamp, NULL, NULL);
+  }
+
   PlusLockGuard< vtkPlusTimestampedCircularBuffer > bufferGuardedLock(this);
   StreamBufferItem* itemPtr = NULL;
   ItemStatus status = GetBufferItemPointerFromUid(uid, itemPtr);
@@ -223,6 +497,14 @@ ItemStatus vtkPlusTimestampedCircularBuffer::GetFilteredTimeStamp(const BufferIt
 //----------------------------------------------------------------------------
 ItemStatus vtkPlusTimestampedCircularBuffer::GetUnfilteredTimeStamp(const BufferItemUidType uid, double& unfilteredTimestamp)
 {
+  if (this->GetLockFreeReading())
+  {
+    PublishedState state;
+    this->GetPublishedState(state);
+    unfilteredTimestamp = 0;
+    return this->GetPublishedItemInfo(state, uid, NULL, &unfilteredTimestamp, NULL);
+  }
+
   PlusLockGuard< vtkPlusTimestampedCircularBuffer > bufferGuardedLock(this);
   StreamBufferItem* itemPtr = NULL;
   ItemStatus status = GetBufferItemPointerFromUid(uid, itemPtr);
@@ -274,6 +556,14 @@ bool vtkPlusTimestampedCircularBuffer::GetLatestItemHasValidFieldData()
 //----------------------------------------------------------------------------
 ItemStatus vtkPlusTimestampedCircularBuffer::GetIndex(const BufferItemUidType uid, unsigned long& index)
 {
+  if (this->GetLockFreeReading())
+  {
+    PublishedState state;
+    this->GetPublishedState(state);
+    index = 0;
+    return this->GetPublishedItemInfo(state, uid, NULL, NULL, &index);
+  }
+
   PlusLockGuard< vtkPlusTimestampedCircularBuffer > bufferGuardedLock(this);
   StreamBufferItem* itemPtr = NULL;
   ItemStatus status = GetBufferItemPointerFromUid(uid, itemPtr);
@@ -313,6 +603,11 @@ ItemStatus vtkPlusTimestampedCircularBuffer::GetBufferIndexFromTime(const double
 // that best matches the given timestamp
 ItemStatus vtkPlusTimestampedCircularBuffer::GetItemUidFromTime(const double time, BufferItemUidType& uid)
 {
+  if (this->GetLockFreeReading())
+  {
+    return this->GetPublishedItemUidFromTime(time, uid);
+  }
+
   PlusLockGuard< vtkPlusTimestampedCircularBuffer > bufferGuardedLock(this);
 
   if (this->NumberOfItems == 1)
@@ -411,6 +706,7 @@ void vtkPlusTimestampedCircularBuffer::DeepCopy(vtkPlusTimestampedCircularBuffer
   this->FilterContainerIndexVector = buffer->FilterContainerIndexVector;
 
   this->BufferItemContainer = buffer->BufferItemContainer;
+  this->PublishAllItems();
   this->Unlock();
   buffer->Unlock();
 }
@@ -423,6 +719,7 @@ void vtkPlusTimestampedCircularBuffer::Clear()
   this->NumberOfItems = 0;
   this->CurrentTimeStamp = 0;
   this->LatestItemUid = 0;
+  this->PublishAllItems();
   this->Unlock();
 }
 
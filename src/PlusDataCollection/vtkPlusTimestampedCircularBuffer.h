@@ -11,7 +11,9 @@
 #include "PlusStreamBufferItem.h"
 #include "vtkObject.h"
 #include "vtkTypeTemplate.h"
+#include <atomic>
 #include <deque>
+#include <vector>
 
 #include "vnl/vnl_matrix.h"
 #include "vnl/vnl_vector.h"
@@ -65,6 +67,10 @@ public:
   /*! Get the most recent frame UID that is already in the buffer */
   virtual BufferItemUidType GetLatestItemUidInBuffer()
   {
+    if (this->GetLockFreeReading())
+    {
+      return this->PublishedLatestItemUid.load(std::memory_order_acquire);
+    }
     this->Lock();
     BufferItemUidType latestUid = this->LatestItemUid;
     this->Unlock();
@@ -74,6 +80,12 @@ public:
   /*! Get the oldest frame UID in the buffer  */
   virtual BufferItemUidType GetOldestItemUidInBuffer()
   {
+    if (this->GetLockFreeReading())
+    {
+      PublishedState state;
+      this->GetPublishedState(state);
+      return state.LatestItemUid - (state.NumberOfItems - 1);
+    }
     this->Lock();
     // LatestItemUid - ( NumberOfItems - 1 ) is the oldest element in the buffer
     BufferItemUidType oldestUid = this->LatestItemUid - ( this->NumberOfItems - 1 );
@@ -89,6 +101,18 @@ public:
 
   virtual ItemStatus GetOldestTimeStamp( double& timestamp )
   {
+    if (this->GetLockFreeReading())
+    {
+      // The oldest item may be overwritten at any moment, retry with the new oldest item
+      for (;;)
+      {
+        ItemStatus status = this->GetFilteredTimeStamp(this->GetOldestItemUidInBuffer(), timestamp);
+        if (status != ITEM_NOT_AVAILABLE_ANYMORE)
+        {
+          return status;
+        }
+      }
+    }
     // The oldest item may be removed from the buffer at any moment
     // therefore we need to retrieve its UID and timestamp within a single lock
     this->Lock();
@@ -169,6 +193,25 @@ public:
 
   virtual PlusStatus PrepareForNewItem( const double timestamp, BufferItemUidType& newFrameUid, int& bufferIndex );
 
+  /*!
+    Make the items that were added by PrepareForNewItem calls visible to lock-free readers.
+    Must be called by the writer while the buffer is locked, after all the item data is set.
+  */
+  virtual void PublishNewItems();
+
+  /*!
+    If lock-free reading is enabled then UID, timestamp and frame index queries (GetLatestItemUidInBuffer,
+    GetItemUidFromTime, GetTimeStamp, GetIndex, ...) do not lock the buffer. The writer publishes these
+    values through sequence counters and the readers retry if an item was overwritten while it was read.
+    Accessing the full content of an item (image, transform, custom fields) still requires locking the buffer.
+    The buffer size must not be changed while there are readers running on other threads.
+    The mode may be switched while readers are running: the published values are maintained in both modes,
+    so a reader that has just seen the previous mode still gets consistent results.
+  */
+  virtual void SetLockFreeReading( bool enable );
+  virtual bool GetLockFreeReading() { return this->LockFreeReading.load( std::memory_order_acquire ); }
+  vtkBooleanMacro( LockFreeReading, bool );
+
   /*!
     Create filtered and unfiltered timestamp for accurate timing of the buffer item.
     The timing may be inaccurate because the timestamp is attached to the item when Plus receives it
@@ -211,9 +254,65 @@ protected:
   vtkPlusTimestampedCircularBuffer();
   ~vtkPlusTimestampedCircularBuffer();
 
+  /*! Item properties that can be read without locking the buffer */
+  struct PublishedItemInfo
+  {
+    PublishedItemInfo();
+    PublishedItemInfo( const PublishedItemInfo& info );
+    /*! UID of the item, 0 while the writer is updating the item */
+    std::atomic<BufferItemUidType> Uid;
+    /*! Filtered timestamp, without local time offset */
+    std::atomic<double> FilteredTimestamp;
+    /*! Unfiltered timestamp, without local time offset */
+    std::atomic<double> UnfilteredTimestamp;
+    std::atomic<unsigned long> Index;
+  };
+
+  /*! Consistent snapshot of the buffer state that is visible for lock-free readers */
+  struct PublishedState
+  {
+    BufferItemUidType LatestItemUid;
+    int NumberOfItems;
+    int WritePointer;
+  };
+
+  /*! Get the latest published buffer state without locking the buffer */
+  void GetPublishedState( PublishedState& state );
+
+  /*! Get the properties of an item without locking the buffer */
+  ItemStatus GetPublishedItemInfo( const PublishedState& state, const BufferItemUidType uid, double* filteredTimestamp, double* unfilteredTimestamp, unsigned long* index );
+
+  /*! Lock-free implementation of GetItemUidFromTime */
+  ItemStatus GetPublishedItemUidFromTime( const double time, BufferItemUidType& uid );
+
+  /*! Write the properties of a single item into the published item list. Caller must lock the buffer. */
+  void PublishItemInfo( const int bufferIndex, const BufferItemUidType uid );
+
+  /*! Write the buffer state and all the items into the published item list. Caller must lock the buffer. */
+  void PublishAllItems();
+
+  /*! Begin/end updating published state. Caller must lock the buffer. */
+  void BeginPublishState() { this->PublishedStateSequence.fetch_add( 1, std::memory_order_relaxed ); std::atomic_thread_fence( std::memory_order_release ); }
+  void EndPublishState() { this->PublishedStateSequence.fetch_add( 1, std::memory_order_release ); }
+
 protected:
   vtkPlusRecursiveCriticalSection* Mutex;
 
+  /*! If enabled then UID and timestamp queries do not lock the buffer. Atomic, as it is read by the reader threads without locking. */
+  std::atomic<bool> LockFreeReading;
+
+  /*! Odd value indicates that the writer is updating the published state */
+  std::atomic<unsigned int> PublishedStateSequence;
+  std::atomic<BufferItemUidType> PublishedLatestItemUid;
+  std::atomic<int> PublishedNumberOfItems;
+  std::atomic<int> PublishedWritePointer;
+
+  /*! Lock-free readable copy of item properties, one element for each item in BufferItemContainer */
+  std::vector<PublishedItemInfo> PublishedItems;
+
+  /*! UID of the latest item that has been published to lock-free readers (accessed only by the writer) */
+  BufferItemUidType LastPublishedItemUid;
+
   int NumberOfItems;
 
   /*! Next image will be written here */
@@ -0,0 +1,282 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+See License.txt for details.
+=========================================================Plus=header=end*/
+
+/*!
+\file vtkPlusRfToBrightnessConvertTest.cxx
+Convert RF frames to brightness images with and without SIMD instructions, verify that the results are identical,
+and report the conversion speed (scanlines/s) for each RF image type.
+Verify that the FFT-based Hilbert transform gives similar brightness values as the FIR filter and report the
+speed of the two methods for various scanline lengths.
+*/
+
+#include "PlusConfigure.h"
+#include "PlusTrackedFrame.h"
+#include "vtkPlusRfToBrightnessConvert.h"
+#include "vtkPlusSequenceIO.h"
+#include "vtkPlusTrackedFrameList.h"
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkSmartPointer.h>
+#include <vtksys/CommandLineArguments.hxx>
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+
+//----------------------------------------------------------------------------
+// Convert all frames of the list numberOfIterations times, returns the number of converted scanlines per second
+double ConvertFrames(vtkPlusRfToBrightnessConvert* converter, vtkPlusTrackedFrameList* rfFrames, int numberOfIterations, std::vector< vtkSmartPointer<vtkImageData> >& outputImages)
+{
+  outputImages.clear();
+  double numberOfScanlines = 0;
+  double processingTimeSec = 0;
+  for (unsigned int frameIndex = 0; frameIndex < rfFrames->GetNumberOfTrackedFrames(); ++frameIndex)
+  {
+    converter->SetInputData(rfFrames->GetTrackedFrame(frameIndex)->GetImageData()->GetImage());
+    double startTime = vtkPlusAccurateTimer::GetSystemTime();
+    for (int iteration = 0; iteration < numberOfIterations; ++iteration)
+    {
+      converter->Modified();
+      converter->Update();
+    }
+    processingTimeSec += vtkPlusAccurateTimer::GetSystemTime() - startTime;
+
+    vtkSmartPointer<vtkImageData> outputImage = vtkSmartPointer<vtkImageData>::New();
+    outputImage->DeepCopy(converter->GetOutput());
+    outputImages.push_back(outputImage);
+    int* outputDimensions = outputImage->GetDimensions();
+    numberOfScanlines += double(outputDimensions[1]) * outputDimensions[2] * numberOfIterations;
+  }
+  return (processingTimeSec > 0 ? numberOfScanlines / processingTimeSec : 0);
+}
+
+//----------------------------------------------------------------------------
+// Compare FFT and FIR filter based Hilbert transform results, returns the number of errors
+int CompareHilbertTransformMethods(vtkPlusTrackedFrameList* rfFrames)
+{
+  vtkSmartPointer<vtkPlusRfToBrightnessConvert> converter = vtkSmartPointer<vtkPlusRfToBrightnessConvert>::New();
+  converter->SetImageType(US_IMG_RF_REAL);
+  std::vector< vtkSmartPointer<vtkImageData> > firImages;
+  converter->SetHilbertTransformMethod(vtkPlusRfToBrightnessConvert::HILBERT_TRANSFORM_FIR);
+  ConvertFrames(converter, rfFrames, 1, firImages);
+  std::vector< vtkSmartPointer<vtkImageData> > fftImages;
+  converter->SetHilbertTransformMethod(vtkPlusRfToBrightnessConvert::HILBERT_TRANSFORM_FFT);
+  ConvertFrames(converter, rfFrames, 1, fftImages);
+
+  // Compare only the samples that the FIR filter computes, the FFT method computes all the samples
+  const double maxMeanBrightnessDifference = 5.0;
+  int margin = converter->GetNumberOfHilbertFilterCoeffs() / 2 + 1;
+  int numberOfErrors = 0;
+  for (unsigned int frameIndex = 0; frameIndex < firImages.size(); ++frameIndex)
+  {
+    int* dimensions = firImages[frameIndex]->GetDimensions();
+    double sumBrightnessDifference = 0;
+    double numberOfComparedSamples = 0;
+    for (int z = 0; z < dimensions[2]; ++z)
+    {
+      for (int y = 0; y < dimensions[1]; ++y)
+      {
+        unsigned char* firScanline = static_cast<unsigned char*>(firImages[frameIndex]->GetScalarPointer(0, y, z));
+        unsigned char* fftScanline = static_cast<unsigned char*>(fftImages[frameIndex]->GetScalarPointer(0, y, z));
+        for (int x = margin; x < dimensions[0] - margin; ++x)
+        {
+          sumBrightnessDifference += abs(int(firScanline[x]) - int(fftScanline[x]));
+          numberOfComparedSamples++;
+        }
+      }
+    }
+    double meanBrightnessDifference = (numberOfComparedSamples > 0 ? sumBrightnessDifference / numberOfComparedSamples : 0);
+    LOG_DEBUG("Mean brightness difference between FIR and FFT Hilbert transform (frame " << frameIndex << "): " << meanBrightnessDifference);
+    if (meanBrightnessDifference > maxMeanBrightnessDifference)
+    {
+      LOG_ERROR("Brightness image computed with FFT Hilbert transform differs from the FIR filter result (frame " << frameIndex
+                << ", mean difference: " << meanBrightnessDifference << ", maximum allowed: " << maxMeanBrightnessDifference << ")");
+      numberOfErrors++;
+    }
+  }
+  return numberOfErrors;
+}
+
+//----------------------------------------------------------------------------
+// Convert a synthetic RF_REAL frame with the specified scanline length, returns the number of converted scanlines per second
+double MeasureHilbertTransformSpeed(int numberOfSamplesInScanline, vtkPlusRfToBrightnessConvert::HilbertTransformMethodType method, bool enableSimd, int numberOfIterations)
+{
+  const int numberOfScanlines = 128;
+  vtkSmartPointer<vtkImageData> rfImage = vtkSmartPointer<vtkImageData>::New();
+  rfImage->SetDimensions(numberOfSamplesInScanline, numberOfScanlines, 1);
+  rfImage->AllocateScalars(VTK_SHORT, 1);
+  short* rfSamples = static_cast<short*>(rfImage->GetScalarPointer());
+  srand(0);
+  for (int i = 0; i < numberOfSamplesInScanline * numberOfScanlines; ++i)
+  {
+    // attenuated sinusoid with noise
+    int sampleIndex = i % numberOfSamplesInScanline;
+    rfSamples[i] = static_cast<short>(5000.0 * exp(-2.0 * sampleIndex / numberOfSamplesInScanline) * cos(0.6 * sampleIndex) + (rand() % 200 - 100));
+  }
+
+  vtkSmartPointer<vtkPlusRfToBrightnessConvert> converter = vtkSmartPointer<vtkPlusRfToBrightnessConvert>::New();
+  converter->SetNumberOfThreads(1);
+  converter->SetImageType(US_IMG_RF_REAL);
+  converter->SetHilbertTransformMethod(method);
+  converter->SetEnableSimd(enableSimd);
+  converter->SetInputData(rfImage);
+  // The first conversion prepares the filter coefficients and the FFT plan
+  converter->Update();
+  double startTime = vtkPlusAccurateTimer::GetSystemTime();
+  for (int iteration = 0; iteration < numberOfIterations; ++iteration)
+  {
+    converter->Modified();
+    converter->Update();
+  }
+  double processingTimeSec = vtkPlusAccurateTimer::GetSystemTime() - startTime;
+  return (processingTimeSec > 0 ? double(numberOfScanlines) * numberOfIterations / processingTimeSec : 0);
+}
+
+//----------------------------------------------------------------------------
+// Report the scanline length from which the FFT Hilbert transform is faster than the FIR filter
+void ReportHilbertTransformCrossover(int numberOfIterations)
+{
+  int crossoverScalar = -1;
+  int crossoverSimd = -1;
+  for (int numberOfSamplesInScanline = 256; numberOfSamplesInScanline <= 16384; numberOfSamplesInScanline *= 2)
+  {
+    double firScalarLinesPerSec = MeasureHilbertTransformSpeed(numberOfSamplesInScanline, vtkPlusRfToBrightnessConvert::HILBERT_TRANSFORM_FIR, false, numberOfIterations);
+    double firSimdLinesPerSec = MeasureHilbertTransformSpeed(numberOfSamplesInScanline, vtkPlusRfToBrightnessConvert::HILBERT_TRANSFORM_FIR, true, numberOfIterations);
+    double fftLinesPerSec = MeasureHilbertTransformSpeed(numberOfSamplesInScanline, vtkPlusRfToBrightnessConvert::HILBERT_TRANSFORM_FFT, true, numberOfIterations);
+    LOG_INFO("Scanline length: " << std::setw(5) << numberOfSamplesInScanline
+             << " | FIR scalar: " << std::setw(9) << std::fixed << std::setprecision(0) << firScalarLinesPerSec << " lines/s"
+             << " | FIR SIMD: " << std::setw(9) << firSimdLinesPerSec << " lines/s"
+             << " | FFT: " << std::setw(9) << fftLinesPerSec << " lines/s");
+    if (crossoverScalar < 0 && fftLinesPerSec > firScalarLinesPerSec)
+    {
+      crossoverScalar = numberOfSamplesInScanline;
+    }
+    if (crossoverSimd < 0 && fftLinesPerSec > firSimdLinesPerSec)
+    {
+      crossoverSimd = numberOfSamplesInScanline;
+    }
+  }
+  if (crossoverScalar > 0)
+  {
+    LOG_INFO("FFT Hilbert transform is faster than the scalar FIR filter from scanline length " << crossoverScalar);
+  }
+  else
+  {
+    LOG_INFO("FFT Hilbert transform is not faster than the scalar FIR filter for the tested scanline lengths");
+  }
+  if (crossoverSimd > 0)
+  {
+    LOG_INFO("FFT Hilbert transform is faster than the SIMD FIR filter from scanline length " << crossoverSimd);
+  }
+  else
+  {
+    LOG_INFO("FFT Hilbert transform is not faster than the SIMD FIR filter for the tested scanline lengths");
+  }
+}
+
+//----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  bool printHelp = false;
+  std::string inputRfFile;
+  int numberOfIterations = 3;
+  bool reportCrossover = false;
+  int verboseLevel = vtkPlusLogger::LOG_LEVEL_UNDEFINED;
+
+  vtksys::CommandLineArguments args;
+  args.Initialize(argc, argv);
+
+  args.AddArgument("--help", vtksys::CommandLineArguments::NO_ARGUMENT, &printHelp, "Print this help.");
+  args.AddArgument("--rf-file", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &inputRfFile, "File name of input RF image data");
+  args.AddArgument("--iterations", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &numberOfIterations, "Number of times each frame is converted for measuring the speed (default: 3)");
+  args.AddArgument("--report-crossover", vtksys::CommandLineArguments::NO_ARGUMENT, &reportCrossover, "Measure the speed of the Hilbert transform methods for scanline lengths 256-16384 and report from which length the FFT method is faster (takes long, not needed for testing)");
+  args.AddArgument("--verbose", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &verboseLevel, "Verbose level (1=error only, 2=warning, 3=info, 4=debug, 5=trace)");
+
+  if (!args.Parse())
+  {
+    std::cerr << "Problem parsing arguments" << std::endl;
+    std::cout << "Help: " << args.GetHelp() << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  if (printHelp)
+  {
+    std::cout << args.GetHelp() << std::endl;
+    exit(EXIT_SUCCESS);
+  }
+
+  vtkPlusLogger::Instance()->SetLogLevel(verboseLevel);
+
+  if (inputRfFile.empty())
+  {
+    LOG_ERROR("--rf-file argument is required");
+    exit(EXIT_FAILURE);
+  }
+
+  vtkSmartPointer<vtkPlusTrackedFrameList> rfFrames = vtkSmartPointer<vtkPlusTrackedFrameList>::New();
+  if (vtkPlusSequenceIO::Read(inputRfFile, rfFrames) != PLUS_SUCCESS || rfFrames->GetNumberOfTrackedFrames() == 0)
+  {
+    LOG_ERROR("Failed to read RF frames from " << inputRfFile);
+    exit(EXIT_FAILURE);
+  }
+
+  LOG_INFO("SIMD instruction set: " << (PlusCommon::IsAvx2Supported() ? "AVX2" : (PlusCommon::IsSse2Supported() ? "SSE2" : "none")));
+
+  // The same RF data is interpreted as each RF encoding type to test all the computation methods
+  US_IMAGE_TYPE imageTypes[] = { US_IMG_RF_REAL, US_IMG_RF_I_LINE_Q_LINE, US_IMG_RF_IQ_LINE };
+  int numberOfErrors = 0;
+  for (unsigned int imageTypeIndex = 0; imageTypeIndex < sizeof(imageTypes) / sizeof(imageTypes[0]); ++imageTypeIndex)
+  {
+    vtkSmartPointer<vtkPlusRfToBrightnessConvert> converter = vtkSmartPointer<vtkPlusRfToBrightnessConvert>::New();
+    // Measure single-thread performance
+    converter->SetNumberOfThreads(1);
+    converter->SetImageType(imageTypes[imageTypeIndex]);
+
+    std::vector< vtkSmartPointer<vtkImageData> > referenceImages;
+    converter->EnableSimdOff();
+    double referenceLinesPerSec = ConvertFrames(converter, rfFrames, numberOfIterations, referenceImages);
+
+    std::vector< vtkSmartPointer<vtkImageData> > simdImages;
+    converter->EnableSimdOn();
+    double simdLinesPerSec = ConvertFrames(converter, rfFrames, numberOfIterations, simdImages);
+
+    LOG_INFO(std::setw(16) << PlusVideoFrame::GetStringFromUsImageType(imageTypes[imageTypeIndex])
+             << " | scalar: " << std::setw(9) << std::fixed << std::setprecision(0) << referenceLinesPerSec << " lines/s"
+             << " | SIMD: " << std::setw(9) << simdLinesPerSec << " lines/s"
+             << " | speedup: " << std::setprecision(2) << (referenceLinesPerSec > 0 ? simdLinesPerSec / referenceLinesPerSec : 0));
+
+    for (unsigned int frameIndex = 0; frameIndex < referenceImages.size(); ++frameIndex)
+    {
+      vtkImageData* referenceImage = referenceImages[frameIndex];
+      vtkImageData* simdImage = simdImages[frameIndex];
+      size_t imageSizeBytes = referenceImage->GetNumberOfPoints() * referenceImage->GetScalarSize();
+      if (simdImage->GetNumberOfPoints() != referenceImage->GetNumberOfPoints()
+          || memcmp(referenceImage->GetScalarPointer(), simdImage->GetScalarPointer(), imageSizeBytes) != 0)
+      {
+        LOG_ERROR("Brightness image computed with SIMD instructions differs from the reference image (frame " << frameIndex
+                  << ", image type " << PlusVideoFrame::GetStringFromUsImageType(imageTypes[imageTypeIndex]) << ")");
+        numberOfErrors++;
+      }
+    }
+  }
+
+  numberOfErrors += CompareHilbertTransformMethods(rfFrames);
+  if (reportCrossover)
+  {
+    ReportHilbertTransformCrossover(numberOfIterations);
+  }
+
+  if (numberOfErrors > 0)
+  {
+    LOG_ERROR("Test failed, number of errors: " << numberOfErrors);
+    return EXIT_FAILURE;
+  }
+
+  LOG_INFO("Test completed successfully");
+  return EXIT_SUCCESS;
+}
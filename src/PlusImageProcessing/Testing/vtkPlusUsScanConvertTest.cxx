@@ -0,0 +1,235 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+See License.txt for details.
+=========================================================Plus=header=end*/
+
+/*!
+\file vtkPlusUsScanConvertTest.cxx
+Scan convert a synthetic curvilinear brightness image with the exact and the compact interpolation table
+and verify that the pixel values differ by at most one. Verify that scan converters with the same geometry
+share the same interpolation table, converters with different geometry use different tables, and tables that
+are not used by any scan converter are released.
+*/
+
+#include "PlusConfigure.h"
+#include "vtkPlusUsScanConvertCurvilinear.h"
+#include "vtkPlusUsScanConvertInterpolationTable.h"
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkSmartPointer.h>
+#include <vtkWeakPointer.h>
+#include <vtkXMLDataElement.h>
+#include <vtksys/CommandLineArguments.hxx>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+namespace
+{
+  const int NUMBER_OF_SAMPLES_IN_SCANLINE = 1024;
+  const int NUMBER_OF_SCANLINES = 128;
+  const int MAX_COMPACT_TABLE_PIXEL_DIFFERENCE = 1;
+  const double DEFAULT_RADIUS_STOP_MM = 175.0;
+
+  //----------------------------------------------------------------------------
+  vtkSmartPointer<vtkImageData> CreateBrightnessImage()
+  {
+    vtkSmartPointer<vtkImageData> image = vtkSmartPointer<vtkImageData>::New();
+    image->SetDimensions(NUMBER_OF_SAMPLES_IN_SCANLINE, NUMBER_OF_SCANLINES, 1);
+    image->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+    unsigned char* pixels = static_cast<unsigned char*>(image->GetScalarPointer());
+    srand(0);
+    for (int line = 0; line < NUMBER_OF_SCANLINES; ++line)
+    {
+      for (int sample = 0; sample < NUMBER_OF_SAMPLES_IN_SCANLINE; ++sample)
+      {
+        // speckle-like noise over a smooth pattern, covering the full intensity range
+        double value = 127.5 + 100.0 * sin(0.05 * sample) * cos(0.2 * line) + (rand() % 56 - 28);
+        pixels[line * NUMBER_OF_SAMPLES_IN_SCANLINE + sample] = static_cast<unsigned char>(std::max(0.0, std::min(255.0, value)));
+      }
+    }
+    return image;
+  }
+
+  //----------------------------------------------------------------------------
+  vtkSmartPointer<vtkPlusUsScanConvertCurvilinear> CreateScanConverter(vtkImageData* inputImage, bool compact, double radiusStopMm)
+  {
+    vtkSmartPointer<vtkXMLDataElement> scanConversionElement = vtkSmartPointer<vtkXMLDataElement>::New();
+    scanConversionElement->SetName("ScanConversion");
+    scanConversionElement->SetAttribute("TransducerGeometry", "CURVILINEAR");
+    scanConversionElement->SetDoubleAttribute("RadiusStartMm", 60.0);
+    scanConversionElement->SetDoubleAttribute("RadiusStopMm", radiusStopMm);
+    scanConversionElement->SetDoubleAttribute("ThetaStartDeg", -36.0);
+    scanConversionElement->SetDoubleAttribute("ThetaStopDeg", 36.0);
+    scanConversionElement->SetAttribute("OutputImageSizePixel", "820 616");
+    scanConversionElement->SetAttribute("OutputImageSpacingMmPerPixel", "0.2 0.2");
+    scanConversionElement->SetAttribute("CompactInterpolationTable", compact ? "TRUE" : "FALSE");
+
+    vtkSmartPointer<vtkPlusUsScanConvertCurvilinear> scanConverter = vtkSmartPointer<vtkPlusUsScanConvertCurvilinear>::New();
+    if (scanConverter->ReadConfiguration(scanConversionElement) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to configure scan converter");
+      return NULL;
+    }
+    scanConverter->SetInputData(inputImage);
+    scanConverter->Update();
+    return scanConverter;
+  }
+
+  //----------------------------------------------------------------------------
+  int CompareExactAndCompactTables(vtkImageData* inputImage)
+  {
+    vtkSmartPointer<vtkPlusUsScanConvertCurvilinear> exactScanConverter = CreateScanConverter(inputImage, false, DEFAULT_RADIUS_STOP_MM);
+    vtkSmartPointer<vtkPlusUsScanConvertCurvilinear> compactScanConverter = CreateScanConverter(inputImage, true, DEFAULT_RADIUS_STOP_MM);
+    if (exactScanConverter == NULL || compactScanConverter == NULL)
+    {
+      return 1;
+    }
+    vtkImageData* exactImage = exactScanConverter->GetOutput();
+    vtkImageData* compactImage = compactScanConverter->GetOutput();
+
+    int exactDimensions[3] = {0};
+    int compactDimensions[3] = {0};
+    exactImage->GetDimensions(exactDimensions);
+    compactImage->GetDimensions(compactDimensions);
+    if (exactDimensions[0] != compactDimensions[0] || exactDimensions[1] != compactDimensions[1] || exactDimensions[2] != compactDimensions[2])
+    {
+      LOG_ERROR("Scan converted image size mismatch: exact table " << exactDimensions[0] << "x" << exactDimensions[1]
+                << ", compact table " << compactDimensions[0] << "x" << compactDimensions[1]);
+      return 1;
+    }
+
+    const unsigned char* exactPixels = static_cast<unsigned char*>(exactImage->GetScalarPointer());
+    const unsigned char* compactPixels = static_cast<unsigned char*>(compactImage->GetScalarPointer());
+    int numberOfPixels = exactDimensions[0] * exactDimensions[1] * exactDimensions[2];
+    int numberOfDifferentPixels = 0;
+    int maxDifference = 0;
+    for (int i = 0; i < numberOfPixels; ++i)
+    {
+      int difference = abs(static_cast<int>(exactPixels[i]) - static_cast<int>(compactPixels[i]));
+      if (difference > 0)
+      {
+        numberOfDifferentPixels++;
+        maxDifference = std::max(maxDifference, difference);
+      }
+    }
+    LOG_INFO("Compact table result differs in " << numberOfDifferentPixels << " of " << numberOfPixels << " pixels, maximum difference: " << maxDifference);
+    if (maxDifference > MAX_COMPACT_TABLE_PIXEL_DIFFERENCE)
+    {
+      LOG_ERROR("Compact table result differs by " << maxDifference << " from the exact table result, maximum allowed difference is " << MAX_COMPACT_TABLE_PIXEL_DIFFERENCE);
+      return 1;
+    }
+    return 0;
+  }
+
+  //----------------------------------------------------------------------------
+  int TestSharedTables(vtkImageData* inputImage)
+  {
+    int numberOfErrors = 0;
+
+    // Same geometry
+    vtkSmartPointer<vtkPlusUsScanConvertCurvilinear> scanConverter1 = CreateScanConverter(inputImage, true, DEFAULT_RADIUS_STOP_MM);
+    vtkSmartPointer<vtkPlusUsScanConvertCurvilinear> scanConverter2 = CreateScanConverter(inputImage, true, DEFAULT_RADIUS_STOP_MM);
+    if (scanConverter1 == NULL || scanConverter2 == NULL)
+    {
+      return 1;
+    }
+    if (scanConverter1->GetInterpolationTable() == NULL || scanConverter1->GetInterpolationTable() != scanConverter2->GetInterpolationTable())
+    {
+      LOG_ERROR("Scan converters with the same geometry do not share the interpolation table");
+      numberOfErrors++;
+    }
+
+    // Different geometry
+    vtkSmartPointer<vtkPlusUsScanConvertCurvilinear> scanConverter3 = CreateScanConverter(inputImage, true, DEFAULT_RADIUS_STOP_MM - 20.0);
+    vtkSmartPointer<vtkPlusUsScanConvertCurvilinear> scanConverter4 = CreateScanConverter(inputImage, false, DEFAULT_RADIUS_STOP_MM);
+    if (scanConverter3 == NULL || scanConverter4 == NULL)
+    {
+      return numberOfErrors + 1;
+    }
+    if (scanConverter3->GetInterpolationTable() == scanConverter1->GetInterpolationTable())
+    {
+      LOG_ERROR("Scan converters with different geometry use the same interpolation table");
+      numberOfErrors++;
+    }
+    if (scanConverter4->GetInterpolationTable() == scanConverter1->GetInterpolationTable())
+    {
+      LOG_ERROR("Scan converters with exact and compact interpolation table use the same interpolation table");
+      numberOfErrors++;
+    }
+
+    // Release a table that is not used anymore
+    vtkWeakPointer<vtkPlusUsScanConvertInterpolationTable> unusedTable = scanConverter3->GetInterpolationTable();
+    vtkWeakPointer<vtkPlusUsScanConvertInterpolationTable> usedTable = scanConverter1->GetInterpolationTable();
+    scanConverter3 = NULL;
+    if (unusedTable.GetPointer() == NULL)
+    {
+      LOG_ERROR("Interpolation table is released before a new table is added");
+      numberOfErrors++;
+    }
+    // Adding a new table releases the unused tables
+    vtkSmartPointer<vtkPlusUsScanConvertCurvilinear> scanConverter5 = CreateScanConverter(inputImage, true, DEFAULT_RADIUS_STOP_MM + 20.0);
+    if (scanConverter5 == NULL)
+    {
+      return numberOfErrors + 1;
+    }
+    if (unusedTable.GetPointer() != NULL)
+    {
+      LOG_ERROR("Interpolation table that is not used by any scan converter is not released");
+      numberOfErrors++;
+    }
+    if (usedTable.GetPointer() == NULL || usedTable.GetPointer() != scanConverter2->GetInterpolationTable())
+    {
+      LOG_ERROR("Interpolation table that is used by scan converters is released");
+      numberOfErrors++;
+    }
+    LOG_INFO("Number of shared interpolation tables: " << vtkPlusUsScanConvertInterpolationTable::GetNumberOfSharedTables());
+    return numberOfErrors;
+  }
+}
+
+//----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  bool printHelp = false;
+  int verboseLevel = vtkPlusLogger::LOG_LEVEL_UNDEFINED;
+
+  vtksys::CommandLineArguments args;
+  args.Initialize(argc, argv);
+
+  args.AddArgument("--help", vtksys::CommandLineArguments::NO_ARGUMENT, &printHelp, "Print this help.");
+  args.AddArgument("--verbose", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &verboseLevel, "Verbose level (1=error only, 2=warning, 3=info, 4=debug, 5=trace)");
+
+  if (!args.Parse())
+  {
+    std::cerr << "Problem parsing arguments" << std::endl;
+    std::cout << "Help: " << args.GetHelp() << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  if (printHelp)
+  {
+    std::cout << args.GetHelp() << std::endl;
+    exit(EXIT_SUCCESS);
+  }
+
+  vtkPlusLogger::Instance()->SetLogLevel(verboseLevel);
+
+  vtkSmartPointer<vtkImageData> inputImage = CreateBrightnessImage();
+
+  int numberOfErrors = 0;
+  numberOfErrors += CompareExactAndCompactTables(inputImage);
+  numberOfErrors += TestSharedTables(inputImage);
+
+  if (numberOfErrors > 0)
+  {
+    LOG_ERROR("Test failed, number of errors: " << numberOfErrors);
+    return EXIT_FAILURE;
+  }
+
+  LOG_INFO("Test completed successfully");
+  return EXIT_SUCCESS;
+}
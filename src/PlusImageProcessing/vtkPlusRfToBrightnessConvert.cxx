@@ -15,12 +15,262 @@ See License.txt for details.
 #include "vtkStreamingDemandDrivenPipeline.h"
 #include "vtkMath.h"
 
+#include <algorithm>
 #include <math.h>
 
+#ifdef PLUS_SSE2_AVAILABLE
+#include <emmintrin.h>
+#endif
+#ifdef PLUS_AVX2_AVAILABLE
+#include <immintrin.h>
+#endif
+
 vtkStandardNewMacro(vtkPlusRfToBrightnessConvert);
 
-const double MIN_BRIGHTNESS_VALUE=0.0;
-const double MAX_BRIGHTNESS_VALUE=255.0;
+namespace
+{
+  const double MIN_BRIGHTNESS_VALUE=0.0;
+  const double MAX_BRIGHTNESS_VALUE=255.0;
+
+  // Squared amplitude of a sample with -32768 in-phase and quadrature components (largest possible value)
+  const unsigned int MAX_SQUARED_AMPLITUDE=2u*32768u*32768u;
+
+  // Thresholds are stored for brightness values 0..255 and for 256 (never reached), so that the
+  // threshold of the next brightness value can be looked up for any brightness value
+  const int NUMBER_OF_BRIGHTNESS_THRESHOLDS=static_cast<int>(MAX_BRIGHTNESS_VALUE)+2;
+
+  //----------------------------------------------------------------------------
+  // Round to the nearest 16-bit signed integer, with saturation
+  inline short ConvertToShort(double value)
+  {
+    value=floor(value+0.5);
+    if (value>32767.0) value=32767.0;
+    if (value<-32768.0) value=-32768.0;
+    return static_cast<short>(value);
+  }
+
+  //----------------------------------------------------------------------------
+  inline unsigned char ComputeBrightness(double squaredAmplitude, double brightnessScale)
+  {
+    double brightnessValue = sqrt(sqrt(sqrt(squaredAmplitude)))*brightnessScale;
+    if (brightnessValue>MAX_BRIGHTNESS_VALUE) brightnessValue=MAX_BRIGHTNESS_VALUE;
+    if (brightnessValue<MIN_BRIGHTNESS_VALUE) brightnessValue=MIN_BRIGHTNESS_VALUE;
+    return static_cast<unsigned char>(brightnessValue);
+  }
+
+#ifdef PLUS_SSE2_AVAILABLE
+  //----------------------------------------------------------------------------
+  // Convert 2x4 32-bit integers to 8 16-bit integers by keeping the lower 16 bits
+  // (same as the static_cast<short> conversion of the scalar implementation, without saturation)
+  inline __m128i PackLower16Sse2(__m128i a, __m128i b)
+  {
+    a = _mm_srai_epi32(_mm_slli_epi32(a, 16), 16);
+    b = _mm_srai_epi32(_mm_slli_epi32(b, 16), 16);
+    return _mm_packs_epi32(a, b);
+  }
+
+  //----------------------------------------------------------------------------
+  // output[j] = sum(input[j+k]*coeffs[k], k=0..numberOfCoeffs-1), summed in the same order as the scalar implementation
+  void ConvolveSse2(const double* input, const double* coeffs, int numberOfCoeffs, short* output, int numberOfOutputs)
+  {
+    int outputIndex = 0;
+    for (; outputIndex + 8 <= numberOfOutputs; outputIndex += 8)
+    {
+      const double* inputPtr = input + outputIndex;
+      __m128d sum0 = _mm_setzero_pd();
+      __m128d sum1 = _mm_setzero_pd();
+      __m128d sum2 = _mm_setzero_pd();
+      __m128d sum3 = _mm_setzero_pd();
+      for (int k = 0; k < numberOfCoeffs; ++k, ++inputPtr)
+      {
+        __m128d coeff = _mm_set1_pd(coeffs[k]);
+        sum0 = _mm_add_pd(sum0, _mm_mul_pd(_mm_loadu_pd(inputPtr), coeff));
+        sum1 = _mm_add_pd(sum1, _mm_mul_pd(_mm_loadu_pd(inputPtr + 2), coeff));
+        sum2 = _mm_add_pd(sum2, _mm_mul_pd(_mm_loadu_pd(inputPtr + 4), coeff));
+        sum3 = _mm_add_pd(sum3, _mm_mul_pd(_mm_loadu_pd(inputPtr + 6), coeff));
+      }
+      __m128i sum01 = _mm_unpacklo_epi64(_mm_cvttpd_epi32(sum0), _mm_cvttpd_epi32(sum1));
+      __m128i sum23 = _mm_unpacklo_epi64(_mm_cvttpd_epi32(sum2), _mm_cvttpd_epi32(sum3));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(output + outputIndex), PackLower16Sse2(sum01, sum23));
+    }
+    for (; outputIndex < numberOfOutputs; ++outputIndex)
+    {
+      double sum = 0.0;
+      for (int k = 0; k < numberOfCoeffs; ++k)
+      {
+        sum += input[outputIndex + k] * coeffs[k];
+      }
+      output[outputIndex] = static_cast<short>(sum);
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  // Compute brightness of 4 samples from the squared amplitudes (unsigned 32-bit integers), in double precision
+  inline __m128i ComputeBrightnessSse2(__m128i squaredAmplitude, __m128d brightnessScale)
+  {
+    const __m128d signMask = _mm_set1_pd(-0.0);
+    const __m128d minBrightness = _mm_set1_pd(MIN_BRIGHTNESS_VALUE);
+    const __m128d maxBrightness = _mm_set1_pd(MAX_BRIGHTNESS_VALUE);
+    // The only squared amplitude that does not fit into a signed integer is 2^31, which is converted to -2^31,
+    // so taking the absolute value gives the correct result
+    __m128d squaredAmplitudeLow = _mm_andnot_pd(signMask, _mm_cvtepi32_pd(squaredAmplitude));
+    __m128d squaredAmplitudeHigh = _mm_andnot_pd(signMask, _mm_cvtepi32_pd(_mm_unpackhi_epi64(squaredAmplitude, squaredAmplitude)));
+    __m128d brightnessLow = _mm_mul_pd(_mm_sqrt_pd(_mm_sqrt_pd(_mm_sqrt_pd(squaredAmplitudeLow))), brightnessScale);
+    __m128d brightnessHigh = _mm_mul_pd(_mm_sqrt_pd(_mm_sqrt_pd(_mm_sqrt_pd(squaredAmplitudeHigh))), brightnessScale);
+    brightnessLow = _mm_max_pd(_mm_min_pd(brightnessLow, maxBrightness), minBrightness);
+    brightnessHigh = _mm_max_pd(_mm_min_pd(brightnessHigh, maxBrightness), minBrightness);
+    return _mm_unpacklo_epi64(_mm_cvttpd_epi32(brightnessLow), _mm_cvttpd_epi32(brightnessHigh));
+  }
+
+  //----------------------------------------------------------------------------
+  void ComputeBrightnessILineQLineSse2(unsigned char* output, const short* inputSignal, const short* inputSignalHilbertTransformed, int numberOfSamples, double brightnessScale)
+  {
+    const __m128d brightnessScaleVector = _mm_set1_pd(brightnessScale);
+    int sampleIndex = 0;
+    for (; sampleIndex + 8 <= numberOfSamples; sampleIndex += 8)
+    {
+      __m128i i = _mm_loadu_si128(reinterpret_cast<const __m128i*>(inputSignal + sampleIndex));
+      __m128i q = _mm_loadu_si128(reinterpret_cast<const __m128i*>(inputSignalHilbertTransformed + sampleIndex));
+      // Interleave I and Q values, then i*i+q*q is computed exactly by multiply-add
+      __m128i iqLow = _mm_unpacklo_epi16(i, q);
+      __m128i iqHigh = _mm_unpackhi_epi16(i, q);
+      __m128i brightnessLow = ComputeBrightnessSse2(_mm_madd_epi16(iqLow, iqLow), brightnessScaleVector);
+      __m128i brightnessHigh = ComputeBrightnessSse2(_mm_madd_epi16(iqHigh, iqHigh), brightnessScaleVector);
+      __m128i brightness = _mm_packs_epi32(brightnessLow, brightnessHigh);
+      _mm_storel_epi64(reinterpret_cast<__m128i*>(output + sampleIndex), _mm_packus_epi16(brightness, brightness));
+    }
+    for (; sampleIndex < numberOfSamples; ++sampleIndex)
+    {
+      double xt = inputSignal[sampleIndex];
+      double xht = inputSignalHilbertTransformed[sampleIndex];
+      output[sampleIndex] = ComputeBrightness(xt * xt + xht * xht, brightnessScale);
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  void ComputeBrightnessIqLineSse2(unsigned char* output, const short* inputSignal, int numberOfIqPairs, double brightnessScale)
+  {
+    const __m128d brightnessScaleVector = _mm_set1_pd(brightnessScale);
+    int pairIndex = 0;
+    for (; pairIndex + 8 <= numberOfIqPairs; pairIndex += 8)
+    {
+      __m128i iqLow = _mm_loadu_si128(reinterpret_cast<const __m128i*>(inputSignal + 2 * pairIndex));
+      __m128i iqHigh = _mm_loadu_si128(reinterpret_cast<const __m128i*>(inputSignal + 2 * pairIndex + 8));
+      __m128i brightnessLow = ComputeBrightnessSse2(_mm_madd_epi16(iqLow, iqLow), brightnessScaleVector);
+      __m128i brightnessHigh = ComputeBrightnessSse2(_mm_madd_epi16(iqHigh, iqHigh), brightnessScaleVector);
+      __m128i brightness = _mm_packs_epi32(brightnessLow, brightnessHigh);
+      _mm_storel_epi64(reinterpret_cast<__m128i*>(output + pairIndex), _mm_packus_epi16(brightness, brightness));
+    }
+    for (; pairIndex < numberOfIqPairs; ++pairIndex)
+    {
+      double xt = inputSignal[2 * pairIndex];
+      double xht = inputSignal[2 * pairIndex + 1];
+      output[pairIndex] = ComputeBrightness(xt * xt + xht * xht, brightnessScale);
+    }
+  }
+#endif
+
+#ifdef PLUS_AVX2_AVAILABLE
+  //----------------------------------------------------------------------------
+  // output[j] = sum(input[j+k]*coeffs[k], k=0..numberOfCoeffs-1), summed in the same order as the scalar implementation
+  PLUS_TARGET_AVX2 void ConvolveAvx2(const double* input, const double* coeffs, int numberOfCoeffs, short* output, int numberOfOutputs)
+  {
+    int outputIndex = 0;
+    for (; outputIndex + 16 <= numberOfOutputs; outputIndex += 16)
+    {
+      const double* inputPtr = input + outputIndex;
+      __m256d sum0 = _mm256_setzero_pd();
+      __m256d sum1 = _mm256_setzero_pd();
+      __m256d sum2 = _mm256_setzero_pd();
+      __m256d sum3 = _mm256_setzero_pd();
+      for (int k = 0; k < numberOfCoeffs; ++k, ++inputPtr)
+      {
+        __m256d coeff = _mm256_broadcast_sd(coeffs + k);
+        sum0 = _mm256_add_pd(sum0, _mm256_mul_pd(_mm256_loadu_pd(inputPtr), coeff));
+        sum1 = _mm256_add_pd(sum1, _mm256_mul_pd(_mm256_loadu_pd(inputPtr + 4), coeff));
+        sum2 = _mm256_add_pd(sum2, _mm256_mul_pd(_mm256_loadu_pd(inputPtr + 8), coeff));
+        sum3 = _mm256_add_pd(sum3, _mm256_mul_pd(_mm256_loadu_pd(inputPtr + 12), coeff));
+      }
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(output + outputIndex), PackLower16Sse2(_mm256_cvttpd_epi32(sum0), _mm256_cvttpd_epi32(sum1)));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(output + outputIndex + 8), PackLower16Sse2(_mm256_cvttpd_epi32(sum2), _mm256_cvttpd_epi32(sum3)));
+    }
+    // Remaining outputs
+    ConvolveSse2(input + outputIndex, coeffs, numberOfCoeffs, output + outputIndex, numberOfOutputs - outputIndex);
+  }
+
+  //----------------------------------------------------------------------------
+  // Compute brightness of 8 samples from the squared amplitudes (unsigned 32-bit integers).
+  // The eighth root is computed in single precision, which may differ from the double precision result by one brightness
+  // value near the thresholds, so the result is corrected by comparing the squared amplitude to the exact thresholds.
+  PLUS_TARGET_AVX2 inline __m256i ComputeBrightnessAvx2(__m256i squaredAmplitude, __m256 brightnessScale, const int* brightnessThresholds)
+  {
+    const __m256 signMask = _mm256_set1_ps(-0.0f);
+    const __m256 minBrightness = _mm256_set1_ps(static_cast<float>(MIN_BRIGHTNESS_VALUE));
+    const __m256 maxBrightness = _mm256_set1_ps(static_cast<float>(MAX_BRIGHTNESS_VALUE));
+    const __m256i signBit = _mm256_set1_epi32(static_cast<int>(0x80000000u));
+    const __m256i one = _mm256_set1_epi32(1);
+    // 2^31 is converted to -2^31, taking the absolute value gives the correct result
+    __m256 squaredAmplitudeFloat = _mm256_andnot_ps(signMask, _mm256_cvtepi32_ps(squaredAmplitude));
+    __m256 brightnessFloat = _mm256_mul_ps(_mm256_sqrt_ps(_mm256_sqrt_ps(_mm256_sqrt_ps(squaredAmplitudeFloat))), brightnessScale);
+    brightnessFloat = _mm256_max_ps(_mm256_min_ps(brightnessFloat, maxBrightness), minBrightness);
+    __m256i brightness = _mm256_cvttps_epi32(brightnessFloat);
+    // brightness = brightness - (squaredAmplitude < threshold[brightness]) + (squaredAmplitude >= threshold[brightness+1])
+    __m256i squaredAmplitudeSigned = _mm256_xor_si256(squaredAmplitude, signBit);
+    __m256i thresholdLow = _mm256_i32gather_epi32(brightnessThresholds, brightness, 4);
+    __m256i thresholdHigh = _mm256_i32gather_epi32(brightnessThresholds + 1, brightness, 4);
+    __m256i belowLow = _mm256_cmpgt_epi32(thresholdLow, squaredAmplitudeSigned);
+    __m256i belowHigh = _mm256_cmpgt_epi32(thresholdHigh, squaredAmplitudeSigned);
+    return _mm256_add_epi32(_mm256_add_epi32(brightness, belowLow), _mm256_add_epi32(one, belowHigh));
+  }
+
+  //----------------------------------------------------------------------------
+  PLUS_TARGET_AVX2 void ComputeBrightnessILineQLineAvx2(unsigned char* output, const short* inputSignal, const short* inputSignalHilbertTransformed, int numberOfSamples, double brightnessScale, const int* brightnessThresholds)
+  {
+    const __m256 brightnessScaleVector = _mm256_set1_ps(static_cast<float>(brightnessScale));
+    int sampleIndex = 0;
+    for (; sampleIndex + 16 <= numberOfSamples; sampleIndex += 16)
+    {
+      __m256i i = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(inputSignal + sampleIndex));
+      __m256i q = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(inputSignalHilbertTransformed + sampleIndex));
+      // Interleaving is done within 128-bit lanes: iqLow contains samples 0-3 and 8-11, iqHigh contains samples 4-7 and 12-15
+      __m256i iqLow = _mm256_unpacklo_epi16(i, q);
+      __m256i iqHigh = _mm256_unpackhi_epi16(i, q);
+      __m256i brightnessLow = ComputeBrightnessAvx2(_mm256_madd_epi16(iqLow, iqLow), brightnessScaleVector, brightnessThresholds);
+      __m256i brightnessHigh = ComputeBrightnessAvx2(_mm256_madd_epi16(iqHigh, iqHigh), brightnessScaleVector, brightnessThresholds);
+      // Packing within 128-bit lanes restores the sample order: samples 0-7 in the lower lane, 8-15 in the upper lane
+      __m256i brightness = _mm256_packs_epi32(brightnessLow, brightnessHigh);
+      brightness = _mm256_packus_epi16(brightness, brightness);
+      brightness = _mm256_permute4x64_epi64(brightness, 0x08);
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(output + sampleIndex), _mm256_castsi256_si128(brightness));
+    }
+    // Remaining samples
+    ComputeBrightnessILineQLineSse2(output + sampleIndex, inputSignal + sampleIndex, inputSignalHilbertTransformed + sampleIndex, numberOfSamples - sampleIndex, brightnessScale);
+  }
+
+  //----------------------------------------------------------------------------
+  PLUS_TARGET_AVX2 void ComputeBrightnessIqLineAvx2(unsigned char* output, const short* inputSignal, int numberOfIqPairs, double brightnessScale, const int* brightnessThresholds)
+  {
+    const __m256 brightnessScaleVector = _mm256_set1_ps(static_cast<float>(brightnessScale));
+    int pairIndex = 0;
+    for (; pairIndex + 16 <= numberOfIqPairs; pairIndex += 16)
+    {
+      __m256i iqLow = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(inputSignal + 2 * pairIndex));
+      __m256i iqHigh = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(inputSignal + 2 * pairIndex + 16));
+      __m256i brightnessLow = ComputeBrightnessAvx2(_mm256_madd_epi16(iqLow, iqLow), brightnessScaleVector, brightnessThresholds);
+      __m256i brightnessHigh = ComputeBrightnessAvx2(_mm256_madd_epi16(iqHigh, iqHigh), brightnessScaleVector, brightnessThresholds);
+      // Packing within 128-bit lanes gives pairs 0-3, 8-11, 4-7, 12-15, reorder them before packing to bytes
+      __m256i brightness = _mm256_packs_epi32(brightnessLow, brightnessHigh);
+      brightness = _mm256_permute4x64_epi64(brightness, 0xD8);
+      brightness = _mm256_packus_epi16(brightness, brightness);
+      brightness = _mm256_permute4x64_epi64(brightness, 0x08);
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(output + pairIndex), _mm256_castsi256_si128(brightness));
+    }
+    // Remaining samples
+    ComputeBrightnessIqLineSse2(output + pairIndex, inputSignal + 2 * pairIndex, numberOfIqPairs - pairIndex, brightnessScale);
+  }
+#endif
+}
+
 
 //----------------------------------------------------------------------------
 vtkPlusRfToBrightnessConvert::vtkPlusRfToBrightnessConvert()
@@ -28,6 +278,9 @@ vtkPlusRfToBrightnessConvert::vtkPlusRfToBrightnessConvert()
   this->ImageType=US_IMG_TYPE_XX;
   this->BrightnessScale=10.0;
   this->NumberOfHilbertFilterCoeffs=64;
+  this->BrightnessThresholdsScale=0.0;
+  this->EnableSimd=true;
+  this->HilbertTransformMethod=HILBERT_TRANSFORM_FIR;
 }
 
 //----------------------------------------------------------------------------
@@ -101,6 +354,29 @@ int vtkPlusRfToBrightnessConvert::RequestInformation(vtkInformation*,
   return 1;
 }
 
+//----------------------------------------------------------------------------
+int vtkPlusRfToBrightnessConvert::RequestData(vtkInformation* request,
+                                              vtkInformationVector** inputVector,
+                                              vtkInformationVector* outputVector)
+{
+  // Compute the coefficients and lookup tables here, so that the threads only read them
+  this->ComputeHilbertTransformCoeffs();
+  this->ComputeBrightnessThresholds();
+  if (this->HilbertTransformMethod==HILBERT_TRANSFORM_FFT && this->ImageType==US_IMG_RF_REAL)
+  {
+    // The FFT plan and the scratch buffers are only updated if the scanline length or the number of threads changes
+    int inExt[6]={0};
+    inputVector[0]->GetInformationObject(0)->Get(vtkStreamingDemandDrivenPipeline::WHOLE_EXTENT(), inExt);
+    if (this->HilbertTransformFft.SetLength(PlusFft::GetPowerOfTwoLength(inExt[1]-inExt[0]+1))!=PLUS_SUCCESS)
+    {
+      vtkErrorMacro("Failed to prepare FFT for Hilbert transform");
+      return 0;
+    }
+    this->HilbertTransformFftBuffers.resize(this->GetNumberOfThreads());
+  }
+  return this->Superclass::RequestData(request, inputVector, outputVector);
+}
+
 //----------------------------------------------------------------------------
 void vtkPlusRfToBrightnessConvert::ThreadedRequestData(
   vtkInformation *vtkNotUsed(request),
@@ -152,6 +428,10 @@ void vtkPlusRfToBrightnessConvert::ThreadedRequestData(
   outData[0]->GetContinuousIncrements(outExt, outInc0, outInc1, outInc2);  
   unsigned char *outPtr = static_cast<unsigned char*>(outData[0]->GetScalarPointerForExtent(outExt));
 
+  // The brightness thresholds are computed in RequestData, the threads only read them
+  const double brightnessScale=this->BrightnessThresholdsScale;
+  const int *brightnessThresholds=&this->BrightnessThresholds[0];
+
   int inExt[6]={outExt[0], outExt[1], outExt[2], outExt[3], outExt[4], outExt[5]};
   // Get the input extent for the output extent
   switch (this->ImageType)
@@ -206,6 +486,20 @@ void vtkPlusRfToBrightnessConvert::ThreadedRequestData(
   int numberOfRfSamplesInScanline=inExt[1]-inExt[0]+1;
   int numberOfBmodeSamplesInScanline=outExt[1]-outExt[0]+1;
   short* hilbertTransformBuffer=new short[numberOfRfSamplesInScanline+1];
+  // The FFT method computes the Hilbert transform of two scanlines at once
+  short* secondHilbertTransformBuffer=NULL;
+  std::vector<double> localFftBuffer;
+  std::vector<double>* fftBuffer=&localFftBuffer;
+  // Switched off if the FFT fails, then the rest of the extent is processed by the FIR filter
+  bool useFftHilbertTransform=(this->HilbertTransformMethod==HILBERT_TRANSFORM_FFT);
+  if (useFftHilbertTransform && this->ImageType==US_IMG_RF_REAL)
+  {
+    secondHilbertTransformBuffer=new short[numberOfRfSamplesInScanline+1];
+    if (id>=0 && id<static_cast<int>(this->HilbertTransformFftBuffers.size()))
+    {
+      fftBuffer=&this->HilbertTransformFftBuffers[id];
+    }
+  }
   /*
   std::vector<short> hilbertTransformBuffer;
   hilbertTransformBuffer.resize(numberOfSamplesInScanline);
@@ -265,7 +559,7 @@ void vtkPlusRfToBrightnessConvert::ThreadedRequestData(
           inPtr += numberOfRfSamplesInScanline+inInc1;
           short *phaseShiftedSignal=inPtr;
           inPtr += numberOfRfSamplesInScanline+inInc1;
-          ComputeAmplitudeILineQLine(outPtr, originalSignal, phaseShiftedSignal, numberOfRfSamplesInScanline);
+          ComputeAmplitudeILineQLine(outPtr, originalSignal, phaseShiftedSignal, numberOfRfSamplesInScanline, brightnessScale, brightnessThresholds);
           outPtr += numberOfBmodeSamplesInScanline+outInc1;
           //inPtr += 2*(numberOfRfSamplesInScanline+inInc1);
           
@@ -275,16 +569,46 @@ void vtkPlusRfToBrightnessConvert::ThreadedRequestData(
         {
           // e.g., Ultrasonix
           // RF data: IIIII..., IIIII...
-          ComputeHilbertTransform(hilbertTransformBuffer, inPtr, numberOfRfSamplesInScanline);
-          ComputeAmplitudeILineQLine(outPtr, inPtr, hilbertTransformBuffer, numberOfRfSamplesInScanline);
-          inPtr += numberOfRfSamplesInScanline+inInc1;
-          outPtr += numberOfBmodeSamplesInScanline+outInc1;
+          // Transform the next scanline of the slice together with this one
+          short* secondInPtr=NULL;
+          if (useFftHilbertTransform)
+          {
+            if (idx1<outExt[3])
+            {
+              secondInPtr=inPtr+numberOfRfSamplesInScanline+inInc1;
+            }
+            if (ComputeHilbertTransformFft(hilbertTransformBuffer, inPtr, secondHilbertTransformBuffer, secondInPtr, numberOfRfSamplesInScanline, *fftBuffer)!=PLUS_SUCCESS)
+            {
+              LOG_ERROR("FFT Hilbert transform failed, the FIR filter is used for the rest of the image extent");
+              useFftHilbertTransform=false;
+            }
+          }
+          if (useFftHilbertTransform)
+          {
+            ComputeAmplitudeSamples(outPtr, inPtr, hilbertTransformBuffer, numberOfRfSamplesInScanline, brightnessScale, brightnessThresholds);
+            inPtr += numberOfRfSamplesInScanline+inInc1;
+            outPtr += numberOfBmodeSamplesInScanline+outInc1;
+            if (secondInPtr!=NULL)
+            {
+              ComputeAmplitudeSamples(outPtr, inPtr, secondHilbertTransformBuffer, numberOfRfSamplesInScanline, brightnessScale, brightnessThresholds);
+              inPtr += numberOfRfSamplesInScanline+inInc1;
+              outPtr += numberOfBmodeSamplesInScanline+outInc1;
+              ++idx1;
+            }
+          }
+          else
+          {
+            ComputeHilbertTransform(hilbertTransformBuffer, inPtr, numberOfRfSamplesInScanline);
+            ComputeAmplitudeILineQLine(outPtr, inPtr, hilbertTransformBuffer, numberOfRfSamplesInScanline, brightnessScale, brightnessThresholds);
+            inPtr += numberOfRfSamplesInScanline+inInc1;
+            outPtr += numberOfBmodeSamplesInScanline+outInc1;
+          }
         }
         break;
       case US_IMG_RF_IQ_LINE:
         {
           // RF data: IQIQIQ....., IQIQIQIQ.....
-          ComputeAmplitudeIqLine(outPtr, inPtr, numberOfRfSamplesInScanline);
+          ComputeAmplitudeIqLine(outPtr, inPtr, numberOfRfSamplesInScanline, brightnessScale, brightnessThresholds);
           inPtr += numberOfRfSamplesInScanline+inInc1;
           outPtr += numberOfBmodeSamplesInScanline+outInc1;
         }
@@ -303,6 +627,8 @@ void vtkPlusRfToBrightnessConvert::ThreadedRequestData(
 
   delete[] hilbertTransformBuffer;
   hilbertTransformBuffer=NULL;
+  delete[] secondHilbertTransformBuffer;
+  secondHilbertTransformBuffer=NULL;
 }
 
 void vtkPlusRfToBrightnessConvert::PrintSelf(ostream& os, vtkIndent indent)
@@ -317,6 +643,9 @@ PlusStatus vtkPlusRfToBrightnessConvert::ReadConfiguration(vtkXMLDataElement* rf
   XML_VERIFY_ELEMENT(rfToBrightnessElement, "RfToBrightnessConversion");
   XML_READ_SCALAR_ATTRIBUTE_OPTIONAL(int, NumberOfHilbertFilterCoeffs, rfToBrightnessElement);
   XML_READ_SCALAR_ATTRIBUTE_OPTIONAL(double, BrightnessScale, rfToBrightnessElement);
+  XML_READ_ENUM2_ATTRIBUTE_OPTIONAL(HilbertTransformMethod, rfToBrightnessElement,
+    GetHilbertTransformMethodAsString(HILBERT_TRANSFORM_FIR), HILBERT_TRANSFORM_FIR,
+    GetHilbertTransformMethodAsString(HILBERT_TRANSFORM_FFT), HILBERT_TRANSFORM_FFT);
   return PLUS_SUCCESS;
 }
 
@@ -329,10 +658,26 @@ PlusStatus vtkPlusRfToBrightnessConvert::WriteConfiguration(vtkXMLDataElement* r
 
   rfToBrightnessElement->SetDoubleAttribute("NumberOfHilbertFilterCoeffs", this->NumberOfHilbertFilterCoeffs);
   rfToBrightnessElement->SetDoubleAttribute("BrightnessScale", this->BrightnessScale);
+  rfToBrightnessElement->SetAttribute("HilbertTransformMethod", GetHilbertTransformMethodAsString(this->HilbertTransformMethod));
 
   return PLUS_SUCCESS;
 }
 
+//-----------------------------------------------------------------------------
+const char* vtkPlusRfToBrightnessConvert::GetHilbertTransformMethodAsString(HilbertTransformMethodType method)
+{
+  switch (method)
+  {
+  case HILBERT_TRANSFORM_FIR:
+    return "FIR";
+  case HILBERT_TRANSFORM_FFT:
+    return "FFT";
+  default:
+    LOG_ERROR("Unknown Hilbert transform method: " << method);
+    return "unknown";
+  }
+}
+
 //-----------------------------------------------------------------------------
 void vtkPlusRfToBrightnessConvert::ComputeHilbertTransformCoeffs()
 {
@@ -343,10 +688,12 @@ void vtkPlusRfToBrightnessConvert::ComputeHilbertTransformCoeffs()
   }
 
   this->HilbertTransformCoeffs.resize(this->NumberOfHilbertFilterCoeffs+1);
+  this->HilbertTransformCoeffsReversed.resize(this->NumberOfHilbertFilterCoeffs);
   for (int i=1; i<=this->NumberOfHilbertFilterCoeffs; i++)
   {
     // From http://www.vbforums.com/archive/index.php/t-639223.html
     this->HilbertTransformCoeffs[i]=1/((i-this->NumberOfHilbertFilterCoeffs/2)-0.5)/vtkMath::Pi();
+    this->HilbertTransformCoeffsReversed[this->NumberOfHilbertFilterCoeffs-i]=this->HilbertTransformCoeffs[i];
   }
   
   bool debugOutput=false; // print Hilbert transform coefficients in Matlab format
@@ -369,6 +716,62 @@ void vtkPlusRfToBrightnessConvert::ComputeHilbertTransformCoeffs()
   }
 }
 
+//-----------------------------------------------------------------------------
+void vtkPlusRfToBrightnessConvert::ComputeBrightnessThresholds()
+{
+  if (static_cast<int>(this->BrightnessThresholds.size())==NUMBER_OF_BRIGHTNESS_THRESHOLDS && this->BrightnessThresholdsScale==this->BrightnessScale)
+  {
+    // already computed for the current brightness scale
+    return;
+  }
+
+  this->BrightnessThresholds.resize(NUMBER_OF_BRIGHTNESS_THRESHOLDS);
+  for (int brightness=0; brightness<NUMBER_OF_BRIGHTNESS_THRESHOLDS; brightness++)
+  {
+    // Brightness is a monotonic function of the squared amplitude, so the threshold can be found by binary search
+    unsigned int threshold=0xFFFFFFFF; // brightness value cannot be reached
+    if (ComputeBrightness(MAX_SQUARED_AMPLITUDE, this->BrightnessScale)>=brightness)
+    {
+      unsigned int low=0;
+      unsigned int high=MAX_SQUARED_AMPLITUDE;
+      while (low<high)
+      {
+        unsigned int middle=low+(high-low)/2;
+        if (ComputeBrightness(middle, this->BrightnessScale)>=brightness)
+        {
+          high=middle;
+        }
+        else
+        {
+          low=middle+1;
+        }
+      }
+      threshold=low;
+    }
+    this->BrightnessThresholds[brightness]=static_cast<int>(threshold^0x80000000u);
+  }
+  this->BrightnessThresholdsScale=this->BrightnessScale;
+}
+
+//-----------------------------------------------------------------------------
+vtkPlusRfToBrightnessConvert::SimdInstructionSet vtkPlusRfToBrightnessConvert::GetSimdInstructionSet()
+{
+  if (!this->EnableSimd)
+  {
+    return SIMD_NONE;
+  }
+  if (PlusCommon::IsAvx2Supported())
+  {
+    return SIMD_AVX2;
+  }
+  if (PlusCommon::IsSse2Supported())
+  {
+    return SIMD_SSE2;
+  }
+  return SIMD_NONE;
+}
+
+//-----------------------------------------------------------------------------
 PlusStatus vtkPlusRfToBrightnessConvert::ComputeHilbertTransform(short *hilbertTransformOutput, short *input, int npt)
 {
   ComputeHilbertTransformCoeffs(); // update the transform coefficients if needed
@@ -380,14 +783,37 @@ PlusStatus vtkPlusRfToBrightnessConvert::ComputeHilbertTransform(short *hilbertT
   }
 
   // Compute Hilbert transform by convolution
-  for (int l=1; l<=npt-this->NumberOfHilbertFilterCoeffs+1; l++) 
+  switch (this->GetSimdInstructionSet())
   {
-    double yt = 0.0;
-    for (int i=1; i<=this->NumberOfHilbertFilterCoeffs; i++) 
+#ifdef PLUS_AVX2_AVAILABLE
+  case SIMD_AVX2:
+    {
+      // Samples are converted to double only once, as each of them is multiplied by all the coefficients
+      std::vector<double> inputSamples(input+1, input+npt+1);
+      ConvolveAvx2(&inputSamples[0], &this->HilbertTransformCoeffsReversed[0], this->NumberOfHilbertFilterCoeffs,
+        hilbertTransformOutput+1, npt-this->NumberOfHilbertFilterCoeffs+1);
+    }
+    break;
+#endif
+#ifdef PLUS_SSE2_AVAILABLE
+  case SIMD_SSE2:
     {
-      yt += input[l+i-1]*this->HilbertTransformCoeffs[this->NumberOfHilbertFilterCoeffs+1-i];
+      std::vector<double> inputSamples(input+1, input+npt+1);
+      ConvolveSse2(&inputSamples[0], &this->HilbertTransformCoeffsReversed[0], this->NumberOfHilbertFilterCoeffs,
+        hilbertTransformOutput+1, npt-this->NumberOfHilbertFilterCoeffs+1);
+    }
+    break;
+#endif
+  default:
+    for (int l=1; l<=npt-this->NumberOfHilbertFilterCoeffs+1; l++) 
+    {
+      double yt = 0.0;
+      for (int i=1; i<=this->NumberOfHilbertFilterCoeffs; i++) 
+      {
+        yt += input[l+i-1]*this->HilbertTransformCoeffs[this->NumberOfHilbertFilterCoeffs+1-i];
+      }
+      hilbertTransformOutput[l] = yt;
     }
-    hilbertTransformOutput[l] = yt;
   }
 
   // Shift this->NumberOfHilbertFilterCoeffs/1+1/2 points
@@ -410,48 +836,142 @@ PlusStatus vtkPlusRfToBrightnessConvert::ComputeHilbertTransform(short *hilbertT
   return PLUS_SUCCESS;
 }
 
-void vtkPlusRfToBrightnessConvert::ComputeAmplitudeILineQLine(unsigned char *ampl, short *inputSignal, short *inputSignalHilbertTransformed, int npt)
+//-----------------------------------------------------------------------------
+PlusStatus vtkPlusRfToBrightnessConvert::ComputeHilbertTransformFft(short *hilbertTransformOutput1, short *input1, short *hilbertTransformOutput2, short *input2, int npt, std::vector<double>& scratchBuffer)
 {
-  for (int i=0; i<this->NumberOfHilbertFilterCoeffs/2+1; i++)
+  unsigned int fftLength=this->HilbertTransformFft.GetLength();
+  if (npt<1 || fftLength!=PlusFft::GetPowerOfTwoLength(npt))
   {
-    ampl[i]=0;
+    LOG_ERROR("FFT is not prepared for Hilbert transform of "<<npt<<" samples");
+    return PLUS_FAIL;
   }
-  for (int i=this->NumberOfHilbertFilterCoeffs/2+1; i<=npt-this->NumberOfHilbertFilterCoeffs/2; i++) 
+  scratchBuffer.resize(2*fftLength);
+  double* signal=&scratchBuffer[0];
+
+  // The two real signals are transformed as the real and imaginary part of one complex signal: z = x1 + j*x2
+  for (int i=0; i<npt; i++)
   {
-    double xt = inputSignal[i];
-    double xht = inputSignalHilbertTransformed[i];
-    double brightnessValue = sqrt(sqrt(sqrt(xt*xt+xht*xht)))*this->BrightnessScale;
-    if (brightnessValue>MAX_BRIGHTNESS_VALUE) brightnessValue=MAX_BRIGHTNESS_VALUE;
-    if (brightnessValue<MIN_BRIGHTNESS_VALUE) brightnessValue=MIN_BRIGHTNESS_VALUE;
-    ampl[i]=brightnessValue;
-    /*
-    If needed, the phase could be computed as follows:
-    phase[i] = atan2(xht ,xt);
-    omega[i] = phase[i]-phase[i-1];
-    if (omega[i]<0)
+    signal[2*i]=input1[i];
+    signal[2*i+1]=(input2!=NULL ? input2[i] : 0.0);
+  }
+  std::fill(signal+2*npt, signal+2*fftLength, 0.0);
+  this->HilbertTransformFft.Transform(signal);
+
+  // Keep only the positive frequencies: the inverse transform is then the analytic signal, which is
+  // a1 + j*a2 = (x1 + j*h1) + j*(x2 + j*h2) = (x1 - h2) + j*(x2 + h1) (h1, h2: Hilbert transforms of x1, x2)
+  for (unsigned int i=1; i<fftLength/2; i++)
+  {
+    signal[2*i]*=2.0;
+    signal[2*i+1]*=2.0;
+  }
+  if (fftLength>1)
+  {
+    std::fill(signal+fftLength+2, signal+2*fftLength, 0.0);
+  }
+  this->HilbertTransformFft.InverseTransform(signal);
+
+  for (int i=0; i<npt; i++)
+  {
+    hilbertTransformOutput1[i]=ConvertToShort(signal[2*i+1]-(input2!=NULL ? input2[i] : 0.0));
+  }
+  if (input2!=NULL && hilbertTransformOutput2!=NULL)
+  {
+    for (int i=0; i<npt; i++)
     {
-      omega[i]+=2*pi;
+      hilbertTransformOutput2[i]=ConvertToShort(input1[i]-signal[2*i]);
     }
-    */
   }
+  return PLUS_SUCCESS;
+}
+
+//-----------------------------------------------------------------------------
+void vtkPlusRfToBrightnessConvert::ComputeAmplitudeILineQLine(unsigned char *ampl, short *inputSignal, short *inputSignalHilbertTransformed, int npt, double brightnessScale, const int *brightnessThresholds)
+{
+  for (int i=0; i<this->NumberOfHilbertFilterCoeffs/2+1; i++)
+  {
+    ampl[i]=0;
+  }
+  int firstSample=this->NumberOfHilbertFilterCoeffs/2+1;
+  int numberOfSamples=npt-this->NumberOfHilbertFilterCoeffs/2-firstSample+1;
+  ComputeAmplitudeSamples(ampl+firstSample, inputSignal+firstSample, inputSignalHilbertTransformed+firstSample, numberOfSamples, brightnessScale, brightnessThresholds);
   for (int i=npt-this->NumberOfHilbertFilterCoeffs/2+1; i<npt; i++)
   {
     ampl[i]=0;
   }
 }
 
-void vtkPlusRfToBrightnessConvert::ComputeAmplitudeIqLine(unsigned char *ampl, short *inputSignal, const int npt)
+//-----------------------------------------------------------------------------
+void vtkPlusRfToBrightnessConvert::ComputeAmplitudeSamples(unsigned char *ampl, short *inputSignal, short *inputSignalHilbertTransformed, int numberOfSamples, double brightnessScale, const int *brightnessThresholds)
+{
+  if (numberOfSamples<=0)
+  {
+    return;
+  }
+#ifndef PLUS_AVX2_AVAILABLE
+  (void)brightnessThresholds; // only used by the AVX2 implementation
+#endif
+  switch (this->GetSimdInstructionSet())
+  {
+#ifdef PLUS_AVX2_AVAILABLE
+  case SIMD_AVX2:
+    ComputeBrightnessILineQLineAvx2(ampl, inputSignal, inputSignalHilbertTransformed,
+      numberOfSamples, brightnessScale, brightnessThresholds);
+    break;
+#endif
+#ifdef PLUS_SSE2_AVAILABLE
+  case SIMD_SSE2:
+    ComputeBrightnessILineQLineSse2(ampl, inputSignal, inputSignalHilbertTransformed,
+      numberOfSamples, brightnessScale);
+    break;
+#endif
+  default:
+    for (int i=0; i<numberOfSamples; i++) 
+    {
+      double xt = inputSignal[i];
+      double xht = inputSignalHilbertTransformed[i];
+      ampl[i]=ComputeBrightness(xt*xt+xht*xht, brightnessScale);
+      /*
+      If needed, the phase could be computed as follows:
+      phase[i] = atan2(xht ,xt);
+      omega[i] = phase[i]-phase[i-1];
+      if (omega[i]<0)
+      {
+        omega[i]+=2*pi;
+      }
+      */
+    }
+  }
+}
+
+//-----------------------------------------------------------------------------
+void vtkPlusRfToBrightnessConvert::ComputeAmplitudeIqLine(unsigned char *ampl, short *inputSignal, const int npt, double brightnessScale, const int *brightnessThresholds)
 {
-  int inputIndex=0;
-  int outputIndex=0;
   int numberOfIqPairs=floor(double(npt)/2);
-  for (int i=0; i<numberOfIqPairs; i++) 
-  {
-    double xt = inputSignal[inputIndex++];
-    double xht = inputSignal[inputIndex++];
-    double outputValue=sqrt(sqrt(sqrt(xt*xt+xht*xht)))*this->BrightnessScale;
-    if (outputValue>MAX_BRIGHTNESS_VALUE) outputValue=MAX_BRIGHTNESS_VALUE;
-    if (outputValue<MIN_BRIGHTNESS_VALUE) outputValue=MIN_BRIGHTNESS_VALUE;
-    ampl[outputIndex++] = outputValue;
+#ifndef PLUS_AVX2_AVAILABLE
+  (void)brightnessThresholds; // only used by the AVX2 implementation
+#endif
+  switch (this->GetSimdInstructionSet())
+  {
+#ifdef PLUS_AVX2_AVAILABLE
+  case SIMD_AVX2:
+    ComputeBrightnessIqLineAvx2(ampl, inputSignal, numberOfIqPairs, brightnessScale, brightnessThresholds);
+    break;
+#endif
+#ifdef PLUS_SSE2_AVAILABLE
+  case SIMD_SSE2:
+    ComputeBrightnessIqLineSse2(ampl, inputSignal, numberOfIqPairs, brightnessScale);
+    break;
+#endif
+  default:
+    {
+      int inputIndex=0;
+      int outputIndex=0;
+      for (int i=0; i<numberOfIqPairs; i++) 
+      {
+        double xt = inputSignal[inputIndex++];
+        double xht = inputSignal[inputIndex++];
+        ampl[outputIndex++] = ComputeBrightness(xt*xt+xht*xht, brightnessScale);
+      }
+    }
   }
 }
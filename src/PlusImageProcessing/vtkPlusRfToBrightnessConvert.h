@@ -10,6 +10,7 @@
 #include "vtkPlusImageProcessingExport.h"
 #include "vtkThreadedImageAlgorithm.h"
 #include "PlusVideoFrame.h" // for US_IMAGE_TYPE
+#include "PlusFft.h"
 
 /*!
 \class vtkPlusRfToBrightnessConvert
@@ -32,6 +33,23 @@ range (16 bits).
 The input image type must be VTK_SHORT (signed 16-bit) and the output image type
 is always VTK_UNSIGNED_CHAR (unsigned 8-bit).
 
+The Hilbert transform and the brightness computation use SSE2 or AVX2 instructions if the processor
+supports them (see EnableSimd). The vectorized computation gives exactly the same result as the scalar one:
+the Hilbert transform filter uses double precision in the same summation order, while the eighth root
+of the squared amplitude is approximated in single precision and then corrected by a lookup table that
+stores the smallest squared amplitude for each brightness value (BrightnessThresholds).
+
+For RF_REAL data the Hilbert transform can be computed either by a FIR filter (default) or by FFT
+(HilbertTransformMethod="FFT" attribute). The FIR filter cost is proportional to the number of filter
+coefficients and the filter is less accurate at low frequencies; the first and last
+NumberOfHilbertFilterCoeffs/2 samples of each scanline are set to zero. The FFT method computes the exact
+analytic signal of the whole scanline (zero-padded to the next power of two length) and processes two
+scanlines with one complex transform, so its cost only depends on the scanline length.
+With the default 64 filter coefficients, the FFT method is faster than the scalar FIR filter for all
+scanline lengths, but the vectorized FIR filter is faster than the FFT method. The FFT method is faster than
+the vectorized FIR filter if more than about 200 filter coefficients would be needed.
+vtkPlusRfToBrightnessConvertTest reports the measured speed for various scanline lengths.
+
 \ingroup PlusLibImageProcessingAlgo
 */ 
 class vtkPlusImageProcessingExport vtkPlusRfToBrightnessConvert : public vtkThreadedImageAlgorithm
@@ -47,6 +65,13 @@ public:
   /*! Write configuration to xml data. The rfToBrightnessElement is typically in DataCollction/ImageAcquisition/RfProcessing. */
   virtual PlusStatus WriteConfiguration(vtkXMLDataElement* rfToBrightnessElement); 
 
+  /*! Methods for computing the Hilbert transform of RF_REAL data */
+  enum HilbertTransformMethodType
+  {
+    HILBERT_TRANSFORM_FIR,
+    HILBERT_TRANSFORM_FFT
+  };
+
   /*! Specify image type (RF data encoding type) */
   vtkSetMacro(ImageType, US_IMAGE_TYPE);
   vtkGetMacro(ImageType, US_IMAGE_TYPE);
@@ -57,6 +82,20 @@ public:
   vtkSetMacro(BrightnessScale, double);
   vtkGetMacro(BrightnessScale, double);
 
+  /*! Method for computing the Hilbert transform of RF_REAL data (FIR filter by default) */
+  vtkSetMacro(HilbertTransformMethod, HilbertTransformMethodType);
+  vtkGetMacro(HilbertTransformMethod, HilbertTransformMethodType);
+  /*! Get the name of a Hilbert transform method, as used in the configuration file */
+  static const char* GetHilbertTransformMethodAsString(HilbertTransformMethodType method);
+
+  /*!
+    Use SSE2 or AVX2 instructions (selected at runtime based on the processor capabilities).
+    The results are the same as without SIMD instructions. Enabled by default.
+  */
+  vtkSetMacro(EnableSimd, bool);
+  vtkGetMacro(EnableSimd, bool);
+  vtkBooleanMacro(EnableSimd, bool);
+
 protected:
   vtkPlusRfToBrightnessConvert();
   ~vtkPlusRfToBrightnessConvert();
@@ -65,6 +104,11 @@ protected:
                                  vtkInformationVector**,
                                  vtkInformationVector* outputVector);
 
+  /*! Updates the filter coefficients and lookup tables that are shared by all the threads, then processes the image */
+  virtual int RequestData(vtkInformation* request,
+                          vtkInformationVector** inputVector,
+                          vtkInformationVector* outputVector) VTK_OVERRIDE;
+
   void ThreadedRequestData( vtkInformation *request,
                             vtkInformationVector **inputVector,
                             vtkInformationVector *outputVector,
@@ -74,14 +118,44 @@ protected:
   /*! Compute the Hilbert transform coefficients. Used by the ComputeHilbertTransform method. */
   virtual void ComputeHilbertTransformCoeffs();
 
+  /*!
+    Compute the squared amplitude threshold of each brightness value for the current BrightnessScale. Used by the vectorized brightness computation.
+    Called from RequestData, before the threads start, because it modifies BrightnessThresholds.
+  */
+  virtual void ComputeBrightnessThresholds();
+
+  /*! SIMD instruction sets that can be used for the computation */
+  enum SimdInstructionSet
+  {
+    SIMD_NONE,
+    SIMD_SSE2,
+    SIMD_AVX2
+  };
+
+  /*! Get the best SIMD instruction set that the processor supports (SIMD_NONE if EnableSimd is false) */
+  SimdInstructionSet GetSimdInstructionSet();
+
   /*! Compute the Hilbert transform (90 deg phase shift) of a signal */
   virtual PlusStatus ComputeHilbertTransform(short *hilbertTransformOutput, short *input, int npt);
+
+  /*!
+    Compute the Hilbert transform of one or two signals by FFT. The second input may be NULL.
+    Unlike ComputeHilbertTransform, the output arrays are 0-based and all the npt output values are valid.
+    The FFT plan must be prepared for npt samples (see RequestData), scratchBuffer is resized as needed.
+  */
+  virtual PlusStatus ComputeHilbertTransformFft(short *hilbertTransformOutput1, short *input1, short *hilbertTransformOutput2, short *input2, int npt, std::vector<double>& scratchBuffer);
   
-  /*! Compute amplitude from the original and Hilbert transformed RF data. npt is the number of samples in the input signal */
-  virtual void ComputeAmplitudeILineQLine(unsigned char *ampl, short *inputSignal, short *inputSignalHilbertTransformed, int npt);
+  /*!
+    Compute amplitude from the original and Hilbert transformed RF data. npt is the number of samples in the input signal.
+    brightnessThresholds must be computed for brightnessScale (see ComputeBrightnessThresholds), it is only read.
+  */
+  virtual void ComputeAmplitudeILineQLine(unsigned char *ampl, short *inputSignal, short *inputSignalHilbertTransformed, int npt, double brightnessScale, const int *brightnessThresholds);
   
   /*! Compute amplitude from IQ encoded RF data. npt is the number of IQ pairs * 2. */
-  virtual void ComputeAmplitudeIqLine(unsigned char *ampl, short *inputSignal, const int npt);
+  virtual void ComputeAmplitudeIqLine(unsigned char *ampl, short *inputSignal, const int npt, double brightnessScale, const int *brightnessThresholds);
+
+  /*! Compute amplitude of numberOfSamples samples from the original and Hilbert transformed RF data, without skipping any samples at the ends */
+  void ComputeAmplitudeSamples(unsigned char *ampl, short *inputSignal, short *inputSignalHilbertTransformed, int numberOfSamples, double brightnessScale, const int *brightnessThresholds);
 
   /*! Scaling of the brightness output. Higher value means brighter image. */
   double BrightnessScale;
@@ -92,6 +166,30 @@ protected:
   /*! Coefficients of the Hilbert transform, computed from the NumberOfHilbertFilterCoeffs */
   std::vector<double> HilbertTransformCoeffs;
 
+  /*! Coefficients of the Hilbert transform in the order they are applied in the convolution, used by the vectorized computation */
+  std::vector<double> HilbertTransformCoeffsReversed;
+
+  /*!
+    BrightnessThresholds[k] is the smallest squared amplitude that results in at least k brightness value (k=0..256).
+    The values are stored with inverted sign bit so that they can be compared as signed integers.
+  */
+  std::vector<int> BrightnessThresholds;
+
+  /*! BrightnessScale value that was used for computing the BrightnessThresholds */
+  double BrightnessThresholdsScale;
+
+  /*! Use SSE2 or AVX2 instructions if the processor supports them */
+  bool EnableSimd;
+
+  /*! Method for computing the Hilbert transform of RF_REAL data */
+  HilbertTransformMethodType HilbertTransformMethod;
+
+  /*! FFT plan for computing the Hilbert transform, prepared for the scanline length of the current input */
+  PlusFft HilbertTransformFft;
+
+  /*! Scratch buffer of each thread for the FFT computation, kept between frames to avoid memory allocations */
+  std::vector< std::vector<double> > HilbertTransformFftBuffers;
+
   /*! Image type (RF_IQ_LINE, RF_I_LINE_Q_LINE, ...) */
   US_IMAGE_TYPE ImageType;
 
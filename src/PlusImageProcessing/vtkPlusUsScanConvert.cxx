@@ -33,6 +33,7 @@ vtkPlusUsScanConvert::vtkPlusUsScanConvert()
   this->TransducerCenterPixelSpecified = false;
   this->TransducerCenterPixel[0] = 0;
   this->TransducerCenterPixel[1] = 0;
+  this->CompactInterpolationTable = false;
 }
 
 //----------------------------------------------------------------------------
@@ -49,6 +50,7 @@ void vtkPlusUsScanConvert::PrintSelf( ostream& os, vtkIndent indent )
      << this->OutputImageExtent[0] << ", " << this->OutputImageExtent[1] << ", "
      << this->OutputImageExtent[2] << ", " << this->OutputImageExtent[3] << ")\n";
   os << indent << "OutputImageSpacing: (" << this->OutputImageSpacing[0] << ", " << this->OutputImageSpacing[1] << ")\n";
+  os << indent << "CompactInterpolationTable: " << ( this->CompactInterpolationTable ? "TRUE" : "FALSE" ) << "\n";
 }
 
 //-----------------------------------------------------------------------------
@@ -99,6 +101,8 @@ PlusStatus vtkPlusUsScanConvert::ReadConfiguration( vtkXMLDataElement* scanConve
     this->TransducerCenterPixel[1] = transducerCenterPixel[1];
   }
 
+  XML_READ_BOOL_ATTRIBUTE_OPTIONAL( CompactInterpolationTable, scanConversionElement );
+
   return PLUS_SUCCESS;
 }
 
@@ -125,6 +129,11 @@ PlusStatus vtkPlusUsScanConvert::WriteConfiguration( vtkXMLDataElement* scanConv
     scanConversionElement->SetVectorAttribute( "TransducerCenterPixel", 2, this->TransducerCenterPixel );
   }
 
+  if ( this->CompactInterpolationTable )
+  {
+    XML_WRITE_BOOL_ATTRIBUTE( CompactInterpolationTable, scanConversionElement );
+  }
+
   return PLUS_SUCCESS;
 }
 
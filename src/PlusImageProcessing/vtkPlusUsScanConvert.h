@@ -66,6 +66,17 @@ public:
   /*! Get the distance between two sample points in the scanline, in mm. Setting of the input image or at least the input image extent is required before calling this method. */
   virtual double GetDistanceBetweenScanlineSamplePointsMm()=0;
 
+  /*!
+    If enabled then the interpolation table weights are stored as 16-bit fixed point values.
+    The compact table uses less memory and unsigned char images are resampled with vectorized instructions (if supported by the processor),
+    but pixel values may differ by one from the result computed with double precision weights.
+    Linear scan conversion also changes interpolation mode: it uses nearest neighbor interpolation (vtkImageReslice) by default
+    and bilinear interpolation in compact mode, therefore the result may differ by more than one in linear compact mode.
+  */
+  vtkSetMacro(CompactInterpolationTable, bool);
+  vtkGetMacro(CompactInterpolationTable, bool);
+  vtkBooleanMacro(CompactInterpolationTable, bool);
+
 protected:
   vtkPlusUsScanConvert();
   virtual ~vtkPlusUsScanConvert();
@@ -99,6 +110,9 @@ protected:
   */
   int InputImageExtent[6];
 
+  /*! Store interpolation table weights as 16-bit fixed point values */
+  bool CompactInterpolationTable;
+
 private:
   vtkPlusUsScanConvert(const vtkPlusUsScanConvert&);  // Not implemented.
   void operator=(const vtkPlusUsScanConvert&);  // Not implemented.
@@ -31,6 +31,7 @@ non-commercial terms in your toolbox and distribute it."
 #include <math.h>
 #include <string.h>
 #include <ctype.h>
+#include <iomanip>
 
 vtkStandardNewMacro( vtkPlusUsScanConvertCurvilinear );
 
@@ -67,6 +68,7 @@ vtkPlusUsScanConvertCurvilinear::vtkPlusUsScanConvertCurvilinear()
   this->InterpTransducerCenterPixel[0] = 0.0;
   this->InterpTransducerCenterPixel[1] = 0.0;
   this->InterpIntensityScaling = 0.0;
+  this->InterpCompact = false;
 }
 
 //----------------------------------------------------------------------------
@@ -75,11 +77,11 @@ vtkPlusUsScanConvertCurvilinear::~vtkPlusUsScanConvertCurvilinear()
 }
 
 //----------------------------------------------------------------------------
-void vtkPlusUsScanConvertCurvilinear::ComputeInterpolatedPointArray(
+void vtkPlusUsScanConvertCurvilinear::ComputeInterpolationTable(
   int* inputImageExtent, double radiusStartMm, double radiusStopMm, double thetaStartDeg, double thetaStopDeg,
-  int* outputImageExtent, double* outputImageSpacing, double* transducerCenterPixel, double intensityScaling )
+  int* outputImageExtent, double* outputImageSpacing, double* transducerCenterPixel, double intensityScaling, bool compact )
 {
-  // Computing the point array is a costly operation, so perform it only if a scan conversion parameter has been changed
+  // Computing the interpolation table is a costly operation, so perform it only if a scan conversion parameter has been changed
 
   // Check if any scan conversion parameter has been changed
   bool modifiedScanConversionParams = false;
@@ -89,7 +91,7 @@ void vtkPlusUsScanConvertCurvilinear::ComputeInterpolatedPointArray(
     {
       modifiedScanConversionParams = true;
     }
-    if ( this->OutputImageExtent[i] != outputImageExtent[i] )
+    if ( this->InterpOutputImageExtent[i] != outputImageExtent[i] )
     {
       modifiedScanConversionParams = true;
     }
@@ -107,23 +109,25 @@ void vtkPlusUsScanConvertCurvilinear::ComputeInterpolatedPointArray(
        || ( this->InterpThetaStopDeg != thetaStopDeg )
        || ( this->InterpTransducerCenterPixel[0] != transducerCenterPixel[0] )
        || ( this->InterpTransducerCenterPixel[1] != transducerCenterPixel[1] )
-       || ( this->InterpIntensityScaling != intensityScaling ) )
+       || ( this->InterpIntensityScaling != intensityScaling )
+       || ( this->InterpCompact != compact )
+       || ( this->InterpolationTable.GetPointer() == NULL ) )
   {
     modifiedScanConversionParams = true;
   }
 
   if ( !modifiedScanConversionParams )
   {
-    // scan conversion parameters haven't been modified since the InterpolatedPointArray was last computed
+    // scan conversion parameters haven't been modified since the InterpolationTable was last computed
     // there is no need to recompute, just return
     return;
   }
 
-  // remember the current scan conversion parameters that are used to compute the interpolated point array
+  // remember the current scan conversion parameters that are used to compute the interpolation table
   for ( int i = 0; i < 6; i++ )
   {
     this->InterpInputImageExtent[i] = inputImageExtent[i];
-    this->OutputImageExtent[i] = outputImageExtent[i];
+    this->InterpOutputImageExtent[i] = outputImageExtent[i];
   }
   for ( int i = 0; i < 3; i++ )
   {
@@ -136,10 +140,26 @@ void vtkPlusUsScanConvertCurvilinear::ComputeInterpolatedPointArray(
   this->InterpTransducerCenterPixel[0] = transducerCenterPixel[0];
   this->InterpTransducerCenterPixel[1] = transducerCenterPixel[1];
   this->InterpIntensityScaling = intensityScaling;
+  this->InterpCompact = compact;
+
+  // Use the table of another scan converter if it has already been computed for the same parameters
+  std::ostringstream geometryDescription;
+  geometryDescription << std::setprecision( 17 ) << this->GetTransducerGeometry()
+                      << " InputImageExtent=" << inputImageExtent[0] << " " << inputImageExtent[1] << " " << inputImageExtent[2] << " " << inputImageExtent[3]
+                      << " Radius=" << radiusStartMm << " " << radiusStopMm << " Theta=" << thetaStartDeg << " " << thetaStopDeg
+                      << " OutputImageExtent=" << outputImageExtent[0] << " " << outputImageExtent[1] << " " << outputImageExtent[2] << " " << outputImageExtent[3]
+                      << " OutputImageSpacing=" << outputImageSpacing[0] << " " << outputImageSpacing[1]
+                      << " TransducerCenterPixel=" << transducerCenterPixel[0] << " " << transducerCenterPixel[1]
+                      << " IntensityScaling=" << intensityScaling << " Compact=" << compact;
+  this->InterpolationTable = vtkPlusUsScanConvertInterpolationTable::GetSharedTable( geometryDescription.str() );
+  if ( this->InterpolationTable.GetPointer() != NULL )
+  {
+    return;
+  }
 
-  // Compute the interpolated point array now
+  // Compute the interpolation table now
 
-  this->InterpolatedPointArray.clear();
+  vtkSmartPointer<vtkPlusUsScanConvertInterpolationTable> interpolationTable = vtkSmartPointer<vtkPlusUsScanConvertInterpolationTable>::New();
 
   int numberOfSamples = inputImageExtent[1] - inputImageExtent[0] + 1;
   int numberOfLines = inputImageExtent[3] - inputImageExtent[2] + 1;
@@ -153,6 +173,8 @@ void vtkPlusUsScanConvertCurvilinear::ComputeInterpolatedPointArray(
   int outputImageSizePixelsX = outputImageExtent[1] - outputImageExtent[0] + 1;
   int outputImageSizePixelsY = outputImageExtent[3] - outputImageExtent[2] + 1;
 
+  interpolationTable->Initialize( numberOfSamples, numberOfLines, compact );
+
   // Increments in image coordinates in mm
   double dx = outputImageSpacing[0];
   double dz = outputImageSpacing[1];
@@ -178,20 +200,17 @@ void vtkPlusUsScanConvertCurvilinear::ComputeInterpolatedPointArray(
            ( index_line >= 0 ) && ( index_line + 1 < numberOfLines ) )
       {
         // The sample is inside the input image, so it can be computed
-        InterpolatedPoint ip;
+        double weightCoefficients[4] = {0};
         double samp_val = samp - index_samp; // Sub-sample fraction for interpolation
         double line_val = line - index_line; // Sub-line fraction for interpolation
 
         //  Calculate the coefficients
-        ip.weightCoefficients[0] = ( 1 - samp_val ) * ( 1 - line_val ) * intensityScaling;
-        ip.weightCoefficients[1] =    samp_val * ( 1 - line_val ) * intensityScaling;
-        ip.weightCoefficients[2] = ( 1 - samp_val ) * line_val   * intensityScaling;
-        ip.weightCoefficients[3] =    samp_val * line_val   * intensityScaling;
-
-        ip.inputPixelIndex = index_samp + index_line * numberOfSamples;
-        ip.outputPixelIndex = j + outputImageSizePixelsX * i;
+        weightCoefficients[0] = ( 1 - samp_val ) * ( 1 - line_val ) * intensityScaling;
+        weightCoefficients[1] =    samp_val * ( 1 - line_val ) * intensityScaling;
+        weightCoefficients[2] = ( 1 - samp_val ) * line_val   * intensityScaling;
+        weightCoefficients[3] =    samp_val * line_val   * intensityScaling;
 
-        this->InterpolatedPointArray.push_back( ip );
+        interpolationTable->AddPoint( index_samp + index_line * numberOfSamples, j + outputImageSizePixelsX * i, weightCoefficients );
       }
 
       x = x + dx;
@@ -199,6 +218,8 @@ void vtkPlusUsScanConvertCurvilinear::ComputeInterpolatedPointArray(
     z = z + dz;
   }
 
+  // If another scan converter has added the same table in the meantime then that one is used
+  this->InterpolationTable = vtkPlusUsScanConvertInterpolationTable::AddSharedTable( geometryDescription.str(), interpolationTable );
 }
 
 //----------------------------------------------------------------------------
@@ -222,8 +243,9 @@ int vtkPlusUsScanConvertCurvilinear::RequestInformation ( vtkInformation* vtkNot
   //inInfo->Set(vtkStreamingDemandDrivenPipeline::UPDATE_EXTENT(),inExtent, 6);
 
   // Create the interpolation table. It is recomputed only if the scan conversion parameters change.
-  ComputeInterpolatedPointArray( inExtent, this->RadiusStartMm, this->RadiusStopMm, this->ThetaStartDeg, this->ThetaStopDeg,
-                                 this->OutputImageExtent, this->OutputImageSpacing, this->TransducerCenterPixel, this->OutputIntensityScaling );
+  ComputeInterpolationTable( inExtent, this->RadiusStartMm, this->RadiusStopMm, this->ThetaStartDeg, this->ThetaStopDeg,
+                             this->OutputImageExtent, this->OutputImageSpacing, this->TransducerCenterPixel, this->OutputIntensityScaling,
+                             this->CompactInterpolationTable );
 
   return 1;
 }
@@ -288,23 +310,8 @@ void vtkPlusUsScanConvertExecute( vtkPlusUsScanConvertCurvilinear* self,
                                   vtkImageData* outData, T* outPtr,
                                   int interpolationTableExt[6], int id )
 {
-  T* envelope_data = inPtr; // The envelope detected and log-compressed data
-  int numberOfSamples = inData->GetExtent()[1] - inData->GetExtent()[0] + 1; // Number of samples in one envelope line
-
-  T* image = outPtr; // The resulting image
-
-  std::vector<vtkPlusUsScanConvertCurvilinear::InterpolatedPoint>::const_iterator firstPoint = self->GetInterpolatedPointArray().begin() + interpolationTableExt[0];
-  std::vector<vtkPlusUsScanConvertCurvilinear::InterpolatedPoint>::const_iterator afterLastPoint = self->GetInterpolatedPointArray().begin() + interpolationTableExt[1] + 1;
-  for ( std::vector<vtkPlusUsScanConvertCurvilinear::InterpolatedPoint>::const_iterator it = firstPoint; it != afterLastPoint; ++it )
-  {
-    T* env_pointer = ( T* ) & ( envelope_data[it->inputPixelIndex] ); // Pointer to the envelope data
-    image[it->outputPixelIndex] =
-      it->weightCoefficients[0] * env_pointer[0] // (+0, +0)
-      + it->weightCoefficients[1] * env_pointer[1] // (+1, +0)
-      + it->weightCoefficients[2] * env_pointer[numberOfSamples] // (+0, +1)
-      + it->weightCoefficients[3] * env_pointer[numberOfSamples + 1] // (+1, +1)
-      + 0.5; // for rounding
-  }
+  // inPtr: the envelope detected and log-compressed data, outPtr: the resulting image
+  self->GetInterpolationTable()->Resample( inPtr, outPtr, interpolationTableExt[0], interpolationTableExt[1] );
 }
 
 //----------------------------------------------------------------------------
@@ -354,7 +361,7 @@ void vtkPlusUsScanConvertCurvilinear::PrintSelf( ostream& os, vtkIndent indent )
   os << indent << "ThetaStartDeg: " << this->ThetaStartDeg << "\n";
   os << indent << "ThetaStopDeg: " << this->ThetaStopDeg << "\n";
   os << indent << "OutputIntensityScaling: " << this->OutputIntensityScaling << "\n";
-  os << indent << "InterpolatedPointArraySize: " << this->InterpolatedPointArray.size() << "\n";
+  os << indent << "InterpolationTableSize: " << ( this->InterpolationTable.GetPointer() != NULL ? this->InterpolationTable->GetNumberOfPoints() : 0 ) << "\n";
 
 }
 
@@ -371,7 +378,7 @@ int vtkPlusUsScanConvertCurvilinear::SplitExtent( int splitExt[6], int startExt[
 
   // Starting extent
   int min = 0;
-  int max = this->InterpolatedPointArray.size() - 1;
+  int max = ( this->InterpolationTable.GetPointer() != NULL ? this->InterpolationTable->GetNumberOfPoints() : 0 ) - 1;
 
   splitExt[0] = min;
   splitExt[1] = max;
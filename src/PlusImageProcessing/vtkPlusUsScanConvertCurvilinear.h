@@ -9,6 +9,7 @@ See License.txt for details.
 
 #include "vtkPlusImageProcessingExport.h"
 #include "vtkPlusUsScanConvert.h"
+#include "vtkPlusUsScanConvertInterpolationTable.h"
 
 /*!
 \class vtkPlusUsScanConvertCurvilinear
@@ -36,20 +37,10 @@ public:
   /*! Get the scan converted image */
   virtual vtkImageData* GetOutput();
 
-  struct InterpolatedPoint
+  /*! Retrieve the interpolation table (used internally by the thread function) */
+  vtkPlusUsScanConvertInterpolationTable* GetInterpolationTable()
   {
-    /*! Weighting coefficients that used to construct the output pixel from 4 input pixels */
-    double weightCoefficients[4];
-    /*! Position of the first input pixel that is used to construct the output point (in the sample line matrix). The 3 others are one row/column away. */
-    int inputPixelIndex;
-    // Position of the output pixel (in the image matrix) */
-    int outputPixelIndex;
-  };
-
-  /*! Retrieve the InterpolatedPointArray (used internally by the thread function) */
-  const std::vector<InterpolatedPoint>& GetInterpolatedPointArray()
-  {
-    return this->InterpolatedPointArray;
+    return this->InterpolationTable;
   };
 
   /*! Initialize the parameters used in reconstruction. These are for the cases when video source can obtain them from the hardware */
@@ -109,8 +100,11 @@ protected:
   /*! Intensity scaling factor from envelope to image */
   double OutputIntensityScaling;
 
-  /*! Each element of this array defines the computation of a pixel in the output (scan converted) image.  */
-  std::vector<InterpolatedPoint> InterpolatedPointArray;
+  /*!
+    Each point of this table defines the computation of a pixel in the output (scan converted) image.
+    The table is shared with all other scan converters that have the same geometry.
+  */
+  vtkSmartPointer<vtkPlusUsScanConvertInterpolationTable> InterpolationTable;
 
   int InterpInputImageExtent[6];
   double InterpRadiusStartMm;
@@ -121,14 +115,16 @@ protected:
   double InterpOutputImageSpacing[3];
   double InterpTransducerCenterPixel[2];
   double InterpIntensityScaling;
+  bool InterpCompact;
 
   /*!
-    Computes the InterpolatedPointArray from the method arguments. The array is not recomputed if
-    the input arguments are the same as last time.
+    Computes the InterpolationTable from the method arguments. The table is not recomputed if
+    the input arguments are the same as last time or if another scan converter has already computed
+    a table with the same arguments.
   */
-  void ComputeInterpolatedPointArray(
+  void ComputeInterpolationTable(
     int* inputImageExtent, double radiusStartMm, double radiusStopMm, double thetaStartDeg, double thetaStopDeg,
-    int* outputImageExtent, double* outputImageSpacing, double* transducerCenterPixel, double intensityScaling
+    int* outputImageExtent, double* outputImageSpacing, double* transducerCenterPixel, double intensityScaling, bool compact
   );
 
 private:
@@ -0,0 +1,253 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+See License.txt for details.
+=========================================================Plus=header=end*/
+
+#include "PlusConfigure.h"
+
+#include "vtkPlusUsScanConvertInterpolationTable.h"
+
+#include "vtkObjectFactory.h"
+#include "vtkPlusRecursiveCriticalSection.h"
+
+#include <algorithm>
+#include <map>
+#include <math.h>
+
+#ifdef PLUS_AVX2_AVAILABLE
+#include <immintrin.h>
+#endif
+
+vtkStandardNewMacro(vtkPlusUsScanConvertInterpolationTable);
+
+namespace
+{
+  typedef std::map< std::string, vtkSmartPointer<vtkPlusUsScanConvertInterpolationTable> > SharedTableMapType;
+
+  class SharedTables
+  {
+  public:
+    vtkPlusSimpleRecursiveCriticalSection CriticalSection;
+    SharedTableMapType Tables;
+  };
+  SharedTables sharedTables;
+
+#ifdef PLUS_AVX2_AVAILABLE
+  //----------------------------------------------------------------------------
+  // Compute 8 output pixels at a time: the 4 input samples of 8 points are fetched by two gathers
+  // (samples of the first and the second scanline), weighted, summed, and rounded in 32-bit integers.
+  // Returns the index of the first point that has not been computed.
+  PLUS_TARGET_AVX2 int ResampleCompactAvx2(const unsigned char* input, unsigned char* output, const int* inputPixelIndices, const int* outputPixelIndices,
+    const unsigned short* const compactWeights[4], int numberOfSamples, int maxGatherIndex, int firstPointIndex, int lastPointIndex)
+  {
+    const int roundingOffset = 1 << (vtkPlusUsScanConvertInterpolationTable::COMPACT_WEIGHT_FRACTION_BITS - 1);
+    const __m256i byteMask = _mm256_set1_epi32(0xFF);
+    const __m256i lineOffset = _mm256_set1_epi32(numberOfSamples);
+    const __m256i roundingOffsetVector = _mm256_set1_epi32(roundingOffset);
+    const __m256i maxGatherIndexVector = _mm256_set1_epi32(maxGatherIndex);
+    const int* inputWords = reinterpret_cast<const int*>(input);
+    int pointIndex = firstPointIndex;
+    for (; pointIndex + 7 <= lastPointIndex; pointIndex += 8)
+    {
+      __m256i inputIndex = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(inputPixelIndices + pointIndex));
+      if (_mm256_movemask_epi8(_mm256_cmpgt_epi32(inputIndex, maxGatherIndexVector)) != 0)
+      {
+        // 4-byte gather would read after the end of the input image, compute these points without SIMD
+        for (int i = pointIndex; i < pointIndex + 8; ++i)
+        {
+          const unsigned char* inputPixel = input + inputPixelIndices[i];
+          int value = (compactWeights[0][i] * inputPixel[0] + compactWeights[1][i] * inputPixel[1]
+            + compactWeights[2][i] * inputPixel[numberOfSamples] + compactWeights[3][i] * inputPixel[numberOfSamples + 1]
+            + roundingOffset) >> vtkPlusUsScanConvertInterpolationTable::COMPACT_WEIGHT_FRACTION_BITS;
+          output[outputPixelIndices[i]] = static_cast<unsigned char>(value > 255 ? 255 : value);
+        }
+        continue;
+      }
+      __m256i firstLine = _mm256_i32gather_epi32(inputWords, inputIndex, 1);
+      __m256i secondLine = _mm256_i32gather_epi32(inputWords, _mm256_add_epi32(inputIndex, lineOffset), 1);
+      __m256i sum = _mm256_mullo_epi32(_mm256_and_si256(firstLine, byteMask),
+        _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(compactWeights[0] + pointIndex))));
+      sum = _mm256_add_epi32(sum, _mm256_mullo_epi32(_mm256_and_si256(_mm256_srli_epi32(firstLine, 8), byteMask),
+        _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(compactWeights[1] + pointIndex)))));
+      sum = _mm256_add_epi32(sum, _mm256_mullo_epi32(_mm256_and_si256(secondLine, byteMask),
+        _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(compactWeights[2] + pointIndex)))));
+      sum = _mm256_add_epi32(sum, _mm256_mullo_epi32(_mm256_and_si256(_mm256_srli_epi32(secondLine, 8), byteMask),
+        _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(compactWeights[3] + pointIndex)))));
+      __m256i value = _mm256_srli_epi32(_mm256_add_epi32(sum, roundingOffsetVector), vtkPlusUsScanConvertInterpolationTable::COMPACT_WEIGHT_FRACTION_BITS);
+
+      // Pack to 8 bytes (with saturation)
+      __m128i value16 = _mm_packus_epi32(_mm256_castsi256_si128(value), _mm256_extracti128_si256(value, 1));
+      __m128i value8 = _mm_packus_epi16(value16, value16);
+      const int* outputIndex = outputPixelIndices + pointIndex;
+      if (outputIndex[7] - outputIndex[0] == 7)
+      {
+        // Points are ordered by output pixel index, so consecutive output pixels are contiguous within an image row
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(output + outputIndex[0]), value8);
+      }
+      else
+      {
+        unsigned char values[16];
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(values), value8);
+        for (int i = 0; i < 8; ++i)
+        {
+          output[outputIndex[i]] = values[i];
+        }
+      }
+    }
+    return pointIndex;
+  }
+#endif
+}
+
+//----------------------------------------------------------------------------
+vtkPlusUsScanConvertInterpolationTable::vtkPlusUsScanConvertInterpolationTable()
+  : NumberOfSamples(0)
+  , NumberOfLines(0)
+  , Compact(false)
+{
+}
+
+//----------------------------------------------------------------------------
+vtkPlusUsScanConvertInterpolationTable::~vtkPlusUsScanConvertInterpolationTable()
+{
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusUsScanConvertInterpolationTable::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+  os << indent << "NumberOfSamples: " << this->NumberOfSamples << "\n";
+  os << indent << "NumberOfLines: " << this->NumberOfLines << "\n";
+  os << indent << "Compact: " << (this->Compact ? "TRUE" : "FALSE") << "\n";
+  os << indent << "NumberOfPoints: " << this->GetNumberOfPoints() << "\n";
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusUsScanConvertInterpolationTable::Initialize(int numberOfSamples, int numberOfLines, bool compact)
+{
+  this->NumberOfSamples = numberOfSamples;
+  this->NumberOfLines = numberOfLines;
+  this->Compact = compact;
+  this->InputPixelIndices.clear();
+  this->OutputPixelIndices.clear();
+  for (int i = 0; i < 4; ++i)
+  {
+    this->Weights[i].clear();
+    this->CompactWeights[i].clear();
+  }
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusUsScanConvertInterpolationTable::AddPoint(int inputPixelIndex, int outputPixelIndex, const double weightCoefficients[4])
+{
+  this->InputPixelIndices.push_back(inputPixelIndex);
+  this->OutputPixelIndices.push_back(outputPixelIndex);
+  if (!this->Compact)
+  {
+    for (int i = 0; i < 4; ++i)
+    {
+      this->Weights[i].push_back(weightCoefficients[i]);
+    }
+    return;
+  }
+
+  // Round the total weight and the first three weights, the last weight gets the remainder,
+  // so that a uniform input region results in the same uniform output
+  const double weightScale = 1 << COMPACT_WEIGHT_FRACTION_BITS;
+  const int maxWeight = 0xFFFF;
+  int totalWeight = static_cast<int>(floor((weightCoefficients[0] + weightCoefficients[1] + weightCoefficients[2] + weightCoefficients[3]) * weightScale + 0.5));
+  int remainingWeight = std::min(std::max(totalWeight, 0), maxWeight);
+  for (int i = 0; i < 3; ++i)
+  {
+    int weight = static_cast<int>(floor(weightCoefficients[i] * weightScale + 0.5));
+    weight = std::min(std::max(weight, 0), remainingWeight);
+    this->CompactWeights[i].push_back(static_cast<unsigned short>(weight));
+    remainingWeight -= weight;
+  }
+  this->CompactWeights[3].push_back(static_cast<unsigned short>(remainingWeight));
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusUsScanConvertInterpolationTable::Resample(const unsigned char* input, unsigned char* output, int firstPointIndex, int lastPointIndex) const
+{
+  if (firstPointIndex > lastPointIndex)
+  {
+    return;
+  }
+  if (!this->Compact)
+  {
+    this->Resample<unsigned char>(input, output, firstPointIndex, lastPointIndex);
+    return;
+  }
+
+  int pointIndex = firstPointIndex;
+#ifdef PLUS_AVX2_AVAILABLE
+  if (PlusCommon::IsAvx2Supported())
+  {
+    // Each gather reads 4 bytes starting at the sample index in the first and the second scanline
+    int maxGatherIndex = this->NumberOfSamples * this->NumberOfLines - this->NumberOfSamples - 4;
+    const unsigned short* const compactWeights[4] = { &this->CompactWeights[0][0], &this->CompactWeights[1][0], &this->CompactWeights[2][0], &this->CompactWeights[3][0] };
+    pointIndex = ResampleCompactAvx2(input, output, &this->InputPixelIndices[0], &this->OutputPixelIndices[0],
+      compactWeights, this->NumberOfSamples, maxGatherIndex, firstPointIndex, lastPointIndex);
+  }
+#endif
+
+  const int roundingOffset = 1 << (COMPACT_WEIGHT_FRACTION_BITS - 1);
+  for (int i = pointIndex; i <= lastPointIndex; ++i)
+  {
+    const unsigned char* inputPixel = input + this->InputPixelIndices[i];
+    int value = (this->CompactWeights[0][i] * inputPixel[0]
+      + this->CompactWeights[1][i] * inputPixel[1]
+      + this->CompactWeights[2][i] * inputPixel[this->NumberOfSamples]
+      + this->CompactWeights[3][i] * inputPixel[this->NumberOfSamples + 1]
+      + roundingOffset) >> COMPACT_WEIGHT_FRACTION_BITS;
+    output[this->OutputPixelIndices[i]] = static_cast<unsigned char>(value > 255 ? 255 : value);
+  }
+}
+
+//----------------------------------------------------------------------------
+vtkSmartPointer<vtkPlusUsScanConvertInterpolationTable> vtkPlusUsScanConvertInterpolationTable::GetSharedTable(const std::string& geometryDescription)
+{
+  PlusLockGuard<vtkPlusSimpleRecursiveCriticalSection> sharedTablesGuard(&sharedTables.CriticalSection);
+  SharedTableMapType::iterator tableIt = sharedTables.Tables.find(geometryDescription);
+  if (tableIt == sharedTables.Tables.end())
+  {
+    return NULL;
+  }
+  return tableIt->second;
+}
+
+//----------------------------------------------------------------------------
+vtkSmartPointer<vtkPlusUsScanConvertInterpolationTable> vtkPlusUsScanConvertInterpolationTable::AddSharedTable(const std::string& geometryDescription, vtkPlusUsScanConvertInterpolationTable* table)
+{
+  PlusLockGuard<vtkPlusSimpleRecursiveCriticalSection> sharedTablesGuard(&sharedTables.CriticalSection);
+
+  // Release tables that are only referenced by the shared table map
+  for (SharedTableMapType::iterator tableIt = sharedTables.Tables.begin(); tableIt != sharedTables.Tables.end();)
+  {
+    if (tableIt->second->GetReferenceCount() == 1 && tableIt->first != geometryDescription)
+    {
+      sharedTables.Tables.erase(tableIt++);
+    }
+    else
+    {
+      ++tableIt;
+    }
+  }
+
+  SharedTableMapType::iterator tableIt = sharedTables.Tables.find(geometryDescription);
+  if (tableIt != sharedTables.Tables.end())
+  {
+    return tableIt->second;
+  }
+  sharedTables.Tables[geometryDescription] = table;
+  return table;
+}
+
+//----------------------------------------------------------------------------
+int vtkPlusUsScanConvertInterpolationTable::GetNumberOfSharedTables()
+{
+  PlusLockGuard<vtkPlusSimpleRecursiveCriticalSection> sharedTablesGuard(&sharedTables.CriticalSection);
+  return static_cast<int>(sharedTables.Tables.size());
+}
@@ -0,0 +1,155 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+See License.txt for details.
+=========================================================Plus=header=end*/
+
+#ifndef __vtkPlusUsScanConvertInterpolationTable_h
+#define __vtkPlusUsScanConvertInterpolationTable_h
+
+#include "vtkPlusImageProcessingExport.h"
+#include "vtkObject.h"
+#include "vtkSmartPointer.h"
+
+#include <string>
+#include <vector>
+
+/*!
+\class vtkPlusUsScanConvertInterpolationTable
+\brief Resampling table that defines how the pixels of a scan converted image are computed from scanline samples
+
+Each point of the table defines an output pixel as the weighted sum of 4 input samples: two neighbor samples
+in two neighbor scanlines (bilinear interpolation). Points are stored as a struct of arrays, ordered by output pixel index,
+so that the table can be split between threads by point index.
+
+Weights are stored either in double precision (exact table) or as 16-bit fixed point values (compact table).
+The compact table uses less memory and it can be processed by a vectorized gather/blend kernel (AVX2)
+for unsigned char images, but the computed pixel values may differ by one from the exact table result.
+Curvilinear scan conversion always uses a table (exact or compact), while linear scan conversion only uses
+a (compact) table in compact mode, which means bilinear instead of nearest neighbor interpolation.
+
+Tables only depend on the probe geometry, therefore they are shared between all scan converters in the process:
+converters with identical geometry (such as the RF processors of multiple channels that use the same probe)
+use the same table instance, which is computed only once. Tables are identified by a string that describes
+all the parameters that the table depends on (see GetSharedTable). Shared tables that are not used by any
+scan converter anymore are released when a new table is added.
+
+\ingroup PlusLibImageProcessingAlgo
+*/
+class vtkPlusImageProcessingExport vtkPlusUsScanConvertInterpolationTable : public vtkObject
+{
+public:
+  static vtkPlusUsScanConvertInterpolationTable* New();
+  vtkTypeMacro(vtkPlusUsScanConvertInterpolationTable, vtkObject);
+  virtual void PrintSelf(ostream& os, vtkIndent indent) VTK_OVERRIDE;
+
+  /*! Weight value of 1.0 in the compact table is stored as 2^COMPACT_WEIGHT_FRACTION_BITS */
+  static const int COMPACT_WEIGHT_FRACTION_BITS = 14;
+
+  /*!
+    Remove all points and set the input image size
+    \param numberOfSamples Number of samples in a scanline (number of columns of the input image)
+    \param numberOfLines Number of scanlines (number of rows of the input image)
+    \param compact If true then weights are stored as 16-bit fixed point values, otherwise in double precision
+  */
+  void Initialize(int numberOfSamples, int numberOfLines, bool compact);
+
+  /*!
+    Add an output pixel to the table
+    \param inputPixelIndex Index of the first input sample. The others are the next sample, and the same samples in the next scanline.
+    \param outputPixelIndex Index of the computed output pixel
+    \param weightCoefficients Weights of the input samples: (+0, +0), (+1, +0), (+0, +1), (+1, +1)
+  */
+  void AddPoint(int inputPixelIndex, int outputPixelIndex, const double weightCoefficients[4]);
+
+  /*! Get the number of points (computed output pixels) in the table */
+  int GetNumberOfPoints() const { return static_cast<int>(this->InputPixelIndices.size()); }
+
+  /*! Returns true if the weights are stored as 16-bit fixed point values */
+  bool GetCompact() const { return this->Compact; }
+
+  int GetNumberOfSamples() const { return this->NumberOfSamples; }
+  int GetNumberOfLines() const { return this->NumberOfLines; }
+
+  /*!
+    Compute the output pixels of the points from firstPointIndex to lastPointIndex (inclusive).
+    Output pixels that are not in the table are not modified.
+  */
+  template <class T> void Resample(const T* input, T* output, int firstPointIndex, int lastPointIndex) const
+  {
+    if (firstPointIndex > lastPointIndex)
+    {
+      return;
+    }
+    const int* inputPixelIndices = &this->InputPixelIndices[0];
+    const int* outputPixelIndices = &this->OutputPixelIndices[0];
+    if (this->Compact)
+    {
+      const double weightScale = 1.0 / (1 << COMPACT_WEIGHT_FRACTION_BITS);
+      for (int i = firstPointIndex; i <= lastPointIndex; ++i)
+      {
+        const T* inputPixel = input + inputPixelIndices[i];
+        output[outputPixelIndices[i]] = static_cast<T>(
+          (this->CompactWeights[0][i] * static_cast<double>(inputPixel[0])
+          + this->CompactWeights[1][i] * static_cast<double>(inputPixel[1])
+          + this->CompactWeights[2][i] * static_cast<double>(inputPixel[this->NumberOfSamples])
+          + this->CompactWeights[3][i] * static_cast<double>(inputPixel[this->NumberOfSamples + 1])) * weightScale
+          + 0.5); // for rounding
+      }
+    }
+    else
+    {
+      for (int i = firstPointIndex; i <= lastPointIndex; ++i)
+      {
+        const T* inputPixel = input + inputPixelIndices[i];
+        output[outputPixelIndices[i]] = static_cast<T>(
+          this->Weights[0][i] * inputPixel[0] // (+0, +0)
+          + this->Weights[1][i] * inputPixel[1] // (+1, +0)
+          + this->Weights[2][i] * inputPixel[this->NumberOfSamples] // (+0, +1)
+          + this->Weights[3][i] * inputPixel[this->NumberOfSamples + 1] // (+1, +1)
+          + 0.5); // for rounding
+      }
+    }
+  }
+
+  /*! Compute the output pixels of unsigned char images. Compact tables are processed with AVX2 instructions if the processor supports them. */
+  void Resample(const unsigned char* input, unsigned char* output, int firstPointIndex, int lastPointIndex) const;
+
+  /*! Get a shared table by its geometry description. Returns NULL if no such table has been added. */
+  static vtkSmartPointer<vtkPlusUsScanConvertInterpolationTable> GetSharedTable(const std::string& geometryDescription);
+
+  /*!
+    Make a table available for all scan converters. If a table has already been added with the same geometry description
+    (e.g., by another thread) then that table is returned, otherwise the specified table.
+  */
+  static vtkSmartPointer<vtkPlusUsScanConvertInterpolationTable> AddSharedTable(const std::string& geometryDescription, vtkPlusUsScanConvertInterpolationTable* table);
+
+  /*! Get the number of tables that are currently shared */
+  static int GetNumberOfSharedTables();
+
+protected:
+  vtkPlusUsScanConvertInterpolationTable();
+  virtual ~vtkPlusUsScanConvertInterpolationTable();
+
+  /*! Number of samples in a scanline of the input image */
+  int NumberOfSamples;
+  /*! Number of scanlines in the input image */
+  int NumberOfLines;
+  /*! Weights are stored in CompactWeights if true, in Weights otherwise */
+  bool Compact;
+
+  /*! Index of the first input sample of each point */
+  std::vector<int> InputPixelIndices;
+  /*! Index of the output pixel of each point */
+  std::vector<int> OutputPixelIndices;
+  /*! Weights of the 4 input samples of each point (exact table) */
+  std::vector<double> Weights[4];
+  /*! Weights of the 4 input samples of each point, in fixed point format (compact table) */
+  std::vector<unsigned short> CompactWeights[4];
+
+private:
+  vtkPlusUsScanConvertInterpolationTable(const vtkPlusUsScanConvertInterpolationTable&);  // Not implemented.
+  void operator=(const vtkPlusUsScanConvertInterpolationTable&);  // Not implemented.
+};
+
+#endif
@@ -14,6 +14,10 @@ See License.txt for details.
 #include "vtkImageData.h"
 #include "vtkAlgorithmOutput.h"
 
+#include <iomanip>
+#include <math.h>
+#include <string.h>
+
 vtkStandardNewMacro(vtkPlusUsScanConvertLinear);
 
 //----------------------------------------------------------------------------
@@ -23,6 +27,7 @@ vtkPlusUsScanConvertLinear::vtkPlusUsScanConvertLinear()
   this->TransducerWidthMm=38.0;
 
   this->ImageReslice=vtkImageReslice::New();  
+  this->OutputImage=vtkImageData::New();
 }
 
 //----------------------------------------------------------------------------
@@ -30,6 +35,8 @@ vtkPlusUsScanConvertLinear::~vtkPlusUsScanConvertLinear()
 {
   this->ImageReslice->Delete();
   this->ImageReslice=NULL;  
+  this->OutputImage->Delete();
+  this->OutputImage=NULL;
 }
 
 void vtkPlusUsScanConvertLinear::PrintSelf(ostream& os, vtkIndent indent)
@@ -37,6 +44,7 @@ void vtkPlusUsScanConvertLinear::PrintSelf(ostream& os, vtkIndent indent)
   this->Superclass::PrintSelf(os,indent);
   os << indent << "ImagingDepthMm: "<< this->ImagingDepthMm << "\n";
   os << indent << "TransducerWidthMm: "<< this->TransducerWidthMm << "\n";
+  os << indent << "InterpolationTableSize: " << (this->InterpolationTable.GetPointer()!=NULL ? this->InterpolationTable->GetNumberOfPoints() : 0) << "\n";
 }
 
 //-----------------------------------------------------------------------------
@@ -92,14 +100,119 @@ void vtkPlusUsScanConvertLinear::Update()
     transducerCenterPixel[1]=this->TransducerCenterPixel[1];
   }
 
-  this->ImageReslice->SetOutputOrigin(-this->TransducerCenterPixel[0]+halfImageWidthPixel,-this->TransducerCenterPixel[1],0);
+  double outputOrigin[3]={-this->TransducerCenterPixel[0]+halfImageWidthPixel,-this->TransducerCenterPixel[1],0};
+
+  if (this->CompactInterpolationTable && inputImage->GetNumberOfScalarComponents()==1)
+  {
+    // Resample using the interpolation table, with the same mapping between output and input coordinates as the reslice filter
+    ComputeInterpolationTable(inputImage, yVec[0], xVec[1], outputOrigin);
+
+    this->OutputImage->SetExtent(this->OutputImageExtent);
+    this->OutputImage->SetSpacing(1.0, 1.0, 1.0);
+    this->OutputImage->SetOrigin(outputOrigin);
+    this->OutputImage->AllocateScalars(inputImage->GetScalarType(), 1);
+    // Only pixels that are in the table are computed, the rest is set to zero
+    memset(this->OutputImage->GetScalarPointer(), 0, this->OutputImage->GetNumberOfPoints()*this->OutputImage->GetScalarSize());
+
+    void* inPtr=inputImage->GetScalarPointer();
+    void* outPtr=this->OutputImage->GetScalarPointer();
+    switch (inputImage->GetScalarType())
+    {
+      vtkTemplateMacro(
+        this->InterpolationTable->Resample(static_cast<VTK_TT*>(inPtr), static_cast<VTK_TT*>(outPtr), 0, this->InterpolationTable->GetNumberOfPoints()-1) );
+    default:
+      LOG_ERROR("vtkPlusUsScanConvertLinear::Update failed: unknown scalar type");
+    }
+    this->OutputImage->Modified();
+    return;
+  }
+
+  this->ImageReslice->SetOutputOrigin(outputOrigin);
 
   this->ImageReslice->Update();
 }
 
+//-----------------------------------------------------------------------------
+void vtkPlusUsScanConvertLinear::ComputeInterpolationTable(vtkImageData* inputImage, double sampleScale, double lineScale, double outputOrigin[3])
+{
+  int inputExtent[6]={0,-1,0,-1,0,-1};
+  inputImage->GetExtent(inputExtent);
+  double inputOrigin[3]={0};
+  inputImage->GetOrigin(inputOrigin);
+  double inputSpacing[3]={1.0, 1.0, 1.0};
+  inputImage->GetSpacing(inputSpacing);
+
+  std::ostringstream geometryDescription;
+  geometryDescription << std::setprecision(17) << this->GetTransducerGeometry()
+    << " InputImageExtent=" << inputExtent[0] << " " << inputExtent[1] << " " << inputExtent[2] << " " << inputExtent[3]
+    << " InputImageOrigin=" << inputOrigin[0] << " " << inputOrigin[1]
+    << " InputImageSpacing=" << inputSpacing[0] << " " << inputSpacing[1]
+    << " OutputImageExtent=" << this->OutputImageExtent[0] << " " << this->OutputImageExtent[1] << " " << this->OutputImageExtent[2] << " " << this->OutputImageExtent[3]
+    << " OutputImageOrigin=" << outputOrigin[0] << " " << outputOrigin[1]
+    << " Scale=" << sampleScale << " " << lineScale << " Compact=1";
+  if (this->InterpolationTable.GetPointer()!=NULL && this->InterpolationTableGeometryDescription==geometryDescription.str())
+  {
+    // scan conversion parameters haven't been modified since the InterpolationTable was last computed
+    return;
+  }
+  this->InterpolationTableGeometryDescription=geometryDescription.str();
+
+  // Use the table of another scan converter if it has already been computed for the same parameters
+  this->InterpolationTable=vtkPlusUsScanConvertInterpolationTable::GetSharedTable(this->InterpolationTableGeometryDescription);
+  if (this->InterpolationTable.GetPointer()!=NULL)
+  {
+    return;
+  }
+
+  int numberOfSamples=inputExtent[1]-inputExtent[0]+1;
+  int numberOfLines=inputExtent[3]-inputExtent[2]+1;
+  int outputImageSizePixelsX=this->OutputImageExtent[1]-this->OutputImageExtent[0]+1;
+  int outputImageSizePixelsY=this->OutputImageExtent[3]-this->OutputImageExtent[2]+1;
+
+  vtkSmartPointer<vtkPlusUsScanConvertInterpolationTable> interpolationTable=vtkSmartPointer<vtkPlusUsScanConvertInterpolationTable>::New();
+  interpolationTable->Initialize(numberOfSamples, numberOfLines, true);
+  for (int i=0; i<outputImageSizePixelsY; i++)
+  {
+    // Output image rows are along the scanlines
+    double samp=((outputOrigin[1]+this->OutputImageExtent[2]+i)*sampleScale-inputOrigin[0])/inputSpacing[0]-inputExtent[0];
+    int index_samp=static_cast<int>(floor(samp));
+    if (index_samp<0 || index_samp+1>=numberOfSamples)
+    {
+      continue;
+    }
+    double samp_val=samp-index_samp;
+    for (int j=0; j<outputImageSizePixelsX; j++)
+    {
+      // Output image columns are across the scanlines
+      double line=((outputOrigin[0]+this->OutputImageExtent[0]+j)*lineScale-inputOrigin[1])/inputSpacing[1]-inputExtent[2];
+      int index_line=static_cast<int>(floor(line));
+      if (index_line<0 || index_line+1>=numberOfLines)
+      {
+        continue;
+      }
+      double line_val=line-index_line;
+      double weightCoefficients[4]=
+      {
+        (1-samp_val)*(1-line_val),
+        samp_val*(1-line_val),
+        (1-samp_val)*line_val,
+        samp_val*line_val
+      };
+      interpolationTable->AddPoint(index_samp+index_line*numberOfSamples, j+outputImageSizePixelsX*i, weightCoefficients);
+    }
+  }
+
+  // If another scan converter has added the same table in the meantime then that one is used
+  this->InterpolationTable=vtkPlusUsScanConvertInterpolationTable::AddSharedTable(this->InterpolationTableGeometryDescription, interpolationTable);
+}
+
 //-----------------------------------------------------------------------------
 vtkImageData* vtkPlusUsScanConvertLinear::GetOutput()
 {
+  if (this->CompactInterpolationTable && this->InterpolationTable.GetPointer()!=NULL)
+  {
+    return this->OutputImage;
+  }
   return this->ImageReslice->GetOutput();
 }
 
@@ -9,6 +9,7 @@ See License.txt for details.
 
 #include "vtkPlusImageProcessingExport.h"
 #include "vtkPlusUsScanConvert.h"
+#include "vtkPlusUsScanConvertInterpolationTable.h"
 
 class vtkAlgorithmOutput;
 class vtkImageReslice;
@@ -17,6 +18,10 @@ class vtkImageData;
 /*!
 \class vtkPlusUsScanConvertLinear
 \brief This class performs scan conversion from scan lines for curvilinear probes
+
+By default the image is resampled by vtkImageReslice (nearest neighbor interpolation).
+If CompactInterpolationTable is enabled then bilinear interpolation is performed using a precomputed
+compact interpolation table, which is shared with all other scan converters that have the same geometry.
 \ingroup PlusLibImageProcessingAlgo
 */ 
 class vtkPlusImageProcessingExport vtkPlusUsScanConvertLinear : public vtkPlusUsScanConvert
@@ -72,9 +77,28 @@ protected:
   /*! Image width covered by the transducer (distance between the first and last RF scanlines), in mm */
   double TransducerWidthMm;
 
+  /*!
+    Computes the InterpolationTable for the specified input image and resampling parameters. The table is not recomputed if
+    the parameters are the same as last time or if another scan converter has already computed a table with the same parameters.
+    \param inputImage Input image containing the brightness lines
+    \param sampleScale Sample coordinate increment corresponding to one output image row
+    \param lineScale Scanline coordinate increment corresponding to one output image column
+    \param outputOrigin Origin of the output image
+  */
+  void ComputeInterpolationTable(vtkImageData* inputImage, double sampleScale, double lineScale, double outputOrigin[3]);
+
   /*! Reslice class that performs the necessary resampling */
   vtkImageReslice* ImageReslice;
 
+  /*! Shared interpolation table, used for resampling if CompactInterpolationTable is enabled */
+  vtkSmartPointer<vtkPlusUsScanConvertInterpolationTable> InterpolationTable;
+
+  /*! Parameters that the current InterpolationTable is computed from */
+  std::string InterpolationTableGeometryDescription;
+
+  /*! Scan converted image, if the interpolation table is used for resampling */
+  vtkImageData* OutputImage;
+
 private:
   vtkPlusUsScanConvertLinear(const vtkPlusUsScanConvertLinear&);  // Not implemented.
   void operator=(const vtkPlusUsScanConvertLinear&);  // Not implemented.
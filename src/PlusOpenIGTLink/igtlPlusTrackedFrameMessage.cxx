@@ -50,7 +50,8 @@ namespace igtl
   //----------------------------------------------------------------------------
   PlusStatus PlusTrackedFrameMessage::SetTrackedFrame(const PlusTrackedFrame& trackedFrame, const std::vector<PlusTransformName>& requestedTransforms)
   {
-    this->m_TrackedFrame = trackedFrame;
+    // Image pixels are copied only once, directly into the message body
+    this->m_TrackedFrame.ShallowCopy(trackedFrame);
 
     if (this->m_TrackedFrame.GetTrackedFrameInXmlData(this->m_TrackedFrameXmlData, requestedTransforms) != PLUS_SUCCESS)
     {
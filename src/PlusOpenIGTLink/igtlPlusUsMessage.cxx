@@ -95,7 +95,8 @@ PlusTrackedFrame& PlusUsMessage::GetTrackedFrame()
 //----------------------------------------------------------------------------
 PlusStatus PlusUsMessage::SetTrackedFrame( const PlusTrackedFrame& trackedFrame )
 {
-  this->m_TrackedFrame = trackedFrame;
+  // Image pixels are copied only once, directly into the message body
+  this->m_TrackedFrame.ShallowCopy( trackedFrame );
 
   double timestamp = this->m_TrackedFrame.GetTimestamp();
 
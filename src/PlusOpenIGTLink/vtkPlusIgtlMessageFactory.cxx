@@ -16,6 +16,7 @@ See License.txt for details.
 #include "vtkPlusTrackedFrameList.h"
 #include "vtkPlusTransformRepository.h"
 #include "vtksys/SystemTools.hxx"
+#include <algorithm>
 #include <typeinfo>
 
 //----------------------------------------------------------------------------
@@ -34,6 +35,35 @@ See License.txt for details.
 
 vtkStandardNewMacro(vtkPlusIgtlMessageFactory);
 
+namespace
+{
+  //----------------------------------------------------------------------------
+  // Append the message from the cache to the message list. Returns false if the message is not found in the cache.
+  bool GetPackedMessageFromCache(vtkPlusIgtlMessageFactory::PackedMessageCache* packedMessageCache, const std::string& key, std::vector<igtl::MessageBase::Pointer>& igtlMessages)
+  {
+    if (packedMessageCache == NULL)
+    {
+      return false;
+    }
+    vtkPlusIgtlMessageFactory::PackedMessageCache::iterator cachedMessage = packedMessageCache->find(key);
+    if (cachedMessage == packedMessageCache->end())
+    {
+      return false;
+    }
+    igtlMessages.push_back(cachedMessage->second);
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+  void AddPackedMessageToCache(vtkPlusIgtlMessageFactory::PackedMessageCache* packedMessageCache, const std::string& key, igtl::MessageBase::Pointer message)
+  {
+    if (packedMessageCache != NULL)
+    {
+      (*packedMessageCache)[key] = message;
+    }
+  }
+}
+
 //----------------------------------------------------------------------------
 vtkPlusIgtlMessageFactory::vtkPlusIgtlMessageFactory()
   : IgtlFactory(igtl::MessageFactory::New())
@@ -127,7 +157,7 @@ igtl::MessageBase::Pointer vtkPlusIgtlMessageFactory::CreateSendMessage(const st
 
 //----------------------------------------------------------------------------
 PlusStatus vtkPlusIgtlMessageFactory::PackMessages(const PlusIgtlClientInfo& clientInfo, std::vector<igtl::MessageBase::Pointer>& igtlMessages, PlusTrackedFrame& trackedFrame,
-    bool packValidTransformsOnly, vtkPlusTransformRepository* transformRepository/*=NULL*/)
+    bool packValidTransformsOnly, vtkPlusTransformRepository* transformRepository/*=NULL*/, PackedMessageCache* packedMessageCache/*=NULL*/)
 {
   int numberOfErrors(0);
   igtlMessages.clear();
@@ -158,6 +188,10 @@ PlusStatus vtkPlusIgtlMessageFactory::PackMessages(const PlusIgtlClientInfo& cli
       continue;
     }
 
+    // Messages with the same type, header version, and content can be shared between clients
+    std::ostringstream cacheKeyPrefix;
+    cacheKeyPrefix << messageType << "/" << clientInfo.ClientHeaderVersion << "/";
+
     // Image message
     if (typeid(*igtlMessage) == typeid(igtl::ImageMessage))
     {
@@ -168,6 +202,12 @@ PlusStatus vtkPlusIgtlMessageFactory::PackMessages(const PlusIgtlClientInfo& cli
         //Set transform name to [Name]To[CoordinateFrame]
         PlusTransformName imageTransformName = PlusTransformName(imageStream.Name, imageStream.EmbeddedTransformToFrame);
 
+        std::string cacheKey = cacheKeyPrefix.str() + imageStream.Name + "/" + imageStream.EmbeddedTransformToFrame;
+        if (GetPackedMessageFromCache(packedMessageCache, cacheKey, igtlMessages))
+        {
+          continue;
+        }
+
         vtkSmartPointer<vtkMatrix4x4> matrix = vtkSmartPointer<vtkMatrix4x4>::New();
         bool isValid;
         if (transformRepository->GetTransform(imageTransformName, matrix.Get(), &isValid) != PLUS_SUCCESS)
@@ -193,6 +233,7 @@ PlusStatus vtkPlusIgtlMessageFactory::PackMessages(const PlusIgtlClientInfo& cli
           continue;
         }
         igtlMessages.push_back(imageMessage.GetPointer());
+        AddPackedMessageToCache(packedMessageCache, cacheKey, imageMessage.GetPointer());
       }
     }
     // Transform message
@@ -210,12 +251,19 @@ PlusStatus vtkPlusIgtlMessageFactory::PackMessages(const PlusIgtlClientInfo& cli
           continue;
         }
 
+        std::string cacheKey = cacheKeyPrefix.str() + transformName.GetTransformName();
+        if (GetPackedMessageFromCache(packedMessageCache, cacheKey, igtlMessages))
+        {
+          continue;
+        }
+
         igtl::Matrix4x4 igtlMatrix;
         vtkPlusIgtlMessageCommon::GetIgtlMatrix(igtlMatrix, transformRepository, transformName);
 
         igtl::TransformMessage::Pointer transformMessage = dynamic_cast<igtl::TransformMessage*>(igtlMessage->Clone().GetPointer());
         vtkPlusIgtlMessageCommon::PackTransformMessage(transformMessage, transformName, igtlMatrix, trackedFrame.GetTimestamp());
         igtlMessages.push_back(transformMessage.GetPointer());
+        AddPackedMessageToCache(packedMessageCache, cacheKey, transformMessage.GetPointer());
       }
     }
     // Tracking data message
@@ -223,6 +271,16 @@ PlusStatus vtkPlusIgtlMessageFactory::PackMessages(const PlusIgtlClientInfo& cli
     {
       if (clientInfo.TDATARequested && clientInfo.LastTDATASentTimeStamp + clientInfo.Resolution < trackedFrame.GetTimestamp())
       {
+        std::string cacheKey = cacheKeyPrefix.str();
+        for (std::vector<PlusTransformName>::const_iterator transformNameIterator = clientInfo.TransformNames.begin(); transformNameIterator != clientInfo.TransformNames.end(); ++transformNameIterator)
+        {
+          cacheKey += transformNameIterator->GetTransformName() + "/";
+        }
+        if (GetPackedMessageFromCache(packedMessageCache, cacheKey, igtlMessages))
+        {
+          continue;
+        }
+
         std::map<std::string, vtkSmartPointer<vtkMatrix4x4> > transforms;
         for (std::vector<PlusTransformName>::const_iterator transformNameIterator = clientInfo.TransformNames.begin(); transformNameIterator != clientInfo.TransformNames.end(); ++transformNameIterator)
         {
@@ -247,6 +305,7 @@ PlusStatus vtkPlusIgtlMessageFactory::PackMessages(const PlusIgtlClientInfo& cli
         igtl::TrackingDataMessage::Pointer trackingDataMessage = dynamic_cast<igtl::TrackingDataMessage*>(igtlMessage->Clone().GetPointer());
         vtkPlusIgtlMessageCommon::PackTrackingDataMessage(trackingDataMessage, transforms, trackedFrame.GetTimestamp());
         igtlMessages.push_back(trackingDataMessage.GetPointer());
+        AddPackedMessageToCache(packedMessageCache, cacheKey, trackingDataMessage.GetPointer());
       }
     }
     // Position message
@@ -261,6 +320,12 @@ PlusStatus vtkPlusIgtlMessageFactory::PackMessages(const PlusIgtlClientInfo& cli
           pushing high frame-rate data from tracking devices.
         */
         PlusTransformName transformName = (*transformNameIterator);
+        std::string cacheKey = cacheKeyPrefix.str() + transformName.GetTransformName();
+        if (GetPackedMessageFromCache(packedMessageCache, cacheKey, igtlMessages))
+        {
+          continue;
+        }
+
         igtl::Matrix4x4 igtlMatrix;
         vtkPlusIgtlMessageCommon::GetIgtlMatrix(igtlMatrix, transformRepository, transformName);
 
@@ -271,13 +336,13 @@ PlusStatus vtkPlusIgtlMessageFactory::PackMessages(const PlusIgtlClientInfo& cli
         igtl::PositionMessage::Pointer positionMessage = dynamic_cast<igtl::PositionMessage*>(igtlMessage->Clone().GetPointer());
         vtkPlusIgtlMessageCommon::PackPositionMessage(positionMessage, transformName, position, quaternion, trackedFrame.GetTimestamp());
         igtlMessages.push_back(positionMessage.GetPointer());
+        AddPackedMessageToCache(packedMessageCache, cacheKey, positionMessage.GetPointer());
       }
     }
     // TRACKEDFRAME message
     else if (typeid(*igtlMessage) == typeid(igtl::PlusTrackedFrameMessage))
     {
-      igtl::PlusTrackedFrameMessage::Pointer trackedFrameMessage = dynamic_cast<igtl::PlusTrackedFrameMessage*>(igtlMessage->Clone().GetPointer());
-
+      std::vector<std::string> requestedTransformNames;
       for (auto nameIter = clientInfo.TransformNames.begin(); nameIter != clientInfo.TransformNames.end(); ++nameIter)
       {
         bool isValid(false);
@@ -285,7 +350,29 @@ PlusStatus vtkPlusIgtlMessageFactory::PackMessages(const PlusIgtlClientInfo& cli
         transformRepository->GetTransform(*nameIter, matrix, &isValid);
         trackedFrame.SetCustomFrameTransform(*nameIter, matrix);
         trackedFrame.SetCustomFrameTransformStatus(*nameIter, isValid ? FIELD_OK : FIELD_INVALID);
+        requestedTransformNames.push_back(nameIter->GetTransformName());
+      }
+
+      // The message is shared by clients that request the same device, image streams and set of transforms (in any order)
+      std::sort(requestedTransformNames.begin(), requestedTransformNames.end());
+      std::ostringstream cacheKeyStream;
+      cacheKeyStream << cacheKeyPrefix.str() << igtlMessage->GetDeviceName() << "/";
+      for (auto imageStreamIter = clientInfo.ImageStreams.begin(); imageStreamIter != clientInfo.ImageStreams.end(); ++imageStreamIter)
+      {
+        cacheKeyStream << imageStreamIter->Name << "To" << imageStreamIter->EmbeddedTransformToFrame << ";";
       }
+      cacheKeyStream << "/";
+      for (auto nameIter = requestedTransformNames.begin(); nameIter != requestedTransformNames.end(); ++nameIter)
+      {
+        cacheKeyStream << *nameIter << ";";
+      }
+      std::string cacheKey = cacheKeyStream.str();
+      if (GetPackedMessageFromCache(packedMessageCache, cacheKey, igtlMessages))
+      {
+        continue;
+      }
+
+      igtl::PlusTrackedFrameMessage::Pointer trackedFrameMessage = dynamic_cast<igtl::PlusTrackedFrameMessage*>(igtlMessage->Clone().GetPointer());
 
       vtkSmartPointer<vtkMatrix4x4> imageMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
       imageMatrix->Identity();
@@ -305,10 +392,16 @@ PlusStatus vtkPlusIgtlMessageFactory::PackMessages(const PlusIgtlClientInfo& cli
         continue;
       }
       igtlMessages.push_back(trackedFrameMessage.GetPointer());
+      AddPackedMessageToCache(packedMessageCache, cacheKey, trackedFrameMessage.GetPointer());
     }
     // USMESSAGE message
     else if (typeid(*igtlMessage) == typeid(igtl::PlusUsMessage))
     {
+      std::string cacheKey = cacheKeyPrefix.str();
+      if (GetPackedMessageFromCache(packedMessageCache, cacheKey, igtlMessages))
+      {
+        continue;
+      }
       igtl::PlusUsMessage::Pointer usMessage = dynamic_cast<igtl::PlusUsMessage*>(igtlMessage->Clone().GetPointer());
       if (vtkPlusIgtlMessageCommon::PackUsMessage(usMessage, trackedFrame) != PLUS_SUCCESS)
       {
@@ -317,6 +410,7 @@ PlusStatus vtkPlusIgtlMessageFactory::PackMessages(const PlusIgtlClientInfo& cli
         continue;
       }
       igtlMessages.push_back(usMessage.GetPointer());
+      AddPackedMessageToCache(packedMessageCache, cacheKey, usMessage.GetPointer());
     }
     // String message
     else if (typeid(*igtlMessage) == typeid(igtl::StringMessage))
@@ -330,9 +424,15 @@ PlusStatus vtkPlusIgtlMessageFactory::PackMessages(const PlusIgtlClientInfo& cli
           // no value is available, do not send anything
           continue;
         }
+        std::string cacheKey = cacheKeyPrefix.str() + stringName;
+        if (GetPackedMessageFromCache(packedMessageCache, cacheKey, igtlMessages))
+        {
+          continue;
+        }
         igtl::StringMessage::Pointer stringMessage = dynamic_cast<igtl::StringMessage*>(igtlMessage->Clone().GetPointer());
         vtkPlusIgtlMessageCommon::PackStringMessage(stringMessage, stringName, stringValue, trackedFrame.GetTimestamp());
         igtlMessages.push_back(stringMessage.GetPointer());
+        AddPackedMessageToCache(packedMessageCache, cacheKey, stringMessage.GetPointer());
       }
     }
     else if (typeid(*igtlMessage) == typeid(igtl::CommandMessage))
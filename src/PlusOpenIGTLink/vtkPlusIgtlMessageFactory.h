@@ -14,6 +14,7 @@
 #include "igtlMessageBase.h"
 #include "igtlMessageFactory.h"
 #include "PlusIgtlClientInfo.h" 
+#include <map>
 
 class vtkXMLDataElement; 
 class PlusTrackedFrame; 
@@ -63,6 +64,12 @@ public:
   /// Creates message, sets header onto message and calls AllocateBuffer() on the message.
   igtl::MessageBase::Pointer CreateSendMessage(const std::string& messageType, int headerVersion) const;
 
+  /*!
+    Messages that are already packed from a tracked frame, indexed by message type, header version, and content names.
+    The packed messages must not be modified, as they may be sent to multiple clients.
+  */
+  typedef std::map<std::string, igtl::MessageBase::Pointer> PackedMessageCache;
+
   /*! 
   Generate and pack IGTL messages from tracked frame
   \param packValidTransformsOnly Control whether or not to pack transform messages if they contain invalid transforms
@@ -70,9 +77,11 @@ public:
   \param igtMessages Output list for the generated IGTL messages
   \param trackedFrame Input tracked frame data used for IGTL message generation 
   \param transformRepository Transform repository used for computing the selected transforms 
+  \param packedMessageCache If not NULL then messages found in the cache are reused instead of packed again and newly packed messages are added
+    to the cache. Use the same cache for all the clients that a tracked frame is sent to and clear it before packing the next tracked frame.
   */ 
   PlusStatus PackMessages(const PlusIgtlClientInfo& clientInfo, std::vector<igtl::MessageBase::Pointer>& igtMessages, PlusTrackedFrame& trackedFrame, 
-    bool packValidTransformsOnly, vtkPlusTransformRepository* transformRepository=NULL); 
+    bool packValidTransformsOnly, vtkPlusTransformRepository* transformRepository=NULL, PackedMessageCache* packedMessageCache=NULL); 
 
 protected:
   vtkPlusIgtlMessageFactory();
@@ -33,6 +33,7 @@ vtkStandardNewMacro(vtkPlusReconstructVolumeCommand);
 //----------------------------------------------------------------------------
 vtkPlusReconstructVolumeCommand::vtkPlusReconstructVolumeCommand()
   : ApplyHoleFilling(true)
+  , FullResolution(false)
 {
   this->OutputOrigin[0] = UNDEFINED_VALUE;
   this->OutputOrigin[1] = UNDEFINED_VALUE;
@@ -129,7 +130,7 @@ std::string vtkPlusReconstructVolumeCommand::GetDescription(const std::string& c
   if (commandName.empty() || PlusCommon::IsEqualInsensitive(commandName, GET_LIVE_RECONSTRUCTION_SNAPSHOT_CMD))
   {
     desc += GET_LIVE_RECONSTRUCTION_SNAPSHOT_CMD;
-    desc += ": Request a snapshot of the live reconstruction result. Attributes: VolumeReconstructorDeviceId: ID of the volume reconstructor device. OutputVolFilename: name of the output volume file name (optional). OutputVolDeviceName: name of the OpenIGTLink device for the IMAGE message (optional). ApplyHoleFilling: if FALSE then holes will not be filled (optional, default: TRUE).";
+    desc += ": Request a snapshot of the live reconstruction result. Attributes: VolumeReconstructorDeviceId: ID of the volume reconstructor device. OutputVolFilename: name of the output volume file name (optional). OutputVolDeviceName: name of the OpenIGTLink device for the IMAGE message (optional). ApplyHoleFilling: if FALSE then holes will not be filled (optional, default: TRUE). FullResolution: if TRUE then the full-resolution volume is returned instead of the live preview volume (optional, default: FALSE).";
   }
 
   return desc;
@@ -154,6 +155,7 @@ PlusStatus vtkPlusReconstructVolumeCommand::ReadConfiguration(vtkXMLDataElement*
   XML_READ_VECTOR_ATTRIBUTE_OPTIONAL(int, 6, OutputExtent, aConfig);
 
   XML_READ_BOOL_ATTRIBUTE_OPTIONAL(ApplyHoleFilling, aConfig);
+  XML_READ_BOOL_ATTRIBUTE_OPTIONAL(FullResolution, aConfig);
   return PLUS_SUCCESS;
 }
 
@@ -192,6 +194,7 @@ PlusStatus vtkPlusReconstructVolumeCommand::WriteConfiguration(vtkXMLDataElement
   }
 
   XML_WRITE_BOOL_ATTRIBUTE(ApplyHoleFilling, aConfig);
+  XML_WRITE_BOOL_ATTRIBUTE(FullResolution, aConfig);
 
   return PLUS_SUCCESS;
 }
@@ -324,7 +327,17 @@ PlusStatus vtkPlusReconstructVolumeCommand::Execute()
     LOG_INFO("Volume reconstruction from live frames snapshot request, device: " << reconstructorDeviceId);
     vtkSmartPointer<vtkImageData> volumeToSend = vtkSmartPointer<vtkImageData>::New();
     std::string errorMessage;
-    if (reconstructorDevice->GetReconstructedVolume(volumeToSend, errorMessage, this->ApplyHoleFilling) != PLUS_SUCCESS)
+    PlusStatus volumeStatus = PLUS_FAIL;
+    if (this->FullResolution)
+    {
+      volumeStatus = reconstructorDevice->GetReconstructedVolume(volumeToSend, errorMessage, this->ApplyHoleFilling);
+    }
+    else
+    {
+      // Return the live preview immediately, without waiting for the full-resolution reconstruction
+      volumeStatus = reconstructorDevice->GetReconstructedVolumePreview(volumeToSend, errorMessage, this->ApplyHoleFilling);
+    }
+    if (volumeStatus != PLUS_SUCCESS)
     {
       this->QueueCommandResponse(PLUS_FAIL, "Command failed. See error message.", baseMessage + " Reconstruction snapshot request failed, device: " + errorMessage);
       return PLUS_FAIL;
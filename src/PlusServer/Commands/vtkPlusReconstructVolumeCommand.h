@@ -87,6 +87,13 @@ public:
   vtkGetMacro(ApplyHoleFilling, bool);
   vtkSetMacro(ApplyHoleFilling, bool);
 
+  /*!
+    If false (default) then the snapshot contains the live preview volume (if the reconstructor device has a preview volume),
+    otherwise the full-resolution volume is returned, after all the queued frames are inserted.
+  */
+  vtkGetMacro(FullResolution, bool);
+  vtkSetMacro(FullResolution, bool);
+
   void SetNameToReconstruct();
   void SetNameToStart();
   void SetNameToStop();
@@ -115,6 +122,7 @@ protected:
   int OutputExtent[6];
 
   bool ApplyHoleFilling;
+  bool FullResolution;
 
   vtkPlusReconstructVolumeCommand(const vtkPlusReconstructVolumeCommand&);
   void operator=(const vtkPlusReconstructVolumeCommand&);
@@ -17,6 +17,9 @@ See License.txt for details.
 #include <vtkSmartPointer.h>
 #include <vtksys/CommandLineArguments.hxx>
 
+// OpenIGTLink includes
+#include <igtlClientSocket.h>
+
 // -------------------------------------------------
 PlusStatus ConnectClients(int listeningPort, std::vector< vtkSmartPointer<vtkPlusOpenIGTLinkVideoSource> >& testClientList, int numberOfClientsToConnect, vtkSmartPointer<vtkXMLDataElement> configRootElement)
 {
@@ -108,6 +111,151 @@ PlusStatus DisconnectClients(std::vector< vtkSmartPointer<vtkPlusOpenIGTLinkVide
   return (numberOfErrors == 0 ? PLUS_SUCCESS : PLUS_FAIL);
 }
 
+// -------------------------------------------------
+void WaitWithServerProcessing(vtkPlusOpenIGTLinkServer* server, double waitTimeSec)
+{
+  const double commandQueuePollIntervalSec = 0.010;
+  const double startTime = vtkPlusAccurateTimer::GetSystemTime();
+  while (vtkPlusAccurateTimer::GetSystemTime() < startTime + waitTimeSec)
+  {
+    server->ProcessPendingCommands();
+
+    // Need to process messages while waiting because some devices (such as the vtkPlusWin32VideoSource2) require event processing
+    vtkPlusAccurateTimer::DelayWithEventProcessing(commandQueuePollIntervalSec);
+  }
+}
+
+// -------------------------------------------------
+PlusStatus WaitForNumberOfConnectedClients(vtkPlusOpenIGTLinkServer* server, unsigned int expectedNumberOfClients, double timeoutSec)
+{
+  const double startTime = vtkPlusAccurateTimer::GetSystemTime();
+  while (server->GetNumberOfConnectedClients() != expectedNumberOfClients)
+  {
+    if (vtkPlusAccurateTimer::GetSystemTime() > startTime + timeoutSec)
+    {
+      LOG_ERROR("Number of connected clients is " << server->GetNumberOfConnectedClients() << " instead of " << expectedNumberOfClients << " after " << timeoutSec << " seconds");
+      return PLUS_FAIL;
+    }
+    WaitWithServerProcessing(server, 0.1);
+  }
+  return PLUS_SUCCESS;
+}
+
+// -------------------------------------------------
+PlusStatus GetLatestFrameUids(std::vector< vtkSmartPointer<vtkPlusOpenIGTLinkVideoSource> >& testClientList, std::vector<BufferItemUidType>& latestUids)
+{
+  latestUids.clear();
+  for (unsigned int i = 0; i < testClientList.size(); ++i)
+  {
+    vtkPlusChannel* aChannel = *(testClientList[i]->GetOutputChannelsStart());
+    vtkPlusDataSource* aSource(NULL);
+    if (aChannel->GetVideoSource(aSource) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Unable to retrieve the video source of client #" << i + 1);
+      return PLUS_FAIL;
+    }
+    latestUids.push_back(aSource->GetLatestItemUidInBuffer());
+  }
+  return PLUS_SUCCESS;
+}
+
+// -------------------------------------------------
+/*!
+  Check that the clients keep receiving frames at least at the specified fraction of the reference frame rate
+  while slow clients are connected and when a client disconnects while data is being sent to it.
+*/
+PlusStatus TestSlowClients(vtkPlusOpenIGTLinkServer* server, std::vector< vtkSmartPointer<vtkPlusOpenIGTLinkVideoSource> >& testClientList)
+{
+  const double MEASUREMENT_TIME_SEC = 3.0;
+  const double DISCONNECT_TIMEOUT_SEC = 30.0;
+  const double MIN_RELATIVE_FRAME_RATE = 0.5;
+
+  // Reference number of received frames without slow clients
+  std::vector<BufferItemUidType> startUids;
+  std::vector<BufferItemUidType> endUids;
+  if (GetLatestFrameUids(testClientList, startUids) != PLUS_SUCCESS)
+  {
+    return PLUS_FAIL;
+  }
+  WaitWithServerProcessing(server, MEASUREMENT_TIME_SEC);
+  if (GetLatestFrameUids(testClientList, endUids) != PLUS_SUCCESS)
+  {
+    return PLUS_FAIL;
+  }
+  std::vector<BufferItemUidType> referenceNumberOfFrames;
+  for (unsigned int i = 0; i < testClientList.size(); ++i)
+  {
+    referenceNumberOfFrames.push_back(endUids[i] - startUids[i]);
+  }
+
+  // Connect a client that never reads data and a client that disconnects while data is being sent to it
+  igtl::ClientSocket::Pointer slowClientSocket = igtl::ClientSocket::New();
+  igtl::ClientSocket::Pointer disconnectingClientSocket = igtl::ClientSocket::New();
+  if (slowClientSocket->ConnectToServer("127.0.0.1", server->GetListeningPort()) != 0
+      || disconnectingClientSocket->ConnectToServer("127.0.0.1", server->GetListeningPort()) != 0)
+  {
+    LOG_ERROR("Slow clients couldn't connect to server");
+    return PLUS_FAIL;
+  }
+  if (WaitForNumberOfConnectedClients(server, testClientList.size() + 2, DISCONNECT_TIMEOUT_SEC) != PLUS_SUCCESS)
+  {
+    return PLUS_FAIL;
+  }
+
+  if (GetLatestFrameUids(testClientList, startUids) != PLUS_SUCCESS)
+  {
+    return PLUS_FAIL;
+  }
+  WaitWithServerProcessing(server, MEASUREMENT_TIME_SEC / 2);
+  disconnectingClientSocket->CloseSocket();
+  WaitWithServerProcessing(server, MEASUREMENT_TIME_SEC / 2);
+  if (GetLatestFrameUids(testClientList, endUids) != PLUS_SUCCESS)
+  {
+    return PLUS_FAIL;
+  }
+
+  int numberOfErrors = 0;
+  for (unsigned int i = 0; i < testClientList.size(); ++i)
+  {
+    BufferItemUidType numberOfFrames = endUids[i] - startUids[i];
+    LOG_INFO("Client #" << i + 1 << " received " << numberOfFrames << " frames with slow clients connected, " << referenceNumberOfFrames[i] << " frames without slow clients");
+    if (numberOfFrames == 0 || numberOfFrames < MIN_RELATIVE_FRAME_RATE * referenceNumberOfFrames[i])
+    {
+      LOG_ERROR("Client #" << i + 1 << " was slowed down by the slow clients");
+      ++numberOfErrors;
+    }
+  }
+
+  // Sending fails to both the closed and the never reading client (when the send timeout expires), they must be disconnected by the server
+  if (WaitForNumberOfConnectedClients(server, testClientList.size(), DISCONNECT_TIMEOUT_SEC) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Slow clients were not disconnected by the server");
+    ++numberOfErrors;
+  }
+  slowClientSocket->CloseSocket();
+
+  // The remaining clients keep receiving data
+  if (GetLatestFrameUids(testClientList, startUids) != PLUS_SUCCESS)
+  {
+    return PLUS_FAIL;
+  }
+  WaitWithServerProcessing(server, MEASUREMENT_TIME_SEC);
+  if (GetLatestFrameUids(testClientList, endUids) != PLUS_SUCCESS)
+  {
+    return PLUS_FAIL;
+  }
+  for (unsigned int i = 0; i < testClientList.size(); ++i)
+  {
+    if (endUids[i] == startUids[i])
+    {
+      LOG_ERROR("Client #" << i + 1 << " stopped receiving frames after the slow clients were disconnected");
+      ++numberOfErrors;
+    }
+  }
+
+  return (numberOfErrors == 0 ? PLUS_SUCCESS : PLUS_FAIL);
+}
+
 // -------------------------------------------------
 vtkSmartPointer<vtkPlusOpenIGTLinkServer> StartServer(const std::string& inputConfigFileName)
 {
@@ -199,6 +347,7 @@ int main(int argc, char** argv)
   bool printHelp(false);
   std::string inputConfigFileName;
   std::string testingConfigFileName;
+  bool testSlowClients(false);
   int verboseLevel = vtkPlusLogger::LOG_LEVEL_UNDEFINED;
 
   const double WAIT_TIME_SEC = 5.0;
@@ -211,6 +360,7 @@ int main(int argc, char** argv)
   args.AddArgument("--server-config-file", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &inputConfigFileName, "Name of the server configuration file.");
   args.AddArgument("--verbose", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &verboseLevel, "Verbose level (1=error only, 2=warning, 3=info, 4=debug, 5=trace)");
   args.AddArgument("--testing-config-file", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &testingConfigFileName, "Name of the testing configuration file");
+  args.AddArgument("--test-slow-clients", vtksys::CommandLineArguments::NO_ARGUMENT, &testSlowClients, "Test that a client that does not read data or disconnects while data is sent does not slow down the other clients.");
 
   if (!args.Parse())
   {
@@ -267,18 +417,21 @@ int main(int argc, char** argv)
   }
   LOG_INFO("Clients are connected");
 
-  const double commandQueuePollIntervalSec = 0.010;
-  const double startTime = vtkPlusAccurateTimer::GetSystemTime();
-  while (vtkPlusAccurateTimer::GetSystemTime() < startTime + WAIT_TIME_SEC)
-  {
-    server->ProcessPendingCommands();
-
-    // Need to process messages while waiting because some devices (such as the vtkPlusWin32VideoSource2) require event processing
-    vtkPlusAccurateTimer::DelayWithEventProcessing(commandQueuePollIntervalSec);
-  }
+  WaitWithServerProcessing(server, WAIT_TIME_SEC);
 
   LOG_INFO("Requested testing time elapsed");
 
+  if (testSlowClients)
+  {
+    if (TestSlowClients(server, outTestClients) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Slow client test failed");
+      DisconnectClients(outTestClients);
+      exit(EXIT_FAILURE);
+    }
+    LOG_INFO("Slow client test completed successfully");
+  }
+
   // Make sure all the clients are still connected
   unsigned int numOfActuallyConnectedClients = server->GetNumberOfConnectedClients();
   if (numOfActuallyConnectedClients != outTestClients.size())
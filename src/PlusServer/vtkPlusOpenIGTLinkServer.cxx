@@ -13,6 +13,7 @@ See License.txt for details.
 #include "vtkPlusDataCollector.h"
 #include "vtkPlusIgtlMessageCommon.h"
 #include "vtkPlusIgtlMessageFactory.h"
+#include "vtkPlusNewItemSignal.h"
 #include "vtkPlusOpenIGTLinkServer.h"
 #include "vtkPlusRecursiveCriticalSection.h"
 #include "vtkPlusTrackedFrameList.h"
@@ -70,6 +71,7 @@ vtkPlusOpenIGTLinkServer::vtkPlusOpenIGTLinkServer()
   , TransformRepository(NULL)
   , DataCollector(NULL)
   , Threader(vtkSmartPointer<vtkMultiThreader>::New())
+  , ClientDataSenderThreader(vtkSmartPointer<vtkMultiThreader>::New())
   , IGTLProtocolVersion(OpenIGTLink_PROTOCOL_VERSION)
   , ListeningPort(-1)
   , NumberOfRetryAttempts(10)
@@ -84,6 +86,10 @@ vtkPlusOpenIGTLinkServer::vtkPlusOpenIGTLinkServer()
   , LastSentTrackedFrameTimestamp(0)
   , MaxTimeSpentWithProcessingMs(50)
   , LastProcessingTimePerFrameMs(-1)
+  , SendOnNewData(true)
+  , NewDataSignal(vtkSmartPointer<vtkPlusNewItemSignal>::New())
+  , ClientSendQueueSize(10)
+  , DropOldestFramesWhenQueueIsFull(true)
   , SendValidTransformsOnly(true)
   , DefaultClientSendTimeoutSec(CLIENT_SOCKET_TIMEOUT_SEC)
   , DefaultClientReceiveTimeoutSec(CLIENT_SOCKET_TIMEOUT_SEC)
@@ -131,8 +137,12 @@ PlusStatus vtkPlusOpenIGTLinkServer::QueueMessageResponseForClient(int clientId,
     return PLUS_FAIL;
   }
 
-  PlusLockGuard<vtkPlusRecursiveCriticalSection> mutexGuardedLock(this->MessageResponseQueueMutex);
-  this->MessageResponseQueue[clientId].push_back(message);
+  {
+    PlusLockGuard<vtkPlusRecursiveCriticalSection> mutexGuardedLock(this->MessageResponseQueueMutex);
+    this->MessageResponseQueue[clientId].push_back(message);
+  }
+  // Wake up the data sender thread to send the response
+  this->NewDataSignal->Notify();
 
   return PLUS_SUCCESS;
 }
@@ -183,6 +193,8 @@ PlusStatus vtkPlusOpenIGTLinkServer::StopOpenIGTLinkService()
   if (this->ConnectionReceiverThreadId >= 0)
   {
     this->ConnectionActive.first = false;
+    // Wake up the data sender thread so that it can stop
+    this->NewDataSignal->Notify();
     while (this->ConnectionActive.second)
     {
       // Wait until the thread stops
@@ -247,6 +259,8 @@ void* vtkPlusOpenIGTLinkServer::ConnectionReceiverThread(vtkMultiThreader::Threa
       client->ClientSocket->SetSendTimeout(self->DefaultClientSendTimeoutSec * 1000);
       client->ClientInfo = self->DefaultClientInfo;
       client->Server = self;
+      client->SendQueueMutex = vtkSmartPointer<vtkPlusRecursiveCriticalSection>::New();
+      client->SendQueueSignal = vtkSmartPointer<vtkPlusNewItemSignal>::New();
 
       int port = 0;
       std::string address = "unknown";
@@ -255,8 +269,13 @@ void* vtkPlusOpenIGTLinkServer::ConnectionReceiverThread(vtkMultiThreader::Threa
 #endif
       LOG_INFO("Received new client connection (client " << client->ClientId << " at " << address << ":" << port << "). Number of connected clients: " << self->GetNumberOfConnectedClients());
 
-      client->DataReceiverActive.first = true;
+      // The threads are marked as running before they are spawned, so that the client is not removed before the threads start
+      client->DataReceiverActive = std::make_pair(true, true);
       client->DataReceiverThreadId = self->Threader->SpawnThread((vtkThreadFunctionType)&DataReceiverThread, client);
+
+      // Each client has its own sender thread, so that a slow client does not delay sending data to other clients
+      client->DataSenderActive = std::make_pair(true, true);
+      client->DataSenderThreadId = self->ClientDataSenderThreader->SpawnThread((vtkThreadFunctionType)&ClientDataSenderThread, client);
     }
   }
 
@@ -330,6 +349,10 @@ void* vtkPlusOpenIGTLinkServer::DataSenderThread(vtkMultiThreader::ThreadInfo* d
   if (self->BroadcastChannel)
   {
     self->BroadcastChannel->GetMostRecentTimestamp(self->LastSentTrackedFrameTimestamp);
+    if (self->SendOnNewData)
+    {
+      self->BroadcastChannel->AddNewItemSignal(self->NewDataSignal);
+    }
   }
 
   double elapsedTimeSinceLastPacketSentSec = 0;
@@ -363,7 +386,15 @@ void* vtkPlusOpenIGTLinkServer::DataSenderThread(vtkMultiThreader::ThreadInfo* d
 
     // Send image/tracking/string data
     SendLatestFramesToClients(*self, elapsedTimeSinceLastPacketSentSec);
+
+    self->DisconnectFailedClients();
   }
+
+  if (self->BroadcastChannel)
+  {
+    self->BroadcastChannel->RemoveNewItemSignal(self->NewDataSignal);
+  }
+
   // Close thread
   self->DataSenderThreadId = -1;
   self->DataSenderActive.second = false;
@@ -375,6 +406,8 @@ PlusStatus vtkPlusOpenIGTLinkServer::SendLatestFramesToClients(vtkPlusOpenIGTLin
 {
   vtkSmartPointer<vtkPlusTrackedFrameList> trackedFrameList = vtkSmartPointer<vtkPlusTrackedFrameList>::New();
   double startTimeSec = vtkPlusAccurateTimer::GetSystemTime();
+  // Read the notification counter before getting the frames, so that frames that arrive during sending are not missed
+  unsigned long long lastNewDataNotificationCount = self.NewDataSignal->GetNotificationCount();
 
   // Acquire tracked frames since last acquisition (minimum 1 frame)
   if (self.LastProcessingTimePerFrameMs < 1)
@@ -419,7 +452,15 @@ PlusStatus vtkPlusOpenIGTLinkServer::SendLatestFramesToClients(vtkPlusOpenIGTLin
   // There is no new frame in the buffer
   if (trackedFrameList->GetNumberOfTrackedFrames() == 0)
   {
-    vtkPlusAccurateTimer::Delay(DELAY_ON_NO_NEW_FRAMES_SEC);
+    if (self.SendOnNewData && self.BroadcastChannel != NULL)
+    {
+      // Command responses are not notified, so do not wait longer than the polling period
+      self.NewDataSignal->WaitForNewItem(lastNewDataNotificationCount, DELAY_ON_NO_NEW_FRAMES_SEC);
+    }
+    else
+    {
+      vtkPlusAccurateTimer::Delay(DELAY_ON_NO_NEW_FRAMES_SEC);
+    }
     elapsedTimeSinceLastPacketSentSec += vtkPlusAccurateTimer::GetSystemTime() - startTimeSec;
 
     // Send keep alive packet to clients
@@ -460,17 +501,17 @@ PlusStatus vtkPlusOpenIGTLinkServer::SendMessageResponses(vtkPlusOpenIGTLinkServ
     for (ClientIdToMessageListMap::iterator it = self.MessageResponseQueue.begin(); it != self.MessageResponseQueue.end(); ++it)
     {
       PlusLockGuard<vtkPlusRecursiveCriticalSection> igtlClientsMutexGuardedLock(self.IgtlClientsMutex);
-      igtl::ClientSocket::Pointer clientSocket = NULL;
+      ClientData* client = NULL;
 
       for (std::list<ClientData>::iterator clientIterator = self.IgtlClients.begin(); clientIterator != self.IgtlClients.end(); ++clientIterator)
       {
         if (clientIterator->ClientId == it->first)
         {
-          clientSocket = clientIterator->ClientSocket;
+          client = &(*clientIterator);
           break;
         }
       }
-      if (clientSocket.IsNull())
+      if (client == NULL)
       {
         LOG_WARNING("Message reply cannot be sent to client " << it->first << ", probably client has been disconnected.");
         continue;
@@ -478,7 +519,7 @@ PlusStatus vtkPlusOpenIGTLinkServer::SendMessageResponses(vtkPlusOpenIGTLinkServ
 
       for (std::vector<igtl::MessageBase::Pointer>::iterator messageIt = it->second.begin(); messageIt != it->second.end(); ++messageIt)
       {
-        clientSocket->Send((*messageIt)->GetBufferPointer(), (*messageIt)->GetBufferSize());
+        QueueResponseMessage(*client, *messageIt);
       }
     }
     self.MessageResponseQueue.clear();
@@ -507,22 +548,22 @@ PlusStatus vtkPlusOpenIGTLinkServer::SendCommandResponses(vtkPlusOpenIGTLinkServ
       // Only send the response to the client that requested the command
       LOG_DEBUG("Send command reply to client " << (*responseIt)->GetClientId() << ": " << igtlResponseMessage->GetDeviceName());
       PlusLockGuard<vtkPlusRecursiveCriticalSection> igtlClientsMutexGuardedLock(self.IgtlClientsMutex);
-      igtl::ClientSocket::Pointer clientSocket = NULL;
+      ClientData* client = NULL;
       for (std::list<ClientData>::iterator clientIterator = self.IgtlClients.begin(); clientIterator != self.IgtlClients.end(); ++clientIterator)
       {
         if (clientIterator->ClientId == (*responseIt)->GetClientId())
         {
-          clientSocket = clientIterator->ClientSocket;
+          client = &(*clientIterator);
           break;
         }
       }
 
-      if (clientSocket.IsNull())
+      if (client == NULL)
       {
         LOG_WARNING("Message reply cannot be sent to client " << (*responseIt)->GetClientId() << ", probably client has been disconnected");
         continue;
       }
-      clientSocket->Send(igtlResponseMessage->GetBufferPointer(), igtlResponseMessage->GetBufferSize());
+      QueueResponseMessage(*client, igtlResponseMessage);
     }
   }
 
@@ -841,56 +882,57 @@ PlusStatus vtkPlusOpenIGTLinkServer::SendTrackedFrame(PlusTrackedFrame& trackedF
   double timestampUniversal = vtkPlusAccurateTimer::GetUniversalTimeFromSystemTime(timestampSystem);
   trackedFrame.SetTimestamp(timestampUniversal);
 
-  std::vector<int> disconnectedClientIds;
   {
-    // Lock before we send message to the clients
+    // Messages are packed only once for all the clients that requested the same content
+    vtkPlusIgtlMessageFactory::PackedMessageCache packedMessageCache;
+
+    // Lock before we queue messages for the clients
     PlusLockGuard<vtkPlusRecursiveCriticalSection> igtlClientsMutexGuardedLock(this->IgtlClientsMutex);
     for (std::list<ClientData>::iterator clientIterator = this->IgtlClients.begin(); clientIterator != this->IgtlClients.end(); ++clientIterator)
     {
-      igtl::ClientSocket::Pointer clientSocket = (*clientIterator).ClientSocket;
+      if (clientIterator->DisconnectRequested)
+      {
+        // The client is being disconnected
+        continue;
+      }
 
       // Create IGT messages
-      std::vector<igtl::MessageBase::Pointer> igtlMessages;
-      std::vector<igtl::MessageBase::Pointer>::iterator igtlMessageIterator;
-
-      if (this->IgtlMessageFactory->PackMessages(clientIterator->ClientInfo, igtlMessages, trackedFrame, this->SendValidTransformsOnly, this->TransformRepository) != PLUS_SUCCESS)
+      ClientFrameMessages frameMessages;
+      frameMessages.TimestampSystem = timestampSystem;
+      if (this->IgtlMessageFactory->PackMessages(clientIterator->ClientInfo, frameMessages.Messages, trackedFrame, this->SendValidTransformsOnly, this->TransformRepository, &packedMessageCache) != PLUS_SUCCESS)
       {
         LOG_WARNING("Failed to pack all IGT messages");
       }
+      if (frameMessages.Messages.empty())
+      {
+        continue;
+      }
+
+      // Update the TDATA timestamp, even if TDATA isn't sent (cheaper than checking for existing TDATA message type)
+      clientIterator->ClientInfo.LastTDATASentTimeStamp = trackedFrame.GetTimestamp();
 
-      // Send all messages to a client
-      for (igtlMessageIterator = igtlMessages.begin(); igtlMessageIterator != igtlMessages.end(); ++igtlMessageIterator)
+      // Queue the messages, the client's data sender thread will send them
       {
-        igtl::MessageBase::Pointer igtlMessage = (*igtlMessageIterator);
-        if (igtlMessage.IsNull())
+        PlusLockGuard<vtkPlusRecursiveCriticalSection> sendQueueGuardedLock(clientIterator->SendQueueMutex);
+        if (this->ClientSendQueueSize > 0 && clientIterator->FrameMessageQueue.size() >= static_cast<size_t>(this->ClientSendQueueSize))
         {
-          continue;
+          // The client cannot keep up with the data rate
+          clientIterator->NumberOfDroppedFrames++;
+          if (this->DropOldestFramesWhenQueueIsFull)
+          {
+            clientIterator->FrameMessageQueue.pop_front();
+            clientIterator->FrameMessageQueue.push_back(frameMessages);
+          }
         }
-
-        int retValue = 0;
-        RETRY_UNTIL_TRUE((retValue = clientSocket->Send(igtlMessage->GetBufferPointer(), igtlMessage->GetBufferSize())) != 0, this->NumberOfRetryAttempts, this->DelayBetweenRetryAttemptsSec);
-        if (retValue == 0)
+        else
         {
-          disconnectedClientIds.push_back(clientIterator->ClientId);
-          igtl::TimeStamp::Pointer ts = igtl::TimeStamp::New();
-          igtlMessage->GetTimeStamp(ts);
-          LOG_INFO("Client disconnected - could not send " << igtlMessage->GetMessageType() << " message to client (device name: " << igtlMessage->GetDeviceName()
-                   << "  Timestamp: " << std::fixed << ts->GetTimeStamp() << ").");
-          break;
+          clientIterator->FrameMessageQueue.push_back(frameMessages);
         }
-
-        // Update the TDATA timestamp, even if TDATA isn't sent (cheaper than checking for existing TDATA message type)
-        clientIterator->ClientInfo.LastTDATASentTimeStamp = trackedFrame.GetTimestamp();
       }
+      clientIterator->SendQueueSignal->Notify();
     }
   }
 
-  // Clean up disconnected clients
-  for (std::vector< int >::iterator it = disconnectedClientIds.begin(); it != disconnectedClientIds.end(); ++it)
-  {
-    DisconnectClient(*it);
-  }
-
   // restore original timestamp
   trackedFrame.SetTimestamp(timestampSystem);
 
@@ -900,28 +942,25 @@ PlusStatus vtkPlusOpenIGTLinkServer::SendTrackedFrame(PlusTrackedFrame& trackedF
 //----------------------------------------------------------------------------
 void vtkPlusOpenIGTLinkServer::DisconnectClient(int clientId)
 {
-  // Stop the client's data receiver thread
+  // Request stop of the client's data receiver and data sender threads
   {
-    // Request thread stop
     PlusLockGuard<vtkPlusRecursiveCriticalSection> igtlClientsMutexGuardedLock(this->IgtlClientsMutex);
     for (std::list<ClientData>::iterator clientIterator = this->IgtlClients.begin(); clientIterator != this->IgtlClients.end(); ++clientIterator)
     {
-      if (clientIterator->ClientId != clientId)
+      if (clientIterator->ClientId == clientId)
       {
-        continue;
+        RequestClientThreadsStop(*clientIterator);
+        break;
       }
-      clientIterator->DataReceiverActive.first = false;
-      break;
     }
   }
 
-  // Wait for the thread to stop
-  bool clientDataReceiverThreadStillActive = false;
+  // Wait for the threads to stop, then remove the client (it may have been removed already by DisconnectFailedClients)
+  bool clientThreadStillActive = false;
   do
   {
-    clientDataReceiverThreadStillActive = false;
+    clientThreadStillActive = false;
     {
-      // check if any of the receiver threads are still active
       PlusLockGuard<vtkPlusRecursiveCriticalSection> igtlClientsMutexGuardedLock(this->IgtlClientsMutex);
       for (std::list<ClientData>::iterator clientIterator = this->IgtlClients.begin(); clientIterator != this->IgtlClients.end(); ++clientIterator)
       {
@@ -929,53 +968,75 @@ void vtkPlusOpenIGTLinkServer::DisconnectClient(int clientId)
         {
           continue;
         }
-        if (clientIterator->DataReceiverThreadId > 0)
+        if (this->ReleaseStoppedClientThreads(*clientIterator))
         {
-          if (clientIterator->DataReceiverActive.second)
-          {
-            // thread still running
-            clientDataReceiverThreadStillActive = true;
-          }
-          else
-          {
-            // thread stopped
-            clientIterator->DataReceiverThreadId = -1;
-          }
-          break;
+          this->RemoveClient(clientIterator);
+        }
+        else
+        {
+          clientThreadStillActive = true;
         }
+        break;
       }
     }
-    if (clientDataReceiverThreadStillActive)
+    if (clientThreadStillActive)
     {
       // give some time for the threads to finish
       vtkPlusAccurateTimer::DelayWithEventProcessing(0.2);
     }
   }
-  while (clientDataReceiverThreadStillActive);
+  while (clientThreadStillActive);
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusOpenIGTLinkServer::RequestClientThreadsStop(ClientData& client)
+{
+  client.DisconnectRequested = true;
+  client.DataReceiverActive.first = false;
+  client.DataSenderActive.first = false;
+  client.SendQueueSignal->Notify();
+}
+
+//----------------------------------------------------------------------------
+bool vtkPlusOpenIGTLinkServer::ReleaseStoppedClientThreads(ClientData& client)
+{
+  if (client.DataReceiverActive.second || client.DataSenderActive.second)
+  {
+    // thread still running
+    return false;
+  }
+  client.DataReceiverThreadId = -1;
+  if (client.DataSenderThreadId >= 0)
+  {
+    // Release the thread slot of the data sender thread (it has already stopped)
+    this->ClientDataSenderThreader->TerminateThread(client.DataSenderThreadId);
+    client.DataSenderThreadId = -1;
+  }
+  return true;
+}
 
-  // Close socket and remove client from the list
+//----------------------------------------------------------------------------
+std::list<ClientData>::iterator vtkPlusOpenIGTLinkServer::RemoveClient(std::list<ClientData>::iterator clientIterator)
+{
+  int clientId = clientIterator->ClientId;
   int port = 0;
   std::string address = "unknown";
+  if (clientIterator->ClientSocket.IsNotNull())
   {
-    PlusLockGuard<vtkPlusRecursiveCriticalSection> igtlClientsMutexGuardedLock(this->IgtlClientsMutex);
-    for (std::list<ClientData>::iterator clientIterator = this->IgtlClients.begin(); clientIterator != this->IgtlClients.end(); ++clientIterator)
-    {
-      if (clientIterator->ClientId != clientId)
-      {
-        continue;
-      }
-      if (clientIterator->ClientSocket.IsNotNull())
-      {
 #if (OPENIGTLINK_VERSION_MAJOR > 1) || ( OPENIGTLINK_VERSION_MAJOR == 1 && OPENIGTLINK_VERSION_MINOR > 9 ) || ( OPENIGTLINK_VERSION_MAJOR == 1 && OPENIGTLINK_VERSION_MINOR == 9 && OPENIGTLINK_VERSION_PATCH > 4 )
-        clientIterator->ClientSocket->GetSocketAddressAndPort(address, port);
+    clientIterator->ClientSocket->GetSocketAddressAndPort(address, port);
 #endif
-        clientIterator->ClientSocket->CloseSocket();
-      }
-      this->IgtlClients.erase(clientIterator);
-      break;
-    }
+    clientIterator->ClientSocket->CloseSocket();
+  }
+  if (clientIterator->NumberOfSentFrames > 0)
+  {
+    LOG_INFO("Client " << clientId << " frame latency (from acquisition to sending): mean = " << 1000.0 * clientIterator->SentFrameLatencySumSec / clientIterator->NumberOfSentFrames
+             << "ms, max = " << 1000.0 * clientIterator->SentFrameLatencyMaxSec << "ms. Sent frames: " << clientIterator->NumberOfSentFrames
+             << ", dropped frames: " << clientIterator->NumberOfDroppedFrames << ".");
   }
+  std::list<ClientData>::iterator nextClientIterator = this->IgtlClients.erase(clientIterator);
   LOG_INFO("Client disconnected (" <<  address << ":" << port << "). Number of connected clients: " << GetNumberOfConnectedClients());
+  return nextClientIterator;
 }
 
 //----------------------------------------------------------------------------
@@ -983,38 +1044,122 @@ void vtkPlusOpenIGTLinkServer::KeepAlive()
 {
   LOG_TRACE("Keep alive packet sent to clients...");
 
-  std::vector< int > disconnectedClientIds;
+  igtl::StatusMessage::Pointer replyMsg = igtl::StatusMessage::New();
+  replyMsg->SetCode(igtl::StatusMessage::STATUS_OK);
+  replyMsg->Pack();
 
+  // Lock before we queue message for the clients
+  PlusLockGuard<vtkPlusRecursiveCriticalSection> igtlClientsMutexGuardedLock(this->IgtlClientsMutex);
+  for (std::list<ClientData>::iterator clientIterator = this->IgtlClients.begin(); clientIterator != this->IgtlClients.end(); ++clientIterator)
   {
-    // Lock before we send message to the clients
-    PlusLockGuard<vtkPlusRecursiveCriticalSection> igtlClientsMutexGuardedLock(this->IgtlClientsMutex);
+    QueueResponseMessage(*clientIterator, replyMsg.GetPointer());
+  }
+}
 
-    for (std::list<ClientData>::iterator clientIterator = this->IgtlClients.begin(); clientIterator != this->IgtlClients.end(); ++clientIterator)
+//----------------------------------------------------------------------------
+void vtkPlusOpenIGTLinkServer::QueueResponseMessage(ClientData& client, igtl::MessageBase::Pointer message)
+{
+  {
+    PlusLockGuard<vtkPlusRecursiveCriticalSection> sendQueueGuardedLock(client.SendQueueMutex);
+    client.ResponseMessageQueue.push_back(message);
+  }
+  client.SendQueueSignal->Notify();
+}
+
+//----------------------------------------------------------------------------
+void* vtkPlusOpenIGTLinkServer::ClientDataSenderThread(vtkMultiThreader::ThreadInfo* data)
+{
+  ClientData* client = (ClientData*)(data->UserData);
+  client->DataSenderActive.second = true;
+  vtkPlusOpenIGTLinkServer* self = client->Server;
+
+  // Make copy of frequently used data to avoid locking of client data
+  igtl::ClientSocket::Pointer clientSocket = client->ClientSocket;
+  int clientId = client->ClientId;
+
+  unsigned long long lastNotificationCount = client->SendQueueSignal->GetNotificationCount();
+  std::vector<igtl::MessageBase::Pointer> messagesToSend;
+  while (client->DataSenderActive.first && !client->SendFailed)
+  {
+    // Send all the responses first, then the oldest tracked frame
+    double frameTimestampSystem = UNDEFINED_TIMESTAMP;
+    messagesToSend.clear();
     {
-      igtl::StatusMessage::Pointer replyMsg = igtl::StatusMessage::New();
-      replyMsg->SetCode(igtl::StatusMessage::STATUS_OK);
-      replyMsg->Pack();
+      PlusLockGuard<vtkPlusRecursiveCriticalSection> sendQueueGuardedLock(client->SendQueueMutex);
+      messagesToSend.assign(client->ResponseMessageQueue.begin(), client->ResponseMessageQueue.end());
+      client->ResponseMessageQueue.clear();
+      if (!client->FrameMessageQueue.empty())
+      {
+        ClientFrameMessages& frameMessages = client->FrameMessageQueue.front();
+        messagesToSend.insert(messagesToSend.end(), frameMessages.Messages.begin(), frameMessages.Messages.end());
+        frameTimestampSystem = frameMessages.TimestampSystem;
+        client->FrameMessageQueue.pop_front();
+      }
+    }
+
+    if (messagesToSend.empty())
+    {
+      // Wake up regularly to check if the thread has to be stopped
+      client->SendQueueSignal->WaitForNewItem(lastNotificationCount, CLIENT_SOCKET_TIMEOUT_SEC);
+      continue;
+    }
+
+    for (std::vector<igtl::MessageBase::Pointer>::iterator messageIt = messagesToSend.begin(); messageIt != messagesToSend.end(); ++messageIt)
+    {
+      igtl::MessageBase::Pointer igtlMessage = (*messageIt);
+      if (igtlMessage.IsNull())
+      {
+        continue;
+      }
 
       int retValue = 0;
-      RETRY_UNTIL_TRUE(
-        (retValue = clientIterator->ClientSocket->Send(replyMsg->GetPackPointer(), replyMsg->GetPackSize())) != 0,
-        this->NumberOfRetryAttempts, this->DelayBetweenRetryAttemptsSec);
+      RETRY_UNTIL_TRUE((retValue = clientSocket->Send(igtlMessage->GetBufferPointer(), igtlMessage->GetBufferSize())) != 0, self->NumberOfRetryAttempts, self->DelayBetweenRetryAttemptsSec);
       if (retValue == 0)
       {
-        disconnectedClientIds.push_back(clientIterator->ClientId);
         igtl::TimeStamp::Pointer ts = igtl::TimeStamp::New();
-        replyMsg->GetTimeStamp(ts);
-
-        LOG_DEBUG("Client disconnected - could not send " << replyMsg->GetMessageType() << " message to client (device name: " << replyMsg->GetDeviceName()
-                  << "  Timestamp: " << std::fixed <<  ts->GetTimeStamp() << ").");
+        igtlMessage->GetTimeStamp(ts);
+        LOG_INFO("Client disconnected - could not send " << igtlMessage->GetMessageType() << " message to client " << clientId << " (device name: " << igtlMessage->GetDeviceName()
+                 << "  Timestamp: " << std::fixed << ts->GetTimeStamp() << ").");
+        // The data sender thread of the server will disconnect the client
+        client->SendFailed = true;
+        break;
       }
-    } // clientIterator
-  } // unlock client list
+    }
+
+    if (frameTimestampSystem != UNDEFINED_TIMESTAMP && !client->SendFailed)
+    {
+      double latencySec = vtkPlusAccurateTimer::GetSystemTime() - frameTimestampSystem;
+      client->NumberOfSentFrames++;
+      client->SentFrameLatencySumSec += latencySec;
+      client->SentFrameLatencyMaxSec = std::max(client->SentFrameLatencyMaxSec, latencySec);
+    }
+  }
+
+  // Close thread, the thread ID is released by DisconnectClient
+  client->DataSenderActive.second = false;
+  return NULL;
+}
 
-  // Clean up disconnected clients
-  for (std::vector< int >::iterator it = disconnectedClientIds.begin(); it != disconnectedClientIds.end(); ++it)
+//----------------------------------------------------------------------------
+void vtkPlusOpenIGTLinkServer::DisconnectFailedClients()
+{
+  // Do not wait for the client threads to stop, as it would delay sending data to the other clients
+  PlusLockGuard<vtkPlusRecursiveCriticalSection> igtlClientsMutexGuardedLock(this->IgtlClientsMutex);
+  std::list<ClientData>::iterator clientIterator = this->IgtlClients.begin();
+  while (clientIterator != this->IgtlClients.end())
   {
-    DisconnectClient(*it);
+    if (clientIterator->SendFailed && !clientIterator->DisconnectRequested)
+    {
+      RequestClientThreadsStop(*clientIterator);
+    }
+    if (clientIterator->DisconnectRequested && this->ReleaseStoppedClientThreads(*clientIterator))
+    {
+      clientIterator = this->RemoveClient(clientIterator);
+    }
+    else
+    {
+      ++clientIterator;
+    }
   }
 }
 
@@ -1065,6 +1210,9 @@ PlusStatus vtkPlusOpenIGTLinkServer::ReadConfiguration(vtkXMLDataElement* server
   XML_READ_BOOL_ATTRIBUTE_OPTIONAL(SendValidTransformsOnly, serverElement);
   XML_READ_BOOL_ATTRIBUTE_OPTIONAL(IgtlMessageCrcCheckEnabled, serverElement);
   XML_READ_BOOL_ATTRIBUTE_OPTIONAL(LogWarningOnNoDataAvailable, serverElement);
+  XML_READ_BOOL_ATTRIBUTE_OPTIONAL(SendOnNewData, serverElement);
+  XML_READ_SCALAR_ATTRIBUTE_OPTIONAL(int, ClientSendQueueSize, serverElement);
+  XML_READ_BOOL_ATTRIBUTE_OPTIONAL(DropOldestFramesWhenQueueIsFull, serverElement);
 
   this->DefaultClientInfo.IgtlMessageTypes.clear();
   this->DefaultClientInfo.TransformNames.clear();
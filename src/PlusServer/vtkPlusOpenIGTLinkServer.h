@@ -37,9 +37,18 @@ class vtkPlusOpenIGTLinkServer;
 class vtkPlusChannel;
 class vtkPlusCommandProcessor;
 class vtkPlusCommandResponse;
+class vtkPlusNewItemSignal;
 class vtkPlusRecursiveCriticalSection;
 class vtkPlusTransformRepository;
 
+/*! Packed messages of a tracked frame, waiting to be sent to a client */
+struct ClientFrameMessages
+{
+  /// Acquisition timestamp of the tracked frame (system time)
+  double TimestampSystem;
+  std::vector<igtl::MessageBase::Pointer> Messages;
+};
+
 struct ClientData
 {
   ClientData()
@@ -47,6 +56,14 @@ struct ClientData
     , ClientSocket(NULL)
     , DataReceiverActive(std::make_pair(false, false))
     , DataReceiverThreadId(-1)
+    , DataSenderActive(std::make_pair(false, false))
+    , DataSenderThreadId(-1)
+    , SendFailed(false)
+    , DisconnectRequested(false)
+    , NumberOfDroppedFrames(0)
+    , NumberOfSentFrames(0)
+    , SentFrameLatencySumSec(0.0)
+    , SentFrameLatencyMaxSec(0.0)
     , Server(NULL)
   {
   }
@@ -65,6 +82,29 @@ struct ClientData
   std::pair<bool, bool> DataReceiverActive;
   int DataReceiverThreadId;
 
+  /// Active flag for the thread that sends the queued messages to the client (first: request, second: respond )
+  std::pair<bool, bool> DataSenderActive;
+  int DataSenderThreadId;
+  /// Set by the data sender thread if the client could not be reached
+  bool SendFailed;
+  /// Set when the client threads are requested to stop, the client is removed from the client list when both threads have stopped
+  bool DisconnectRequested;
+
+  /// Tracked frame messages waiting to be sent. The number of queued frames is limited by ClientSendQueueSize.
+  std::deque<ClientFrameMessages> FrameMessageQueue;
+  /// Responses and keep-alive messages waiting to be sent. These are never dropped and sent before frame messages.
+  std::deque<igtl::MessageBase::Pointer> ResponseMessageQueue;
+  /// Protects the message queues
+  vtkSmartPointer<vtkPlusRecursiveCriticalSection> SendQueueMutex;
+  /// Notified when a message is added to the queues
+  vtkSmartPointer<vtkPlusNewItemSignal> SendQueueSignal;
+
+  /// Statistics, updated by the data sender thread
+  unsigned long NumberOfDroppedFrames;
+  unsigned long NumberOfSentFrames;
+  double SentFrameLatencySumSec;
+  double SentFrameLatencyMaxSec;
+
   PlusIgtlClientInfo ClientInfo;
 
   vtkPlusOpenIGTLinkServer* Server;
@@ -83,6 +123,18 @@ struct ClientData
   requested image and tracking information in the same format as in the DefaultClientInfo element in the device set
   configuration file.
 
+  Messages are packed once per tracked frame for all the clients that requested the same content and then placed into
+  the send queue of each client. Each client has its own sender thread, therefore a slow client does not delay other clients.
+  If a client cannot keep up with the data rate then frames are dropped from its queue (see ClientSendQueueSize and
+  DropOldestFramesWhenQueueIsFull attributes).
+
+  Each connected client uses two threads: a data receiver thread and a data sender thread. The data sender threads are
+  spawned by a separate vtkMultiThreader, so the maximum number of simultaneously connected clients is still limited only by
+  the number of thread slots (VTK_MAX_THREADS) of the main threader. An idle client thread only waits on a signal or a socket
+  with a timeout, so the cost of a client is mainly the memory of the thread stacks and of the queued frames (up to
+  ClientSendQueueSize frames). Clients that fail to receive data are disconnected without waiting for their threads to stop,
+  therefore a client that is disconnected while data is being sent does not delay sending data to the other clients.
+
   \ingroup PlusLibPlusServer
 */
 class vtkPlusServerExport vtkPlusOpenIGTLinkServer: public vtkObject
@@ -183,16 +235,37 @@ protected:
   /*! Thread for receiving control data from clients */
   static void* DataReceiverThread(vtkMultiThreader::ThreadInfo* data);
 
-  /*! Tracked frame interface, sends the selected message type and data to all clients */
+  /*! Thread for sending the queued messages to a client, one thread per client */
+  static void* ClientDataSenderThread(vtkMultiThreader::ThreadInfo* data);
+
+  /*! Tracked frame interface, queues the selected message type and data for all clients */
   virtual PlusStatus SendTrackedFrame(PlusTrackedFrame& trackedFrame);
 
+  /*! Add a message to the response queue of a client. Caller must lock IgtlClientsMutex. */
+  static void QueueResponseMessage(ClientData& client, igtl::MessageBase::Pointer message);
+
+  /*!
+    Disconnect the clients whose data sender thread failed to send data. It does not wait for the client threads to stop:
+    the stop is requested and the client is removed in a later call, after its threads have stopped.
+  */
+  void DisconnectFailedClients();
+
+  /*! Request the data receiver and data sender threads of a client to stop. Caller must lock IgtlClientsMutex. */
+  static void RequestClientThreadsStop(ClientData& client);
+
+  /*! Returns true if both threads of the client have stopped and releases the thread slot of the data sender thread. Caller must lock IgtlClientsMutex. */
+  bool ReleaseStoppedClientThreads(ClientData& client);
+
+  /*! Closes the socket of a client whose threads have stopped and removes the client from the client list. Caller must lock IgtlClientsMutex. */
+  std::list<ClientData>::iterator RemoveClient(std::list<ClientData>::iterator clientIterator);
+
   /*! Converts a command response to an OpenIGTLink message that can be sent to the client */
   igtl::MessageBase::Pointer CreateIgtlMessageFromCommandResponse(vtkPlusCommandResponse* response);
 
   /*! Send status message to clients to keep alive the connection */
   virtual void KeepAlive();
 
-  /*! Stops client's data receiving thread, closes the socket, and removes the client from the client list */
+  /*! Stops client's data receiving and sending threads, closes the socket, and removes the client from the client list. Waits for the client threads to stop. */
   void DisconnectClient(int clientId);
 
   /*! Set IGTL CRC check flag (0: disabled, 1: enabled) */
@@ -215,6 +288,15 @@ protected:
   vtkSetMacro(KeepAliveIntervalSec, double);
   vtkGetMacroConst(KeepAliveIntervalSec, double);
 
+  vtkSetMacro(SendOnNewData, bool);
+  vtkGetMacroConst(SendOnNewData, bool);
+
+  vtkSetMacro(ClientSendQueueSize, int);
+  vtkGetMacroConst(ClientSendQueueSize, int);
+
+  vtkSetMacro(DropOldestFramesWhenQueueIsFull, bool);
+  vtkGetMacroConst(DropOldestFramesWhenQueueIsFull, bool);
+
   vtkSetStdStringMacro(OutputChannelId);
   vtkSetStdStringMacro(ConfigFilename);
 
@@ -236,6 +318,9 @@ private:
   /*! Multithreader instance for controlling threads */
   vtkSmartPointer<vtkMultiThreader> Threader;
 
+  /*! Multithreader instance for the client data sender threads, separate from Threader to not reduce the maximum number of clients */
+  vtkSmartPointer<vtkMultiThreader> ClientDataSenderThreader;
+
   /*! The version of the IGTL protocol that this server is using */
   int IGTLProtocolVersion;
 
@@ -277,6 +362,24 @@ private:
   /*! Time needed to process one frame in the latest recording round (in milliseconds) */
   int LastProcessingTimePerFrameMs;
 
+  /*!
+    If enabled then the data sender thread is woken up as soon as new data is added to the broadcast channel.
+    If disabled then the broadcast channel is polled for new data.
+  */
+  bool SendOnNewData;
+
+  /*! Notified when new data is added to the broadcast channel or a new message response is queued */
+  vtkSmartPointer<vtkPlusNewItemSignal> NewDataSignal;
+
+  /*! Maximum number of tracked frames in the send queue of each client */
+  int ClientSendQueueSize;
+
+  /*!
+    If the send queue of a client is full then the oldest queued frame is dropped if this flag is enabled,
+    otherwise the new frame is not queued.
+  */
+  bool DropOldestFramesWhenQueueIsFull;
+
   /*! Whether or not the server should send invalid transforms through the IGT Link */
   bool SendValidTransformsOnly;
 
@@ -0,0 +1,111 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+See License.txt for details.
+=========================================================Plus=header=end*/
+
+#include "PlusConfigure.h"
+#include "PlusVolumeReconstructionTestUtilities.h"
+#include "vtkPlusPasteSliceIntoVolume.h"
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkMatrix4x4.h>
+#include <vtkTransform.h>
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+//----------------------------------------------------------------------------
+void PlusVolumeReconstructionTestUtilities::ParseArguments(vtksys::CommandLineArguments& args)
+{
+  bool printHelp = false;
+  int verboseLevel = vtkPlusLogger::LOG_LEVEL_UNDEFINED;
+
+  args.AddArgument("--help", vtksys::CommandLineArguments::NO_ARGUMENT, &printHelp, "Print this help.");
+  args.AddArgument("--verbose", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &verboseLevel, "Verbose level (1=error only, 2=warning, 3=info, 4=debug, 5=trace)");
+
+  if (!args.Parse())
+  {
+    std::cerr << "Problem parsing arguments" << std::endl;
+    std::cout << "Help: " << args.GetHelp() << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  if (printHelp)
+  {
+    std::cout << args.GetHelp() << std::endl;
+    exit(EXIT_SUCCESS);
+  }
+
+  vtkPlusLogger::Instance()->SetLogLevel(verboseLevel);
+}
+
+//----------------------------------------------------------------------------
+void PlusVolumeReconstructionTestUtilities::CreateSweep(int numberOfFrames, double sweepLengthMm, std::vector< vtkSmartPointer<vtkImageData> >& frames,
+    std::vector< vtkSmartPointer<vtkMatrix4x4> >& imageToReferenceTransforms)
+{
+  int frameSize[2] = { 200, 150 };
+  srand(0);
+  for (int frameIndex = 0; frameIndex < numberOfFrames; ++frameIndex)
+  {
+    vtkSmartPointer<vtkImageData> frame = vtkSmartPointer<vtkImageData>::New();
+    frame->SetExtent(0, frameSize[0] - 1, 0, frameSize[1] - 1, 0, 0);
+    frame->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+    unsigned char* pixels = static_cast<unsigned char*>(frame->GetScalarPointer());
+    for (int i = 0; i < frameSize[0] * frameSize[1]; ++i)
+    {
+      pixels[i] = static_cast<unsigned char>(1 + rand() % 255);
+    }
+    frames.push_back(frame);
+
+    double t = double(frameIndex) / numberOfFrames;
+    vtkSmartPointer<vtkTransform> imageToReference = vtkSmartPointer<vtkTransform>::New();
+    imageToReference->Translate(20.0 + 10.0 * t, 15.0, 10.0 + sweepLengthMm * t);
+    imageToReference->RotateY(10.0 * sin(t * 17.0));
+    imageToReference->RotateX(75.0 + 10.0 * cos(t * 11.0));
+    imageToReference->Scale(0.5, 0.5, 0.5);
+    vtkSmartPointer<vtkMatrix4x4> imageToReferenceMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+    imageToReference->GetMatrix(imageToReferenceMatrix);
+    imageToReferenceTransforms.push_back(imageToReferenceMatrix);
+  }
+}
+
+//----------------------------------------------------------------------------
+double PlusVolumeReconstructionTestUtilities::ReconstructVolume(vtkPlusPasteSliceIntoVolume* reconstructor, std::vector< vtkSmartPointer<vtkImageData> >& frames,
+    std::vector< vtkSmartPointer<vtkMatrix4x4> >& imageToReferenceTransforms)
+{
+  reconstructor->ResetOutput();
+  double startTime = vtkPlusAccurateTimer::GetSystemTime();
+  for (unsigned int frameIndex = 0; frameIndex < frames.size(); ++frameIndex)
+  {
+    if (reconstructor->InsertSlice(frames[frameIndex], imageToReferenceTransforms[frameIndex]) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to insert frame " << frameIndex);
+    }
+  }
+  reconstructor->WaitForQueuedSlices();
+  return vtkPlusAccurateTimer::GetSystemTime() - startTime;
+}
+
+//----------------------------------------------------------------------------
+bool PlusVolumeReconstructionTestUtilities::IsImageScalarsEqual(vtkImageData* image1, vtkImageData* image2)
+{
+  int* extent1 = image1->GetExtent();
+  int* extent2 = image2->GetExtent();
+  for (int i = 0; i < 6; ++i)
+  {
+    if (extent1[i] != extent2[i])
+    {
+      return false;
+    }
+  }
+  if (image1->GetScalarType() != image2->GetScalarType() || image1->GetNumberOfScalarComponents() != image2->GetNumberOfScalarComponents())
+  {
+    return false;
+  }
+  size_t size = size_t(extent1[1] - extent1[0] + 1) * size_t(extent1[3] - extent1[2] + 1) * size_t(extent1[5] - extent1[4] + 1)
+                * image1->GetScalarSize() * image1->GetNumberOfScalarComponents();
+  return memcmp(image1->GetScalarPointer(), image2->GetScalarPointer(), size) == 0;
+}
@@ -0,0 +1,53 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+See License.txt for details.
+=========================================================Plus=header=end*/
+
+/*!
+\file PlusVolumeReconstructionTestUtilities.h
+Synthetic sweep generator and helper functions that are shared between the volume reconstruction tests.
+*/
+
+#ifndef __PlusVolumeReconstructionTestUtilities_h
+#define __PlusVolumeReconstructionTestUtilities_h
+
+#include <vtkSmartPointer.h>
+#include <vtksys/CommandLineArguments.hxx>
+
+#include <vector>
+
+class vtkImageData;
+class vtkMatrix4x4;
+class vtkPlusPasteSliceIntoVolume;
+
+namespace PlusVolumeReconstructionTestUtilities
+{
+  /*!
+    Add the --help and --verbose arguments to the test-specific arguments, parse the command line and set the log level.
+    Exits the process if the help is requested or the arguments cannot be parsed.
+    args must be initialized with the command line before calling this function.
+  */
+  void ParseArguments(vtksys::CommandLineArguments& args);
+
+  /*!
+    Create frames (200x150 pixels, random values between 1 and 255) and ImageToReference transforms (0.5 mm/pixel)
+    of a freehand sweep that moves the probe along the z axis by sweepLengthMm while it is slightly tilted back and forth.
+    The result only depends on the input arguments.
+  */
+  void CreateSweep(int numberOfFrames, double sweepLengthMm, std::vector< vtkSmartPointer<vtkImageData> >& frames,
+                   std::vector< vtkSmartPointer<vtkMatrix4x4> >& imageToReferenceTransforms);
+
+  /*!
+    Reset the output of the reconstructor and insert all the frames. Pipelined insertion is waited for.
+    Output extent, spacing, and origin must be set before calling this function.
+    Returns the processing time in seconds.
+  */
+  double ReconstructVolume(vtkPlusPasteSliceIntoVolume* reconstructor, std::vector< vtkSmartPointer<vtkImageData> >& frames,
+                           std::vector< vtkSmartPointer<vtkMatrix4x4> >& imageToReferenceTransforms);
+
+  /*! Returns true if the extent, scalar type, and scalar values of the two images are identical */
+  bool IsImageScalarsEqual(vtkImageData* image1, vtkImageData* image2);
+}
+
+#endif
@@ -0,0 +1,166 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+See License.txt for details.
+=========================================================Plus=header=end*/
+
+/*!
+\file vtkPlusFillHolesInVolumeTest.cxx
+Fill holes in a synthetic volume with and without blocked execution and verify that the results are identical
+for all hole filling element types. Report the processing time of both execution modes.
+*/
+
+#include "PlusConfigure.h"
+#include "PlusVolumeReconstructionTestUtilities.h"
+#include "vtkPlusFillHolesInVolume.h"
+
+// VTK includes
+#include <vtkCallbackCommand.h>
+#include <vtkCommand.h>
+#include <vtkImageData.h>
+#include <vtkSmartPointer.h>
+#include <vtksys/CommandLineArguments.hxx>
+
+#include <cstdlib>
+#include <iomanip>
+#include <utility>
+
+using namespace PlusVolumeReconstructionTestUtilities;
+
+//----------------------------------------------------------------------------
+// Create a volume that is densely filled in its lower half and has large unfilled regions in its upper half
+void CreateVolumeWithHoles(int size, vtkImageData* volume, vtkImageData* accumulationBuffer)
+{
+  volume->SetExtent(0, size - 1, 0, size - 1, 0, size - 1);
+  volume->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+  accumulationBuffer->SetExtent(0, size - 1, 0, size - 1, 0, size - 1);
+  accumulationBuffer->AllocateScalars(VTK_UNSIGNED_SHORT, 1);
+  unsigned char* volumePtr = static_cast<unsigned char*>(volume->GetScalarPointer());
+  unsigned short* accumulationPtr = static_cast<unsigned short*>(accumulationBuffer->GetScalarPointer());
+  srand(0);
+  for (int z = 0; z < size; ++z)
+  {
+    for (int y = 0; y < size; ++y)
+    {
+      for (int x = 0; x < size; ++x, ++volumePtr, ++accumulationPtr)
+      {
+        bool filled = (z < size / 2) ? (rand() % 10 != 0) : (z % 7 < 3 && x < size * 2 / 3);
+        *volumePtr = filled ? static_cast<unsigned char>(1 + rand() % 255) : 0;
+        *accumulationPtr = filled ? static_cast<unsigned short>(1 + rand() % 500) : 0;
+      }
+    }
+  }
+}
+
+//----------------------------------------------------------------------------
+// Count the progress events and store the last reported progress
+void ProgressCallback(vtkObject* caller, unsigned long, void* clientData, void*)
+{
+  std::pair<int, double>* progress = static_cast<std::pair<int, double>*>(clientData);
+  progress->first++;
+  progress->second = vtkAlgorithm::SafeDownCast(caller)->GetProgress();
+}
+
+//----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  int volumeSize = 128;
+
+  vtksys::CommandLineArguments args;
+  args.Initialize(argc, argv);
+  args.AddArgument("--volume-size", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &volumeSize, "Number of voxels along each axis of the synthetic volume (default: 128)");
+  ParseArguments(args);
+
+  vtkSmartPointer<vtkImageData> volume = vtkSmartPointer<vtkImageData>::New();
+  vtkSmartPointer<vtkImageData> accumulationBuffer = vtkSmartPointer<vtkImageData>::New();
+  CreateVolumeWithHoles(volumeSize, volume, accumulationBuffer);
+
+  const int numberOfElementTypes = 5;
+  const char* elementTypeNames[numberOfElementTypes] = { "GAUSSIAN", "GAUSSIAN_ACCUMULATION", "DISTANCE_WEIGHT_INVERSE", "NEAREST_NEIGHBOR", "STICK" };
+  int numberOfErrors = 0;
+  for (int elementTypeIndex = 0; elementTypeIndex < numberOfElementTypes; ++elementTypeIndex)
+  {
+    FillHolesInVolumeElement element;
+    switch (elementTypeIndex)
+    {
+    case 0:
+      element.type = FillHolesInVolumeElement::HFTYPE_GAUSSIAN;
+      element.size = 5;
+      element.stdev = 1.5f;
+      element.minRatio = 0.1f;
+      break;
+    case 1:
+      element.type = FillHolesInVolumeElement::HFTYPE_GAUSSIAN_ACCUMULATION;
+      element.size = 5;
+      element.stdev = 1.5f;
+      element.minRatio = 0.1f;
+      break;
+    case 2:
+      element.type = FillHolesInVolumeElement::HFTYPE_DISTANCE_WEIGHT_INVERSE;
+      element.size = 5;
+      element.minRatio = 0.05f;
+      break;
+    case 3:
+      element.type = FillHolesInVolumeElement::HFTYPE_NEAREST_NEIGHBOR;
+      element.size = 7;
+      element.minRatio = 0.0f;
+      break;
+    default:
+      element.type = FillHolesInVolumeElement::HFTYPE_STICK;
+      element.stickLengthLimit = 9;
+      element.numSticksToUse = 2;
+      break;
+    }
+
+    vtkSmartPointer<vtkPlusFillHolesInVolume> holeFiller = vtkSmartPointer<vtkPlusFillHolesInVolume>::New();
+    holeFiller->SetReconstructedVolume(volume);
+    holeFiller->SetAccumulationBuffer(accumulationBuffer);
+    holeFiller->SetNumHFElements(1);
+    holeFiller->AllocateHFElements();
+    holeFiller->SetHFElement(0, element);
+
+    holeFiller->BlockedExecutionOff();
+    double startTime = vtkPlusAccurateTimer::GetSystemTime();
+    holeFiller->Update();
+    double defaultProcessingTimeSec = vtkPlusAccurateTimer::GetSystemTime() - startTime;
+    vtkSmartPointer<vtkImageData> defaultResult = vtkSmartPointer<vtkImageData>::New();
+    defaultResult->DeepCopy(holeFiller->GetOutput());
+
+    holeFiller->BlockedExecutionOn();
+    holeFiller->Modified();
+    std::pair<int, double> blockedProgress(0, 0.0);
+    vtkSmartPointer<vtkCallbackCommand> progressCallback = vtkSmartPointer<vtkCallbackCommand>::New();
+    progressCallback->SetCallback(ProgressCallback);
+    progressCallback->SetClientData(&blockedProgress);
+    unsigned long progressObserverTag = holeFiller->AddObserver(vtkCommand::ProgressEvent, progressCallback);
+    startTime = vtkPlusAccurateTimer::GetSystemTime();
+    holeFiller->Update();
+    double blockedProcessingTimeSec = vtkPlusAccurateTimer::GetSystemTime() - startTime;
+    holeFiller->RemoveObserver(progressObserverTag);
+
+    LOG_INFO(elementTypeNames[elementTypeIndex] << ": " << std::fixed << std::setprecision(3)
+             << "default: " << defaultProcessingTimeSec << " s, blocked: " << blockedProcessingTimeSec << " s");
+
+    if (!IsImageScalarsEqual(defaultResult, holeFiller->GetOutput()))
+    {
+      LOG_ERROR("Hole filling result with blocked execution is different from default execution (" << elementTypeNames[elementTypeIndex] << ")");
+      numberOfErrors++;
+    }
+    // the pipeline reports progress 0 and 1 by itself, bricks must report progress in between
+    if (blockedProgress.first <= 2 || blockedProgress.second < 1.0)
+    {
+      LOG_ERROR("Progress is not reported with blocked execution (" << elementTypeNames[elementTypeIndex] << "): "
+                << blockedProgress.first << " progress events, last progress: " << blockedProgress.second);
+      numberOfErrors++;
+    }
+  }
+
+  if (numberOfErrors > 0)
+  {
+    LOG_ERROR("Test failed, number of errors: " << numberOfErrors);
+    return EXIT_FAILURE;
+  }
+
+  LOG_INFO("Test completed successfully");
+  return EXIT_SUCCESS;
+}
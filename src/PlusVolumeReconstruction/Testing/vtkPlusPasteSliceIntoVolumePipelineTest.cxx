@@ -0,0 +1,192 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+See License.txt for details.
+=========================================================Plus=header=end*/
+
+/*!
+\file vtkPlusPasteSliceIntoVolumePipelineTest.cxx
+Reconstruct a volume with pipelined insertion and verify that the result is identical to single-threaded insertion
+for all interpolation and compounding modes. The slices are taken from a synthetic freehand sweep (consecutive slices
+intersect), from parallel slices that are written concurrently into disjoint regions of the volume, from parallel
+slices that are all written into the same region, and from parallel slices where each region is written by every
+fourth slice (a blocked slice is overtaken by the following slices).
+Report the insertion speed (frames/s) of the multi-threaded and pipelined insertion for various numbers of threads.
+*/
+
+#include "PlusConfigure.h"
+#include "PlusVolumeReconstructionTestUtilities.h"
+#include "vtkPlusPasteSliceIntoVolume.h"
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkMatrix4x4.h>
+#include <vtkSmartPointer.h>
+#include <vtkTransform.h>
+#include <vtksys/CommandLineArguments.hxx>
+
+#include <cstdlib>
+#include <iomanip>
+
+using namespace PlusVolumeReconstructionTestUtilities;
+
+namespace
+{
+  const int NUMBER_OF_PIPELINE_THREADS = 8;
+  // Brick size (in voxels) for the parallel slice tests, much smaller than the distance between slice positions
+  const int PARALLEL_SLICES_BRICK_SIZE = 4;
+  const double PARALLEL_SLICES_DISTANCE_MM = 6.0;
+
+  //----------------------------------------------------------------------------
+  // Create frames and ImageToReference transforms of slices that are parallel to the XY plane of the volume.
+  // Slice i is placed at position (i % numberOfPositions) along the z axis, therefore slices at different positions
+  // write disjoint regions of the volume and slices at the same position write the same region.
+  void CreateParallelSlices(int numberOfFrames, int numberOfPositions, std::vector< vtkSmartPointer<vtkImageData> >& frames,
+                            std::vector< vtkSmartPointer<vtkMatrix4x4> >& imageToReferenceTransforms)
+  {
+    int frameSize[2] = { 200, 150 };
+    srand(1);
+    for (int frameIndex = 0; frameIndex < numberOfFrames; ++frameIndex)
+    {
+      vtkSmartPointer<vtkImageData> frame = vtkSmartPointer<vtkImageData>::New();
+      frame->SetExtent(0, frameSize[0] - 1, 0, frameSize[1] - 1, 0, 0);
+      frame->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+      unsigned char* pixels = static_cast<unsigned char*>(frame->GetScalarPointer());
+      for (int i = 0; i < frameSize[0] * frameSize[1]; ++i)
+      {
+        pixels[i] = static_cast<unsigned char>(1 + rand() % 255);
+      }
+      frames.push_back(frame);
+
+      // slices are not aligned with the voxel centers, so linear interpolation writes two voxel layers
+      vtkSmartPointer<vtkTransform> imageToReference = vtkSmartPointer<vtkTransform>::New();
+      imageToReference->Translate(0.0, 10.0, 2.2 + PARALLEL_SLICES_DISTANCE_MM * (frameIndex % numberOfPositions));
+      imageToReference->Scale(0.5, 0.5, 0.5);
+      vtkSmartPointer<vtkMatrix4x4> imageToReferenceMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+      imageToReference->GetMatrix(imageToReferenceMatrix);
+      imageToReferenceTransforms.push_back(imageToReferenceMatrix);
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  vtkSmartPointer<vtkPlusPasteSliceIntoVolume> CreateReconstructor()
+  {
+    int outputExtent[6] = { 0, 199, 0, 199, 0, 299 };
+    double outputSpacing[3] = { 0.5, 0.5, 0.5 };
+    double outputOrigin[3] = { 0.0, 0.0, 0.0 };
+    vtkSmartPointer<vtkPlusPasteSliceIntoVolume> reconstructor = vtkSmartPointer<vtkPlusPasteSliceIntoVolume>::New();
+    reconstructor->SetOutputExtent(outputExtent);
+    reconstructor->SetOutputSpacing(outputSpacing);
+    reconstructor->SetOutputOrigin(outputOrigin);
+    return reconstructor;
+  }
+
+  //----------------------------------------------------------------------------
+  // Returns the number of interpolation and compounding modes where pipelined insertion result differs from single-threaded insertion
+  int CompareToSingleThreaded(const std::string& caseName, int pipelineBrickSize, std::vector< vtkSmartPointer<vtkImageData> >& frames,
+                              std::vector< vtkSmartPointer<vtkMatrix4x4> >& imageToReferenceTransforms)
+  {
+    vtkPlusPasteSliceIntoVolume::InterpolationType interpolationModes[] = { vtkPlusPasteSliceIntoVolume::NEAREST_NEIGHBOR_INTERPOLATION, vtkPlusPasteSliceIntoVolume::LINEAR_INTERPOLATION };
+    vtkPlusPasteSliceIntoVolume::CompoundingType compoundingModes[] = { vtkPlusPasteSliceIntoVolume::LATEST_COMPOUNDING_MODE, vtkPlusPasteSliceIntoVolume::MEAN_COMPOUNDING_MODE, vtkPlusPasteSliceIntoVolume::MAXIMUM_COMPOUNDING_MODE };
+    int numberOfErrors = 0;
+    for (unsigned int interpolationIndex = 0; interpolationIndex < sizeof(interpolationModes) / sizeof(interpolationModes[0]); ++interpolationIndex)
+    {
+      for (unsigned int compoundingIndex = 0; compoundingIndex < sizeof(compoundingModes) / sizeof(compoundingModes[0]); ++compoundingIndex)
+      {
+        vtkSmartPointer<vtkPlusPasteSliceIntoVolume> reconstructor = CreateReconstructor();
+        reconstructor->SetInterpolationMode(interpolationModes[interpolationIndex]);
+        reconstructor->SetCompoundingMode(compoundingModes[compoundingIndex]);
+        reconstructor->SetPipelineBrickSize(pipelineBrickSize);
+
+        reconstructor->SetNumberOfThreads(1);
+        reconstructor->PipelinedInsertionOff();
+        ReconstructVolume(reconstructor, frames, imageToReferenceTransforms);
+        vtkSmartPointer<vtkImageData> referenceVolume = vtkSmartPointer<vtkImageData>::New();
+        referenceVolume->DeepCopy(reconstructor->GetReconstructedVolume());
+        vtkSmartPointer<vtkImageData> referenceAccumulationBuffer = vtkSmartPointer<vtkImageData>::New();
+        referenceAccumulationBuffer->DeepCopy(reconstructor->GetAccumulationBuffer());
+
+        reconstructor->SetNumberOfThreads(NUMBER_OF_PIPELINE_THREADS);
+        reconstructor->PipelinedInsertionOn();
+        ReconstructVolume(reconstructor, frames, imageToReferenceTransforms);
+
+        if (!IsImageScalarsEqual(referenceVolume, reconstructor->GetReconstructedVolume()))
+        {
+          LOG_ERROR("Pipelined reconstruction result is different from single-threaded reconstruction (" << caseName << ", "
+                    << reconstructor->GetInterpolationModeAsString(interpolationModes[interpolationIndex]) << ", "
+                    << reconstructor->GetCompoundingModeAsString(compoundingModes[compoundingIndex]) << ")");
+          numberOfErrors++;
+        }
+        if (!IsImageScalarsEqual(referenceAccumulationBuffer, reconstructor->GetAccumulationBuffer()))
+        {
+          LOG_ERROR("Pipelined reconstruction accumulation buffer is different from single-threaded reconstruction (" << caseName << ", "
+                    << reconstructor->GetInterpolationModeAsString(interpolationModes[interpolationIndex]) << ", "
+                    << reconstructor->GetCompoundingModeAsString(compoundingModes[compoundingIndex]) << ")");
+          numberOfErrors++;
+        }
+      }
+    }
+    return numberOfErrors;
+  }
+}
+
+//----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  int numberOfFrames = 400;
+  int numberOfParallelSlices = 24;
+  int maximumNumberOfThreads = 32;
+
+  vtksys::CommandLineArguments args;
+  args.Initialize(argc, argv);
+  args.AddArgument("--frames", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &numberOfFrames, "Number of frames in the synthetic sweep (default: 400)");
+  args.AddArgument("--parallel-slices", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &numberOfParallelSlices, "Number of slices in the parallel slice tests (default: 24)");
+  args.AddArgument("--max-threads", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &maximumNumberOfThreads, "Maximum number of threads for measuring the speed (default: 32)");
+  ParseArguments(args);
+
+  int numberOfErrors = 0;
+
+  std::vector< vtkSmartPointer<vtkImageData> > frames;
+  std::vector< vtkSmartPointer<vtkMatrix4x4> > imageToReferenceTransforms;
+  CreateSweep(numberOfFrames, 100.0, frames, imageToReferenceTransforms);
+  vtkSmartPointer<vtkPlusPasteSliceIntoVolume> defaultReconstructor = vtkSmartPointer<vtkPlusPasteSliceIntoVolume>::New();
+  numberOfErrors += CompareToSingleThreaded("freehand sweep", defaultReconstructor->GetPipelineBrickSize(), frames, imageToReferenceTransforms);
+
+  // Number of slice positions: each slice in a different region, all slices in the same region, every fourth slice in the same region
+  int numberOfPositions[] = { numberOfParallelSlices, 1, 4 };
+  const char* parallelSlicesCaseNames[] = { "disjoint regions", "contended region", "interleaved regions" };
+  for (unsigned int caseIndex = 0; caseIndex < sizeof(numberOfPositions) / sizeof(numberOfPositions[0]); ++caseIndex)
+  {
+    std::vector< vtkSmartPointer<vtkImageData> > parallelFrames;
+    std::vector< vtkSmartPointer<vtkMatrix4x4> > parallelImageToReferenceTransforms;
+    CreateParallelSlices(numberOfParallelSlices, numberOfPositions[caseIndex], parallelFrames, parallelImageToReferenceTransforms);
+    numberOfErrors += CompareToSingleThreaded(parallelSlicesCaseNames[caseIndex], PARALLEL_SLICES_BRICK_SIZE, parallelFrames, parallelImageToReferenceTransforms);
+  }
+
+  // Measure insertion speed
+  for (int numberOfThreads = 1; numberOfThreads <= maximumNumberOfThreads; numberOfThreads *= 2)
+  {
+    vtkSmartPointer<vtkPlusPasteSliceIntoVolume> reconstructor = CreateReconstructor();
+    reconstructor->SetCompoundingMode(vtkPlusPasteSliceIntoVolume::MEAN_COMPOUNDING_MODE);
+    reconstructor->SetNumberOfThreads(numberOfThreads);
+    reconstructor->PipelinedInsertionOff();
+    double splitProcessingTimeSec = ReconstructVolume(reconstructor, frames, imageToReferenceTransforms);
+    reconstructor->PipelinedInsertionOn();
+    double pipelinedProcessingTimeSec = ReconstructVolume(reconstructor, frames, imageToReferenceTransforms);
+    double splitFramesPerSec = (splitProcessingTimeSec > 0 ? frames.size() / splitProcessingTimeSec : 0);
+    double pipelinedFramesPerSec = (pipelinedProcessingTimeSec > 0 ? frames.size() / pipelinedProcessingTimeSec : 0);
+    LOG_INFO("Threads: " << std::setw(2) << numberOfThreads
+             << " | split frames: " << std::setw(7) << std::fixed << std::setprecision(0) << splitFramesPerSec << " frames/s"
+             << " | pipelined: " << std::setw(7) << pipelinedFramesPerSec << " frames/s"
+             << " | speedup: " << std::setprecision(2) << (splitFramesPerSec > 0 ? pipelinedFramesPerSec / splitFramesPerSec : 0));
+  }
+
+  if (numberOfErrors > 0)
+  {
+    LOG_ERROR("Test failed, number of errors: " << numberOfErrors);
+    return EXIT_FAILURE;
+  }
+
+  LOG_INFO("Test completed successfully");
+  return EXIT_SUCCESS;
+}
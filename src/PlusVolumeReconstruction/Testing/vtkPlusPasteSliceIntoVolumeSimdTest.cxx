@@ -0,0 +1,102 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+See License.txt for details.
+=========================================================Plus=header=end*/
+
+/*!
+\file vtkPlusPasteSliceIntoVolumeSimdTest.cxx
+Reconstruct a volume from a synthetic freehand sweep with and without vectorized (AVX2) slice insertion and verify that
+the reconstructed volumes and accumulation buffers are identical for all compounding modes.
+Report the insertion speed (frames/s) with and without vectorization.
+*/
+
+#include "PlusConfigure.h"
+#include "PlusVolumeReconstructionTestUtilities.h"
+#include "vtkPlusPasteSliceIntoVolume.h"
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkMatrix4x4.h>
+#include <vtkSmartPointer.h>
+#include <vtksys/CommandLineArguments.hxx>
+
+#include <cstdlib>
+#include <iomanip>
+
+using namespace PlusVolumeReconstructionTestUtilities;
+
+//----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  int numberOfFrames = 200;
+
+  vtksys::CommandLineArguments args;
+  args.Initialize(argc, argv);
+  args.AddArgument("--frames", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &numberOfFrames, "Number of frames in the synthetic sweep (default: 200)");
+  ParseArguments(args);
+
+  if (!PlusCommon::IsAvx2Supported())
+  {
+    LOG_INFO("AVX2 instructions are not supported on this system, the scalar implementation is used with EnableSimd as well");
+  }
+
+  std::vector< vtkSmartPointer<vtkImageData> > frames;
+  std::vector< vtkSmartPointer<vtkMatrix4x4> > imageToReferenceTransforms;
+  CreateSweep(numberOfFrames, 100.0, frames, imageToReferenceTransforms);
+
+  int outputExtent[6] = { 0, 199, 0, 199, 0, 299 };
+  double outputSpacing[3] = { 0.5, 0.5, 0.5 };
+  double outputOrigin[3] = { 0.0, 0.0, 0.0 };
+
+  vtkPlusPasteSliceIntoVolume::CompoundingType compoundingModes[] = { vtkPlusPasteSliceIntoVolume::LATEST_COMPOUNDING_MODE, vtkPlusPasteSliceIntoVolume::MEAN_COMPOUNDING_MODE, vtkPlusPasteSliceIntoVolume::MAXIMUM_COMPOUNDING_MODE };
+  int numberOfErrors = 0;
+  for (unsigned int compoundingIndex = 0; compoundingIndex < sizeof(compoundingModes) / sizeof(compoundingModes[0]); ++compoundingIndex)
+  {
+    vtkSmartPointer<vtkPlusPasteSliceIntoVolume> reconstructor = vtkSmartPointer<vtkPlusPasteSliceIntoVolume>::New();
+    reconstructor->SetOutputExtent(outputExtent);
+    reconstructor->SetOutputSpacing(outputSpacing);
+    reconstructor->SetOutputOrigin(outputOrigin);
+    reconstructor->SetInterpolationMode(vtkPlusPasteSliceIntoVolume::LINEAR_INTERPOLATION);
+    reconstructor->SetOptimization(vtkPlusPasteSliceIntoVolume::PARTIAL_OPTIMIZATION);
+    reconstructor->SetCompoundingMode(compoundingModes[compoundingIndex]);
+    reconstructor->SetNumberOfThreads(1);
+
+    reconstructor->EnableSimdOff();
+    double scalarProcessingTimeSec = ReconstructVolume(reconstructor, frames, imageToReferenceTransforms);
+    vtkSmartPointer<vtkImageData> scalarVolume = vtkSmartPointer<vtkImageData>::New();
+    scalarVolume->DeepCopy(reconstructor->GetReconstructedVolume());
+    vtkSmartPointer<vtkImageData> scalarAccumulationBuffer = vtkSmartPointer<vtkImageData>::New();
+    scalarAccumulationBuffer->DeepCopy(reconstructor->GetAccumulationBuffer());
+
+    reconstructor->EnableSimdOn();
+    double simdProcessingTimeSec = ReconstructVolume(reconstructor, frames, imageToReferenceTransforms);
+
+    LOG_INFO(reconstructor->GetCompoundingModeAsString(compoundingModes[compoundingIndex]) << ": "
+             << std::fixed << std::setprecision(1)
+             << "scalar: " << numberOfFrames / scalarProcessingTimeSec << " frames/s, "
+             << "SIMD: " << numberOfFrames / simdProcessingTimeSec << " frames/s");
+
+    if (!IsImageScalarsEqual(scalarVolume, reconstructor->GetReconstructedVolume()))
+    {
+      LOG_ERROR("Volume reconstructed with SIMD insertion is different from scalar insertion ("
+                << reconstructor->GetCompoundingModeAsString(compoundingModes[compoundingIndex]) << ")");
+      numberOfErrors++;
+    }
+    if (!IsImageScalarsEqual(scalarAccumulationBuffer, reconstructor->GetAccumulationBuffer()))
+    {
+      LOG_ERROR("Accumulation buffer with SIMD insertion is different from scalar insertion ("
+                << reconstructor->GetCompoundingModeAsString(compoundingModes[compoundingIndex]) << ")");
+      numberOfErrors++;
+    }
+  }
+
+  if (numberOfErrors > 0)
+  {
+    LOG_ERROR("Test failed, number of errors: " << numberOfErrors);
+    return EXIT_FAILURE;
+  }
+
+  LOG_INFO("Test completed successfully");
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,116 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+See License.txt for details.
+=========================================================Plus=header=end*/
+
+/*!
+\file vtkPlusSparseVolumeTest.cxx
+Reconstruct a volume from a synthetic freehand sweep with dense and sparse output and verify that the reconstructed
+volumes and accumulation buffers are identical for all interpolation, optimization, and compounding modes.
+Report the memory size of the allocated bricks compared to the dense volume and accumulation buffer.
+*/
+
+#include "PlusConfigure.h"
+#include "PlusVolumeReconstructionTestUtilities.h"
+#include "vtkPlusPasteSliceIntoVolume.h"
+#include "vtkPlusSparseVolume.h"
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkMatrix4x4.h>
+#include <vtkSmartPointer.h>
+#include <vtksys/CommandLineArguments.hxx>
+
+#include <cstdlib>
+
+using namespace PlusVolumeReconstructionTestUtilities;
+
+//----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  int numberOfFrames = 200;
+
+  vtksys::CommandLineArguments args;
+  args.Initialize(argc, argv);
+  args.AddArgument("--frames", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &numberOfFrames, "Number of frames in the synthetic sweep (default: 200)");
+  ParseArguments(args);
+
+  std::vector< vtkSmartPointer<vtkImageData> > frames;
+  std::vector< vtkSmartPointer<vtkMatrix4x4> > imageToReferenceTransforms;
+  CreateSweep(numberOfFrames, 200.0, frames, imageToReferenceTransforms);
+
+  int outputExtent[6] = { 0, 299, 0, 299, 0, 499 };
+  double outputSpacing[3] = { 0.5, 0.5, 0.5 };
+  double outputOrigin[3] = { 0.0, 0.0, 0.0 };
+
+  vtkPlusPasteSliceIntoVolume::InterpolationType interpolationModes[] = { vtkPlusPasteSliceIntoVolume::NEAREST_NEIGHBOR_INTERPOLATION, vtkPlusPasteSliceIntoVolume::LINEAR_INTERPOLATION };
+  vtkPlusPasteSliceIntoVolume::OptimizationType optimizationModes[] = { vtkPlusPasteSliceIntoVolume::FULL_OPTIMIZATION, vtkPlusPasteSliceIntoVolume::NO_OPTIMIZATION };
+  vtkPlusPasteSliceIntoVolume::CompoundingType compoundingModes[] = { vtkPlusPasteSliceIntoVolume::LATEST_COMPOUNDING_MODE, vtkPlusPasteSliceIntoVolume::MEAN_COMPOUNDING_MODE, vtkPlusPasteSliceIntoVolume::MAXIMUM_COMPOUNDING_MODE };
+  int numberOfErrors = 0;
+  for (unsigned int interpolationIndex = 0; interpolationIndex < sizeof(interpolationModes) / sizeof(interpolationModes[0]); ++interpolationIndex)
+  {
+    for (unsigned int optimizationIndex = 0; optimizationIndex < sizeof(optimizationModes) / sizeof(optimizationModes[0]); ++optimizationIndex)
+    {
+      for (unsigned int compoundingIndex = 0; compoundingIndex < sizeof(compoundingModes) / sizeof(compoundingModes[0]); ++compoundingIndex)
+      {
+        vtkSmartPointer<vtkPlusPasteSliceIntoVolume> reconstructor = vtkSmartPointer<vtkPlusPasteSliceIntoVolume>::New();
+        reconstructor->SetOutputExtent(outputExtent);
+        reconstructor->SetOutputSpacing(outputSpacing);
+        reconstructor->SetOutputOrigin(outputOrigin);
+        reconstructor->SetInterpolationMode(interpolationModes[interpolationIndex]);
+        reconstructor->SetOptimization(optimizationModes[optimizationIndex]);
+        reconstructor->SetCompoundingMode(compoundingModes[compoundingIndex]);
+
+        reconstructor->SparseOutputOff();
+        ReconstructVolume(reconstructor, frames, imageToReferenceTransforms);
+        vtkSmartPointer<vtkImageData> denseVolume = vtkSmartPointer<vtkImageData>::New();
+        denseVolume->DeepCopy(reconstructor->GetReconstructedVolume());
+        vtkSmartPointer<vtkImageData> denseAccumulationBuffer = vtkSmartPointer<vtkImageData>::New();
+        denseAccumulationBuffer->DeepCopy(reconstructor->GetAccumulationBuffer());
+
+        reconstructor->SparseOutputOn();
+        ReconstructVolume(reconstructor, frames, imageToReferenceTransforms);
+        vtkPlusSparseVolume* sparseVolume = reconstructor->GetSparseVolume();
+        double denseMemorySizeMb = double(outputExtent[1] - outputExtent[0] + 1) * (outputExtent[3] - outputExtent[2] + 1) * (outputExtent[5] - outputExtent[4] + 1)
+                                   * (sizeof(unsigned char) + sizeof(unsigned short)) / 1024.0 / 1024.0;
+        LOG_INFO(reconstructor->GetInterpolationModeAsString(interpolationModes[interpolationIndex]) << ", "
+                 << reconstructor->GetOptimizationModeAsString(optimizationModes[optimizationIndex]) << ", "
+                 << reconstructor->GetCompoundingModeAsString(compoundingModes[compoundingIndex]) << ": "
+                 << sparseVolume->GetNumberOfAllocatedBricks() << " of " << sparseVolume->GetTotalNumberOfBricks() << " bricks allocated, "
+                 << sparseVolume->GetAllocatedMemorySize() / 1024.0 / 1024.0 << " MB (dense: " << denseMemorySizeMb << " MB)");
+
+        if (!IsImageScalarsEqual(denseVolume, reconstructor->GetReconstructedVolume()))
+        {
+          LOG_ERROR("Volume reconstructed with sparse output is different from dense output ("
+                    << reconstructor->GetInterpolationModeAsString(interpolationModes[interpolationIndex]) << ", "
+                    << reconstructor->GetOptimizationModeAsString(optimizationModes[optimizationIndex]) << ", "
+                    << reconstructor->GetCompoundingModeAsString(compoundingModes[compoundingIndex]) << ")");
+          numberOfErrors++;
+        }
+        if (!IsImageScalarsEqual(denseAccumulationBuffer, reconstructor->GetAccumulationBuffer()))
+        {
+          LOG_ERROR("Accumulation buffer with sparse output is different from dense output ("
+                    << reconstructor->GetInterpolationModeAsString(interpolationModes[interpolationIndex]) << ", "
+                    << reconstructor->GetOptimizationModeAsString(optimizationModes[optimizationIndex]) << ", "
+                    << reconstructor->GetCompoundingModeAsString(compoundingModes[compoundingIndex]) << ")");
+          numberOfErrors++;
+        }
+        if (sparseVolume->GetNumberOfAllocatedBricks() >= sparseVolume->GetTotalNumberOfBricks())
+        {
+          LOG_ERROR("All bricks of the sparse volume are allocated, the sweep should only touch a part of the volume");
+          numberOfErrors++;
+        }
+      }
+    }
+  }
+
+  if (numberOfErrors > 0)
+  {
+    LOG_ERROR("Test failed, number of errors: " << numberOfErrors);
+    return EXIT_FAILURE;
+  }
+
+  LOG_INFO("Test completed successfully");
+  return EXIT_SUCCESS;
+}
@@ -8,13 +8,200 @@
 #include "PlusTrackedFrame.h"
 #include "vtkImageData.h"
 #include "vtkMatrix4x4.h"
+#include "vtkMultiThreader.h"
 #include "vtkPlusSequenceIO.h"
 #include "vtkPlusTrackedFrameList.h"
 #include "vtkPlusTransformRepository.h"
 #include "vtkPlusVolumeReconstructor.h"
 #include "vtkXMLUtilities.h"
 #include "vtksys/CommandLineArguments.hxx"
+#include "vtksys/SystemTools.hxx"
 
+#include <algorithm>
+#include <atomic>
+#include <iomanip>
+#include <thread>
+#include <vector>
+
+namespace
+{
+  /*! Result of the reconstruction of one input sequence */
+  struct SweepResult
+  {
+    SweepResult()
+      : Status(PLUS_FAIL)
+      , NumberOfFrames(0)
+      , NumberOfFramesAddedToVolume(0)
+      , ReconstructionTimeSec(0.0)
+      , SavingTimeSec(0.0)
+    {
+    }
+    PlusStatus Status;
+    int NumberOfFrames;
+    int NumberOfFramesAddedToVolume;
+    double ReconstructionTimeSec;
+    double SavingTimeSec;
+  };
+}
+
+//----------------------------------------------------------------------------
+// Create a reconstructor with the settings in the configuration file and the command-line arguments
+vtkSmartPointer<vtkPlusVolumeReconstructor> CreateReconstructor(vtkXMLDataElement* configRootElement, const std::string& importanceMaskFileName, const std::string& inputImageToReferenceTransformName)
+{
+  vtkSmartPointer<vtkPlusVolumeReconstructor> reconstructor = vtkSmartPointer<vtkPlusVolumeReconstructor>::New();
+  if (reconstructor->ReadConfiguration(configRootElement) != PLUS_SUCCESS)
+  {
+    return NULL;
+  }
+  if (!importanceMaskFileName.empty())
+  {
+    reconstructor->SetImportanceMaskFilename(importanceMaskFileName);
+  }
+  if (!inputImageToReferenceTransformName.empty())
+  {
+    // image to reference transform is specified at the command-line
+    PlusTransformName imageToReferenceTransformName;
+    if (imageToReferenceTransformName.SetTransformName(inputImageToReferenceTransformName.c_str()) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Invalid image to reference transform name: " << inputImageToReferenceTransformName);
+      return NULL;
+    }
+    reconstructor->SetImageCoordinateFrame(imageToReferenceTransformName.From().c_str());
+    reconstructor->SetReferenceCoordinateFrame(imageToReferenceTransformName.To().c_str());
+  }
+  return reconstructor;
+}
+
+//----------------------------------------------------------------------------
+// Insert all the frames of a sequence file into the volume. Frames are read from the file one by one.
+PlusStatus ReconstructSequence(vtkPlusVolumeReconstructor* reconstructor, vtkPlusTransformRepository* transformRepository, const std::string& inputImgSeqFileName,
+                               int readAheadFrameCount, bool printProgress, const std::string& outputFrameFileName, const PlusTransformName& imageToReferenceTransformName,
+                               SweepResult& result)
+{
+  // Read image sequence header. Images are read one by one during the reconstruction, so the
+  // whole sequence does not have to fit into memory. The next few frames are read ahead on a
+  // separate thread, so file reading and decompression overlaps with slice insertion.
+  LOG_INFO("Reading image sequence " << inputImgSeqFileName);
+  vtkSmartPointer<vtkPlusSequenceIOBase> sequenceReader = vtkSmartPointer<vtkPlusSequenceIOBase>::Take(vtkPlusSequenceIO::CreateSequenceReaderForFile(inputImgSeqFileName));
+  if (sequenceReader.GetPointer() != NULL)
+  {
+    sequenceReader->SetReadAheadFrameCount(readAheadFrameCount);
+  }
+  if (sequenceReader.GetPointer() == NULL || sequenceReader->StartFrameByFrameReading() != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Unable to load input sequences file.");
+    return PLUS_FAIL;
+  }
+  vtkPlusTrackedFrameList* trackedFrameList = sequenceReader->GetTrackedFrameList();
+
+  LOG_INFO("Set volume output extent...");
+  std::string errorDetail;
+  unsigned int frameSize[3] = { sequenceReader->GetDimensions()[0], sequenceReader->GetDimensions()[1], sequenceReader->GetDimensions()[2] };
+  if (reconstructor->SetOutputExtentFromFrameList(trackedFrameList, transformRepository, frameSize, sequenceReader->GetPixelType(), errorDetail) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Failed to set output extent of volume!");
+    return PLUS_FAIL;
+  }
+
+  LOG_INFO("Reconstruct volume...");
+  const int numberOfFrames = trackedFrameList->GetNumberOfTrackedFrames();
+  int numberOfFramesAddedToVolume = 0;
+
+  PlusTrackedFrame trackedFrame;
+  PlusTrackedFrame* frame = &trackedFrame;
+  for (int frameIndex = 0; frameIndex < numberOfFrames; ++frameIndex)
+  {
+    // Frames are stored sequentially in the file, so skipped frames have to be read, too
+    if (sequenceReader->ReadNextFrame(trackedFrame) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to read frame #" << frameIndex << " from the input sequence file");
+      break;
+    }
+    if (frameIndex % reconstructor->GetSkipInterval() != 0)
+    {
+      continue;
+    }
+
+    LOG_DEBUG("Frame: " << frameIndex);
+    if (printProgress)
+    {
+      vtkPlusLogger::PrintProgressbar((100.0 * frameIndex) / numberOfFrames);
+    }
+
+    if (transformRepository->SetTransforms(*frame) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to update transform repository with frame #" << frameIndex);
+      continue;
+    }
+
+    // Insert slice for reconstruction
+    bool insertedIntoVolume = false;
+    if (reconstructor->AddTrackedFrame(frame, transformRepository, &insertedIntoVolume) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to add tracked frame to volume with frame #" << frameIndex);
+      continue;
+    }
+
+    if (insertedIntoVolume)
+    {
+      numberOfFramesAddedToVolume++;
+    }
+
+    // Write an ITK image with the image pose in the reference coordinate system
+    if (!outputFrameFileName.empty())
+    {
+      vtkSmartPointer<vtkMatrix4x4> imageToReferenceTransformMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+      if (transformRepository->GetTransform(imageToReferenceTransformName, imageToReferenceTransformMatrix) != PLUS_SUCCESS)
+      {
+        std::string strImageToReferenceTransformName;
+        imageToReferenceTransformName.GetTransformName(strImageToReferenceTransformName);
+        LOG_ERROR("Failed to get transform '" << strImageToReferenceTransformName << "' from transform repository!");
+        continue;
+      }
+
+      // Print the image to reference transform
+      std::ostringstream os;
+      imageToReferenceTransformMatrix->Print(os);
+      LOG_TRACE("Image to reference transform: \n" << os.str());
+
+      // Insert frame index before the file extension (image.mha => image001.mha)
+      std::ostringstream ss;
+      size_t found;
+      found = outputFrameFileName.find_last_of(".");
+      ss << outputFrameFileName.substr(0, found);
+      ss.width(3);
+      ss.fill('0');
+      ss << frameIndex;
+      ss << outputFrameFileName.substr(found);
+
+      frame->WriteToFile(ss.str(), imageToReferenceTransformMatrix);
+    }
+  }
+
+  if (printProgress)
+  {
+    vtkPlusLogger::PrintProgressbar(100);
+  }
+
+  sequenceReader->StopFrameByFrameReading();
+  trackedFrameList->Clear();
+
+  LOG_INFO("Number of frames added to the volume: " << numberOfFramesAddedToVolume << " out of " << numberOfFrames);
+  result.NumberOfFrames = numberOfFrames;
+  result.NumberOfFramesAddedToVolume = numberOfFramesAddedToVolume;
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+// Default output volume file name in batch mode: <input path>/<input name>_Volume.mha
+std::string GetDefaultOutputVolumeFileName(const std::string& inputImgSeqFileName)
+{
+  std::string path = vtksys::SystemTools::GetFilenamePath(inputImgSeqFileName);
+  std::string name = vtksys::SystemTools::GetFilenameWithoutLastExtension(inputImgSeqFileName) + "_Volume.mha";
+  return path.empty() ? name : path + "/" + name;
+}
+
+//----------------------------------------------------------------------------
 int main(int argc, char* argv[])
 {
   bool printHelp(false);
@@ -28,6 +215,8 @@ int main(int argc, char* argv[])
   std::string outputFrameFileName;
   std::string importanceMaskFileName;
   std::string inputImageToReferenceTransformName;
+  std::vector<std::string> inputImgSeqFileNames;
+  std::vector<std::string> outputVolumeFileNames;
 
   // Deprecated arguments (2013-07-29, #800)
   std::string inputImageToReferenceTransformNameDeprecated;
@@ -37,6 +226,10 @@ int main(int argc, char* argv[])
 
   bool disableCompression = false;
 
+  int readAheadFrameCount = 16;
+  int numberOfConcurrentSweeps = 0;
+  int threadBudget = 0;
+
   vtksys::CommandLineArguments cmdargs;
   cmdargs.Initialize(argc, argv);
 
@@ -50,6 +243,11 @@ int main(int argc, char* argv[])
   cmdargs.AddArgument("--disable-compression", vtksys::CommandLineArguments::NO_ARGUMENT, &disableCompression, "Do not compress output image files.");
   cmdargs.AddArgument("--verbose", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &verboseLevel, "Verbose level (1=error only, 2=warning, 3=info, 4=debug, 5=trace)");
   cmdargs.AddArgument("--importance-mask-file", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &importanceMaskFileName, "The file to use as the importance mask.");
+  cmdargs.AddArgument("--source-seq-files", vtksys::CommandLineArguments::MULTI_ARGUMENT, &inputImgSeqFileNames, "Batch mode: list of input sequence files (.mha/.nrrd), separated by spaces. A volume is reconstructed from each sequence, using the same configuration. Sweeps are reconstructed concurrently and a timing table is printed at the end.");
+  cmdargs.AddArgument("--output-volume-files", vtksys::CommandLineArguments::MULTI_ARGUMENT, &outputVolumeFileNames, "Batch mode: list of output volume files, one for each input sequence file. If not specified then each volume is written next to its input sequence file, with a _Volume.mha suffix.");
+  cmdargs.AddArgument("--concurrent-sweeps", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &numberOfConcurrentSweeps, "Batch mode: maximum number of sweeps that are reconstructed at the same time. 0 means one sweep per thread of the thread budget. (default: 0)");
+  cmdargs.AddArgument("--thread-budget", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &threadBudget, "Batch mode: total number of threads that are shared between the concurrently reconstructed sweeps. It overrides NumberOfThreads in the configuration file. 0 means one thread per processor core. (default: 0)");
+  cmdargs.AddArgument("--read-ahead-frames", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &readAheadFrameCount, "Number of frames that are read and decompressed from the input sequence file on a separate thread while the previous frames are inserted into the volume. Set to 0 to read the frames on the reconstruction thread. (default: 16)");
 
   // Deprecated arguments (2013-07-29, #800)
   cmdargs.AddArgument("--transform", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &inputImageToReferenceTransformNameDeprecated, "Image to reference transform name used for the reconstruction. DEPRECATED, use --image-to-reference-transform argument instead");
@@ -107,8 +305,6 @@ int main(int argc, char* argv[])
     exit(EXIT_FAILURE);
   }
 
-  vtkSmartPointer<vtkPlusVolumeReconstructor> reconstructor = vtkSmartPointer<vtkPlusVolumeReconstructor>::New();
-
   LOG_INFO("Reading configuration file:" << inputConfigFileName);
   vtkSmartPointer<vtkXMLDataElement> configRootElement = vtkSmartPointer<vtkXMLDataElement>::New();
   if (PlusXmlUtils::ReadDeviceSetConfigurationFromFile(configRootElement, inputConfigFileName.c_str()) == PLUS_FAIL)
@@ -117,17 +313,6 @@ int main(int argc, char* argv[])
     return EXIT_FAILURE;
   }
 
-  if (reconstructor->ReadConfiguration(configRootElement) != PLUS_SUCCESS)
-  {
-    LOG_ERROR("Failed to read configuration from " << inputConfigFileName.c_str());
-    return EXIT_FAILURE;
-  }
-
-  if (!importanceMaskFileName.empty())
-  {
-    reconstructor->SetImportanceMaskFilename(importanceMaskFileName);
-  }
-
   vtkSmartPointer<vtkPlusTransformRepository> transformRepository = vtkSmartPointer<vtkPlusTransformRepository>::New();
   if (configRootElement->FindNestedElementWithName("CoordinateDefinitions") != NULL)
   {
@@ -147,103 +332,141 @@ int main(int argc, char* argv[])
   transformRepository->Print(osTransformRepo);
   LOG_DEBUG("Transform repository: \n" << osTransformRepo.str());
 
-  // Read image sequence
-  LOG_INFO("Reading image sequence " << inputImgSeqFileName);
-  vtkSmartPointer<vtkPlusTrackedFrameList> trackedFrameList = vtkSmartPointer<vtkPlusTrackedFrameList>::New();
-  if (vtkPlusSequenceIO::Read(inputImgSeqFileName, trackedFrameList) != PLUS_SUCCESS)
-  {
-    LOG_ERROR("Unable to load input sequences file.");
-    exit(EXIT_FAILURE);
-  }
-
-  // Reconstruct volume
-  PlusTransformName imageToReferenceTransformName;
-  if (!inputImageToReferenceTransformName.empty())
+  if (!inputImgSeqFileNames.empty())
   {
-    // image to reference transform is specified at the command-line
-    if (imageToReferenceTransformName.SetTransformName(inputImageToReferenceTransformName.c_str()) != PLUS_SUCCESS)
+    // Batch mode
+    if (!outputVolumeFileNames.empty() && outputVolumeFileNames.size() != inputImgSeqFileNames.size())
     {
-      LOG_ERROR("Invalid image to reference transform name: " << inputImageToReferenceTransformName);
+      LOG_ERROR("Number of output volume files (" << outputVolumeFileNames.size() << ") does not match the number of input sequence files (" << inputImgSeqFileNames.size() << ")");
       return EXIT_FAILURE;
     }
-    reconstructor->SetImageCoordinateFrame(imageToReferenceTransformName.From().c_str());
-    reconstructor->SetReferenceCoordinateFrame(imageToReferenceTransformName.To().c_str());
-  }
-
-  LOG_INFO("Set volume output extent...");
-  std::string errorDetail;
-  if (reconstructor->SetOutputExtentFromFrameList(trackedFrameList, transformRepository, errorDetail) != PLUS_SUCCESS)
-  {
-    LOG_ERROR("Failed to set output extent of volume!");
-    return EXIT_FAILURE;
-  }
-
-  LOG_INFO("Reconstruct volume...");
-  const int numberOfFrames = trackedFrameList->GetNumberOfTrackedFrames();
-  int numberOfFramesAddedToVolume = 0;
-
-  for (int frameIndex = 0; frameIndex < numberOfFrames; frameIndex += reconstructor->GetSkipInterval())
-  {
-    LOG_DEBUG("Frame: " << frameIndex);
-    vtkPlusLogger::PrintProgressbar((100.0 * frameIndex) / numberOfFrames);
-
-    PlusTrackedFrame* frame = trackedFrameList->GetTrackedFrame(frameIndex);
-
-    if (transformRepository->SetTransforms(*frame) != PLUS_SUCCESS)
+    if (!inputImgSeqFileName.empty() || !outputVolumeFileName.empty() || !outputVolumeAccumulationFileName.empty() || !outputFrameFileName.empty())
     {
-      LOG_ERROR("Failed to update transform repository with frame #" << frameIndex);
-      continue;
+      LOG_ERROR("The --source-seq-file, --output-volume-file, --output-volume-accumulation-file, and --output-frame-file arguments cannot be used with --source-seq-files");
+      return EXIT_FAILURE;
     }
-
-    // Insert slice for reconstruction
-    bool insertedIntoVolume = false;
-    if (reconstructor->AddTrackedFrame(frame, transformRepository, &insertedIntoVolume) != PLUS_SUCCESS)
+    const int numberOfSweeps = static_cast<int>(inputImgSeqFileNames.size());
+    if (outputVolumeFileNames.empty())
     {
-      LOG_ERROR("Failed to add tracked frame to volume with frame #" << frameIndex);
-      continue;
+      for (int sweepIndex = 0; sweepIndex < numberOfSweeps; ++sweepIndex)
+      {
+        outputVolumeFileNames.push_back(GetDefaultOutputVolumeFileName(inputImgSeqFileNames[sweepIndex]));
+      }
     }
 
-    if (insertedIntoVolume)
+    // The thread budget is shared between the concurrently reconstructed sweeps
+    if (threadBudget <= 0)
     {
-      numberOfFramesAddedToVolume++;
+      threadBudget = vtkMultiThreader::GetGlobalDefaultNumberOfThreads();
     }
-
-    // Write an ITK image with the image pose in the reference coordinate system
-    if (!outputFrameFileName.empty())
+    if (numberOfConcurrentSweeps <= 0)
     {
-      vtkSmartPointer<vtkMatrix4x4> imageToReferenceTransformMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
-      if (transformRepository->GetTransform(imageToReferenceTransformName, imageToReferenceTransformMatrix) != PLUS_SUCCESS)
+      numberOfConcurrentSweeps = threadBudget;
+    }
+    numberOfConcurrentSweeps = std::max(1, std::min(numberOfConcurrentSweeps, numberOfSweeps));
+    int numberOfThreadsPerSweep = std::max(1, threadBudget / numberOfConcurrentSweeps);
+    LOG_INFO("Reconstruct " << numberOfSweeps << " sweeps, " << numberOfConcurrentSweeps << " at a time, using " << numberOfThreadsPerSweep << " threads for each sweep");
+
+    // Reconstructors and transform repositories are set up from the already parsed configuration.
+    // Each sweep needs its own transform repository, as it is updated with the transforms of each frame.
+    std::vector< vtkSmartPointer<vtkPlusVolumeReconstructor> > reconstructors(numberOfSweeps);
+    std::vector< vtkSmartPointer<vtkPlusTransformRepository> > transformRepositories(numberOfSweeps);
+    for (int sweepIndex = 0; sweepIndex < numberOfSweeps; ++sweepIndex)
+    {
+      reconstructors[sweepIndex] = CreateReconstructor(configRootElement, importanceMaskFileName, inputImageToReferenceTransformName);
+      if (reconstructors[sweepIndex].GetPointer() == NULL)
       {
-        std::string strImageToReferenceTransformName;
-        imageToReferenceTransformName.GetTransformName(strImageToReferenceTransformName);
-        LOG_ERROR("Failed to get transform '" << strImageToReferenceTransformName << "' from transform repository!");
-        continue;
+        LOG_ERROR("Failed to read configuration from " << inputConfigFileName.c_str());
+        return EXIT_FAILURE;
       }
+      reconstructors[sweepIndex]->SetNumberOfThreads(numberOfThreadsPerSweep);
+      transformRepositories[sweepIndex] = vtkSmartPointer<vtkPlusTransformRepository>::New();
+      transformRepositories[sweepIndex]->DeepCopy(transformRepository, true);
+    }
 
-      // Print the image to reference transform
-      std::ostringstream os;
-      imageToReferenceTransformMatrix->Print(os);
-      LOG_TRACE("Image to reference transform: \n" << os.str());
-
-      // Insert frame index before the file extension (image.mha => image001.mha)
-      std::ostringstream ss;
-      size_t found;
-      found = outputFrameFileName.find_last_of(".");
-      ss << outputFrameFileName.substr(0, found);
-      ss.width(3);
-      ss.fill('0');
-      ss << frameIndex;
-      ss << outputFrameFileName.substr(found);
+    std::vector<SweepResult> results(numberOfSweeps);
+    std::atomic<int> nextSweepIndex(0);
+    auto reconstructSweeps = [&]()
+    {
+      for (int sweepIndex = nextSweepIndex++; sweepIndex < numberOfSweeps; sweepIndex = nextSweepIndex++)
+      {
+        SweepResult& result = results[sweepIndex];
+        double startTime = vtkPlusAccurateTimer::GetSystemTime();
+        result.Status = ReconstructSequence(reconstructors[sweepIndex], transformRepositories[sweepIndex], inputImgSeqFileNames[sweepIndex],
+                                            readAheadFrameCount, false, "", PlusTransformName(), result);
+        double reconstructedTime = vtkPlusAccurateTimer::GetSystemTime();
+        result.ReconstructionTimeSec = reconstructedTime - startTime;
+        if (result.Status == PLUS_SUCCESS)
+        {
+          result.Status = reconstructors[sweepIndex]->SaveReconstructedVolumeToMetafile(outputVolumeFileNames[sweepIndex], false, !disableCompression);
+          result.SavingTimeSec = vtkPlusAccurateTimer::GetSystemTime() - reconstructedTime;
+        }
+        if (result.Status != PLUS_SUCCESS)
+        {
+          LOG_ERROR("Failed to reconstruct volume from " << inputImgSeqFileNames[sweepIndex]);
+        }
+        // Release the volume before the next sweep is started
+        reconstructors[sweepIndex] = NULL;
+        transformRepositories[sweepIndex] = NULL;
+      }
+    };
 
-      frame->WriteToFile(ss.str(), imageToReferenceTransformMatrix);
+    double batchStartTime = vtkPlusAccurateTimer::GetSystemTime();
+    std::vector<std::thread> sweepThreads;
+    for (int threadIndex = 1; threadIndex < numberOfConcurrentSweeps; ++threadIndex)
+    {
+      sweepThreads.push_back(std::thread(reconstructSweeps));
     }
+    reconstructSweeps();
+    for (std::vector<std::thread>::iterator threadIt = sweepThreads.begin(); threadIt != sweepThreads.end(); ++threadIt)
+    {
+      threadIt->join();
+    }
+    double batchTimeSec = vtkPlusAccurateTimer::GetSystemTime() - batchStartTime;
+
+    // Timing table
+    int numberOfFailedSweeps = 0;
+    std::ostringstream table;
+    table << "Sweep reconstruction summary:\n";
+    table << std::setw(6) << "Sweep" << std::setw(10) << "Status" << std::setw(10) << "Frames" << std::setw(10) << "Inserted"
+          << std::setw(14) << "Reconstr.[s]" << std::setw(10) << "Save[s]" << "  Input -> Output\n";
+    for (int sweepIndex = 0; sweepIndex < numberOfSweeps; ++sweepIndex)
+    {
+      const SweepResult& result = results[sweepIndex];
+      if (result.Status != PLUS_SUCCESS)
+      {
+        numberOfFailedSweeps++;
+      }
+      table << std::setw(6) << sweepIndex << std::setw(10) << (result.Status == PLUS_SUCCESS ? "OK" : "FAILED")
+            << std::setw(10) << result.NumberOfFrames << std::setw(10) << result.NumberOfFramesAddedToVolume
+            << std::fixed << std::setprecision(2) << std::setw(14) << result.ReconstructionTimeSec << std::setw(10) << result.SavingTimeSec
+            << "  " << inputImgSeqFileNames[sweepIndex] << " -> " << outputVolumeFileNames[sweepIndex] << "\n";
+    }
+    table << "Total time: " << std::fixed << std::setprecision(2) << batchTimeSec << " s, failed sweeps: " << numberOfFailedSweeps;
+    LOG_INFO(table.str());
+
+    return (numberOfFailedSweeps > 0 ? EXIT_FAILURE : EXIT_SUCCESS);
   }
 
-  vtkPlusLogger::PrintProgressbar(100);
+  vtkSmartPointer<vtkPlusVolumeReconstructor> reconstructor = CreateReconstructor(configRootElement, importanceMaskFileName, inputImageToReferenceTransformName);
+  if (reconstructor.GetPointer() == NULL)
+  {
+    LOG_ERROR("Failed to read configuration from " << inputConfigFileName.c_str());
+    return EXIT_FAILURE;
+  }
 
-  trackedFrameList->Clear();
+  // Reconstruct volume
+  PlusTransformName imageToReferenceTransformName;
+  if (!inputImageToReferenceTransformName.empty())
+  {
+    imageToReferenceTransformName.SetTransformName(inputImageToReferenceTransformName.c_str());
+  }
 
-  LOG_INFO("Number of frames added to the volume: " << numberOfFramesAddedToVolume << " out of " << numberOfFrames);
+  SweepResult result;
+  if (ReconstructSequence(reconstructor, transformRepository, inputImgSeqFileName, readAheadFrameCount, true, outputFrameFileName, imageToReferenceTransformName, result) != PLUS_SUCCESS)
+  {
+    return EXIT_FAILURE;
+  }
 
   LOG_INFO("Saving volume to file...");
   reconstructor->SaveReconstructedVolumeToMetafile(outputVolumeFileName, false, !disableCompression);
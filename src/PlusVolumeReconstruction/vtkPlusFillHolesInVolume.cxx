@@ -55,11 +55,18 @@ POSSIBILITY OF SUCH DAMAGES.
 #include "vtkImageExtractComponents.h"
 #include "vtkMetaImageWriter.h"
 
+#include <algorithm>
+#include <atomic>
 #include <math.h>
+#include <string.h>
+#include <thread>
+#include <vector>
 
 static const int INPUT_PORT_RECONSTRUCTED_VOLUME=0;
 static const int INPUT_PORT_ACCUMULATION_BUFFER=1;
 
+static const int NUMBER_OF_STICK_DIRECTIONS=13;
+
 ///////////
 
 vtkStandardNewMacro(vtkPlusFillHolesInVolume);
@@ -222,27 +229,30 @@ bool FillHolesInVolumeElement::applyDistanceWeightInverse(
   unsigned short currentAccumulation(0);
   int numKnownVoxels(0);
 
-  for (int x = minX; x <= maxX; x++)
+  // clip the neighborhood to the volume boundaries (voxels are visited in the same order as without clipping)
+  int startX = std::max(minX, wholeExtent[0]);
+  int startY = std::max(minY, wholeExtent[2]);
+  int startZ = std::max(minZ, wholeExtent[4]);
+  int endX = std::min(maxX, wholeExtent[1]);
+  int endY = std::min(maxY, wholeExtent[3]);
+  int endZ = std::min(maxZ, wholeExtent[5]);
+
+  for (int x = startX; x <= endX; x++)
   {
-    for (int y = minY; y <= maxY; y++)
+    for (int y = startY; y <= endY; y++)
     {
-      for (int z = minZ; z <= maxZ; z++)
+      for (int z = startZ; z <= endZ; z++)
       {
-        if (x <= wholeExtent[1] && x >= wholeExtent[0] &&
-          y <= wholeExtent[3] && y >= wholeExtent[2] &&
-          z <= wholeExtent[5] && z >= wholeExtent[4] ) // check bounds
-        {
-          int accIndex =   accOffsets[0]*x+  accOffsets[1]*y+  accOffsets[2]*z;
-          currentAccumulation = accData[accIndex];
-          if (currentAccumulation) { // if the accumulation buffer for the voxel is non-zero
-            int volIndex = inputOffsets[0]*x+inputOffsets[1]*y+inputOffsets[2]*z+inputComp;
-            int kerIndex = size*size*(z-minZ)+size*(y-minY)+(x-minX);
-            double weight = kernel[kerIndex];
-            sumIntensities += inputData[volIndex] * weight;
-            sumAccumulator += weight;
-            numKnownVoxels++;
-          }
-        } // end boundary check
+        int accIndex =   accOffsets[0]*x+  accOffsets[1]*y+  accOffsets[2]*z;
+        currentAccumulation = accData[accIndex];
+        if (currentAccumulation) { // if the accumulation buffer for the voxel is non-zero
+          int volIndex = inputOffsets[0]*x+inputOffsets[1]*y+inputOffsets[2]*z+inputComp;
+          int kerIndex = size*size*(z-minZ)+size*(y-minY)+(x-minX);
+          double weight = kernel[kerIndex];
+          sumIntensities += inputData[volIndex] * weight;
+          sumAccumulator += weight;
+          numKnownVoxels++;
+        }
       } // end z loop
     } // end y loop
   } // end x loop
@@ -290,24 +300,26 @@ bool FillHolesInVolumeElement::applyNearestNeighbor(
     int maxX = thisPixel[0] + range;
     int maxY = thisPixel[1] + range;
     int maxZ = thisPixel[2] + range;
-    for (int x = minX; x <= maxX; x++)
+    // clip the neighborhood to the volume boundaries (voxels are visited in the same order as without clipping)
+    int startX = std::max(minX, wholeExtent[0]);
+    int startY = std::max(minY, wholeExtent[2]);
+    int startZ = std::max(minZ, wholeExtent[4]);
+    int endX = std::min(maxX, wholeExtent[1]);
+    int endY = std::min(maxY, wholeExtent[3]);
+    int endZ = std::min(maxZ, wholeExtent[5]);
+    for (int x = startX; x <= endX; x++)
     {
-      for (int y = minY; y <= maxY; y++)
+      for (int y = startY; y <= endY; y++)
       {
-        for (int z = minZ; z <= maxZ; z++)
+        for (int z = startZ; z <= endZ; z++)
         {
-          if (x <= wholeExtent[1] && x >= wholeExtent[0] &&
-            y <= wholeExtent[3] && y >= wholeExtent[2] &&
-            z <= wholeExtent[5] && z >= wholeExtent[4] ) // check bounds
-          {
-            int accIndex =   accOffsets[0]*x+  accOffsets[1]*y+  accOffsets[2]*z;
-            if (accData[accIndex]) { // if the accumulation buffer for the voxel is non-zero
-              int volIndex = inputOffsets[0]*x+inputOffsets[1]*y+inputOffsets[2]*z+inputComp;
-              sumIntensities += inputData[volIndex];
-              sumAccumulator++;
-              exit = true;
-            }
-          } // end boundary check
+          int accIndex =   accOffsets[0]*x+  accOffsets[1]*y+  accOffsets[2]*z;
+          if (accData[accIndex]) { // if the accumulation buffer for the voxel is non-zero
+            int volIndex = inputOffsets[0]*x+inputOffsets[1]*y+inputOffsets[2]*z+inputComp;
+            sumIntensities += inputData[volIndex];
+            sumAccumulator++;
+            exit = true;
+          }
         } // end z loop
       } // end y loop
     } // end x loop
@@ -358,27 +370,30 @@ bool FillHolesInVolumeElement::applyGaussian(
   unsigned short currentAccumulation(0);
   int numKnownVoxels(0);
 
-  for (int x = minX; x <= maxX; x++)
+  // clip the neighborhood to the volume boundaries (voxels are visited in the same order as without clipping)
+  int startX = std::max(minX, wholeExtent[0]);
+  int startY = std::max(minY, wholeExtent[2]);
+  int startZ = std::max(minZ, wholeExtent[4]);
+  int endX = std::min(maxX, wholeExtent[1]);
+  int endY = std::min(maxY, wholeExtent[3]);
+  int endZ = std::min(maxZ, wholeExtent[5]);
+
+  for (int x = startX; x <= endX; x++)
   {
-    for (int y = minY; y <= maxY; y++)
+    for (int y = startY; y <= endY; y++)
     {
-      for (int z = minZ; z <= maxZ; z++)
+      for (int z = startZ; z <= endZ; z++)
       {
-        if (x <= wholeExtent[1] && x >= wholeExtent[0] &&
-          y <= wholeExtent[3] && y >= wholeExtent[2] &&
-          z <= wholeExtent[5] && z >= wholeExtent[4] ) // check bounds
-        {
-          int accIndex =   accOffsets[0]*x+  accOffsets[1]*y+  accOffsets[2]*z;
-          currentAccumulation = accData[accIndex];
-          if (currentAccumulation) { // if the accumulation buffer for the voxel is non-zero
-            int volIndex = inputOffsets[0]*x+inputOffsets[1]*y+inputOffsets[2]*z+inputComp;
-            int kerIndex = size*size*(z-minZ)+size*(y-minY)+(x-minX);
-            double weight = kernel[kerIndex];
-            sumIntensities += inputData[volIndex] * weight;
-            sumAccumulator += weight;
-            numKnownVoxels++;
-          }
-        } // end boundary check
+        int accIndex =   accOffsets[0]*x+  accOffsets[1]*y+  accOffsets[2]*z;
+        currentAccumulation = accData[accIndex];
+        if (currentAccumulation) { // if the accumulation buffer for the voxel is non-zero
+          int volIndex = inputOffsets[0]*x+inputOffsets[1]*y+inputOffsets[2]*z+inputComp;
+          int kerIndex = size*size*(z-minZ)+size*(y-minY)+(x-minX);
+          double weight = kernel[kerIndex];
+          sumIntensities += inputData[volIndex] * weight;
+          sumAccumulator += weight;
+          numKnownVoxels++;
+        }
       } // end z loop
     } // end y loop
   } // end x loop
@@ -428,27 +443,30 @@ bool FillHolesInVolumeElement::applyGaussianAccumulation(
   unsigned short currentAccumulation(0);
   int numKnownVoxels(0);
 
-  for (int x = minX; x <= maxX; x++)
+  // clip the neighborhood to the volume boundaries (voxels are visited in the same order as without clipping)
+  int startX = std::max(minX, wholeExtent[0]);
+  int startY = std::max(minY, wholeExtent[2]);
+  int startZ = std::max(minZ, wholeExtent[4]);
+  int endX = std::min(maxX, wholeExtent[1]);
+  int endY = std::min(maxY, wholeExtent[3]);
+  int endZ = std::min(maxZ, wholeExtent[5]);
+
+  for (int x = startX; x <= endX; x++)
   {
-    for (int y = minY; y <= maxY; y++)
+    for (int y = startY; y <= endY; y++)
     {
-      for (int z = minZ; z <= maxZ; z++)
+      for (int z = startZ; z <= endZ; z++)
       {
-        if (x <= wholeExtent[1] && x >= wholeExtent[0] &&
-          y <= wholeExtent[3] && y >= wholeExtent[2] &&
-          z <= wholeExtent[5] && z >= wholeExtent[4] ) // check bounds
-        {
-          int accIndex =   accOffsets[0]*x+  accOffsets[1]*y+  accOffsets[2]*z;
-          currentAccumulation = accData[accIndex];
-          if (currentAccumulation) { // if the accumulation buffer for the voxel is non-zero
-            int volIndex = inputOffsets[0]*x+inputOffsets[1]*y+inputOffsets[2]*z+inputComp;
-            int kerIndex = size*size*(z-minZ)+size*(y-minY)+(x-minX);
-            double weight = currentAccumulation * kernel[kerIndex];
-            sumIntensities += inputData[volIndex] * weight;
-            sumAccumulator += weight;
-            numKnownVoxels++;
-          }
-        } // end boundary check
+        int accIndex =   accOffsets[0]*x+  accOffsets[1]*y+  accOffsets[2]*z;
+        currentAccumulation = accData[accIndex];
+        if (currentAccumulation) { // if the accumulation buffer for the voxel is non-zero
+          int volIndex = inputOffsets[0]*x+inputOffsets[1]*y+inputOffsets[2]*z+inputComp;
+          int kerIndex = size*size*(z-minZ)+size*(y-minY)+(x-minX);
+          double weight = currentAccumulation * kernel[kerIndex];
+          sumIntensities += inputData[volIndex] * weight;
+          sumAccumulator += weight;
+          numKnownVoxels++;
+        }
       } // end z loop
     } // end y loop
   } // end x loop
@@ -481,8 +499,8 @@ void FillHolesInVolumeElement::setupAsStick(int stickLengthLimit, int numberOfSt
 
 //----------------------------------------------------------------------------
 void FillHolesInVolumeElement::allocateSticks() {
-  numSticksInList = 13;
-  sticksList = new int[39];
+  numSticksInList = NUMBER_OF_STICK_DIRECTIONS;
+  sticksList = new int[3*NUMBER_OF_STICK_DIRECTIONS];
 
   // 1x1, 2x0
   sticksList[ 0] = 1; sticksList[ 1] = 0; sticksList[ 2] = 0; // x, y, z
@@ -527,8 +545,9 @@ bool FillHolesInVolumeElement::applySticks(
   int fwdTrav, rvsTrav; // store the number of voxels that have been searched
   T fwdVal, rvsVal; // store the values at each end of the stick
 
-  T* values = new T[numSticksInList];
-  double* weights = new double[numSticksInList];
+  // this function is called for each hole voxel, so use arrays on the stack instead of allocating memory
+  T values[NUMBER_OF_STICK_DIRECTIONS];
+  double weights[NUMBER_OF_STICK_DIRECTIONS];
 
   // try each stick direction
   for (int i = 0; i < numSticksInList; i++) {
@@ -636,9 +655,6 @@ bool FillHolesInVolumeElement::applySticks(
 
   }
 
-  delete[] weights;
-  delete[] values;
-
   if (sumWeights != 0) {
     returnVal = (T)(sumWeightedValues/sumWeights);
     return true; // at least one stick was good, = success
@@ -689,6 +705,8 @@ vtkPlusFillHolesInVolume::vtkPlusFillHolesInVolume()
   this->SetNumberOfOutputPorts(1);
   this->Compounding=0;
   HFElements = NULL;
+  this->BlockedExecution = true;
+  this->BrickSize = 32;
 }
 
 //----------------------------------------------------------------------------
@@ -703,6 +721,8 @@ void vtkPlusFillHolesInVolume::PrintSelf(ostream& os, vtkIndent indent)
 {
   this->Superclass::PrintSelf(os, indent);
   os << indent << "Compounding: " << this->Compounding<< "\n";
+  os << indent << "BlockedExecution: " << (this->BlockedExecution ? "true" : "false") << "\n";
+  os << indent << "BrickSize: " << this->BrickSize << "\n";
 }
 
 //----------------------------------------------------------------------------
@@ -883,6 +903,205 @@ void vtkPlusFillHolesInVolume::ThreadedRequestData(vtkInformation *request,
     }
 }
 
+//----------------------------------------------------------------------------
+int vtkPlusFillHolesInVolume::RequestData(vtkInformation *request,
+    vtkInformationVector **inputVector,
+    vtkInformationVector *outputVector)
+{
+  if (!this->BlockedExecution)
+  {
+    return this->Superclass::RequestData(request, inputVector, outputVector);
+  }
+
+  vtkInformation* outInfo = outputVector->GetInformationObject(0);
+  vtkImageData* outVolData = vtkImageData::SafeDownCast(outInfo->Get(vtkDataObject::DATA_OBJECT()));
+  vtkImageData* inVolData = vtkImageData::GetData(inputVector[INPUT_PORT_RECONSTRUCTED_VOLUME]);
+  vtkImageData* inAccData = vtkImageData::GetData(inputVector[INPUT_PORT_ACCUMULATION_BUFFER]);
+  if (outVolData == NULL || inVolData == NULL || inAccData == NULL)
+  {
+    LOG_ERROR("vtkPlusFillHolesInVolume::RequestData failed: reconstructed volume or accumulation buffer is not set");
+    return 0;
+  }
+
+  int outExt[6];
+  outInfo->Get(vtkStreamingDemandDrivenPipeline::UPDATE_EXTENT(), outExt);
+  this->AllocateOutputData(outVolData, outInfo, outExt);
+  this->CopyAttributeData(inVolData, outVolData, inputVector);
+
+  // this filter expects that input is the same type as output.
+  if (inVolData->GetScalarType() != outVolData->GetScalarType())
+  {
+    LOG_ERROR("Execute: input data type, " 
+              << inVolData->GetScalarType()
+              << ", must match out ScalarType " 
+              << outVolData->GetScalarType());
+    return 0;
+  }
+
+  void *outVolPtr = outVolData->GetScalarPointer();
+  void *inVolPtr = inVolData->GetScalarPointer();
+  void *inAccPtr = inAccData->GetScalarPointer();
+  switch (inVolData->GetScalarType())
+  {
+    vtkTemplateMacro(
+      FillHolesInBricks(inVolData, static_cast<VTK_TT *>(inVolPtr),
+                        inAccData, static_cast<unsigned short *>(inAccPtr),
+                        outVolData, static_cast<VTK_TT *>(outVolPtr), outExt));
+  default:
+    LOG_ERROR("Execute: Unknown ScalarType");
+    return 0;
+  }
+
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+template <class T>
+void vtkPlusFillHolesInVolume::FillHolesInBricks(vtkImageData *inVolData,
+                             T *inVolPtr, 
+                             vtkImageData *accData,
+                             unsigned short *accPtr, 
+                             vtkImageData *outData, 
+                             T *outPtr,
+                             int outExt[6])
+{
+  int brickSize = std::max(this->BrickSize, 1);
+  int numberOfBricks[3] = {0};
+  for (int axis = 0; axis < 3; ++axis)
+  {
+    numberOfBricks[axis] = (outExt[2 * axis + 1] - outExt[2 * axis] + brickSize) / brickSize;
+    if (numberOfBricks[axis] <= 0)
+    {
+      // empty output extent
+      return;
+    }
+  }
+  int totalNumberOfBricks = numberOfBricks[0] * numberOfBricks[1] * numberOfBricks[2];
+
+  int numberOfThreads = this->GetNumberOfThreads();
+  if (numberOfThreads < 1)
+  {
+    numberOfThreads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+  }
+  numberOfThreads = std::min(numberOfThreads, totalNumberOfBricks);
+
+  // Each thread processes a contiguous range of bricks (bricks are ordered by z, y, x; neighbor bricks share
+  // part of their neighborhood). When a thread is finished with its own range then it takes the next unprocessed bricks
+  // from the ranges of the other threads.
+  struct BrickRange
+  {
+    std::atomic<int> NextBrickIndex;
+    int EndBrickIndex;
+    char Padding[64]; // keep the counters of different threads in different cache lines
+  };
+  std::vector<BrickRange> brickRanges(numberOfThreads);
+  for (int threadIndex = 0; threadIndex < numberOfThreads; ++threadIndex)
+  {
+    brickRanges[threadIndex].NextBrickIndex = static_cast<int>(static_cast<long long>(totalNumberOfBricks) * threadIndex / numberOfThreads);
+    brickRanges[threadIndex].EndBrickIndex = static_cast<int>(static_cast<long long>(totalNumberOfBricks) * (threadIndex + 1) / numberOfThreads);
+  }
+
+  std::atomic<int> numberOfProcessedBricks(0);
+  auto processBricks = [&](int threadIndex)
+  {
+    for (int rangeOffset = 0; rangeOffset < numberOfThreads; ++rangeOffset)
+    {
+      // own range first, then the ranges of the other threads
+      BrickRange& range = brickRanges[(threadIndex + rangeOffset) % numberOfThreads];
+      for (int brickIndex = range.NextBrickIndex++; brickIndex < range.EndBrickIndex; brickIndex = range.NextBrickIndex++)
+      {
+        if (this->GetAbortExecute())
+        {
+          return;
+        }
+        int brickPosition[3] =
+        {
+          brickIndex % numberOfBricks[0],
+          (brickIndex / numberOfBricks[0]) % numberOfBricks[1],
+          brickIndex / (numberOfBricks[0] * numberOfBricks[1])
+        };
+        int brickExt[6];
+        for (int axis = 0; axis < 3; ++axis)
+        {
+          brickExt[2 * axis] = outExt[2 * axis] + brickPosition[axis] * brickSize;
+          brickExt[2 * axis + 1] = std::min(brickExt[2 * axis] + brickSize - 1, outExt[2 * axis + 1]);
+        }
+        this->FillHolesInBrick(inVolData, inVolPtr, accData, accPtr, outData, outPtr, brickExt, threadIndex);
+        int processedBricks = ++numberOfProcessedBricks;
+        if (threadIndex == 0)
+        {
+          // progress observers are only invoked from the calling thread (same as in vtkThreadedImageAlgorithm)
+          this->UpdateProgress(static_cast<double>(processedBricks) / totalNumberOfBricks);
+        }
+      }
+    }
+  };
+
+  std::vector<std::thread> workers;
+  for (int threadIndex = 1; threadIndex < numberOfThreads; ++threadIndex)
+  {
+    workers.push_back(std::thread(processBricks, threadIndex));
+  }
+  // the calling thread processes bricks, too
+  processBricks(0);
+  for (std::vector<std::thread>::iterator workerIt = workers.begin(); workerIt != workers.end(); ++workerIt)
+  {
+    workerIt->join();
+  }
+}
+
+//----------------------------------------------------------------------------
+template <class T>
+void vtkPlusFillHolesInVolume::FillHolesInBrick(vtkImageData *inVolData,
+                             T *inVolPtr, 
+                             vtkImageData *accData,
+                             unsigned short *accPtr, 
+                             vtkImageData *outData, 
+                             T *outPtr,
+                             int brickExt[6],
+                             int threadIndex)
+{
+  vtkIdType incVol[3]={0}; //x,y,z
+  outData->GetIncrements(incVol[0],incVol[1],incVol[2]);
+  vtkIdType incAcc[3]={0}; //x,y,z
+  accData->GetIncrements(incAcc[0],incAcc[1],incAcc[2]);
+
+  // check if there is any hole in the brick
+  bool holeFound = false;
+  for (int z = brickExt[4]; z <= brickExt[5] && !holeFound; z++)
+  {
+    for (int y = brickExt[2]; y <= brickExt[3] && !holeFound; y++)
+    {
+      const unsigned short* accRowPtr = accPtr + (brickExt[0]*incAcc[0]+y*incAcc[1]+z*incAcc[2]);
+      for (int x = brickExt[0]; x <= brickExt[1]; x++, accRowPtr += incAcc[0])
+      {
+        if (*accRowPtr == 0)
+        {
+          holeFound = true;
+          break;
+        }
+      }
+    }
+  }
+
+  if (holeFound)
+  {
+    this->vtkPlusFillHolesInVolumeExecute(inVolData, inVolPtr, accData, accPtr, outData, outPtr, brickExt, threadIndex);
+    return;
+  }
+
+  // no holes, just copy the input
+  size_t rowSizeBytes = (brickExt[1] - brickExt[0] + 1) * incVol[0] * sizeof(T);
+  for (int z = brickExt[4]; z <= brickExt[5]; z++)
+  {
+    for (int y = brickExt[2]; y <= brickExt[3]; y++)
+    {
+      vtkIdType volIndex = brickExt[0]*incVol[0]+y*incVol[1]+z*incVol[2];
+      memcpy(outPtr + volIndex, inVolPtr + volIndex, rowSizeBytes);
+    }
+  }
+}
+
 //--------------------------------------------------------------------------------------
 void vtkPlusFillHolesInVolume::SetHFElement(int index, FillHolesInVolumeElement& element) {
   // universal
@@ -1081,6 +1300,9 @@ PlusStatus vtkPlusFillHolesInVolume::ReadConfiguration( vtkXMLDataElement* holeF
     currentElementIndex++;
   }
 
+  XML_READ_BOOL_ATTRIBUTE_OPTIONAL(BlockedExecution, holeFillingConfig);
+  XML_READ_SCALAR_ATTRIBUTE_OPTIONAL(int, BrickSize, holeFillingConfig);
+
   if (numberOfErrors != 0)
   {
     return PLUS_FAIL;
@@ -250,6 +250,26 @@ public:
   /*! Read hole filling parameter form a HoleFilling XML element */
   virtual PlusStatus ReadConfiguration( vtkXMLDataElement* holeFillingConfig); 
 
+  /*!
+    Enable blocked execution (enabled by default).
+    If enabled then the output is divided into bricks of BrickSize x BrickSize x BrickSize voxels.
+    Bricks that contain no holes (no zero value in the accumulation buffer) are just copied from the input,
+    therefore only the bricks that contain holes are processed by the hole filling elements.
+    A brick and its neighborhood (the brick extended by the hole filling element size or stick length)
+    is small enough to stay in the processor cache while the brick is processed.
+    Bricks are distributed between NumberOfThreads threads in contiguous ranges; threads that have finished
+    their range take the remaining bricks of other threads, so threads are kept busy even if the holes are
+    concentrated in a small part of the volume.
+    The output is the same as with non-blocked execution, as each output voxel only depends on the input.
+  */
+  vtkSetMacro(BlockedExecution, bool);
+  vtkGetMacro(BlockedExecution, bool);
+  vtkBooleanMacro(BlockedExecution, bool);
+
+  /*! Size of the bricks (in voxels along each axis) that are used in blocked execution */
+  vtkSetMacro(BrickSize, int);
+  vtkGetMacro(BrickSize, int);
+
 protected:
   vtkPlusFillHolesInVolume();
   ~vtkPlusFillHolesInVolume();
@@ -268,6 +288,11 @@ protected:
                                   vtkInformationVector**,
                                   vtkInformationVector*);
 
+  /*! Fill holes brick by brick if BlockedExecution is enabled, otherwise use the default extent splitting of the superclass */
+  virtual int RequestData(vtkInformation*,
+                          vtkInformationVector**,
+                          vtkInformationVector*) VTK_OVERRIDE;
+
   template <class T>
   void vtkPlusFillHolesInVolumeExecute(vtkImageData *inVolData,
                    T *inVolPtr,
@@ -278,6 +303,27 @@ protected:
                    int outExt[6],
                    int id);
 
+  /*! Fill holes in all the bricks of the output extent using multiple threads (blocked execution) */
+  template <class T>
+  void FillHolesInBricks(vtkImageData *inVolData,
+                   T *inVolPtr,
+                   vtkImageData *accData,
+                   unsigned short *accPtr, 
+                   vtkImageData *outData, 
+                   T *outPtr,
+                   int outExt[6]);
+
+  /*! Fill holes in a single brick. If the brick contains no holes then the input is copied to the output. */
+  template <class T>
+  void FillHolesInBrick(vtkImageData *inVolData,
+                   T *inVolPtr,
+                   vtkImageData *accData,
+                   unsigned short *accPtr, 
+                   vtkImageData *outData, 
+                   T *outPtr,
+                   int brickExt[6],
+                   int threadIndex);
+
   /*!
     This method contains a switch statement that calls the correct
     templated function for the input data type.  The output data
@@ -296,6 +342,9 @@ protected:
   int NumHFElements;
   FillHolesInVolumeElement* HFElements;
 
+  bool BlockedExecution;
+  int BrickSize;
+
 private:
   vtkPlusFillHolesInVolume(const vtkPlusFillHolesInVolume&);  // Not implemented.
   void operator=(const vtkPlusFillHolesInVolume&);  // Not implemented.
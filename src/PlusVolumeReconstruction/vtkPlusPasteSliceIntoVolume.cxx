@@ -51,10 +51,17 @@ POSSIBILITY OF SUCH DAMAGES.
 #include "vtkXMLDataElement.h"
 
 #include "vtkPlusPasteSliceIntoVolume.h"
+#include "vtkPlusSparseVolume.h"
 #include "vtkPlusPasteSliceIntoVolumeHelperCommon.h"
 #include "vtkPlusPasteSliceIntoVolumeHelperUnoptimized.h"
 #include "vtkPlusPasteSliceIntoVolumeHelperOptimized.h"
 
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
 vtkStandardNewMacro( vtkPlusPasteSliceIntoVolume );
 
 struct InsertSliceThreadFunctionInfoStruct
@@ -64,7 +71,9 @@ struct InsertSliceThreadFunctionInfoStruct
   vtkImageData* OutputVolume;
   vtkImageData* Accumulator;
   vtkImageData* ImportanceImage;
+  vtkPlusSparseVolume* SparseVolume; // if not NULL then the output is stored in this sparse volume instead of OutputVolume and Accumulator
   vtkPlusPasteSliceIntoVolume::OptimizationType Optimization;
+  bool EnableSimd;
   vtkPlusPasteSliceIntoVolume::InterpolationType InterpolationMode;
   vtkPlusPasteSliceIntoVolume::CompoundingType CompoundingMode;
   double PixelRejectionThreshold;
@@ -78,6 +87,58 @@ struct InsertSliceThreadFunctionInfoStruct
   std::vector<unsigned int> AccumulationBufferSaturationErrors;
 };
 
+//----------------------------------------------------------------------------
+// Slice in the insertion queue of pipelined insertion
+struct QueuedSliceInfo
+{
+  InsertSliceThreadFunctionInfoStruct InsertionInfo;
+  // Copies of the inputs, as the caller may modify them after InsertSlice returns
+  vtkSmartPointer<vtkImageData> FrameImage;
+  vtkSmartPointer<vtkMatrix4x4> ImageToReference;
+  vtkSmartPointer<vtkImageData> ImportanceImage;
+  // Range of volume bricks that the slice may modify (first and last brick index along each axis)
+  int BrickExtent[6];
+  bool Started;
+  bool Finished;
+  unsigned int AccumulationBufferSaturationErrors;
+};
+
+//----------------------------------------------------------------------------
+class vtkPlusPasteSliceIntoVolume::vtkInternal
+{
+public:
+  vtkInternal()
+    : StopWorkers(false)
+    , VolumeModified(false)
+    , AccumulationBufferSaturationErrors(0)
+  {
+  }
+
+  /*! Add a slice to the queue. Waits if the queue is full. */
+  PlusStatus QueueSlice(vtkPlusPasteSliceIntoVolume* self, const InsertSliceThreadFunctionInfoStruct& str);
+
+  /*! Start the worker threads if they are not running yet with the requested number of threads */
+  void StartWorkers(vtkPlusPasteSliceIntoVolume* self, int numberOfThreads);
+
+  /*! Main loop of the worker threads */
+  void WorkerThreadFunction();
+
+  /*! Get the first queued slice that can be inserted now. QueueMutex must be locked. */
+  QueuedSliceInfo* GetNextSliceToInsert();
+
+  std::mutex QueueMutex;
+  /*! Notified whenever a slice is added to the queue or a slice insertion is completed */
+  std::condition_variable QueueChangedCondition;
+  /*! Queued slices in the order of insertion. Slices are removed when they and all preceding slices are inserted. */
+  std::deque<QueuedSliceInfo*> Queue;
+  std::vector<std::thread> Workers;
+  bool StopWorkers;
+  /*! True if a slice has been inserted since the last WaitForQueuedSlices call */
+  bool VolumeModified;
+  /*! Number of accumulation buffer overflow errors since the last WaitForQueuedSlices call */
+  unsigned int AccumulationBufferSaturationErrors;
+};
+
 //----------------------------------------------------------------------------
 vtkPlusPasteSliceIntoVolume::vtkPlusPasteSliceIntoVolume()
 {
@@ -122,6 +183,7 @@ vtkPlusPasteSliceIntoVolume::vtkPlusPasteSliceIntoVolume()
   this->InterpolationMode = NEAREST_NEIGHBOR_INTERPOLATION;
   this->Optimization = FULL_OPTIMIZATION;
   this->CompoundingMode = UNDEFINED_COMPOUNDING_MODE;
+  this->EnableSimd = true;
 
   this->NumberOfThreads = 0; // 0 means not set, the default number of threads will be used
 
@@ -131,12 +193,24 @@ vtkPlusPasteSliceIntoVolume::vtkPlusPasteSliceIntoVolume()
   this->Compounding = -1;
   this->Calculation = UNDEFINED_CALCULATION;
 
+  this->PipelinedInsertion = false;
+  this->PipelineBrickSize = 32;
+  this->MaximumNumberOfQueuedSlices = 64;
+  this->Internal = new vtkInternal;
+
+  this->SparseOutput = false;
+  this->SparseVolume = vtkPlusSparseVolume::New();
+
   SetPixelRejectionDisabled();
 }
 
 //----------------------------------------------------------------------------
 vtkPlusPasteSliceIntoVolume::~vtkPlusPasteSliceIntoVolume()
 {
+  this->StopPipelineWorkers();
+  delete this->Internal;
+  this->Internal = NULL;
+
   if ( this->ReconstructedVolume )
   {
     this->ReconstructedVolume->Delete();
@@ -153,6 +227,11 @@ vtkPlusPasteSliceIntoVolume::~vtkPlusPasteSliceIntoVolume()
     this->Threader->Delete();
     this->Threader = NULL;
   }
+  if ( this->SparseVolume )
+  {
+    this->SparseVolume->Delete();
+    this->SparseVolume = NULL;
+  }
 }
 
 //----------------------------------------------------------------------------
@@ -195,6 +274,7 @@ void vtkPlusPasteSliceIntoVolume::PrintSelf( ostream& os, vtkIndent indent )
   os << indent << "InterpolationMode: " << this->GetInterpolationModeAsString( this->InterpolationMode ) << "\n";
   os << indent << "CompoundingMode: " << this->GetCompoundingModeAsString( this->CompoundingMode ) << "\n";
   os << indent << "Optimization: " << this->GetOptimizationModeAsString( this->Optimization ) << "\n";
+  os << indent << "EnableSimd: " << ( this->EnableSimd ? "true" : "false" ) << "\n";
   os << indent << "NumberOfThreads: ";
   if ( this->NumberOfThreads > 0 )
   {
@@ -204,18 +284,41 @@ void vtkPlusPasteSliceIntoVolume::PrintSelf( ostream& os, vtkIndent indent )
   {
     os << "default\n";
   }
+  os << indent << "PipelinedInsertion: " << ( this->PipelinedInsertion ? "true" : "false" ) << "\n";
+  os << indent << "PipelineBrickSize: " << this->PipelineBrickSize << "\n";
+  os << indent << "MaximumNumberOfQueuedSlices: " << this->MaximumNumberOfQueuedSlices << "\n";
+  os << indent << "SparseOutput: " << ( this->SparseOutput ? "true" : "false" ) << "\n";
+  if ( this->SparseVolume->IsInitialized() )
+  {
+    os << indent << "SparseVolume:\n";
+    this->SparseVolume->PrintSelf( os, indent.GetNextIndent() );
+  }
 }
 
 
 //----------------------------------------------------------------------------
 vtkImageData* vtkPlusPasteSliceIntoVolume::GetReconstructedVolume()
 {
+  this->WaitForQueuedSlices();
+  if ( this->SparseVolume->IsInitialized() && this->ReconstructedVolume->GetMTime() > this->ReconstructedVolumeUpdateTime )
+  {
+    // convert the sparse volume to dense
+    this->SparseVolume->CopyScalarsToImage( this->ReconstructedVolume );
+    this->ReconstructedVolumeUpdateTime.Modified();
+  }
   return this->ReconstructedVolume;
 }
 
 //----------------------------------------------------------------------------
 vtkImageData* vtkPlusPasteSliceIntoVolume::GetAccumulationBuffer()
 {
+  this->WaitForQueuedSlices();
+  if ( this->SparseVolume->IsInitialized() && this->AccumulationBuffer->GetMTime() > this->AccumulationBufferUpdateTime )
+  {
+    // convert the sparse accumulation buffer to dense
+    this->SparseVolume->CopyAccumulationBufferToImage( this->AccumulationBuffer );
+    this->AccumulationBufferUpdateTime.Modified();
+  }
   return this->AccumulationBuffer;
 }
 
@@ -223,6 +326,24 @@ vtkImageData* vtkPlusPasteSliceIntoVolume::GetAccumulationBuffer()
 // Clear the output volume and the accumulation buffer
 PlusStatus vtkPlusPasteSliceIntoVolume::ResetOutput()
 {
+  // Queued slices must not be inserted into the new volume
+  this->WaitForQueuedSlices();
+
+  if ( this->SparseOutput )
+  {
+    // Release the dense buffers, they are only allocated if they are requested
+    this->AccumulationBuffer->ReleaseData();
+    this->AccumulationBuffer->SetExtent( this->OutputExtent );
+    this->AccumulationBuffer->SetOrigin( this->OutputOrigin );
+    this->AccumulationBuffer->SetSpacing( this->OutputSpacing );
+    this->ReconstructedVolume->ReleaseData();
+    this->ReconstructedVolume->SetExtent( this->OutputExtent );
+    this->ReconstructedVolume->SetOrigin( this->OutputOrigin );
+    this->ReconstructedVolume->SetSpacing( this->OutputSpacing );
+    return this->SparseVolume->Initialize( this->OutputExtent, this->OutputScalarMode, 1 );
+  }
+  this->SparseVolume->Clear();
+
   // Allocate memory for accumulation buffer and set all pixels to 0
   // Start with this buffer because if no compunding is needed then we release memory before allocating memory for the reconstructed image.
 
@@ -313,9 +434,11 @@ PlusStatus vtkPlusPasteSliceIntoVolume::InsertSlice( vtkImageData* image, vtkMat
   str.OutputVolume = this->ReconstructedVolume;
   str.Accumulator = this->AccumulationBuffer;
   str.ImportanceImage = this->ImportanceMask;
+  str.SparseVolume = ( this->SparseVolume->IsInitialized() ? this->SparseVolume : NULL );
   str.InterpolationMode = this->InterpolationMode;
   str.CompoundingMode = this->CompoundingMode;
   str.Optimization = this->Optimization;
+  str.EnableSimd = this->EnableSimd;
   if ( this->ClipRectangleSize[0] > 0 && this->ClipRectangleSize[1] > 0 )
   {
     // ClipRectangle specified
@@ -341,6 +464,28 @@ PlusStatus vtkPlusPasteSliceIntoVolume::InsertSlice( vtkImageData* image, vtkMat
 
   str.PixelRejectionThreshold = this->PixelRejectionThreshold;
 
+  if ( this->PipelinedInsertion )
+  {
+    int outputScalarType = ( str.SparseVolume ? str.SparseVolume->GetScalarType() : this->ReconstructedVolume->GetScalarType() );
+    if ( image->GetScalarType() != outputScalarType )
+    {
+      LOG_ERROR( "InsertSlice: input ScalarType (" << image->GetScalarType() << ") "
+                 << " must match out ScalarType (" << outputScalarType << ")" );
+      return PLUS_FAIL;
+    }
+    if ( this->CompoundingMode == IMPORTANCE_MASK_COMPOUNDING_MODE && this->ImportanceMask == NULL )
+    {
+      LOG_ERROR( "InsertSlice: IMPORTANCE_MASK_COMPOUNDING_MODE was selected but importance mask has not been defined" );
+      return PLUS_FAIL;
+    }
+    PlusStatus status = this->Internal->QueueSlice( this, str );
+    this->Modified();
+    return status;
+  }
+
+  // Slices that were queued while pipelined insertion was enabled must be inserted first
+  this->WaitForQueuedSlices();
+
   if ( this->NumberOfThreads > 0 )
   {
     this->Threader->SetNumberOfThreads( this->NumberOfThreads );
@@ -377,35 +522,47 @@ PlusStatus vtkPlusPasteSliceIntoVolume::InsertSlice( vtkImageData* image, vtkMat
 }
 
 //----------------------------------------------------------------------------
-VTK_THREAD_RETURN_TYPE vtkPlusPasteSliceIntoVolume::InsertSliceThreadFunction( void* arg )
+// Compute the transform from input frame pixel coordinates to output volume voxel coordinates
+static void GetImagePixToVolumePixMatrix( InsertSliceThreadFunctionInfoStruct* str, vtkMatrix4x4* mImagePixToVolumePix )
 {
-  vtkMultiThreader::ThreadInfo* threadInfo = static_cast<vtkMultiThreader::ThreadInfo*>( arg );
-  InsertSliceThreadFunctionInfoStruct* str = static_cast<InsertSliceThreadFunctionInfoStruct*>( threadInfo->UserData );
+  // Transform chain:
+  // ImagePixToVolumePix =
+  //  = VolumePixFromImagePix
+  //  = VolumePixFromRef * RefFromImage * ImageFromImagePix
 
-  // Compute what extent of the input image will be processed by this thread
-  int threadId = threadInfo->ThreadID;
-  int threadCount = threadInfo->NumberOfThreads;
+  vtkSmartPointer<vtkTransform> tVolumePixFromRef = vtkSmartPointer<vtkTransform>::New();
+  tVolumePixFromRef->Translate( str->OutputVolume->GetOrigin() );
+  tVolumePixFromRef->Scale( str->OutputVolume->GetSpacing() );
+  tVolumePixFromRef->Inverse();
+
+  vtkSmartPointer<vtkTransform> tRefFromImage = vtkSmartPointer<vtkTransform>::New();
+  tRefFromImage->SetMatrix( str->TransformImageToReference );
+
+  vtkSmartPointer<vtkTransform> tImageFromImagePix = vtkSmartPointer<vtkTransform>::New();
+  tImageFromImagePix->Scale( str->InputFrameImage->GetSpacing() );
+
+  vtkSmartPointer<vtkTransform> tImagePixToVolumePix = vtkSmartPointer<vtkTransform>::New();
+  tImagePixToVolumePix->Concatenate( tVolumePixFromRef );
+  tImagePixToVolumePix->Concatenate( tRefFromImage );
+  tImagePixToVolumePix->Concatenate( tImageFromImagePix );
+
+  tImagePixToVolumePix->GetMatrix( mImagePixToVolumePix );
+}
+
+//----------------------------------------------------------------------------
+// Paste the specified extent of the input frame into the volume
+static void InsertSliceIntoVolume( InsertSliceThreadFunctionInfoStruct* str, int inputFrameExtentForCurrentThread[6], unsigned int* accumulationBufferSaturationErrors )
+{
   int inputFrameExtent[6];
   str->InputFrameImage->GetExtent( inputFrameExtent );
   unsigned char *importancePtr = NULL;
-  int inputFrameExtentForCurrentThread[6] = { 0, -1, 0, -1, 0, -1 };
-
-  int totalUsedThreads = vtkPlusPasteSliceIntoVolume::SplitSliceExtent(inputFrameExtentForCurrentThread, inputFrameExtent, threadId, threadCount);
-
-  if (threadId >= totalUsedThreads)
-  {
-    // don't use this thread. Sometimes the threads dont
-    // break up very well and it is just as efficient to leave a
-    // few threads idle.
-    return VTK_THREAD_RETURN_VALUE;
-  }
 
-  if (str->CompoundingMode == IMPORTANCE_MASK_COMPOUNDING_MODE)
+  if (str->CompoundingMode == vtkPlusPasteSliceIntoVolume::IMPORTANCE_MASK_COMPOUNDING_MODE)
   {
     if (!str->ImportanceImage)
     {
       LOG_ERROR( "OptimizedInsertSlice: IMPORTANCE_MASK_COMPOUNDING_MODE was selected but importance mask has not been defined" );
-      return VTK_THREAD_RETURN_VALUE;
+      return;
     }
     int importanceMaskExtent[6];
     str->ImportanceImage->GetExtent( importanceMaskExtent );
@@ -419,29 +576,30 @@ VTK_THREAD_RETURN_TYPE vtkPlusPasteSliceIntoVolume::InsertSliceThreadFunction( v
         " does not match importance mask extent ["
         << importanceMaskExtent[0] << ", " << importanceMaskExtent[1] << ", " << importanceMaskExtent[2]<<", "
         << importanceMaskExtent[3] << ", " << importanceMaskExtent[4] << ", " << importanceMaskExtent[5]<<"]");
-        return VTK_THREAD_RETURN_VALUE;
+        return;
       }
     }
     if (str->ImportanceImage->GetNumberOfScalarComponents() != 1)
     {
       LOG_ERROR("OptimizedInsertSlice: number of scalar components in importance mask is invalid (1 expected, actual value is "
         << str->ImportanceImage->GetNumberOfScalarComponents() << ")");
-      return VTK_THREAD_RETURN_VALUE;
+      return;
     }
     if (str->ImportanceImage->GetScalarType() != VTK_UNSIGNED_CHAR)
     {
       LOG_ERROR( "OptimizedInsertSlice: importance mask extent must have unsigned char scalar type");
-      return VTK_THREAD_RETURN_VALUE;
+      return;
     }
     importancePtr = static_cast<unsigned char*>(str->ImportanceImage->GetScalarPointerForExtent(inputFrameExtentForCurrentThread));
   }
 
   // this filter expects that input is the same type as output.
-  if ( str->InputFrameImage->GetScalarType() != str->OutputVolume->GetScalarType() )
+  int outputScalarType = ( str->SparseVolume ? str->SparseVolume->GetScalarType() : str->OutputVolume->GetScalarType() );
+  if ( str->InputFrameImage->GetScalarType() != outputScalarType )
   {
     LOG_ERROR( "OptimizedInsertSlice: input ScalarType (" << str->InputFrameImage->GetScalarType() << ") "
-               << " must match out ScalarType (" << str->OutputVolume->GetScalarType() << ")" );
-    return VTK_THREAD_RETURN_VALUE;
+               << " must match out ScalarType (" << outputScalarType << ")" );
+    return;
   }
 
   // Get input frame extent and pointer
@@ -451,47 +609,28 @@ VTK_THREAD_RETURN_TYPE vtkPlusPasteSliceIntoVolume::InsertSliceThreadFunction( v
   // Get output volume extent and pointer
   vtkImageData* outData = str->OutputVolume;
   int* outExt = outData->GetExtent();
-  void* outPtr = outData->GetScalarPointerForExtent( outExt );
-
-  if (str->Accumulator->GetScalarType() != VTK_UNSIGNED_SHORT || str->Accumulator->GetNumberOfScalarComponents() != 1)
+  void* outPtr = NULL;
+  unsigned short* accPtr = NULL;
+  if ( str->SparseVolume == NULL )
   {
-    LOG_ERROR( "OptimizedInsertSlice: accumulator must have unsigned short scalar type and 1 component");
-    return VTK_THREAD_RETURN_VALUE;
+    outPtr = outData->GetScalarPointerForExtent( outExt );
+    if (str->Accumulator->GetScalarType() != VTK_UNSIGNED_SHORT || str->Accumulator->GetNumberOfScalarComponents() != 1)
+    {
+      LOG_ERROR( "OptimizedInsertSlice: accumulator must have unsigned short scalar type and 1 component");
+      return;
+    }
+    accPtr = static_cast<unsigned short*>(str->Accumulator->GetScalarPointerForExtent(outExt));
   }
-  unsigned short* accPtr = static_cast<unsigned short*>(str->Accumulator->GetScalarPointerForExtent(outExt));
-
-  // count the number of accumulation buffer overflow instances in the memory address here:
-  unsigned int* accumulationBufferSaturationErrorsThread = &( str->AccumulationBufferSaturationErrors[threadId] );
-
-  // Transform chain:
-  // ImagePixToVolumePix =
-  //  = VolumePixFromImagePix
-  //  = VolumePixFromRef * RefFromImage * ImageFromImagePix
-
-  vtkSmartPointer<vtkTransform> tVolumePixFromRef = vtkSmartPointer<vtkTransform>::New();
-  tVolumePixFromRef->Translate( str->OutputVolume->GetOrigin() );
-  tVolumePixFromRef->Scale( str->OutputVolume->GetSpacing() );
-  tVolumePixFromRef->Inverse();
-
-  vtkSmartPointer<vtkTransform> tRefFromImage = vtkSmartPointer<vtkTransform>::New();
-  tRefFromImage->SetMatrix( str->TransformImageToReference );
-
-  vtkSmartPointer<vtkTransform> tImageFromImagePix = vtkSmartPointer<vtkTransform>::New();
-  tImageFromImagePix->Scale( str->InputFrameImage->GetSpacing() );
-
-  vtkSmartPointer<vtkTransform> tImagePixToVolumePix = vtkSmartPointer<vtkTransform>::New();
-  tImagePixToVolumePix->Concatenate( tVolumePixFromRef );
-  tImagePixToVolumePix->Concatenate( tRefFromImage );
-  tImagePixToVolumePix->Concatenate( tImageFromImagePix );
 
   vtkSmartPointer<vtkMatrix4x4> mImagePixToVolumePix = vtkSmartPointer<vtkMatrix4x4>::New();
-  tImagePixToVolumePix->GetMatrix( mImagePixToVolumePix );
+  GetImagePixToVolumePixMatrix( str, mImagePixToVolumePix );
 
 
   // set up all the info for passing into the appropriate insertSlice function
   vtkPlusPasteSliceIntoVolumeInsertSliceParams insertionParams;
-  insertionParams.accOverflowCount = accumulationBufferSaturationErrorsThread;
+  insertionParams.accOverflowCount = accumulationBufferSaturationErrors;
   insertionParams.accPtr = accPtr;
+  insertionParams.sparseVolume = str->SparseVolume;
   insertionParams.importanceMask = str->ImportanceImage;
   insertionParams.importancePtr = importancePtr;
   insertionParams.compoundingMode = str->CompoundingMode;
@@ -508,9 +647,10 @@ VTK_THREAD_RETURN_TYPE vtkPlusPasteSliceIntoVolume::InsertSliceThreadFunction( v
   insertionParams.outData = outData;
   insertionParams.outPtr = outPtr;
   insertionParams.pixelRejectionThreshold = str->PixelRejectionThreshold;
+  insertionParams.useAvx2 = str->EnableSimd && PlusCommon::IsAvx2Supported();
   // the matrix will be set once we know more about the optimization level
 
-  if ( str->Optimization == FULL_OPTIMIZATION )
+  if ( str->Optimization == vtkPlusPasteSliceIntoVolume::FULL_OPTIMIZATION )
   {
     // use fixed-point math
     // change transform matrix so that instead of taking
@@ -560,7 +700,7 @@ VTK_THREAD_RETURN_TYPE vtkPlusPasteSliceIntoVolume::InsertSliceThreadFunction( v
       break;
     default:
       LOG_ERROR( "OptimizedInsertSlice: Unknown input ScalarType" );
-      return VTK_THREAD_RETURN_VALUE;
+      return;
     }
   }
   else
@@ -583,7 +723,7 @@ VTK_THREAD_RETURN_TYPE vtkPlusPasteSliceIntoVolume::InsertSliceThreadFunction( v
     insertionParams.matrix = newmatrix;
 
 
-    if ( str->Optimization == PARTIAL_OPTIMIZATION )
+    if ( str->Optimization == vtkPlusPasteSliceIntoVolume::PARTIAL_OPTIMIZATION )
     {
       switch ( inData->GetScalarType() )
       {
@@ -661,10 +801,275 @@ VTK_THREAD_RETURN_TYPE vtkPlusPasteSliceIntoVolume::InsertSliceThreadFunction( v
       }
     }
   }
+}
+
+//----------------------------------------------------------------------------
+// Compute the range of volume bricks that the frame may modify. Returns false if the frame does not intersect the volume.
+static bool GetSliceBrickExtent( InsertSliceThreadFunctionInfoStruct* str, int brickSize, int brickExtent[6] )
+{
+  vtkSmartPointer<vtkMatrix4x4> mImagePixToVolumePix = vtkSmartPointer<vtkMatrix4x4>::New();
+  GetImagePixToVolumePixMatrix( str, mImagePixToVolumePix );
+
+  int* inExt = str->InputFrameImage->GetExtent();
+  int* outExt = str->OutputVolume->GetExtent();
+  double minPoint[3] = { VTK_DOUBLE_MAX, VTK_DOUBLE_MAX, VTK_DOUBLE_MAX };
+  double maxPoint[3] = { VTK_DOUBLE_MIN, VTK_DOUBLE_MIN, VTK_DOUBLE_MIN };
+  for ( int corner = 0; corner < 8; corner++ )
+  {
+    double imagePoint[4] = { double( inExt[( corner & 1 )] ), double( inExt[2 + ( ( corner >> 1 ) & 1 )] ), double( inExt[4 + ( ( corner >> 2 ) & 1 )] ), 1.0 };
+    double volumePoint[4] = { 0, 0, 0, 1 };
+    mImagePixToVolumePix->MultiplyPoint( imagePoint, volumePoint );
+    for ( int axis = 0; axis < 3; axis++ )
+    {
+      minPoint[axis] = std::min( minPoint[axis], volumePoint[axis] );
+      maxPoint[axis] = std::max( maxPoint[axis], volumePoint[axis] );
+    }
+  }
+
+  for ( int axis = 0; axis < 3; axis++ )
+  {
+    // interpolation may modify the neighbor voxels as well, so add one voxel margin
+    double firstVoxel = std::max( floor( minPoint[axis] ) - 1.0, double( outExt[2 * axis] ) );
+    double lastVoxel = std::min( ceil( maxPoint[axis] ) + 1.0, double( outExt[2 * axis + 1] ) );
+    if ( !( firstVoxel <= lastVoxel ) )
+    {
+      // outside the volume (or invalid transform)
+      return false;
+    }
+    brickExtent[2 * axis] = ( int( firstVoxel ) - outExt[2 * axis] ) / brickSize;
+    brickExtent[2 * axis + 1] = ( int( lastVoxel ) - outExt[2 * axis] ) / brickSize;
+  }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE vtkPlusPasteSliceIntoVolume::InsertSliceThreadFunction( void* arg )
+{
+  vtkMultiThreader::ThreadInfo* threadInfo = static_cast<vtkMultiThreader::ThreadInfo*>( arg );
+  InsertSliceThreadFunctionInfoStruct* str = static_cast<InsertSliceThreadFunctionInfoStruct*>( threadInfo->UserData );
+
+  // Compute what extent of the input image will be processed by this thread
+  int threadId = threadInfo->ThreadID;
+  int threadCount = threadInfo->NumberOfThreads;
+  int inputFrameExtent[6];
+  str->InputFrameImage->GetExtent( inputFrameExtent );
+  int inputFrameExtentForCurrentThread[6] = { 0, -1, 0, -1, 0, -1 };
+
+  int totalUsedThreads = vtkPlusPasteSliceIntoVolume::SplitSliceExtent(inputFrameExtentForCurrentThread, inputFrameExtent, threadId, threadCount);
+
+  if (threadId >= totalUsedThreads)
+  {
+    // don't use this thread. Sometimes the threads dont
+    // break up very well and it is just as efficient to leave a
+    // few threads idle.
+    return VTK_THREAD_RETURN_VALUE;
+  }
+
+  // count the number of accumulation buffer overflow instances in the memory address here:
+  InsertSliceIntoVolume( str, inputFrameExtentForCurrentThread, &( str->AccumulationBufferSaturationErrors[threadId] ) );
 
   return VTK_THREAD_RETURN_VALUE;
 }
 
+//****************************************************************************
+// PIPELINED INSERTION
+//****************************************************************************
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusPasteSliceIntoVolume::vtkInternal::QueueSlice( vtkPlusPasteSliceIntoVolume* self, const InsertSliceThreadFunctionInfoStruct& str )
+{
+  QueuedSliceInfo* slice = new QueuedSliceInfo;
+  slice->InsertionInfo = str;
+  slice->FrameImage = vtkSmartPointer<vtkImageData>::New();
+  slice->FrameImage->DeepCopy( str.InputFrameImage );
+  slice->ImageToReference = vtkSmartPointer<vtkMatrix4x4>::New();
+  slice->ImageToReference->DeepCopy( str.TransformImageToReference );
+  // the mask is not modified, just make sure it is not deleted while the slice is in the queue
+  slice->ImportanceImage = str.ImportanceImage;
+  slice->InsertionInfo.InputFrameImage = slice->FrameImage;
+  slice->InsertionInfo.TransformImageToReference = slice->ImageToReference;
+  slice->Started = false;
+  slice->Finished = false;
+  slice->AccumulationBufferSaturationErrors = 0;
+
+  int brickSize = std::max( self->PipelineBrickSize, 1 );
+  if ( !GetSliceBrickExtent( &slice->InsertionInfo, brickSize, slice->BrickExtent ) )
+  {
+    // the slice does not intersect the volume, nothing to insert
+    delete slice;
+    return PLUS_SUCCESS;
+  }
+
+  int numberOfThreads = ( self->NumberOfThreads > 0 ? self->NumberOfThreads : vtkMultiThreader::GetGlobalDefaultNumberOfThreads() );
+  if ( this->Workers.size() != static_cast<size_t>( numberOfThreads ) )
+  {
+    self->StopPipelineWorkers();
+    this->StartWorkers( self, numberOfThreads );
+  }
+
+  size_t maximumNumberOfQueuedSlices = static_cast<size_t>( std::max( self->MaximumNumberOfQueuedSlices, 1 ) );
+  {
+    std::unique_lock<std::mutex> lock( this->QueueMutex );
+    while ( this->Queue.size() >= maximumNumberOfQueuedSlices )
+    {
+      this->QueueChangedCondition.wait( lock );
+    }
+    this->Queue.push_back( slice );
+  }
+  this->QueueChangedCondition.notify_all();
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusPasteSliceIntoVolume::vtkInternal::StartWorkers( vtkPlusPasteSliceIntoVolume* self, int numberOfThreads )
+{
+  this->StopWorkers = false;
+  for ( int i = 0; i < numberOfThreads; i++ )
+  {
+    this->Workers.push_back( std::thread( &vtkPlusPasteSliceIntoVolume::vtkInternal::WorkerThreadFunction, this ) );
+  }
+  LOG_DEBUG( "Started " << numberOfThreads << " volume reconstruction worker threads" );
+}
+
+//----------------------------------------------------------------------------
+QueuedSliceInfo* vtkPlusPasteSliceIntoVolume::vtkInternal::GetNextSliceToInsert()
+{
+  for ( std::deque<QueuedSliceInfo*>::iterator sliceIt = this->Queue.begin(); sliceIt != this->Queue.end(); ++sliceIt )
+  {
+    QueuedSliceInfo* slice = *sliceIt;
+    if ( slice->Started )
+    {
+      continue;
+    }
+    // The slice can be inserted if none of the preceding unfinished slices modify the same bricks
+    bool blocked = false;
+    for ( std::deque<QueuedSliceInfo*>::iterator precedingIt = this->Queue.begin(); precedingIt != sliceIt && !blocked; ++precedingIt )
+    {
+      QueuedSliceInfo* preceding = *precedingIt;
+      if ( preceding->Finished )
+      {
+        continue;
+      }
+      blocked = true;
+      for ( int axis = 0; axis < 3; axis++ )
+      {
+        if ( preceding->BrickExtent[2 * axis + 1] < slice->BrickExtent[2 * axis] || slice->BrickExtent[2 * axis + 1] < preceding->BrickExtent[2 * axis] )
+        {
+          // disjoint along this axis
+          blocked = false;
+          break;
+        }
+      }
+    }
+    if ( !blocked )
+    {
+      return slice;
+    }
+  }
+  return NULL;
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusPasteSliceIntoVolume::vtkInternal::WorkerThreadFunction()
+{
+  std::unique_lock<std::mutex> lock( this->QueueMutex );
+  while ( true )
+  {
+    QueuedSliceInfo* slice = this->GetNextSliceToInsert();
+    if ( slice == NULL )
+    {
+      if ( this->StopWorkers )
+      {
+        return;
+      }
+      this->QueueChangedCondition.wait( lock );
+      continue;
+    }
+
+    slice->Started = true;
+    lock.unlock();
+    int inputFrameExtent[6];
+    slice->FrameImage->GetExtent( inputFrameExtent );
+    InsertSliceIntoVolume( &slice->InsertionInfo, inputFrameExtent, &slice->AccumulationBufferSaturationErrors );
+    lock.lock();
+
+    slice->Finished = true;
+    this->VolumeModified = true;
+    while ( !this->Queue.empty() && this->Queue.front()->Finished )
+    {
+      this->AccumulationBufferSaturationErrors += this->Queue.front()->AccumulationBufferSaturationErrors;
+      delete this->Queue.front();
+      this->Queue.pop_front();
+    }
+    this->QueueChangedCondition.notify_all();
+  }
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusPasteSliceIntoVolume::WaitForQueuedSlices()
+{
+  if ( this->Internal->Workers.empty() )
+  {
+    // pipelined insertion has not been used
+    return PLUS_SUCCESS;
+  }
+
+  bool volumeModified = false;
+  unsigned int sumAccOverflowErrors = 0;
+  {
+    std::unique_lock<std::mutex> lock( this->Internal->QueueMutex );
+    while ( !this->Internal->Queue.empty() )
+    {
+      this->Internal->QueueChangedCondition.wait( lock );
+    }
+    volumeModified = this->Internal->VolumeModified;
+    sumAccOverflowErrors = this->Internal->AccumulationBufferSaturationErrors;
+    this->Internal->VolumeModified = false;
+    this->Internal->AccumulationBufferSaturationErrors = 0;
+  }
+
+  if ( sumAccOverflowErrors && !EnableAccumulationBufferOverflowWarning )
+  {
+    LOG_WARNING( sumAccOverflowErrors << " voxels have had too many pixels inserted. This can result in errors in the final volume. It is recommended that the output volume resolution be increased." );
+  }
+
+  if ( volumeModified )
+  {
+    this->ReconstructedVolume->Modified();
+    this->AccumulationBuffer->Modified();
+  }
+
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int vtkPlusPasteSliceIntoVolume::GetNumberOfQueuedSlices()
+{
+  std::unique_lock<std::mutex> lock( this->Internal->QueueMutex );
+  return static_cast<int>( this->Internal->Queue.size() );
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusPasteSliceIntoVolume::StopPipelineWorkers()
+{
+  if ( this->Internal->Workers.empty() )
+  {
+    return;
+  }
+  this->WaitForQueuedSlices();
+  {
+    std::unique_lock<std::mutex> lock( this->Internal->QueueMutex );
+    this->Internal->StopWorkers = true;
+  }
+  this->Internal->QueueChangedCondition.notify_all();
+  for ( std::vector<std::thread>::iterator workerIt = this->Internal->Workers.begin(); workerIt != this->Internal->Workers.end(); ++workerIt )
+  {
+    workerIt->join();
+  }
+  this->Internal->Workers.clear();
+  this->Internal->StopWorkers = false;
+}
+
 //----------------------------------------------------------------------------
 // For streaming and threads.  Splits output update extent into num pieces.
 // This method needs to be called num times.  Results must not overlap for
@@ -50,6 +50,7 @@ class vtkImageData;
 class vtkMatrix4x4;
 class vtkXMLDataElement;
 class vtkMultiThreader;
+class vtkPlusSparseVolume;
 
 /*!
   \class vtkPlusPasteSliceIntoVolume
@@ -149,14 +150,25 @@ public:
     Insert the slice into the reconstructed volume
     The origin of the image is at the first pixel stored in the memory.
     The extent, origin, and spacing of the output must be defined before calling this method.
+    If PipelinedInsertion is enabled then the slice is only added to the insertion queue.
   */
   virtual PlusStatus InsertSlice(vtkImageData *image, vtkMatrix4x4* mImageToReference);
 
+  /*!
+    Wait until all the slices in the insertion queue are pasted into the volume.
+    Returns immediately if no slices are queued.
+  */
+  virtual PlusStatus WaitForQueuedSlices();
+
+  /*! Get the number of slices that are in the insertion queue (waiting for insertion or being inserted) */
+  int GetNumberOfQueuedSlices();
+
   /*!
     Get the output reconstructed 3D ultrasound volume
     (the output is the reconstruction volume, the second component
     is the alpha component that stores whether or not a voxel has
-    been touched by the reconstruction)
+    been touched by the reconstruction).
+    Waits for the insertion of all queued slices.
   */
   virtual vtkImageData *GetReconstructedVolume();
 
@@ -164,12 +176,27 @@ public:
     Get the accumulation buffer
     Accumulation buffer is for compounding, there is a voxel in
     the accumulation buffer for each voxel in the output.
+    Waits for the insertion of all queued slices.
   */
   virtual vtkImageData *GetAccumulationBuffer();
 
   /*! Creates the and clears all necessary image buffers */
   virtual PlusStatus ResetOutput();
 
+  /*!
+    Store the reconstructed volume and the accumulation buffer in a sparse volume, which only allocates memory
+    for bricks of the volume that are touched by the inserted slices.
+    The dense reconstructed volume and accumulation buffer are only allocated and filled when they are requested
+    (by GetReconstructedVolume and GetAccumulationBuffer).
+    Takes effect at the next ResetOutput call.
+  */
+  vtkSetMacro(SparseOutput, bool);
+  vtkGetMacro(SparseOutput, bool);
+  vtkBooleanMacro(SparseOutput, bool);
+
+  /*! Get the sparse volume that stores the output if SparseOutput is enabled */
+  vtkGetObjectMacro(SparseVolume, vtkPlusSparseVolume);
+
   /*!
     Set the clip rectangle origin to apply to the image in pixel coordinates.
     Pixels outside the clip rectangle will not be pasted into the volume.
@@ -264,6 +291,17 @@ public:
   /*! Get the name of an optimization method from a type id */
   const char* GetOptimizationModeAsString(OptimizationType type);
 
+  /*!
+    Enable vectorized (AVX2) slice insertion if supported by the processor (enabled by default).
+    Used with LINEAR interpolation and PARTIAL_OPTIMIZATION: trilinear weights and voxel indices are computed
+    for 4 pixels at once, and with MEAN compounding of single-component unsigned char volumes
+    the 8 voxels around a pixel are updated at once.
+    The reconstructed volume and accumulation buffer are identical to the ones computed without AVX2 instructions.
+  */
+  vtkSetMacro(EnableSimd, bool);
+  vtkGetMacro(EnableSimd, bool);
+  vtkBooleanMacro(EnableSimd, bool);
+
   /*!
     Set the interpolation mode
     LINEAR:           Each pixel is distributed into the surrounding eight voxels using trilinear interpolation weights.
@@ -306,6 +344,29 @@ public:
   /*! Get number of threads used for processing the data */
   vtkGetMacro(NumberOfThreads,int);
 
+  /*!
+    Enable pipelined insertion of slices.
+    If disabled (default) then InsertSlice pastes the slice into the volume before returning, and the slice
+    is split between NumberOfThreads threads.
+    If enabled then InsertSlice copies the slice into a queue and returns immediately. A persistent pool of
+    NumberOfThreads worker threads pastes the queued slices, each worker pastes a whole slice. The volume
+    is divided into bricks (see PipelineBrickSize): slices that touch disjoint sets of bricks are pasted
+    concurrently, while slices that touch a common brick are pasted in the order of insertion.
+    Therefore the result is the same as single-threaded insertion (NumberOfThreads=1), for all compounding modes.
+    This mode is most efficient for small frames, which cannot be split efficiently between many threads.
+  */
+  vtkSetMacro(PipelinedInsertion, bool);
+  vtkGetMacro(PipelinedInsertion, bool);
+  vtkBooleanMacro(PipelinedInsertion, bool);
+
+  /*! Size of volume bricks (in voxels along each axis) that are used for determining which queued slices may be pasted concurrently */
+  vtkSetMacro(PipelineBrickSize, int);
+  vtkGetMacro(PipelineBrickSize, int);
+
+  /*! Maximum number of slices in the insertion queue. If the queue is full then InsertSlice waits until a slice is pasted. */
+  vtkSetMacro(MaximumNumberOfQueuedSlices, int);
+  vtkGetMacro(MaximumNumberOfQueuedSlices, int);
+
   /*! DEPRECATED - use CompoundingMode instead! */
   vtkSetMacro(Compounding,int);
   /*! DEPRECATED - use CompoundingMode instead! */
@@ -342,6 +403,9 @@ protected:
   */
   static int SplitSliceExtent(int splitExt[6], int fullExt[6], int threadId, int requestedNumberOfThreads);
 
+  /*! Stop the worker threads of pipelined insertion. All queued slices are inserted before the threads are stopped. */
+  void StopPipelineWorkers();
+
   vtkImageData *ReconstructedVolume;
   vtkImageData *AccumulationBuffer;
   vtkImageData *ImportanceMask;
@@ -363,6 +427,7 @@ protected:
   InterpolationType InterpolationMode;
   OptimizationType Optimization;
   CompoundingType CompoundingMode;
+  bool EnableSimd;
   int OutputScalarMode;
   // deprecated
   int Compounding;
@@ -371,6 +436,22 @@ protected:
   // Multithreading
   vtkMultiThreader *Threader;
   int NumberOfThreads;
+
+  // Pipelined insertion
+  bool PipelinedInsertion;
+  int PipelineBrickSize;
+  int MaximumNumberOfQueuedSlices;
+  /*! Insertion queue and worker threads */
+  class vtkInternal;
+  vtkInternal* Internal;
+
+  // Sparse output
+  bool SparseOutput;
+  vtkPlusSparseVolume* SparseVolume;
+  /*! Time when the dense reconstructed volume was last updated from the sparse volume */
+  vtkTimeStamp ReconstructedVolumeUpdateTime;
+  /*! Time when the dense accumulation buffer was last updated from the sparse volume */
+  vtkTimeStamp AccumulationBufferUpdateTime;
   
   double PixelRejectionThreshold;
   
@@ -90,6 +90,7 @@ afterward. This resulted in unwanted and clearly-wrong artifacts.
 
 #include "PlusMath.h"
 #include "fixed.h"
+#include "vtkPlusSparseVolume.h"
 #include "float.h" // for DBL_MAX
 #include <typeinfo>
 
@@ -120,6 +121,7 @@ struct vtkPlusPasteSliceIntoVolumeInsertSliceParams
   vtkImageData* outData;            // the output volume
   void* outPtr;                     // scalar pointer to the output volume over the output extent
   unsigned short* accPtr;           // scalar pointer to the accumulation buffer over the output extent
+  vtkPlusSparseVolume* sparseVolume; // if not NULL then the output volume and accumulation buffer are stored in this sparse volume (outPtr and accPtr are not used)
   vtkImageData* importanceMask;
   unsigned char* importancePtr;     // scalar pointer to the importance mask over the output extent
   vtkImageData* inData;             // input slice
@@ -144,9 +146,185 @@ struct vtkPlusPasteSliceIntoVolumeInsertSliceParams
   double fanRadiusStop; // in the input image physical coordinate system
 
   double pixelRejectionThreshold;
+
+  bool useAvx2; // use vectorized implementation if available (the processor supports AVX2 instructions)
 };
 
 
+/*!
+  Get the address of an output volume voxel and its accumulation buffer value.
+  Voxel indices are relative to the first voxel of the output extent.
+  If sparseVolume is not NULL then the voxel is stored in the sparse volume, otherwise in
+  the dense output volume (outPtr) and accumulation buffer (accPtr).
+*/
+template <class T>
+static inline void GetOutputVoxelPointers(int outIdX, int outIdY, int outIdZ, T* outPtr, unsigned short* accPtr, vtkIdType outInc[3],
+                                          vtkPlusSparseVolume* sparseVolume, T*& outVoxelPtr, unsigned short*& accVoxelPtr)
+{
+  if (sparseVolume != NULL)
+  {
+    sparseVolume->GetVoxelPointers(outIdX, outIdY, outIdZ, outVoxelPtr, accVoxelPtr);
+    return;
+  }
+  vtkIdType inc = outIdX * outInc[0] + outIdY * outInc[1] + outIdZ * outInc[2];
+  outVoxelPtr = outPtr + inc;
+  // divide by outInc[0] to accomodate for the difference
+  // in the number of scalar pointers between the output
+  // and the accumulation buffer
+  accVoxelPtr = accPtr + (inc / outInc[0]);
+}
+
+/*!
+  Distributes an input pixel into the eight output voxels that surround a point (reverse trilinear interpolation)
+  and updates the accumulation buffer.
+  Voxel indices are relative to the first voxel of the output extent, fdx contains the weight of each voxel:
+  bit 2, 1, 0 of the voxel index in fdx selects the X, Y, Z neighbor (outId*1 instead of outId*0).
+  Voxels with zero weight are not modified.
+*/
+template <class F, class T>
+static inline void vtkTrilinearSplat(F* fdx,
+                                     int outIdX0, int outIdY0, int outIdZ0,
+                                     int outIdX1, int outIdY1, int outIdZ1,
+                                     T* inPtr,
+                                     T* outPtr,
+                                     unsigned short* accPtr,
+                                     vtkPlusSparseVolume* sparseVolume,
+                                     unsigned char* importancePtr,
+                                     int numscalars,
+                                     vtkPlusPasteSliceIntoVolume::CompoundingType compoundingMode,
+                                     vtkIdType outInc[3],
+                                     unsigned int* accOverflowCount)
+{
+  // Determine if the output is a floating point or integer type. If floating point type then we don't round
+  // the interpolated value.
+  bool roundOutput = true; // assume integer output by default
+  T floatValueInOutputType = 0.3;
+  if (floatValueInOutputType > 0)
+  {
+    // output is a floating point number
+    roundOutput = false;
+  }
+
+  F f, r, a;
+  T* inPtrTmp, *outPtrTmp;
+
+  unsigned short* accPtrTmp;
+
+  // loop over the eight voxels
+  int j = 8;
+  do
+  {
+    j--;
+    if (fdx[j] == 0)
+    {
+      continue;
+    }
+    inPtrTmp = inPtr;
+    // bit 2, 1, 0 of the corner index selects the X, Y, Z neighbor
+    GetOutputVoxelPointers((j & 4) ? outIdX1 : outIdX0, (j & 2) ? outIdY1 : outIdY0, (j & 1) ? outIdZ1 : outIdZ0,
+                           outPtr, accPtr, outInc, sparseVolume, outPtrTmp, accPtrTmp);
+    a = *accPtrTmp;
+
+    int i = numscalars;
+    do
+    {
+      i--;
+      switch (compoundingMode)
+      {
+        case vtkPlusPasteSliceIntoVolume::MAXIMUM_COMPOUNDING_MODE:
+        {
+          const F minWeight(0.125); // If a pixel is right in the middle of the eight surrounding voxels
+          // (trilinear weight = 0.125 for each), then it the compounding operator
+          // should be applied for each. Else, it should only be considered
+          // for the other nearest voxels.
+          if (fdx[j] >= minWeight && *inPtrTmp > *outPtrTmp)
+          {
+            *outPtrTmp = (*inPtrTmp);
+            f = fdx[j];
+            a = f * ACCUMULATION_MULTIPLIER;;
+          }
+          break;
+        }
+        case vtkPlusPasteSliceIntoVolume::LATEST_COMPOUNDING_MODE:
+        {
+          const F minWeight(0.125); // If a pixel is right in the middle of the eight surrounding voxels
+          // (trilinear weight = 0.125 for each), then it the compounding operator
+          // should be applied for each. Else, it should only be considered
+          // for the other nearest voxels.
+          if (fdx[j] >= minWeight)
+          {
+            *outPtrTmp = (*inPtrTmp);
+            f = fdx[j];
+            a = f * ACCUMULATION_MULTIPLIER;;
+          }
+          break;
+        }
+        case vtkPlusPasteSliceIntoVolume::MEAN_COMPOUNDING_MODE:
+          f = fdx[j];
+          r = F((*accPtrTmp) / (double)ACCUMULATION_MULTIPLIER); // added division by double, since this always returned 0 otherwise
+          a = f + r;
+          if (roundOutput)
+          {
+            PlusMath::Round((f * (*inPtrTmp) + r * (*outPtrTmp)) / a, *outPtrTmp);
+          }
+          else
+          {
+            *outPtrTmp = (f * (*inPtrTmp) + r * (*outPtrTmp)) / a;
+          }
+          a *= ACCUMULATION_MULTIPLIER; // needs to be done for proper conversion to unsigned short for accumulation buffer
+          break;
+        case vtkPlusPasteSliceIntoVolume::IMPORTANCE_MASK_COMPOUNDING_MODE:
+          f = fdx[j];
+          if (*importancePtr == 0)
+          {
+            break;
+          }
+          a = F((*importancePtr) * f + *accPtrTmp);
+          if (typeid(F) == typeid(fixed))
+          {
+            //multiplying (*accPtrTmp)*(*outPtrTmp) tends to overflow fixed point type, so divide in-between
+            //splitting like this incurs two divisions, but avoids overflow
+            r = (*inPtrTmp) * (*importancePtr) * f / a + ((*accPtrTmp) / a) * (*outPtrTmp);
+          }
+          else // with float just one division is used
+          {
+            r = F((*inPtrTmp) * (*importancePtr) * f + (*outPtrTmp) * (*accPtrTmp)) / a;
+          }
+          if (roundOutput)
+          {
+            PlusMath::Round(r, *outPtrTmp);
+          }
+          else
+          {
+            *outPtrTmp = r;
+          }
+          break;
+        default:
+          LOG_ERROR("Unknown Compounding operator detected, value " << compoundingMode << ". Leaving value as-is.");
+          break;
+      }
+      inPtrTmp++;
+      outPtrTmp++;
+    }
+    while (i); // number of scalars
+
+    F newa = a;
+    if (newa > ACCUMULATION_THRESHOLD && *accPtrTmp <= ACCUMULATION_THRESHOLD)
+    {
+      (*accOverflowCount) += 1;
+    }
+
+    // don't allow accumulation buffer overflow
+    *accPtrTmp = ACCUMULATION_MAXIMUM;
+    if (newa < ACCUMULATION_MAXIMUM)
+    {
+      // round the fixed point to the nearest whole unit, and save the result as an unsigned short into the accumulation buffer
+      PlusMath::Round(newa, *accPtrTmp);
+    }
+  }
+  while (j);
+}
+
 /*!
   Implements trilinear interpolation
 
@@ -166,6 +344,7 @@ static int vtkTrilinearInterpolation(F* point,
                                      T* inPtr,
                                      T* outPtr,
                                      unsigned short* accPtr,
+                                     vtkPlusSparseVolume* sparseVolume,
                                      unsigned char* importancePtr,
                                      int numscalars,
                                      vtkPlusPasteSliceIntoVolume::CompoundingType compoundingMode,
@@ -173,16 +352,6 @@ static int vtkTrilinearInterpolation(F* point,
                                      vtkIdType outInc[3],
                                      unsigned int* accOverflowCount)
 {
-  // Determine if the output is a floating point or integer type. If floating point type then we don't round
-  // the interpolated value.
-  bool roundOutput = true; // assume integer output by default
-  T floatValueInOutputType = 0.3;
-  if (floatValueInOutputType > 0)
-  {
-    // output is a floating point number
-    roundOutput = false;
-  }
-
   F fx, fy, fz;
 
   // convert point[0] into integer component and a fraction
@@ -204,29 +373,6 @@ static int vtkTrilinearInterpolation(F* point,
        outIdZ0 | (outExt[5] - outExt[4] - outIdZ1)) >= 0)
   {
     // do reverse trilinear interpolation
-    vtkIdType factX0 = outIdX0 * outInc[0];
-    vtkIdType factY0 = outIdY0 * outInc[1];
-    vtkIdType factZ0 = outIdZ0 * outInc[2];
-    vtkIdType factX1 = outIdX1 * outInc[0];
-    vtkIdType factY1 = outIdY1 * outInc[1];
-    vtkIdType factZ1 = outIdZ1 * outInc[2];
-
-    vtkIdType factY0Z0 = factY0 + factZ0;
-    vtkIdType factY0Z1 = factY0 + factZ1;
-    vtkIdType factY1Z0 = factY1 + factZ0;
-    vtkIdType factY1Z1 = factY1 + factZ1;
-
-    // increment between the output pointer and the 8 pixels to work on
-    vtkIdType idx[8];
-    idx[0] = factX0 + factY0Z0;
-    idx[1] = factX0 + factY0Z1;
-    idx[2] = factX0 + factY1Z0;
-    idx[3] = factX0 + factY1Z1;
-    idx[4] = factX1 + factY0Z0;
-    idx[5] = factX1 + factY0Z1;
-    idx[6] = factX1 + factY1Z0;
-    idx[7] = factX1 + factY1Z1;
-
     // remainders from the fractional components - difference between the fractional value and the ceiling
     F rx = 1 - fx;
     F ry = 1 - fy;
@@ -247,123 +393,8 @@ static int vtkTrilinearInterpolation(F* point,
     fdx[6] = fx * fyrz;
     fdx[7] = fx * fyfz;
 
-    F f, r, a;
-    T* inPtrTmp, *outPtrTmp;
-
-    unsigned short* accPtrTmp;
-
-    // loop over the eight voxels
-    int j = 8;
-    do
-    {
-      j--;
-      if (fdx[j] == 0)
-      {
-        continue;
-      }
-      inPtrTmp = inPtr;
-      outPtrTmp = outPtr + idx[j];
-      accPtrTmp = accPtr + ((idx[j] / outInc[0]));
-      a = *accPtrTmp;
-
-      int i = numscalars;
-      do
-      {
-        i--;
-        switch (compoundingMode)
-        {
-          case vtkPlusPasteSliceIntoVolume::MAXIMUM_COMPOUNDING_MODE:
-          {
-            const F minWeight(0.125); // If a pixel is right in the middle of the eight surrounding voxels
-            // (trilinear weight = 0.125 for each), then it the compounding operator
-            // should be applied for each. Else, it should only be considered
-            // for the other nearest voxels.
-            if (fdx[j] >= minWeight && *inPtrTmp > *outPtrTmp)
-            {
-              *outPtrTmp = (*inPtrTmp);
-              f = fdx[j];
-              a = f * ACCUMULATION_MULTIPLIER;;
-            }
-            break;
-          }
-          case vtkPlusPasteSliceIntoVolume::LATEST_COMPOUNDING_MODE:
-          {
-            const F minWeight(0.125); // If a pixel is right in the middle of the eight surrounding voxels
-            // (trilinear weight = 0.125 for each), then it the compounding operator
-            // should be applied for each. Else, it should only be considered
-            // for the other nearest voxels.
-            if (fdx[j] >= minWeight)
-            {
-              *outPtrTmp = (*inPtrTmp);
-              f = fdx[j];
-              a = f * ACCUMULATION_MULTIPLIER;;
-            }
-            break;
-          }
-          case vtkPlusPasteSliceIntoVolume::MEAN_COMPOUNDING_MODE:
-            f = fdx[j];
-            r = F((*accPtrTmp) / (double)ACCUMULATION_MULTIPLIER); // added division by double, since this always returned 0 otherwise
-            a = f + r;
-            if (roundOutput)
-            {
-              PlusMath::Round((f * (*inPtrTmp) + r * (*outPtrTmp)) / a, *outPtrTmp);
-            }
-            else
-            {
-              *outPtrTmp = (f * (*inPtrTmp) + r * (*outPtrTmp)) / a;
-            }
-            a *= ACCUMULATION_MULTIPLIER; // needs to be done for proper conversion to unsigned short for accumulation buffer
-            break;
-          case vtkPlusPasteSliceIntoVolume::IMPORTANCE_MASK_COMPOUNDING_MODE:
-            f = fdx[j];
-            if (*importancePtr == 0)
-            {
-              break;
-            }
-            a = F((*importancePtr) * f + *accPtrTmp);
-            if (typeid(F) == typeid(fixed))
-            {
-              //multiplying (*accPtrTmp)*(*outPtrTmp) tends to overflow fixed point type, so divide in-between
-              //splitting like this incurs two divisions, but avoids overflow
-              r = (*inPtrTmp) * (*importancePtr) * f / a + ((*accPtrTmp) / a) * (*outPtrTmp);
-            }
-            else // with float just one division is used
-            {
-              r = F((*inPtrTmp) * (*importancePtr) * f + (*outPtrTmp) * (*accPtrTmp)) / a;
-            }
-            if (roundOutput)
-            {
-              PlusMath::Round(r, *outPtrTmp);
-            }
-            else
-            {
-              *outPtrTmp = r;
-            }
-            break;
-          default:
-            LOG_ERROR("Unknown Compounding operator detected, value " << compoundingMode << ". Leaving value as-is.");
-            break;
-        }
-        inPtrTmp++;
-        outPtrTmp++;
-      }
-      while (i); // number of scalars
-
-      F newa = a;
-      if (newa > ACCUMULATION_THRESHOLD && *accPtrTmp <= ACCUMULATION_THRESHOLD)
-      {
-        (*accOverflowCount) += 1;
-      }
-
-      // don't allow accumulation buffer overflow
-      *accPtrTmp = ACCUMULATION_MAXIMUM;
-      if (newa < ACCUMULATION_MAXIMUM)
-      {
-        // round the fixed point to the nearest whole unit, and save the result as an unsigned short into the accumulation buffer
-        PlusMath::Round(newa, *accPtrTmp);
-      }
-    }
-    while (j);
+    vtkTrilinearSplat(fdx, outIdX0, outIdY0, outIdZ0, outIdX1, outIdY1, outIdZ1,
+                      inPtr, outPtr, accPtr, sparseVolume, importancePtr, numscalars, compoundingMode, outInc, accOverflowCount);
     return 1;
   }
   // if bounds check fails
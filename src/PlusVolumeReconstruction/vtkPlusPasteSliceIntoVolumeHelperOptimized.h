@@ -54,6 +54,7 @@ POSSIBILITY OF SUCH DAMAGES.
 #define __vtkPlusPasteSliceIntoVolumeHelperOptimized_h
 
 #include "vtkPlusPasteSliceIntoVolumeHelperCommon.h"
+#include "vtkPlusPasteSliceIntoVolumeHelperSimd.h"
 #include "fixed.h"
 
 //----------------------------------------------------------------------------
@@ -507,6 +508,7 @@ static inline void vtkFreehand2OptimizedNNHelper(int xIntersectionPixStart,
                                                  int numscalars,
                                                  vtkPlusPasteSliceIntoVolume::CompoundingType compoundingMode, 
                                                  unsigned short *accPtr,
+                                                 vtkPlusSparseVolume *sparseVolume,
                                                  unsigned char *&importancePtr,
                                                  unsigned int *accOverflowCount,
                                                  double pixelRejectionThreshold)
@@ -544,12 +546,9 @@ static inline void vtkFreehand2OptimizedNNHelper(int xIntersectionPixStart,
       int outIdY = PlusMath::Round(outPoint[1]) - outExt[2];
       int outIdZ = PlusMath::Round(outPoint[2]) - outExt[4];
 
-      int inc = outIdX*outInc[0] + outIdY*outInc[1] + outIdZ*outInc[2];
-      T *outPtr1 = outPtr + inc;
-      // divide by outInc[0] to accomodate for the difference
-      // in the number of scalar pointers between the output
-      // and the accumulation buffer
-      unsigned short *accPtr1 = accPtr + (inc/outInc[0]); // removed cast to unsigned short because it might cause loss in larger numbers
+      T *outPtr1 = NULL;
+      unsigned short *accPtr1 = NULL;
+      GetOutputVoxelPointers(outIdX, outIdY, outIdZ, outPtr, accPtr, outInc, sparseVolume, outPtr1, accPtr1);
 
       if (*accPtr1 <= ACCUMULATION_THRESHOLD) { // no overflow, act normally
 
@@ -605,12 +604,9 @@ static inline void vtkFreehand2OptimizedNNHelper(int xIntersectionPixStart,
       int outIdY = PlusMath::Round(outPoint[1]) - outExt[2];
       int outIdZ = PlusMath::Round(outPoint[2]) - outExt[4];
 
-      int inc = outIdX*outInc[0] + outIdY*outInc[1] + outIdZ*outInc[2];
-      T *outPtr1 = outPtr + inc;
-      // divide by outInc[0] to accomodate for the difference
-      // in the number of scalar pointers between the output
-      // and the accumulation buffer
-      unsigned short *accPtr1 = accPtr + (inc/outInc[0]); // removed cast to unsigned short because it might cause loss in larger numbers
+      T *outPtr1 = NULL;
+      unsigned short *accPtr1 = NULL;
+      GetOutputVoxelPointers(outIdX, outIdY, outIdZ, outPtr, accPtr, outInc, sparseVolume, outPtr1, accPtr1);
 
       if (*accPtr1 <= ACCUMULATION_THRESHOLD)
       {
@@ -677,12 +673,9 @@ static inline void vtkFreehand2OptimizedNNHelper(int xIntersectionPixStart,
       int outIdY = PlusMath::Round(outPoint[1]) - outExt[2];
       int outIdZ = PlusMath::Round(outPoint[2]) - outExt[4];
 
-      int inc = outIdX*outInc[0] + outIdY*outInc[1] + outIdZ*outInc[2];
-      T *outPtr1 = outPtr + inc;
-      // divide by outInc[0] to accomodate for the difference
-      // in the number of scalar pointers between the output
-      // and the accumulation buffer
-      unsigned short *accPtr1 = accPtr + (inc/outInc[0]); // removed cast to unsigned short because it might cause loss in larger numbers
+      T *outPtr1 = NULL;
+      unsigned short *accPtr1 = NULL;
+      GetOutputVoxelPointers(outIdX, outIdY, outIdZ, outPtr, accPtr, outInc, sparseVolume, outPtr1, accPtr1);
       int i = numscalars;
       do 
       {
@@ -723,12 +716,9 @@ static inline void vtkFreehand2OptimizedNNHelper(int xIntersectionPixStart,
       int outIdY = PlusMath::Round(outPoint[1]) - outExt[2];
       int outIdZ = PlusMath::Round(outPoint[2]) - outExt[4];
 
-      int inc = outIdX*outInc[0] + outIdY*outInc[1] + outIdZ*outInc[2];
-      T *outPtr1 = outPtr + inc;
-      // divide by outInc[0] to accomodate for the difference
-      // in the number of scalar pointers between the output
-      // and the accumulation buffer
-      unsigned short *accPtr1 = accPtr + (inc/outInc[0]); // removed cast to unsigned short because it might cause loss in larger numbers
+      T *outPtr1 = NULL;
+      unsigned short *accPtr1 = NULL;
+      GetOutputVoxelPointers(outIdX, outIdY, outIdZ, outPtr, accPtr, outInc, sparseVolume, outPtr1, accPtr1);
       int i = numscalars;
       do 
       {
@@ -766,6 +756,7 @@ static inline void vtkFreehand2OptimizedNNHelper(int xIntersectionPixStart,
                                                  int numscalars,
                                                  vtkPlusPasteSliceIntoVolume::CompoundingType compoundingMode,
                                                  unsigned short *accPtr,
+                                                 vtkPlusSparseVolume *sparseVolume,
                                                  unsigned char *&importancePtr,
                                                  unsigned int *accOverflowCount,
                                                  double pixelRejectionThreshold)
@@ -808,12 +799,9 @@ static inline void vtkFreehand2OptimizedNNHelper(int xIntersectionPixStart,
       int outIdY = PlusMath::Round(outPoint[1]);
       int outIdZ = PlusMath::Round(outPoint[2]);
 
-      int inc = outIdX*outInc[0] + outIdY*outInc[1] + outIdZ*outInc[2];
-      T *outPtr1 = outPtr + inc;
-      // divide by outInc[0] to accomodate for the difference
-      // in the number of scalar pointers between the output
-      // and the accumulation buffer
-      unsigned short *accPtr1 = accPtr + (inc/outInc[0]);
+      T *outPtr1 = NULL;
+      unsigned short *accPtr1 = NULL;
+      GetOutputVoxelPointers(outIdX, outIdY, outIdZ, outPtr, accPtr, outInc, sparseVolume, outPtr1, accPtr1);
 
       if (*accPtr1 <= ACCUMULATION_THRESHOLD) { // no overflow, act normally
 
@@ -873,12 +861,9 @@ static inline void vtkFreehand2OptimizedNNHelper(int xIntersectionPixStart,
       int outIdY = PlusMath::Round(outPoint[1]);
       int outIdZ = PlusMath::Round(outPoint[2]);
 
-      int inc = outIdX*outInc[0] + outIdY*outInc[1] + outIdZ*outInc[2];
-      T *outPtr1 = outPtr + inc;
-      // divide by outInc[0] to accomodate for the difference
-      // in the number of scalar pointers between the output
-      // and the accumulation buffer
-      unsigned short *accPtr1 = accPtr + (inc/outInc[0]);
+      T *outPtr1 = NULL;
+      unsigned short *accPtr1 = NULL;
+      GetOutputVoxelPointers(outIdX, outIdY, outIdZ, outPtr, accPtr, outInc, sparseVolume, outPtr1, accPtr1);
 
       if (*accPtr1 <= ACCUMULATION_THRESHOLD) { // no overflow, act normally
 
@@ -947,12 +932,9 @@ static inline void vtkFreehand2OptimizedNNHelper(int xIntersectionPixStart,
       int outIdY = PlusMath::Round(outPoint[1]);
       int outIdZ = PlusMath::Round(outPoint[2]);
 
-      int inc = outIdX*outInc[0] + outIdY*outInc[1] + outIdZ*outInc[2];
-      T *outPtr1 = outPtr + inc;
-      // divide by outInc[0] to accomodate for the difference
-      // in the number of scalar pointers between the output
-      // and the accumulation buffer
-      unsigned short *accPtr1 = accPtr + (inc/outInc[0]);
+      T *outPtr1 = NULL;
+      unsigned short *accPtr1 = NULL;
+      GetOutputVoxelPointers(outIdX, outIdY, outIdZ, outPtr, accPtr, outInc, sparseVolume, outPtr1, accPtr1);
       int i = numscalars;
       do 
       {
@@ -996,12 +978,9 @@ static inline void vtkFreehand2OptimizedNNHelper(int xIntersectionPixStart,
       int outIdY = PlusMath::Round(outPoint[1]);
       int outIdZ = PlusMath::Round(outPoint[2]);
 
-      int inc = outIdX*outInc[0] + outIdY*outInc[1] + outIdZ*outInc[2];
-      T *outPtr1 = outPtr + inc;
-      // divide by outInc[0] to accomodate for the difference
-      // in the number of scalar pointers between the output
-      // and the accumulation buffer
-      unsigned short *accPtr1 = accPtr + (inc/outInc[0]);
+      T *outPtr1 = NULL;
+      unsigned short *accPtr1 = NULL;
+      GetOutputVoxelPointers(outIdX, outIdY, outIdZ, outPtr, accPtr, outInc, sparseVolume, outPtr1, accPtr1);
       int i = numscalars;
       do 
       {
@@ -1025,6 +1004,70 @@ static inline void vtkFreehand2OptimizedNNHelper(int xIntersectionPixStart,
   }
 }
 
+//----------------------------------------------------------------------------
+/*!
+  Paste the pixels of an image row between xIntersectionPixStart and xIntersectionPixEnd (inclusive)
+  into the volume with trilinear interpolation. If useAvx2 is true and a vectorized implementation is available
+  for the numeric type (see vtkPlusPasteSliceIntoVolumeHelperSimd) then the row is pasted using AVX2 instructions.
+*/
+template <class F, class T>
+static inline void vtkOptimizedTrilinearInterpolationRow(int xIntersectionPixStart,
+                                                         int xIntersectionPixEnd,
+                                                         F *outPoint,
+                                                         F *outPoint1,
+                                                         F *xAxis,
+                                                         T *&inPtr,
+                                                         T *outPtr,
+                                                         int *outExt,
+                                                         vtkIdType *outInc,
+                                                         int numscalars,
+                                                         vtkPlusPasteSliceIntoVolume::CompoundingType compoundingMode, 
+                                                         unsigned short *accPtr,
+                                                         vtkPlusSparseVolume *sparseVolume,
+                                                         unsigned char *&importancePtr,
+                                                         unsigned int *accOverflowCount,
+                                                         double pixelRejectionThreshold,
+                                                         bool useAvx2)
+{
+  if (useAvx2 && vtkTrilinearInterpolationRowAvx2(xIntersectionPixStart, xIntersectionPixEnd, outPoint1, xAxis,
+    inPtr, outPtr, outExt, outInc, numscalars, compoundingMode, accPtr, sparseVolume, importancePtr, accOverflowCount, pixelRejectionThreshold))
+  {
+    return;
+  }
+
+  bool pixelRejectionEnabled = PixelRejectionEnabled(pixelRejectionThreshold);
+  double pixelRejectionThresholdSumAllComponents = 0;
+  if (pixelRejectionEnabled)
+  {
+    pixelRejectionThresholdSumAllComponents = pixelRejectionThreshold * numscalars;
+  }
+  for (int idX = xIntersectionPixStart; idX <= xIntersectionPixEnd; idX++)
+  {
+    if (pixelRejectionEnabled)
+    {
+      double inPixelSumAllComponents = 0;
+      for (int i = numscalars-1; i>=0; i--)
+      {
+        inPixelSumAllComponents+=inPtr[i];
+      }
+      if (inPixelSumAllComponents<pixelRejectionThresholdSumAllComponents)
+      {
+        // too dark, skip this pixel
+        inPtr += numscalars; // go to the next x pixel
+        importancePtr++;
+        continue;
+      }
+    }
+
+    outPoint[0] = outPoint1[0] + idX*xAxis[0];
+    outPoint[1] = outPoint1[1] + idX*xAxis[1];
+    outPoint[2] = outPoint1[2] + idX*xAxis[2];
+    vtkTrilinearInterpolation(outPoint, inPtr, outPtr, accPtr, sparseVolume, importancePtr, numscalars, compoundingMode, outExt, outInc, accOverflowCount); // hit is either 1 or 0
+    inPtr += numscalars; // go to the next x pixel
+    importancePtr++;
+  }
+}
+
 //----------------------------------------------------------------------------
 /*! Actually inserts the slice, with optimization */
 template <class F, class T>
@@ -1034,11 +1077,13 @@ static void vtkOptimizedInsertSlice(vtkPlusPasteSliceIntoVolumeInsertSliceParams
   vtkImageData* outData = insertionParams->outData;
   T* outPtr = reinterpret_cast<T*>(insertionParams->outPtr);
   unsigned short* accPtr = insertionParams->accPtr;
+  vtkPlusSparseVolume* sparseVolume = insertionParams->sparseVolume;
   unsigned char* importancePtr = insertionParams->importancePtr;
   vtkImageData* inData = insertionParams->inData;
   T* inPtr = reinterpret_cast<T*>(insertionParams->inPtr);
   int* inExt = insertionParams->inExt;
   unsigned int* accOverflowCount = insertionParams->accOverflowCount;
+  bool useAvx2 = insertionParams->useAvx2;
 
   // transform matrix for image -> volume
   F* matrix = reinterpret_cast<F*>(insertionParams->matrix);
@@ -1147,13 +1192,6 @@ static void vtkOptimizedInsertSlice(vtkPlusPasteSliceIntoVolumeInsertSliceParams
 
   bool fanClippingEnabled = (fanLinePixelRatioLeft != 0 || fanLinePixelRatioRight != 0);
 
-  bool pixelRejectionEnabled = PixelRejectionEnabled(insertionParams->pixelRejectionThreshold);
-  double pixelRejectionThresholdSumAllComponents = 0;
-  if (pixelRejectionEnabled)
-  {
-    pixelRejectionThresholdSumAllComponents = insertionParams->pixelRejectionThreshold * numscalars;
-  }
-
   int xIntersectionPixStart,xIntersectionPixEnd;
 
   // Loop through INPUT pixels - remember this is a 3D cube represented by the input extent
@@ -1297,86 +1335,20 @@ static void vtkOptimizedInsertSlice(vtkPlusPasteSliceIntoVolumeInsertSliceParams
       { 
         if (skipMiddleSegment)
         {
-          for (int idX = xIntersectionPixStart; idX < xSkipMiddleSegmentPixStart; idX++) // for all of the x pixels within the fan before the skipped middle section
-          {
-            if (pixelRejectionEnabled)
-            {
-              double inPixelSumAllComponents = 0;
-              for (int i = numscalars-1; i>=0; i--)
-              {
-                inPixelSumAllComponents+=inPtr[i];
-              }
-              if (inPixelSumAllComponents<pixelRejectionThresholdSumAllComponents)
-              {
-                // too dark, skip this pixel
-                inPtr += numscalars; // go to the next x pixel
-                importancePtr++;
-                continue;
-              }
-            }
-
-            outPoint[0] = outPoint1[0] + idX*xAxis[0];
-            outPoint[1] = outPoint1[1] + idX*xAxis[1];
-            outPoint[2] = outPoint1[2] + idX*xAxis[2];
-            vtkTrilinearInterpolation(outPoint, inPtr, outPtr, accPtr, importancePtr, numscalars, compoundingMode, outExt, outInc, accOverflowCount); // hit is either 1 or 0
-            inPtr += numscalars; // go to the next x pixel
-            importancePtr++;
-          }
+          vtkOptimizedTrilinearInterpolationRow(xIntersectionPixStart, xSkipMiddleSegmentPixStart-1, outPoint, outPoint1, xAxis, 
+            inPtr, outPtr, outExt, outInc,
+            numscalars, compoundingMode, accPtr, sparseVolume, importancePtr, accOverflowCount, insertionParams->pixelRejectionThreshold, useAvx2);
           inPtr += numscalars * (xSkipMiddleSegmentPixEnd-xSkipMiddleSegmentPixStart+1);
           importancePtr += xSkipMiddleSegmentPixEnd - xSkipMiddleSegmentPixStart + 1;
-          for (int idX = xSkipMiddleSegmentPixEnd+1; idX <= xIntersectionPixEnd; idX++) // for all of the x pixels within the fan after the skipped middle section
-          {
-            if (pixelRejectionEnabled)
-            {
-              double inPixelSumAllComponents = 0;
-              for (int i = numscalars-1; i>=0; i--)
-              {
-                inPixelSumAllComponents+=inPtr[i];
-              }
-              if (inPixelSumAllComponents<pixelRejectionThresholdSumAllComponents)
-              {
-                // too dark, skip this pixel
-                inPtr += numscalars; // go to the next x pixel
-                importancePtr++;
-                continue;
-              }
-            }
-
-            outPoint[0] = outPoint1[0] + idX*xAxis[0];
-            outPoint[1] = outPoint1[1] + idX*xAxis[1];
-            outPoint[2] = outPoint1[2] + idX*xAxis[2];
-            vtkTrilinearInterpolation(outPoint, inPtr, outPtr, accPtr, importancePtr, numscalars, compoundingMode, outExt, outInc, accOverflowCount); // hit is either 1 or 0
-            inPtr += numscalars; // go to the next x pixel
-            importancePtr++;
-          }
+          vtkOptimizedTrilinearInterpolationRow(xSkipMiddleSegmentPixEnd+1, xIntersectionPixEnd, outPoint, outPoint1, xAxis, 
+            inPtr, outPtr, outExt, outInc,
+            numscalars, compoundingMode, accPtr, sparseVolume, importancePtr, accOverflowCount, insertionParams->pixelRejectionThreshold, useAvx2);
         }
         else
         {
-          for (int idX = xIntersectionPixStart; idX <= xIntersectionPixEnd; idX++) // for all of the x pixels within the fan
-          {
-            if (pixelRejectionEnabled)
-            {
-              double inPixelSumAllComponents = 0;
-              for (int i = numscalars-1; i>=0; i--)
-              {
-                inPixelSumAllComponents+=inPtr[i];
-              }
-              if (inPixelSumAllComponents<pixelRejectionThresholdSumAllComponents)
-              {
-                // too dark, skip this pixel
-                inPtr += numscalars; // go to the next x pixel
-                importancePtr++;
-                continue;
-              }
-            }
-
-            outPoint[0] = outPoint1[0] + idX*xAxis[0];
-            outPoint[1] = outPoint1[1] + idX*xAxis[1];
-            outPoint[2] = outPoint1[2] + idX*xAxis[2];
-            vtkTrilinearInterpolation(outPoint, inPtr, outPtr, accPtr, importancePtr, numscalars, compoundingMode, outExt, outInc, accOverflowCount); // hit is either 1 or 0
-            inPtr += numscalars; // go to the next x pixel
-            importancePtr++;
-          }
+          vtkOptimizedTrilinearInterpolationRow(xIntersectionPixStart, xIntersectionPixEnd, outPoint, outPoint1, xAxis, 
+            inPtr, outPtr, outExt, outInc,
+            numscalars, compoundingMode, accPtr, sparseVolume, importancePtr, accOverflowCount, insertionParams->pixelRejectionThreshold, useAvx2);
         }
       }      
       else 
@@ -1386,18 +1358,18 @@ static void vtkOptimizedInsertSlice(vtkPlusPasteSliceIntoVolumeInsertSliceParams
         {
           vtkFreehand2OptimizedNNHelper(xIntersectionPixStart, xSkipMiddleSegmentPixStart-1, outPoint, outPoint1, xAxis, 
             inPtr, outPtr, outExt, outInc,
-            numscalars, compoundingMode, accPtr, importancePtr, accOverflowCount, insertionParams->pixelRejectionThreshold);
+            numscalars, compoundingMode, accPtr, sparseVolume, importancePtr, accOverflowCount, insertionParams->pixelRejectionThreshold);
           inPtr += numscalars * (xSkipMiddleSegmentPixEnd-xSkipMiddleSegmentPixStart+1);
           importancePtr += (xSkipMiddleSegmentPixEnd - xSkipMiddleSegmentPixStart + 1);;
           vtkFreehand2OptimizedNNHelper(xSkipMiddleSegmentPixEnd+1, xIntersectionPixEnd, outPoint, outPoint1, xAxis, 
             inPtr, outPtr, outExt, outInc,
-            numscalars, compoundingMode, accPtr, importancePtr, accOverflowCount, insertionParams->pixelRejectionThreshold);
+            numscalars, compoundingMode, accPtr, sparseVolume, importancePtr, accOverflowCount, insertionParams->pixelRejectionThreshold);
         }
         else
         {
           vtkFreehand2OptimizedNNHelper(xIntersectionPixStart, xIntersectionPixEnd, outPoint, outPoint1, xAxis, 
             inPtr, outPtr, outExt, outInc,
-            numscalars, compoundingMode, accPtr, importancePtr, accOverflowCount, insertionParams->pixelRejectionThreshold);
+            numscalars, compoundingMode, accPtr, sparseVolume, importancePtr, accOverflowCount, insertionParams->pixelRejectionThreshold);
         }
       }
 
@@ -0,0 +1,267 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+/*!
+  \file vtkPlusPasteSliceIntoVolumeHelperSimd.h
+  \brief Vectorized helper functions for pasting slice into volume
+
+  Contains the AVX2 trilinear interpolation kernel that is used by the optimized slice insertion
+  (vtkPlusPasteSliceIntoVolumeHelperOptimized) with double precision computation (PARTIAL_OPTIMIZATION).
+
+  The voxel indices and the trilinear weights of 4 consecutive pixels of an image row are computed at once.
+  Then the pixels are pasted one by one, in the same order as in the scalar implementation, because
+  neighbor pixels often modify the same voxels. The 8 voxels around a pixel are all different (voxels with
+  zero weight are not modified), so for single-component unsigned char volumes with MEAN compounding
+  these 8 voxels are updated at once.
+
+  All computations are performed in double precision, in the same order as in the scalar implementation
+  (floor and round are computed the same way as by PlusMath on 64-bit platforms), therefore
+  the reconstructed volume is exactly the same as the one computed without AVX2 instructions.
+
+  \sa vtkPlusPasteSliceIntoVolume, vtkPlusPasteSliceIntoVolumeHelperCommon, vtkPlusPasteSliceIntoVolumeHelperOptimized
+  \ingroup PlusLibVolumeReconstruction
+*/
+
+#ifndef __vtkPlusPasteSliceIntoVolumeHelperSimd_h
+#define __vtkPlusPasteSliceIntoVolumeHelperSimd_h
+
+#include "vtkPlusPasteSliceIntoVolumeHelperCommon.h"
+
+#ifdef PLUS_AVX2_AVAILABLE
+#include <immintrin.h>
+#endif
+
+//----------------------------------------------------------------------------
+/*!
+  The AVX2 kernel is only available for double precision computation.
+  Returns false, which means that the row has to be pasted by the scalar implementation.
+*/
+template <class F, class T>
+static inline bool vtkTrilinearInterpolationRowAvx2(int, int, F*, F*, T*&, T*, int[6], vtkIdType[3], int,
+    vtkPlusPasteSliceIntoVolume::CompoundingType, unsigned short*, vtkPlusSparseVolume*, unsigned char*&, unsigned int*, double)
+{
+  return false;
+}
+
+#ifdef PLUS_AVX2_AVAILABLE
+
+//----------------------------------------------------------------------------
+/*! Same as PlusMath::Floor on 64-bit platforms. Returns the integer part as double, the fraction is returned in f. */
+PLUS_TARGET_AVX2 static inline __m256d vtkFloorAvx2(__m256d x, __m256d& f)
+{
+  __m256d shifted = _mm256_add_pd(x, _mm256_set1_pd(103079215104.0 + VTK_RESLICE_FLOOR_TOL));
+  __m256d i = _mm256_sub_pd(_mm256_floor_pd(shifted), _mm256_set1_pd(103079215104.0));
+  f = _mm256_sub_pd(x, i);
+  return i;
+}
+
+//----------------------------------------------------------------------------
+/*! Same as PlusMath::Round on 64-bit platforms. Returns the rounded value as double. */
+PLUS_TARGET_AVX2 static inline __m256d vtkRoundAvx2(__m256d x)
+{
+  __m256d shifted = _mm256_add_pd(x, _mm256_set1_pd(103079215104.5 + VTK_RESLICE_FLOOR_TOL));
+  return _mm256_sub_pd(_mm256_floor_pd(shifted), _mm256_set1_pd(103079215104.0));
+}
+
+//----------------------------------------------------------------------------
+/*!
+  Paste a pixel into the 8 surrounding voxels of a single-component unsigned char volume with MEAN compounding.
+  Same as vtkTrilinearSplat, but the 8 voxels are updated at once.
+  \param fdx Weights of the voxels (voxel 0-3 in the first, 4-7 in the second vector)
+  \param voxelIndex Index of the voxels in the output volume
+*/
+PLUS_TARGET_AVX2 static inline void vtkTrilinearSplatMeanAvx2(const __m256d fdx[2], const vtkIdType voxelIndex[8], unsigned char inValue,
+    unsigned char* outPtr, unsigned short* accPtr, unsigned int* accOverflowCount)
+{
+  const __m256d inValues = _mm256_set1_pd(inValue);
+  const __m256d accumulationMultiplier = _mm256_set1_pd(ACCUMULATION_MULTIPLIER);
+  const __m256d accumulationThreshold = _mm256_set1_pd(ACCUMULATION_THRESHOLD);
+  const __m256d accumulationMaximum = _mm256_set1_pd(ACCUMULATION_MAXIMUM);
+
+  double newOutValues[8];
+  double newAccValues[8];
+  int modifiedVoxels = 0;
+  int overflowVoxels = 0;
+  for (int half = 0; half < 2; half++)
+  {
+    const vtkIdType* index = voxelIndex + 4 * half;
+    __m256d outValues = _mm256_set_pd(outPtr[index[3]], outPtr[index[2]], outPtr[index[1]], outPtr[index[0]]);
+    __m256d accValues = _mm256_set_pd(accPtr[index[3]], accPtr[index[2]], accPtr[index[1]], accPtr[index[0]]);
+    // r = acc / ACCUMULATION_MULTIPLIER (multiplication by the inverse of a power of two gives the exact same result)
+    __m256d r = _mm256_mul_pd(accValues, _mm256_set1_pd(1.0 / ACCUMULATION_MULTIPLIER));
+    __m256d a = _mm256_add_pd(fdx[half], r);
+    __m256d value = _mm256_div_pd(_mm256_add_pd(_mm256_mul_pd(fdx[half], inValues), _mm256_mul_pd(r, outValues)), a);
+    _mm256_storeu_pd(newOutValues + 4 * half, vtkRoundAvx2(value));
+    a = _mm256_mul_pd(a, accumulationMultiplier);
+    overflowVoxels |= _mm256_movemask_pd(_mm256_and_pd(_mm256_cmp_pd(a, accumulationThreshold, _CMP_GT_OQ),
+                                         _mm256_cmp_pd(accValues, accumulationThreshold, _CMP_LE_OQ))) << (4 * half);
+    // don't allow accumulation buffer overflow
+    _mm256_storeu_pd(newAccValues + 4 * half, _mm256_blendv_pd(accumulationMaximum, vtkRoundAvx2(a), _mm256_cmp_pd(a, accumulationMaximum, _CMP_LT_OQ)));
+    modifiedVoxels |= _mm256_movemask_pd(_mm256_cmp_pd(fdx[half], _mm256_setzero_pd(), _CMP_NEQ_UQ)) << (4 * half);
+  }
+
+  for (int j = 0; j < 8; j++)
+  {
+    if (modifiedVoxels & (1 << j))
+    {
+      outPtr[voxelIndex[j]] = static_cast<int>(newOutValues[j]);
+      accPtr[voxelIndex[j]] = static_cast<int>(newAccValues[j]);
+      if (overflowVoxels & (1 << j))
+      {
+        (*accOverflowCount) += 1;
+      }
+    }
+  }
+}
+
+//----------------------------------------------------------------------------
+/*!
+  Paste the pixels of an image row between xIntersectionPixStart and xIntersectionPixEnd (inclusive) into the volume
+  using trilinear interpolation. Gives the same result as calling vtkTrilinearInterpolation for each pixel.
+  inPtr and importancePtr are moved to the pixel after xIntersectionPixEnd.
+  Returns true (the row has been pasted).
+*/
+template <class T>
+PLUS_TARGET_AVX2 static bool vtkTrilinearInterpolationRowAvx2(int xIntersectionPixStart, int xIntersectionPixEnd, double* outPoint1, double* xAxis,
+    T*& inPtr, T* outPtr, int outExt[6], vtkIdType outInc[3], int numscalars,
+    vtkPlusPasteSliceIntoVolume::CompoundingType compoundingMode, unsigned short* accPtr, vtkPlusSparseVolume* sparseVolume,
+    unsigned char*& importancePtr, unsigned int* accOverflowCount, double pixelRejectionThreshold)
+{
+  bool pixelRejectionEnabled = PixelRejectionEnabled(pixelRejectionThreshold);
+  double pixelRejectionThresholdSumAllComponents = 0;
+  if (pixelRejectionEnabled)
+  {
+    pixelRejectionThresholdSumAllComponents = pixelRejectionThreshold * numscalars;
+  }
+  // the 8 voxels can be updated at once if all the scalars of a voxel are stored in a single value
+  bool vectorizedMeanCompounding = (compoundingMode == vtkPlusPasteSliceIntoVolume::MEAN_COMPOUNDING_MODE
+                                    && typeid(T) == typeid(unsigned char) && numscalars == 1 && outInc[0] == 1 && sparseVolume == NULL);
+
+  const __m256d one = _mm256_set1_pd(1.0);
+  const __m256d zero = _mm256_setzero_pd();
+  const __m256d pixelOffsets = _mm256_set_pd(3, 2, 1, 0);
+  __m256d outPoint1Vec[3];
+  __m256d xAxisVec[3];
+  __m256d outSize[3];
+  for (int axis = 0; axis < 3; axis++)
+  {
+    outPoint1Vec[axis] = _mm256_set1_pd(outPoint1[axis]);
+    xAxisVec[axis] = _mm256_set1_pd(xAxis[axis]);
+    outSize[axis] = _mm256_set1_pd(outExt[2 * axis + 1] - outExt[2 * axis]);
+  }
+
+  double fdx[8][4]; // weight of each voxel for the 4 pixels
+  int outId[6][4]; // outIdX0, outIdX1, outIdY0, outIdY1, outIdZ0, outIdZ1 for the 4 pixels
+
+  int idX = xIntersectionPixStart;
+  for (; idX + 3 <= xIntersectionPixEnd; idX += 4)
+  {
+    __m256d pixelIndex = _mm256_add_pd(_mm256_set1_pd(idX), pixelOffsets);
+    __m256d f[3];
+    __m256d insideVolume = _mm256_castsi256_pd(_mm256_set1_epi64x(-1));
+    for (int axis = 0; axis < 3; axis++)
+    {
+      __m256d outPoint = _mm256_add_pd(outPoint1Vec[axis], _mm256_mul_pd(pixelIndex, xAxisVec[axis]));
+      __m256d outId0 = vtkFloorAvx2(outPoint, f[axis]);
+      __m256d outId1 = _mm256_add_pd(outId0, _mm256_and_pd(_mm256_cmp_pd(f[axis], zero, _CMP_NEQ_UQ), one)); // ceiling
+      // bounds check
+      insideVolume = _mm256_and_pd(insideVolume, _mm256_cmp_pd(outId0, zero, _CMP_GE_OQ));
+      insideVolume = _mm256_and_pd(insideVolume, _mm256_cmp_pd(outId1, outSize[axis], _CMP_LE_OQ));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(outId[2 * axis]), _mm256_cvtpd_epi32(outId0));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(outId[2 * axis + 1]), _mm256_cvtpd_epi32(outId1));
+    }
+    int insideVolumeMask = _mm256_movemask_pd(insideVolume);
+
+    // remainders from the fractional components - difference between the fractional value and the ceiling
+    __m256d rx = _mm256_sub_pd(one, f[0]);
+    __m256d ry = _mm256_sub_pd(one, f[1]);
+    __m256d rz = _mm256_sub_pd(one, f[2]);
+    __m256d ryrz = _mm256_mul_pd(ry, rz);
+    __m256d ryfz = _mm256_mul_pd(ry, f[2]);
+    __m256d fyrz = _mm256_mul_pd(f[1], rz);
+    __m256d fyfz = _mm256_mul_pd(f[1], f[2]);
+    _mm256_storeu_pd(fdx[0], _mm256_mul_pd(rx, ryrz));
+    _mm256_storeu_pd(fdx[1], _mm256_mul_pd(rx, ryfz));
+    _mm256_storeu_pd(fdx[2], _mm256_mul_pd(rx, fyrz));
+    _mm256_storeu_pd(fdx[3], _mm256_mul_pd(rx, fyfz));
+    _mm256_storeu_pd(fdx[4], _mm256_mul_pd(f[0], ryrz));
+    _mm256_storeu_pd(fdx[5], _mm256_mul_pd(f[0], ryfz));
+    _mm256_storeu_pd(fdx[6], _mm256_mul_pd(f[0], fyrz));
+    _mm256_storeu_pd(fdx[7], _mm256_mul_pd(f[0], fyfz));
+
+    // paste the pixels in order, as subsequent pixels may modify the same voxels
+    for (int pixel = 0; pixel < 4; pixel++, inPtr += numscalars, importancePtr++)
+    {
+      if ((insideVolumeMask & (1 << pixel)) == 0)
+      {
+        continue;
+      }
+      if (pixelRejectionEnabled)
+      {
+        double inPixelSumAllComponents = 0;
+        for (int i = numscalars - 1; i >= 0; i--)
+        {
+          inPixelSumAllComponents += inPtr[i];
+        }
+        if (inPixelSumAllComponents < pixelRejectionThresholdSumAllComponents)
+        {
+          // too dark, skip this pixel
+          continue;
+        }
+      }
+      if (vectorizedMeanCompounding)
+      {
+        __m256d pixelFdx[2] =
+        {
+          _mm256_set_pd(fdx[3][pixel], fdx[2][pixel], fdx[1][pixel], fdx[0][pixel]),
+          _mm256_set_pd(fdx[7][pixel], fdx[6][pixel], fdx[5][pixel], fdx[4][pixel])
+        };
+        vtkIdType voxelIndex[8];
+        for (int j = 0; j < 8; j++)
+        {
+          // bit 2, 1, 0 of the corner index selects the X, Y, Z neighbor
+          voxelIndex[j] = outId[(j & 4) ? 1 : 0][pixel] * outInc[0] + outId[(j & 2) ? 3 : 2][pixel] * outInc[1] + outId[(j & 1) ? 5 : 4][pixel] * outInc[2];
+        }
+        vtkTrilinearSplatMeanAvx2(pixelFdx, voxelIndex, *reinterpret_cast<unsigned char*>(inPtr),
+                                  reinterpret_cast<unsigned char*>(outPtr), accPtr, accOverflowCount);
+      }
+      else
+      {
+        double pixelFdx[8] = { fdx[0][pixel], fdx[1][pixel], fdx[2][pixel], fdx[3][pixel], fdx[4][pixel], fdx[5][pixel], fdx[6][pixel], fdx[7][pixel] };
+        vtkTrilinearSplat(pixelFdx, outId[0][pixel], outId[2][pixel], outId[4][pixel], outId[1][pixel], outId[3][pixel], outId[5][pixel],
+                          inPtr, outPtr, accPtr, sparseVolume, importancePtr, numscalars, compoundingMode, outInc, accOverflowCount);
+      }
+    }
+  }
+
+  // remaining pixels
+  double outPoint[3];
+  for (; idX <= xIntersectionPixEnd; idX++, inPtr += numscalars, importancePtr++)
+  {
+    if (pixelRejectionEnabled)
+    {
+      double inPixelSumAllComponents = 0;
+      for (int i = numscalars - 1; i >= 0; i--)
+      {
+        inPixelSumAllComponents += inPtr[i];
+      }
+      if (inPixelSumAllComponents < pixelRejectionThresholdSumAllComponents)
+      {
+        // too dark, skip this pixel
+        continue;
+      }
+    }
+    outPoint[0] = outPoint1[0] + idX * xAxis[0];
+    outPoint[1] = outPoint1[1] + idX * xAxis[1];
+    outPoint[2] = outPoint1[2] + idX * xAxis[2];
+    vtkTrilinearInterpolation(outPoint, inPtr, outPtr, accPtr, sparseVolume, importancePtr, numscalars, compoundingMode, outExt, outInc, accOverflowCount);
+  }
+  return true;
+}
+
+#endif
+
+#endif
@@ -84,6 +84,7 @@ static int vtkNearestNeighborInterpolation(F *point,
                                            T *inPtr,
                                            T *outPtr,
                                            unsigned short *accPtr,
+                                           vtkPlusSparseVolume *sparseVolume,
                                            unsigned char *importancePtr,
                                            int numscalars,
                                            vtkPlusPasteSliceIntoVolume::CompoundingType compoundingMode,
@@ -104,14 +105,11 @@ static int vtkNearestNeighborInterpolation(F *point,
        outIdY | (outExt[3]-outExt[2] - outIdY) |
        outIdZ | (outExt[5]-outExt[4] - outIdZ)) >= 0)
   {
-    int inc = outIdX*outInc[0]+outIdY*outInc[1]+outIdZ*outInc[2];
-    outPtr += inc;
+    GetOutputVoxelPointers(outIdX, outIdY, outIdZ, outPtr, accPtr, outInc, sparseVolume, outPtr, accPtr);
     switch (compoundingMode)
     {
     case (vtkPlusPasteSliceIntoVolume::MAXIMUM_COMPOUNDING_MODE):
       {
-        accPtr += inc/outInc[0];
-
         int newa = *accPtr + ACCUMULATION_MULTIPLIER;
         if (newa > ACCUMULATION_THRESHOLD)
           (*accOverflowCount) += 1;
@@ -134,7 +132,6 @@ static int vtkNearestNeighborInterpolation(F *point,
       }
     case (vtkPlusPasteSliceIntoVolume::MEAN_COMPOUNDING_MODE):
       {
-        accPtr += inc/outInc[0];
         if (*accPtr <= ACCUMULATION_THRESHOLD) { // no overflow, act normally
 
           int newa = *accPtr + ACCUMULATION_MULTIPLIER;
@@ -160,7 +157,6 @@ static int vtkNearestNeighborInterpolation(F *point,
       }
     case (vtkPlusPasteSliceIntoVolume::IMPORTANCE_MASK_COMPOUNDING_MODE):
       {
-        accPtr += inc/outInc[0];
         if (*accPtr <= ACCUMULATION_THRESHOLD) { // no overflow, act normally
 
           if (*importancePtr == 0)
@@ -197,8 +193,6 @@ static int vtkNearestNeighborInterpolation(F *point,
       }
     case (vtkPlusPasteSliceIntoVolume::LATEST_COMPOUNDING_MODE):
       {
-        accPtr += inc/outInc[0];
-
         int newa = *accPtr + ACCUMULATION_MULTIPLIER;
         if (newa > ACCUMULATION_THRESHOLD)
           (*accOverflowCount) += 1;
@@ -241,6 +235,7 @@ static void vtkUnoptimizedInsertSlice(vtkPlusPasteSliceIntoVolumeInsertSlicePara
   vtkImageData* outData = insertionParams->outData;
   T* outPtr = reinterpret_cast<T*>(insertionParams->outPtr);
   unsigned short* accPtr = insertionParams->accPtr;
+  vtkPlusSparseVolume* sparseVolume = insertionParams->sparseVolume;
   unsigned char* importancePtr = insertionParams->importancePtr;
   vtkImageData* inData = insertionParams->inData;
   T* inPtr = reinterpret_cast<T*>(insertionParams->inPtr);
@@ -326,7 +321,7 @@ static void vtkUnoptimizedInsertSlice(vtkPlusPasteSliceIntoVolumeInsertSlicePara
   }
 
   // Set interpolation method - nearest neighbor or trilinear  
-  int (*interpolate)(F *, T *, T *, unsigned short *, unsigned char *, int, vtkPlusPasteSliceIntoVolume::CompoundingType, int a[6], vtkIdType b[3], unsigned int *)=NULL; // pointer to the nearest neighbor or trilinear interpolation function  
+  int (*interpolate)(F *, T *, T *, unsigned short *, vtkPlusSparseVolume *, unsigned char *, int, vtkPlusPasteSliceIntoVolume::CompoundingType, int a[6], vtkIdType b[3], unsigned int *)=NULL; // pointer to the nearest neighbor or trilinear interpolation function  
   switch (interpolationMode)
   {
   case vtkPlusPasteSliceIntoVolume::NEAREST_NEIGHBOR_INTERPOLATION:
@@ -421,7 +416,7 @@ static void vtkUnoptimizedInsertSlice(vtkPlusPasteSliceIntoVolumeInsertSlicePara
         outPoint[3] = 1;
 
         // interpolation functions return 1 if the interpolation was successful, 0 otherwise
-        interpolate(outPoint, inPtr, outPtr, accPtr, importancePtr, numscalars, compoundingMode, outExt, outInc, accOverflowCount);
+        interpolate(outPoint, inPtr, outPtr, accPtr, sparseVolume, importancePtr, numscalars, compoundingMode, outExt, outInc, accOverflowCount);
       }
     }
   }
@@ -0,0 +1,238 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+#include "PlusConfigure.h"
+#include "vtkPlusSparseVolume.h"
+
+#include "vtkDataArray.h"
+#include "vtkImageData.h"
+
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+#include <new>
+
+vtkStandardNewMacro(vtkPlusSparseVolume);
+
+//----------------------------------------------------------------------------
+vtkPlusSparseVolume::vtkPlusSparseVolume()
+  : ScalarType(VTK_UNSIGNED_CHAR)
+  , NumberOfScalarComponents(1)
+  , Bricks(NULL)
+  , NumberOfAllocatedBricks(0)
+  , BrickMemorySize(0)
+  , AccumulationBufferOffset(0)
+  , DiscardedBrick(NULL)
+{
+  for (int i = 0; i < 6; i++)
+  {
+    this->Extent[i] = 0;
+  }
+  this->NumberOfBricks[0] = 0;
+  this->NumberOfBricks[1] = 0;
+  this->NumberOfBricks[2] = 0;
+}
+
+//----------------------------------------------------------------------------
+vtkPlusSparseVolume::~vtkPlusSparseVolume()
+{
+  this->Clear();
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusSparseVolume::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+  os << indent << "Extent: " << this->Extent[0] << " " << this->Extent[1] << " " << this->Extent[2] << " "
+     << this->Extent[3] << " " << this->Extent[4] << " " << this->Extent[5] << "\n";
+  os << indent << "ScalarType: " << vtkImageScalarTypeNameMacro(this->ScalarType) << "\n";
+  os << indent << "NumberOfScalarComponents: " << this->NumberOfScalarComponents << "\n";
+  os << indent << "BrickSize: " << BRICK_SIZE << "\n";
+  os << indent << "NumberOfAllocatedBricks: " << this->GetNumberOfAllocatedBricks() << " of " << this->GetTotalNumberOfBricks() << "\n";
+  os << indent << "AllocatedMemorySize: " << this->GetAllocatedMemorySize() << " bytes\n";
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusSparseVolume::Initialize(const int extent[6], int scalarType, int numberOfScalarComponents)
+{
+  this->Clear();
+
+  for (int axis = 0; axis < 3; axis++)
+  {
+    if (extent[2 * axis] > extent[2 * axis + 1])
+    {
+      LOG_ERROR("vtkPlusSparseVolume::Initialize failed: invalid extent [" << extent[0] << "," << extent[1] << ","
+                << extent[2] << "," << extent[3] << "," << extent[4] << "," << extent[5] << "]");
+      return PLUS_FAIL;
+    }
+  }
+  if (numberOfScalarComponents < 1)
+  {
+    LOG_ERROR("vtkPlusSparseVolume::Initialize failed: invalid number of scalar components (" << numberOfScalarComponents << ")");
+    return PLUS_FAIL;
+  }
+
+  for (int i = 0; i < 6; i++)
+  {
+    this->Extent[i] = extent[i];
+  }
+  for (int axis = 0; axis < 3; axis++)
+  {
+    this->NumberOfBricks[axis] = (extent[2 * axis + 1] - extent[2 * axis]) / BRICK_SIZE + 1;
+  }
+  this->ScalarType = scalarType;
+  this->NumberOfScalarComponents = numberOfScalarComponents;
+
+  const size_t numberOfVoxelsInBrick = BRICK_SIZE * BRICK_SIZE * BRICK_SIZE;
+  this->AccumulationBufferOffset = numberOfVoxelsInBrick * numberOfScalarComponents * vtkDataArray::GetDataTypeSize(scalarType);
+  this->BrickMemorySize = this->AccumulationBufferOffset + numberOfVoxelsInBrick * sizeof(unsigned short);
+
+  vtkIdType totalNumberOfBricks = this->GetTotalNumberOfBricks();
+  this->Bricks = new (std::nothrow) std::atomic<unsigned char*>[totalNumberOfBricks];
+  if (this->Bricks == NULL)
+  {
+    LOG_ERROR("vtkPlusSparseVolume::Initialize failed: cannot allocate brick table for " << totalNumberOfBricks << " bricks");
+    return PLUS_FAIL;
+  }
+  for (vtkIdType brickIndex = 0; brickIndex < totalNumberOfBricks; brickIndex++)
+  {
+    this->Bricks[brickIndex].store(NULL);
+  }
+  this->NumberOfAllocatedBricks = 0;
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusSparseVolume::Clear()
+{
+  if (this->Bricks != NULL)
+  {
+    vtkIdType totalNumberOfBricks = this->GetTotalNumberOfBricks();
+    for (vtkIdType brickIndex = 0; brickIndex < totalNumberOfBricks; brickIndex++)
+    {
+      delete[] this->Bricks[brickIndex].load();
+    }
+    delete[] this->Bricks;
+    this->Bricks = NULL;
+  }
+  delete[] this->DiscardedBrick;
+  this->DiscardedBrick = NULL;
+  this->NumberOfAllocatedBricks = 0;
+  this->NumberOfBricks[0] = 0;
+  this->NumberOfBricks[1] = 0;
+  this->NumberOfBricks[2] = 0;
+}
+
+//----------------------------------------------------------------------------
+unsigned char* vtkPlusSparseVolume::AllocateBrick(vtkIdType brickIndex)
+{
+  unsigned char* newBrick = new (std::nothrow) unsigned char[this->BrickMemorySize]();
+  if (newBrick == NULL)
+  {
+    LOG_ERROR("vtkPlusSparseVolume: failed to allocate volume brick (" << this->BrickMemorySize << " bytes), "
+              << this->GetNumberOfAllocatedBricks() << " bricks are allocated already. Voxels in this brick are not stored.");
+    // All threads may write into the discarded brick, so it is allocated only once and never released until the volume is cleared
+    std::lock_guard<std::mutex> lock(this->DiscardedBrickMutex);
+    if (this->DiscardedBrick == NULL)
+    {
+      this->DiscardedBrick = new unsigned char[this->BrickMemorySize]();
+    }
+    return this->DiscardedBrick;
+  }
+
+  unsigned char* existingBrick = NULL;
+  if (!this->Bricks[brickIndex].compare_exchange_strong(existingBrick, newBrick, std::memory_order_acq_rel))
+  {
+    // another thread has allocated the brick in the meantime
+    delete[] newBrick;
+    return existingBrick;
+  }
+  this->NumberOfAllocatedBricks++;
+  return newBrick;
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusSparseVolume::CopyBricksToBuffer(unsigned char* buffer, size_t voxelSize, size_t offsetInBrick)
+{
+  const int brickSize = BRICK_SIZE;
+  const int dimensions[3] =
+  {
+    this->Extent[1] - this->Extent[0] + 1,
+    this->Extent[3] - this->Extent[2] + 1,
+    this->Extent[5] - this->Extent[4] + 1
+  };
+  for (int brickZ = 0; brickZ < this->NumberOfBricks[2]; brickZ++)
+  {
+    for (int brickY = 0; brickY < this->NumberOfBricks[1]; brickY++)
+    {
+      for (int brickX = 0; brickX < this->NumberOfBricks[0]; brickX++)
+      {
+        unsigned char* brick = this->Bricks[brickX + (brickY + vtkIdType(brickZ) * this->NumberOfBricks[1]) * this->NumberOfBricks[0]].load();
+        int x0 = brickX * brickSize;
+        int y0 = brickY * brickSize;
+        int z0 = brickZ * brickSize;
+        size_t rowSize = std::min(brickSize, dimensions[0] - x0) * voxelSize;
+        int numberOfRows = std::min(brickSize, dimensions[1] - y0);
+        int numberOfSlices = std::min(brickSize, dimensions[2] - z0);
+        for (int z = 0; z < numberOfSlices; z++)
+        {
+          for (int y = 0; y < numberOfRows; y++)
+          {
+            unsigned char* bufferRow = buffer + ((size_t(z0 + z) * dimensions[1] + (y0 + y)) * dimensions[0] + x0) * voxelSize;
+            if (brick == NULL)
+            {
+              memset(bufferRow, 0, rowSize);
+            }
+            else
+            {
+              memcpy(bufferRow, brick + offsetInBrick + (size_t(z) * brickSize + y) * brickSize * voxelSize, rowSize);
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusSparseVolume::CopyScalarsToImage(vtkImageData* volume)
+{
+  if (!this->IsInitialized())
+  {
+    LOG_ERROR("vtkPlusSparseVolume::CopyScalarsToImage failed: the volume is not initialized");
+    return PLUS_FAIL;
+  }
+  volume->SetExtent(this->Extent);
+  volume->AllocateScalars(this->ScalarType, this->NumberOfScalarComponents);
+  unsigned char* volumePtr = static_cast<unsigned char*>(volume->GetScalarPointerForExtent(this->Extent));
+  if (volumePtr == NULL)
+  {
+    LOG_ERROR("vtkPlusSparseVolume::CopyScalarsToImage failed: cannot allocate memory for the dense volume");
+    return PLUS_FAIL;
+  }
+  this->CopyBricksToBuffer(volumePtr, this->NumberOfScalarComponents * vtkDataArray::GetDataTypeSize(this->ScalarType), 0);
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusSparseVolume::CopyAccumulationBufferToImage(vtkImageData* accumulationBuffer)
+{
+  if (!this->IsInitialized())
+  {
+    LOG_ERROR("vtkPlusSparseVolume::CopyAccumulationBufferToImage failed: the volume is not initialized");
+    return PLUS_FAIL;
+  }
+  accumulationBuffer->SetExtent(this->Extent);
+  accumulationBuffer->AllocateScalars(VTK_UNSIGNED_SHORT, 1);
+  unsigned char* accPtr = static_cast<unsigned char*>(accumulationBuffer->GetScalarPointerForExtent(this->Extent));
+  if (accPtr == NULL)
+  {
+    LOG_ERROR("vtkPlusSparseVolume::CopyAccumulationBufferToImage failed: cannot allocate memory for the dense accumulation buffer");
+    return PLUS_FAIL;
+  }
+  this->CopyBricksToBuffer(accPtr, sizeof(unsigned short), this->AccumulationBufferOffset);
+  return PLUS_SUCCESS;
+}
@@ -0,0 +1,127 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+#ifndef __vtkPlusSparseVolume_h
+#define __vtkPlusSparseVolume_h
+
+#include "vtkPlusVolumeReconstructionExport.h"
+#include "vtkObject.h"
+
+#include <atomic>
+#include <mutex>
+
+class vtkImageData;
+
+/*!
+  \class vtkPlusSparseVolume
+  \brief Reconstructed volume and accumulation buffer stored in bricks that are allocated when they are first written
+
+  The volume extent is divided into cubic bricks of BRICK_SIZE x BRICK_SIZE x BRICK_SIZE voxels. Each brick stores
+  the scalars and the accumulation buffer values of its voxels. Memory is only allocated for bricks that contain
+  at least one written voxel, therefore the memory need of reconstructing a long freehand sweep is proportional
+  to the swept region instead of the bounding box of the sweep.
+
+  Voxel pointers may be requested from multiple threads concurrently (bricks are allocated atomically),
+  but a voxel must not be written by multiple threads at the same time (same as in a dense volume).
+
+  \sa vtkPlusPasteSliceIntoVolume
+  \ingroup PlusLibVolumeReconstruction
+*/
+class vtkPlusVolumeReconstructionExport vtkPlusSparseVolume : public vtkObject
+{
+public:
+  static vtkPlusSparseVolume* New();
+  vtkTypeMacro(vtkPlusSparseVolume, vtkObject);
+  virtual void PrintSelf(ostream& os, vtkIndent indent) VTK_OVERRIDE;
+
+  /*! Number of voxels along each axis of a brick is 2^BRICK_SIZE_LOG2 */
+  static const int BRICK_SIZE_LOG2 = 5;
+  static const int BRICK_SIZE = 1 << BRICK_SIZE_LOG2;
+
+  /*!
+    Release all bricks and set the volume extent and voxel type. All voxels are 0 after initialization.
+    Accumulation buffer values are stored as unsigned short.
+  */
+  PlusStatus Initialize(const int extent[6], int scalarType, int numberOfScalarComponents);
+
+  /*! Release all bricks. The volume cannot be used until it is initialized again. */
+  void Clear();
+
+  /*! Returns true if the volume has been initialized */
+  bool IsInitialized() const { return this->Bricks != NULL; }
+
+  /*!
+    Get the address of a voxel in the volume and in the accumulation buffer.
+    Voxel indices are relative to the first voxel of the extent and they must be inside the extent.
+    The brick that contains the voxel is allocated if it has not been allocated yet.
+  */
+  template <class T> void GetVoxelPointers(int x, int y, int z, T*& voxelPtr, unsigned short*& accumulationPtr)
+  {
+    vtkIdType brickIndex = (x >> BRICK_SIZE_LOG2)
+      + ((y >> BRICK_SIZE_LOG2) + vtkIdType(z >> BRICK_SIZE_LOG2) * this->NumberOfBricks[1]) * this->NumberOfBricks[0];
+    unsigned char* brick = this->Bricks[brickIndex].load(std::memory_order_acquire);
+    if (brick == NULL)
+    {
+      brick = this->AllocateBrick(brickIndex);
+    }
+    int voxelIndex = (x & (BRICK_SIZE - 1)) + ((y & (BRICK_SIZE - 1)) + (z & (BRICK_SIZE - 1)) * BRICK_SIZE) * BRICK_SIZE;
+    voxelPtr = reinterpret_cast<T*>(brick) + voxelIndex * this->NumberOfScalarComponents;
+    accumulationPtr = reinterpret_cast<unsigned short*>(brick + this->AccumulationBufferOffset) + voxelIndex;
+  }
+
+  /*! Copy the voxel scalars into a dense image. The image scalars are allocated with the volume extent. Voxels in unallocated bricks are set to 0. */
+  PlusStatus CopyScalarsToImage(vtkImageData* volume);
+
+  /*! Copy the accumulation buffer into a dense unsigned short image. The image scalars are allocated with the volume extent. */
+  PlusStatus CopyAccumulationBufferToImage(vtkImageData* accumulationBuffer);
+
+  int GetScalarType() const { return this->ScalarType; }
+  int GetNumberOfScalarComponents() const { return this->NumberOfScalarComponents; }
+
+  /*! Get the number of bricks that cover the volume extent */
+  vtkIdType GetTotalNumberOfBricks() const { return vtkIdType(this->NumberOfBricks[0]) * this->NumberOfBricks[1] * this->NumberOfBricks[2]; }
+
+  /*! Get the number of bricks that have been written */
+  vtkIdType GetNumberOfAllocatedBricks() const { return this->NumberOfAllocatedBricks; }
+
+  /*! Get the memory size of all allocated bricks in bytes */
+  unsigned long long GetAllocatedMemorySize() const { return static_cast<unsigned long long>(this->NumberOfAllocatedBricks) * this->BrickMemorySize; }
+
+protected:
+  vtkPlusSparseVolume();
+  virtual ~vtkPlusSparseVolume();
+
+  /*! Allocate a zero-filled brick if it has not been allocated by another thread yet, returns the brick */
+  unsigned char* AllocateBrick(vtkIdType brickIndex);
+
+  /*! Copy voxel values from the bricks into a dense buffer that covers the volume extent */
+  void CopyBricksToBuffer(unsigned char* buffer, size_t voxelSize, size_t offsetInBrick);
+
+  int Extent[6];
+  int ScalarType;
+  int NumberOfScalarComponents;
+  int NumberOfBricks[3];
+
+  /*! Pointer to the memory of each brick, NULL if the brick is not allocated */
+  std::atomic<unsigned char*>* Bricks;
+  std::atomic<vtkIdType> NumberOfAllocatedBricks;
+
+  /*! Memory size of a brick in bytes: voxel scalars followed by the accumulation buffer values */
+  size_t BrickMemorySize;
+  /*! Position of the first accumulation buffer value in a brick, in bytes */
+  size_t AccumulationBufferOffset;
+
+  /*! Bricks that could not be allocated are written into this brick (the written values are lost) */
+  unsigned char* DiscardedBrick;
+  /*! Protects the allocation of DiscardedBrick, which may be requested by multiple threads */
+  std::mutex DiscardedBrickMutex;
+
+private:
+  vtkPlusSparseVolume(const vtkPlusSparseVolume&);  // Not implemented.
+  void operator=(const vtkPlusSparseVolume&);  // Not implemented.
+};
+
+#endif
@@ -14,6 +14,7 @@
 #include "vtkPlusVolumeReconstructor.h"
 
 // STL includes
+#include <algorithm>
 #include <limits>
 
 // VTK includes
@@ -131,6 +132,8 @@ PlusStatus vtkPlusVolumeReconstructor::ReadConfiguration(vtkXMLDataElement* conf
                                     this->Reconstructor->GetCompoundingModeAsString(vtkPlusPasteSliceIntoVolume::MAXIMUM_COMPOUNDING_MODE), vtkPlusPasteSliceIntoVolume::MAXIMUM_COMPOUNDING_MODE);
 
   XML_READ_SCALAR_ATTRIBUTE_OPTIONAL(int, NumberOfThreads, reconConfig);
+  XML_READ_BOOL_ATTRIBUTE_OPTIONAL(PipelinedInsertion, reconConfig);
+  XML_READ_BOOL_ATTRIBUTE_OPTIONAL(SparseOutput, reconConfig);
 
   XML_READ_ENUM2_ATTRIBUTE_OPTIONAL(FillHoles, reconConfig, "ON", true, "OFF", false);
   XML_READ_BOOL_ATTRIBUTE_OPTIONAL(EnableFanAnglesAutoDetect, reconConfig);
@@ -251,6 +254,24 @@ PlusStatus vtkPlusVolumeReconstructor::WriteConfiguration(vtkXMLDataElement* con
     XML_REMOVE_ATTRIBUTE(reconConfig, "NumberOfThreads");
   }
 
+  if (this->Reconstructor->GetPipelinedInsertion())
+  {
+    reconConfig->SetAttribute("PipelinedInsertion", "TRUE");
+  }
+  else
+  {
+    XML_REMOVE_ATTRIBUTE(reconConfig, "PipelinedInsertion");
+  }
+
+  if (this->Reconstructor->GetSparseOutput())
+  {
+    reconConfig->SetAttribute("SparseOutput", "TRUE");
+  }
+  else
+  {
+    XML_REMOVE_ATTRIBUTE(reconConfig, "SparseOutput");
+  }
+
   XML_WRITE_STRING_ATTRIBUTE_REMOVE_IF_EMPTY(ImportanceMaskFilename, reconConfig);
 
   if (this->Reconstructor->IsPixelRejectionEnabled())
@@ -267,11 +288,16 @@ PlusStatus vtkPlusVolumeReconstructor::WriteConfiguration(vtkXMLDataElement* con
 
 //----------------------------------------------------------------------------
 void vtkPlusVolumeReconstructor::AddImageToExtent(vtkImageData* image, vtkMatrix4x4* imageToReference, double* extent_Ref)
+{
+  AddImageToExtent(image->GetExtent(), imageToReference, extent_Ref);
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusVolumeReconstructor::AddImageToExtent(const int* frameExtent, vtkMatrix4x4* imageToReference, double* extent_Ref)
 {
   // Output volume is in the Reference coordinate system.
 
   // Prepare the four corner points of the input US image.
-  int* frameExtent = image->GetExtent();
   std::vector< double* > corners_ImagePix;
   double minX = frameExtent[0];
   double maxX = frameExtent[1];
@@ -341,6 +367,24 @@ PlusStatus vtkPlusVolumeReconstructor::GetImageToReferenceTransformName(PlusTran
 
 //----------------------------------------------------------------------------
 PlusStatus vtkPlusVolumeReconstructor::SetOutputExtentFromFrameList(vtkPlusTrackedFrameList* trackedFrameList, vtkPlusTransformRepository* transformRepository, std::string& errorDescription)
+{
+  return SetOutputExtentFromFrameListInternal(trackedFrameList, transformRepository, NULL, VTK_VOID, errorDescription);
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusVolumeReconstructor::SetOutputExtentFromFrameList(vtkPlusTrackedFrameList* trackedFrameList, vtkPlusTransformRepository* transformRepository, const unsigned int frameSize[3], PlusCommon::VTKScalarPixelType pixelType, std::string& errorDescription)
+{
+  if (frameSize == NULL)
+  {
+    errorDescription = "Frame size is not specified";
+    LOG_ERROR("Failed to set output extent from tracked frame list - frame size is not specified");
+    return PLUS_FAIL;
+  }
+  return SetOutputExtentFromFrameListInternal(trackedFrameList, transformRepository, frameSize, pixelType, errorDescription);
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusVolumeReconstructor::SetOutputExtentFromFrameListInternal(vtkPlusTrackedFrameList* trackedFrameList, vtkPlusTransformRepository* transformRepository, const unsigned int* frameSize, PlusCommon::VTKScalarPixelType pixelType, std::string& errorDescription)
 {
   PlusTransformName imageToReferenceTransformName;
   if (GetImageToReferenceTransformName(imageToReferenceTransformName) != PLUS_SUCCESS)
@@ -404,11 +448,19 @@ PlusStatus vtkPlusVolumeReconstructor::SetOutputExtentFromFrameList(vtkPlusTrack
     {
       numberOfValidFrames++;
 
-      // Get image (only the frame extents will be used)
-      vtkImageData* frameImage = trackedFrameList->GetTrackedFrame(frameIndex)->GetImageData()->GetImage();
-
       // Expand the extent_Ref to include this frame
-      AddImageToExtent(frameImage, imageToReferenceTransformMatrix, extent_Ref);
+      if (frameSize != NULL)
+      {
+        // Frames may contain only the header fields, all images have the same size
+        int frameExtent[6] = { 0, static_cast<int>(frameSize[0]) - 1, 0, static_cast<int>(frameSize[1]) - 1, 0, static_cast<int>(frameSize[2]) - 1 };
+        AddImageToExtent(frameExtent, imageToReferenceTransformMatrix, extent_Ref);
+      }
+      else
+      {
+        // Get image (only the frame extents will be used)
+        vtkImageData* frameImage = trackedFrameList->GetTrackedFrame(frameIndex)->GetImageData()->GetImage();
+        AddImageToExtent(frameImage, imageToReferenceTransformMatrix, extent_Ref);
+      }
     }
   }
 
@@ -430,7 +482,14 @@ PlusStatus vtkPlusVolumeReconstructor::SetOutputExtentFromFrameList(vtkPlusTrack
   outputExtent[ 3 ] = int(std::ceil((extent_Ref[3] - extent_Ref[2]) / outputSpacing[ 1 ]));
   outputExtent[ 5 ] = int(std::ceil((extent_Ref[5] - extent_Ref[4]) / outputSpacing[ 2 ]));
 
-  this->Reconstructor->SetOutputScalarMode(trackedFrameList->GetTrackedFrame(0)->GetImageData()->GetImage()->GetScalarType());
+  if (frameSize != NULL)
+  {
+    this->Reconstructor->SetOutputScalarMode(pixelType);
+  }
+  else
+  {
+    this->Reconstructor->SetOutputScalarMode(trackedFrameList->GetTrackedFrame(0)->GetImageData()->GetImage()->GetScalarType());
+  }
   this->Reconstructor->SetOutputExtent(outputExtent);
   this->Reconstructor->SetOutputOrigin(extent_Ref[0], extent_Ref[2], extent_Ref[4]);
   try
@@ -751,6 +810,24 @@ void vtkPlusVolumeReconstructor::SetOutputExtent(int* extent)
   this->Reconstructor->SetOutputExtent(extent);
 }
 
+//----------------------------------------------------------------------------
+double* vtkPlusVolumeReconstructor::GetOutputOrigin()
+{
+  return this->Reconstructor->GetOutputOrigin();
+}
+
+//----------------------------------------------------------------------------
+double* vtkPlusVolumeReconstructor::GetOutputSpacing()
+{
+  return this->Reconstructor->GetOutputSpacing();
+}
+
+//----------------------------------------------------------------------------
+int* vtkPlusVolumeReconstructor::GetOutputExtent()
+{
+  return this->Reconstructor->GetOutputExtent();
+}
+
 //----------------------------------------------------------------------------
 void vtkPlusVolumeReconstructor::SetNumberOfThreads(int numberOfThreads)
 {
@@ -758,6 +835,40 @@ void vtkPlusVolumeReconstructor::SetNumberOfThreads(int numberOfThreads)
   this->HoleFiller->SetNumberOfThreads(numberOfThreads);
 }
 
+//----------------------------------------------------------------------------
+void vtkPlusVolumeReconstructor::SetPipelinedInsertion(bool enable)
+{
+  this->Reconstructor->SetPipelinedInsertion(enable);
+}
+
+//----------------------------------------------------------------------------
+bool vtkPlusVolumeReconstructor::GetPipelinedInsertion()
+{
+  return this->Reconstructor->GetPipelinedInsertion();
+}
+
+//----------------------------------------------------------------------------
+bool vtkPlusVolumeReconstructor::IsFrameInsertionQueueFull()
+{
+  if (!this->Reconstructor->GetPipelinedInsertion())
+  {
+    return false;
+  }
+  return this->Reconstructor->GetNumberOfQueuedSlices() >= std::max(this->Reconstructor->GetMaximumNumberOfQueuedSlices(), 1);
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusVolumeReconstructor::SetSparseOutput(bool enable)
+{
+  this->Reconstructor->SetSparseOutput(enable);
+}
+
+//----------------------------------------------------------------------------
+bool vtkPlusVolumeReconstructor::GetSparseOutput()
+{
+  return this->Reconstructor->GetSparseOutput();
+}
+
 //----------------------------------------------------------------------------
 void vtkPlusVolumeReconstructor::SetClipRectangleOrigin(int* origin)
 {
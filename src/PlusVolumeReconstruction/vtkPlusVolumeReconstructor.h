@@ -65,6 +65,13 @@ public:
   */
   virtual PlusStatus SetOutputExtentFromFrameList(vtkPlusTrackedFrameList* trackedFrameList, vtkPlusTransformRepository* transformRepository, std::string& errorDescription);
 
+  /*!
+    Automatically adjusts the reconstruced volume size to enclose all the frames in the supplied vtkPlusTrackedFrameList.
+    Only the transforms are used from the frames, so the list may contain only the header fields of a sequence file
+    (see vtkPlusSequenceIOBase::StartFrameByFrameReading). It clears the reconstructed volume.
+  */
+  virtual PlusStatus SetOutputExtentFromFrameList(vtkPlusTrackedFrameList* trackedFrameList, vtkPlusTransformRepository* transformRepository, const unsigned int frameSize[3], PlusCommon::VTKScalarPixelType pixelType, std::string& errorDescription);
+
   /*!
     Inserts the tracked frame into the volume. The origin, spacing, and extent of the output volume
     must be set before calling this method (either by calling the SetOutputExtentFromFrameList method
@@ -144,9 +151,30 @@ public:
   /*! Set the output volume's extent (xStart, xEnd, yStart, yEnd, zStart, zEnd) in voxels */
   void SetOutputExtent(int* extent);
 
+  /*! Get the output volume's origin in the Reference coordinate system*/
+  double* GetOutputOrigin();
+  /*! Get the output volume's spacing in the Reference coordinate system's unit (usually mm)*/
+  double* GetOutputSpacing();
+  /*! Get the output volume's extent (xStart, xEnd, yStart, yEnd, zStart, zEnd) in voxels */
+  int* GetOutputExtent();
+
   /*! Set the number of threads used for volume reconstruction and hole filling */
   void SetNumberOfThreads(int numberOfThreads);
 
+  /*! Enable pipelined insertion of frames (frames are queued and pasted into the volume by a pool of worker threads) */
+  void SetPipelinedInsertion(bool enable);
+  bool GetPipelinedInsertion();
+
+  /*!
+    Returns true if pipelined insertion is enabled and the insertion queue is full, i.e., AddTrackedFrame
+    would have to wait until a queued frame is pasted into the volume.
+  */
+  bool IsFrameInsertionQueueFull();
+
+  /*! Store the reconstructed volume in sparse bricks, which are only allocated where frames are inserted */
+  void SetSparseOutput(bool enable);
+  bool GetSparseOutput();
+
   /*! Set the fan-shaped clipping region for curvilinear probes. */
   void SetFanAnglesDeg(double* fanAngles);
   /*! Set the fan-shaped clipping region for curvilinear probes. */
@@ -207,6 +235,10 @@ protected:
 
   /*! Helper function for computing the extent of the reconstructed volume that encloses all the frames */
   void AddImageToExtent(vtkImageData* image, vtkMatrix4x4* imageToReference, double* extent_Ref);
+  void AddImageToExtent(const int* frameExtent, vtkMatrix4x4* imageToReference, double* extent_Ref);
+
+  /*! Compute the output extent from the frame transforms. If frameSize is NULL then the frame sizes and pixel type are taken from the images of the frames. */
+  PlusStatus SetOutputExtentFromFrameListInternal(vtkPlusTrackedFrameList* trackedFrameList, vtkPlusTransformRepository* transformRepository, const unsigned int* frameSize, PlusCommon::VTKScalarPixelType pixelType, std::string& errorDescription);
 
   /*! Construct ImageToReference transform name from the image and reference coordinate frame member variables */
   PlusStatus GetImageToReferenceTransformName(PlusTransformName& imageToReferenceTransformName);